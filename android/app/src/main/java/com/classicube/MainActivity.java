@@ -8,6 +8,9 @@ import java.io.OutputStream;
 import java.lang.reflect.Method;
 import java.net.HttpURLConnection;
 import java.net.URL;
+import java.nio.ByteBuffer;
+import java.nio.channels.Channels;
+import java.nio.channels.ReadableByteChannel;
 import java.nio.file.Files;
 import java.util.ArrayList;
 import java.util.List;
@@ -912,7 +915,9 @@ public class MainActivity extends Activity
 	//  Implements java Android side of the Android HTTP backend (See Http.c)
 	static HttpURLConnection conn;
 	static InputStream src;
-	static byte[] readCache = new byte[8192];
+	// Direct buffer, so the native side can copy data straight out of it
+	//  (much cheaper than passing a byte[] through JNI for every small chunk)
+	static ByteBuffer readBuffer = ByteBuffer.allocateDirect(64 * 1024);
 
 	public static int httpInit(String url, String method) {
 		// newer android versions block cleartext traffic by default
@@ -964,7 +969,8 @@ public class MainActivity extends Activity
 		try {
 			conn.connect();
 			// Some implementations also provide this as getHeaderField(0), but some don't
-			httpParseHeader("HTTP/1.1 " + conn.getResponseCode() + " MSG");
+			StringBuilder headers = new StringBuilder();
+			headers.append("HTTP/1.1 " + conn.getResponseCode() + " MSG\n");
 			
 			// Legitimate webservers aren't going to reply with over 200 headers
 			for (int i = 0; i < 200; i++) {
@@ -972,16 +978,23 @@ public class MainActivity extends Activity
 				String val = conn.getHeaderField(i);
 				if (key == null && val == null) break;
 				
-				if (key == null) {
-					httpParseHeader(val);
-				} else {
-					httpParseHeader(key + ":" + val);
-				}
+				if (key != null) headers.append(key + ":");
+				headers.append(val + "\n");
 			}
+			httpParseHeaders(headers.toString());
 
 			src = conn.getInputStream();
-			while ((len = src.read(readCache)) > 0) {
-				httpAppendData(readCache, len);
+			ReadableByteChannel channel = Channels.newChannel(src);
+			readBuffer.clear();
+
+			// Only pass data to the native side once the buffer is full, to minimise JNI calls
+			while ((len = channel.read(readBuffer)) >= 0) {
+				if (readBuffer.hasRemaining()) continue;
+				httpAppendData(readBuffer, readBuffer.position());
+				readBuffer.clear();
+			}
+			if (readBuffer.position() > 0) {
+				httpAppendData(readBuffer, readBuffer.position());
 			}
 
 			httpFinish();
@@ -1014,6 +1027,6 @@ public class MainActivity extends Activity
 		return res >= 0 && res < errors.size() ? errors.get(res) : null;
 	}
 
-	native static void httpParseHeader(String header);
-	native static void httpAppendData(byte[] data, int len);
+	native static void httpParseHeaders(String headers);
+	native static void httpAppendData(ByteBuffer data, int len);
 }
@@ -14,13 +14,19 @@ CC_KERN32_FUNC BOOL (WINAPI *_AttachConsole)(DWORD processId);
 CC_KERN32_FUNC BOOL (WINAPI *_IsDebuggerPresent)(void);
 CC_KERN32_FUNC void (NTAPI *_RtlCaptureContext)(CONTEXT* ContextRecord);
 
+/* High resolution timers are only supported on Windows 10 1803 and later */
+CC_KERN32_FUNC HANDLE (WINAPI *_CreateWaitableTimerExW)(void* attributes, LPCWSTR name, DWORD flags, DWORD access);
+CC_KERN32_FUNC BOOL (WINAPI *_SetWaitableTimer)(HANDLE timer, const LARGE_INTEGER* dueTime, LONG period, void* completion, void* arg, BOOL resume);
+
 
 static void Kernel32_LoadDynamicFuncs(void) {
 	static const struct DynamicLibSym funcs[] = {
 		DynamicLib_Sym(AttachConsole), 
 		DynamicLib_Sym(IsDebuggerPresent),
 		DynamicLib_Sym(GetSystemTimeAsFileTime),
-		DynamicLib_Sym(RtlCaptureContext)
+		DynamicLib_Sym(RtlCaptureContext),
+		DynamicLib_Sym(CreateWaitableTimerExW),
+		DynamicLib_Sym(SetWaitableTimer)
 	};
 
 	static const cc_string kernel32 = String_FromConst("KERNEL32.DLL");
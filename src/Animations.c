@@ -11,6 +11,7 @@
 #include "ExtMath.h"
 #include "Options.h"
 #include "Logger.h"
+#include "Block.h"
 
 #ifndef CC_DISABLE_ANIMATIONS
 static void Animations_Update(int loc, struct Bitmap* bmp, int stride);
@@ -184,6 +185,7 @@ struct AnimationData {
 	cc_uint16 statesCount;    /* Total number of animation frames */
 	cc_uint16 delay;          /* Delay in ticks until next frame is drawn */
 	cc_uint16 frameDelay;     /* Delay between each frame */
+	cc_uint16 applied;        /* Whether current frame has been copied into the terrain atlas */
 };
 
 static struct Bitmap anims_bmp;
@@ -249,25 +251,55 @@ static void Animations_ReadDescription(struct Stream* stream, const cc_string* p
 	}
 }
 
+/* Whether each tile in terrain.png is used by any block face */
+/* Animations of tiles that no block uses are not updated, since they would never be seen */
+static cc_uint8 anims_tileUsed[ATLAS1D_MAX_ATLASES];
+static cc_bool anims_tilesDirty = true;
+
+static void Animations_CalcUsedTiles(void) {
+	TextureLoc loc;
+	int i;
+	Mem_Set(anims_tileUsed, 0, sizeof(anims_tileUsed));
+
+	for (i = 0; i < BLOCK_COUNT * FACE_COUNT; i++) 
+	{
+		loc = Blocks.Textures[i];
+		if (loc < ATLAS1D_MAX_ATLASES) anims_tileUsed[loc] = true;
+	}
+	anims_tilesDirty = false;
+}
+
 static void Animations_Update(int texLoc, struct Bitmap* bmp, int stride) {
 	int dstX = Atlas1D_Index(texLoc);
 	int dstY = Atlas1D_RowId(texLoc) * Atlas2D.TileSize;
+	int layerHeight;
 	GfxResourceID tex;
 
 	tex = Atlas1D.TexIds[dstX];
-	if (tex) Gfx_UpdateTexture(tex, 0, dstY, bmp, stride, Gfx.Mipmaps);
+	if (!tex) return;
+
+	if (Atlas1D.Layers) {
+		layerHeight = (Atlas1D.TilesPerAtlas / Atlas1D.Layers) * Atlas2D.TileSize;
+		Gfx_UpdateTextureArray(tex, 0, dstY % layerHeight, dstY / layerHeight, bmp, stride, Gfx.Mipmaps);
+	} else {
+		Gfx_UpdateTexture(tex, 0, dstY, bmp, stride, Gfx.Mipmaps);
+	}
 }
 
 static void Animations_Apply(struct AnimationData* data) {
 	struct Bitmap frame;
-	int loc, size;
+	int loc, size, state;
 	if (data->delay) { data->delay--; return; }
 
-	data->state++;
-	data->state %= data->statesCount;
-	data->delay  = data->frameDelay;
+	state = (data->state + 1) % data->statesCount;
+	data->delay = data->frameDelay;
+	/* Avoid uploading the same frame again (e.g. single frame animations) */
+	if (state == data->state && data->applied) return;
+	data->state = state;
 
 	loc = data->texLoc;
+	data->applied = anims_tileUsed[loc];
+	if (!data->applied) return;
 #ifndef CC_BUILD_WEB
 	if (loc == LAVA_TEX_LOC  && useLavaAnim)  return;
 	if (loc == WATER_TEX_LOC && useWaterAnim) return;
@@ -335,9 +367,11 @@ static void Animations_Validate(void) {
 
 static void Animations_Tick(struct ScheduledTask* task) {
 	int i;
+	if (anims_tilesDirty) Animations_CalcUsedTiles();
 #ifndef CC_BUILD_WEB
-	if (useLavaAnim)  LavaAnimation_Tick();
-	if (useWaterAnim) WaterAnimation_Tick();
+	/* Skip generating liquid animation pixels when nothing uses the tile */
+	if (useLavaAnim  && anims_tileUsed[LAVA_TEX_LOC])  LavaAnimation_Tick();
+	if (useWaterAnim && anims_tileUsed[WATER_TEX_LOC]) WaterAnimation_Tick();
 #endif
 
 	if (!anims_count) return;
@@ -347,6 +381,8 @@ static void Animations_Tick(struct ScheduledTask* task) {
 		anims_count = 0; return;
 	}
 
+	/* Animations are validated against terrain.png, so wait until it has finished decoding */
+	if (Atlas_IsDecoding()) return;
 	/* deferred, because when reading animations.txt, might not have read animations.png yet */
 	if (!anims_validated) Animations_Validate();
 	for (i = 0; i < anims_count; i++) {
@@ -359,7 +395,7 @@ static void Animations_Tick(struct ScheduledTask* task) {
 *--------------------------------------------------Animations component---------------------------------------------------*
 *#########################################################################################################################*/
 static void AnimationsPngProcess(struct Stream* stream, const cc_string* name) {
-	cc_result res = Png_Decode(&anims_bmp, stream);
+	cc_result res = TexturePack_DecodePng(&anims_bmp, stream);
 	if (!res) return;
 
 	Logger_SysWarn2(res, "decoding", name);
@@ -389,6 +425,14 @@ static void OnPackChanged(void* obj) {
 	alwaysLavaAnim  = false;
 	alwaysWaterAnim = false;
 }
+
+static void OnAtlasChanged(void* obj) {
+	int i;
+	/* Terrain atlas textures were recreated, so frames must be copied into them again */
+	for (i = 0; i < anims_count; i++) { anims_list[i].applied = false; }
+}
+static void OnBlockDefChanged(void* obj) { anims_tilesDirty = true; }
+
 static void OnInit(void) {
 	TextureEntry_Register(&animations_entry);
 	TextureEntry_Register(&animations_txt);
@@ -396,7 +440,9 @@ static void OnInit(void) {
 	TextureEntry_Register(&lava_entry);
 
 	ScheduledTask_Add(GAME_DEF_TICKS, Animations_Tick);
-	Event_Register_(&TextureEvents.PackChanged, NULL, OnPackChanged);
+	Event_Register_(&TextureEvents.PackChanged,  NULL, OnPackChanged);
+	Event_Register_(&TextureEvents.AtlasChanged, NULL, OnAtlasChanged);
+	Event_Register_(&BlockEvents.BlockDefChanged, NULL, OnBlockDefChanged);
 }
 #else
 static void Animations_Clear(void) { }
@@ -56,6 +56,38 @@ struct Soundboard { struct SoundGroup groups[SOUND_COUNT]; };
 static struct Soundboard digBoard, stepBoard;
 static RNGState sounds_rnd;
 
+/* Sounds may be loaded on a background thread, which must not print to chat directly */
+/* Instead messages are stored, and printed on the main thread once loading finishes */
+static cc_bool sounds_deferMsgs;
+static struct StringsBuffer sounds_msgs;
+
+static void Sounds_Message(const cc_string* msg, cc_bool warning) {
+	cc_string str; char strBuffer[256 + 1];
+
+	if (!sounds_deferMsgs) {
+		if (warning) Logger_WarnFunc(msg);
+		else Chat_Add(msg);
+	} else {
+		/* First character indicates whether message is a warning */
+		String_InitArray(str, strBuffer);
+		String_Append(&str, warning ? 'W' : 'C');
+		String_AppendString(&str, msg);
+		StringsBuffer_Add(&sounds_msgs, &str);
+	}
+}
+
+static void Sounds_Warn(cc_result res, const char* action, const cc_string* path) {
+	cc_string msg; char msgBuffer[256];
+	String_InitArray(msg, msgBuffer);
+
+	if (path) {
+		Logger_FormatWarn2(&msg, res, action, path, Platform_DescribeError);
+	} else {
+		Logger_FormatWarn(&msg, res, action, Audio_DescribeError);
+	}
+	Sounds_Message(&msg, true);
+}
+
 #define WAV_FourCC(a, b, c, d) (((cc_uint32)a << 24) | ((cc_uint32)b << 16) | ((cc_uint32)c << 8) | (cc_uint32)d)
 #define WAV_FMT_SIZE 16
 
@@ -136,17 +168,21 @@ static void Soundboard_Load(struct Soundboard* board, const cc_string* boardName
 
 	group = Soundboard_FindGroup(board, &name);
 	if (!group) {
-		Chat_Add1("&cUnknown sound group '%s'", &name); return;
+		cc_string msg; char msgBuffer[STRING_SIZE];
+		String_InitArray(msg, msgBuffer);
+		String_Format1(&msg, "&cUnknown sound group '%s'", &name);
+		Sounds_Message(&msg, false); return;
 	}
 	if (group->count == Array_Elems(group->sounds)) {
-		Chat_AddRaw("&cCannot have more than 10 sounds in a group"); return;
+		static const cc_string msg = String_FromConst("&cCannot have more than 10 sounds in a group");
+		Sounds_Message(&msg, false); return;
 	}
 
 	snd = &group->sounds[group->count];
 	res = Sound_ReadWaveData(stream, snd);
 
 	if (res) {
-		Logger_SysWarn2(res, "decoding", file);
+		Sounds_Warn(res, "decoding", file);
 		Audio_FreeChunks(&snd->chunk, 1);
 		snd->chunk.data = NULL;
 		snd->chunk.size = 0;
@@ -167,7 +203,125 @@ static const struct Sound* Soundboard_PickRandom(struct Soundboard* board, cc_ui
 	return &group->sounds[idx];
 }
 
+/* All sounds are converted to the same format after loading, so that */
+/*  the pooled audio contexts never need to be reconfigured when playing sounds */
+static int sounds_channels, sounds_sampleRate;
+
+static int Sound_GetSample(const cc_int16* src, int frame, int ch, int srcChannels, int dstChannels) {
+	int i, sum = 0;
+	if (srcChannels <= dstChannels) return src[frame * srcChannels + (ch % srcChannels)];
+
+	/* Downmix all channels when converting stereo to mono */
+	for (i = 0; i < srcChannels; i++) { sum += src[frame * srcChannels + i]; }
+	return sum / srcChannels;
+}
+
+static cc_result Sound_Convert(struct Sound* snd, int channels, int sampleRate) {
+	struct AudioChunk chunk;
+	cc_int16* src = (cc_int16*)snd->chunk.data;
+	cc_int16* dst;
+	int srcFrames, dstFrames, i, ch, idx, next;
+	float ratio, pos, frac, a, b;
+	cc_result res;
+
+	srcFrames = snd->chunk.size / (2 * snd->channels);
+	dstFrames = (int)((cc_uint64)srcFrames * sampleRate / snd->sampleRate);
+	if (!srcFrames || !dstFrames) return 0;
+	if ((res = Audio_AllocChunks(dstFrames * channels * 2, &chunk, 1))) return res;
+
+	dst   = (cc_int16*)chunk.data;
+	ratio = (float)snd->sampleRate / sampleRate;
+
+	/* Linearly interpolate between the two nearest source frames */
+	for (i = 0; i < dstFrames; i++) 
+	{
+		pos  = i * ratio;
+		idx  = (int)pos;
+		frac = pos - idx;
+		next = min(idx + 1, srcFrames - 1);
+
+		for (ch = 0; ch < channels; ch++) 
+		{
+			a = (float)Sound_GetSample(src, idx,  ch, snd->channels, channels);
+			b = (float)Sound_GetSample(src, next, ch, snd->channels, channels);
+			*dst++ = (cc_int16)(a + (b - a) * frac);
+		}
+	}
+
+	Audio_FreeChunks(&snd->chunk, 1);
+	snd->chunk      = chunk;
+	snd->channels   = channels;
+	snd->sampleRate = sampleRate;
+	return 0;
+}
+
+static void Soundboard_Convert(struct Soundboard* board) {
+	struct SoundGroup* group;
+	struct Sound* snd;
+	cc_result res;
+	int i, j;
+
+	for (i = 0; i < SOUND_COUNT; i++) 
+	{
+		group = &board->groups[i];
+		for (j = 0; j < group->count; j++) 
+		{
+			snd = &group->sounds[j];
+			if (snd->channels == sounds_channels && snd->sampleRate == sounds_sampleRate) continue;
+
+			res = Sound_Convert(snd, sounds_channels, sounds_sampleRate);
+			if (res) Sounds_Warn(res, "converting sounds", NULL);
+		}
+	}
+}
+
+/* Picks the format used by the most sounds, so that the fewest sounds need to be converted */
+static void Sounds_PickFormat(void) {
+	struct SoundGroup* groups[SOUND_COUNT * 2];
+	struct Sound* snd;
+	int best = 0, count, i, j, k, l;
+
+	for (i = 0; i < SOUND_COUNT; i++) 
+	{
+		groups[i]               = &digBoard.groups[i];
+		groups[i + SOUND_COUNT] = &stepBoard.groups[i];
+	}
+
+	for (i = 0; i < SOUND_COUNT * 2; i++) 
+	{
+		for (j = 0; j < groups[i]->count; j++) 
+		{
+			snd   = &groups[i]->sounds[j];
+			count = 0;
+
+			for (k = 0; k < SOUND_COUNT * 2; k++) 
+			{
+				for (l = 0; l < groups[k]->count; l++) 
+				{
+					if (groups[k]->sounds[l].channels   != snd->channels)   continue;
+					if (groups[k]->sounds[l].sampleRate != snd->sampleRate) continue;
+					count++;
+				}
+			}
+			if (count <= best) continue;
+
+			best              = count;
+			sounds_channels   = snd->channels;
+			sounds_sampleRate = snd->sampleRate;
+		}
+	}
+}
+
+static void Sounds_Convert(void) {
+	Sounds_PickFormat();
+	if (!sounds_channels) return;
 
+	Soundboard_Convert(&digBoard);
+	Soundboard_Convert(&stepBoard);
+}
+
+
+static cc_bool Sounds_FinishLoad(cc_bool wait);
 CC_NOINLINE static void Sounds_Fail(cc_result res) {
 	Audio_Warn(res, "playing sounds");
 	Chat_AddRaw("&cDisabling sounds");
@@ -180,6 +334,7 @@ static void Sounds_Play(cc_uint8 type, struct Soundboard* board) {
 	cc_result res;
 
 	if (type == SOUND_NONE || !Audio_SoundsVolume) return;
+	if (!Sounds_FinishLoad(false)) return;
 	snd = Soundboard_PickRandom(board, type);
 	if (!snd) return;
 
@@ -188,6 +343,7 @@ static void Sounds_Play(cc_uint8 type, struct Soundboard* board) {
 	data.sampleRate = snd->sampleRate;
 	data.rate       = 100;
 	data.volume     = Audio_SoundsVolume;
+	data.priority   = board == &digBoard ? AUDIO_PRIORITY_DIG : AUDIO_PRIORITY_STEP;
 
 	/* https://minecraft.wiki/w/Block_of_Gold#Sounds */
 	/* https://minecraft.wiki/w/Grass#Sounds */
@@ -229,11 +385,11 @@ static cc_result Sounds_ExtractZip(const cc_string* path) {
 	cc_result res;
 
 	res = Stream_OpenFile(&stream, path);
-	if (res) { Logger_SysWarn2(res, "opening", path); return res; }
+	if (res) { Sounds_Warn(res, "opening", path); return res; }
 
 	res = Zip_Extract(&stream, SelectZipEntry, ProcessZipEntry,
 						entries, Array_Elems(entries));
-	if (res) Logger_SysWarn2(res, "extracting", path);
+	if (res) Sounds_Warn(res, "extracting", path);
 
 	/* No point logging error for closing readonly file */
 	(void)stream.Close(&stream);
@@ -281,23 +437,86 @@ static void InitWebSounds(void) {
 #endif
 
 static cc_bool sounds_loaded;
-static void Sounds_Start(void) {
+static void Sounds_Load(void) {
 	cc_result res;
-	if (!AudioBackend_Init()) { 
-		AudioBackend_Free(); 
-		Audio_SoundsVolume = 0; 
-		return; 
-	}
-
-	if (sounds_loaded) return;
-	sounds_loaded = true;
 #ifdef CC_BUILD_WEBAUDIO
 	InitWebSounds();
 #else
 	res = Sounds_ExtractZip(&Sounds_ZipPathMC);
 	if (res == ReturnCode_FileNotFound)
 		Sounds_ExtractZip(&Sounds_ZipPathCC);
+	Sounds_Convert();
+#endif
+}
+
+static void Sounds_Prepare(void) {
+	cc_result res;
+	if (!sounds_channels || !Audio_SoundsVolume) return;
+
+	res = AudioPool_Prepare(sounds_channels, sounds_sampleRate);
+	if (res) Audio_Warn(res, "preparing sounds");
+}
+
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_WEB && !defined CC_BUILD_LOWMEM
+/* Sounds are loaded in the background, so the rest of the game can start up meanwhile */
+static void* sounds_thread;
+static volatile cc_bool sounds_loadDone;
+
+static void Sounds_LoadWorker(void) {
+	Sounds_Load();
+	sounds_loadDone = true;
+}
+
+static void Sounds_StartLoad(void) {
+	sounds_deferMsgs = true;
+	sounds_loadDone  = false;
+	Thread_Run(&sounds_thread, Sounds_LoadWorker, 256 * 1024, "Sounds loader");
+}
+
+static void Sounds_PrintDeferred(void) {
+	cc_string msg;
+	int i;
+	sounds_deferMsgs = false;
+
+	for (i = 0; i < sounds_msgs.count; i++) 
+	{
+		msg = StringsBuffer_UNSAFE_Get(&sounds_msgs, i);
+		Sounds_Message(&msg, msg.buffer[0] == 'W');
+	}
+	StringsBuffer_Clear(&sounds_msgs);
+}
+
+/* Returns whether sounds have finished loading, waiting for that to happen if requested */
+static cc_bool Sounds_FinishLoad(cc_bool wait) {
+	if (!sounds_thread) return true;
+	if (!wait && !sounds_loadDone) return false;
+
+	Thread_Join(sounds_thread);
+	sounds_thread = NULL;
+	Sounds_PrintDeferred();
+	Sounds_Prepare();
+	return true;
+}
+
+static void Sounds_CheckLoaded(struct ScheduledTask* task) { Sounds_FinishLoad(false); }
+#else
+static void Sounds_StartLoad(void) { Sounds_Load(); Sounds_Prepare(); }
+static cc_bool Sounds_FinishLoad(cc_bool wait) { return true; }
 #endif
+
+static void Sounds_Start(void) {
+	if (!AudioBackend_Init()) { 
+		AudioBackend_Free(); 
+		Audio_SoundsVolume = 0; 
+		return; 
+	}
+
+	if (!sounds_loaded) {
+		sounds_loaded = true;
+		Sounds_StartLoad();
+	} else if (Sounds_FinishLoad(false)) {
+		Sounds_Prepare();
+	}
 }
 
 static void Sounds_Stop(void) { AudioPool_Close(); }
@@ -306,8 +525,15 @@ static void Sounds_Init(void) {
 	int volume = Options_GetInt(OPT_SOUND_VOLUME, 0, 100, DEFAULT_SOUNDS_VOLUME);
 	Audio_SetSounds(volume);
 	Event_Register_(&UserEvents.BlockChanged, NULL, Audio_PlayBlockSound);
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_WEB && !defined CC_BUILD_LOWMEM
+	ScheduledTask_Add(0.5, Sounds_CheckLoaded);
+#endif
+}
+
+static void Sounds_Free(void) { 
+	Sounds_FinishLoad(true);
+	Sounds_Stop(); 
 }
-static void Sounds_Free(void) { Sounds_Stop(); }
 
 void Audio_PlayDigSound(cc_uint8 type)  { Sounds_Play(type, &digBoard); }
 void Audio_PlayStepSound(cc_uint8 type) { Sounds_Play(type, &stepBoard); }
@@ -332,10 +558,31 @@ static void* music_waitable;
 static volatile cc_bool music_stopping, music_joining;
 static int music_minDelay, music_maxDelay;
 
-static cc_result Music_Buffer(struct AudioChunk* chunk, int maxSamples, struct VorbisState* ctx) {
+/* Vorbis decoding runs ahead of the audio backend on its own thread, so that a slow */
+/*  frame never delays submitting an already decoded chunk to the backend */
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_WEB && !defined CC_BUILD_LOWMEM
+#define MUSIC_DECODE_THREAD
+#define MUSIC_PREFETCH_CHUNKS 4
+#else
+#define MUSIC_PREFETCH_CHUNKS 0
+#endif
+/* Chunks are either queued in the backend, or decoded and waiting to be queued */
+#define MUSIC_MAX_CHUNKS (AUDIO_MAX_BUFFERS + MUSIC_PREFETCH_CHUNKS)
+
+static struct AudioChunk dec_chunks[MUSIC_MAX_CHUNKS];
+static struct VorbisState* dec_vorbis;
+static int dec_samples;
+static void* dec_mutex;
+static void* dec_waitable;
+/* Number of chunks decoded so far, and number of chunks the backend has finished playing */
+static int dec_decoded, dec_played;
+static cc_bool dec_finished;
+static cc_result dec_result;
+
+static cc_result Music_Decode(struct AudioChunk* chunk, int maxSamples, struct VorbisState* ctx) {
 	int samples = 0;
 	cc_int16* cur;
-	cc_result res = 0, res2;
+	cc_result res = 0;
 	cc_int16* data = (cc_int16*)chunk->data;
 
 	while (samples < maxSamples) {
@@ -346,19 +593,70 @@ static cc_result Music_Buffer(struct AudioChunk* chunk, int maxSamples, struct V
 	}
 
 	chunk->size = samples * 2;
-	res2 = Audio_QueueChunk(&music_ctx, chunk);
-	if (res2) { music_stopping = true; return res2; }
 	return res;
 }
 
+/* Decodes the next chunk of audio, if there is a free chunk to decode into */
+/* Returns false when there was nothing to do */
+static cc_bool MusicDecoder_Next(void) {
+	cc_bool canDecode;
+	int index;
+	cc_result res;
+
+	Mutex_Lock(dec_mutex);
+	{
+		canDecode = !dec_finished && (dec_decoded - dec_played) < MUSIC_MAX_CHUNKS;
+		index     = dec_decoded % MUSIC_MAX_CHUNKS;
+	}
+	Mutex_Unlock(dec_mutex);
+	if (!canDecode) return false;
+
+	res = Music_Decode(&dec_chunks[index], dec_samples, dec_vorbis);
+
+	Mutex_Lock(dec_mutex);
+	{
+		dec_decoded++;
+		if (res) { dec_finished = true; dec_result = res; }
+	}
+	Mutex_Unlock(dec_mutex);
+	return true;
+}
+
+#ifdef MUSIC_DECODE_THREAD
+static void* dec_thread;
+
+static void MusicDecoder_RunLoop(void) {
+	while (!music_stopping && !dec_finished) 
+	{
+		if (MusicDecoder_Next()) continue;
+		/* Woken up by the music thread whenever the backend finishes with a chunk */
+		Waitable_WaitFor(dec_waitable, 100);
+	}
+}
+
+static void MusicDecoder_Start(void) {
+	Thread_Run(&dec_thread, MusicDecoder_RunLoop, 256 * 1024, "Music decoder");
+}
+
+static void MusicDecoder_Stop(void) {
+	if (!dec_thread) return;
+	Waitable_Signal(dec_waitable);
+	Thread_Join(dec_thread);
+	dec_thread = NULL;
+}
+#else
+static void MusicDecoder_Start(void) { }
+static void MusicDecoder_Stop(void)  { }
+#endif
+
 static cc_result Music_PlayOgg(struct Stream* source) {
 	struct OggState ogg;
 	struct VorbisState vorbis;
 	int channels, sampleRate, volume;
 
-	int chunkSize, samplesPerSecond;
-	struct AudioChunk chunks[AUDIO_MAX_BUFFERS] = { 0 };
-	int inUse, i, cur;
+	int chunkSize, decoded, queued;
+	cc_bool finished, playing = false;
+	int inUse;
 	cc_result res;
 
 	Ogg_Init(&ogg, source);
@@ -372,23 +670,20 @@ static cc_result Music_PlayOgg(struct Stream* source) {
 
 	/* largest possible vorbis frame decodes to blocksize1 * channels samples, */
 	/*  so can end up decoding slightly over a second of audio */
-	chunkSize        = channels * (sampleRate + vorbis.blockSizes[1]);
-	samplesPerSecond = channels * sampleRate;
+	chunkSize   = channels * (sampleRate + vorbis.blockSizes[1]);
+	dec_samples = channels * sampleRate;
 
-	if ((res = Audio_AllocChunks(chunkSize * 2, chunks, AUDIO_MAX_BUFFERS))) goto cleanup;
+	if ((res = Audio_AllocChunks(chunkSize * 2, dec_chunks, MUSIC_MAX_CHUNKS))) goto cleanup;
     volume = Audio_MusicVolume;
     Audio_SetVolume(&music_ctx, volume);	
 
-	/* fill up with some samples before playing */
-	for (i = 0; i < AUDIO_MAX_BUFFERS && !res; i++) 
-	{
-		res = Music_Buffer(&chunks[i], samplesPerSecond, &vorbis);
-	}
-	if (music_stopping) goto cleanup;
-
-	res  = Audio_Play(&music_ctx);
-	if (res) goto cleanup;
-	cur  = 0;
+	dec_vorbis   = &vorbis;
+	dec_decoded  = 0;
+	dec_played   = 0;
+	dec_finished = false;
+	dec_result   = 0;
+	queued       = 0;
+	MusicDecoder_Start();
 
 	while (!music_stopping) {
 #ifdef CC_BUILD_ANDROID
@@ -407,20 +702,49 @@ static cc_result Music_PlayOgg(struct Stream* source) {
             Audio_SetVolume(&music_ctx, volume);
         }
 
-		res = Audio_Poll(&music_ctx, &inUse);
-		if (res) { music_stopping = true; break; }
+		if (playing) {
+			res = Audio_Poll(&music_ctx, &inUse);
+			if (res) { music_stopping = true; break; }
+		} else {
+			inUse = queued;
+		}
+
+		Mutex_Lock(dec_mutex);
+		{
+			dec_played = queued - inUse;
+			decoded    = dec_decoded;
+			finished   = dec_finished;
+		}
+		Mutex_Unlock(dec_mutex);
+#ifdef MUSIC_DECODE_THREAD
+		if (inUse < AUDIO_MAX_BUFFERS) Waitable_Signal(dec_waitable);
+#endif
 
-		if (inUse >= AUDIO_MAX_BUFFERS) {
-			Thread_Sleep(10); continue;
+		if (queued < decoded && inUse < AUDIO_MAX_BUFFERS) {
+			res = Audio_QueueChunk(&music_ctx, &dec_chunks[queued % MUSIC_MAX_CHUNKS]);
+			if (res) { music_stopping = true; break; }
+			queued++; continue;
 		}
 
-		res = Music_Buffer(&chunks[cur], samplesPerSecond, &vorbis);
-		cur = (cur + 1) % AUDIO_MAX_BUFFERS;
+		/* fill up with some samples before playing */
+		if (!playing && (inUse >= AUDIO_MAX_BUFFERS || (finished && queued == decoded))) {
+			res = Audio_Play(&music_ctx);
+			if (res) { music_stopping = true; break; }
+			playing = true; continue;
+		}
 
 		/* need to specially handle last bit of audio */
-		if (res) break;
+		if (finished && queued == decoded) break;
+
+#ifndef MUSIC_DECODE_THREAD
+		if (MusicDecoder_Next()) continue;
+#endif
+		Thread_Sleep(10);
 	}
 
+	MusicDecoder_Stop();
+	if (!res) res = dec_result;
+
 	if (music_stopping) {
 		/* must close audio context, as otherwise some of the audio */
 		/*  context's internal audio buffers may have a reference */
@@ -435,7 +759,7 @@ static cc_result Music_PlayOgg(struct Stream* source) {
 	}
 
 cleanup:
-	Audio_FreeChunks(chunks, AUDIO_MAX_BUFFERS);
+	Audio_FreeChunks(dec_chunks, MUSIC_MAX_CHUNKS);
 	Vorbis_Free(&vorbis);
 	return res == ERR_END_OF_STREAM ? 0 : res;
 }
@@ -527,6 +851,8 @@ static void Music_Init(void) {
 	music_minDelay = Options_GetInt(OPT_MIN_MUSIC_DELAY, 0, 3600, 120) * MILLIS_PER_SEC;
 	music_maxDelay = Options_GetInt(OPT_MAX_MUSIC_DELAY, 0, 3600, 420) * MILLIS_PER_SEC;
 	music_waitable = Waitable_Create("Music sleep");
+	dec_waitable   = Waitable_Create("Music decoder");
+	dec_mutex      = Mutex_Create("Music decoder");
 
 	volume = Options_GetInt(OPT_MUSIC_VOLUME, 0, 100, DEFAULT_MUSIC_VOLUME);
 	Audio_SetMusic(volume);
@@ -535,6 +861,8 @@ static void Music_Init(void) {
 static void Music_Free(void) {
 	Music_Stop();
 	Waitable_Free(music_waitable);
+	Waitable_Free(dec_waitable);
+	Mutex_Free(dec_mutex);
 }
 #endif
 
@@ -35,8 +35,13 @@ struct AudioData {
 	int sampleRate; /* frequency / sample rate */
 	int volume; /* volume data played at (100 = normal volume) */
 	int rate;   /* speed/pitch played at (100 = normal speed) */
+	int priority; /* sounds with higher priority may take over voices playing lower priority sounds */
 };
 
+/* Priorities of the different types of sounds */
+#define AUDIO_PRIORITY_STEP 1
+#define AUDIO_PRIORITY_DIG  2
+
 /* Volume sounds are played at, from 0-100. */
 /* NOTE: Use Audio_SetSounds, don't change this directly. */
 extern int Audio_SoundsVolume;
@@ -88,6 +93,9 @@ extern struct AudioContext music_ctx;
 void Audio_Warn(cc_result res, const char* action);
 
 cc_result AudioPool_Play(struct AudioData* data);
+/* Initialises and configures any pooled audio contexts which have not been created yet */
+/*  so that playing sounds in the given format does not need to reconfigure a context */
+cc_result AudioPool_Prepare(int channels, int sampleRate);
 void AudioPool_Close(void);
 
 CC_END_HEADER
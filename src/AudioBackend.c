@@ -5,13 +5,22 @@
 #include "Errors.h"
 #include "Utils.h"
 #include "Platform.h"
+#include "ExtMath.h"
 
 void Audio_Warn(cc_result res, const char* action) {
 	Logger_Warn(res, action, Audio_DescribeError);
 }
 
+/* Define CC_BUILD_AUDIOMIXER to mix all sounds into a single backend stream in software, */
+/*  instead of playing each sound on its own pooled backend context */
+#if defined CC_BUILD_AUDIOMIXER && !defined CC_BUILD_WEBAUDIO && !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_NOSOUNDS
+#define AUDIO_SOFTWARE_MIXER
+#endif
+
+#ifndef AUDIO_SOFTWARE_MIXER
 /* Whether the given audio data can be played without recreating the underlying audio device */
 static cc_bool Audio_FastPlay(struct AudioContext* ctx, struct AudioData* data);
+#endif
 
 /* Common/Base methods */
 static void AudioBase_Clear(struct AudioContext* ctx);
@@ -267,10 +276,12 @@ cc_result Audio_Poll(struct AudioContext* ctx, int* inUse) {
 	*inUse = ctx->count - ctx->free; return 0;
 }
 
+#ifndef AUDIO_SOFTWARE_MIXER
 static cc_bool Audio_FastPlay(struct AudioContext* ctx, struct AudioData* data) {
 	/* Channels/Sample rate is per buffer, not a per source property */
 	return true;
 }
+#endif
 
 static const char* GetError(cc_result res) {
 	switch (res) {
@@ -443,11 +454,13 @@ cc_result Audio_Poll(struct AudioContext* ctx, int* inUse) {
 }
 
 
+#ifndef AUDIO_SOFTWARE_MIXER
 static cc_bool Audio_FastPlay(struct AudioContext* ctx, struct AudioData* data) {
 	int channels   = data->channels;
 	int sampleRate = Audio_AdjustSampleRate(data->sampleRate, data->rate);
 	return !ctx->channels || (ctx->channels == channels && ctx->sampleRate == sampleRate);
 }
+#endif
 
 cc_bool Audio_DescribeError(cc_result res, cc_string* dst) {
 	char buffer[NATIVE_STR_LEN] = { 0 };
@@ -689,9 +702,11 @@ cc_result Audio_Poll(struct AudioContext* ctx, int* inUse) {
 	return res;
 }
 
+#ifndef AUDIO_SOFTWARE_MIXER
 static cc_bool Audio_FastPlay(struct AudioContext* ctx, struct AudioData* data) {
 	return !ctx->channels || (ctx->channels == data->channels && ctx->sampleRate == data->sampleRate);
 }
+#endif
 
 static const char* GetError(cc_result res) {
 	switch (res) {
@@ -812,10 +827,10 @@ cc_result Audio_QueueChunk(struct AudioContext* ctx, struct AudioChunk* chunk) {
 	ndspWaveBuf* buf;
 
 	// DSP audio buffers must be aligned to a multiple of 0x80, according to the example code I could find.
-	if (((uintptr_t)chunk->data & 0x7F) != 0) {
+	if (((uintptr_t)chunk->data & 0x7F) != 0 && Platform_LogEnabled(LOG_CATEGORY_AUDIO, LOG_LEVEL_WARN)) {
 		Platform_Log1("Audio_QueueData: tried to queue buffer with non-aligned audio buffer 0x%x\n", &chunk->data);
 	}
-	if ((chunk->size & 0x7F) != 0) {
+	if ((chunk->size & 0x7F) != 0 && Platform_LogEnabled(LOG_CATEGORY_AUDIO, LOG_LEVEL_WARN)) {
 		Platform_Log1("Audio_QueueData: unaligned audio data size 0x%x\n", &chunk->size);
 	}
 
@@ -854,9 +869,11 @@ cc_result Audio_Poll(struct AudioContext* ctx, int* inUse) {
 }
 
 
+#ifndef AUDIO_SOFTWARE_MIXER
 static cc_bool Audio_FastPlay(struct AudioContext* ctx, struct AudioData* data) {
 	return true;
 }
+#endif
 
 cc_bool Audio_DescribeError(cc_result res, cc_string* dst) {
 	return false;
@@ -997,10 +1014,10 @@ cc_result Audio_QueueChunk(struct AudioContext* ctx, struct AudioChunk* chunk) {
 	AudioDriverWaveBuf* buf;
 
 	// Audio buffers must be aligned to a multiple of 0x1000, according to libnx example code
-	if (((uintptr_t)chunk->data & 0xFFF) != 0) {
+	if (((uintptr_t)chunk->data & 0xFFF) != 0 && Platform_LogEnabled(LOG_CATEGORY_AUDIO, LOG_LEVEL_WARN)) {
 		Platform_Log1("Audio_QueueData: tried to queue buffer with non-aligned audio buffer 0x%x\n", &chunk->data);
 	}
-	if ((chunk->size & 0xFFF) != 0) {
+	if ((chunk->size & 0xFFF) != 0 && Platform_LogEnabled(LOG_CATEGORY_AUDIO, LOG_LEVEL_WARN)) {
 		Platform_Log1("Audio_QueueData: unaligned audio data size 0x%x\n", &chunk->size);
 	}
 
@@ -1051,9 +1068,11 @@ cc_result Audio_Poll(struct AudioContext* ctx, int* inUse) {
 	return 0;
 }
 
+#ifndef AUDIO_SOFTWARE_MIXER
 static cc_bool Audio_FastPlay(struct AudioContext* ctx, struct AudioData* data) {
 	return true;
 }
+#endif
 
 cc_bool Audio_DescribeError(cc_result res, cc_string* dst) {
 	return false;
@@ -1182,7 +1201,7 @@ void Audio_SetVolume(struct AudioContext* ctx, int volume) {
 
 cc_result Audio_QueueChunk(struct AudioContext* ctx, struct AudioChunk* chunk) {
 	// Audio buffers must be aligned and padded to a multiple of 32 bytes
-	if (((uintptr_t)chunk->data & 0x1F) != 0) {
+	if (((uintptr_t)chunk->data & 0x1F) != 0 && Platform_LogEnabled(LOG_CATEGORY_AUDIO, LOG_LEVEL_WARN)) {
 		Platform_Log1("Audio_QueueData: tried to queue buffer with non-aligned audio buffer 0x%x\n", &chunk->data);
 	}
 
@@ -1383,9 +1402,11 @@ cc_result Audio_Poll(struct AudioContext* ctx, int* inUse) {
 	return 0;
 }
 
+#ifndef AUDIO_SOFTWARE_MIXER
 static cc_bool Audio_FastPlay(struct AudioContext* ctx, struct AudioData* data) {
 	return true;
 }
+#endif
 
 cc_bool Audio_DescribeError(cc_result res, cc_string* dst) {
 	return false;
@@ -1469,10 +1490,12 @@ cc_result Audio_Poll(struct AudioContext* ctx, int* inUse) {
 	return interop_AudioPoll(ctx->contextID, inUse);
 }
 
+#ifndef AUDIO_SOFTWARE_MIXER
 static cc_bool Audio_FastPlay(struct AudioContext* ctx, struct AudioData* data) {
 	/* Channels/Sample rate is per buffer, not a per source property */
 	return true;
 }
+#endif
 
 cc_bool Audio_DescribeError(cc_result res, cc_string* dst) {
 	char buffer[NATIVE_STR_LEN];
@@ -1665,9 +1688,11 @@ cc_result Audio_Poll(struct AudioContext* ctx, int* inUse) {
 	return ctx->done;
 }
 
+#ifndef AUDIO_SOFTWARE_MIXER
 static cc_bool Audio_FastPlay(struct AudioContext* ctx, struct AudioData* data) {
 	return false;
 }
+#endif
 
 cc_bool Audio_DescribeError(cc_result res, cc_string* dst) {
 	CHAR buffer[128];
@@ -1721,7 +1746,9 @@ cc_result Audio_Poll(struct AudioContext* ctx, int* inUse) {
 	return ERR_NOT_SUPPORTED;
 }
 
+#ifndef AUDIO_SOFTWARE_MIXER
 static cc_bool Audio_FastPlay(struct AudioContext* ctx, struct AudioData* data) { return false; }
+#endif
 
 cc_bool Audio_DescribeError(cc_result res, cc_string* dst) { return false; }
 
@@ -1825,12 +1852,203 @@ static void AudioBase_FreeChunks(struct AudioChunk* chunks, int numChunks) {
 *#########################################################################################################################*/
 struct AudioContext music_ctx;
 #define POOL_MAX_CONTEXTS 8
+#ifndef AUDIO_SOFTWARE_MIXER
 static struct AudioContext context_pool[POOL_MAX_CONTEXTS];
+#endif
+/* When all voices are busy, a new sound replaces the voice with the lowest score if it has a higher score */
+/*  (i.e. higher priority sounds win, and the quietest voice is stolen amongst equal priority sounds) */
+#define Audio_VoiceScore(data) ((data)->priority * 256 + (data)->volume)
 
 #ifndef CC_BUILD_NOSOUNDS
-static cc_result PlayAudio(struct AudioContext* ctx, struct AudioData* data) {
+#ifdef AUDIO_SOFTWARE_MIXER
+/*########################################################################################################################*
+*-----------------------------------------------------Software mixer------------------------------------------------------*
+*#########################################################################################################################*/
+#define MIXER_MAX_VOICES  16
+#define MIXER_BUFFERS     4
+#define MIXER_CHANNELS    2
+#define MIXER_SAMPLE_RATE 44100
+/* ~23 milliseconds of audio per mixed chunk */
+#define MIXER_FRAMES      1024
+
+struct MixerVoice {
+	const cc_int16* data;
+	int frames, channels, volume;
+	/* Position and step through the source samples, in 16.16 fixed point */
+	cc_uint32 pos, step;
+	int score;
+};
+static struct MixerVoice mixer_voices[MIXER_MAX_VOICES];
+static int mixer_numVoices;
+
+static struct AudioContext mixer_ctx;
+static struct AudioChunk mixer_chunks[MIXER_BUFFERS];
+static void* mixer_thread;
+static void* mixer_mutex;
+static void* mixer_waitable;
+static volatile cc_bool mixer_stopping;
+
+/* Adds the given voice's samples to the output, removing the voice once it has finished */
+static cc_bool MixerVoice_Mix(struct MixerVoice* v, int* dst, int frames) {
+	int i, ch, idx, next, frac, a, b, sample;
+
+	for (i = 0; i < frames; i++, v->pos += v->step) 
+	{
+		idx = v->pos >> 16;
+		if (idx >= v->frames) return false;
+
+		next = min(idx + 1, v->frames - 1);
+		frac = (v->pos & 0xFFFF) >> 1;
+
+		for (ch = 0; ch < MIXER_CHANNELS; ch++) 
+		{
+			a = v->data[idx  * v->channels + (ch % v->channels)];
+			b = v->data[next * v->channels + (ch % v->channels)];
+
+			sample = a + (((b - a) * frac) >> 15);
+			*dst++ += (sample * v->volume) / 100;
+		}
+	}
+	return true;
+}
+
+static void Mixer_MixChunk(struct AudioChunk* chunk) {
+	int mixed[MIXER_FRAMES * MIXER_CHANNELS] = { 0 };
+	cc_int16* dst = (cc_int16*)chunk->data;
+	int i, sample;
+
+	Mutex_Lock(mixer_mutex);
+	{
+		for (i = 0; i < mixer_numVoices; ) 
+		{
+			if (MixerVoice_Mix(&mixer_voices[i], mixed, MIXER_FRAMES)) { i++; continue; }
+			/* Finished playing, so replace with last voice */
+			mixer_voices[i] = mixer_voices[--mixer_numVoices];
+		}
+	}
+	Mutex_Unlock(mixer_mutex);
+
+	for (i = 0; i < MIXER_FRAMES * MIXER_CHANNELS; i++) 
+	{
+		sample = mixed[i];
+		Math_Clamp(sample, -32768, 32767);
+		dst[i] = (cc_int16)sample;
+	}
+	chunk->size = MIXER_FRAMES * MIXER_CHANNELS * 2;
+}
+
+static void Mixer_RunLoop(void) {
+	int inUse, cur = 0, voices;
+	cc_result res;
+
+	while (!mixer_stopping) {
+		if ((res = Audio_Poll(&mixer_ctx, &inUse))) break;
+
+		Mutex_Lock(mixer_mutex);
+		voices = mixer_numVoices;
+		Mutex_Unlock(mixer_mutex);
+
+		/* Nothing left to play, so sleep until another sound is played */
+		if (!voices) {
+			if (inUse) Thread_Sleep(5);
+			else Waitable_Wait(mixer_waitable);
+			continue;
+		}
+		if (inUse >= MIXER_BUFFERS) {
+			Thread_Sleep(5); continue;
+		}
+
+		Mixer_MixChunk(&mixer_chunks[cur]);
+		if ((res = Audio_QueueChunk(&mixer_ctx, &mixer_chunks[cur]))) break;
+		cur = (cur + 1) % MIXER_BUFFERS;
+
+		/* Backends may stop playing when they run out of queued data */
+		if (!inUse && (res = Audio_Play(&mixer_ctx))) break;
+	}
+	if (res) Audio_Warn(res, "mixing sounds");
+}
+
+static cc_result Mixer_Start(void) {
+	cc_result res;
+	if (!mixer_mutex) {
+		mixer_mutex    = Mutex_Create("Audio mixer");
+		mixer_waitable = Waitable_Create("Audio mixer");
+	}
+
+	if ((res = Audio_Init(&mixer_ctx, MIXER_BUFFERS)))                             return res;
+	if ((res = Audio_SetFormat(&mixer_ctx, MIXER_CHANNELS, MIXER_SAMPLE_RATE, 100))) return res;
+	Audio_SetVolume(&mixer_ctx, 100);
+
+	if ((res = Audio_AllocChunks(MIXER_FRAMES * MIXER_CHANNELS * 2, mixer_chunks, MIXER_BUFFERS))) return res;
+	mixer_stopping = false;
+	Thread_Run(&mixer_thread, Mixer_RunLoop, 64 * 1024, "Audio mixer");
+	return 0;
+}
+
+/* Returns the voice a new sound with the given score should be mixed into, or NULL if it should be culled */
+static struct MixerVoice* Mixer_FindVoice(int score) {
+	struct MixerVoice* victim;
+	int i;
+	if (mixer_numVoices < MIXER_MAX_VOICES) return &mixer_voices[mixer_numVoices++];
+
+	victim = &mixer_voices[0];
+	for (i = 1; i < mixer_numVoices; i++) 
+	{
+		if (mixer_voices[i].score < victim->score) victim = &mixer_voices[i];
+	}
+	return victim->score < score ? victim : NULL;
+}
+
+cc_result AudioPool_Play(struct AudioData* data) {
+	struct MixerVoice* v;
+	cc_uint32 rate;
+	cc_result res;
+
+	if (!data->channels || !data->sampleRate || data->volume <= 0) return 0;
+	if (!mixer_thread && (res = Mixer_Start())) return res;
+
+	Mutex_Lock(mixer_mutex);
+	if ((v = Mixer_FindVoice(Audio_VoiceScore(data)))) {
+		rate = Audio_AdjustSampleRate(data->sampleRate, data->rate);
+
+		v->data     = (const cc_int16*)data->chunk.data;
+		v->channels = data->channels;
+		v->frames   = data->chunk.size / (2 * data->channels);
+		v->volume   = data->volume;
+		v->pos      = 0;
+		v->step     = (cc_uint32)(((cc_uint64)rate << 16) / MIXER_SAMPLE_RATE);
+		v->score    = Audio_VoiceScore(data);
+	}
+	Mutex_Unlock(mixer_mutex);
+
+	Waitable_Signal(mixer_waitable);
+	return 0;
+}
+
+cc_result AudioPool_Prepare(int channels, int sampleRate) { return 0; }
+
+void AudioPool_Close(void) {
+	if (!mixer_thread) return;
+
+	mixer_stopping = true;
+	Waitable_Signal(mixer_waitable);
+	Thread_Join(mixer_thread);
+	mixer_thread = NULL;
+
+	/* must close audio context before freeing the chunks it may reference */
+	Audio_Close(&mixer_ctx);
+	Audio_FreeChunks(mixer_chunks, MIXER_BUFFERS);
+	mixer_numVoices = 0;
+}
+#else
+/* Score of the sound last played on each pooled context */
+static int pool_scores[POOL_MAX_CONTEXTS];
+
+static cc_result PlayAudio(int i, struct AudioData* data) {
+	struct AudioContext* ctx = &context_pool[i];
     cc_result res;
     Audio_SetVolume(ctx, data->volume);
+	pool_scores[i] = Audio_VoiceScore(data);
 
 	if ((res = Audio_SetFormat(ctx,  data->channels, data->sampleRate, data->rate))) return res;
 	if ((res = Audio_QueueChunk(ctx, &data->chunk))) return res;
@@ -1840,30 +2058,50 @@ static cc_result PlayAudio(struct AudioContext* ctx, struct AudioData* data) {
 
 cc_result AudioPool_Play(struct AudioData* data) {
 	struct AudioContext* ctx;
-	int inUse, i;
+	int inUse, i, idle = -1, victim = -1;
 	cc_result res;
 
+	/* Inaudible sounds are culled before touching the backend at all */
+	if (data->volume <= 0) return 0;
+
 	/* Try to play on a context that doesn't need to be recreated */
 	for (i = 0; i < POOL_MAX_CONTEXTS; i++) {
 		ctx = &context_pool[i];
 		if (!ctx->count && (res = Audio_Init(ctx, 1))) return res;
-
 		if ((res = Audio_Poll(ctx, &inUse))) return res;
-		if (inUse > 0) continue;
+
+		if (inUse > 0) {
+			if (victim == -1 || pool_scores[i] < pool_scores[victim]) victim = i;
+			continue;
+		}
 		
-		if (!Audio_FastPlay(ctx, data)) continue;
-		return PlayAudio(ctx, data);
+		if (Audio_FastPlay(ctx, data)) return PlayAudio(i, data);
+		if (idle == -1) idle = i;
 	}
 
-	/* Try again with all contexts, even if need to recreate one (expensive) */
+	/* Use an idle context, even if need to recreate it (expensive) */
+	if (idle >= 0) return PlayAudio(idle, data);
+
+	/* All contexts busy, so either cull this sound or steal the lowest scoring voice */
+	if (victim == -1 || pool_scores[victim] >= Audio_VoiceScore(data)) return 0;
+	ctx = &context_pool[victim];
+
+	Audio_Close(ctx);
+	if ((res = Audio_Init(ctx, 1))) return res;
+	return PlayAudio(victim, data);
+}
+
+cc_result AudioPool_Prepare(int channels, int sampleRate) {
+	struct AudioContext* ctx;
+	int i;
+	cc_result res;
+
 	for (i = 0; i < POOL_MAX_CONTEXTS; i++) {
 		ctx = &context_pool[i];
-		res = Audio_Poll(ctx, &inUse);
+		if (ctx->count) continue;
 
-		if (res) return res;
-		if (inUse > 0) continue;
-
-		return PlayAudio(ctx, data);
+		if ((res = Audio_Init(ctx, 1)))                              return res;
+		if ((res = Audio_SetFormat(ctx, channels, sampleRate, 100))) return res;
 	}
 	return 0;
 }
@@ -1875,3 +2113,4 @@ void AudioPool_Close(void) {
 	}
 }
 #endif
+#endif
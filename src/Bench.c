@@ -0,0 +1,403 @@
+#include "Core.h"
+#ifdef CC_BUILD_BENCH
+#include "Platform.h"
+#include "Logger.h"
+#include "String.h"
+#include "Constants.h"
+#include "Game.h"
+#include "World.h"
+#include "Block.h"
+#include "Entity.h"
+#include "Camera.h"
+#include "Model.h"
+#include "Lighting.h"
+#include "Builder.h"
+#include "MapRenderer.h"
+#include "Generator.h"
+#include "Formats.h"
+#include "Deflate.h"
+#include "Bitmap.h"
+#include "Stream.h"
+#include "TexturePack.h"
+#include "Graphics.h"
+#include "ExtMath.h"
+#include "Funcs.h"
+
+/*
+Headless benchmarks of engine hot paths (chunk meshing, lighting, map generation and decoding)
+  Output is CSV, one row per benchmark, so results can be diffed between releases
+  Usage: ClassiCube-bench [map.cw] (a map is generated and saved first when no map is given)
+Copyright 2014-2023 ClassiCube | Licensed under BSD-3
+*/
+#define BENCH_MAX_RUNS 16
+#define BENCH_MAP_WIDTH  256
+#define BENCH_MAP_HEIGHT 64
+#define BENCH_MAP_LENGTH 256
+static const int bench_seeds[] = { 1, 1234, 98765 };
+
+static const cc_string bench_mapPath = String_FromConst("bench-map.cw");
+static const cc_string bench_pngPath = String_FromConst("bench-image.png");
+
+typedef void (*Bench_Func)(void);
+static cc_uint32 bench_times[BENCH_MAX_RUNS];
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Reporting-------------------------------------------------------*
+*#########################################################################################################################*/
+static void Bench_Print(const cc_string* line) {
+	Platform_Log(line->buffer, line->length);
+}
+
+static void Bench_Fail(const char* place, cc_result res) {
+	cc_string msg; char msgBuffer[STRING_SIZE];
+	String_InitArray(msg, msgBuffer);
+	String_Format2(&msg, "# failed %c (error %e)", place, &res);
+	Bench_Print(&msg);
+	Process_Exit(res ? res : 1);
+}
+
+static cc_uint32 Bench_Median(int count) {
+	cc_uint32 value;
+	int i, j;
+
+	for (i = 1; i < count; i++)
+	{
+		value = bench_times[i];
+		for (j = i; j > 0 && bench_times[j - 1] > value; j--) bench_times[j] = bench_times[j - 1];
+		bench_times[j] = value;
+	}
+	return bench_times[count / 2];
+}
+
+/* Runs the given benchmark multiple times, then prints how long it took */
+/* 'units' is the amount of work done by each run (e.g. bytes or chunks), used to calculate throughput */
+static void Bench_Run(const char* name, Bench_Func func, int runs, cc_uint32 units) {
+	cc_string line; char lineBuffer[STRING_SIZE * 2];
+	cc_uint64 beg, end;
+	cc_uint32 median, lo, rate;
+	int i;
+
+	for (i = 0; i < runs; i++)
+	{
+		beg = Stopwatch_Measure();
+		func();
+		end = Stopwatch_Measure();
+		bench_times[i] = (cc_uint32)Stopwatch_ElapsedMicroseconds(beg, end);
+	}
+
+	median = Bench_Median(runs);
+	lo     = bench_times[0];
+	/* units per second, calculated from the fastest run */
+	rate   = lo ? (cc_uint32)((cc_uint64)units * 1000000 / lo) : 0;
+
+	String_InitArray(line, lineBuffer);
+	String_Format4(&line, "%c,%i,%i,%i,", name, &runs, &lo, &median);
+	String_Format2(&line, "%i,%i", &units, &rate);
+	Bench_Print(&line);
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Map generation---------------------------------------------------*
+*#########################################################################################################################*/
+static void Bench_FreeGenerated(void) {
+	Mem_Free(Gen_Blocks);
+	Gen_Blocks = NULL;
+}
+
+static void Bench_Generate(void) {
+	Bench_FreeGenerated();
+	World_SetDimensions(BENCH_MAP_WIDTH, BENCH_MAP_HEIGHT, BENCH_MAP_LENGTH);
+	Gen_Active = &NotchyGen;
+	Gen_Start();
+
+	while (!Gen_IsDone()) Thread_Sleep(1);
+	if (!Gen_Blocks) Bench_Fail("generating map", 0);
+}
+
+static void Bench_GenerateAll(void) {
+	char name[STRING_SIZE];
+	cc_string str;
+	int i;
+
+	for (i = 0; i < Array_Elems(bench_seeds); i++)
+	{
+		Gen_Seed = bench_seeds[i];
+		String_InitArray_NT(str, name);
+		String_Format1(&str, "notchygen_seed%i", &Gen_Seed);
+		str.buffer[str.length] = '\0';
+		Bench_Run(name, Bench_Generate, 3, BENCH_MAP_WIDTH * BENCH_MAP_HEIGHT * BENCH_MAP_LENGTH);
+	}
+}
+
+/* Saves a map generated with the first seed, so there is always a map to benchmark on */
+static void Bench_SaveGenerated(void) {
+	struct Stream stream, compStream;
+	struct GZipState* state;
+	cc_result res;
+
+	Gen_Seed = bench_seeds[0];
+	Bench_Generate();
+	World_SetNewMap(Gen_Blocks, BENCH_MAP_WIDTH, BENCH_MAP_HEIGHT, BENCH_MAP_LENGTH);
+	World.Seed = Gen_Seed;
+	Gen_Blocks = NULL;
+
+	if ((res = Stream_CreateFile(&stream, &bench_mapPath))) Bench_Fail("creating map", res);
+	state = (struct GZipState*)Mem_Alloc(1, sizeof(struct GZipState), "GZip state");
+	GZip_MakeStream(&compStream, state, &stream);
+
+	res = Cw_Save(&compStream);
+	if (!res) res = compStream.Close(&compStream);
+	(void)stream.Close(&stream);
+
+	Mem_Free(state);
+	if (res) Bench_Fail("saving map", res);
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------File decoding-----------------------------------------------------*
+*#########################################################################################################################*/
+static const cc_string* bench_map;
+static cc_uint8* bench_data;
+static cc_uint32 bench_dataLen;
+static cc_uint8* bench_scratch;
+static cc_uint32 bench_scratchLen;
+
+static void Bench_ReadAll(const cc_string* path) {
+	struct Stream stream;
+	cc_result res;
+
+	if ((res = Stream_OpenFile(&stream, path)))            Bench_Fail("opening file", res);
+	if ((res = stream.Length(&stream, &bench_dataLen)))    Bench_Fail("getting file length", res);
+
+	Mem_Free(bench_data);
+	bench_data = (cc_uint8*)Mem_Alloc(bench_dataLen, 1, "bench data");
+	if ((res = Stream_Read(&stream, bench_data, bench_dataLen))) Bench_Fail("reading file", res);
+	(void)stream.Close(&stream);
+}
+
+static void Bench_LoadMap(void) {
+	cc_result res = Map_LoadFrom(bench_map);
+	if (res) Bench_Fail("loading map", res);
+}
+
+/* Decompresses the .cw map file (which is GZIP compressed) */
+static cc_uint32 Bench_InflateOnce(void) {
+	struct GZipHeader gzHeader;
+	struct InflateState state;
+	struct Stream compStream, stream;
+	cc_uint32 read, total = 0;
+	cc_result res = 0;
+
+	Stream_ReadonlyMemory(&compStream, bench_data, bench_dataLen);
+	GZipHeader_Init(&gzHeader);
+	while (!gzHeader.done && !(res = GZipHeader_Read(&compStream, &gzHeader))) { }
+	if (res) Bench_Fail("reading GZIP header", res);
+
+	Inflate_MakeStream2(&stream, &state, &compStream);
+	for (;;)
+	{
+		res = stream.Read(&stream, bench_scratch, bench_scratchLen, &read);
+		if (res) Bench_Fail("inflating map", res);
+		if (!read) break;
+		total += read;
+	}
+	return total;
+}
+static void Bench_Inflate(void) { Bench_InflateOnce(); }
+
+static void Bench_MakePng(void) {
+	struct Bitmap bmp;
+	struct Stream stream;
+	RNGState rnd;
+	int x, y, r, g, b;
+	cc_result res;
+
+	Bitmap_Allocate(&bmp, 512, 512);
+	Random_Seed(&rnd, bench_seeds[0]);
+
+	/* Smooth gradients with some noise, so compression is neither trivial nor worst case */
+	for (y = 0; y < bmp.height; y++)
+	{
+		for (x = 0; x < bmp.width; x++)
+		{
+			r = (x >> 1) ^ (y >> 3);
+			g = (y >> 1) + Random_Next(&rnd, 8);
+			b = (x + y) >> 2;
+			Bitmap_GetPixel(&bmp, x, y) = BitmapColor_RGB(r & 0xFF, g & 0xFF, b & 0xFF);
+		}
+	}
+
+	if ((res = Stream_CreateFile(&stream, &bench_pngPath))) Bench_Fail("creating png", res);
+	res = Png_Encode(&bmp, &stream, NULL, true, NULL);
+	(void)stream.Close(&stream);
+	Mem_Free(bmp.scan0);
+	if (res) Bench_Fail("encoding png", res);
+}
+
+static void Bench_DecodePng(void) {
+	struct Bitmap bmp;
+	struct Stream stream;
+	cc_result res;
+
+	Stream_ReadonlyMemory(&stream, bench_data, bench_dataLen);
+	if ((res = Png_Decode(&bmp, &stream))) Bench_Fail("decoding png", res);
+	Mem_Free(bmp.scan0);
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Lighting/Meshing---------------------------------------------------*
+*#########################################################################################################################*/
+static struct ChunkInfo* bench_chunks;
+static struct ChunkPartInfo* bench_parts;
+
+static void Bench_SetLighting(cc_uint8 mode) {
+	/* Lighting component handles switching the lighting engine over */
+	Lighting_SetMode(mode, false);
+	Builder_ApplyActive();
+}
+
+static void Bench_InitLighting(void) {
+	Lighting.FreeState();
+	Lighting.AllocState();
+}
+
+/* Sets up a single 1D atlas holding all terrain tiles, since meshing never samples textures */
+static void Bench_InitAtlas(void) {
+	Atlas2D.TileSize  = 16;
+	Atlas2D.RowsCount = ATLAS2D_MAX_ROWS_COUNT;
+
+	Atlas1D.TilesPerAtlas = Atlas2D.RowsCount * ATLAS2D_TILES_PER_ROW;
+	Atlas1D.Count         = 1;
+	Atlas1D.InvTileSize   = 1.0f / Atlas1D.TilesPerAtlas;
+	Atlas1D.Mask          = Atlas1D.TilesPerAtlas - 1;
+	Atlas1D.Shift         = Math_ilog2(Atlas1D.TilesPerAtlas);
+}
+
+static void Bench_AllocChunks(void) {
+	int x, y, z, count = World.ChunksCount;
+	struct ChunkInfo* info = NULL;
+
+	bench_chunks = (struct ChunkInfo*)Mem_AllocCleared(count, sizeof(struct ChunkInfo), "bench chunks");
+	bench_parts  = (struct ChunkPartInfo*)Mem_AllocCleared(count * 2, sizeof(struct ChunkPartInfo), "bench parts");
+	MapRenderer_1DUsedCount      = 1;
+	MapRenderer_PartsNormal      = bench_parts;
+	MapRenderer_PartsTranslucent = bench_parts + count;
+
+	/* Same order as World_ChunkPack */
+	info = bench_chunks;
+	for (y = 0; y < World.ChunksY; y++)
+		for (z = 0; z < World.ChunksZ; z++)
+			for (x = 0; x < World.ChunksX; x++, info++)
+	{
+		info->centreX = (x << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+		info->centreY = (y << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+		info->centreZ = (z << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+	}
+}
+
+static void Bench_BuildChunks(void) {
+	struct ChunkInfo* info;
+	int i;
+
+	for (i = 0; i < World.ChunksCount; i++)
+	{
+		info = &bench_chunks[i];
+		info->normalParts      = NULL;
+		info->translucentParts = NULL;
+		Builder_MakeChunk(info);
+		Gfx_DeleteVb(&info->vb);
+	}
+}
+
+static void Bench_BuilderWith(const char* name, cc_bool smooth, cc_uint8 lighting) {
+	Builder_SmoothLighting = smooth;
+	Bench_SetLighting(lighting);
+	Bench_Run(name, Bench_BuildChunks, 5, World.ChunksCount);
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------------Main----------------------------------------------------------*
+*#########################################################################################################################*/
+static void Bench_AddComponents(void) {
+	/* Only the components needed to load a map and build meshes, so no window or graphics context is required */
+	Game_AddComponent(&World_Component);
+	Game_AddComponent(&Blocks_Component);
+	Game_AddComponent(&Models_Component);
+	Game_AddComponent(&Entities_Component);
+	Game_AddComponent(&Camera_Component);
+	Game_AddComponent(&Lighting_Component);
+	Game_AddComponent(&Builder_Component);
+	Game_AddComponent(&Formats_Component);
+
+	World_Component.Init();
+	Blocks_Component.Init();
+	Models_Component.Init();
+	Entities_Component.Init();
+	Camera_Component.Init();
+	Lighting_Component.Init();
+	Builder_Component.Init();
+	Formats_Component.Init();
+}
+
+int main(int argc, char** argv) {
+	cc_string args[GAME_MAX_CMDARGS];
+	cc_string line; char lineBuffer[STRING_SIZE];
+	int argsCount, w, h, l;
+
+	Logger_Hook();
+	Platform_Init();
+	argsCount = Platform_GetCommandLineArgs(argc, argv, args);
+	Bench_AddComponents();
+
+	String_InitArray(line, lineBuffer);
+	String_AppendConst(&line, "# " GAME_APP_NAME " benchmark report");
+	Bench_Print(&line);
+	line.length = 0;
+	String_AppendConst(&line, "benchmark,runs,min_us,median_us,units,units_per_sec");
+	Bench_Print(&line);
+
+	Bench_GenerateAll();
+	if (argsCount) {
+		bench_map = &args[0];
+	} else {
+		Bench_SaveGenerated();
+		bench_map = &bench_mapPath;
+	}
+
+	Bench_ReadAll(bench_map);
+	bench_scratchLen = 64 * 1024;
+	bench_scratch    = (cc_uint8*)Mem_Alloc(bench_scratchLen, 1, "bench scratch");
+
+	Bench_Run("map_load",  Bench_LoadMap, 3, bench_dataLen);
+	Bench_Run("inflate",   Bench_Inflate, 5, Bench_InflateOnce());
+	if (!World.Loaded) Bench_Fail("loading map", 0);
+
+	w = World.Width; h = World.Height; l = World.Length;
+	line.length = 0;
+	String_Format3(&line, "# map %ix%ix%i", &w, &h, &l);
+	Bench_Print(&line);
+
+	Bench_SetLighting(LIGHTING_MODE_CLASSIC);
+	Bench_Run("lighting_classic_init", Bench_InitLighting, 5, World.Volume);
+	Bench_SetLighting(LIGHTING_MODE_FANCY);
+	Bench_Run("lighting_fancy_init",   Bench_InitLighting, 5, World.Volume);
+
+	Bench_InitAtlas();
+	Bench_AllocChunks();
+	Bench_BuilderWith("builder_normal", false, LIGHTING_MODE_CLASSIC);
+	Bench_BuilderWith("builder_adv",    true,  LIGHTING_MODE_CLASSIC);
+	Bench_BuilderWith("builder_modern", true,  LIGHTING_MODE_FANCY);
+
+	Bench_MakePng();
+	Bench_ReadAll(&bench_pngPath);
+	Bench_Run("png_decode", Bench_DecodePng, 10, 512 * 512);
+
+	Process_Exit(0);
+	return 0;
+}
+#endif
@@ -6,6 +6,16 @@
 #include "Stream.h"
 #include "Errors.h"
 #include "Utils.h"
+
+/* SIMD instructions are used to speed up PNG decoding and bitmap scaling where supported */
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define PNG_SIMD_SSE2
+#elif (defined __ARM_NEON || defined __ARM_NEON__) && !defined __ARM_BIG_ENDIAN
+	#include <arm_neon.h>
+	#define PNG_SIMD_NEON
+#endif
+/* NOTE: Must be included after SIMD headers, as C++ standard library undefines min/max */
 #include "Funcs.h"
 
 BitmapCol BitmapColor_Offset(BitmapCol color, int rBy, int gBy, int bBy) {
@@ -43,6 +53,29 @@ void Bitmap_TryAllocate(struct Bitmap* bmp, int width, int height) {
 	bmp->scan0 = (BitmapCol*)Mem_TryAlloc(width * height, BITMAPCOLOR_SIZE);
 }
 
+/* Doubles the width of a row, by duplicating each source pixel */
+static void Bitmap_ScaleRow2x(BitmapCol* dstRow, const BitmapCol* srcRow, int srcWidth) {
+	int x = 0;
+#if defined PNG_SIMD_SSE2 && !defined BITMAP_16BPP
+	for (; x + 4 <= srcWidth; x += 4) {
+		__m128i pix = _mm_loadu_si128((const __m128i*)(srcRow + x));
+		_mm_storeu_si128((__m128i*)(dstRow + x * 2),     _mm_unpacklo_epi32(pix, pix));
+		_mm_storeu_si128((__m128i*)(dstRow + x * 2 + 4), _mm_unpackhi_epi32(pix, pix));
+	}
+#elif defined PNG_SIMD_NEON && !defined BITMAP_16BPP
+	for (; x + 4 <= srcWidth; x += 4) {
+		uint32x4_t pix   = vld1q_u32((const uint32_t*)(srcRow + x));
+		uint32x4x2_t dbl = vzipq_u32(pix, pix);
+		vst1q_u32((uint32_t*)(dstRow + x * 2),     dbl.val[0]);
+		vst1q_u32((uint32_t*)(dstRow + x * 2 + 4), dbl.val[1]);
+	}
+#endif
+	for (; x < srcWidth; x++) 
+	{
+		dstRow[x * 2] = srcRow[x]; dstRow[x * 2 + 1] = srcRow[x];
+	}
+}
+
 void Bitmap_Scale(struct Bitmap* dst, struct Bitmap* src, 
 					int srcX, int srcY, int srcWidth, int srcHeight) {
 	BitmapCol* dstRow;
@@ -52,6 +85,18 @@ void Bitmap_Scale(struct Bitmap* dst, struct Bitmap* src,
 	width  = dst->width;
 	height = dst->height;
 
+	/* Exactly doubling the size is common (e.g. at 200% display scale), so is worth a fast path */
+	if (width == srcWidth * 2 && height == srcHeight * 2) {
+		for (y = 0; y < height; y += 2) {
+			srcRow = Bitmap_GetRow(src, srcY + (y >> 1)) + srcX;
+			dstRow = Bitmap_GetRow(dst, y);
+
+			Bitmap_ScaleRow2x(dstRow, srcRow, srcWidth);
+			Mem_Copy(Bitmap_GetRow(dst, y + 1), dstRow, width * BITMAPCOLOR_SIZE);
+		}
+		return;
+	}
+
 	for (y = 0; y < height; y++) {
 		srcRow = Bitmap_GetRow(src, srcY + (y * srcHeight / height));
 		dstRow = Bitmap_GetRow(dst, y);
@@ -63,6 +108,257 @@ void Bitmap_Scale(struct Bitmap* dst, struct Bitmap* src,
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------PNG SIMD helpers----------------------------------------------------*
+*#########################################################################################################################*/
+#if defined PNG_SIMD_SSE2 || defined PNG_SIMD_NEON
+#define PNG_SIMD
+
+static CC_INLINE cc_uint32 Png_Load4(const cc_uint8* src) {
+	return src[0] | (src[1] << 8) | (src[2] << 16) | ((cc_uint32)src[3] << 24);
+}
+
+static CC_INLINE void Png_Store4(cc_uint8* dst, cc_uint32 value) {
+	dst[0] = (cc_uint8)(value      ); dst[1] = (cc_uint8)(value >>  8);
+	dst[2] = (cc_uint8)(value >> 16); dst[3] = (cc_uint8)(value >> 24);
+}
+#endif
+
+#if defined PNG_SIMD_SSE2
+static void Png_SimdUp(cc_uint8* line, const cc_uint8* prior, cc_uint32 lineLen) {
+	cc_uint32 i;
+	for (i = 0; i + 16 <= lineLen; i += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(line  + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(prior + i));
+		_mm_storeu_si128((__m128i*)(line + i), _mm_add_epi8(x, b));
+	}
+	for (; i < lineLen; i++) { line[i] += prior[i]; }
+}
+
+/* Each pixel depends on the pixel to its left, so partial sums are computed for 4 pixels at once */
+static void Png_SimdSub4(cc_uint8* line, cc_uint32 lineLen) {
+	__m128i a = _mm_setzero_si128();
+	cc_uint32 i;
+
+	for (i = 0; i + 16 <= lineLen; i += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(line + i));
+		x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+		x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+		x = _mm_add_epi8(x, a);
+
+		_mm_storeu_si128((__m128i*)(line + i), x);
+		a = _mm_shuffle_epi32(x, 0xFF); /* Broadcast last pixel */
+	}
+	for (; i + 4 <= lineLen; i += 4) {
+		a = _mm_add_epi8(a, _mm_cvtsi32_si128((int)Png_Load4(line + i)));
+		Png_Store4(line + i, (cc_uint32)_mm_cvtsi128_si32(a));
+	}
+}
+
+static void Png_SimdAverage4(cc_uint8* line, const cc_uint8* prior, cc_uint32 lineLen) {
+	__m128i ones = _mm_set1_epi8(1);
+	__m128i a    = _mm_setzero_si128();
+	__m128i b, avg;
+	cc_uint32 i;
+
+	for (i = 0; i + 4 <= lineLen; i += 4) {
+		b   = _mm_cvtsi32_si128((int)Png_Load4(prior + i));
+		/* _mm_avg_epu8 rounds up, whereas PNG requires rounding down */
+		avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), ones));
+		a   = _mm_add_epi8(_mm_cvtsi32_si128((int)Png_Load4(line + i)), avg);
+		Png_Store4(line + i, (cc_uint32)_mm_cvtsi128_si32(a));
+	}
+}
+
+#define Png_SseAbs16(v) _mm_max_epi16(v, _mm_sub_epi16(zero, v))
+#define Png_SseSelect(mask, x, y) _mm_or_si128(_mm_and_si128(mask, x), _mm_andnot_si128(mask, y))
+
+/* Computes in 16 bit lanes, since the predictor can exceed 8 bits */
+static void Png_SimdPaeth4(cc_uint8* line, const cc_uint8* prior, cc_uint32 lineLen) {
+	__m128i zero = _mm_setzero_si128();
+	__m128i mask = _mm_set1_epi16(0xFF);
+	__m128i a = zero, c = zero;
+	__m128i b, x, pa, pb, pc, min, pred;
+	cc_uint32 i;
+
+	for (i = 0; i + 4 <= lineLen; i += 4) {
+		b  = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)Png_Load4(prior + i)), zero);
+		x  = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)Png_Load4(line  + i)), zero);
+
+		pa = _mm_sub_epi16(b, c);
+		pb = _mm_sub_epi16(a, c);
+		pc = _mm_add_epi16(pa, pb);
+		pa = Png_SseAbs16(pa); pb = Png_SseAbs16(pb); pc = Png_SseAbs16(pc);
+
+		/* Ties are broken in the order a, b, c */
+		min  = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+		pred = Png_SseSelect(_mm_cmpeq_epi16(min, pb), b, c);
+		pred = Png_SseSelect(_mm_cmpeq_epi16(min, pa), a, pred);
+
+		a = _mm_and_si128(_mm_add_epi16(x, pred), mask);
+		c = b;
+		Png_Store4(line + i, (cc_uint32)_mm_cvtsi128_si32(_mm_packus_epi16(a, a)));
+	}
+}
+#elif defined PNG_SIMD_NEON
+static void Png_SimdUp(cc_uint8* line, const cc_uint8* prior, cc_uint32 lineLen) {
+	cc_uint32 i;
+	for (i = 0; i + 16 <= lineLen; i += 16) {
+		vst1q_u8(line + i, vaddq_u8(vld1q_u8(line + i), vld1q_u8(prior + i)));
+	}
+	for (; i < lineLen; i++) { line[i] += prior[i]; }
+}
+
+/* Each pixel depends on the pixel to its left, so partial sums are computed for 4 pixels at once */
+static void Png_SimdSub4(cc_uint8* line, cc_uint32 lineLen) {
+	uint8x16_t zero = vdupq_n_u8(0);
+	uint8x16_t a    = zero;
+	uint8x8_t  p    = vdup_n_u8(0);
+	cc_uint32 i;
+
+	for (i = 0; i + 16 <= lineLen; i += 16) {
+		uint8x16_t x = vld1q_u8(line + i);
+		x = vaddq_u8(x, vextq_u8(zero, x, 12));
+		x = vaddq_u8(x, vextq_u8(zero, x,  8));
+		x = vaddq_u8(x, a);
+
+		vst1q_u8(line + i, x);
+		a = vreinterpretq_u8_u32(vdupq_n_u32(vgetq_lane_u32(vreinterpretq_u32_u8(x), 3)));
+	}
+
+	p = vget_low_u8(a);
+	for (; i + 4 <= lineLen; i += 4) {
+		p = vadd_u8(p, vreinterpret_u8_u32(vdup_n_u32(Png_Load4(line + i))));
+		Png_Store4(line + i, vget_lane_u32(vreinterpret_u32_u8(p), 0));
+	}
+}
+
+static void Png_SimdAverage4(cc_uint8* line, const cc_uint8* prior, cc_uint32 lineLen) {
+	uint8x8_t a = vdup_n_u8(0);
+	uint8x8_t b, x;
+	cc_uint32 i;
+
+	for (i = 0; i + 4 <= lineLen; i += 4) {
+		b = vreinterpret_u8_u32(vdup_n_u32(Png_Load4(prior + i)));
+		x = vreinterpret_u8_u32(vdup_n_u32(Png_Load4(line  + i)));
+		a = vadd_u8(x, vhadd_u8(a, b));
+		Png_Store4(line + i, vget_lane_u32(vreinterpret_u32_u8(a), 0));
+	}
+}
+
+/* Computes in 16 bit lanes, since the predictor can exceed 8 bits */
+static void Png_SimdPaeth4(cc_uint8* line, const cc_uint8* prior, cc_uint32 lineLen) {
+	int16x8_t a = vdupq_n_s16(0), c = a;
+	int16x8_t b, pa, pb, pc, min, pred;
+	uint8x8_t x;
+	cc_uint32 i;
+
+	for (i = 0; i + 4 <= lineLen; i += 4) {
+		b = vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(Png_Load4(prior + i)))));
+		x = vreinterpret_u8_u32(vdup_n_u32(Png_Load4(line + i)));
+
+		pa = vsubq_s16(b, c);
+		pb = vsubq_s16(a, c);
+		pc = vabsq_s16(vaddq_s16(pa, pb));
+		pa = vabsq_s16(pa); pb = vabsq_s16(pb);
+
+		/* Ties are broken in the order a, b, c */
+		min  = vminq_s16(pc, vminq_s16(pa, pb));
+		pred = vbslq_s16(vceqq_s16(min, pb), b, c);
+		pred = vbslq_s16(vceqq_s16(min, pa), a, pred);
+
+		x = vadd_u8(x, vmovn_u16(vreinterpretq_u16_s16(pred)));
+		a = vreinterpretq_s16_u16(vmovl_u8(x));
+		c = b;
+		Png_Store4(line + i, vget_lane_u32(vreinterpret_u32_u8(x), 0));
+	}
+}
+#endif
+
+/* Row expanders convert from PNG's R,G,B(,A) byte order into the platform's BitmapCol layout */
+#if defined PNG_SIMD_SSE2 && !defined BITMAP_16BPP && BITMAPCOLOR_G_SHIFT == 8 && BITMAPCOLOR_A_SHIFT == 24
+	#if BITMAPCOLOR_R_SHIFT == 16 && BITMAPCOLOR_B_SHIFT == 0
+		/* Swaps the R and B components of each pixel */
+		#define Png_SseSwizzle(v) _mm_or_si128(_mm_and_si128(v, ga), \
+			_mm_or_si128(_mm_slli_epi32(_mm_and_si128(v, rb), 16), _mm_srli_epi32(_mm_and_si128(v, rb), 16)))
+		#define PNG_SIMD_EXPAND
+	#elif BITMAPCOLOR_R_SHIFT == 0 && BITMAPCOLOR_B_SHIFT == 16
+		#define Png_SseSwizzle(v) (v)
+		#define PNG_SIMD_EXPAND
+	#endif
+#elif defined PNG_SIMD_NEON && !defined BITMAP_16BPP
+	#define PNG_SIMD_EXPAND
+#endif
+
+#if defined PNG_SIMD_EXPAND && defined PNG_SIMD_SSE2
+/* Expands pixels from the end of the row backwards, and returns number of pixels left to expand at start of row */
+static int Png_SimdExpandRGB(int width, cc_uint8* src, BitmapCol* dst) {
+	__m128i ga    = _mm_set1_epi32((int)0xFF00FF00);
+	__m128i rb    = _mm_set1_epi32(0x00FF00FF);
+	__m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	__m128i v, lo, hi;
+	int i;
+
+	/* Each load reads the 4 bytes before the 4 pixels too, so the load never goes past the end of the row */
+	for (i = width - 4; i >= 2; i -= 4) {
+		v  = _mm_srli_si128(_mm_loadu_si128((const __m128i*)(src + i * 3 - 4)), 4);
+		lo = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+		hi = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+		v  = _mm_or_si128(_mm_unpacklo_epi64(lo, hi), alpha);
+		_mm_storeu_si128((__m128i*)(dst + i), Png_SseSwizzle(v));
+	}
+	return i + 4;
+}
+
+/* Expands pixels from the start of the row forwards, and returns number of pixels expanded */
+static int Png_SimdExpandRGBA(int width, cc_uint8* src, BitmapCol* dst) {
+	__m128i ga = _mm_set1_epi32((int)0xFF00FF00);
+	__m128i rb = _mm_set1_epi32(0x00FF00FF);
+	__m128i v;
+	int i;
+
+	for (i = 0; i + 4 <= width; i += 4) {
+		v = _mm_loadu_si128((const __m128i*)(src + i * 4));
+		_mm_storeu_si128((__m128i*)(dst + i), Png_SseSwizzle(v));
+	}
+	return i;
+}
+#elif defined PNG_SIMD_EXPAND && defined PNG_SIMD_NEON
+/* Expands pixels from the end of the row backwards, and returns number of pixels left to expand at start of row */
+static int Png_SimdExpandRGB(int width, cc_uint8* src, BitmapCol* dst) {
+	uint8x8x3_t v;
+	uint8x8x4_t d;
+	int i;
+	d.val[BITMAPCOLOR_A_SHIFT >> 3] = vdup_n_u8(255);
+
+	for (i = width - 8; i >= 0; i -= 8) {
+		v = vld3_u8(src + i * 3);
+		d.val[BITMAPCOLOR_R_SHIFT >> 3] = v.val[0];
+		d.val[BITMAPCOLOR_G_SHIFT >> 3] = v.val[1];
+		d.val[BITMAPCOLOR_B_SHIFT >> 3] = v.val[2];
+		vst4_u8((cc_uint8*)(dst + i), d);
+	}
+	return i + 8;
+}
+
+/* Expands pixels from the start of the row forwards, and returns number of pixels expanded */
+static int Png_SimdExpandRGBA(int width, cc_uint8* src, BitmapCol* dst) {
+	uint8x8x4_t v, d;
+	int i;
+
+	for (i = 0; i + 8 <= width; i += 8) {
+		v = vld4_u8(src + i * 4);
+		d.val[BITMAPCOLOR_R_SHIFT >> 3] = v.val[0];
+		d.val[BITMAPCOLOR_G_SHIFT >> 3] = v.val[1];
+		d.val[BITMAPCOLOR_B_SHIFT >> 3] = v.val[2];
+		d.val[BITMAPCOLOR_A_SHIFT >> 3] = v.val[3];
+		vst4_u8((cc_uint8*)(dst + i), d);
+	}
+	return i;
+}
+#endif
+
+
 /*########################################################################################################################*
 *------------------------------------------------------PNG decoder--------------------------------------------------------*
 *#########################################################################################################################*/
@@ -95,6 +391,9 @@ static void Png_ReconstructFirst(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8
 
 	switch (type) {
 	case PNG_FILTER_SUB:
+#ifdef PNG_SIMD
+		if (bytesPerPixel == 4) { Png_SimdSub4(line, lineLen); return; }
+#endif
 		for (i = bytesPerPixel, j = 0; i < lineLen; i++, j++) {
 			line[i] += line[j];
 		}
@@ -107,6 +406,9 @@ static void Png_ReconstructFirst(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8
 		return;
 
 	case PNG_FILTER_PAETH:
+#ifdef PNG_SIMD
+		if (bytesPerPixel == 4) { Png_SimdSub4(line, lineLen); return; }
+#endif
 		for (i = bytesPerPixel, j = 0; i < lineLen; i++, j++) {
 			line[i] += line[j];
 		}
@@ -119,18 +421,27 @@ static void Png_Reconstruct(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* lin
 
 	switch (type) {
 	case PNG_FILTER_SUB:
+#ifdef PNG_SIMD
+		if (bytesPerPixel == 4) { Png_SimdSub4(line, lineLen); return; }
+#endif
 		for (i = bytesPerPixel, j = 0; i < lineLen; i++, j++) {
 			line[i] += line[j];
 		}
 		return;
 
 	case PNG_FILTER_UP:
+#ifdef PNG_SIMD
+		Png_SimdUp(line, prior, lineLen); return;
+#endif
 		for (i = 0; i < lineLen; i++) {
 			line[i] += prior[i];
 		}
 		return;
 
 	case PNG_FILTER_AVERAGE:
+#ifdef PNG_SIMD
+		if (bytesPerPixel == 4) { Png_SimdAverage4(line, prior, lineLen); return; }
+#endif
 		for (i = 0; i < bytesPerPixel; i++) {
 			line[i] += (prior[i] >> 1);
 		}
@@ -140,6 +451,9 @@ static void Png_Reconstruct(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* lin
 		return;
 
 	case PNG_FILTER_PAETH:
+#ifdef PNG_SIMD
+		if (bytesPerPixel == 4) { Png_SimdPaeth4(line, prior, lineLen); return; }
+#endif
 		/* TODO: verify this is right */
 		for (i = 0; i < bytesPerPixel; i++) {
 			line[i] += prior[i];
@@ -204,6 +518,9 @@ static void Png_Expand_GRAYSCALE_8(int width, BitmapCol* palette, cc_uint8* src,
 }
 
 static void Png_Expand_RGB_8(int width, BitmapCol* palette, cc_uint8* src, BitmapCol* dst) {
+#ifdef PNG_SIMD_EXPAND
+	width = Png_SimdExpandRGB(width, src, dst);
+#endif
 	src += (width - 1) * 3;
 	dst += (width - 1);
 
@@ -254,6 +571,10 @@ static void Png_Expand_GRAYSCALE_A_8(int width, BitmapCol* palette, cc_uint8* sr
 
 static void Png_Expand_RGB_A_8(int width, BitmapCol* palette, cc_uint8* src, BitmapCol* dst) {
 	/* Processed in forward order */
+#ifdef PNG_SIMD_EXPAND
+	int count = Png_SimdExpandRGBA(width, src, dst);
+	width -= count; src += count * 4; dst += count;
+#endif
 
 	for (; width >= 4; width -= 4) {
 		PNG_Do_RGB_A__8(); PNG_Do_RGB_A__8();
@@ -304,16 +625,20 @@ static Png_RowExpander Png_GetExpander(cc_uint8 col, cc_uint8 bitsPerSample) {
 }
 
 /* Sets alpha to 0 for any pixels in the bitmap whose RGB is same as colorspace */
-static void ComputeTransparency(struct Bitmap* bmp, BitmapCol col) {
+static void ComputeTransparencyRow(BitmapCol* row, int width, BitmapCol col) {
 	BitmapCol trnsRGB = col & BITMAPCOLOR_RGB_MASK;
-	int x, y, width = bmp->width, height = bmp->height;
+	int x;
 
-	for (y = 0; y < height; y++) {
-		BitmapCol* row = Bitmap_GetRow(bmp, y);
-		for (x = 0; x < width; x++) {
-			BitmapCol rgb = row[x] & BITMAPCOLOR_RGB_MASK;
-			row[x] = (rgb == trnsRGB) ? trnsRGB : row[x];
-		}
+	for (x = 0; x < width; x++) {
+		BitmapCol rgb = row[x] & BITMAPCOLOR_RGB_MASK;
+		row[x] = (rgb == trnsRGB) ? trnsRGB : row[x];
+	}
+}
+
+static void ComputeTransparency(struct Bitmap* bmp, BitmapCol col) {
+	int y;
+	for (y = 0; y < bmp->height; y++) {
+		ComputeTransparencyRow(Bitmap_GetRow(bmp, y), bmp->width, col);
 	}
 }
 
@@ -329,7 +654,10 @@ static BitmapCol ExpandRGB(cc_uint8 bitsPerSample, int r, int g, int b) {
 	return BitmapCol_Make(r, g, b, 0);
 }
 
-cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
+/* Decodes a PNG image, either into bmp->scan0 or (when getRow is non-NULL) row by row into caller provided rows */
+/* NOTE: When getRow is non-NULL, the scanlines buffer is returned in rows and must be freed by the caller */
+static cc_result Png_DecodeCore(struct Bitmap* bmp, struct Stream* stream, 
+								Png_RowGetter getRow, void* ctx, cc_uint8** rows) {
 	cc_uint8 tmp[64];
 	cc_uint32 dataSize, fourCC;
 	cc_result res;
@@ -408,6 +736,14 @@ cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 			scanlineSize  = ((samplesPerPixel[colorspace] * bitsPerSample * bmp->width) + 7) >> 3;
 			scanlineBytes = scanlineSize + 1; /* Add 1 byte for filter byte of each scanline */
 
+			if (getRow) {
+				/* Only the prior and current scanlines need to be kept around */
+				data  = (cc_uint8*)Mem_TryAlloc(2, scanlineBytes);
+				*rows = data;
+				if (!data) return ERR_OUT_OF_MEMORY;
+				break;
+			}
+
 			data = (cc_uint8*)Mem_TryAlloc(bmp->height, max(scanlineBytes, bmp->width * 4));
 			bmp->scan0 = (BitmapCol*)data;
 			if (!bmp->scan0) return ERR_OUT_OF_MEMORY;
@@ -475,8 +811,42 @@ cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 				if ((res = ZLibHeader_Read(&datStream, &zlibHeader))) return res;
 			}
 
-			if (!bmp->scan0) return PNG_ERR_NO_DATA;
+			if (!data) return PNG_ERR_NO_DATA;
 			if (rowY >= bmp->height) break;
+
+			if (getRow) {
+				/* Decompress one scanline at a time, alternating between the two scanline buffers */
+				for (;;) {
+					cc_uint8* scanline = &data[(rowY & 1) * scanlineBytes];
+					cc_uint8* prior    = &data[((rowY + 1) & 1) * scanlineBytes];
+					BitmapCol* dst;
+
+					res = compStream.Read(&compStream, &scanline[bufferIdx], scanlineBytes - bufferIdx, &read);
+					if (res) return res;
+					if (!read) break;
+
+					bufferIdx += read;
+					if (bufferIdx < scanlineBytes) continue;
+					if (scanline[0] > PNG_FILTER_PAETH) return PNG_ERR_INVALID_SCANLINE;
+
+					if (rowY == 0) {
+						Png_ReconstructFirst(scanline[0], bytesPerPixel, &scanline[1], scanlineSize);
+					} else {
+						Png_Reconstruct(scanline[0], bytesPerPixel, &scanline[1], &prior[1], scanlineSize);
+					}
+
+					/* Caller may choose to discard some rows */
+					dst = getRow(bmp, rowY, ctx);
+					if (dst) {
+						rowExpander(bmp->width, palette, &scanline[1], dst);
+						if (!BitmapCol_A(trnsColor)) ComputeTransparencyRow(dst, bmp->width, trnsColor);
+					}
+
+					bufferIdx = 0;
+					if (++rowY == bmp->height) return 0;
+				}
+				break;
+			}
 			left = bufferLen - bufferIdx;
 
 			res  = compStream.Read(&compStream, &data[bufferIdx], left, &read);
@@ -547,6 +917,18 @@ cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 	}
 }
 
+cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
+	return Png_DecodeCore(bmp, stream, NULL, NULL, NULL);
+}
+
+cc_result Png_DecodeRows(struct Bitmap* bmp, struct Stream* stream, Png_RowGetter getRow, void* ctx) {
+	cc_uint8* rows = NULL;
+	cc_result res  = Png_DecodeCore(bmp, stream, getRow, ctx, &rows);
+
+	Mem_Free(rows);
+	return res;
+}
+
 
 /*########################################################################################################################*
 *------------------------------------------------------PNG encoder--------------------------------------------------------*
@@ -653,7 +1035,7 @@ static void Png_EncodeRow(const cc_uint8* cur, const cc_uint8* prior, cc_uint8*
 
 static BitmapCol* DefaultGetRow(struct Bitmap* bmp, int y, void* ctx) { return Bitmap_GetRow(bmp, y); }
 static cc_result Png_EncodeCore(struct Bitmap* bmp, struct Stream* stream, cc_uint8* buffer,
-					Png_RowGetter getRow, cc_bool alpha, void* ctx) {
+					Png_RowGetter getRow, cc_bool alpha, void* ctx, cc_bool fast) {
 	cc_uint8 tmp[32];
 	cc_uint8* prevLine = buffer;
 	cc_uint8*  curLine = buffer + (bmp->width * 4) * 1;
@@ -693,6 +1075,7 @@ static cc_result Png_EncodeCore(struct Bitmap* bmp, struct Stream* stream, cc_ui
 	if ((res = Stream_Write(&chunk, tmp, 4))) return res;
 
 	ZLib_MakeStream(&zlStream, &zlState, &chunk); 
+	if (fast) Deflate_SetLevel(&zlState.Base, DEFLATE_LEVEL_FAST);
 	lineSize = bmp->width * (alpha ? 4 : 3);
 	Mem_Set(prevLine, 0, lineSize);
 
@@ -702,7 +1085,13 @@ static cc_result Png_EncodeCore(struct Bitmap* bmp, struct Stream* stream, cc_ui
 		cc_uint8* cur  = (y & 1) == 0 ? curLine  : prevLine;
 
 		Png_MakeRow(src, cur, lineSize, alpha);
-		Png_EncodeRow(cur, prev, bestLine, lineSize, alpha);
+		if (fast) {
+			/* Paeth usually compresses best, so skip trying the other filters */
+			Png_Filter(PNG_FILTER_PAETH, cur, prev, bestLine + 1, lineSize, alpha ? 4 : 3);
+			bestLine[0] = PNG_FILTER_PAETH;
+		} else {
+			Png_EncodeRow(cur, prev, bestLine, lineSize, alpha);
+		}
 
 		/* +1 for filter byte */
 		if ((res = Stream_Write(&zlStream, bestLine, lineSize + 1))) return res;
@@ -725,22 +1114,37 @@ static cc_result Png_EncodeCore(struct Bitmap* bmp, struct Stream* stream, cc_ui
 	return stream->Seek(stream, stream_end);
 }
 
-cc_result Png_Encode(struct Bitmap* bmp, struct Stream* stream, 
-					Png_RowGetter getRow, cc_bool alpha, void* ctx) {
+static cc_result Png_EncodeWith(struct Bitmap* bmp, struct Stream* stream, 
+					Png_RowGetter getRow, cc_bool alpha, void* ctx, cc_bool fast) {
 	cc_result res;
 	/* Add 1 for scanline filter type byter */
 	cc_uint8* buffer = (cc_uint8*)Mem_TryAlloc(3, bmp->width * 4 + 1);
 	if (!buffer) return ERR_NOT_SUPPORTED;
 
-	res = Png_EncodeCore(bmp, stream, buffer, getRow, alpha, ctx);
+	res = Png_EncodeCore(bmp, stream, buffer, getRow, alpha, ctx, fast);
 	Mem_Free(buffer);
 	return res;
 }
+
+cc_result Png_Encode(struct Bitmap* bmp, struct Stream* stream, 
+					Png_RowGetter getRow, cc_bool alpha, void* ctx) {
+	return Png_EncodeWith(bmp, stream, getRow, alpha, ctx, false);
+}
+
+cc_result Png_EncodeFast(struct Bitmap* bmp, struct Stream* stream, 
+					Png_RowGetter getRow, cc_bool alpha, void* ctx) {
+	return Png_EncodeWith(bmp, stream, getRow, alpha, ctx, true);
+}
 #else
 /* No point including encoding code when can't save screenshots anyways */
 cc_result Png_Encode(struct Bitmap* bmp, struct Stream* stream, 
 					Png_RowGetter getRow, cc_bool alpha, void* ctx) {
 	return ERR_NOT_SUPPORTED;
 }
+
+cc_result Png_EncodeFast(struct Bitmap* bmp, struct Stream* stream, 
+					Png_RowGetter getRow, cc_bool alpha, void* ctx) {
+	return ERR_NOT_SUPPORTED;
+}
 #endif
 
@@ -137,11 +137,20 @@ typedef BitmapCol* (*Png_RowGetter)(struct Bitmap* bmp, int row, void* ctx);
      https://github.com/nothings/stb/blob/master/stb_image.h
 */
 CC_API cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream);
+/* Decodes a bitmap in PNG format, writing each decoded row into the row returned by getRow. */
+/* getRow can return NULL to discard that row. (e.g. when it is outside the area of interest) */
+/* NOTE: Only bmp->width and bmp->height are set, as the pixels are never stored in bmp->scan0 */
+/* NOTE: Rows are requested in order, once the width/height of the image are known */
+CC_API cc_result Png_DecodeRows(struct Bitmap* bmp, struct Stream* stream, Png_RowGetter getRow, void* ctx);
 /* Encodes a bitmap in PNG format. */
 /* getRow is optional. Can be used to modify how rows are encoded. (e.g. flip image) */
 /* if alpha is non-zero, RGBA channels are saved, otherwise only RGB channels are. */
 cc_result Png_Encode(struct Bitmap* bmp, struct Stream* stream, 
 						Png_RowGetter getRow, cc_bool alpha, void* ctx);
+/* Same as Png_Encode, but favours encoding speed over output file size. */
+/* NOTE: Only uses one row filter, and the fastest DEFLATE compression level */
+cc_result Png_EncodeFast(struct Bitmap* bmp, struct Stream* stream, 
+						Png_RowGetter getRow, cc_bool alpha, void* ctx);
 
 CC_END_HEADER
 #endif
@@ -413,6 +413,41 @@ static void Block_UpdateCulling(BlockID block) {
 	}
 }
 
+/* Servers often define hundreds of blocks at once when joining, so rather than recalculating */
+/*  culling and raising BlockDefChanged for every single block, that's only done once per frame */
+static cc_uint32 pendingDefBlocks[BLOCK_COUNT >> 5];
+static int pendingDefsCount;
+#define Block_IsDefPending(block) (pendingDefBlocks[(block) >> 5] & (1u << ((block) & 0x1F)))
+
+static void Block_MarkDefPending(BlockID block) {
+	if (Block_IsDefPending(block)) return;
+
+	pendingDefBlocks[block >> 5] |= 1u << (block & 0x1F);
+	pendingDefsCount++;
+}
+
+void Block_FlushPendingDefs(void) {
+	int i, block;
+	if (!pendingDefsCount) return;
+
+	/* Past a certain point, recalculating everything in one pass is faster */
+	if (pendingDefsCount >= BLOCK_COUNT / 4) {
+		Block_UpdateAllCulling();
+	} else {
+		for (block = BLOCK_AIR; block < BLOCK_COUNT; block++) 
+		{
+			if (Block_IsDefPending(block)) Block_UpdateCulling((BlockID)block);
+		}
+	}
+
+	for (i = 0; i < Array_Elems(pendingDefBlocks); i++) 
+	{
+		pendingDefBlocks[i] = 0;
+	}
+	pendingDefsCount = 0;
+	Event_RaiseVoid(&BlockEvents.BlockDefChanged);
+}
+
 
 /*########################################################################################################################*
 *---------------------------------------------------------Block-----------------------------------------------------------*
@@ -444,12 +479,11 @@ void Block_DefineCustom(BlockID block, cc_bool checkSprite) {
 	Block_SetCollide(block,  collide);
 	Block_SetDrawType(block, Blocks.Draw[block]);
 	Block_CalcRenderBounds(block);
-	Block_UpdateCulling(block);
 	Block_CalcLightOffset(block);
 
 	Inventory_AddDefault(block);
 	Block_SetCustomDefined(block, true);
-	Event_RaiseVoid(&BlockEvents.BlockDefChanged);
+	Block_MarkDefPending(block);
 
 	if (!checkSprite) return; /* TODO eliminate this */
 	/* Update sprite BoundingBox if necessary */
@@ -458,13 +492,12 @@ void Block_DefineCustom(BlockID block, cc_bool checkSprite) {
 
 void Block_UndefineCustom(BlockID block) {
 	Block_ResetProps(block);
-	Block_UpdateCulling(block);
 
 	Inventory_Remove(block);
 	if (block <= BLOCK_MAX_CPE) { Inventory_AddDefault(block); }
 
 	Block_SetCustomDefined(block, false);
-	Event_RaiseVoid(&BlockEvents.BlockDefChanged);
+	Block_MarkDefPending(block);
 
 	/* Update sprite BoundingBox if necessary */
 	if (Blocks.Draw[block] == DRAW_SPRITE) Block_RecalculateBB(block);
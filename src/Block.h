@@ -119,10 +119,15 @@ cc_uint8 Block_WriteFullBright(cc_uint8 brightness);
 
 /* Returns whether the given block has been changed from default */
 cc_bool Block_IsCustomDefined(BlockID block);
-/* Updates state and raises event after the given block has been defined */
+/* Updates state after the given block has been defined */
+/* NOTE: Culling state is only updated and BlockDefChanged raised in Block_FlushPendingDefs */
 void Block_DefineCustom(BlockID block, cc_bool checkSprite);
 /* Resets the given block to default */
+/* NOTE: Culling state is only updated and BlockDefChanged raised in Block_FlushPendingDefs */
 void Block_UndefineCustom(BlockID block);
+/* Updates culling state of blocks (un)defined since the last call, then raises BlockDefChanged once */
+/* NOTE: This is called once every frame */
+void Block_FlushPendingDefs(void);
 /* Resets all the properties of the given block to default */
 void Block_ResetProps(BlockID block);
 
@@ -14,6 +14,13 @@
 #include "Vectors.h"
 #include "Chat.h"
 
+/* Physics only ever looks at the lower 8 bits of blocks */
+#ifdef CC_BUILD_BRICKWORLD
+#define Physics_GetBlock(index) ((BlockRaw)World_GetRawBlock(index))
+#else
+#define Physics_GetBlock(index) World.Blocks[index]
+#endif
+
 /* Data for a resizable queue, used for liquid physic tick entries. */
 struct TickQueue {
 	cc_uint32* entries; /* Buffer holding the items in the tick queue */
@@ -86,22 +93,85 @@ static cc_uint32 TickQueue_Dequeue(struct TickQueue* queue) {
 }
 
 
+/* Schedules block indices to be processed after a delay, with one queue for each tick */
+/*  (so that each entry is only looked at once, when the tick it is due on is reached) */
+/* NOTE: TICKWHEEL_SLOTS must always be greater than the longest delay */
+#define TICKWHEEL_SLOTS 32
+struct TickWheel {
+	struct TickQueue slots[TICKWHEEL_SLOTS];
+	cc_uint8* pending; /* Bitset of block indices currently scheduled, NULL if not allocated */
+	int delay;         /* Delay normally used when scheduling entries in this wheel */
+	int tick;          /* The next tick that will be processed */
+};
+#define TickWheel_IsPending(wheel, index) ((wheel)->pending[(index) >> 3] & (1 << ((index) & 7)))
+
+static void TickWheel_Init(struct TickWheel* wheel, int delay) {
+	int i;
+	for (i = 0; i < TICKWHEEL_SLOTS; i++) TickQueue_Init(&wheel->slots[i]);
+
+	wheel->pending = NULL;
+	wheel->delay   = delay;
+	wheel->tick    = 0;
+}
+
+static void TickWheel_Clear(struct TickWheel* wheel) {
+	int i;
+	for (i = 0; i < TICKWHEEL_SLOTS; i++) TickQueue_Clear(&wheel->slots[i]);
+
+	Mem_Free(wheel->pending);
+	wheel->pending = NULL;
+}
+
+/* Schedules the given block index to be processed after 'delay' ticks */
+static void TickWheel_Schedule(struct TickWheel* wheel, int index, int delay) {
+	if (wheel->pending) {
+		/* Already scheduled item is due no later than this one would be, so it doesn't need to be scheduled again */
+		if (delay >= wheel->delay && TickWheel_IsPending(wheel, index)) return;
+		wheel->pending[index >> 3] |= 1 << (index & 7);
+	}
+	TickQueue_Enqueue(&wheel->slots[(wheel->tick + delay) & (TICKWHEEL_SLOTS - 1)], index);
+}
+
+/* Returns the queue of entries that are due this tick, and advances to the next tick */
+static struct TickQueue* TickWheel_Advance(struct TickWheel* wheel) {
+	struct TickQueue* slot = &wheel->slots[wheel->tick & (TICKWHEEL_SLOTS - 1)];
+	wheel->tick++;
+
+	/* Deduplicating is just an optimisation, so doesn't matter if out of memory */
+	if (!wheel->pending) wheel->pending = (cc_uint8*)Mem_TryAllocCleared((World.Volume + 7) >> 3, 1);
+	return slot;
+}
+
+/* Removes the next entry from the queue returned by TickWheel_Advance */
+static int TickWheel_Next(struct TickWheel* wheel, struct TickQueue* slot) {
+	int index = (int)TickQueue_Dequeue(slot);
+	if (wheel->pending) wheel->pending[index >> 3] &= ~(1 << (index & 7));
+	return index;
+}
+
+
 struct Physics_ Physics;
 static RNGState physics_rnd;
 static int physics_tickCount;
 static int physics_maxWaterX, physics_maxWaterY, physics_maxWaterZ;
-static struct TickQueue lavaQ, waterQ;
+static struct TickWheel lavaQ, waterQ;
+/* Number of blocks with a random tick handler in each chunk, so chunks without any can be skipped */
+/* NOTE: Only counted once random ticks happen, as that only occurs in singleplayer */
+static cc_uint16* physics_tickable;
+
+#define PHYSICS_ONE_DELAY    1
+#define PHYSICS_LAVA_DELAY  30
+#define PHYSICS_WATER_DELAY  5
 
-#define PHYSICS_DELAY_MASK 0xF8000000UL
-#define PHYSICS_POS_MASK   0x07FFFFFFUL
-#define PHYSICS_DELAY_SHIFT 27
-#define PHYSICS_ONE_DELAY   (1U << PHYSICS_DELAY_SHIFT)
-#define PHYSICS_LAVA_DELAY (30U << PHYSICS_DELAY_SHIFT)
-#define PHYSICS_WATER_DELAY (5U << PHYSICS_DELAY_SHIFT)
+static void Physics_FreeTickable(void* obj) {
+	Mem_Free(physics_tickable);
+	physics_tickable = NULL;
+}
 
 static void Physics_OnNewMapLoaded(void* obj) {
-	TickQueue_Clear(&lavaQ);
-	TickQueue_Clear(&waterQ);
+	TickWheel_Clear(&lavaQ);
+	TickWheel_Clear(&waterQ);
+	Physics_FreeTickable(NULL);
 
 	physics_maxWaterX = World.MaxX - 2;
 	physics_maxWaterY = World.MaxY - 2;
@@ -118,7 +188,7 @@ void Physics_SetEnabled(cc_bool enabled) {
 }
 
 static void Physics_Activate(int index) {
-	BlockID block = World.Blocks[index];
+	BlockID block = Physics_GetBlock(index);
 	PhysicsHandler activate = Physics.OnActivate[block];
 	if (activate) activate(index, block);
 }
@@ -162,12 +232,43 @@ void Physics_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now) {
 	Physics_ActivateNeighbours(x, y, z, index);
 }
 
+void Physics_OnBlockUpdated(int x, int y, int z, BlockID old, BlockID now) {
+	int index;
+	if (!physics_tickable) return;
+	index = World_ChunkPack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+
+	if (Physics.OnRandomTick[(BlockRaw)old] && physics_tickable[index]) physics_tickable[index]--;
+	if (Physics.OnRandomTick[(BlockRaw)now]) physics_tickable[index]++;
+}
+
+static void Physics_CountTickable(void) {
+	int x, y, z, index = 0;
+	BlockID block;
+
+	physics_tickable = (cc_uint16*)Mem_TryAllocCleared(World.ChunksCount, 2);
+	if (!physics_tickable) return;
+
+	for (y = 0; y < World.Height; y++) {
+		for (z = 0; z < World.Length; z++) {
+			for (x = 0; x < World.Width; x++, index++) {
+				block = Physics_GetBlock(index);
+				if (!Physics.OnRandomTick[block]) continue;
+
+				physics_tickable[World_ChunkPack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT)]++;
+			}
+		}
+	}
+}
+
 static void Physics_TickRandomBlocks(void) {
 	int lo, hi, index;
 	BlockID block;
 	PhysicsHandler tick;
 	int x, y, z, x2, y2, z2;
 
+	/* If out of memory, just tick every chunk instead */
+	if (!physics_tickable) Physics_CountTickable();
+
 	for (y = 0; y < World.Height; y += CHUNK_SIZE) {
 		y2 = min(y + CHUNK_MAX, World.MaxY);
 		for (z = 0; z < World.Length; z += CHUNK_SIZE) {
@@ -175,22 +276,25 @@ static void Physics_TickRandomBlocks(void) {
 			for (x = 0; x < World.Width; x += CHUNK_SIZE) {
 				x2 = min(x + CHUNK_MAX, World.MaxX);
 
+				/* Chunk has nothing to tick (e.g. all air or all stone) */
+				if (physics_tickable && !physics_tickable[World_ChunkPack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT)]) continue;
+
 				/* Inlined 3 random ticks for this chunk */
 				lo = World_Pack( x,  y,  z);
 				hi = World_Pack(x2, y2, z2);
 				
 				index = Random_Range(&physics_rnd, lo, hi);
-				block = World.Blocks[index];
+				block = Physics_GetBlock(index);
 				tick = Physics.OnRandomTick[block];
 				if (tick) tick(index, block);
 
 				index = Random_Range(&physics_rnd, lo, hi);
-				block = World.Blocks[index];
+				block = Physics_GetBlock(index);
 				tick = Physics.OnRandomTick[block];
 				if (tick) tick(index, block);
 
 				index = Random_Range(&physics_rnd, lo, hi);
-				block = World.Blocks[index];
+				block = Physics_GetBlock(index);
 				tick = Physics.OnRandomTick[block];
 				if (tick) tick(index, block);
 			}
@@ -207,7 +311,7 @@ static void Physics_DoFalling(int index, BlockID block) {
 	/* Find lowest block can fall into */
 	while (index >= World.OneY) {
 		index -= World.OneY;
-		other  = World.Blocks[index];
+		other  = Physics_GetBlock(index);
 
 		if (other == BLOCK_AIR || (other >= BLOCK_WATER && other <= BLOCK_STILL_LAVA))
 			found = index;
@@ -224,18 +328,6 @@ static void Physics_DoFalling(int index, BlockID block) {
 	Physics_ActivateNeighbours(x, y, z, start);
 }
 
-static cc_bool Physics_CheckItem(struct TickQueue* queue, int* posIndex) {
-	cc_uint32 item = TickQueue_Dequeue(queue);
-	*posIndex     = (int)(item & PHYSICS_POS_MASK);
-
-	if (item >= PHYSICS_ONE_DELAY) {
-		item -= PHYSICS_ONE_DELAY;
-		TickQueue_Enqueue(queue, item);
-		return false;
-	}
-	return true;
-}
-
 
 static void Physics_HandleSapling(int index, BlockID block) {
 	IVec3 coords[TREE_MAX_COUNT];
@@ -247,7 +339,7 @@ static void Physics_HandleSapling(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 
 	below = BLOCK_AIR;
-	if (y > 0) below = World.Blocks[index - World.OneY];
+	if (y > 0) below = Physics_GetBlock(index - World.OneY);
 	if (below != BLOCK_GRASS) return;
 
 	height = 5 + Random_Next(&physics_rnd, 3);
@@ -294,7 +386,7 @@ static void Physics_HandleFlower(int index, BlockID block) {
 	}
 
 	below = BLOCK_DIRT;
-	if (y > 0) below = World.Blocks[index - World.OneY];
+	if (y > 0) below = Physics_GetBlock(index - World.OneY);
 	if (!(below == BLOCK_DIRT || below == BLOCK_GRASS)) {
 		Game_UpdateBlock(x, y, z, BLOCK_AIR);
 		Physics_ActivateNeighbours(x, y, z, index);
@@ -313,7 +405,7 @@ static void Physics_HandleMushroom(int index, BlockID block) {
 	}
 
 	below = BLOCK_STONE;
-	if (y > 0) below = World.Blocks[index - World.OneY];
+	if (y > 0) below = Physics_GetBlock(index - World.OneY);
 	if (!(below == BLOCK_STONE || below == BLOCK_COBBLE)) {
 		Game_UpdateBlock(x, y, z, BLOCK_AIR);
 		Physics_ActivateNeighbours(x, y, z, index);
@@ -322,11 +414,11 @@ static void Physics_HandleMushroom(int index, BlockID block) {
 
 
 static void Physics_PlaceLava(int index, BlockID block) {
-	TickQueue_Enqueue(&lavaQ, PHYSICS_LAVA_DELAY | index);
+	TickWheel_Schedule(&lavaQ, index, PHYSICS_LAVA_DELAY);
 }
 
 static void Physics_PropagateLava(int posIndex, int x, int y, int z) {
-	BlockID block = World.Blocks[posIndex];
+	BlockID block = Physics_GetBlock(posIndex);
 
 	if (block >= BLOCK_WATER && block <= BLOCK_STILL_LAVA) {
 		/* Lava spreading into water turns the water solid */
@@ -334,7 +426,7 @@ static void Physics_PropagateLava(int posIndex, int x, int y, int z) {
 			Game_UpdateBlock(x, y, z, BLOCK_STONE);
 		}
 	} else if (Blocks.Collide[block] == COLLIDE_NONE) {
-		TickQueue_Enqueue(&lavaQ, PHYSICS_LAVA_DELAY | posIndex);
+		TickWheel_Schedule(&lavaQ, posIndex, PHYSICS_LAVA_DELAY);
 		Game_UpdateBlock(x, y, z, BLOCK_LAVA);
 	}
 }
@@ -351,24 +443,24 @@ static void Physics_ActivateLava(int index, BlockID block) {
 }
 
 static void Physics_TickLava(void) {
-	int i, count = lavaQ.count;
+	struct TickQueue* due = TickWheel_Advance(&lavaQ);
+	int i, count = due->count;
+
 	for (i = 0; i < count; i++) {
-		int index;
-		if (Physics_CheckItem(&lavaQ, &index)) {
-			BlockID block = World.Blocks[index];
-			if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA)) continue;
-			Physics_ActivateLava(index, block);
-		}
+		int index = TickWheel_Next(&lavaQ, due);
+		BlockID block = Physics_GetBlock(index);
+		if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA)) continue;
+		Physics_ActivateLava(index, block);
 	}
 }
 
 
 static void Physics_PlaceWater(int index, BlockID block) {
-	TickQueue_Enqueue(&waterQ, PHYSICS_WATER_DELAY | index);
+	TickWheel_Schedule(&waterQ, index, PHYSICS_WATER_DELAY);
 }
 
 static void Physics_PropagateWater(int posIndex, int x, int y, int z) {
-	BlockID block = World.Blocks[posIndex];
+	BlockID block = Physics_GetBlock(posIndex);
 	int xx, yy, zz;
 
 	if (block >= BLOCK_WATER && block <= BLOCK_STILL_LAVA) {
@@ -387,7 +479,7 @@ static void Physics_PropagateWater(int posIndex, int x, int y, int z) {
 			}
 		}
 
-		TickQueue_Enqueue(&waterQ, PHYSICS_WATER_DELAY | posIndex);
+		TickWheel_Schedule(&waterQ, posIndex, PHYSICS_WATER_DELAY);
 		Game_UpdateBlock(x, y, z, BLOCK_WATER);
 	}
 }
@@ -404,14 +496,14 @@ static void Physics_ActivateWater(int index, BlockID block) {
 }
 
 static void Physics_TickWater(void) {
-	int i, count = waterQ.count;
+	struct TickQueue* due = TickWheel_Advance(&waterQ);
+	int i, count = due->count;
+
 	for (i = 0; i < count; i++) {
-		int index;
-		if (Physics_CheckItem(&waterQ, &index)) {
-			BlockID block = World.Blocks[index];
-			if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
-			Physics_ActivateWater(index, block);
-		}
+		int index = TickWheel_Next(&waterQ, due);
+		BlockID block = Physics_GetBlock(index);
+		if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
+		Physics_ActivateWater(index, block);
 	}
 }
 
@@ -445,9 +537,9 @@ static void Physics_DeleteSponge(int index, BlockID block) {
 					if (!World_Contains(xx, yy, zz)) continue;
 
 					index = World_Pack(xx, yy, zz);
-					block = World.Blocks[index];
+					block = Physics_GetBlock(index);
 					if (block == BLOCK_WATER || block == BLOCK_STILL_WATER) {
-						TickQueue_Enqueue(&waterQ, index | PHYSICS_ONE_DELAY);
+						TickWheel_Schedule(&waterQ, index, PHYSICS_ONE_DELAY);
 					}
 				}
 			}
@@ -461,7 +553,7 @@ static void Physics_HandleSlab(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 	if (index < World.OneY) return;
 
-	if (World.Blocks[index - World.OneY] != BLOCK_SLAB) return;
+	if (Physics_GetBlock(index - World.OneY) != BLOCK_SLAB) return;
 	Game_UpdateBlock(x, y,     z, BLOCK_AIR);
 	Game_UpdateBlock(x, y - 1, z, BLOCK_DOUBLE_SLAB);
 }
@@ -471,7 +563,7 @@ static void Physics_HandleCobblestoneSlab(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 	if (index < World.OneY) return;
 
-	if (World.Blocks[index - World.OneY] != BLOCK_COBBLE_SLAB) return;
+	if (Physics_GetBlock(index - World.OneY) != BLOCK_COBBLE_SLAB) return;
 	Game_UpdateBlock(x, y,     z, BLOCK_AIR);
 	Game_UpdateBlock(x, y - 1, z, BLOCK_COBBLE);
 }
@@ -504,7 +596,7 @@ static void Physics_HandleTnt(int index, BlockID block) {
 				if (!World_Contains(xx, yy, zz)) continue;
 				index = World_Pack(xx, yy, zz);
 
-				block = World.Blocks[index];
+				block = Physics_GetBlock(index);
 				if (BlocksTNT(block)) continue;
 
 				Game_UpdateBlock(xx, yy, zz, BLOCK_AIR);
@@ -516,9 +608,10 @@ static void Physics_HandleTnt(int index, BlockID block) {
 
 void Physics_Init(void) {
 	Event_Register_(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
+	Event_Register_(&WorldEvents.NewMap,       NULL, Physics_FreeTickable);
 	Physics.Enabled = Options_GetBool(OPT_BLOCK_PHYSICS, true);
-	TickQueue_Init(&lavaQ);
-	TickQueue_Init(&waterQ);
+	TickWheel_Init(&lavaQ,  PHYSICS_LAVA_DELAY);
+	TickWheel_Init(&waterQ, PHYSICS_WATER_DELAY);
 
 	Physics.OnPlace[BLOCK_SAND]        = Physics_DoFalling;
 	Physics.OnPlace[BLOCK_GRAVEL]      = Physics_DoFalling;
@@ -559,10 +652,12 @@ void Physics_Init(void) {
 
 void Physics_Free(void) {
 	Event_Unregister_(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
+	Event_Unregister_(&WorldEvents.NewMap,       NULL, Physics_FreeTickable);
+	Physics_FreeTickable(NULL);
 }
 
 void Physics_Tick(void) {
-	if (!Physics.Enabled || !World.Blocks) return;
+	if (!Physics.Enabled || !World_HasBlocks()) return;
 
 	/*if ((tickCount % 5) == 0) {*/
 	Physics_TickLava();
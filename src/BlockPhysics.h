@@ -25,6 +25,9 @@ CC_VAR extern struct Physics_ {
 
 void Physics_SetEnabled(cc_bool enabled);
 void Physics_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now);
+/* Updates internal state after any block in the world has been changed. */
+/* (unlike Physics_OnBlockChanged, which is only called for blocks changed by the user) */
+void Physics_OnBlockUpdated(int x, int y, int z, BlockID old, BlockID now);
 void Physics_Init(void);
 void Physics_Free(void);
 void Physics_Tick(void);
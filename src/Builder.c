@@ -13,6 +13,8 @@
 #include "TexturePack.h"
 #include "Game.h"
 #include "Options.h"
+#include "Utils.h"
+#include "Camera.h"
 
 int Builder_SidesLevel, Builder_EdgeLevel;
 /* Packs an index into the 16x16x16 count array. Coordinates range from 0 to 15. */
@@ -20,23 +22,8 @@ int Builder_SidesLevel, Builder_EdgeLevel;
 /* Packs an index into the 18x18x18 chunk array. Coordinates range from -1 to 16. */
 #define Builder_PackChunk(xx, yy, zz) (((yy) + 1) * EXTCHUNK_SIZE_2 + ((zz) + 1) * EXTCHUNK_SIZE + ((xx) + 1))
 
-static BlockID* Builder_Chunk;
-static cc_uint8* Builder_Counts;
-static int* Builder_BitFlags;
-static int Builder_X, Builder_Y, Builder_Z;
-static BlockID Builder_Block;
-static int Builder_ChunkIndex;
-static cc_bool Builder_FullBright;
-static int Builder_ChunkEndX, Builder_ChunkEndZ;
 static int Builder_Offsets[FACE_COUNT] = { -1,1, -EXTCHUNK_SIZE,EXTCHUNK_SIZE, -EXTCHUNK_SIZE_2,EXTCHUNK_SIZE_2 };
 
-static int (*Builder_StretchXLiquid)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block);
-static int (*Builder_StretchX)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
-static int (*Builder_StretchZ)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
-static void (*Builder_RenderBlock)(int countsIndex, int x, int y, int z);
-static void (*Builder_PrePrepareChunk)(void);
-static void (*Builder_PostPrepareChunk)(void);
-
 /* Contains state for vertices for a portion of a chunk mesh (vertices that are in a 1D atlas) */
 struct Builder1DPart {
 	/* Union to save on memory, since chunk building is divided into counting then building phases */
@@ -47,10 +34,78 @@ struct Builder1DPart {
 	int sCount, sOffset;
 };
 
-/* Part builder data, for both normal and translucent parts.
-The first ATLAS1D_MAX_ATLASES parts are for normal parts, remainder are for translucent parts. */
-static struct Builder1DPart Builder_Parts[ATLAS1D_MAX_ATLASES * 2];
-static struct VertexTextured* Builder_Vertices;
+/* Contains all the state used while building the mesh of a single chunk. */
+/* Each thread building chunk meshes uses its own context, so that multiple chunks can be built at once. */
+struct BuilderContext {
+	/* Copy of the blocks in the 18x18x18 region around the chunk */
+	BlockID chunk[EXTCHUNK_SIZE_3];
+	/* Number of faces that can be stretched, for each face of each block in the chunk */
+	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT];
+	/* Number of rows of faces merged together by greedy meshing, for each face of each block in the chunk */
+	cc_uint8 heights[CHUNK_SIZE_3 * FACE_COUNT];
+#ifdef CC_BUILD_TINYSTACK
+	int bitFlags[1];
+#else
+	int bitFlags[EXTCHUNK_SIZE_3];
+#endif
+	/* Flood fill state used to calculate which faces of the chunk are connected */
+	cc_uint8 visited[CHUNK_SIZE_3];
+	cc_uint16 fillQueue[CHUNK_SIZE_3];
+	int x, y, z;
+	BlockID block;
+	int chunkIndex;
+	cc_bool fullBright;
+	int chunkEndX, chunkEndY, chunkEndZ;
+
+	/* Part builder data, for both normal and translucent parts.
+	The first ATLAS1D_MAX_ATLASES parts are for normal parts, remainder are for translucent parts. */
+	struct Builder1DPart parts[ATLAS1D_MAX_ATLASES * 2];
+	struct VertexTextured* vertices;
+	/* Temp buffer that vertices are built into before being packed */
+	struct VertexTextured* scratch;
+	int scratchCount;
+	/* Holds the vertices of chunks built by worker threads, until they are copied into VBs */
+	struct MemArena arena;
+	/* Temp buffers used to sort translucent quads from back to front */
+	cc_uint32* sortKeys;
+	int* sortQuads;
+	struct VertexTextured* sortVertices;
+	int sortCapacity;
+	struct _DrawerData drawer;
+	RNGState spriteRng;
+
+	/* Advanced/Modern mesh builder state */
+	Vec3 minBB, maxBB;
+	int initBitFlags, baseOffset;
+	float x1, y1, z1, x2, y2, z2;
+	PackedCol lerp[5], lerpX[5], lerpZ[5], lerpY[5];
+	cc_bool tinted;
+	/* Whether classic lighting is active, in which case light is calculated inline */
+	cc_bool classicLighting;
+#ifdef CC_BUILD_ADVLIGHTING
+	/* Light colour of each cell in the 18x18x18 region around the chunk, for each type of face */
+	/* Lazily calculated by the Modern mesh builder (0 means not calculated yet) */
+	PackedCol lightCache[4][EXTCHUNK_SIZE_3];
+#endif
+
+	/* Functions of the currently active mesh builder */
+	int  (*StretchXLiquid)(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block);
+	int  (*StretchX)(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
+	int  (*StretchZ)(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
+	void (*RenderBlock)(struct BuilderContext* ctx, int countsIndex, int x, int y, int z);
+	void (*PrePrepareChunk)(struct BuilderContext* ctx);
+	void (*PostPrepareChunk)(struct BuilderContext* ctx);
+};
+/* Initialises the functions of the given context to the currently active mesh builder */
+static void (*Builder_SetActive)(struct BuilderContext* ctx);
+
+/* Calling through the Lighting function pointers for every face is relatively costly, */
+/*  so classic lighting (which is by far the most commonly used) is calculated inline */
+#define Builder_LightCol(ctx, func, sun, shadow, x, y, z) \
+	((ctx)->classicLighting ? (ClassicLighting_IsLit_Inline(x, y, z) ? (sun) : (shadow)) : Lighting.func(x, y, z))
+#define Builder_IsLit(ctx, x, y, z) \
+	((ctx)->classicLighting ? ClassicLighting_IsLit_Inline(x, y, z) : Lighting.IsLit_Fast(x, y, z))
+
 
 static int Builder1DPart_VerticesCount(struct Builder1DPart* part) {
 	int i, count = part->sCount;
@@ -58,7 +113,7 @@ static int Builder1DPart_VerticesCount(struct Builder1DPart* part) {
 	return count;
 }
 
-static int Builder1DPart_CalcOffsets(struct Builder1DPart* part, int offset) {
+static int Builder1DPart_CalcOffsets(struct BuilderContext* ctx, struct Builder1DPart* part, int offset) {
 	int i, counts[FACE_COUNT];
 	part->sOffset = offset;
 
@@ -71,16 +126,16 @@ static int Builder1DPart_CalcOffsets(struct Builder1DPart* part, int offset) {
 	offset += part->sCount;
 	for (i = 0; i < FACE_COUNT; i++) 
 	{
-		part->faces.vertices[i] = &Builder_Vertices[offset];
+		part->faces.vertices[i] = &ctx->vertices[offset];
 		offset += counts[i];
 	}
 	return offset;
 }
 
-static int Builder_TotalVerticesCount(void) {
+static int Builder_TotalVerticesCount(struct BuilderContext* ctx) {
 	int i, count = 0;
 	for (i = 0; i < ATLAS1D_MAX_ATLASES * 2; i++) {
-		count += Builder1DPart_VerticesCount(&Builder_Parts[i]);
+		count += Builder1DPart_VerticesCount(&ctx->parts[i]);
 	}
 	return count;
 }
@@ -89,28 +144,28 @@ static int Builder_TotalVerticesCount(void) {
 /*########################################################################################################################*
 *----------------------------------------------------Base mesh builder----------------------------------------------------*
 *#########################################################################################################################*/
-static void AddSpriteVertices(BlockID block) {
+static void AddSpriteVertices(struct BuilderContext* ctx, BlockID block) {
 	int i = Atlas1D_Index(Block_Tex(block, FACE_XMAX));
-	struct Builder1DPart* part = &Builder_Parts[i];
+	struct Builder1DPart* part = &ctx->parts[i];
 	part->sCount += 4 * 4;
 }
 
-static void AddVertices(BlockID block, Face face) {
+static void AddVertices(struct BuilderContext* ctx, BlockID block, Face face) {
 	int baseOffset = (Blocks.Draw[block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
 	int i = Atlas1D_Index(Block_Tex(block, face));
-	struct Builder1DPart* part = &Builder_Parts[baseOffset + i];
+	struct Builder1DPart* part = &ctx->parts[baseOffset + i];
 	part->faces.count[face] += 4;
 }
 
 #ifdef CC_BUILD_GL11
-static void BuildPartVbs(struct ChunkPartInfo* info) {
+static void BuildPartVbs(struct BuilderContext* ctx, struct ChunkPartInfo* info) {
 	/* Sprites vertices are stored before chunk face sides */
 	int i, count, offset = info->offset + info->spriteCount;
 	for (i = 0; i < FACE_COUNT; i++) {
 		count = info->counts[i];
 
 		if (count) {
-			info->vbs[i] = Gfx_CreateVb2(&Builder_Vertices[offset], VERTEX_FORMAT_TEXTURED, count);
+			info->vbs[i] = Gfx_CreateVb2(&ctx->vertices[offset], VERTEX_FORMAT_TEXTURED, count);
 			offset += count;
 		} else {
 			info->vbs[i] = 0;
@@ -120,7 +175,7 @@ static void BuildPartVbs(struct ChunkPartInfo* info) {
 	count  = info->spriteCount;
 	offset = info->offset;
 	if (count) {
-		info->vbs[i] = Gfx_CreateVb2(&Builder_Vertices[offset], VERTEX_FORMAT_TEXTURED, count);
+		info->vbs[i] = Gfx_CreateVb2(&ctx->vertices[offset], VERTEX_FORMAT_TEXTURED, count);
 	} else {
 		info->vbs[i] = 0;
 	}
@@ -146,7 +201,7 @@ static cc_bool SetPartInfo(struct Builder1DPart* part, int* offset, struct Chunk
 }
 
 
-static void PrepareChunk(int x1, int y1, int z1) {
+static void PrepareChunk(struct BuilderContext* ctx, int x1, int y1, int z1) {
 	int xMax = min(World.Width,  x1 + CHUNK_SIZE);
 	int yMax = min(World.Height, y1 + CHUNK_SIZE);
 	int zMax = min(World.Length, z1 + CHUNK_SIZE);
@@ -155,89 +210,76 @@ static void PrepareChunk(int x1, int y1, int z1) {
 	BlockID b;
 	int x, y, z, xx, yy, zz;
 
-#ifdef OCCLUSION
-	int flags = ComputeOcclusion();
-#endif
-#ifdef DEBUG_OCCLUSION
-	FastColour col = new FastColour(60, 60, 60, 255);
-	if (flags & 1) col.R = 255; /* x */
-	if (flags & 4) col.G = 255; /* y */
-	if (flags & 2) col.B = 255; /* z */
-	map.Sunlight = map.Shadowlight = col;
-	map.SunlightXSide = map.ShadowlightXSide = col;
-	map.SunlightZSide = map.ShadowlightZSide = col;
-	map.SunlightYBottom = map.ShadowlightYBottom = col;
-#endif
 	
 	for (y = y1, yy = 0; y < yMax; y++, yy++) {
 		for (z = z1, zz = 0; z < zMax; z++, zz++) {
 			cIndex = Builder_PackChunk(0, yy, zz);
 
 			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
-				b = Builder_Chunk[cIndex];
+				b = ctx->chunk[cIndex];
 				if (Blocks.Draw[b] == DRAW_GAS) continue;
 				index = Builder_PackCount(xx, yy, zz);
 
 				/* Sprites can't be stretched, nor can then be they hidden by other blocks. */
 				/* Note sprites are drawn using DrawSprite and not with any of the DrawXFace. */
-				if (Blocks.Draw[b] == DRAW_SPRITE) { AddSpriteVertices(b); continue; }
+				if (Blocks.Draw[b] == DRAW_SPRITE) { AddSpriteVertices(ctx, b); continue; }
 
-				Builder_X = x; Builder_Y = y; Builder_Z = z;
-				Builder_FullBright = Blocks.Brightness[b];
+				ctx->x = x; ctx->y = y; ctx->z = z;
+				ctx->fullBright = Blocks.Brightness[b];
 				tileIdx = b * BLOCK_COUNT;
 				/* All of these function calls are inlined as they can be called tens of millions to hundreds of millions of times. */
 
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->counts[index] == 0 ||
 					(x == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(x != 0 && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - 1]] & FACE_BIT_XMIN) != 0)) {
-					Builder_Counts[index] = 0;
+					(x != 0 && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex - 1]] & FACE_BIT_XMIN) != 0)) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchZ(index, x, y, z, cIndex, b, FACE_XMIN);
+					ctx->counts[index] = ctx->StretchZ(ctx, index, x, y, z, cIndex, b, FACE_XMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->counts[index] == 0 ||
 					(x == World.MaxX && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(x != World.MaxX && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + 1]] & FACE_BIT_XMAX) != 0)) {
-					Builder_Counts[index] = 0;
+					(x != World.MaxX && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex + 1]] & FACE_BIT_XMAX) != 0)) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchZ(index, x, y, z, cIndex, b, FACE_XMAX);
+					ctx->counts[index] = ctx->StretchZ(ctx, index, x, y, z, cIndex, b, FACE_XMAX);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->counts[index] == 0 ||
 					(z == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(z != 0 && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - EXTCHUNK_SIZE]] & FACE_BIT_ZMIN) != 0)) {
-					Builder_Counts[index] = 0;
+					(z != 0 && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex - EXTCHUNK_SIZE]] & FACE_BIT_ZMIN) != 0)) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_ZMIN);
+					ctx->counts[index] = ctx->StretchX(ctx, index, x, y, z, cIndex, b, FACE_ZMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->counts[index] == 0 ||
 					(z == World.MaxZ && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(z != World.MaxZ && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + EXTCHUNK_SIZE]] & FACE_BIT_ZMAX) != 0)) {
-					Builder_Counts[index] = 0;
+					(z != World.MaxZ && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex + EXTCHUNK_SIZE]] & FACE_BIT_ZMAX) != 0)) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_ZMAX);
+					ctx->counts[index] = ctx->StretchX(ctx, index, x, y, z, cIndex, b, FACE_ZMAX);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 || y == 0 ||
-					(Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - EXTCHUNK_SIZE_2]] & FACE_BIT_YMIN) != 0) {
-					Builder_Counts[index] = 0;
+				if (ctx->counts[index] == 0 || y == 0 ||
+					(Blocks.Hidden[tileIdx + ctx->chunk[cIndex - EXTCHUNK_SIZE_2]] & FACE_BIT_YMIN) != 0) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_YMIN);
+					ctx->counts[index] = ctx->StretchX(ctx, index, x, y, z, cIndex, b, FACE_YMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
-					(Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + EXTCHUNK_SIZE_2]] & FACE_BIT_YMAX) != 0) {
-					Builder_Counts[index] = 0;
+				if (ctx->counts[index] == 0 ||
+					(Blocks.Hidden[tileIdx + ctx->chunk[cIndex + EXTCHUNK_SIZE_2]] & FACE_BIT_YMAX) != 0) {
+					ctx->counts[index] = 0;
 				} else if (b < BLOCK_WATER || b > BLOCK_STILL_LAVA) {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_YMAX);
+					ctx->counts[index] = ctx->StretchX(ctx, index, x, y, z, cIndex, b, FACE_YMAX);
 				} else {
-					Builder_Counts[index] = Builder_StretchXLiquid(index, x, y, z, cIndex, b);
+					ctx->counts[index] = ctx->StretchXLiquid(ctx, index, x, y, z, cIndex, b);
 				}
 			}
 		}
@@ -256,27 +298,29 @@ for (yy = -1; yy < 17; ++yy) {\
 			block    = get_block;\
 			allAir   = allAir   && Blocks.Draw[block] == DRAW_GAS;\
 			allSolid = allSolid && Blocks.FullOpaque[block];\
-			Builder_Chunk[cIndex] = block;\
+			ctx->chunk[cIndex] = block;\
 		}\
 	}\
 }
 
-static cc_bool ReadChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+static cc_bool ReadChunkData(struct BuilderContext* ctx, int x1, int y1, int z1, cc_bool* outAllAir) {
+#ifndef CC_BUILD_BRICKWORLD
 	BlockRaw* blocks = World.Blocks;
-	BlockRaw* blocks2;
+#endif
 	cc_bool allAir = true, allSolid = true;
 	int index, cIndex;
 	BlockID block;
 	int xx, yy, zz, y;
 
-#ifndef EXTENDED_BLOCKS
+#if defined CC_BUILD_BRICKWORLD
+	ReadChunkBody(World_GetBlock(x1 + xx, y, z1 + zz));
+#elif !defined EXTENDED_BLOCKS
 	ReadChunkBody(blocks[index]);
 #else
 	if (World.IDMask <= 0xFF) {
 		ReadChunkBody(blocks[index]);
 	} else {
-		blocks2 = World.Blocks2;
-		ReadChunkBody(blocks[index] | (blocks2[index] << 8));
+		ReadChunkBody(World_GetRawBlock(index));
 	}
 #endif
 
@@ -305,27 +349,29 @@ for (yy = -1; yy < 17; ++yy) {\
 \
 			block  = get_block;\
 			allAir = allAir && Blocks.Draw[block] == DRAW_GAS;\
-			Builder_Chunk[cIndex] = block;\
+			ctx->chunk[cIndex] = block;\
 		}\
 	}\
 }
 
-static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+static cc_bool ReadBorderChunkData(struct BuilderContext* ctx, int x1, int y1, int z1, cc_bool* outAllAir) {
+#ifndef CC_BUILD_BRICKWORLD
 	BlockRaw* blocks = World.Blocks;
-	BlockRaw* blocks2;
+#endif
 	cc_bool allAir = true;
 	int index, cIndex;
 	BlockID block;
 	int xx, yy, zz, x, y, z;
 
-#ifndef EXTENDED_BLOCKS
+#if defined CC_BUILD_BRICKWORLD
+	ReadBorderChunkBody(World_GetBlock(x, y, z));
+#elif !defined EXTENDED_BLOCKS
 	ReadBorderChunkBody(blocks[index]);
 #else
 	if (World.IDMask <= 0xFF) {
 		ReadBorderChunkBody(blocks[index]);
 	} else {
-		blocks2 = World.Blocks2;
-		ReadBorderChunkBody(blocks[index] | (blocks2[index] << 8));
+		ReadBorderChunkBody(World_GetRawBlock(index));
 	}
 #endif
 
@@ -333,7 +379,7 @@ static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
 	return false;
 }
 
-static void OutputChunkPartsMeta(int x, int y, int z, struct ChunkInfo* info) {
+static void OutputChunkPartsMeta(struct BuilderContext* ctx, int x, int y, int z, struct ChunkInfo* info) {
 	cc_bool hasNorm, hasTran;
 	int partsIndex;
 	int i, j, curIdx, offset;
@@ -347,8 +393,8 @@ static void OutputChunkPartsMeta(int x, int y, int z, struct ChunkInfo* info) {
 		j = i + ATLAS1D_MAX_ATLASES;
 		curIdx = partsIndex + i * World.ChunksCount;
 
-		hasNorm |= SetPartInfo(&Builder_Parts[i], &offset, &MapRenderer_PartsNormal[curIdx]);
-		hasTran |= SetPartInfo(&Builder_Parts[j], &offset, &MapRenderer_PartsTranslucent[curIdx]);
+		hasNorm |= SetPartInfo(&ctx->parts[i], &offset, &MapRenderer_PartsNormal[curIdx]);
+		hasTran |= SetPartInfo(&ctx->parts[j], &offset, &MapRenderer_PartsTranslucent[curIdx]);
 	}
 
 	if (hasNorm) {
@@ -359,130 +405,659 @@ static void OutputChunkPartsMeta(int x, int y, int z, struct ChunkInfo* info) {
 	}
 }
 
-void Builder_MakeChunk(struct ChunkInfo* info) {
-#ifdef CC_BUILD_TINYSTACK
-	/* The Saturn build only has 16 kb stack, not large enough */
-	static BlockID chunk[EXTCHUNK_SIZE_3]; 
-	static cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
-	static int bitFlags[1];
-#else
-	BlockID chunk[EXTCHUNK_SIZE_3]; 
-	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
-	int bitFlags[EXTCHUNK_SIZE_3];
-#endif
+/* Adds the given neighbouring block to the flood fill queue, if it has not been visited yet and is not opaque */
+#define Builder_FillCell(cond, offset, xx, yy, zz) \
+if ((cond) && !ctx->visited[index + (offset)] && !Blocks.FullOpaque[ctx->chunk[Builder_PackChunk(xx, yy, zz)]]) {\
+	ctx->visited[index + (offset)] = true;\
+	ctx->fillQueue[tail++] = index + (offset);\
+}
+
+/* Flood fills the non opaque blocks connected to the given block, returning the faces of the chunk they touch */
+static int FloodFillRegion(struct BuilderContext* ctx, int start, int xEnd, int yEnd, int zEnd) {
+	int head = 0, tail = 0, faces = 0;
+	int index, x, y, z;
+
+	ctx->visited[start]    = true;
+	ctx->fillQueue[tail++] = start;
+
+	while (head < tail) {
+		index = ctx->fillQueue[head++];
+		x = index & 0x0F; z = (index >> 4) & 0x0F; y = index >> 8;
+
+		if (x == 0) faces |= 1 << FACE_XMIN;
+		if (z == 0) faces |= 1 << FACE_ZMIN;
+		if (y == 0) faces |= 1 << FACE_YMIN;
+		if (x == xEnd - 1) faces |= 1 << FACE_XMAX;
+		if (z == zEnd - 1) faces |= 1 << FACE_ZMAX;
+		if (y == yEnd - 1) faces |= 1 << FACE_YMAX;
+
+		Builder_FillCell(x > 0,        -1,    x - 1, y, z);
+		Builder_FillCell(x < xEnd - 1,  1,    x + 1, y, z);
+		Builder_FillCell(z > 0,        -16,   x, y, z - 1);
+		Builder_FillCell(z < zEnd - 1,  16,   x, y, z + 1);
+		Builder_FillCell(y > 0,        -256,  x, y - 1, z);
+		Builder_FillCell(y < yEnd - 1,  256,  x, y + 1, z);
+	}
+	return faces;
+}
 
+/* Calculates which faces of the chunk can be seen from which other faces, through non opaque blocks */
+static void CalcConnectivity(struct BuilderContext* ctx, struct ChunkInfo* info, int x1, int y1, int z1) {
+	int xEnd = min(CHUNK_SIZE, World.Width  - x1);
+	int yEnd = min(CHUNK_SIZE, World.Height - y1);
+	int zEnd = min(CHUNK_SIZE, World.Length - z1);
+	int x, y, z, index, faces, face;
+
+	Mem_Set(info->connects,  0, sizeof(info->connects));
+	Mem_Set(ctx->visited, false, sizeof(ctx->visited));
+
+	for (y = 0; y < yEnd; y++) {
+		for (z = 0; z < zEnd; z++) {
+			for (x = 0; x < xEnd; x++) {
+				index = (y << 8) | (z << 4) | x;
+				if (ctx->visited[index] || Blocks.FullOpaque[ctx->chunk[Builder_PackChunk(x, y, z)]]) continue;
+
+				faces = FloodFillRegion(ctx, index, xEnd, yEnd, zEnd);
+				for (face = 0; face < FACE_COUNT; face++) {
+					if (faces & (1 << face)) info->connects[face] |= faces;
+				}
+			}
+		}
+	}
+}
+
+/* Copies the blocks in and around the given chunk into the context's chunk buffer */
+/* Returns false if the chunk is known to have no visible faces (e.g. all air) */
+static cc_bool ReadChunk(struct BuilderContext* ctx, struct ChunkInfo* info) {
 	cc_bool allAir, allSolid, onBorder;
-	int xMax, yMax, zMax, totalVerts;
-	int cIndex, index;
-	int x, y, z, xx, yy, zz;
 	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
 
-	Builder_Chunk  = chunk;
-	Builder_Counts = counts;
-	Builder_BitFlags = bitFlags;
-	Builder_PrePrepareChunk();
-	
 	onBorder = 
 		x1 == 0 || y1 == 0 || z1 == 0   || x1 + CHUNK_SIZE >= World.Width ||
 		y1 + CHUNK_SIZE >= World.Height || z1 + CHUNK_SIZE >= World.Length;
 
 	if (onBorder) {
 		/* less optimal case here */
-		Mem_Set(chunk, BLOCK_AIR, EXTCHUNK_SIZE_3 * sizeof(BlockID));
-		allSolid = ReadBorderChunkData(x1, y1, z1, &allAir);
+		Mem_Set(ctx->chunk, BLOCK_AIR, EXTCHUNK_SIZE_3 * sizeof(BlockID));
+		allSolid = ReadBorderChunkData(ctx, x1, y1, z1, &allAir);
 	} else {
-		allSolid = ReadChunkData(x1, y1, z1, &allAir);
+		allSolid = ReadChunkData(ctx, x1, y1, z1, &allAir);
 	}
 
 	info->allAir = allAir;
-	if (allAir || allSolid) return;
-	Lighting.LightHint(x1 - 1, y1 - 1, z1 - 1);
+	if (MapRenderer_OcclusionCulling) {
+		if (allAir || allSolid) {
+			Mem_Set(info->connects, allAir ? 0x3F : 0x00, sizeof(info->connects));
+		} else {
+			CalcConnectivity(ctx, info, x1, y1, z1);
+		}
+	}
+	return !allAir && !allSolid;
+}
+
+/* Calculates which faces of the blocks in the chunk are visible and can be stretched */
+/* Returns total number of vertices in the chunk's mesh */
+static int CountChunk(struct BuilderContext* ctx, int x1, int y1, int z1) {
+	Mem_Set(ctx->counts, 1, CHUNK_SIZE_3 * FACE_COUNT);
+	ctx->chunkEndX = min(World.Width,  x1 + CHUNK_SIZE);
+	ctx->chunkEndY = min(World.Height, y1 + CHUNK_SIZE);
+	ctx->chunkEndZ = min(World.Length, z1 + CHUNK_SIZE);
+
+	PrepareChunk(ctx, x1, y1, z1);
+	return Builder_TotalVerticesCount(ctx);
+}
+
+/* Outputs the vertices of all the visible faces in the chunk into ctx->vertices */
+static void RenderChunk(struct BuilderContext* ctx, int x1, int y1, int z1) {
+	int xMax = min(World.Width,  x1 + CHUNK_SIZE);
+	int yMax = min(World.Height, y1 + CHUNK_SIZE);
+	int zMax = min(World.Length, z1 + CHUNK_SIZE);
+	int cIndex, index;
+	int x, y, z, xx, yy, zz;
+
+	ctx->PostPrepareChunk(ctx);
+	for (y = y1, yy = 0; y < yMax; y++, yy++) {
+		for (z = z1, zz = 0; z < zMax; z++, zz++) {
+			cIndex = Builder_PackChunk(0, yy, zz);
+
+			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
+				ctx->block = ctx->chunk[cIndex];
+				if (Blocks.Draw[ctx->block] == DRAW_GAS) continue;
+
+				index = Builder_PackCount(xx, yy, zz);
+				ctx->chunkIndex = cIndex;
+				ctx->RenderBlock(ctx, index, x, y, z);
+			}
+		}
+	}
+}
+
+#ifdef CC_BUILD_GL11
+static void BuildChunkVbs(struct BuilderContext* ctx, struct ChunkInfo* info) {
+	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	int i, curIdx, cIndex = World_ChunkPack(x1 >> CHUNK_SHIFT, y1 >> CHUNK_SHIFT, z1 >> CHUNK_SHIFT);
+
+	for (i = 0; i < MapRenderer_1DUsedCount; i++) {
+		curIdx = cIndex + i * World.ChunksCount;
+
+		BuildPartVbs(ctx, &MapRenderer_PartsNormal[curIdx]);
+		BuildPartVbs(ctx, &MapRenderer_PartsTranslucent[curIdx]);
+	}
+}
+#endif
+
+struct BuilderContext* Builder_CreateContext(void) {
+	struct BuilderContext* ctx = (struct BuilderContext*)Mem_TryAlloc(1, sizeof(struct BuilderContext));
+	if (!ctx) return NULL;
+
+	ctx->scratch      = NULL;
+	ctx->scratchCount = 0;
+	ctx->arena.head   = NULL;
+	ctx->sortKeys     = NULL;
+	ctx->sortQuads    = NULL;
+	ctx->sortVertices = NULL;
+	ctx->sortCapacity = 0;
+	return ctx;
+}
+
+static void FreeSortBuffers(struct BuilderContext* ctx) {
+	Mem_Free(ctx->sortKeys);
+	Mem_Free(ctx->sortQuads);
+	Mem_Free(ctx->sortVertices);
+
+	ctx->sortKeys     = NULL;
+	ctx->sortQuads    = NULL;
+	ctx->sortVertices = NULL;
+	ctx->sortCapacity = 0;
+}
+
+void Builder_FreeContext(struct BuilderContext* ctx) {
+	Mem_Free(ctx->scratch);
+	MemArena_Free(&ctx->arena);
+	FreeSortBuffers(ctx);
+	Mem_Free(ctx);
+}
+
+#ifndef CC_BUILD_GL11
+static void PackVertices(struct VertexPacked* dst, const struct VertexTextured* src, int count) {
+	/* With a terrain texture array, V is spread across all of the layers */
+	float layers = Atlas1D.Layers ? (float)Atlas1D.Layers : 1.0f;
+	float v;
+	int i, layer;
+
+	for (i = 0; i < count; i++, src++, dst++) 
+	{
+		/* Round positions to nearest, so that faces which share an edge still line up */
+		dst->x = (cc_uint16)((src->x + VERTEX_PACKED_POS_BIAS) * VERTEX_PACKED_POS_SCALE + 0.5f);
+		dst->y = (cc_uint16)((src->y + VERTEX_PACKED_POS_BIAS) * VERTEX_PACKED_POS_SCALE + 0.5f);
+		dst->z = (cc_uint16)((src->z + VERTEX_PACKED_POS_BIAS) * VERTEX_PACKED_POS_SCALE + 0.5f);
+		dst->Col  = src->Col;
+
+		v     = src->V * layers;
+		layer = (int)v;
+		dst->layer = layer;
+
+		/* Round UVs down, so that coordinates just inside a tile edge don't spill over into the next tile */
+		dst->U = (cc_uint16)(src->U * VERTEX_PACKED_U_SCALE);
+		dst->V = (cc_uint16)((v - layer) * VERTEX_PACKED_V_SCALE);
+	}
+}
+
+static struct VertexPacked* packedVertices;
+static int packedVerticesCount;
+
+/* Copies the vertices into the chunk's space in the shared vertex buffers, packing them first if necessary */
+static cc_bool PoolVertices(struct ChunkInfo* info, const struct VertexTextured* vertices, int count) {
+	struct VertexPacked* data;
+	if (!Builder_PackedVertices) return MapRenderer_PoolVertices(info, (void*)vertices, count);
+
+	if (count > packedVerticesCount) {
+		data = (struct VertexPacked*)Mem_TryRealloc(packedVertices, count, SIZEOF_VERTEX_PACKED);
+		if (!data) return false;
+
+		packedVertices      = data;
+		packedVerticesCount = count;
+	}
+	PackVertices(packedVertices, vertices, count);
+	return MapRenderer_PoolVertices(info, packedVertices, count);
+}
+
+/* Copies the vertices into the chunk's vertex buffer, packing them first if necessary */
+/* NOTE: With region batching, vertices are instead kept in memory to later be copied into the region's VB */
+static void UploadVertices(struct ChunkInfo* info, const struct VertexTextured* vertices, int count) {
+	void* data;
+
+	if (MapRenderer_RegionBatching) {
+		if (Builder_PackedVertices) {
+			info->vertices = Mem_Alloc(count, SIZEOF_VERTEX_PACKED,   "chunk vertices");
+			PackVertices((struct VertexPacked*)info->vertices, vertices, count);
+		} else {
+			info->vertices = Mem_Alloc(count, SIZEOF_VERTEX_TEXTURED, "chunk vertices");
+			Mem_Copy(info->vertices, vertices, count * sizeof(struct VertexTextured));
+		}
+		return;
+	}
+	if (MapRenderer_PooledVertices && PoolVertices(info, vertices, count)) return;
+
+	/* add an extra element to fix crashing on some GPUs */
+	if (Builder_PackedVertices) {
+		data = Gfx_RecreateAndLockVb(&info->vb, VERTEX_FORMAT_PACKED,   count + 1);
+		PackVertices((struct VertexPacked*)data, vertices, count);
+	} else {
+		data = Gfx_RecreateAndLockVb(&info->vb, VERTEX_FORMAT_TEXTURED, count + 1);
+		Mem_Copy(data, vertices, count * sizeof(struct VertexTextured));
+	}
+	Gfx_UnlockVb(info->vb);
+}
+
+static struct VertexTextured* GetScratchVertices(struct BuilderContext* ctx, int count) {
+	if (count > ctx->scratchCount) {
+		ctx->scratch = (struct VertexTextured*)Mem_Realloc(ctx->scratch, count, 
+													sizeof(struct VertexTextured), "chunk vertices");
+		ctx->scratchCount = count;
+	}
+	return ctx->scratch;
+}
+
+static void SortQuads(cc_uint32* keys, int* values, int left, int right) {
+	cc_uint32 key; int value;
+	#define SortQuads_(l, r) SortQuads(keys, values, l, r)
+
+	while (left < right) {
+		int i = left, j = right;
+		cc_uint32 pivot = keys[(i + j) >> 1];
+
+		/* partition the list */
+		while (i <= j) {
+			while (pivot > keys[i]) i++;
+			while (pivot < keys[j]) j--;
+			QuickSort_Swap_KV_Maybe();
+		}
+		/* recurse into the smaller subset */
+		QuickSort_Recurse(SortQuads_)
+	}
+}
+
+/* Reorders the quads in the given range so that they are ordered from furthest to nearest to pos */
+static void SortFaceQuads(struct BuilderContext* ctx, struct VertexTextured* v, int quads, const Vec3* pos) {
+	union IntAndFloat dist;
+	float dx, dy, dz;
+	int i;
+
+	if (quads > ctx->sortCapacity) {
+		FreeSortBuffers(ctx);
+		ctx->sortKeys     = (cc_uint32*)Mem_Alloc(quads, 4, "sort keys");
+		ctx->sortQuads    = (int*)Mem_Alloc(quads, sizeof(int), "sort quads");
+		ctx->sortVertices = (struct VertexTextured*)Mem_Alloc(quads * 4, sizeof(struct VertexTextured), "sort vertices");
+		ctx->sortCapacity = quads;
+	}
+
+	for (i = 0; i < quads; i++) 
+	{
+		dx = (v[i * 4].x + v[i * 4 + 2].x) * 0.5f - pos->x;
+		dy = (v[i * 4].y + v[i * 4 + 2].y) * 0.5f - pos->y;
+		dz = (v[i * 4].z + v[i * 4 + 2].z) * 0.5f - pos->z;
+
+		/* Bit patterns of non-negative floats sort in the same order as the floats themselves */
+		dist.f = dx * dx + dy * dy + dz * dz;
+		ctx->sortKeys[i]  = dist.u;
+		ctx->sortQuads[i] = i;
+	}
+	SortQuads(ctx->sortKeys, ctx->sortQuads, 0, quads - 1);
+
+	for (i = 0; i < quads; i++) 
+	{
+		Mem_Copy(&ctx->sortVertices[i * 4], &v[ctx->sortQuads[quads - 1 - i] * 4], 4 * sizeof(struct VertexTextured));
+	}
+	Mem_Copy(v, ctx->sortVertices, quads * 4 * sizeof(struct VertexTextured));
+}
 
-	Mem_Set(counts, 1, CHUNK_SIZE_3 * FACE_COUNT);
-	xMax = min(World.Width,  x1 + CHUNK_SIZE);
-	yMax = min(World.Height, y1 + CHUNK_SIZE);
-	zMax = min(World.Length, z1 + CHUNK_SIZE);
+/* Sorts the quads of each face of the translucent parts of the chunk from back to front */
+/* NOTE: Quads of different faces are still drawn separately, so are not sorted relative to each other */
+static void SortTranslucentParts(struct BuilderContext* ctx) {
+	struct VertexTextured* beg;
+	struct VertexTextured* end;
+	struct Builder1DPart* part;
+	Vec3 pos = Camera.CurrentPos;
+	int i, face;
 
-	Builder_ChunkEndX = xMax; Builder_ChunkEndZ = zMax;
-	PrepareChunk(x1, y1, z1);
+	for (i = ATLAS1D_MAX_ATLASES; i < ATLAS1D_MAX_ATLASES * 2; i++)
+	{
+		part = &ctx->parts[i];
+		beg  = &ctx->vertices[part->sOffset + part->sCount];
+
+		for (face = 0; face < FACE_COUNT; face++) 
+		{
+			end = part->faces.vertices[face];
+			if (end - beg > 4) SortFaceQuads(ctx, beg, (int)(end - beg) >> 2, &pos);
+			beg = end;
+		}
+	}
+}
+#endif
+
+void Builder_MakeChunkWith(struct BuilderContext* ctx, struct ChunkInfo* info) {
+	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	int totalVerts;
 
-	totalVerts = Builder_TotalVerticesCount();
+	Builder_SetActive(ctx);
+	ctx->PrePrepareChunk(ctx);
+	if (!ReadChunk(ctx, info)) return;
+	Lighting.LightHint(x1 - 1, y1 - 1, z1 - 1);
+
+	totalVerts = CountChunk(ctx, x1, y1, z1);
 	if (!totalVerts) return;
 	
-	OutputChunkPartsMeta(x1, y1, z1, info);
-#ifdef OCCLUSION
-	if (info.NormalParts != null || info.TranslucentParts != null)
-		info.occlusionFlags = (cc_uint8)ComputeOcclusion();
-#endif
+	OutputChunkPartsMeta(ctx, x1, y1, z1, info);
 
 #ifndef CC_BUILD_GL11
+	/* NOTE: Translucent parts are sorted in system memory, since reading back from VB memory can be very slow */
+	if (Builder_PackedVertices || MapRenderer_RegionBatching || MapRenderer_SortTranslucent || MapRenderer_PooledVertices) {
+		ctx->vertices = GetScratchVertices(ctx, totalVerts);
+		RenderChunk(ctx, x1, y1, z1);
+
+		if (MapRenderer_SortTranslucent) SortTranslucentParts(ctx);
+		UploadVertices(info, ctx->vertices, totalVerts);
+		return;
+	}
+
 	/* add an extra element to fix crashing on some GPUs */
-	Builder_Vertices = (struct VertexTextured*)Gfx_RecreateAndLockVb(&info->vb,
+	ctx->vertices = (struct VertexTextured*)Gfx_RecreateAndLockVb(&info->vb,
 													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
 #else
 	/* NOTE: Relies on assumption vb is ignored by GL11 Gfx_LockVb implementation */
-	Builder_Vertices = (struct VertexTextured*)Gfx_LockVb(0, 
+	ctx->vertices = (struct VertexTextured*)Gfx_LockVb(0, 
 													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
 #endif
-	Builder_PostPrepareChunk();
-	/* now render the chunk */
+	RenderChunk(ctx, x1, y1, z1);
 
-	for (y = y1, yy = 0; y < yMax; y++, yy++) {
-		for (z = z1, zz = 0; z < zMax; z++, zz++) {
-			cIndex = Builder_PackChunk(0, yy, zz);
+#ifdef CC_BUILD_GL11
+	BuildChunkVbs(ctx, info);
+#else
+	Gfx_UnlockVb(info->vb);
+#endif
+}
 
-			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
-				Builder_Block = chunk[cIndex];
-				if (Blocks.Draw[Builder_Block] == DRAW_GAS) continue;
+static struct BuilderContext mainCtx;
+void Builder_MakeChunk(struct ChunkInfo* info) {
+	Builder_MakeChunkWith(&mainCtx, info);
+}
 
-				index = Builder_PackCount(xx, yy, zz);
-				Builder_ChunkIndex = cIndex;
-				Builder_RenderBlock(index, x, y, z);
-			}
+
+/*########################################################################################################################*
+*-------------------------------------------------Multithreaded building--------------------------------------------------*
+*#########################################################################################################################*/
+/* Systems without preemptive multitasking gain nothing from building chunks on other threads */
+#if !defined CC_BUILD_COOPTHREADED && (!defined CC_BUILD_WEB || defined CC_BUILD_WEBTHREADS)
+#define BUILDER_MAX_THREADS 16
+
+struct BuilderJob {
+	struct ChunkInfo* info;
+	struct VertexTextured* vertices;
+	int totalVerts;
+};
+
+struct BuilderWorker {
+	void* thread;
+	void* wakeup;
+	struct BuilderContext* ctx;
+};
+
+static struct BuilderWorker workers[BUILDER_MAX_THREADS];
+static int workersCount, workersStarted, workersBusy;
+static volatile cc_bool workersQuit;
+static void* jobsMutex;
+static void* jobsDone;
+
+static struct BuilderJob* jobs;
+static int jobsCapacity, jobsCount, jobsNext;
+
+/* Builds the chunk mesh into a temporary buffer, which is later copied into a VB by the main thread */
+static void BuildJob(struct BuilderContext* ctx, struct BuilderJob* job) {
+	struct ChunkInfo* info = job->info;
+	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	int totalVerts;
+
+	Builder_SetActive(ctx);
+	ctx->PrePrepareChunk(ctx);
+	if (!ReadChunk(ctx, info)) return;
+
+	totalVerts = CountChunk(ctx, x1, y1, z1);
+	if (!totalVerts) return;
+	job->totalVerts = totalVerts;
+
+	ctx->vertices = (struct VertexTextured*)MemArena_TryAlloc(&ctx->arena, totalVerts + 1, sizeof(struct VertexTextured));
+	if (!ctx->vertices) return;
+
+	OutputChunkPartsMeta(ctx, x1, y1, z1, info);
+	RenderChunk(ctx, x1, y1, z1);
+#ifndef CC_BUILD_GL11
+	if (MapRenderer_SortTranslucent) SortTranslucentParts(ctx);
+#endif
+	job->vertices = ctx->vertices;
+}
+
+static void RunJobs(struct BuilderContext* ctx) {
+	int i;
+	for (;;)
+	{
+		Mutex_Lock(jobsMutex);
+		{
+			i = jobsNext < jobsCount ? jobsNext++ : -1;
 		}
+		Mutex_Unlock(jobsMutex);
+
+		if (i < 0) return;
+		BuildJob(ctx, &jobs[i]);
 	}
+}
 
-#ifdef CC_BUILD_GL11
-	cIndex = World_ChunkPack(x1 >> CHUNK_SHIFT, y1 >> CHUNK_SHIFT, z1 >> CHUNK_SHIFT);
+static void WorkerLoop(void) {
+	struct BuilderWorker* worker;
+	Mutex_Lock(jobsMutex);
+	{
+		worker = &workers[workersStarted++];
+	}
+	Mutex_Unlock(jobsMutex);
 
-	for (index = 0; index < MapRenderer_1DUsedCount; index++) {
-		int curIdx = cIndex + index * World.ChunksCount;
+	for (;;)
+	{
+		Waitable_Wait(worker->wakeup);
+		if (workersQuit) return;
+		RunJobs(worker->ctx);
 
-		BuildPartVbs(&MapRenderer_PartsNormal[curIdx]);
-		BuildPartVbs(&MapRenderer_PartsTranslucent[curIdx]);
+		Mutex_Lock(jobsMutex);
+		{
+			if (--workersBusy == 0) Waitable_Signal(jobsDone);
+		}
+		Mutex_Unlock(jobsMutex);
 	}
+}
+
+static void WaitForWorkers(void) {
+	int busy;
+	for (;;)
+	{
+		Mutex_Lock(jobsMutex);
+		{
+			busy = workersBusy;
+		}
+		Mutex_Unlock(jobsMutex);
+
+		if (!busy) return;
+		Waitable_Wait(jobsDone);
+	}
+}
+
+/* Copies the vertices built by a worker thread into the chunk's vertex buffer */
+static void FinishJob(struct BuilderJob* job) {
+	struct ChunkInfo* info = job->info;
+	if (!job->totalVerts) return;
+	
+	/* Not enough memory for temp buffer, so fallback to building directly into the VB */
+	if (!job->vertices) { Builder_MakeChunk(info); return; }
+
+#ifndef CC_BUILD_GL11
+	UploadVertices(info, job->vertices, job->totalVerts);
 #else
-	Gfx_UnlockVb(info->vb);
+	mainCtx.vertices = job->vertices;
+	BuildChunkVbs(&mainCtx, info);
+#endif
+}
+
+static cc_bool CanBuildInParallel(int count) {
+	/* Fancy lighting lazily calculates lighting when it is first accessed, */
+	/*  which is not safe to do from multiple threads at once */
+	return workersCount && count > 1 && Lighting.LightHint == ClassicLighting_LightHint;
+}
+
+void Builder_MakeChunks(struct ChunkInfo** chunks, int count) {
+	struct BuilderJob* job;
+	struct ChunkInfo* info;
+	int i;
+
+	if (!CanBuildInParallel(count)) {
+		for (i = 0; i < count; i++) Builder_MakeChunk(chunks[i]);
+		return;
+	}
+
+	if (count > jobsCapacity) {
+		jobs = (struct BuilderJob*)Mem_Realloc(jobs, count, sizeof(struct BuilderJob), "builder jobs");
+		jobsCapacity = count;
+	}
+
+	for (i = 0; i < count; i++) 
+	{
+		job  = &jobs[i];
+		info = chunks[i];
+		job->info       = info;
+		job->vertices   = NULL;
+		job->totalVerts = 0;
+
+		/* Lighting state must be calculated upfront on the main thread, */
+		/*  so that the worker threads only ever read from it */
+		Lighting.LightHint(info->centreX - 9, info->centreY - 9, info->centreZ - 9);
+	}
+
+	Mutex_Lock(jobsMutex);
+	{
+		jobsCount   = count;
+		jobsNext    = 0;
+		workersBusy = workersCount;
+	}
+	Mutex_Unlock(jobsMutex);
+
+	for (i = 0; i < workersCount; i++) 
+	{
+		Waitable_Signal(workers[i].wakeup);
+	}
+
+	/* Main thread also builds chunks while waiting */
+	RunJobs(&mainCtx);
+	WaitForWorkers();
+
+	for (i = 0; i < count; i++) 
+	{
+		FinishJob(&jobs[i]);
+	}
+
+	/* All the vertices have been copied into VBs now, so the temp buffers can be reused by the next batch */
+	for (i = 0; i < workersCount; i++) 
+	{
+		MemArena_Reset(&workers[i].ctx->arena);
+	}
+	MemArena_Reset(&mainCtx.arena);
+}
+
+static void Builder_StartWorkers(void) {
+	int i, count;
+#if defined CC_BUILD_CONSOLE || defined CC_BUILD_LOWMEM
+	count = Options_GetInt(OPT_BUILDER_THREADS, 0, BUILDER_MAX_THREADS, 0);
+#else
+	count = Options_GetInt(OPT_BUILDER_THREADS, 0, BUILDER_MAX_THREADS, 3);
 #endif
+#ifdef CC_BUILD_PAGEDWORLD
+	/* Reading a block may page out another brick, which isn't safe to do while other threads are reading blocks */
+	count = 0;
+#endif
+	if (!count) return;
+
+	jobsMutex = Mutex_Create("Builder jobs");
+	jobsDone  = Waitable_Create("Builder done");
+
+	for (i = 0; i < count; i++) 
+	{
+		workers[i].ctx = Builder_CreateContext();
+		if (!workers[i].ctx) break;
+		workers[i].wakeup = Waitable_Create("Builder wakeup");
+	}
+	workersCount = i;
+
+	for (i = 0; i < workersCount; i++) 
+	{
+		Thread_Run(&workers[i].thread, WorkerLoop, 128 * 1024, "Chunk builder");
+	}
 }
 
-static cc_bool Builder_OccludedLiquid(int chunkIndex) {
+static void Builder_StopWorkers(void) {
+	int i;
+	workersQuit = true;
+
+	for (i = 0; i < workersCount; i++) 
+	{
+		Waitable_Signal(workers[i].wakeup);
+		Thread_Join(workers[i].thread);
+
+		Waitable_Free(workers[i].wakeup);
+		Builder_FreeContext(workers[i].ctx);
+	}
+	if (!jobsMutex) return;
+
+	Mutex_Free(jobsMutex);
+	Waitable_Free(jobsDone);
+	Mem_Free(jobs);
+
+	jobs = NULL;
+	workersCount = 0;
+	jobsMutex    = NULL;
+	jobsCapacity = 0;
+}
+#else
+void Builder_MakeChunks(struct ChunkInfo** chunks, int count) {
+	int i;
+	for (i = 0; i < count; i++) Builder_MakeChunk(chunks[i]);
+}
+
+static void Builder_StartWorkers(void) { }
+static void Builder_StopWorkers(void)  { }
+#endif
+
+static cc_bool Builder_OccludedLiquid(struct BuilderContext* ctx, int chunkIndex) {
 	chunkIndex += EXTCHUNK_SIZE_2; /* Checking y above */
 	return
-		Blocks.FullOpaque[Builder_Chunk[chunkIndex]]
-		&& Blocks.Draw[Builder_Chunk[chunkIndex - EXTCHUNK_SIZE]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex - 1]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex + 1]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex + EXTCHUNK_SIZE]] != DRAW_GAS;
+		Blocks.FullOpaque[ctx->chunk[chunkIndex]]
+		&& Blocks.Draw[ctx->chunk[chunkIndex - EXTCHUNK_SIZE]] != DRAW_GAS
+		&& Blocks.Draw[ctx->chunk[chunkIndex - 1]] != DRAW_GAS
+		&& Blocks.Draw[ctx->chunk[chunkIndex + 1]] != DRAW_GAS
+		&& Blocks.Draw[ctx->chunk[chunkIndex + EXTCHUNK_SIZE]] != DRAW_GAS;
 }
 
-static void DefaultPrePrepateChunk(void) {
-	Mem_Set(Builder_Parts, 0, sizeof(Builder_Parts));
+static void DefaultPrePrepateChunk(struct BuilderContext* ctx) {
+	Mem_Set(ctx->parts, 0, sizeof(ctx->parts));
 }
 
-static void DefaultPostStretchChunk(void) {
+static void DefaultPostStretchChunk(struct BuilderContext* ctx) {
 	int i, j, offset;
 	offset = 0;
 	for (i = 0; i < ATLAS1D_MAX_ATLASES; i++) {
 		j = i + ATLAS1D_MAX_ATLASES;
 
-		offset = Builder1DPart_CalcOffsets(&Builder_Parts[i], offset);
-		offset = Builder1DPart_CalcOffsets(&Builder_Parts[j], offset);
+		offset = Builder1DPart_CalcOffsets(ctx, &ctx->parts[i], offset);
+		offset = Builder1DPart_CalcOffsets(ctx, &ctx->parts[j], offset);
 	}
 }
 
-static RNGState spriteRng;
-static void Builder_DrawSprite(int x, int y, int z) {
+static void Builder_DrawSprite(struct BuilderContext* ctx, int x, int y, int z) {
 	struct Builder1DPart* part;
 	struct VertexTextured* v;
 	cc_uint8 offsetType;
@@ -501,29 +1076,29 @@ static void Builder_DrawSprite(int x, int y, int z) {
 
 #define s_u1 0.0f
 #define s_u2 UV2_Scale
-	loc = Block_Tex(Builder_Block, FACE_XMAX);
+	loc = Block_Tex(ctx->block, FACE_XMAX);
 	v1  = Atlas1D_RowId(loc) * Atlas1D.InvTileSize;
 	v2  = v1 + Atlas1D.InvTileSize * UV2_Scale;
 
-	offsetType = Blocks.SpriteOffset[Builder_Block];
+	offsetType = Blocks.SpriteOffset[ctx->block];
 	if (offsetType >= 6 && offsetType <= 7) {
-		Random_Seed(&spriteRng, (x + 1217 * z) & 0x7fffffff);
-		valX = Random_Range(&spriteRng, -3, 3 + 1) / 16.0f;
-		valY = Random_Range(&spriteRng, 0,  3 + 1) / 16.0f;
-		valZ = Random_Range(&spriteRng, -3, 3 + 1) / 16.0f;
+		Random_Seed(&ctx->spriteRng, (x + 1217 * z) & 0x7fffffff);
+		valX = Random_Range(&ctx->spriteRng, -3, 3 + 1) / 16.0f;
+		valY = Random_Range(&ctx->spriteRng, 0,  3 + 1) / 16.0f;
+		valZ = Random_Range(&ctx->spriteRng, -3, 3 + 1) / 16.0f;
 
 		x1 += valX - 1.7f/16.0f; x2 += valX + 1.7f/16.0f;
 		z1 += valZ - 1.7f/16.0f; z2 += valZ + 1.7f/16.0f;
 		if (offsetType == 7) { y1 -= valY; y2 -= valY; }
 	}
 	
-	bright = Blocks.Brightness[Builder_Block];
-	part   = &Builder_Parts[Atlas1D_Index(loc)];
-	color  = bright ? PACKEDCOL_WHITE : Lighting.Color_Sprite_Fast(x, y, z);
-	Block_Tint(color, Builder_Block);
+	bright = Blocks.Brightness[ctx->block];
+	part   = &ctx->parts[Atlas1D_Index(loc)];
+	color  = bright ? PACKEDCOL_WHITE : Builder_LightCol(ctx, Color_Sprite_Fast, Env.SunCol, Env.ShadowCol, x, y, z);
+	Block_Tint(color, ctx->block);
 
 	/* Draw Z axis */
-	v = &Builder_Vertices[part->sOffset];
+	v = &ctx->vertices[part->sOffset];
 	v->x = x1; v->y = y1; v->z = z1; v->Col = color; v->U = s_u2; v->V = v2; v++;
 	v->x = x1; v->y = y2; v->z = z1; v->Col = color; v->U = s_u2; v->V = v1; v++;
 	v->x = x2; v->y = y2; v->z = z2; v->Col = color; v->U = s_u1; v->V = v1; v++;
@@ -557,93 +1132,168 @@ static void Builder_DrawSprite(int x, int y, int z) {
 /*########################################################################################################################*
 *--------------------------------------------------Normal mesh builder----------------------------------------------------*
 *#########################################################################################################################*/
-static PackedCol Normal_LightColor(int x, int y, int z, Face face, BlockID block) {
+static PackedCol Normal_LightColor(struct BuilderContext* ctx, int x, int y, int z, Face face, BlockID block) {
 	int offset = (Blocks.LightOffset[block] >> face) & 1;
 
 	switch (face) {
 	case FACE_XMIN:
-		return x < offset                ? Env.SunXSide : Lighting.Color_XSide_Fast(x - offset, y, z);
+		return x < offset                ? Env.SunXSide : Builder_LightCol(ctx, Color_XSide_Fast, Env.SunXSide, Env.ShadowXSide, x - offset, y, z);
 	case FACE_XMAX:
-		return x > (World.MaxX - offset) ? Env.SunXSide : Lighting.Color_XSide_Fast(x + offset, y, z);
+		return x > (World.MaxX - offset) ? Env.SunXSide : Builder_LightCol(ctx, Color_XSide_Fast, Env.SunXSide, Env.ShadowXSide, x + offset, y, z);
 	case FACE_ZMIN:
-		return z < offset                ? Env.SunZSide : Lighting.Color_ZSide_Fast(x, y, z - offset);
+		return z < offset                ? Env.SunZSide : Builder_LightCol(ctx, Color_ZSide_Fast, Env.SunZSide, Env.ShadowZSide, x, y, z - offset);
 	case FACE_ZMAX:
-		return z > (World.MaxZ - offset) ? Env.SunZSide : Lighting.Color_ZSide_Fast(x, y, z + offset);
+		return z > (World.MaxZ - offset) ? Env.SunZSide : Builder_LightCol(ctx, Color_ZSide_Fast, Env.SunZSide, Env.ShadowZSide, x, y, z + offset);
 
 	case FACE_YMIN:
-		return Lighting.Color_YMin_Fast(x, y - offset, z);		
+		return Builder_LightCol(ctx, Color_YMin_Fast, Env.SunYMin, Env.ShadowYMin, x, y - offset, z);		
 	case FACE_YMAX:
-		return Lighting.Color_YMax_Fast(x, y + offset, z);
+		return Builder_LightCol(ctx, Color_YMax_Fast, Env.SunCol, Env.ShadowCol, x, y + offset, z);
 	}
 	return 0; /* should never happen */
 }
 
-static cc_bool Normal_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
-	BlockID cur = Builder_Chunk[chunkIndex];
+static cc_bool Normal_CanStretch(struct BuilderContext* ctx, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = ctx->chunk[chunkIndex];
+
+	if (cur != initial || Block_IsFaceHidden(cur, ctx->chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
+	if (ctx->fullBright) return true;
+
+	return Normal_LightColor(ctx, ctx->x, ctx->y, ctx->z, face, initial) == Normal_LightColor(ctx, x, y, z, face, cur);
+}
+
+/* Whether rows of the given face can be merged together into a single quad */
+/* The 1D atlases can only repeat tiles horizontally, so the tile must also look the same when stretched vertically */
+static cc_bool Normal_CanGreedyMesh(BlockID block, Face face) {
+	if (!(Blocks.CanStretch[block] & (1 << face))) return false;
+	if (block >= BLOCK_WATER && block <= BLOCK_STILL_LAVA) return false;
+	if (!Atlas2D.UniformRows[Block_Tex(block, face)]) return false;
+
+	return Vec3_IsZero(Blocks.RenderMinBB[block]) && Blocks.RenderMaxBB[block].x == 1.0f
+		&& Blocks.RenderMaxBB[block].y == 1.0f    && Blocks.RenderMaxBB[block].z == 1.0f;
+}
 
-	if (cur != initial || Block_IsFaceHidden(cur, Builder_Chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
-	if (Builder_FullBright) return true;
+/* Merges the following rows of faces into the given row of faces, for as long as the rows are identical */
+/* Rows are stacked along the Z axis for Y faces, and along the Y axis for all other faces */
+static void Normal_StretchRows(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face, int count) {
+	int rowCountStep, rowChunkStep, colCountStep, colChunkStep;
+	int dx = 0, dz = 0, dy, dz2;
+	int i, rows = 1, cIndex, index;
+
+	ctx->heights[countIndex] = 1;
+	if (!Normal_CanGreedyMesh(block, face)) return;
+
+	/* X faces are stretched along Z axis, all other faces along X axis */
+	if (face <= FACE_XMAX) {
+		rowCountStep = CHUNK_SIZE * FACE_COUNT; rowChunkStep = EXTCHUNK_SIZE; dz = 1;
+	} else {
+		rowCountStep = FACE_COUNT;              rowChunkStep = 1;             dx = 1;
+	}
 
-	return Normal_LightColor(Builder_X, Builder_Y, Builder_Z, face, initial) == Normal_LightColor(x, y, z, face, cur);
+	if (face >= FACE_YMIN) {
+		colCountStep = CHUNK_SIZE   * FACE_COUNT; colChunkStep = EXTCHUNK_SIZE;   dy = 0; dz2 = 1;
+	} else {
+		colCountStep = CHUNK_SIZE_2 * FACE_COUNT; colChunkStep = EXTCHUNK_SIZE_2; dy = 1; dz2 = 0;
+	}
+
+	for (;;) {
+		y += dy; z += dz2;
+		if (y >= ctx->chunkEndY || z >= ctx->chunkEndZ) break;
+
+		cIndex = chunkIndex + rows * colChunkStep;
+		index  = countIndex + rows * colCountStep;
+
+		for (i = 0; i < count; i++) {
+			if (!ctx->counts[index + i * rowCountStep]) break;
+			if (!Normal_CanStretch(ctx, block, cIndex + i * rowChunkStep, x + i * dx, y, z + i * dz, face)) break;
+		}
+		if (i < count) break;
+
+		for (i = 0; i < count; i++) {
+			ctx->counts[index + i * rowCountStep] = 0;
+		}
+		rows++;
+	}
+	ctx->heights[countIndex] = rows;
 }
 
-static int NormalBuilder_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int NormalBuilder_StretchXLiquid(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1; cc_bool stretchTile;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
+	ctx->heights[countIndex] = 1;
 	
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(chunkIndex)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(ctx, chunkIndex)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, FACE_YMAX);
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int NormalBuilder_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int NormalBuilder_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	/* NOTE: Faces can already have been merged into previous rows by greedy meshing */
+	while (x < ctx->chunkEndX && stretchTile && ctx->counts[countIndex] && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, face);
+
+	if (Builder_GreedyMeshing) {
+		x -= count; chunkIndex -= count; countIndex -= count * FACE_COUNT;
+		Normal_StretchRows(ctx, countIndex, x, y, z, chunkIndex, block, face, count);
+	}
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int NormalBuilder_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int NormalBuilder_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
 	z++;
 	chunkIndex += EXTCHUNK_SIZE;
 	countIndex += CHUNK_SIZE * FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (z < Builder_ChunkEndZ && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	/* NOTE: Faces can already have been merged into previous rows by greedy meshing */
+	while (z < ctx->chunkEndZ && stretchTile && ctx->counts[countIndex] && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		z++;
 		chunkIndex += EXTCHUNK_SIZE;
 		countIndex += CHUNK_SIZE * FACE_COUNT;
 	}
-	AddVertices(block, face);
+
+	if (Builder_GreedyMeshing) {
+		z -= count; chunkIndex -= count * EXTCHUNK_SIZE; countIndex -= count * CHUNK_SIZE * FACE_COUNT;
+		Normal_StretchRows(ctx, countIndex, x, y, z, chunkIndex, block, face, count);
+	}
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static void NormalBuilder_RenderBlock(int index, int x, int y, int z) {	
+/* Extends the cuboid being drawn to also cover any rows of faces merged into the given face */
+static void Normal_ExtendRows(struct BuilderContext* ctx, int index, Face face, int y, int z, Vec3 max) {
+	int rows = ctx->heights[index + face] - 1;
+	ctx->drawer.Y2 = y + max.y + (face <  FACE_YMIN ? rows : 0);
+	ctx->drawer.Z2 = z + max.z + (face >= FACE_YMIN ? rows : 0);
+}
+
+static void NormalBuilder_RenderBlock(struct BuilderContext* ctx, int index, int x, int y, int z) {
 	/* counters */
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
@@ -659,109 +1309,116 @@ static void NormalBuilder_RenderBlock(int index, int x, int y, int z) {
 	PackedCol col;
 	int offset;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[ctx->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(ctx, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->counts[index + FACE_XMIN];
+	count_XMax = ctx->counts[index + FACE_XMAX];
+	count_ZMin = ctx->counts[index + FACE_ZMIN];
+	count_ZMax = ctx->counts[index + FACE_ZMAX];
+	count_YMin = ctx->counts[index + FACE_YMIN];
+	count_YMax = ctx->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	fullBright = Blocks.Brightness[Builder_Block];
-	baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	lightFlags = Blocks.LightOffset[Builder_Block];
+	fullBright = Blocks.Brightness[ctx->block];
+	baseOffset = (Blocks.Draw[ctx->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	lightFlags = Blocks.LightOffset[ctx->block];
 
-	Drawer.MinBB = Blocks.MinBB[Builder_Block]; Drawer.MinBB.y = 1.0f - Drawer.MinBB.y;
-	Drawer.MaxBB = Blocks.MaxBB[Builder_Block]; Drawer.MaxBB.y = 1.0f - Drawer.MaxBB.y;
+	ctx->drawer.MinBB = Blocks.MinBB[ctx->block]; ctx->drawer.MinBB.y = 1.0f - ctx->drawer.MinBB.y;
+	ctx->drawer.MaxBB = Blocks.MaxBB[ctx->block]; ctx->drawer.MaxBB.y = 1.0f - ctx->drawer.MaxBB.y;
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	Drawer.X1 = x + min.x; Drawer.Y1 = y + min.y; Drawer.Z1 = z + min.z;
-	Drawer.X2 = x + max.x; Drawer.Y2 = y + max.y; Drawer.Z2 = z + max.z;
+	min = Blocks.RenderMinBB[ctx->block]; max = Blocks.RenderMaxBB[ctx->block];
+	ctx->drawer.X1 = x + min.x; ctx->drawer.Y1 = y + min.y; ctx->drawer.Z1 = z + min.z;
+	ctx->drawer.X2 = x + max.x; ctx->drawer.Y2 = y + max.y; ctx->drawer.Z2 = z + max.z;
 
-	Drawer.Tinted  = Blocks.Tinted[Builder_Block];
-	Drawer.TintCol = Blocks.FogCol[Builder_Block];
+	ctx->drawer.Tinted  = Blocks.Tinted[ctx->block];
+	ctx->drawer.TintCol = Blocks.FogCol[ctx->block];
 
 	if (count_XMin) {
-		loc    = Block_Tex(Builder_Block, FACE_XMIN);
+		loc    = Block_Tex(ctx->block, FACE_XMIN);
 		offset = (lightFlags >> FACE_XMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
-			x >= offset ? Lighting.Color_XSide_Fast(x - offset, y, z) : Env.SunXSide;
-		Drawer_XMin(count_XMin, col, loc, &part->faces.vertices[FACE_XMIN]);
+			x >= offset ? Builder_LightCol(ctx, Color_XSide_Fast, Env.SunXSide, Env.ShadowXSide, x - offset, y, z) : Env.SunXSide;
+		if (Builder_GreedyMeshing) Normal_ExtendRows(ctx, index, FACE_XMIN, y, z, max);
+		DrawerState_XMin(&ctx->drawer, count_XMin, col, loc, &part->faces.vertices[FACE_XMIN]);
 	}
 
 	if (count_XMax) {
-		loc    = Block_Tex(Builder_Block, FACE_XMAX);
+		loc    = Block_Tex(ctx->block, FACE_XMAX);
 		offset = (lightFlags >> FACE_XMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
-			x <= (World.MaxX - offset) ? Lighting.Color_XSide_Fast(x + offset, y, z) : Env.SunXSide;
-		Drawer_XMax(count_XMax, col, loc, &part->faces.vertices[FACE_XMAX]);
+			x <= (World.MaxX - offset) ? Builder_LightCol(ctx, Color_XSide_Fast, Env.SunXSide, Env.ShadowXSide, x + offset, y, z) : Env.SunXSide;
+		if (Builder_GreedyMeshing) Normal_ExtendRows(ctx, index, FACE_XMAX, y, z, max);
+		DrawerState_XMax(&ctx->drawer, count_XMax, col, loc, &part->faces.vertices[FACE_XMAX]);
 	}
 
 	if (count_ZMin) {
-		loc    = Block_Tex(Builder_Block, FACE_ZMIN);
+		loc    = Block_Tex(ctx->block, FACE_ZMIN);
 		offset = (lightFlags >> FACE_ZMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
-			z >= offset ? Lighting.Color_ZSide_Fast(x, y, z - offset) : Env.SunZSide;
-		Drawer_ZMin(count_ZMin, col, loc, &part->faces.vertices[FACE_ZMIN]);
+			z >= offset ? Builder_LightCol(ctx, Color_ZSide_Fast, Env.SunZSide, Env.ShadowZSide, x, y, z - offset) : Env.SunZSide;
+		if (Builder_GreedyMeshing) Normal_ExtendRows(ctx, index, FACE_ZMIN, y, z, max);
+		DrawerState_ZMin(&ctx->drawer, count_ZMin, col, loc, &part->faces.vertices[FACE_ZMIN]);
 	}
 
 	if (count_ZMax) {
-		loc    = Block_Tex(Builder_Block, FACE_ZMAX);
+		loc    = Block_Tex(ctx->block, FACE_ZMAX);
 		offset = (lightFlags >> FACE_ZMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
-			z <= (World.MaxZ - offset) ? Lighting.Color_ZSide_Fast(x, y, z + offset) : Env.SunZSide;
-		Drawer_ZMax(count_ZMax, col, loc, &part->faces.vertices[FACE_ZMAX]);
+			z <= (World.MaxZ - offset) ? Builder_LightCol(ctx, Color_ZSide_Fast, Env.SunZSide, Env.ShadowZSide, x, y, z + offset) : Env.SunZSide;
+		if (Builder_GreedyMeshing) Normal_ExtendRows(ctx, index, FACE_ZMAX, y, z, max);
+		DrawerState_ZMax(&ctx->drawer, count_ZMax, col, loc, &part->faces.vertices[FACE_ZMAX]);
 	}
 
 	if (count_YMin) {
-		loc    = Block_Tex(Builder_Block, FACE_YMIN);
+		loc    = Block_Tex(ctx->block, FACE_YMIN);
 		offset = (lightFlags >> FACE_YMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
-		col = fullBright ? PACKEDCOL_WHITE : Lighting.Color_YMin_Fast(x, y - offset, z);
-		Drawer_YMin(count_YMin, col, loc, &part->faces.vertices[FACE_YMIN]);
+		col = fullBright ? PACKEDCOL_WHITE : Builder_LightCol(ctx, Color_YMin_Fast, Env.SunYMin, Env.ShadowYMin, x, y - offset, z);
+		if (Builder_GreedyMeshing) Normal_ExtendRows(ctx, index, FACE_YMIN, y, z, max);
+		DrawerState_YMin(&ctx->drawer, count_YMin, col, loc, &part->faces.vertices[FACE_YMIN]);
 	}
 
 	if (count_YMax) {
-		loc    = Block_Tex(Builder_Block, FACE_YMAX);
+		loc    = Block_Tex(ctx->block, FACE_YMAX);
 		offset = (lightFlags >> FACE_YMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
-		col = fullBright ? PACKEDCOL_WHITE : Lighting.Color_YMax_Fast(x, y + offset, z);
-		Drawer_YMax(count_YMax, col, loc, &part->faces.vertices[FACE_YMAX]);
+		col = fullBright ? PACKEDCOL_WHITE : Builder_LightCol(ctx, Color_YMax_Fast, Env.SunCol, Env.ShadowCol, x, y + offset, z);
+		if (Builder_GreedyMeshing) Normal_ExtendRows(ctx, index, FACE_YMAX, y, z, max);
+		DrawerState_YMax(&ctx->drawer, count_YMax, col, loc, &part->faces.vertices[FACE_YMAX]);
 	}
 }
 
-static void Builder_SetDefault(void) {
-	Builder_StretchXLiquid = NULL;
-	Builder_StretchX       = NULL;
-	Builder_StretchZ       = NULL;
-	Builder_RenderBlock    = NULL;
+static void Builder_SetDefault(struct BuilderContext* ctx) {
+	ctx->StretchXLiquid = NULL;
+	ctx->StretchX       = NULL;
+	ctx->StretchZ       = NULL;
+	ctx->RenderBlock    = NULL;
 
-	Builder_PrePrepareChunk  = DefaultPrePrepateChunk;
-	Builder_PostPrepareChunk = DefaultPostStretchChunk;
+	ctx->PrePrepareChunk  = DefaultPrePrepateChunk;
+	ctx->PostPrepareChunk = DefaultPostStretchChunk;
+	ctx->classicLighting  = Lighting.IsLit_Fast == ClassicLighting_IsLit_Fast;
 }
 
-static void NormalBuilder_SetActive(void) {
-	Builder_SetDefault();
-	Builder_StretchXLiquid = NormalBuilder_StretchXLiquid;
-	Builder_StretchX       = NormalBuilder_StretchX;
-	Builder_StretchZ       = NormalBuilder_StretchZ;
-	Builder_RenderBlock    = NormalBuilder_RenderBlock;
+static void NormalBuilder_SetActive(struct BuilderContext* ctx) {
+	Builder_SetDefault(ctx);
+	ctx->StretchXLiquid = NormalBuilder_StretchXLiquid;
+	ctx->StretchX       = NormalBuilder_StretchX;
+	ctx->StretchZ       = NormalBuilder_StretchZ;
+	ctx->RenderBlock    = NormalBuilder_RenderBlock;
 }
 
 
@@ -769,12 +1426,6 @@ static void NormalBuilder_SetActive(void) {
 *-------------------------------------------------Advanced mesh builder---------------------------------------------------*
 *#########################################################################################################################*/
 #ifdef CC_BUILD_ADVLIGHTING
-static Vec3 adv_minBB, adv_maxBB;
-static int adv_initBitFlags, adv_baseOffset;
-static int* adv_bitFlags;
-static float adv_x1, adv_y1, adv_z1, adv_x2, adv_y2, adv_z2;
-static PackedCol adv_lerp[5], adv_lerpX[5], adv_lerpZ[5], adv_lerpY[5];
-static cc_bool adv_tinted;
 
 enum ADV_MASK {
 	/* z-1 cube points */
@@ -799,7 +1450,7 @@ enum ADV_MASK {
 /* - bit 0 set: Y-1 is in light */
 /* - bit 1 set: Y   is in light */
 /* - bit 2 set: Y+1 is in light */
-static int Adv_Lit(int x, int y, int z, int cIndex) {
+static int Adv_Lit(struct BuilderContext* ctx, int x, int y, int z, int cIndex) {
 	int flags, offset, lightFlags;
 	BlockID block;
 	if (y < 0 || y >= World.Height) return LIT_M1 | LIT_CC | LIT_P1; /* all faces lit */
@@ -810,7 +1461,7 @@ static int Adv_Lit(int x, int y, int z, int cIndex) {
 	}
 
 	flags = 0;
-	block = Builder_Chunk[cIndex];
+	block = ctx->chunk[cIndex];
 	lightFlags = Blocks.LightOffset[block];
 
 	/* TODO using LIGHT_FLAG_SHADES_FROM_BELOW is wrong here, */
@@ -818,36 +1469,36 @@ static int Adv_Lit(int x, int y, int z, int cIndex) {
 
 	/* Use fact Light(Y.YMin) == Light((Y-1).YMax) */
 	offset = (lightFlags >> LIGHT_FLAG_SHADES_FROM_BELOW) & 1;
-	flags |= Lighting.IsLit_Fast(x, y - offset, z) ? LIT_M1 : 0;
+	flags |= Builder_IsLit(ctx, x, y - offset, z) ? LIT_M1 : 0;
 
 	/* Light is same for all the horizontal faces */
-	flags |= Lighting.IsLit_Fast(x, y, z) ? LIT_CC : 0;
+	flags |= Builder_IsLit(ctx, x, y, z) ? LIT_CC : 0;
 
 	/* Use fact Light((Y+1).YMin) == Light(Y.YMax) */
 	offset = (lightFlags >> LIGHT_FLAG_SHADES_FROM_BELOW) & 1;
-	flags |= Lighting.IsLit_Fast(x, (y + 1) - offset, z) ? LIT_P1 : 0;
+	flags |= Builder_IsLit(ctx, x, (y + 1) - offset, z) ? LIT_P1 : 0;
 
 	/* If a block is fullbright, it should also look as if that spot is lit */
-	if (Blocks.Brightness[Builder_Chunk[cIndex - 324]]) flags |= LIT_M1;
+	if (Blocks.Brightness[ctx->chunk[cIndex - 324]]) flags |= LIT_M1;
 	if (Blocks.Brightness[block])                       flags |= LIT_CC;
-	if (Blocks.Brightness[Builder_Chunk[cIndex + 324]]) flags |= LIT_P1;
+	if (Blocks.Brightness[ctx->chunk[cIndex + 324]]) flags |= LIT_P1;
 	
 	return flags;
 }
 
-static int Adv_ComputeLightFlags(int x, int y, int z, int cIndex) {
-	if (Builder_FullBright) return (1 << xP1_yP1_zP1) - 1; /* all faces fully bright */
+static int Adv_ComputeLightFlags(struct BuilderContext* ctx, int x, int y, int z, int cIndex) {
+	if (ctx->fullBright) return (1 << xP1_yP1_zP1) - 1; /* all faces fully bright */
 
 	return
-		Adv_Lit(x - 1, y, z - 1, cIndex - 1 - 18) << xM1_yM1_zM1 |
-		Adv_Lit(x - 1, y, z,     cIndex - 1)      << xM1_yM1_zCC |
-		Adv_Lit(x - 1, y, z + 1, cIndex - 1 + 18) << xM1_yM1_zP1 |
-		Adv_Lit(x,     y, z - 1, cIndex + 0 - 18) << xCC_yM1_zM1 |
-		Adv_Lit(x,     y, z,     cIndex + 0)      << xCC_yM1_zCC |
-		Adv_Lit(x,     y, z + 1, cIndex + 0 + 18) << xCC_yM1_zP1 |
-		Adv_Lit(x + 1, y, z - 1, cIndex + 1 - 18) << xP1_yM1_zM1 |
-		Adv_Lit(x + 1, y, z,     cIndex + 1)      << xP1_yM1_zCC |
-		Adv_Lit(x + 1, y, z + 1, cIndex + 1 + 18) << xP1_yM1_zP1;
+		Adv_Lit(ctx, x - 1, y, z - 1, cIndex - 1 - 18) << xM1_yM1_zM1 |
+		Adv_Lit(ctx, x - 1, y, z,     cIndex - 1)      << xM1_yM1_zCC |
+		Adv_Lit(ctx, x - 1, y, z + 1, cIndex - 1 + 18) << xM1_yM1_zP1 |
+		Adv_Lit(ctx, x,     y, z - 1, cIndex + 0 - 18) << xCC_yM1_zM1 |
+		Adv_Lit(ctx, x,     y, z,     cIndex + 0)      << xCC_yM1_zCC |
+		Adv_Lit(ctx, x,     y, z + 1, cIndex + 0 + 18) << xCC_yM1_zP1 |
+		Adv_Lit(ctx, x + 1, y, z - 1, cIndex + 1 - 18) << xP1_yM1_zM1 |
+		Adv_Lit(ctx, x + 1, y, z,     cIndex + 1)      << xP1_yM1_zCC |
+		Adv_Lit(ctx, x + 1, y, z + 1, cIndex + 1 + 18) << xP1_yM1_zP1;
 }
 
 static int adv_masks[FACE_COUNT] = {
@@ -878,397 +1529,396 @@ static int adv_masks[FACE_COUNT] = {
 };
 
 
-static cc_bool Adv_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
-	BlockID cur = Builder_Chunk[chunkIndex];
-	adv_bitFlags[chunkIndex] = Adv_ComputeLightFlags(x, y, z, chunkIndex);
+static cc_bool Adv_CanStretch(struct BuilderContext* ctx, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = ctx->chunk[chunkIndex];
+	ctx->bitFlags[chunkIndex] = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
 
 	return cur == initial
-		&& !Block_IsFaceHidden(cur, Builder_Chunk[chunkIndex + Builder_Offsets[face]], face)
-		&& (adv_initBitFlags == adv_bitFlags[chunkIndex]
+		&& !Block_IsFaceHidden(cur, ctx->chunk[chunkIndex + Builder_Offsets[face]], face)
+		&& (ctx->initBitFlags == ctx->bitFlags[chunkIndex]
 		/* Check that this face is either fully bright or fully in shadow */
-		&& (adv_initBitFlags == 0 || (adv_initBitFlags & adv_masks[face]) == adv_masks[face]));
+		&& (ctx->initBitFlags == 0 || (ctx->initBitFlags & adv_masks[face]) == adv_masks[face]));
 }
 
-static int Adv_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int Adv_StretchXLiquid(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1; cc_bool stretchTile;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
+	ctx->initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->bitFlags[chunkIndex] = ctx->initBitFlags;
 
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(chunkIndex)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(ctx, chunkIndex)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, FACE_YMAX);
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int Adv_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Adv_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	ctx->initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->bitFlags[chunkIndex] = ctx->initBitFlags;
 	
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int Adv_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Adv_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	ctx->initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->bitFlags[chunkIndex] = ctx->initBitFlags;
 
 	z++;
 	chunkIndex += EXTCHUNK_SIZE;
 	countIndex += CHUNK_SIZE * FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (z < Builder_ChunkEndZ && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (z < ctx->chunkEndZ && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		z++;
 		chunkIndex += EXTCHUNK_SIZE;
 		countIndex += CHUNK_SIZE * FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
 
 #define Adv_CountBits(F, a, b, c, d) (((F >> a) & 1) + ((F >> b) & 1) + ((F >> c) & 1) + ((F >> d) & 1))
 
-static void Adv_DrawXMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMIN);
+static void Adv_DrawXMin(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.z, u2 = (count - 1) + adv_maxBB.z * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.z, u2 = (count - 1) + ctx->maxBB.z * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aY0_Z0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yCC_zM1, xM1_yM1_zCC, xM1_yCC_zCC);
 	int aY0_Z1 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yCC_zP1, xM1_yM1_zCC, xM1_yCC_zCC);
 	int aY1_Z0 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yCC_zM1, xM1_yP1_zCC, xM1_yCC_zCC);
 	int aY1_Z1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yCC_zP1, xM1_yP1_zCC, xM1_yCC_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpX[aY0_Z0], col1_0 = Builder_FullBright ? white : adv_lerpX[aY1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpX[aY1_Z1], col0_1 = Builder_FullBright ? white : adv_lerpX[aY0_Z1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerpX[aY0_Z0], col1_0 = ctx->fullBright ? white : ctx->lerpX[aY1_Z0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerpX[aY1_Z1], col0_1 = ctx->fullBright ? white : ctx->lerpX[aY0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_XMIN];
-	v.x = adv_x1;
+	v.x = ctx->x1;
 	if (aY0_Z0 + aY1_Z1 > aY0_Z1 + aY1_Z0) {
-		v.y = adv_y2; v.z = adv_z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
-		v.y = adv_y2;                                       v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.y = ctx->y2; v.z = ctx->z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.z = ctx->z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+		v.y = ctx->y2;                                       v.V = v1; v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.y = adv_y2; v.z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+		v.y = ctx->y2; v.z = ctx->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.z = ctx->z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_XMIN] = vertices;
 }
 
-static void Adv_DrawXMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMAX);
+static void Adv_DrawXMax(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.z), u2 = (1 - adv_maxBB.z) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->minBB.z), u2 = (1 - ctx->maxBB.z) * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aY0_Z0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yCC_zM1, xP1_yM1_zCC, xP1_yCC_zCC);
 	int aY0_Z1 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yCC_zP1, xP1_yM1_zCC, xP1_yCC_zCC);
 	int aY1_Z0 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yCC_zM1, xP1_yP1_zCC, xP1_yCC_zCC);
 	int aY1_Z1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yCC_zP1, xP1_yP1_zCC, xP1_yCC_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpX[aY0_Z0], col1_0 = Builder_FullBright ? white : adv_lerpX[aY1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpX[aY1_Z1], col0_1 = Builder_FullBright ? white : adv_lerpX[aY0_Z1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerpX[aY0_Z0], col1_0 = ctx->fullBright ? white : ctx->lerpX[aY1_Z0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerpX[aY1_Z1], col0_1 = ctx->fullBright ? white : ctx->lerpX[aY0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_XMAX];
-	v.x = adv_x2;
+	v.x = ctx->x2;
 	if (aY0_Z0 + aY1_Z1 > aY0_Z1 + aY1_Z0) {
-		v.y = adv_y2; v.z = adv_z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		              v.z = adv_z2 + (count - 1); v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.y = ctx->y2; v.z = ctx->z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		              v.z = ctx->z2 + (count - 1); v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
 	} else {
-		v.y = adv_y2; v.z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		v.y = adv_y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.y = ctx->y2; v.z = ctx->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.y = ctx->y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_XMAX] = vertices;
 }
 
-static void Adv_DrawZMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMIN);
+static void Adv_DrawZMin(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.x), u2 = (1 - adv_maxBB.x) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->minBB.x), u2 = (1 - ctx->maxBB.x) * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Y0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yCC_zM1, xCC_yM1_zM1, xCC_yCC_zM1);
 	int aX0_Y1 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yCC_zM1, xCC_yP1_zM1, xCC_yCC_zM1);
 	int aX1_Y0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yCC_zM1, xCC_yM1_zM1, xCC_yCC_zM1);
 	int aX1_Y1 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yCC_zM1, xCC_yP1_zM1, xCC_yCC_zM1);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpZ[aX0_Y0], col1_0 = Builder_FullBright ? white : adv_lerpZ[aX1_Y0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpZ[aX1_Y1], col0_1 = Builder_FullBright ? white : adv_lerpZ[aX0_Y1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerpZ[aX0_Y0], col1_0 = ctx->fullBright ? white : ctx->lerpZ[aX1_Y0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerpZ[aX1_Y1], col0_1 = ctx->fullBright ? white : ctx->lerpZ[aX0_Y1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_ZMIN];
-	v.z = adv_z1;
+	v.z = ctx->z1;
 	if (aX1_Y1 + aX0_Y0 > aX0_Y1 + aX1_Y0) {
-		v.x = adv_x2 + (count - 1); v.y = adv_y1; v.U = u2; v.V = v2; v.Col = col1_0; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		                            v.y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1); v.y = ctx->y1; v.U = u2; v.V = v2; v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		                            v.y = ctx->y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.x = adv_x1;               v.y = adv_y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
-		                            v.y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x1;               v.y = ctx->y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
+		                            v.y = ctx->y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_ZMIN] = vertices;
 }
 
-static void Adv_DrawZMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMAX);
+static void Adv_DrawZMax(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Y0 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yCC_zP1, xCC_yM1_zP1, xCC_yCC_zP1);
 	int aX1_Y0 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yCC_zP1, xCC_yM1_zP1, xCC_yCC_zP1);
 	int aX0_Y1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yCC_zP1, xCC_yP1_zP1, xCC_yCC_zP1);
 	int aX1_Y1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yCC_zP1, xCC_yP1_zP1, xCC_yCC_zP1);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpZ[aX1_Y1], col1_0 = Builder_FullBright ? white : adv_lerpZ[aX1_Y0];
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpZ[aX0_Y0], col0_1 = Builder_FullBright ? white : adv_lerpZ[aX0_Y1];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerpZ[aX1_Y1], col1_0 = ctx->fullBright ? white : ctx->lerpZ[aX1_Y0];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerpZ[aX0_Y0], col0_1 = ctx->fullBright ? white : ctx->lerpZ[aX0_Y1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_ZMAX];
-	v.z = adv_z2;
+	v.z = ctx->z2;
 	if (aX1_Y1 + aX0_Y0 > aX0_Y1 + aX1_Y0) {
-		v.x = adv_x1;               v.y = adv_y2; v.U = u1; v.V = v1; v.Col = col0_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.y = adv_y2;           v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;               v.y = ctx->y2; v.U = u1; v.V = v1; v.Col = col0_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.y = ctx->y2;           v.V = v1; v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.x = adv_x2 + (count - 1); v.y = adv_y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1); v.y = ctx->y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_ZMAX] = vertices;
 }
 
-static void Adv_DrawYMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMIN);
+static void Adv_DrawYMin(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->minBB.z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Z0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yM1_zCC, xCC_yM1_zM1, xCC_yM1_zCC);
 	int aX1_Z0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yM1_zCC, xCC_yM1_zM1, xCC_yM1_zCC);
 	int aX0_Z1 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yM1_zCC, xCC_yM1_zP1, xCC_yM1_zCC);
 	int aX1_Z1 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yM1_zCC, xCC_yM1_zP1, xCC_yM1_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_1 = Builder_FullBright ? white : adv_lerpY[aX0_Z1], col1_1 = Builder_FullBright ? white : adv_lerpY[aX1_Z1];
-	PackedCol col1_0 = Builder_FullBright ? white : adv_lerpY[aX1_Z0], col0_0 = Builder_FullBright ? white : adv_lerpY[aX0_Z0];
+	PackedCol col0_1 = ctx->fullBright ? white : ctx->lerpY[aX0_Z1], col1_1 = ctx->fullBright ? white : ctx->lerpY[aX1_Z1];
+	PackedCol col1_0 = ctx->fullBright ? white : ctx->lerpY[aX1_Z0], col0_0 = ctx->fullBright ? white : ctx->lerpY[aX0_Z0];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_YMIN];
-	v.y = adv_y1;
+	v.y = ctx->y1;
 	if (aX0_Z1 + aX1_Z0 > aX0_Z0 + aX1_Z1) {
-		v.x = adv_x2 + (count - 1); v.z = adv_z2; v.U = u2; v.V = v2; v.Col = col1_1; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1); v.z = ctx->z2; v.U = u2; v.V = v2; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	} else {
-		v.x = adv_x1;               v.z = adv_z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;               v.z = ctx->z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_YMIN] = vertices;
 }
 
-static void Adv_DrawYMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMAX);
+static void Adv_DrawYMax(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->minBB.z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Z0 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yP1_zCC, xCC_yP1_zM1, xCC_yP1_zCC);
 	int aX1_Z0 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yP1_zCC, xCC_yP1_zM1, xCC_yP1_zCC);
 	int aX0_Z1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yP1_zCC, xCC_yP1_zP1, xCC_yP1_zCC);
 	int aX1_Z1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yP1_zCC, xCC_yP1_zP1, xCC_yP1_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerp[aX0_Z0], col1_0 = Builder_FullBright ? white : adv_lerp[aX1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerp[aX1_Z1], col0_1 = Builder_FullBright ? white : adv_lerp[aX0_Z1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerp[aX0_Z0], col1_0 = ctx->fullBright ? white : ctx->lerp[aX1_Z0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerp[aX1_Z1], col0_1 = ctx->fullBright ? white : ctx->lerp[aX0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_YMAX];
-	v.y = adv_y2;
+	v.y = ctx->y2;
 	if (aX0_Z0 + aX1_Z1 > aX0_Z1 + aX1_Z0) {
-		v.x = adv_x2 + (count - 1); v.z = adv_z1; v.U = u2; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1); v.z = ctx->z1; v.U = u2; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.x = adv_x1;               v.z = adv_z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x1;               v.z = ctx->z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_YMAX] = vertices;
 }
 
-static void Adv_RenderBlock(int index, int x, int y, int z) {
+static void Adv_RenderBlock(struct BuilderContext* ctx, int index, int x, int y, int z) {
 	Vec3 min, max;
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[ctx->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(ctx, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->counts[index + FACE_XMIN];
+	count_XMax = ctx->counts[index + FACE_XMAX];
+	count_ZMin = ctx->counts[index + FACE_ZMIN];
+	count_ZMax = ctx->counts[index + FACE_ZMAX];
+	count_YMin = ctx->counts[index + FACE_YMIN];
+	count_YMax = ctx->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	Builder_FullBright = Blocks.Brightness[Builder_Block];
-	adv_baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	adv_tinted     = Blocks.Tinted[Builder_Block];
+	ctx->fullBright = Blocks.Brightness[ctx->block];
+	ctx->baseOffset = (Blocks.Draw[ctx->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	ctx->tinted     = Blocks.Tinted[ctx->block];
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	adv_x1 = x + min.x; adv_y1 = y + min.y; adv_z1 = z + min.z;
-	adv_x2 = x + max.x; adv_y2 = y + max.y; adv_z2 = z + max.z;
+	min = Blocks.RenderMinBB[ctx->block]; max = Blocks.RenderMaxBB[ctx->block];
+	ctx->x1 = x + min.x; ctx->y1 = y + min.y; ctx->z1 = z + min.z;
+	ctx->x2 = x + max.x; ctx->y2 = y + max.y; ctx->z2 = z + max.z;
 
-	adv_minBB = Blocks.MinBB[Builder_Block]; adv_maxBB = Blocks.MaxBB[Builder_Block];
-	adv_minBB.y = 1.0f - adv_minBB.y; adv_maxBB.y = 1.0f - adv_maxBB.y;
+	ctx->minBB = Blocks.MinBB[ctx->block]; ctx->maxBB = Blocks.MaxBB[ctx->block];
+	ctx->minBB.y = 1.0f - ctx->minBB.y; ctx->maxBB.y = 1.0f - ctx->maxBB.y;
 
-	if (count_XMin) Adv_DrawXMin(count_XMin);
-	if (count_XMax) Adv_DrawXMax(count_XMax);
-	if (count_ZMin) Adv_DrawZMin(count_ZMin);
-	if (count_ZMax) Adv_DrawZMax(count_ZMax);
-	if (count_YMin) Adv_DrawYMin(count_YMin);
-	if (count_YMax) Adv_DrawYMax(count_YMax);
+	if (count_XMin) Adv_DrawXMin(ctx, count_XMin);
+	if (count_XMax) Adv_DrawXMax(ctx, count_XMax);
+	if (count_ZMin) Adv_DrawZMin(ctx, count_ZMin);
+	if (count_ZMax) Adv_DrawZMax(ctx, count_ZMax);
+	if (count_YMin) Adv_DrawYMin(ctx, count_YMin);
+	if (count_YMax) Adv_DrawYMax(ctx, count_YMax);
 }
 
-static void Adv_PrePrepareChunk(void) {
+static void Adv_PrePrepareChunk(struct BuilderContext* ctx) {
 	int i;
-	DefaultPrePrepateChunk();
-	adv_bitFlags = Builder_BitFlags;
+	DefaultPrePrepateChunk(ctx);
 
 	for (i = 0; i <= 4; i++) {
-		adv_lerp[i]  = PackedCol_Lerp(Env.ShadowCol,   Env.SunCol,   i / 4.0f);
-		adv_lerpX[i] = PackedCol_Lerp(Env.ShadowXSide, Env.SunXSide, i / 4.0f);
-		adv_lerpZ[i] = PackedCol_Lerp(Env.ShadowZSide, Env.SunZSide, i / 4.0f);
-		adv_lerpY[i] = PackedCol_Lerp(Env.ShadowYMin,  Env.SunYMin,  i / 4.0f);
+		ctx->lerp[i]  = PackedCol_Lerp(Env.ShadowCol,   Env.SunCol,   i / 4.0f);
+		ctx->lerpX[i] = PackedCol_Lerp(Env.ShadowXSide, Env.SunXSide, i / 4.0f);
+		ctx->lerpZ[i] = PackedCol_Lerp(Env.ShadowZSide, Env.SunZSide, i / 4.0f);
+		ctx->lerpY[i] = PackedCol_Lerp(Env.ShadowYMin,  Env.SunYMin,  i / 4.0f);
 	}
 }
 
-static void AdvBuilder_SetActive(void) {
-	Builder_SetDefault();
-	Builder_StretchXLiquid  = Adv_StretchXLiquid;
-	Builder_StretchX        = Adv_StretchX;
-	Builder_StretchZ        = Adv_StretchZ;
-	Builder_RenderBlock     = Adv_RenderBlock;
-	Builder_PrePrepareChunk = Adv_PrePrepareChunk;
+static void AdvBuilder_SetActive(struct BuilderContext* ctx) {
+	Builder_SetDefault(ctx);
+	ctx->StretchXLiquid  = Adv_StretchXLiquid;
+	ctx->StretchX        = Adv_StretchX;
+	ctx->StretchZ        = Adv_StretchZ;
+	ctx->RenderBlock     = Adv_RenderBlock;
+	ctx->PrePrepareChunk = Adv_PrePrepareChunk;
 }
 #else
-static void AdvBuilder_SetActive(void) { NormalBuilder_SetActive(); }
+static void AdvBuilder_SetActive(struct BuilderContext* ctx) { NormalBuilder_SetActive(ctx); }
 #endif
 
 
@@ -1280,8 +1930,29 @@ static void AdvBuilder_SetActive(void) { NormalBuilder_SetActive(); }
 /* Fast color averaging wizardy from https://stackoverflow.com/questions/8440631/how-would-you-average-two-32-bit-colors-packed-into-an-integer */
 #define AVERAGE(a, b)   ( ((((a) ^ (b)) & 0xfefefefe) >> 1) + ((a) & (b)) )
 
-static cc_bool Modern_IsOccluded(int x, int y, int z) {
-	BlockID block = World_SafeGetBlock(x, y, z);
+/* Neighbouring faces share most of their light samples, so the light of each cell is only calculated once */
+enum MODERN_LIGHT { MODERN_LIGHT_XSIDE, MODERN_LIGHT_ZSIDE, MODERN_LIGHT_YMIN, MODERN_LIGHT_YMAX };
+
+static PackedCol Modern_GetLight(struct BuilderContext* ctx, int type, int x, int y, int z, int cIndex) {
+	PackedCol* cached = &ctx->lightCache[type][cIndex];
+	if (*cached) return *cached;
+
+	switch (type) {
+	case MODERN_LIGHT_XSIDE:
+		*cached = Lighting.Color_XSide_Fast(x, y, z); break;
+	case MODERN_LIGHT_ZSIDE:
+		*cached = Lighting.Color_ZSide_Fast(x, y, z); break;
+	case MODERN_LIGHT_YMIN:
+		*cached = Lighting.Color_YMin_Fast(x, y, z);  break;
+	default:
+		*cached = Lighting.Color(x, y, z); break;
+	}
+	return *cached;
+}
+
+/* NOTE: Out of map blocks in the chunk buffer are air, same as World_SafeGetBlock */
+static cc_bool Modern_IsOccluded(struct BuilderContext* ctx, int cIndex) {
+	BlockID block = ctx->chunk[cIndex];
 	if (Blocks.Brightness[block] > 0) { return false; }
 	/* If the block we're pulling colors from is solid, return a darker version of original and increment how many are like this */
 	if (Blocks.FullOpaque[block] || (Blocks.Draw[block] == DRAW_TRANSPARENT && Blocks.BlocksLight[block] && Blocks.LightOffset[block] == 0xFF)) {
@@ -1294,345 +1965,363 @@ static cc_bool Modern_CanStretch(BlockID initial, int chunkIndex, int x, int y,
 	return false;
 }
 
-static int Modern_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int Modern_StretchXLiquid(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
-	AddVertices(block, FACE_YMAX);
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int Modern_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Modern_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1;
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int Modern_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Modern_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1;
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static PackedCol Modern_GetColorX(PackedCol orig, int x, int y, int z, int oY, int oZ) {
-	cc_bool xOccluded =  Modern_IsOccluded(x, y + oY, z     );
-	cc_bool zOccluded =  Modern_IsOccluded(x, y     , z + oZ);
-	cc_bool xzOccluded = Modern_IsOccluded(x, y + oY, z + oZ);
+static PackedCol Modern_GetColorX(struct BuilderContext* ctx, PackedCol orig, int x, int y, int z, int cIndex, int oY, int oZ) {
+	int iA = cIndex + oY * EXTCHUNK_SIZE_2, iB = cIndex + oZ * EXTCHUNK_SIZE, iAB = iA + oZ * EXTCHUNK_SIZE;
+	cc_bool aOccluded  = Modern_IsOccluded(ctx, iA);
+	cc_bool bOccluded  = Modern_IsOccluded(ctx, iB);
+	cc_bool abOccluded = Modern_IsOccluded(ctx, iAB);
 
-	PackedCol CoX = xOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_XSide_Fast(x, y + oY, z     );
-	PackedCol CoZ = zOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_XSide_Fast(x, y     , z + oZ);
-	PackedCol CoXoZ = (xzOccluded || (xOccluded && zOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_XSide_Fast(x, y + oY, z + oZ);
+	PackedCol CoA   =                                aOccluded ? PackedCol_Scale(orig, FANCY_AO) : Modern_GetLight(ctx, MODERN_LIGHT_XSIDE, x, y + oY, z, iA);
+	PackedCol CoB   =                                bOccluded ? PackedCol_Scale(orig, FANCY_AO) : Modern_GetLight(ctx, MODERN_LIGHT_XSIDE, x, y, z + oZ, iB);
+	PackedCol CoAoB = (abOccluded || (aOccluded && bOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Modern_GetLight(ctx, MODERN_LIGHT_XSIDE, x, y + oY, z + oZ, iAB);
 
-	PackedCol ab = AVERAGE(CoX, CoZ);
-	PackedCol cd = AVERAGE(CoXoZ, orig);
+	PackedCol ab = AVERAGE(CoA, CoB);
+	PackedCol cd = AVERAGE(CoAoB, orig);
 	return AVERAGE(ab, cd);
 }
-static void Modern_DrawXMin(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMIN);
+static void Modern_DrawXMin(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.z, u2 = (count - 1) + adv_maxBB.z * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.z, u2 = (count - 1) + ctx->maxBB.z * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_XMIN) & 1;
-	PackedCol orig = Lighting.Color_XSide_Fast(x-offset, y, z);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorX(orig, x-offset, y, z, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorX(orig, x-offset, y, z, 1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorX(orig, x-offset, y, z, 1, 1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorX(orig, x-offset, y, z, -1, 1);
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_XMIN) & 1;
+	int cIndex = ctx->chunkIndex - offset;
+	PackedCol orig = Modern_GetLight(ctx, MODERN_LIGHT_XSIDE, x-offset, y, z, cIndex);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x-offset, y, z, cIndex, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x-offset, y, z, cIndex, 1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x-offset, y, z, cIndex, 1, 1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x-offset, y, z, cIndex, -1, 1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_XMIN];
-	v.x = adv_x1;
-		v.y = adv_y2; v.z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+	v.x = ctx->x1;
+		v.y = ctx->y2; v.z = ctx->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.z = ctx->z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
 	part->faces.vertices[FACE_XMIN] = vertices;
 }
 
-static void Modern_DrawXMax(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMAX);
+static void Modern_DrawXMax(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.z), u2 = (1 - adv_maxBB.z) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->minBB.z), u2 = (1 - ctx->maxBB.z) * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_XMAX) & 1;
-	PackedCol orig = Lighting.Color_XSide_Fast(x+offset, y, z);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorX(orig, x+offset, y, z, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorX(orig, x+offset, y, z, 1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorX(orig, x+offset, y, z, 1, 1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorX(orig, x+offset, y, z, -1, 1);
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_XMAX) & 1;
+	int cIndex = ctx->chunkIndex + offset;
+	PackedCol orig = Modern_GetLight(ctx, MODERN_LIGHT_XSIDE, x+offset, y, z, cIndex);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x+offset, y, z, cIndex, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x+offset, y, z, cIndex, 1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x+offset, y, z, cIndex, 1, 1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x+offset, y, z, cIndex, -1, 1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_XMAX];
-	v.x = adv_x2;
-		v.y = adv_y2; v.z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		v.y = adv_y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
+	v.x = ctx->x2;
+		v.y = ctx->y2; v.z = ctx->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.y = ctx->y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
 	part->faces.vertices[FACE_XMAX] = vertices;
 }
 
-static PackedCol Modern_GetColorZ(PackedCol orig, int x, int y, int z, int oX, int oY) {
-	cc_bool xOccluded  = Modern_IsOccluded(x + oX, y     , z);
-	cc_bool zOccluded  = Modern_IsOccluded(x,      y + oY, z);
-	cc_bool xzOccluded = Modern_IsOccluded(x + oX, y + oY, z);
+static PackedCol Modern_GetColorZ(struct BuilderContext* ctx, PackedCol orig, int x, int y, int z, int cIndex, int oX, int oY) {
+	int iA = cIndex + oX, iB = cIndex + oY * EXTCHUNK_SIZE_2, iAB = iA + oY * EXTCHUNK_SIZE_2;
+	cc_bool aOccluded  = Modern_IsOccluded(ctx, iA);
+	cc_bool bOccluded  = Modern_IsOccluded(ctx, iB);
+	cc_bool abOccluded = Modern_IsOccluded(ctx, iAB);
 
-	PackedCol CoX   =                                xOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_ZSide_Fast(x + oX, y     , z);
-	PackedCol CoZ   =                                zOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_ZSide_Fast(x     , y + oY, z);
-	PackedCol CoXoZ = (xzOccluded || (xOccluded && zOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_ZSide_Fast(x + oX, y + oY, z);
+	PackedCol CoA   =                                aOccluded ? PackedCol_Scale(orig, FANCY_AO) : Modern_GetLight(ctx, MODERN_LIGHT_ZSIDE, x + oX, y, z, iA);
+	PackedCol CoB   =                                bOccluded ? PackedCol_Scale(orig, FANCY_AO) : Modern_GetLight(ctx, MODERN_LIGHT_ZSIDE, x, y + oY, z, iB);
+	PackedCol CoAoB = (abOccluded || (aOccluded && bOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Modern_GetLight(ctx, MODERN_LIGHT_ZSIDE, x + oX, y + oY, z, iAB);
 
-	PackedCol ab = AVERAGE(CoX, CoZ);
-	PackedCol cd = AVERAGE(CoXoZ, orig);
+	PackedCol ab = AVERAGE(CoA, CoB);
+	PackedCol cd = AVERAGE(CoAoB, orig);
 	return AVERAGE(ab, cd);
 }
-static void Modern_DrawZMin(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMIN);
+static void Modern_DrawZMin(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.x), u2 = (1 - adv_maxBB.x) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->minBB.x), u2 = (1 - ctx->maxBB.x) * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_ZMIN) & 1;
-	PackedCol orig = Lighting.Color_ZSide_Fast(x, y, z-offset);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, 1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, 1, 1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, -1, 1);
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_ZMIN) & 1;
+	int cIndex = ctx->chunkIndex - offset * EXTCHUNK_SIZE;
+	PackedCol orig = Modern_GetLight(ctx, MODERN_LIGHT_ZSIDE, x, y, z-offset, cIndex);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z-offset, cIndex, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z-offset, cIndex, 1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z-offset, cIndex, 1, 1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z-offset, cIndex, -1, 1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_ZMIN];
-	v.z = adv_z1;
-		v.x = adv_x1;               v.y = adv_y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
-		                            v.y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
+	v.z = ctx->z1;
+		v.x = ctx->x1;               v.y = ctx->y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
+		                            v.y = ctx->y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
 	part->faces.vertices[FACE_ZMIN] = vertices;
 }
 
-static void Modern_DrawZMax(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMAX);
+static void Modern_DrawZMax(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_ZMAX) & 1;
-	PackedCol orig = Lighting.Color_ZSide_Fast(x, y, z+offset);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, 1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, 1, 1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, -1, 1);
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_ZMAX) & 1;
+	int cIndex = ctx->chunkIndex + offset * EXTCHUNK_SIZE;
+	PackedCol orig = Modern_GetLight(ctx, MODERN_LIGHT_ZSIDE, x, y, z+offset, cIndex);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z+offset, cIndex, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z+offset, cIndex, 1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z+offset, cIndex, 1, 1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z+offset, cIndex, -1, 1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_ZMAX];
-	v.z = adv_z2;
-		v.x = adv_x2 + (count - 1); v.y = adv_y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+	v.z = ctx->z2;
+		v.x = ctx->x2 + (count - 1); v.y = ctx->y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	part->faces.vertices[FACE_ZMAX] = vertices;
 }
 
-static PackedCol Modern_GetColorYMin(PackedCol orig, int x, int y, int z, int oX, int oZ) {
-	cc_bool xOccluded  = Modern_IsOccluded(x + oX, y, z     );
-	cc_bool zOccluded  = Modern_IsOccluded(x,      y, z + oZ);
-	cc_bool xzOccluded = Modern_IsOccluded(x + oX, y, z + oZ);
+static PackedCol Modern_GetColorYMin(struct BuilderContext* ctx, PackedCol orig, int x, int y, int z, int cIndex, int oX, int oZ) {
+	int iA = cIndex + oX, iB = cIndex + oZ * EXTCHUNK_SIZE, iAB = iA + oZ * EXTCHUNK_SIZE;
+	cc_bool aOccluded  = Modern_IsOccluded(ctx, iA);
+	cc_bool bOccluded  = Modern_IsOccluded(ctx, iB);
+	cc_bool abOccluded = Modern_IsOccluded(ctx, iAB);
 
-	PackedCol CoX   =                                xOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_YMin_Fast(x + oX, y, z     );
-	PackedCol CoZ   =                                zOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_YMin_Fast(x     , y, z + oZ);
-	PackedCol CoXoZ = (xzOccluded || (xOccluded && zOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_YMin_Fast(x + oX, y, z + oZ);
+	PackedCol CoA   =                                aOccluded ? PackedCol_Scale(orig, FANCY_AO) : Modern_GetLight(ctx, MODERN_LIGHT_YMIN, x + oX, y, z, iA);
+	PackedCol CoB   =                                bOccluded ? PackedCol_Scale(orig, FANCY_AO) : Modern_GetLight(ctx, MODERN_LIGHT_YMIN, x, y, z + oZ, iB);
+	PackedCol CoAoB = (abOccluded || (aOccluded && bOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Modern_GetLight(ctx, MODERN_LIGHT_YMIN, x + oX, y, z + oZ, iAB);
 
-	PackedCol ab = AVERAGE(CoX, CoZ);
-	PackedCol cd = AVERAGE(CoXoZ, orig);
+	PackedCol ab = AVERAGE(CoA, CoB);
+	PackedCol cd = AVERAGE(CoAoB, orig);
 	return AVERAGE(ab, cd);
 }
-static void Modern_DrawYMin(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMIN);
+static void Modern_DrawYMin(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->minBB.z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_YMIN) & 1;
-	PackedCol orig = Lighting.Color_YMin_Fast(x, y-offset, z);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z,  1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z,  1,  1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z, -1,  1);
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_YMIN) & 1;
+	int cIndex = ctx->chunkIndex - offset * EXTCHUNK_SIZE_2;
+	PackedCol orig = Modern_GetLight(ctx, MODERN_LIGHT_YMIN, x, y-offset, z, cIndex);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorYMin(ctx, orig, x, y-offset, z, cIndex, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorYMin(ctx, orig, x, y-offset, z, cIndex,  1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorYMin(ctx, orig, x, y-offset, z, cIndex,  1,  1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorYMin(ctx, orig, x, y-offset, z, cIndex, -1,  1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_YMIN];
-	v.y = adv_y1;
-		v.x = adv_x1;               v.z = adv_z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
+	v.y = ctx->y1;
+		v.x = ctx->x1;               v.z = ctx->z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
 	part->faces.vertices[FACE_YMIN] = vertices;
 }
 
-static PackedCol Modern_GetColorYMax(PackedCol orig, int x, int y, int z, int oX, int oZ) {
-	cc_bool xOccluded  = Modern_IsOccluded(x + oX, y, z     );
-	cc_bool zOccluded  = Modern_IsOccluded(x,      y, z + oZ);
-	cc_bool xzOccluded = Modern_IsOccluded(x + oX, y, z + oZ);
+static PackedCol Modern_GetColorYMax(struct BuilderContext* ctx, PackedCol orig, int x, int y, int z, int cIndex, int oX, int oZ) {
+	int iA = cIndex + oX, iB = cIndex + oZ * EXTCHUNK_SIZE, iAB = iA + oZ * EXTCHUNK_SIZE;
+	cc_bool aOccluded  = Modern_IsOccluded(ctx, iA);
+	cc_bool bOccluded  = Modern_IsOccluded(ctx, iB);
+	cc_bool abOccluded = Modern_IsOccluded(ctx, iAB);
 
-	PackedCol CoX   =                                xOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color(x + oX, y, z     );
-	PackedCol CoZ   =                                zOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color(x     , y, z + oZ);
-	PackedCol CoXoZ = (xzOccluded || (xOccluded && zOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color(x + oX, y, z + oZ);
+	PackedCol CoA   =                                aOccluded ? PackedCol_Scale(orig, FANCY_AO) : Modern_GetLight(ctx, MODERN_LIGHT_YMAX, x + oX, y, z, iA);
+	PackedCol CoB   =                                bOccluded ? PackedCol_Scale(orig, FANCY_AO) : Modern_GetLight(ctx, MODERN_LIGHT_YMAX, x, y, z + oZ, iB);
+	PackedCol CoAoB = (abOccluded || (aOccluded && bOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Modern_GetLight(ctx, MODERN_LIGHT_YMAX, x + oX, y, z + oZ, iAB);
 
-	PackedCol ab = AVERAGE(CoX, CoZ);
-	PackedCol cd = AVERAGE(CoXoZ, orig);
+	PackedCol ab = AVERAGE(CoA, CoB);
+	PackedCol cd = AVERAGE(CoAoB, orig);
 	return AVERAGE(ab, cd);
 }
-static void Modern_DrawYMax(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMAX);
+static void Modern_DrawYMax(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->minBB.z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_YMAX) & 1;
-	PackedCol orig = Lighting.Color(x, y+offset, z);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z,  1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z,  1,  1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z, -1,  1);
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_YMAX) & 1;
+	int cIndex = ctx->chunkIndex + offset * EXTCHUNK_SIZE_2;
+	PackedCol orig = Modern_GetLight(ctx, MODERN_LIGHT_YMAX, x, y+offset, z, cIndex);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorYMax(ctx, orig, x, y+offset, z, cIndex, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorYMax(ctx, orig, x, y+offset, z, cIndex,  1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorYMax(ctx, orig, x, y+offset, z, cIndex,  1,  1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorYMax(ctx, orig, x, y+offset, z, cIndex, -1,  1);
 
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_YMAX];
-	v.y = adv_y2;
-		v.x = adv_x1;               v.z = adv_z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
+	v.y = ctx->y2;
+		v.x = ctx->x1;               v.z = ctx->z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
 	part->faces.vertices[FACE_YMAX] = vertices;
 }
 
-static void Modern_RenderBlock(int index, int x, int y, int z) {
+static void Modern_RenderBlock(struct BuilderContext* ctx, int index, int x, int y, int z) {
 	Vec3 min, max;
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[ctx->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(ctx, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->counts[index + FACE_XMIN];
+	count_XMax = ctx->counts[index + FACE_XMAX];
+	count_ZMin = ctx->counts[index + FACE_ZMIN];
+	count_ZMax = ctx->counts[index + FACE_ZMAX];
+	count_YMin = ctx->counts[index + FACE_YMIN];
+	count_YMax = ctx->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	Builder_FullBright = Blocks.Brightness[Builder_Block];
-	adv_baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	adv_tinted = Blocks.Tinted[Builder_Block];
+	ctx->fullBright = Blocks.Brightness[ctx->block];
+	ctx->baseOffset = (Blocks.Draw[ctx->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	ctx->tinted = Blocks.Tinted[ctx->block];
+
+	min = Blocks.RenderMinBB[ctx->block]; max = Blocks.RenderMaxBB[ctx->block];
+	ctx->x1 = x + min.x; ctx->y1 = y + min.y; ctx->z1 = z + min.z;
+	ctx->x2 = x + max.x; ctx->y2 = y + max.y; ctx->z2 = z + max.z;
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	adv_x1 = x + min.x; adv_y1 = y + min.y; adv_z1 = z + min.z;
-	adv_x2 = x + max.x; adv_y2 = y + max.y; adv_z2 = z + max.z;
+	ctx->minBB = Blocks.MinBB[ctx->block]; ctx->maxBB = Blocks.MaxBB[ctx->block];
+	ctx->minBB.y = 1.0f - ctx->minBB.y; ctx->maxBB.y = 1.0f - ctx->maxBB.y;
 
-	adv_minBB = Blocks.MinBB[Builder_Block]; adv_maxBB = Blocks.MaxBB[Builder_Block];
-	adv_minBB.y = 1.0f - adv_minBB.y; adv_maxBB.y = 1.0f - adv_maxBB.y;
+	if (count_XMin) Modern_DrawXMin(ctx, count_XMin, x, y, z);
+	if (count_XMax) Modern_DrawXMax(ctx, count_XMax, x, y, z);
+	if (count_ZMin) Modern_DrawZMin(ctx, count_ZMin, x, y, z);
+	if (count_ZMax) Modern_DrawZMax(ctx, count_ZMax, x, y, z);
+	if (count_YMin) Modern_DrawYMin(ctx, count_YMin, x, y, z);
+	if (count_YMax) Modern_DrawYMax(ctx, count_YMax, x, y, z);
+}
 
-	if (count_XMin) Modern_DrawXMin(count_XMin, x, y, z);
-	if (count_XMax) Modern_DrawXMax(count_XMax, x, y, z);
-	if (count_ZMin) Modern_DrawZMin(count_ZMin, x, y, z);
-	if (count_ZMax) Modern_DrawZMax(count_ZMax, x, y, z);
-	if (count_YMin) Modern_DrawYMin(count_YMin, x, y, z);
-	if (count_YMax) Modern_DrawYMax(count_YMax, x, y, z);
+static void Modern_PrePrepareChunk(struct BuilderContext* ctx) {
+	DefaultPrePrepateChunk(ctx);
 }
 
-static void Modern_PrePrepareChunk(void) {
-	DefaultPrePrepateChunk();
-	adv_bitFlags = Builder_BitFlags;
+static void Modern_PostPrepareChunk(struct BuilderContext* ctx) {
+	DefaultPostStretchChunk(ctx);
+	/* Cleared here instead of in PrePrepareChunk, to avoid doing so for chunks that are entirely air */
+	Mem_Set(ctx->lightCache, 0, sizeof(ctx->lightCache));
 }
 
-static void ModernBuilder_SetActive(void) {
-	Builder_SetDefault();
-	Builder_StretchXLiquid =  Modern_StretchXLiquid;
-	Builder_StretchX =        Modern_StretchX;
-	Builder_StretchZ =        Modern_StretchZ;
-	Builder_RenderBlock =     Modern_RenderBlock;
-	Builder_PrePrepareChunk = Modern_PrePrepareChunk;
+static void ModernBuilder_SetActive(struct BuilderContext* ctx) {
+	Builder_SetDefault(ctx);
+	ctx->StretchXLiquid =  Modern_StretchXLiquid;
+	ctx->StretchX =        Modern_StretchX;
+	ctx->StretchZ =        Modern_StretchZ;
+	ctx->RenderBlock =     Modern_RenderBlock;
+	ctx->PrePrepareChunk = Modern_PrePrepareChunk;
+	ctx->PostPrepareChunk = Modern_PostPrepareChunk;
 }
 #else
-static void ModernBuilder_SetActive(void) { NormalBuilder_SetActive(); }
+static void ModernBuilder_SetActive(struct BuilderContext* ctx) { NormalBuilder_SetActive(ctx); }
 #endif
 
 /*########################################################################################################################*
 *---------------------------------------------------Builder interface-----------------------------------------------------*
 *#########################################################################################################################*/
 cc_bool Builder_SmoothLighting;
+cc_bool Builder_GreedyMeshing;
+cc_bool Builder_PackedVertices;
 void Builder_ApplyActive(void) {
 	if (Builder_SmoothLighting) {
 		if (Lighting_Mode != LIGHTING_MODE_CLASSIC) {
-			ModernBuilder_SetActive();
+			Builder_SetActive = ModernBuilder_SetActive;
 		}
 		else {
-			AdvBuilder_SetActive();
+			Builder_SetActive = AdvBuilder_SetActive;
 		}
 	} else {
-		NormalBuilder_SetActive();
+		Builder_SetActive = NormalBuilder_SetActive;
 	}
 }
 
@@ -1645,17 +2334,38 @@ static void OnInit(void) {
 	Builder_Offsets[FACE_YMAX] =  EXTCHUNK_SIZE_2;
 
 	if (!Game_ClassicMode) Builder_SmoothLighting = Options_GetBool(OPT_SMOOTH_LIGHTING, false);
+	Builder_GreedyMeshing = Options_GetBool(OPT_GREEDY_MESHING, false);
 	Builder_ApplyActive();
+	Builder_StartWorkers();
+}
+
+static void OnFree(void) {
+	Builder_StopWorkers();
+	Mem_Free(mainCtx.scratch);
+	mainCtx.scratch      = NULL;
+	mainCtx.scratchCount = 0;
+	MemArena_Free(&mainCtx.arena);
+	FreeSortBuffers(&mainCtx);
+#ifndef CC_BUILD_GL11
+	Mem_Free(packedVertices);
+	packedVertices      = NULL;
+	packedVerticesCount = 0;
+#endif
 }
 
 static void OnNewMapLoaded(void) {
 	Builder_SidesLevel = max(0, Env_SidesHeight);
 	Builder_EdgeLevel  = max(0, Env.EdgeHeight);
+
+	/* Packed vertices can only store coordinates up to a certain size */
+	Builder_PackedVertices = Gfx.SupportsPackedVertices &&
+		World.Width  < VERTEX_PACKED_MAX_COORD && World.Height < VERTEX_PACKED_MAX_COORD &&
+		World.Length < VERTEX_PACKED_MAX_COORD;
 }
 
 struct IGameComponent Builder_Component = {
 	OnInit, /* Init */
-	NULL, /* Free */
+	OnFree, /* Free */
 	NULL, /* Reset */
 	NULL, /* OnNewMap */
 	OnNewMapLoaded /* OnNewMapLoaded */
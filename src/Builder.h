@@ -12,15 +12,32 @@ Converts a 16x16x16 chunk into a mesh of vertices
 Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 */
 struct ChunkInfo;
+struct BuilderContext;
 struct IGameComponent;
 extern struct IGameComponent Builder_Component;
 
 extern int Builder_SidesLevel, Builder_EdgeLevel;
 /* Whether smooth/advanced lighting mesh builder is used. */
 extern cc_bool Builder_SmoothLighting;
+/* Whether the normal mesh builder also merges rows of identical faces together into one quad. */
+/* NOTE: Only applies to full size blocks whose textures look the same when stretched vertically. */
+extern cc_bool Builder_GreedyMeshing;
+/* Whether chunk meshes use VERTEX_FORMAT_PACKED instead of VERTEX_FORMAT_TEXTURED. */
+extern cc_bool Builder_PackedVertices;
 
 /* Builds the mesh of vertices for the given chunk. */
 void Builder_MakeChunk(struct ChunkInfo* info);
+/* Builds the meshes of vertices for the given chunks. */
+/* NOTE: Chunks may be built in parallel by multiple worker threads. */
+void Builder_MakeChunks(struct ChunkInfo** chunks, int count);
+
+/* Allocates a context, which holds all the state used while building the mesh of a chunk. */
+/* Each thread that builds chunk meshes at the same time must use a separate context. */
+/* NOTE: Returns NULL when out of memory */
+struct BuilderContext* Builder_CreateContext(void);
+void Builder_FreeContext(struct BuilderContext* ctx);
+/* Builds the mesh of vertices for the given chunk, using the given context. */
+void Builder_MakeChunkWith(struct BuilderContext* ctx, struct ChunkInfo* info);
 
 void Builder_ApplyActive(void);
 
@@ -58,12 +58,136 @@ static void ResetLogFile(void) {
 	lastLogYear    = -123;
 }
 
+/* Chat log lines are buffered in memory, and only written to disk in batches */
+/*  (on a background thread when possible) to avoid many small writes to the log file */
+#define LOG_BUFFER_SIZE (16 * 1024)
+/* Buffered lines are written once at least this much data is buffered, */
+/*  or otherwise after at most LOG_FLUSH_INTERVAL seconds */
+#define LOG_FLUSH_SIZE  (8  * 1024)
+#define LOG_FLUSH_INTERVAL 2.0
+
+static cc_uint8 logPending[LOG_BUFFER_SIZE];
+static int logPendingLen;
+static void FlushLogFile(void);
+
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_WEB && !defined CC_BUILD_LOWMEM
+#define LOG_WRITER_THREAD
+static cc_uint8 logWriting[LOG_BUFFER_SIZE];
+/* logMutex protects logPending, logStreamMutex protects logStream */
+static void* logMutex;
+static void* logStreamMutex;
+static void* logWaitable;
+static void* logThread;
+static volatile cc_bool  logStopping;
+static volatile cc_result logWriteResult;
+
+static void LogWriter_Run(void) {
+	cc_result res;
+	int len;
+
+	for (;;) {
+		Waitable_Wait(logWaitable);
+		if (logStopping) return;
+
+		Mutex_Lock(logStreamMutex);
+		{
+			Mutex_Lock(logMutex);
+			{
+				len = logPendingLen;
+				Mem_Copy(logWriting, logPending, len);
+				logPendingLen = 0;
+			}
+			Mutex_Unlock(logMutex);
+
+			if (len && logStream.meta.file) {
+				res = Stream_Write(&logStream, logWriting, len);
+				if (res) logWriteResult = res;
+			}
+		}
+		Mutex_Unlock(logStreamMutex);
+	}
+}
+
+static void LogWriter_Start(void) {
+	if (logThread) return;
+	logStopping    = false;
+	logMutex       = Mutex_Create("Chat log");
+	logStreamMutex = Mutex_Create("Chat log stream");
+	logWaitable    = Waitable_Create("Chat log writer");
+	Thread_Run(&logThread, LogWriter_Run, 64 * 1024, "Chat log writer");
+}
+
+static void LogWriter_Stop(void) {
+	if (!logThread) return;
+	logStopping = true;
+	Waitable_Signal(logWaitable);
+	Thread_Join(logThread);
+
+	logThread = NULL;
+	Mutex_Free(logMutex);
+	Mutex_Free(logStreamMutex);
+	Waitable_Free(logWaitable);
+}
+
+/* Asks the background thread to write out the buffered lines */
+static void LogWriter_Wake(void) { Waitable_Signal(logWaitable); }
+#define LogWriter_Lock(mutex)   if (logThread) Mutex_Lock(mutex)
+#define LogWriter_Unlock(mutex) if (logThread) Mutex_Unlock(mutex)
+#else
+static void LogWriter_Start(void) { }
+static void LogWriter_Stop(void)  { }
+static void LogWriter_Wake(void)  { FlushLogFile(); }
+#define LogWriter_Lock(mutex)
+#define LogWriter_Unlock(mutex)
+#endif
+
+static void LogWriter_Failed(cc_result res) {
+	Chat_DisableLogging();
+	Logger_SysWarn2(res, "writing to", &logPath);
+}
+
+/* Immediately writes any buffered lines to the chat log file */
+static void FlushLogFile(void) {
+	cc_result res = 0;
+
+	LogWriter_Lock(logStreamMutex);
+	{
+		LogWriter_Lock(logMutex);
+		{
+			if (logPendingLen && logStream.meta.file) {
+				res = Stream_Write(&logStream, logPending, logPendingLen);
+			}
+			logPendingLen = 0;
+		}
+		LogWriter_Unlock(logMutex);
+	}
+	LogWriter_Unlock(logStreamMutex);
+
+#ifdef LOG_WRITER_THREAD
+	if (!res) { res = logWriteResult; logWriteResult = 0; }
+#endif
+	if (res) LogWriter_Failed(res);
+}
+
+static void LogWriter_Tick(struct ScheduledTask* task) {
+#ifdef LOG_WRITER_THREAD
+	cc_result res = logWriteResult;
+	if (res) { logWriteResult = 0; LogWriter_Failed(res); }
+#endif
+	if (logPendingLen) LogWriter_Wake();
+}
+
 /* Closes handle to the chat log file */
 static void CloseLogFile(void) {
 	cc_result res;
 	if (!logStream.meta.file) return;
+	FlushLogFile();
 
-	res = logStream.Close(&logStream);
+	LogWriter_Lock(logStreamMutex);
+	{
+		res = logStream.Close(&logStream);
+	}
+	LogWriter_Unlock(logStreamMutex);
 	if (res) { Logger_SysWarn2(res, "closing", &logPath); }
 }
 
@@ -137,7 +261,13 @@ static void OpenChatLog(struct cc_datetime* now) {
 			String_Format1(&logPath, "%s.txt", &logName);
 		}
 
-		res = Stream_AppendFile(&logStream, &logPath);
+		LogWriter_Start();
+		LogWriter_Lock(logStreamMutex);
+		{
+			res = Stream_AppendFile(&logStream, &logPath);
+		}
+		LogWriter_Unlock(logStreamMutex);
+
 		if (res && res != ReturnCode_FileShareViolation) {
 			Chat_DisableLogging();
 			Logger_SysWarn2(res, "appending to", &logPath);
@@ -155,7 +285,8 @@ static void OpenChatLog(struct cc_datetime* now) {
 static void AppendChatLog(const cc_string* text) {
 	cc_string str; char strBuffer[DRAWER2D_MAX_TEXT_LENGTH];
 	struct cc_datetime now;
-	cc_result res;	
+	const char* nl;
+	int i, len;
 
 	if (!logName.length || !Chat_Logging) return;
 	DateTime_CurrentLocal(&now);
@@ -173,10 +304,25 @@ static void AppendChatLog(const cc_string* text) {
 	String_Format3(&str, "[%p2:%p2:%p2] ", &now.hour, &now.minute, &now.second);
 	Drawer2D_WithoutColors(&str, text);
 
-	res = Stream_WriteLine(&logStream, &str);
-	if (!res) return;
-	Chat_DisableLogging();
-	Logger_SysWarn2(res, "writing to", &logPath);
+	/* Each character takes at most 3 bytes when converted to UTF8 */
+	if (logPendingLen + str.length * 3 + 2 > LOG_BUFFER_SIZE) FlushLogFile();
+	if (!logStream.meta.file) return;
+
+	LogWriter_Lock(logMutex);
+	{
+		len = logPendingLen;
+		for (i = 0; i < str.length; i++) 
+		{
+			len += Convert_CP437ToUtf8(str.buffer[i], logPending + len);
+		}
+
+		nl = _NL;
+		while (*nl) { logPending[len++] = *nl++; }
+		logPendingLen = len;
+	}
+	LogWriter_Unlock(logMutex);
+
+	if (len >= LOG_FLUSH_SIZE) LogWriter_Wake();
 }
 
 void Chat_Add1(const char* format, const void* a1) {
@@ -278,6 +424,7 @@ static void OnInit(void) {
 #else
 	Chat_Logging = Options_GetBool(OPT_CHAT_LOGGING, true);
 #endif
+	ScheduledTask_Add(LOG_FLUSH_INTERVAL, LogWriter_Tick);
 }
 
 static void ClearCPEMessages(void) {
@@ -300,6 +447,7 @@ static void OnReset(void) {
 
 static void OnFree(void) {
 	CloseLogFile();
+	LogWriter_Stop();
 	ClearCPEMessages();
 
 	ClearChatLogs();
@@ -17,6 +17,9 @@
 #include "TexturePack.h"
 #include "Options.h"
 #include "Drawer2D.h"
+#include "Screens.h"
+#include "Stream.h"
+#include "Lighting.h"
 
 #define COMMANDS_PREFIX "/client"
 #define COMMANDS_PREFIX_SPACE "/client "
@@ -304,6 +307,194 @@ static struct ChatCommand MotdCommand = {
 	}
 };
 
+static void ProfileCommand_Execute(const cc_string* args, int argsCount) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	struct cc_datetime now;
+	struct Stream stream;
+	cc_result res;
+
+	if (argsCount && String_CaselessEqualsConst(&args[0], "overlay")) {
+		ProfilerOverlay_Toggle(); return;
+	}
+	DateTime_CurrentLocal(&now);
+
+	String_InitArray(path, pathBuffer);
+	String_Format3(&path, "profile_%p4-%p2-%p2", &now.year, &now.month, &now.day);
+	String_Format3(&path, "-%p2-%p2-%p2.csv", &now.hour, &now.minute, &now.second);
+
+	res = Stream_CreateFile(&stream, &path);
+	if (res) { Logger_SysWarn2(res, "creating", &path); return; }
+
+	res = Profiler_WriteCSV(&stream);
+	if (res) {
+		Logger_SysWarn2(res, "writing", &path); stream.Close(&stream); return;
+	}
+
+	res = stream.Close(&stream);
+	if (res) { Logger_SysWarn2(res, "closing", &path); return; }
+	Chat_Add1("&e/client: &fSaved frame timings to %s", &path);
+}
+
+static struct ChatCommand ProfileCommand = {
+	"Profile", ProfileCommand_Execute,
+	COMMAND_FLAG_UNSPLIT_ARGS,
+	{
+		"&a/client profile",
+		"&eSaves the time spent in each part of recent frames to a .csv file",
+		"&a/client profile overlay",
+		"&eToggles showing the frame timings overlay",
+	}
+};
+
+#ifdef CC_BUILD_TRACKMEM
+#define MEM_REPORT_MAX_TAGS 128
+#define MEM_REPORT_HEAP_TAGS 8
+
+static void MemCommand_Execute(const cc_string* args, int argsCount) {
+	struct MemTrackedTag tags[MEM_REPORT_MAX_TAGS];
+	struct MemTrackedTag tmp;
+	cc_uint64 totals[MEM_TRACK_COUNT] = { 0 };
+	int allocs = 0, cur, peak, vbs;
+	int i, j, best, count;
+
+	count = Mem_GetTrackedTags(tags, MEM_REPORT_MAX_TAGS);
+	for (i = 0; i < count; i++)
+	{
+		totals[tags[i].type] += tags[i].cur;
+		if (tags[i].type == MEM_TRACK_HEAP) allocs += tags[i].count;
+	}
+
+	cur = (int)(totals[MEM_TRACK_HEAP] / 1024);
+	Chat_Add2("&eTracked heap: &f%i KB in %i allocations", &cur, &allocs);
+	cur  = (int)(totals[MEM_TRACK_TEXTURE] / 1024);
+	vbs = (int)(totals[MEM_TRACK_VB]      / 1024);
+	Chat_Add2("&eEstimated VRAM: &f%i KB textures, %i KB vertex buffers", &cur, &vbs);
+
+	/* Only the largest tags fit in chat */
+	for (i = 0; i < count && i < MEM_REPORT_HEAP_TAGS; i++)
+	{
+		best = i;
+		for (j = i + 1; j < count; j++) 
+		{
+			if (tags[j].cur > tags[best].cur) best = j;
+		}
+		tmp = tags[i]; tags[i] = tags[best]; tags[best] = tmp;
+		if (!tags[i].cur) break;
+
+		cur  = (int)(tags[i].cur  / 1024);
+		peak = (int)(tags[i].peak / 1024);
+		Chat_Add4("  &a%c: &f%i KB (peak %i KB, %i allocs)", tags[i].name, &cur, &peak, &tags[i].count);
+	}
+}
+#else
+static void MemCommand_Execute(const cc_string* args, int argsCount) {
+	Chat_AddRaw("&e/client: &cMemory tracking requires compiling with CC_BUILD_TRACKMEM defined");
+}
+#endif
+
+static struct ChatCommand MemCommand = {
+	"Mem", MemCommand_Execute,
+	COMMAND_FLAG_UNSPLIT_ARGS,
+	{
+		"&a/client mem",
+		"&eDisplays current memory usage of the largest tracked",
+		"&e  allocation types, and estimated texture/vertex buffer VRAM",
+	}
+};
+
+#define NETSTATS_REPORT_OPCODES 8
+
+static void NetStatsCommand_Dump(void) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	struct cc_datetime now;
+	struct Stream stream;
+	cc_result res;
+	DateTime_CurrentLocal(&now);
+
+	String_InitArray(path, pathBuffer);
+	String_Format3(&path, "netstats_%p4-%p2-%p2", &now.year, &now.month, &now.day);
+	String_Format3(&path, "-%p2-%p2-%p2.csv", &now.hour, &now.minute, &now.second);
+
+	res = Stream_CreateFile(&stream, &path);
+	if (res) { Logger_SysWarn2(res, "creating", &path); return; }
+
+	res = NetStats_WriteCSV(&stream);
+	if (res) {
+		Logger_SysWarn2(res, "writing", &path); stream.Close(&stream); return;
+	}
+
+	res = stream.Close(&stream);
+	if (res) { Logger_SysWarn2(res, "closing", &path); return; }
+	Chat_Add1("&e/client: &fSaved network statistics to %s", &path);
+}
+
+static void NetStatsCommand_Execute(const cc_string* args, int argsCount) {
+	cc_uint8 opcodes[256];
+	cc_uint64 recvBytes = 0, sentBytes = 0;
+	cc_uint32 recvPackets = 0;
+	int i, j, best, tmp, kbIn, kbOut, avg, queuedKB, maxQueuedKB;
+	float secs, ms;
+
+	if (argsCount && String_CaselessEqualsConst(&args[0], "dump")) {
+		NetStatsCommand_Dump(); return;
+	}
+	if (argsCount && String_CaselessEqualsConst(&args[0], "reset")) {
+		NetStats_Reset();
+		Chat_AddRaw("&e/client: &fNetwork statistics reset"); return;
+	}
+	if (Server.IsSinglePlayer) {
+		Chat_AddRaw("&e/client: &cNetwork statistics are only recorded in multiplayer"); return;
+	}
+
+	for (i = 0; i < 256; i++) 
+	{
+		recvPackets += NetStats.RecvPackets[i];
+		recvBytes   += NetStats.RecvBytes[i];
+		sentBytes   += NetStats.SentBytes[i];
+		opcodes[i]   = (cc_uint8)i;
+	}
+
+	secs  = (float)(Game.Time - NetStats.ResetTime);
+	kbIn  = (int)(recvBytes / 1024);
+	kbOut = (int)(sentBytes / 1024);
+	Chat_Add3("&eOver &f%f1 &eseconds: &f%i KB &ereceived, &f%i KB &esent", &secs, &kbIn, &kbOut);
+
+	avg         = NetStats.Ticks ? (int)(recvPackets / NetStats.Ticks) : 0;
+	queuedKB    = NetStats.Queued    / 1024;
+	maxQueuedKB = NetStats.MaxQueued / 1024;
+	Chat_Add4("&ePackets per tick: &f%i avg, %i max&e, queued: &f%i KB (max %i KB)", 
+				&avg, &NetStats.MaxTickPackets, &queuedKB, &maxQueuedKB);
+
+	/* Only the most expensive opcodes fit in chat */
+	for (i = 0; i < NETSTATS_REPORT_OPCODES; i++)
+	{
+		best = i;
+		for (j = i + 1; j < 256; j++) 
+		{
+			if (NetStats.HandlerTime[opcodes[j]] > NetStats.HandlerTime[opcodes[best]]) best = j;
+		}
+		tmp = opcodes[i]; opcodes[i] = opcodes[best]; opcodes[best] = (cc_uint8)tmp;
+
+		j = opcodes[i];
+		if (!NetStats.RecvPackets[j]) break;
+		ms   = Stopwatch_ElapsedMicroseconds(0, NetStats.HandlerTime[j]) / 1000.0f;
+		kbIn = (int)(NetStats.RecvBytes[j] / 1024);
+		Chat_Add4("  &aOpcode %i: &f%f2 ms, %i packets, %i KB", &j, &ms, &NetStats.RecvPackets[j], &kbIn);
+	}
+}
+
+static struct ChatCommand NetStatsCommand = {
+	"NetStats", NetStatsCommand_Execute,
+	COMMAND_FLAG_UNSPLIT_ARGS,
+	{
+		"&a/client netstats",
+		"&eDisplays bandwidth used, and the packets which took the most time to process",
+		"&a/client netstats dump",
+		"&eSaves packets and bytes sent/received per opcode to a .csv file",
+		"&a/client netstats reset",
+	}
+};
+
 /*#######################################################################################################################*
 *-------------------------------------------------------PlaceCommand-----------------------------------------------------*
 *########################################################################################################################*/
@@ -400,7 +591,11 @@ static void DrawOpCommand_Execute(void) {
 	if (!World_Contains(min.x, min.y, min.z)) return;
 	if (!World_Contains(max.x, max.y, max.z)) return;
 
+	Game_BeginBlockChanges();
+	Lighting_BeginBatch();
 	drawOp_Func(min, max);
+	Lighting_EndBatch();
+	Game_EndBlockChanges();
 }
 
 static void DrawOpCommand_BlockChanged(void* obj, IVec3 coords, BlockID old, BlockID now) {
@@ -459,21 +654,17 @@ static int DrawOpCommand_ParseBlock(const cc_string* arg) {
 *-------------------------------------------------------CuboidCommand-----------------------------------------------------*
 *#########################################################################################################################*/
 static int cuboid_block;
+static BlockID cuboid_toPlace;
 
-static void CuboidCommand_Draw(IVec3 min, IVec3 max) {
-	BlockID toPlace;
-	int x, y, z;
+static BlockID CuboidCommand_GetBlock(int x, int y, int z, BlockID cur) {
+	return cuboid_toPlace;
+}
 
-	toPlace = (BlockID)cuboid_block;
-	if (cuboid_block == -1) toPlace = Inventory_SelectedBlock;
+static void CuboidCommand_Draw(IVec3 min, IVec3 max) {
+	cuboid_toPlace = (BlockID)cuboid_block;
+	if (cuboid_block == -1) cuboid_toPlace = Inventory_SelectedBlock;
 
-	for (y = min.y; y <= max.y; y++) {
-		for (z = min.z; z <= max.z; z++) {
-			for (x = min.x; x <= max.x; x++) {
-				Game_ChangeBlock(x, y, z, toPlace);
-			}
-		}
-	}
+	Game_ChangeBlocks(min.x, min.y, min.z, max.x, max.y, max.z, CuboidCommand_GetBlock);
 }
 
 static void CuboidCommand_Execute(const cc_string* args, int argsCount) {
@@ -511,24 +702,17 @@ static struct ChatCommand CuboidCommand = {
 *-------------------------------------------------------ReplaceCommand-----------------------------------------------------*
 *#########################################################################################################################*/
 static int replace_source, replace_target;
+static BlockID replace_toPlace;
+
+static BlockID ReplaceCommand_GetBlock(int x, int y, int z, BlockID cur) {
+	return cur == (BlockID)replace_source ? replace_toPlace : cur;
+}
 
 static void ReplaceCommand_Draw(IVec3 min, IVec3 max) {
-	BlockID cur, source, toPlace;
-	int x, y, z;
-
-	source  = (BlockID)replace_source;
-	toPlace = (BlockID)replace_target;
-	if (replace_target == -1) toPlace = Inventory_SelectedBlock;
-
-	for (y = min.y; y <= max.y; y++) {
-		for (z = min.z; z <= max.z; z++) {
-			for (x = min.x; x <= max.x; x++) {
-				cur = World_GetBlock(x, y, z);
-				if (cur != source) continue;
-				Game_ChangeBlock(x, y, z, toPlace);
-			}
-		}
-	}
+	replace_toPlace = (BlockID)replace_target;
+	if (replace_target == -1) replace_toPlace = Inventory_SelectedBlock;
+
+	Game_ChangeBlocks(min.x, min.y, min.z, max.x, max.y, max.z, ReplaceCommand_GetBlock);
 }
 
 static void ReplaceCommand_Execute(const cc_string* args, int argsCount) {
@@ -805,6 +989,9 @@ static void OnInit(void) {
 	Commands_Register(&TeleportCommand);
 	Commands_Register(&ClearDeniedCommand);
 	Commands_Register(&MotdCommand);
+	Commands_Register(&ProfileCommand);
+	Commands_Register(&MemCommand);
+	Commands_Register(&NetStatsCommand);
 	Commands_Register(&PlaceCommand);
 	Commands_Register(&BlockEditCommand);
 	Commands_Register(&CuboidCommand);
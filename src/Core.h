@@ -202,6 +202,7 @@ typedef cc_uint8  cc_bool;
 	#define CC_BUILD_ANDROID
 	#define CC_BUILD_MOBILE
 	#define CC_BUILD_POSIX
+	#define CC_BUILD_LOGRING
 	#define CC_BUILD_GLES
 	#define CC_BUILD_EGL
 	#define CC_BUILD_TOUCH
@@ -351,7 +352,13 @@ typedef cc_uint8  cc_bool;
 	#define CC_BUILD_WEBAUDIO
 	#define CC_BUILD_NOMUSIC
 	#define CC_BUILD_MINFILES
-	#define CC_BUILD_COOPTHREADED
+	#ifdef __EMSCRIPTEN_PTHREADS__
+		/* Opt-in build (make web-threads) - compute work runs on Web Workers */
+		/* NOTE: Requires the page to be served with COOP/COEP headers, see doc/hosting-webclient.md */
+		#define CC_BUILD_WEBTHREADS
+	#else
+		#define CC_BUILD_COOPTHREADED
+	#endif
 	#undef  CC_BUILD_FREETYPE
 	#undef  CC_BUILD_RESOURCES
 	#undef  CC_BUILD_PLUGINS
@@ -453,6 +460,7 @@ typedef cc_uint8  cc_bool;
 #elif defined __SWITCH__
 	#define CC_BUILD_SWITCH
 	#define CC_BUILD_CONSOLE
+	#define CC_BUILD_LOGRING
 	#define CC_BUILD_TOUCH
 	#define CC_BUILD_GLES
 	#define CC_BUILD_EGL
@@ -549,6 +557,13 @@ typedef cc_uint8  cc_bool;
 #ifndef CC_BUILD_LOWMEM
 #define EXTENDED_BLOCKS
 #endif
+#if (defined CC_BUILD_POSIX && !defined CC_BUILD_OS2) || (defined CC_BUILD_WIN && !defined CC_BUILD_UWP)
+#define CC_BUILD_FILEMAP
+#endif
+/* Paged world storage is built on top of brick world storage */
+#if defined CC_BUILD_PAGEDWORLD && !defined CC_BUILD_BRICKWORLD
+#define CC_BUILD_BRICKWORLD
+#endif
 #ifndef CC_BUILD_TINYMEM
 #define EXTENDED_TEXTURES
 #endif
@@ -161,8 +161,6 @@ enum INFLATE_STATE_ {
 #define Inflate_AlignBits(state) cc_uint32 alignSkip = state->NumBits & 7; Inflate_ConsumeBits(state, alignSkip);
 /* Ensures there are 'bitsCount' bits, or returns if not */
 #define Inflate_EnsureBits(state, bitsCount) while (state->NumBits < bitsCount) { if (!state->AvailIn) return; Inflate_GetByte(state); }
-/* Ensures there are 'bitsCount' bits */
-#define Inflate_UNSAFE_EnsureBits(state, bitsCount) while (state->NumBits < bitsCount) { Inflate_GetByte(state); }
 /* Peeks then consumes given bits */
 #define Inflate_ReadBits(state, bitsCount) Inflate_PeekBits(state, bitsCount); Inflate_ConsumeBits(state, bitsCount);
 /* Sets to given result and sets state to DONE */
@@ -174,8 +172,9 @@ enum INFLATE_STATE_ {
 #define Inflate_NextCompressState(state) ((state->AvailIn >= INFLATE_FASTINF_IN && state->AvailOut >= INFLATE_FASTINF_OUT) ? INFLATE_STATE_FASTCOMPRESSED : INFLATE_STATE_COMPRESSED_LIT)
 /* The maximum amount of bytes that can be output is 258 */
 #define INFLATE_FASTINF_OUT 258
-/* The most input bytes required for huffman codes and extra data is 16 + 5 + 16 + 13 bits. Add 3 extra bytes to account for putting data into the bit buffer. */
-#define INFLATE_FASTINF_IN 10
+/* The most input bytes required for huffman codes and extra data is 16 + 5 + 16 + 13 bits. */
+/* The fast path may also read up to 8 bytes ahead into its bit buffer, so round up to 16 bytes. */
+#define INFLATE_FASTINF_IN 16
 
 static cc_uint32 Huffman_ReverseBits(cc_uint32 n, cc_uint8 bits) {
 	n = ((n & 0xAAAA) >> 1) | ((n & 0x5555) << 1);
@@ -306,43 +305,25 @@ static int Huffman_Decode(struct InflateState* state, struct HuffmanTable* table
 	return -1;
 }
 
-/* Inline the common <= 9 bits case */
-#define Huffman_UNSAFE_Decode(state, table, result) \
-{\
-	Inflate_UNSAFE_EnsureBits(state, INFLATE_MAX_BITS);\
-	packed = table.fast[Inflate_PeekBits(state, INFLATE_FAST_BITS)];\
-	if (packed >= 0) {\
-		consumedBits = packed >> INFLATE_FAST_BITS;\
-		Inflate_ConsumeBits(state, consumedBits);\
-		result = packed & 0x1FF;\
-	} else {\
-		result = Huffman_UNSAFE_Decode_Slow(state, &table);\
-	}\
-}
-
-static int Huffman_UNSAFE_Decode_Slow(struct InflateState* state, struct HuffmanTable* table) {
-	cc_uint32 i, j, codeword;
+/* Decodes a codeword longer than INFLATE_FAST_BITS, using the given bits from the stream */
+/* Returns the codeword length in bits, or 0 if the codeword is invalid */
+static int Huffman_DecodeSlow(struct HuffmanTable* table, cc_uint32 bits, int* value) {
+	cc_uint32 i, codeword;
 	int offset;
 
 	/* Slow, bit by bit lookup. Need to reverse order for huffman. */
-	codeword = Inflate_PeekBits(state,       INFLATE_FAST_BITS);
-	codeword = Huffman_ReverseBits(codeword, INFLATE_FAST_BITS);
+	codeword = Huffman_ReverseBits(bits & ((1UL << INFLATE_FAST_BITS) - 1UL), INFLATE_FAST_BITS);
+	bits   >>= INFLATE_FAST_BITS;
 
-	for (i = INFLATE_FAST_BITS + 1, j = INFLATE_FAST_BITS; i < INFLATE_MAX_BITS; i++, j++) {
-		codeword = (codeword << 1) | ((state->Bits >> j) & 1);
+	for (i = INFLATE_FAST_BITS + 1; i < INFLATE_MAX_BITS; i++, bits >>= 1) {
+		codeword = (codeword << 1) | (bits & 1);
 
 		if (codeword < table->endCodewords[i]) {
 			offset = table->firstOffsets[i] + (codeword - table->firstCodewords[i]);
-			Inflate_ConsumeBits(state, i);
-			return table->values[offset];
+			*value = table->values[offset];
+			return i;
 		}
 	}
-
-	Inflate_Fail(state, INF_ERR_INVALID_CODE);
-	/* Need to exit the fast decode loop */
-	/* TODO: This means a few garbage bytes can get written */
-	/* to the output, but it probably doesn't matter */
-	state->AvailIn = 0;
 	return 0;
 }
 
@@ -399,30 +380,73 @@ static const cc_uint8 codelens_order[INFLATE_MAX_CODELENS] = {
 	16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 
 };
 
+/* The fast path keeps the bit buffer in a local machine word, which the compiler can keep in a register */
+/*  (instead of reloading state->Bits after every write to the window) */
+typedef cc_uintptr Inflate_BitBuffer;
+#define INFLATE_FAST_BUFBITS (sizeof(Inflate_BitBuffer) * 8)
+
+/* Tops up the bit buffer with as many whole bytes as will fit */
+#define Fast_Refill() while (bitCount <= INFLATE_FAST_BUFBITS - 8) { bitBuf |= (Inflate_BitBuffer)(*in++) << bitCount; bitCount += 8; }
+/* Ensures there are 'count' bits in the bit buffer */
+/* NOTE: With a 64 bit bit buffer, one refill covers a whole length + distance pair */
+#define Fast_Ensure(count) if (bitCount < (count)) { Fast_Refill(); }
+#define Fast_PeekBits(count) (cc_uint32)(bitBuf & (((Inflate_BitBuffer)1 << (count)) - 1))
+#define Fast_ConsumeBits(count) bitBuf >>= (count); bitCount -= (count);
+
+/* Inline the common <= 9 bits case */
+#define Fast_Decode(table, result) \
+{\
+	Fast_Ensure(INFLATE_MAX_BITS);\
+	packed = table.fast[Fast_PeekBits(INFLATE_FAST_BITS)];\
+	if (packed >= 0) {\
+		consumedBits = packed >> INFLATE_FAST_LEN_SHIFT;\
+		result = packed & INFLATE_FAST_VAL_MASK;\
+	} else {\
+		consumedBits = Huffman_DecodeSlow(&table, Fast_PeekBits(INFLATE_MAX_BITS), &packed);\
+		if (!consumedBits) { Inflate_Fail(s, INF_ERR_INVALID_CODE); break; }\
+		result = packed;\
+	}\
+	Fast_ConsumeBits(consumedBits);\
+}
+
 static void Inflate_InflateFast(struct InflateState* s) {
 	/* huffman variables */
 	cc_uint32 lit, len, dist;
 	cc_uint32 bits, lenIdx, distIdx;
 	int packed, consumedBits;
 
+	/* bit buffer variables */
+	Inflate_BitBuffer bitBuf;
+	cc_uint32 bitCount, ahead;
+	cc_uint8* in;
+	cc_uint8* inEnd;
+
 	/* window variables */
 	cc_uint8* window;
+	cc_uint8* src;
+	cc_uint8* dst;
 	cc_uint32 i, curIdx, startIdx;
-	cc_uint32 copyStart, copyLen, partLen;
+	cc_uint32 copyStart, copyLen, partLen, availOut;
 
 	window = s->Window;
 	curIdx = s->WindowIndex;
 	copyStart = s->WindowIndex;
 	copyLen   = 0;
+	availOut  = s->AvailOut;
+
+	bitBuf   = s->Bits;
+	bitCount = s->NumBits;
+	in       = s->NextIn;
+	inEnd    = s->NextIn + s->AvailIn;
 
 #define INFLATE_FAST_COPY_MAX (INFLATE_WINDOW_SIZE - INFLATE_FASTINF_OUT)
-	while (s->AvailOut >= INFLATE_FASTINF_OUT && s->AvailIn >= INFLATE_FASTINF_IN && copyLen < INFLATE_FAST_COPY_MAX) {
-		Huffman_UNSAFE_Decode(s, s->Table.Lits, lit);
+	while (availOut >= INFLATE_FASTINF_OUT && (cc_uint32)(inEnd - in) >= INFLATE_FASTINF_IN && copyLen < INFLATE_FAST_COPY_MAX) {
+		Fast_Decode(s->Table.Lits, lit);
 
 		if (lit <= 256) {
 			if (lit < 256) {
 				window[curIdx] = (cc_uint8)lit;
-				s->AvailOut--; copyLen++;
+				availOut--; copyLen++;
 				curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
 			} else {
 				s->State = Inflate_NextBlockState(s);
@@ -431,35 +455,60 @@ static void Inflate_InflateFast(struct InflateState* s) {
 		} else {
 			lenIdx = lit - 257;
 			bits = len_bits[lenIdx];
-			Inflate_UNSAFE_EnsureBits(s, bits);
-			len  = len_base[lenIdx] + Inflate_ReadBits(s, bits);
+			Fast_Ensure(bits);
+			len  = len_base[lenIdx] + Fast_PeekBits(bits);
+			Fast_ConsumeBits(bits);
 
-			Huffman_UNSAFE_Decode(s, s->TableDists, distIdx);
+			Fast_Decode(s->TableDists, distIdx);
 			bits = dist_bits[distIdx];
-			Inflate_UNSAFE_EnsureBits(s, bits);
-			dist = dist_base[distIdx] + Inflate_ReadBits(s, bits);
+			Fast_Ensure(bits);
+			dist = dist_base[distIdx] + Fast_PeekBits(bits);
+			Fast_ConsumeBits(bits);
 	
 			/* Window infinitely repeats like ...xyz|uvwxyz|uvwxyz|uvw... */
 			/* If start and end don't cross a boundary, can avoid masking index */
 			startIdx = (curIdx - dist) & INFLATE_WINDOW_MASK;
 			if (curIdx >= startIdx && (curIdx + len) < INFLATE_WINDOW_SIZE) {
-				cc_uint8* src = &window[startIdx]; 
-				cc_uint8* dst = &window[curIdx];
-
-				for (i = 0; i < (len & ~0x3); i += 4) {
-					*dst++ = *src++; *dst++ = *src++; *dst++ = *src++; *dst++ = *src++;
+				src = &window[startIdx]; 
+				dst = &window[curIdx];
+
+				if (dist == 1 && len >= 16) {
+					/* Run of the same byte (very common in map data) */
+					Mem_Set(dst, *src, len);
+				} else if (dist >= len && len >= 16) {
+					/* Source and destination don't overlap */
+					Mem_Copy(dst, src, len);
+				} else {
+					for (i = 0; i < (len & ~0x3); i += 4) {
+						*dst++ = *src++; *dst++ = *src++; *dst++ = *src++; *dst++ = *src++;
+					}
+					for (; i < len; i++) { *dst++ = *src++; }
 				}
-				for (; i < len; i++) { *dst++ = *src++; }
 			} else {
 				for (i = 0; i < len; i++) {
 					window[(curIdx + i) & INFLATE_WINDOW_MASK] = window[(startIdx + i) & INFLATE_WINDOW_MASK];
 				}
 			}
 			curIdx = (curIdx + len) & INFLATE_WINDOW_MASK;
-			s->AvailOut -= len; copyLen += len;
+			availOut -= len; copyLen += len;
 		}
 	}
 
+	/* Give back whole bytes that were read into the bit buffer, but not consumed yet */
+	/* (only bytes read during this call are still guaranteed to be in the input buffer) */
+	ahead = min(bitCount >> 3, (cc_uint32)(in - s->NextIn));
+	if (ahead) {
+		in       -= ahead;
+		bitCount -= ahead << 3;
+		bitBuf   &= ((Inflate_BitBuffer)1 << bitCount) - 1;
+	}
+
+	s->Bits     = (cc_uint32)bitBuf;
+	s->NumBits  = bitCount;
+	s->AvailIn -= (cc_uint32)(in - s->NextIn);
+	s->NextIn   = in;
+	s->AvailOut = availOut;
+
 	s->WindowIndex = curIdx;
 	if (!copyLen) return;
 
@@ -741,6 +790,8 @@ void Inflate_Process(struct InflateState* s) {
 	}
 }
 
+cc_bool Inflate_IsDone(struct InflateState* s) { return s->State == INFLATE_STATE_DONE; }
+
 static cc_result Inflate_StreamRead(struct Stream* stream, cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
 	struct InflateState* state;
 	cc_uint8* inputEnd;
@@ -788,6 +839,168 @@ void Inflate_MakeStream2(struct Stream* stream, struct InflateState* state, stru
 	stream->Read = Inflate_StreamRead;
 }
 
+/*########################################################################################################################*
+*---------------------------------------------------Inflate (to buffer)---------------------------------------------------*
+*#########################################################################################################################*/
+/* Same as the Fast_ bit buffer macros, except reads past the end of the input as 0 bits */
+#define Direct_Refill() while (bitCount <= INFLATE_FAST_BUFBITS - 8) { bitBuf |= (Inflate_BitBuffer)(inPos < srcLen ? src[inPos] : 0) << bitCount; inPos++; bitCount += 8; }
+#define Direct_Ensure(count) if (bitCount < (count)) { Direct_Refill(); }
+#define Direct_PeekBits(count) (cc_uint32)(bitBuf & (((Inflate_BitBuffer)1 << (count)) - 1))
+#define Direct_ConsumeBits(count) bitBuf >>= (count); bitCount -= (count);
+/* Whether any of the bits consumed so far were past the end of the input */
+#define Direct_Overran() (inPos - (bitCount >> 3) > srcLen)
+
+#define Direct_Decode(table, result) \
+{\
+	Direct_Ensure(INFLATE_MAX_BITS);\
+	packed = (table)->fast[Direct_PeekBits(INFLATE_FAST_BITS)];\
+	if (packed >= 0) {\
+		consumedBits = packed >> INFLATE_FAST_LEN_SHIFT;\
+		result = packed & INFLATE_FAST_VAL_MASK;\
+	} else {\
+		consumedBits = Huffman_DecodeSlow(table, Direct_PeekBits(INFLATE_MAX_BITS), &packed);\
+		if (!consumedBits) return INF_ERR_INVALID_CODE;\
+		result = packed;\
+	}\
+	Direct_ConsumeBits(consumedBits);\
+}
+
+cc_result Inflate_ToBuffer(const cc_uint8* src, cc_uint32 srcLen, cc_uint8* dst, cc_uint32 dstLen) {
+	/* Code lengths table is only needed before the literals table is built */
+	struct HuffmanTable lits, dists;
+	cc_uint8 lens[INFLATE_MAX_LITS_DISTS];
+	Inflate_BitBuffer bitBuf = 0;
+	cc_uint32 bitCount = 0, inPos = 0;
+	cc_uint8* out    = dst;
+	cc_uint8* outEnd = dst + dstLen;
+	cc_uint8* copySrc;
+
+	cc_uint32 header, len, nlen, dist, bits, i;
+	cc_uint32 numLits, numDists, numCodeLens, count;
+	int lit, packed, consumedBits;
+	cc_bool lastBlock;
+	cc_result res;
+
+	do {
+		Direct_Ensure(3);
+		header    = Direct_PeekBits(3);
+		lastBlock = header & 1;
+		Direct_ConsumeBits(3);
+
+		switch (header >> 1) {
+		case 0: /* Uncompressed block */
+			Direct_ConsumeBits(bitCount & 7);
+			Direct_Ensure(32);
+			len  = Direct_PeekBits(16); Direct_ConsumeBits(16);
+			nlen = Direct_PeekBits(16); Direct_ConsumeBits(16);
+			if (len != (nlen ^ 0xFFFFUL)) return INF_ERR_LEN_VERIFY;
+
+			/* Give back the whole bytes still in the bit buffer, then copy directly from input */
+			inPos   -= bitCount >> 3;
+			bitBuf   = 0;
+			bitCount = 0;
+
+			if (inPos > srcLen || len > srcLen - inPos) return ERR_END_OF_STREAM;
+			if (len > (cc_uint32)(outEnd - out))       return INF_ERR_OUTPUT_SIZE;
+			Mem_Copy(out, src + inPos, len);
+			out += len; inPos += len;
+			continue;
+
+		case 1: /* Fixed/static huffman compressed */
+			(void)Huffman_Build(&lits,  fixed_lits,  INFLATE_MAX_LITS);
+			(void)Huffman_Build(&dists, fixed_dists, INFLATE_MAX_DISTS);
+			break;
+
+		case 2: /* Dynamic huffman compressed */
+			Direct_Ensure(14);
+			numLits     = 257 + Direct_PeekBits(5); Direct_ConsumeBits(5);
+			numDists    = 1   + Direct_PeekBits(5); Direct_ConsumeBits(5);
+			numCodeLens = 4   + Direct_PeekBits(4); Direct_ConsumeBits(4);
+
+			for (i = 0; i < INFLATE_MAX_CODELENS; i++) lens[i] = 0;
+			for (i = 0; i < numCodeLens; i++) 
+			{
+				Direct_Ensure(3);
+				lens[codelens_order[i]] = Direct_PeekBits(3);
+				Direct_ConsumeBits(3);
+			}
+			if ((res = Huffman_Build(&lits, lens, INFLATE_MAX_CODELENS))) return res;
+
+			count = numLits + numDists;
+			for (i = 0; i < count; )
+			{
+				Direct_Decode(&lits, lit);
+				if (lit < 16) { lens[i++] = lit; continue; }
+
+				if (lit == 16) {
+					if (!i) return INF_ERR_REPEAT_BEG;
+					Direct_Ensure(2); len = 3  + Direct_PeekBits(2); Direct_ConsumeBits(2);
+					nlen = lens[i - 1];
+				} else if (lit == 17) {
+					Direct_Ensure(3); len = 3  + Direct_PeekBits(3); Direct_ConsumeBits(3);
+					nlen = 0;
+				} else {
+					Direct_Ensure(7); len = 11 + Direct_PeekBits(7); Direct_ConsumeBits(7);
+					nlen = 0;
+				}
+
+				if (i + len > count) return INF_ERR_REPEAT_END;
+				Mem_Set(&lens[i], nlen, len);
+				i += len;
+			}
+
+			if ((res = Huffman_Build(&lits,  lens,           numLits)))  return res;
+			if ((res = Huffman_Build(&dists, lens + numLits, numDists))) return res;
+			break;
+
+		default:
+			return INF_ERR_BLOCKTYPE;
+		}
+
+		/* The output itself is used as the window for LZ77 matches */
+		for (;;)
+		{
+			Direct_Decode(&lits, lit);
+			if (lit < 256) {
+				if (out == outEnd) return INF_ERR_OUTPUT_SIZE;
+				*out++ = (cc_uint8)lit;
+				continue;
+			}
+			if (lit == 256) break;
+
+			lit -= 257;
+			bits = len_bits[lit];
+			Direct_Ensure(bits);
+			len  = len_base[lit] + Direct_PeekBits(bits);
+			Direct_ConsumeBits(bits);
+
+			Direct_Decode(&dists, lit);
+			bits = dist_bits[lit];
+			Direct_Ensure(bits);
+			dist = dist_base[lit] + Direct_PeekBits(bits);
+			Direct_ConsumeBits(bits);
+
+			if (dist > (cc_uint32)(out - dst))    return INF_ERR_INVALID_CODE;
+			if (len  > (cc_uint32)(outEnd - out)) return INF_ERR_OUTPUT_SIZE;
+			copySrc = out - dist;
+
+			if (dist == 1) {
+				/* Run of the same byte (very common in map data) */
+				Mem_Set(out, *copySrc, len);
+			} else if (dist >= len) {
+				Mem_Copy(out, copySrc, len);
+			} else {
+				for (i = 0; i < len; i++) out[i] = copySrc[i];
+			}
+			out += len;
+		}
+		if (Direct_Overran()) return ERR_END_OF_STREAM;
+	} while (!lastBlock);
+
+	if (Direct_Overran()) return ERR_END_OF_STREAM;
+	return out == outEnd ? 0 : ERR_END_OF_STREAM;
+}
+
 
 /*########################################################################################################################*
 *---------------------------------------------------Deflate (compress)----------------------------------------------------*
@@ -808,8 +1021,6 @@ static const cc_uint16 deflate_dist[31] = {
 #define Deflate_PushBits(state, value, bits) state->Bits |= (value) << state->NumBits; state->NumBits += (bits);
 /* Pushes bits of the huffman codeword bits for the given literal, but does not write them */
 #define Deflate_PushLit(state, value) Deflate_PushBits(state, state->LitsCodewords[value], state->LitsLens[value])
-/* Pushes given bits (reversing for huffman code), but does not write them */
-#define Deflate_PushHuff(state, value, bits) Deflate_PushBits(state, Huffman_ReverseBits(value, bits), bits)
 /* Writes given byte to output */
 #define Deflate_WriteByte(state) *state->NextOut++ = state->Bits; state->AvailOut--; state->Bits >>= 8; state->NumBits -= 8;
 /* Flushes bits in buffer to output buffer */
@@ -830,6 +1041,26 @@ static cc_uint32 Deflate_Hash(cc_uint8* src) {
 	return (cc_uint32)((src[0] << 8) ^ (src[1] << 4) ^ (src[2])) & DEFLATE_HASH_MASK;
 }
 
+/* Constructs a huffman encoding table (for values to codewords) */
+static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
+	int i, j, offset, codeword;
+	struct HuffmanTable table;
+
+	/* NOTE: Can ignore since lens table is not user controlled */
+	(void)Huffman_Build(&table, lens, count);
+	for (i = 0; i < INFLATE_MAX_BITS; i++) {
+		if (!table.endCodewords[i]) continue;
+		count = table.endCodewords[i] - table.firstCodewords[i];
+
+		for (j = 0; j < count; j++) {
+			offset   = table.values[table.firstOffsets[i] + j];
+			codeword = table.firstCodewords[i] + j;
+			bitlens[offset]   = i;
+			codewords[offset] = Huffman_ReverseBits(codeword, i);
+		}
+	}
+}
+
 /* Writes a literal to state->Output */
 static void Deflate_Lit(struct DeflateState* state, int lit) {
 	Deflate_PushLit(state, lit);
@@ -847,11 +1078,235 @@ static void Deflate_LenDist(struct DeflateState* state, int len, int dist) {
 	Deflate_FlushBits(state);
 
 	for (j = 0; dist >= deflate_dist[j + 1]; j++);
-	Deflate_PushHuff(state, j, 5);
+	Deflate_PushBits(state, state->DistsCodewords[j], state->DistsLens[j]);
+	Deflate_FlushBits(state);
 	if (dist_bits[j]) { Deflate_PushBits(state, dist - deflate_dist[j], dist_bits[j]); }
 	Deflate_FlushBits(state);
 }
 
+/* Writes buffered output data to the destination stream */
+static cc_result Deflate_FlushOutput(struct DeflateState* state) {
+	cc_result res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
+	state->NextOut  = state->Output;
+	state->AvailOut = DEFLATE_OUT_SIZE;
+	return res;
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Deflate huffman codes--------------------------------------------------*
+*#########################################################################################################################*/
+/* Calculates optimal huffman code lengths in place, using the Moffat-Katajainen algorithm */
+/* NOTE: Frequencies must be sorted in ascending order, and are overwritten with code lengths */
+static void Huffman_CalcDepths(int* A, int n) {
+	int root, leaf, next, avail, used, depth;
+
+	/* First pass: Build tree, left to right */
+	A[0] += A[1]; root = 0; leaf = 2;
+	for (next = 1; next < n - 1; next++) {
+		if (leaf >= n || A[root] < A[leaf]) { A[next] = A[root]; A[root++] = next; }
+		else { A[next] = A[leaf++]; }
+
+		if (leaf >= n || (root < next && A[root] < A[leaf])) { A[next] += A[root]; A[root++] = next; }
+		else { A[next] += A[leaf++]; }
+	}
+
+	/* Second pass: Compute depths of internal nodes, right to left */
+	A[n - 2] = 0;
+	for (next = n - 3; next >= 0; next--) A[next] = A[A[next]] + 1;
+
+	/* Third pass: Compute depths of leaves, right to left */
+	avail = 1; used = depth = 0; root = n - 2; next = n - 1;
+	while (avail > 0) {
+		while (root >= 0 && A[root] == depth) { used++; root--; }
+		while (avail > used) { A[next--] = depth; avail--; }
+		avail = 2 * used; depth++; used = 0;
+	}
+}
+
+/* Calculates huffman code lengths for the given symbol frequencies, limiting lengths to at most 'maxBits' */
+static void Deflate_CalcLens(const cc_uint16* freqs, int count, int maxBits, cc_uint8* lens) {
+	int syms[INFLATE_MAX_LITS], depths[INFLATE_MAX_LITS], bl_count[INFLATE_MAX_LITS];
+	int i, j, k, n = 0;
+	cc_uint32 total;
+
+	/* Sort used symbols by ascending frequency */
+	for (i = 0; i < count; i++) {
+		lens[i] = 0;
+		if (!freqs[i]) continue;
+
+		for (j = n; j > 0 && freqs[syms[j - 1]] > freqs[i]; j--) syms[j] = syms[j - 1];
+		syms[j] = i; n++;
+	}
+
+	if (!n) return;
+	if (n == 1) { lens[syms[0]] = 1; return; }
+
+	for (i = 0; i < n; i++) depths[i] = freqs[syms[i]];
+	Huffman_CalcDepths(depths, n);
+
+	Mem_Set(bl_count, 0, sizeof(bl_count));
+	for (i = 0; i < n; i++) bl_count[depths[i]]++;
+
+	/* Move codewords that are too long up to maxBits, then keep */
+	/*  lengthening shorter codewords until the tree is valid again */
+	for (i = maxBits + 1; i < n; i++) { bl_count[maxBits] += bl_count[i]; }
+	for (i = maxBits, total = 0; i > 0; i--) { total += (cc_uint32)bl_count[i] << (maxBits - i); }
+
+	while (total != (1UL << maxBits)) {
+		bl_count[maxBits]--;
+		for (i = maxBits - 1; i > 0; i--) {
+			if (!bl_count[i]) continue;
+			bl_count[i]--; bl_count[i + 1] += 2; break;
+		}
+		total--;
+	}
+
+	/* Most frequent symbols get the shortest codewords */
+	for (i = 1, j = n; i <= maxBits; i++) {
+		for (k = bl_count[i]; k > 0; k--) lens[syms[--j]] = i;
+	}
+}
+
+static const cc_uint8 codelens_extra[3] = { 2, 3, 7 };
+
+/* Writes all queued symbols as a dynamic huffman block */
+static cc_result Deflate_WriteDynamicBlock(struct DeflateState* state, cc_bool final) {
+	cc_uint16 litFreqs[INFLATE_MAX_LITS], distFreqs[INFLATE_MAX_DISTS];
+	cc_uint16 clFreqs[INFLATE_MAX_CODELENS], clCodewords[INFLATE_MAX_CODELENS];
+	cc_uint8  litLens[INFLATE_MAX_LITS], distLens[INFLATE_MAX_DISTS], clLens[INFLATE_MAX_CODELENS];
+	cc_uint8  lens[INFLATE_MAX_LITS_DISTS], rleSyms[INFLATE_MAX_LITS_DISTS], rleExtra[INFLATE_MAX_LITS_DISTS];
+	int numLits, numDists, numCodeLens, numRle, total;
+	int i, j, len, dist, run, sym;
+	cc_result res;
+
+	Mem_Set(litFreqs,  0, sizeof(litFreqs));
+	Mem_Set(distFreqs, 0, sizeof(distFreqs));
+	Mem_Set(clFreqs,   0, sizeof(clFreqs));
+
+	for (i = 0; i < state->NumSyms; i++) {
+		len  = state->SymLits[i];
+		dist = state->SymDists[i];
+		if (!dist) { litFreqs[len]++; continue; }
+
+		for (j = 0; len  >= deflate_len[j + 1];  j++);
+		litFreqs[j + 257]++;
+		for (j = 0; dist >= deflate_dist[j + 1]; j++);
+		distFreqs[j]++;
+	}
+	litFreqs[256] = 1; /* end of block */
+
+	/* Lits 286/287 and dists 30/31 are never used */
+	Deflate_CalcLens(litFreqs,  INFLATE_MAX_LITS  - 2, 15, litLens);
+	Deflate_CalcLens(distFreqs, INFLATE_MAX_DISTS - 2, 15, distLens);
+	litLens[286]  = 0; litLens[287]  = 0;
+	distLens[30]  = 0; distLens[31]  = 0;
+	/* Block must still define at least one distance code */
+	if (!state->NumSyms || !distLens[0]) {
+		for (i = 0; i < INFLATE_MAX_DISTS && !distLens[i]; i++) { }
+		if (i == INFLATE_MAX_DISTS) distLens[0] = 1;
+	}
+
+	numLits  = INFLATE_MAX_LITS  - 2;
+	numDists = INFLATE_MAX_DISTS - 2;
+	while (numLits  > 257 && !litLens[numLits   - 1]) numLits--;
+	while (numDists > 1   && !distLens[numDists - 1]) numDists--;
+
+	Mem_Copy(lens,           litLens,  numLits);
+	Mem_Copy(lens + numLits, distLens, numDists);
+	total = numLits + numDists;
+
+	/* Run length encode the codeword lengths */
+	for (i = 0, numRle = 0; i < total; i += run, numRle++) {
+		len = lens[i];
+		for (run = 1; i + run < total && lens[i + run] == len; run++) { }
+
+		if (!len && run >= 11) {
+			run = min(run, 138);
+			rleSyms[numRle] = 18; rleExtra[numRle] = run - 11;
+		} else if (!len && run >= 3) {
+			rleSyms[numRle] = 17; rleExtra[numRle] = run - 3;
+		} else if (len && i && lens[i - 1] == len && run >= 3) {
+			run = min(run, 6);
+			rleSyms[numRle] = 16; rleExtra[numRle] = run - 3;
+		} else {
+			run = 1;
+			rleSyms[numRle] = len;
+		}
+		clFreqs[rleSyms[numRle]]++;
+	}
+
+	Deflate_CalcLens(clFreqs, INFLATE_MAX_CODELENS, 7, clLens);
+	numCodeLens = INFLATE_MAX_CODELENS;
+	while (numCodeLens > 4 && !clLens[codelens_order[numCodeLens - 1]]) numCodeLens--;
+
+	Deflate_BuildTable(clLens,   INFLATE_MAX_CODELENS, clCodewords,           clLens);
+	Deflate_BuildTable(litLens,  INFLATE_MAX_LITS,     state->LitsCodewords,  state->LitsLens);
+	Deflate_BuildTable(distLens, INFLATE_MAX_DISTS,    state->DistsCodewords, state->DistsLens);
+
+	/* Write block header */
+	Deflate_PushBits(state, final | (2 << 1), 3); /* block type DYNAMIC */
+	Deflate_PushBits(state, numLits  - 257, 5);
+	Deflate_PushBits(state, numDists - 1,   5);
+	Deflate_PushBits(state, numCodeLens - 4, 4);
+	Deflate_FlushBits(state);
+
+	for (i = 0; i < numCodeLens; i++) {
+		Deflate_PushBits(state, clLens[codelens_order[i]], 3);
+		Deflate_FlushBits(state);
+	}
+
+	for (i = 0; i < numRle; i++) {
+		sym = rleSyms[i];
+		Deflate_PushBits(state, clCodewords[sym], clLens[sym]);
+		if (sym >= 16) { Deflate_PushBits(state, rleExtra[i], codelens_extra[sym - 16]); }
+		Deflate_FlushBits(state);
+
+		if (state->AvailOut < 20 && (res = Deflate_FlushOutput(state))) return res;
+	}
+
+	/* Write block data */
+	for (i = 0; i < state->NumSyms; i++) {
+		len  = state->SymLits[i];
+		dist = state->SymDists[i];
+
+		if (dist) {
+			Deflate_LenDist(state, len, dist);
+		} else {
+			Deflate_Lit(state, len);
+		}
+		if (state->AvailOut < 20 && (res = Deflate_FlushOutput(state))) return res;
+	}
+
+	Deflate_Lit(state, 256);
+	state->NumSyms = 0;
+	return 0;
+}
+
+/* Writes a literal, or queues it for the next dynamic huffman block */
+static cc_result Deflate_AddLit(struct DeflateState* state, int lit) {
+	if (!state->Dynamic) { Deflate_Lit(state, lit); return 0; }
+
+	state->SymLits[state->NumSyms]  = lit;
+	state->SymDists[state->NumSyms] = 0;
+	if (++state->NumSyms < DEFLATE_MAX_SYMS) return 0;
+	return Deflate_WriteDynamicBlock(state, false);
+}
+
+/* Writes a length-distance pair, or queues it for the next dynamic huffman block */
+static cc_result Deflate_AddLenDist(struct DeflateState* state, int len, int dist) {
+	if (!state->Dynamic) { Deflate_LenDist(state, len, dist); return 0; }
+
+	state->SymLits[state->NumSyms]  = len;
+	state->SymDists[state->NumSyms] = dist;
+	if (++state->NumSyms < DEFLATE_MAX_SYMS) return 0;
+	return Deflate_WriteDynamicBlock(state, false);
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Deflate stream------------------------------------------------------*
+*#########################################################################################################################*/
 /* Moves "current block" to "previous block", adjusting state if needed. */
 static void Deflate_MoveBlock(struct DeflateState* state) {
 	int i;
@@ -877,9 +1332,10 @@ static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
 	cc_uint8* cur;
 	cc_result res;
 
-	if (!state->WroteHeader) {
+	if (!state->WroteHeader && !state->Dynamic) {
 		state->WroteHeader = true;
-		Deflate_PushBits(state, 3, 3); /* final block TRUE, block type FIXED */
+		/* final block TRUE (unless more data follows), block type FIXED */
+		Deflate_PushBits(state, state->Partial ? 2 : 3, 3);
 	}
 
 	/* Based off descriptions from http://www.gzip.org/algorithm.txt and
@@ -897,12 +1353,13 @@ static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
 		bestPos = 0;
 
 		/* Find longest match starting at this byte */
-		/* Only explore up to 5 previous matches, to avoid slow performance */
-		/* (i.e prefer quickly saving maps/screenshots to completely optimal filesize) */
+		/* Only explore up to MaxChain previous matches, to avoid slow performance */
+		/* (i.e by default prefer quickly saving maps/screenshots to completely optimal filesize) */
 		pos = state->Head[hash];
-		for (depth = 0; pos != 0 && depth < 5; depth++) {
+		for (depth = 0; pos != 0 && depth < state->MaxChain; depth++) {
 			matchLen = Deflate_MatchLen(&input[pos], cur, maxLen);
 			if (matchLen > bestLen) { bestLen = matchLen; bestPos = pos; }
+			if (matchLen == maxLen) break;
 			pos = state->Prev[pos];
 		}
 
@@ -914,12 +1371,12 @@ static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
 
 		/* Lazy evaluation: Find longest match starting at next byte */
 		/* If that's longer than the longest match at current byte, throwaway this match */
-		if (bestPos) {
+		if (bestPos && state->LazyMatch && bestLen < maxLen) {
 			nextHash = Deflate_Hash(cur + 1);
 			nextPos  = state->Head[nextHash];
 			maxLen   = min(len - 1, MAX_MATCH_LEN);
 
-			for (depth = 0; nextPos != 0 && depth < 5; depth++) {
+			for (depth = 0; nextPos != 0 && depth < state->MaxChain; depth++) {
 				matchLen = Deflate_MatchLen(&input[nextPos], cur + 1, maxLen);
 				if (matchLen > bestLen) { bestPos = 0; break; }
 				nextPos = state->Prev[nextPos];
@@ -927,31 +1384,26 @@ static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
 		}
 
 		if (bestPos) {
-			Deflate_LenDist(state, bestLen, pos - bestPos);
+			res = Deflate_AddLenDist(state, bestLen, pos - bestPos);
 			len -= bestLen; cur += bestLen;
 		} else {
-			Deflate_Lit(state, *cur);
+			res = Deflate_AddLit(state, *cur);
 			len--; cur++;
 		}
+		if (res) return res;
 
 		/* leave room for a few bytes and literals at end */
 		if (state->AvailOut >= 20) continue;
-		res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
-		state->NextOut  = state->Output;
-		state->AvailOut = DEFLATE_OUT_SIZE;
-		if (res) return res;
+		if ((res = Deflate_FlushOutput(state))) return res;
 	}
 
 	/* literals for last few bytes */
 	while (len > 0) {
-		Deflate_Lit(state, *cur);
+		if ((res = Deflate_AddLit(state, *cur))) return res;
 		len--; cur++;
 	}
 
-	res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
-	state->NextOut  = state->Output;
-	state->AvailOut = DEFLATE_OUT_SIZE;
-
+	res = Deflate_FlushOutput(state);
 	Deflate_MoveBlock(state);
 	return res;
 }
@@ -994,9 +1446,20 @@ static cc_result Deflate_StreamClose(struct Stream* stream) {
 	res   = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE);
 	if (res) return res;
 
-	/* Write huffman encoded "literal 256" to terminate symbols */
-	Deflate_PushLit(state, 256);
-	Deflate_FlushBits(state);
+	if (state->Dynamic) {
+		/* Remaining queued symbols become the final block */
+		res = Deflate_WriteDynamicBlock(state, !state->Partial);
+		if (res) return res;
+	} else {
+		/* Write huffman encoded "literal 256" to terminate symbols */
+		Deflate_PushLit(state, 256);
+		Deflate_FlushBits(state);
+	}
+	/* Empty stored block header, which is followed by padding to byte boundary */
+	if (state->Partial) {
+		Deflate_PushBits(state, 0, 3);
+		Deflate_FlushBits(state);
+	}
 
 	/* In case last byte still has a few extra bits */
 	if (state->NumBits) {
@@ -1004,27 +1467,15 @@ static cc_result Deflate_StreamClose(struct Stream* stream) {
 		Deflate_FlushBits(state);
 	}
 
-	return Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
-}
-
-/* Constructs a huffman encoding table (for values to codewords) */
-static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
-	int i, j, offset, codeword;
-	struct HuffmanTable table;
-
-	/* NOTE: Can ignore since lens table is not user controlled */
-	(void)Huffman_Build(&table, lens, count);
-	for (i = 0; i < INFLATE_MAX_BITS; i++) {
-		if (!table.endCodewords[i]) continue;
-		count = table.endCodewords[i] - table.firstCodewords[i];
-
-		for (j = 0; j < count; j++) {
-			offset   = table.values[table.firstOffsets[i] + j];
-			codeword = table.firstCodewords[i] + j;
-			bitlens[offset]   = i;
-			codewords[offset] = Huffman_ReverseBits(codeword, i);
-		}
+	if (state->Partial) {
+		if (state->AvailOut < 4 && (res = Deflate_FlushOutput(state))) return res;
+		/* Stored block LEN of 0, and NLEN (one's complement of LEN) */
+		state->NextOut[0] = 0x00; state->NextOut[1] = 0x00;
+		state->NextOut[2] = 0xFF; state->NextOut[3] = 0xFF;
+		state->NextOut += 4; state->AvailOut -= 4;
 	}
+
+	return Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
 }
 
 void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying) {
@@ -1042,12 +1493,43 @@ void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struc
 	state->AvailOut = DEFLATE_OUT_SIZE;
 	state->Dest     = underlying;
 	state->WroteHeader = false;
+	state->NumSyms     = 0;
+	state->Partial     = false;
 
 	Mem_Set(state->Head, 0, sizeof(state->Head));
 	Mem_Set(state->Prev, 0, sizeof(state->Prev));
-	Deflate_BuildTable(fixed_lits, INFLATE_MAX_LITS, state->LitsCodewords, state->LitsLens);
+	Deflate_BuildTable(fixed_lits,  INFLATE_MAX_LITS,  state->LitsCodewords,  state->LitsLens);
+	Deflate_BuildTable(fixed_dists, INFLATE_MAX_DISTS, state->DistsCodewords, state->DistsLens);
+	Deflate_SetLevel(state, DEFLATE_LEVEL_DEFAULT);
+}
+
+void Deflate_SetLevel(struct DeflateState* state, int level) {
+	state->MaxChain  = level == DEFLATE_LEVEL_FAST ? 1 : (level == DEFLATE_LEVEL_BEST ? 128 : 5);
+	state->LazyMatch = level != DEFLATE_LEVEL_FAST;
+	state->Dynamic   = level == DEFLATE_LEVEL_BEST;
 }
 
+void Deflate_SetDictionary(struct DeflateState* state, const cc_uint8* data, cc_uint32 len) {
+	cc_uint32 hash;
+	int pos, start;
+	if (len > DEFLATE_BLOCK_SIZE) { data += len - DEFLATE_BLOCK_SIZE; len = DEFLATE_BLOCK_SIZE; }
+
+	/* Dictionary goes at the end of the "previous block" */
+	start = DEFLATE_BLOCK_SIZE - len;
+	Mem_Copy(state->Input + start, data, len);
+
+	/* NOTE: position 0 is used to indicate no match, so can't be inserted */
+	for (pos = max(start, 1); pos <= DEFLATE_BLOCK_SIZE - MIN_MATCH_LEN; pos++)
+	{
+		hash = Deflate_Hash(state->Input + pos);
+		state->Prev[pos]  = state->Head[hash];
+		state->Head[hash] = pos;
+	}
+}
+
+void Deflate_SetPartial(struct DeflateState* state, cc_bool partial) {
+	state->Partial = partial;
+}
 
 /*########################################################################################################################*
 *-----------------------------------------------------GZip (compress)-----------------------------------------------------*
@@ -1065,15 +1547,8 @@ static cc_result GZip_StreamClose(struct Stream* stream) {
 
 static cc_result GZip_StreamWrite(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
 	struct GZipState* state = (struct GZipState*)stream->meta.inflate;
-	cc_uint32 i, crc32 = state->Crc32;
 	state->Size += count;
-
-	/* TODO: Optimise this calculation */
-	for (i = 0; i < count; i++) {
-		crc32 = Utils_Crc32Table[(crc32 ^ data[i]) & 0xFF] ^ (crc32 >> 8);
-	}
-
-	state->Crc32 = crc32;
+	state->Crc32 = Utils_CRC32Update(state->Crc32, data, count);
 	return Deflate_StreamWrite(stream, data, count, modified);
 }
 
@@ -1113,12 +1588,20 @@ static cc_result ZLib_StreamWrite(struct Stream* stream, const cc_uint8* data, c
 	struct ZLibState* state = (struct ZLibState*)stream->meta.inflate;
 	cc_uint32 i, adler32 = state->Adler32;
 	cc_uint32 s1 = adler32 & 0xFFFF, s2 = (adler32 >> 16) & 0xFFFF;
+	cc_uint32 j, len;
 
-	/* TODO: Optimise this calculation */
-	for (i = 0; i < count; i++) {
-		#define ADLER32_BASE 65521
-		s1 = (s1 + data[i]) % ADLER32_BASE;
-		s2 = (s2 + s1)      % ADLER32_BASE;
+	/* s2 can't overflow 32 bits within 5552 bytes, so the modulo only needs to be done once per block */
+	#define ADLER32_BASE  65521
+	#define ADLER32_BLOCK 5552
+	for (i = 0; i < count; i += len) {
+		len = min(count - i, ADLER32_BLOCK);
+
+		for (j = 0; j < len; j++) {
+			s1 += data[i + j];
+			s2 += s1;
+		}
+		s1 %= ADLER32_BASE;
+		s2 %= ADLER32_BASE;
 	}
 
 	state->Adler32 = (s2 << 16) | s1;
@@ -1163,6 +1646,8 @@ struct ZipState {
 	int totalEntries;
 	/* Offset to central directory entries */
 	cc_uint32 centralDirBeg;
+	/* Total size of the central directory entries */
+	cc_uint32 centralDirSize;
 };
 
 static cc_result Zip_ReadLocalFileHeader(struct ZipState* state, struct ZipEntry* entry) {
@@ -1225,35 +1710,46 @@ static cc_result Zip_ReadLocalFileHeader(struct ZipState* state, struct ZipEntry
 	return res;
 }
 
-static cc_result Zip_ReadCentralDirectory(struct ZipState* state) {
-	struct Stream* stream = state->source;
-	struct ZipEntry* entry;
-	cc_uint8 header[42];
-
-	cc_string path; char pathBuffer[ZIP_MAXNAMELEN];
+#define ZIP_CENTRALDIR_SIZE 42
+/* Reads the header and path of a central directory entry, then skips over the data following it */
+/* NOTE: pathBuffer must be at least ZIP_MAXNAMELEN in size */
+static cc_result Zip_ReadCentralDirHeader(struct Stream* stream, cc_uint8* header, cc_string* path, char* pathBuffer) {
 	int pathLen, extraLen, commentLen;
 	cc_result res;
 
-	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
+	if ((res = Stream_Read(stream, header, ZIP_CENTRALDIR_SIZE))) return res;
 	pathLen = Stream_GetU16_LE(&header[24]);
 	if (pathLen > ZIP_MAXNAMELEN) return ZIP_ERR_FILENAME_LEN;
 
 	/* NOTE: ZIP spec says path uses code page 437 for encoding */
-	path = String_Init(pathBuffer, pathLen, pathLen);
+	*path = String_Init(pathBuffer, pathLen, pathLen);
 	if ((res = Stream_Read(stream, (cc_uint8*)pathBuffer, pathLen))) return res;
 
 	/* skip data following central directory entry header */
 	extraLen   = Stream_GetU16_LE(&header[26]);
 	commentLen = Stream_GetU16_LE(&header[28]);
-	if ((res = stream->Skip(stream, extraLen + commentLen))) return res;
-
-	if (!state->SelectEntry(&path)) return 0;
-	if (state->usedEntries >= state->maxEntries) return ZIP_ERR_TOO_MANY_ENTRIES;
-	entry = &state->entries[state->usedEntries++];
+	return stream->Skip(stream, extraLen + commentLen);
+}
 
+static void Zip_ParseCentralDirHeader(struct ZipEntry* entry, const cc_uint8* header) {
+	entry->CRC32             = Stream_GetU32_LE(&header[12]);
 	entry->CompressedSize    = Stream_GetU32_LE(&header[16]);
 	entry->UncompressedSize  = Stream_GetU32_LE(&header[20]);
 	entry->LocalHeaderOffset = Stream_GetU32_LE(&header[38]);
+}
+
+static cc_result Zip_ReadCentralDirectory(struct ZipState* state) {
+	struct Stream* stream = state->source;
+	cc_uint8 header[ZIP_CENTRALDIR_SIZE];
+	cc_string path; char pathBuffer[ZIP_MAXNAMELEN];
+	cc_result res;
+
+	if ((res = Zip_ReadCentralDirHeader(stream, header, &path, pathBuffer))) return res;
+
+	if (!state->SelectEntry(&path)) return 0;
+	if (state->usedEntries >= state->maxEntries) return ZIP_ERR_TOO_MANY_ENTRIES;
+
+	Zip_ParseCentralDirHeader(&state->entries[state->usedEntries++], header);
 	return 0;
 }
 
@@ -1264,8 +1760,9 @@ static cc_result Zip_ReadEndOfCentralDirectory(struct ZipState* state) {
 	cc_result res;
 	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
 
-	state->totalEntries  = Stream_GetU16_LE(&header[6]);
-	state->centralDirBeg = Stream_GetU32_LE(&header[12]);
+	state->totalEntries   = Stream_GetU16_LE(&header[6]);
+	state->centralDirSize = Stream_GetU32_LE(&header[8]);
+	state->centralDirBeg  = Stream_GetU32_LE(&header[12]);
 	return 0;
 }
 
@@ -1275,9 +1772,9 @@ enum ZipSig {
 	ZIP_SIG_LOCALFILEHEADER = 0x04034b50
 };
 
-cc_result Zip_Extract(struct Stream* source, Zip_SelectEntry selector, Zip_ProcessEntry processor, 
-						struct ZipEntry* entries, int maxEntries) {
-	struct ZipState state;
+/* Finds and reads the end of central directory record, then seeks to the first central directory entry */
+static cc_result Zip_FindCentralDirectory(struct ZipState* state) {
+	struct Stream* source = state->source;
 	cc_uint32 stream_len;
 	cc_uint32 sig = 0;
 	int i, count;
@@ -1295,18 +1792,29 @@ cc_result Zip_Extract(struct Stream* source, Zip_SelectEntry selector, Zip_Proce
 		if (sig == ZIP_SIG_ENDOFCENTRALDIR) break;
 	}
 
+	if (sig != ZIP_SIG_ENDOFCENTRALDIR) return ZIP_ERR_NO_END_OF_CENTRAL_DIR;
+	res = Zip_ReadEndOfCentralDirectory(state);
+	if (res) return res;
+
+	res = source->Seek(source, state->centralDirBeg);
+	if (res) return ZIP_ERR_SEEK_CENTRAL_DIR;
+	return 0;
+}
+
+static cc_result Zip_DoExtract(struct Stream* source, Zip_SelectEntry selector, Zip_ProcessEntry processor, 
+						struct ZipEntry* entries, int maxEntries) {
+	struct ZipState state;
+	cc_uint32 sig = 0;
+	int i;
+
+	cc_result res;
 	state.source       = source;
 	state.SelectEntry  = selector;
 	state.ProcessEntry = processor;
 	state.entries      = entries;
 	state.maxEntries   = maxEntries;
 
-	if (sig != ZIP_SIG_ENDOFCENTRALDIR) return ZIP_ERR_NO_END_OF_CENTRAL_DIR;
-	res = Zip_ReadEndOfCentralDirectory(&state);
-	if (res) return res;
-
-	res = source->Seek(source, state.centralDirBeg);
-	if (res) return ZIP_ERR_SEEK_CENTRAL_DIR;
+	if ((res = Zip_FindCentralDirectory(&state))) return res;
 	state.usedEntries = 0;
 
 	/* Read all the central directory entries */
@@ -1337,3 +1845,343 @@ cc_result Zip_Extract(struct Stream* source, Zip_SelectEntry selector, Zip_Proce
 	}
 	return 0;
 }
+
+cc_result Zip_Extract(struct Stream* source, Zip_SelectEntry selector, Zip_ProcessEntry processor, 
+						struct ZipEntry* entries, int maxEntries) {
+	struct Stream buffered;
+	cc_uint8* buffer;
+	cc_result res;
+
+	/* Reading the central directory involves many small reads and seeks, */
+	/*  which are very slow when done directly against a file */
+	buffer = (cc_uint8*)Mem_TryAlloc(STREAM_FILE_BUFFER_SIZE, 1);
+	if (!buffer) return Zip_DoExtract(source, selector, processor, entries, maxEntries);
+
+	Stream_ReadonlyBuffered(&buffered, source, buffer, STREAM_FILE_BUFFER_SIZE);
+	res = Zip_DoExtract(&buffered, selector, processor, entries, maxEntries);
+
+	Mem_Free(buffer);
+	return res;
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------ZipIndex---------------------------------------------------------*
+*#########################################################################################################################*/
+/* Calculates a case insensitive hash of the given path */
+static cc_uint32 ZipIndex_Hash(const cc_string* path) {
+	cc_uint32 hash = 2166136261U;
+	char c;
+	int i;
+
+	for (i = 0; i < path->length; i++) 
+	{
+		c = path->buffer[i];
+		Char_MakeLower(c);
+		hash = (hash ^ (cc_uint8)c) * 16777619U;
+	}
+	return hash;
+}
+
+cc_result ZipIndex_Build(struct ZipIndex* index, struct Stream* source) {
+	struct ZipState state;
+	struct ZipIndexEntry* e;
+	cc_uint8 header[ZIP_CENTRALDIR_SIZE];
+	cc_string path; char pathBuffer[ZIP_MAXNAMELEN];
+	cc_uint32 sig, pathsLen = 0;
+	int i, bucket, buckets;
+	cc_result res;
+
+	Mem_Set(index, 0, sizeof(*index));
+	index->source = source;
+	state.source  = source;
+	if ((res = Zip_FindCentralDirectory(&state))) return res;
+
+	/* Use at least as many buckets as entries, so hash chains stay short */
+	for (buckets = 16; buckets < state.totalEntries; buckets <<= 1) { }
+
+	/* Paths are stored in the central directory, so in total can't be larger than it */
+	index->entries = (struct ZipIndexEntry*)Mem_TryAlloc(state.totalEntries + 1, sizeof(struct ZipIndexEntry));
+	index->paths   = (char*)Mem_TryAlloc(state.centralDirSize + 1, 1);
+	index->buckets = (int*)Mem_TryAlloc(buckets, sizeof(int));
+
+	if (!index->entries || !index->paths || !index->buckets) {
+		ZipIndex_Free(index); return ERR_OUT_OF_MEMORY;
+	}
+	for (i = 0; i < buckets; i++) index->buckets[i] = -1;
+	index->bucketsMask = buckets - 1;
+
+	for (i = 0; i < state.totalEntries; i++) 
+	{
+		if ((res = Stream_ReadU32_LE(source, &sig))) break;
+		if (sig == ZIP_SIG_ENDOFCENTRALDIR) break;
+		if (sig != ZIP_SIG_CENTRALDIR) { res = ZIP_ERR_INVALID_CENTRAL_DIR; break; }
+
+		if ((res = Zip_ReadCentralDirHeader(source, header, &path, pathBuffer))) break;
+		if (pathsLen + path.length > state.centralDirSize) { res = ZIP_ERR_INVALID_CENTRAL_DIR; break; }
+
+		e = &index->entries[index->count];
+		Zip_ParseCentralDirHeader(&e->data, header);
+		e->pathOffset = pathsLen;
+		e->pathLength = path.length;
+		Mem_Copy(index->paths + pathsLen, path.buffer, path.length);
+		pathsLen += path.length;
+
+		bucket  = ZipIndex_Hash(&path) & index->bucketsMask;
+		e->next = index->buckets[bucket];
+		index->buckets[bucket] = index->count++;
+	}
+
+	if (res) ZipIndex_Free(index);
+	return res;
+}
+
+int ZipIndex_Find(struct ZipIndex* index, const cc_string* path) {
+	cc_string entryPath;
+	int i;
+	if (!index->buckets) return -1;
+
+	for (i = index->buckets[ZipIndex_Hash(path) & index->bucketsMask]; i >= 0; i = index->entries[i].next)
+	{
+		entryPath = ZipIndex_GetPath(index, i);
+		if (String_CaselessEquals(&entryPath, path)) return i;
+	}
+	return -1;
+}
+
+cc_string ZipIndex_GetPath(struct ZipIndex* index, int i) {
+	struct ZipIndexEntry* e = &index->entries[i];
+	return String_Init(index->paths + e->pathOffset, e->pathLength, e->pathLength);
+}
+
+static cc_bool ZipIndex_SelectEntry(const cc_string* path) { return true; }
+cc_result ZipIndex_Extract(struct ZipIndex* index, int i, Zip_ProcessEntry processor) {
+	struct Stream* source = index->source;
+	struct ZipState state;
+	cc_uint32 sig = 0;
+	cc_result res;
+
+	state.source       = source;
+	state.SelectEntry  = ZipIndex_SelectEntry;
+	state.ProcessEntry = processor;
+
+	res = source->Seek(source, index->entries[i].data.LocalHeaderOffset);
+	if (res) return ZIP_ERR_SEEK_LOCAL_DIR;
+
+	if ((res = Stream_ReadU32_LE(source, &sig))) return res;
+	if (sig != ZIP_SIG_LOCALFILEHEADER) return ZIP_ERR_INVALID_LOCAL_DIR;
+
+	return Zip_ReadLocalFileHeader(&state, &index->entries[i].data);
+}
+
+cc_result ZipIndex_ReadCompressed(struct ZipIndex* index, int i, cc_uint8** data, cc_uint32* size, int* method) {
+	struct Stream* source  = index->source;
+	struct ZipEntry* entry = &index->entries[i].data;
+	cc_uint8 header[26];
+	cc_uint32 sig = 0, len;
+	int pathLen, extraLen;
+	cc_result res;
+	*data = NULL;
+
+	res = source->Seek(source, entry->LocalHeaderOffset);
+	if (res) return ZIP_ERR_SEEK_LOCAL_DIR;
+
+	if ((res = Stream_ReadU32_LE(source, &sig))) return res;
+	if (sig != ZIP_SIG_LOCALFILEHEADER) return ZIP_ERR_INVALID_LOCAL_DIR;
+	if ((res = Stream_Read(source, header, sizeof(header)))) return res;
+
+	/* skip over path and extra data */
+	pathLen  = Stream_GetU16_LE(&header[22]);
+	extraLen = Stream_GetU16_LE(&header[24]);
+	if ((res = source->Skip(source, pathLen + extraLen))) return res;
+
+	/* Some .zip files don't set these in local file header */
+	*method = Stream_GetU16_LE(&header[4]);
+	if (*method == 0) {
+		len = Stream_GetU32_LE(&header[18]);
+		if (!len) len = entry->UncompressedSize;
+	} else {
+		len = Stream_GetU32_LE(&header[14]);
+		if (!len) len = entry->CompressedSize;
+	}
+
+	*data = (cc_uint8*)Mem_TryAlloc(len + 1, 1);
+	if (!*data) return ERR_OUT_OF_MEMORY;
+
+	if ((res = Stream_Read(source, *data, len))) {
+		Mem_Free(*data); *data = NULL; return res;
+	}
+	*size = len;
+	return 0;
+}
+
+void ZipIndex_Free(struct ZipIndex* index) {
+	Mem_Free(index->entries);
+	Mem_Free(index->paths);
+	Mem_Free(index->buckets);
+
+	index->entries = NULL;
+	index->paths   = NULL;
+	index->buckets = NULL;
+	index->count   = 0;
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------ZipStreamReader-----------------------------------------------------*
+*#########################################################################################################################*/
+#define ZIP_LOCALHEADER_SIZE 30
+#define ZIP_FLAG_DATA_DESCRIPTOR 0x08
+
+void ZipStream_Init(struct ZipStreamState* state, Zip_SelectEntry selector, Zip_ProcessEntry processor) {
+	state->SelectEntry  = selector;
+	state->ProcessEntry = processor;
+	state->buffer   = NULL;
+	state->length   = 0;
+	state->capacity = 0;
+	state->skipLeft = 0;
+	state->offset   = 0;
+	state->done     = false;
+}
+
+void ZipStream_Free(struct ZipStreamState* state) {
+	Mem_Free(state->buffer);
+	state->buffer   = NULL;
+	state->length   = 0;
+	state->capacity = 0;
+}
+
+static cc_result ZipStream_Buffer(struct ZipStreamState* state, const cc_uint8* data, cc_uint32 len) {
+	cc_uint32 required = state->length + len;
+	cc_uint8* ptr;
+
+	if (required > state->capacity) {
+		required = max(required, state->capacity * 2);
+		if (state->buffer) {
+			ptr = (cc_uint8*)Mem_TryRealloc(state->buffer, required, 1);
+		} else {
+			ptr = (cc_uint8*)Mem_TryAlloc(required, 1);
+		}
+
+		if (!ptr) return ERR_OUT_OF_MEMORY;
+		state->buffer   = ptr;
+		state->capacity = required;
+	}
+
+	Mem_Copy(state->buffer + state->length, data, len);
+	state->length += len;
+	return 0;
+}
+
+/* Processes the local file entry at the start of the buffered data, if all of it has been buffered */
+/* used is set to number of bytes consumed, which is 0 if the entry isn't fully buffered yet */
+static cc_result ZipStream_ReadEntry(struct ZipStreamState* state, cc_uint32* used) {
+	cc_uint8* header = state->buffer;
+	cc_uint32 avail  = state->length;
+	cc_uint32 compressedSize, uncompressedSize, dataLen, totalLen;
+	int flags, method, pathLen, extraLen;
+	struct Stream portion, compStream;
+	struct ZipEntry entry;
+	cc_string path;
+#ifdef CC_BUILD_SMALLSTACK
+	struct InflateState* inflate;
+#else
+	struct InflateState inflate;
+#endif
+	cc_uint32 sig;
+	cc_result res;
+
+	*used = 0;
+	if (avail < 4) return 0;
+	sig = Stream_GetU32_LE(header);
+
+	/* Central directory is located after all the local file entries */
+	if (sig == ZIP_SIG_CENTRALDIR || sig == ZIP_SIG_ENDOFCENTRALDIR) {
+		state->done = true; return 0;
+	}
+	if (sig != ZIP_SIG_LOCALFILEHEADER) return ZIP_ERR_INVALID_LOCAL_DIR;
+	if (avail < ZIP_LOCALHEADER_SIZE)   return 0;
+
+	flags            = Stream_GetU16_LE(&header[6]);
+	method           = Stream_GetU16_LE(&header[8]);
+	compressedSize   = Stream_GetU32_LE(&header[18]);
+	uncompressedSize = Stream_GetU32_LE(&header[22]);
+	pathLen          = Stream_GetU16_LE(&header[26]);
+	extraLen         = Stream_GetU16_LE(&header[28]);
+
+	/* Size of entry data is then only known after reading all of it */
+	if (flags & ZIP_FLAG_DATA_DESCRIPTOR) return ZIP_ERR_DATA_DESCRIPTOR;
+	if (pathLen > ZIP_MAXNAMELEN)         return ZIP_ERR_FILENAME_LEN;
+
+	dataLen  = method == 0 ? uncompressedSize : compressedSize;
+	totalLen = ZIP_LOCALHEADER_SIZE + pathLen + extraLen + dataLen;
+	if (avail < ZIP_LOCALHEADER_SIZE + pathLen + extraLen) return 0;
+
+	/* NOTE: ZIP spec says path uses code page 437 for encoding */
+	path = String_Init((char*)&header[ZIP_LOCALHEADER_SIZE], pathLen, pathLen);
+	if (!state->SelectEntry(&path)) {
+		/* Skip over the entry's data as it arrives, instead of buffering it */
+		*used = min(avail, totalLen);
+		state->skipLeft = totalLen - *used;
+		return 0;
+	}
+	if (avail < totalLen) return 0;
+
+	entry.CRC32             = Stream_GetU32_LE(&header[14]);
+	entry.CompressedSize    = compressedSize;
+	entry.UncompressedSize  = uncompressedSize;
+	entry.LocalHeaderOffset = state->offset;
+	Stream_ReadonlyMemory(&portion, &header[totalLen - dataLen], dataLen);
+	*used = totalLen;
+
+	if (method == 0) {
+		res = state->ProcessEntry(&path, &portion, &entry);
+	} else if (method == 8) {
+#ifdef CC_BUILD_SMALLSTACK
+		inflate = Mem_TryAlloc(1, sizeof(struct InflateState));
+		if (!inflate) return ERR_OUT_OF_MEMORY;
+
+		Inflate_MakeStream2(&compStream, inflate, &portion);
+		res = state->ProcessEntry(&path, &compStream, &entry);
+		Mem_Free(inflate);
+#else
+		Inflate_MakeStream2(&compStream, &inflate, &portion);
+		res = state->ProcessEntry(&path, &compStream, &entry);
+#endif
+	} else {
+		Platform_Log1("Unsupported.zip entry compression method: %i", &method);
+		res = 0;
+	}
+	return res;
+}
+
+cc_result ZipStream_Append(struct ZipStreamState* state, const cc_uint8* data, cc_uint32 len) {
+	cc_uint32 skip, used;
+	cc_result res;
+
+	while (len && !state->done) 
+	{
+		if (state->skipLeft) {
+			skip = min(len, state->skipLeft);
+			state->skipLeft -= skip;
+			state->offset   += skip;
+			data += skip; len -= skip;
+			continue;
+		}
+
+		if ((res = ZipStream_Buffer(state, data, len))) return res;
+		len = 0;
+
+		/* Process all the entries that have now been fully buffered */
+		while (!state->skipLeft)
+		{
+			if ((res = ZipStream_ReadEntry(state, &used))) return res;
+			if (!used) break;
+
+			state->length -= used;
+			state->offset += used;
+			Mem_Move(state->buffer, state->buffer + used, state->length);
+		}
+	}
+	return 0;
+}
@@ -78,10 +78,15 @@ CC_API void Inflate_Init2(struct InflateState* state, struct Stream* source);
 /* Attempts to decompress as much of the currently pending data as possible. */
 /* NOTE: This is a low level call - usually you treat as a stream via Inflate_MakeStream. */
 void Inflate_Process(struct InflateState* s);
+/* Whether the end of the DEFLATE compressed data was reached, or an error occurred (see result) */
+cc_bool Inflate_IsDone(struct InflateState* s);
 /* Deompresses input data read from another stream using DEFLATE. Read only stream. */
 /* NOTE: This only uncompresses pure DEFLATE compressed data. */
 /* If data starts with a GZIP or ZLIB header, use GZipHeader_Read or ZLibHeader_Read to first skip it. */
 CC_API void Inflate_MakeStream2(struct Stream* stream, struct InflateState* state, struct Stream* underlying);
+/* Decompresses DEFLATE compressed data directly into the given buffer. (faster than using Inflate_MakeStream2) */
+/* NOTE: Returns an error if the data does not decompress to exactly dstLen bytes. */
+CC_API cc_result Inflate_ToBuffer(const cc_uint8* src, cc_uint32 srcLen, cc_uint8* dst, cc_uint32 dstLen);
 
 
 #define DEFLATE_BLOCK_SIZE  16384
@@ -89,6 +94,15 @@ CC_API void Inflate_MakeStream2(struct Stream* stream, struct InflateState* stat
 #define DEFLATE_OUT_SIZE 8192
 #define DEFLATE_HASH_SIZE 0x1000UL
 #define DEFLATE_HASH_MASK 0x0FFFUL
+#define DEFLATE_MAX_SYMS 4096
+
+/* Compression levels, trading off compression speed against compressed size */
+enum DeflateLevel {
+	DEFLATE_LEVEL_FAST,    /* Only checks the most recent match, no lazy matching */
+	DEFLATE_LEVEL_DEFAULT, /* Checks a few recent matches, fixed huffman codes */
+	DEFLATE_LEVEL_BEST     /* Checks many recent matches, dynamic huffman codes */
+};
+
 struct DeflateState {
 	cc_uint32 Bits;         /* Holds bits across byte boundaries */
 	cc_uint32 NumBits;      /* Number of bits in Bits buffer */
@@ -100,6 +114,8 @@ struct DeflateState {
 
 	cc_uint16 LitsCodewords[INFLATE_MAX_LITS]; /* Codewords for each value */
 	cc_uint8 LitsLens[INFLATE_MAX_LITS];       /* Bit lengths of each codeword */
+	cc_uint16 DistsCodewords[INFLATE_MAX_DISTS];
+	cc_uint8 DistsLens[INFLATE_MAX_DISTS];
 	
 	cc_uint8 Input[DEFLATE_BUFFER_SIZE];
 	cc_uint8 Output[DEFLATE_OUT_SIZE];
@@ -108,10 +124,28 @@ struct DeflateState {
 	/* NOTE: The largest possible value that can get */
 	/*  stored in Head/Prev is <= DEFLATE_BUFFER_SIZE */
 	cc_bool WroteHeader;
+
+	int MaxChain;       /* Maximum number of previous matches checked */
+	cc_bool LazyMatch;  /* Whether to also check for a longer match at the next byte */
+	cc_bool Dynamic;    /* Whether blocks use dynamic huffman codes */
+	int NumSyms;        /* Number of symbols queued for the next dynamic huffman block */
+	cc_uint16 SymLits[DEFLATE_MAX_SYMS];  /* Literal value, or match length */
+	cc_uint16 SymDists[DEFLATE_MAX_SYMS]; /* Match distance, or 0 for literals */
+	cc_bool Partial;    /* Whether more DEFLATE compressed data will follow the output */
 };
 /* Compresses input data using DEFLATE, then writes compressed output to another stream. Write only stream. */
 /* DEFLATE compression is pure compressed data, there is no header or footer. */
 CC_API void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying);
+/* Sets the compression level (see DeflateLevel enum). Default is DEFLATE_LEVEL_DEFAULT. */
+/* NOTE: Must be called before any data is written to the stream. */
+CC_API void Deflate_SetLevel(struct DeflateState* state, int level);
+/* Sets the data that matches at the start of the compressed data can refer back to. */
+/* NOTE: Only the last DEFLATE_BLOCK_SIZE bytes are used. Must be called before any data is written to the stream. */
+void Deflate_SetDictionary(struct DeflateState* state, const cc_uint8* data, cc_uint32 len);
+/* Sets whether the compressed output will be followed by more DEFLATE compressed data. */
+/* If so, the last block is not marked as final, and the output is padded to a byte boundary */
+/*  with an empty stored block. (i.e. so independently compressed data can be concatenated) */
+void Deflate_SetPartial(struct DeflateState* state, cc_bool partial);
 
 struct GZipState { struct DeflateState Base; cc_uint32 Crc32, Size; };
 /* Compresses input data using GZIP, then writes compressed output to another stream. Write only stream. */
@@ -126,7 +160,7 @@ CC_API  void ZLib_MakeStream(      struct Stream* stream, struct ZLibState* stat
 typedef void (*FP_ZLib_MakeStream)(struct Stream* stream, struct ZLibState* state, struct Stream* underlying);
 
 /* Minimal data needed to describe an entry in a .zip archive */
-struct ZipEntry { cc_uint32 CompressedSize, UncompressedSize, LocalHeaderOffset; };
+struct ZipEntry { cc_uint32 CompressedSize, UncompressedSize, LocalHeaderOffset, CRC32; };
 /* Callback function to process the data in a .zip archive entry */
 /* Return non-zero to indicate an error and stop further processing */
 /* NOTE: data stream MAY NOT be seekable (i.e. entry data might be compressed) */
@@ -138,5 +172,57 @@ typedef cc_bool (*Zip_SelectEntry)(const cc_string* path);
 cc_result Zip_Extract(struct Stream* source, Zip_SelectEntry selector, Zip_ProcessEntry processor,
 						struct ZipEntry* entries, int maxEntries);
 
+/* Index of the entries in the central directory of a .zip archive, hashed by path */
+/* Allows looking up and extracting individual entries, without any limit on the number of entries */
+struct ZipIndexEntry {
+	struct ZipEntry data;
+	cc_uint32 pathOffset; /* Offset of the entry's path in the index's path data */
+	int pathLength;
+	int next; /* Next entry in the same hash bucket, -1 if none */
+};
+struct ZipIndex {
+	struct Stream* source;
+	struct ZipIndexEntry* entries;
+	int count;       /* Number of entries in the archive */
+	char* paths;     /* Paths of all the entries, stored one after another */
+	int* buckets;    /* Index of first entry in each hash bucket, -1 if bucket is empty */
+	int bucketsMask;
+};
+
+/* Reads the central directory of the given .zip archive into the index */
+/* NOTE: source must remain open until the index is freed */
+cc_result ZipIndex_Build(struct ZipIndex* index, struct Stream* source);
+/* Returns the index of the entry with the given path (case insensitive), or -1 if no such entry */
+int ZipIndex_Find(struct ZipIndex* index, const cc_string* path);
+/* Returns the path of the i'th entry in the archive */
+cc_string ZipIndex_GetPath(struct ZipIndex* index, int i);
+/* Seeks to the data of the i'th entry in the archive, then calls processor with it */
+cc_result ZipIndex_Extract(struct ZipIndex* index, int i, Zip_ProcessEntry processor);
+/* Reads the data of the i'th entry into memory, without decompressing it */
+/* NOTE: method is set to the compression method of the data (0 = stored, 8 = DEFLATE) */
+cc_result ZipIndex_ReadCompressed(struct ZipIndex* index, int i, cc_uint8** data, cc_uint32* size, int* method);
+void ZipIndex_Free(struct ZipIndex* index);
+
+/* Stores state for extracting entries from a .zip archive while its data is still arriving */
+/* Only local file headers are used, so entries can be processed before the central directory is available */
+/* NOTE: SelectEntry may be called multiple times for the same entry */
+struct ZipStreamState {
+	Zip_SelectEntry SelectEntry;
+	Zip_ProcessEntry ProcessEntry;
+	cc_uint8* buffer;    /* Data of the entry currently being received */
+	cc_uint32 length;    /* Number of bytes in buffer */
+	cc_uint32 capacity;  /* Size of buffer */
+	cc_uint32 skipLeft;  /* Number of bytes left to skip of an entry that wasn't selected */
+	cc_uint32 offset;    /* Offset in the archive of the start of buffer */
+	cc_bool done;        /* Whether all local file entries have been processed */
+};
+
+void ZipStream_Init(struct ZipStreamState* state, Zip_SelectEntry selector, Zip_ProcessEntry processor);
+/* Appends data of the archive, then processes any entries that are now fully available */
+/* NOTE: Returns ZIP_ERR_DATA_DESCRIPTOR if the archive must be extracted using Zip_Extract instead */
+cc_result ZipStream_Append(struct ZipStreamState* state, const cc_uint8* data, cc_uint32 len);
+/* Frees the buffered data of the current entry */
+void ZipStream_Free(struct ZipStreamState* state);
+
 CC_END_HEADER
 #endif
@@ -38,5 +38,14 @@ CC_API void Drawer_YMin(int count, PackedCol col, TextureLoc texLoc, struct Vert
 /* Draws maximum Y face of the cuboid. (i.e. at Y2) */
 CC_API void Drawer_YMax(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
 
+/* Variants of the above functions that use the given state instead of the global Drawer state */
+/* (Allows multiple threads to draw cuboids at the same time) */
+void DrawerState_XMin(struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void DrawerState_XMax(struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void DrawerState_ZMin(struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void DrawerState_ZMax(struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void DrawerState_YMin(struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void DrawerState_YMax(struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+
 CC_END_HEADER
 #endif
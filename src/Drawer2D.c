@@ -1,7 +1,6 @@
 #include "Drawer2D.h"
 #include "String.h"
 #include "Graphics.h"
-#include "Funcs.h"
 #include "Platform.h"
 #include "ExtMath.h"
 #include "Logger.h"
@@ -16,6 +15,19 @@
 #include "TexturePack.h"
 #include "SystemFonts.h"
 
+/* SIMD instructions are used to speed up filling and blending rows of pixels where supported */
+#if defined BITMAP_16BPP
+	/* Row kernels assume 8 bits per color channel */
+#elif defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define DRAWER2D_SIMD_SSE2
+#elif (defined __ARM_NEON || defined __ARM_NEON__) && !defined __ARM_BIG_ENDIAN
+	#include <arm_neon.h>
+	#define DRAWER2D_SIMD_NEON
+#endif
+/* NOTE: Must be included after SIMD headers, as C++ standard library undefines min/max */
+#include "Funcs.h"
+
 struct _Drawer2DData Drawer2D;
 #define Font_IsBitmap(font) (!(font)->handle)
 
@@ -147,6 +159,73 @@ cc_bool Drawer2D_Clamp(struct Context2D* ctx, int* x, int* y, int* width, int* h
 }
 #define Drawer2D_ClampPixel(p) p = (p < 0 ? 0 : (p > 255 ? 255 : p))
 
+/* Sets all the pixels in the given row to the given color */
+static void Drawer2D_FillRow(BitmapCol* row, int width, BitmapCol color) {
+	int x = 0;
+#if defined DRAWER2D_SIMD_SSE2
+	__m128i vColor = _mm_set1_epi32((int)color);
+	for (; x + 8 <= width; x += 8) {
+		_mm_storeu_si128((__m128i*)(row + x),     vColor);
+		_mm_storeu_si128((__m128i*)(row + x + 4), vColor);
+	}
+#elif defined DRAWER2D_SIMD_NEON
+	uint32x4_t vColor = vdupq_n_u32(color);
+	for (; x + 8 <= width; x += 8) {
+		vst1q_u32((uint32_t*)(row + x),     vColor);
+		vst1q_u32((uint32_t*)(row + x + 4), vColor);
+	}
+#endif
+	for (; x < width; x++) { row[x] = color; }
+}
+
+/* Sets each pixel in the given row to color + pixel * inverse / 255 (color must already be alpha blended) */
+static void Drawer2D_BlendRow(BitmapCol* row, int width, BitmapCol color, int inverse) {
+	int x = 0, R, G, B;
+	/* NOTE: v / 255 is calculated as (v + 1 + (v >> 8)) >> 8, which is exact for all v <= 255 * 255 */
+#if defined DRAWER2D_SIMD_SSE2
+	__m128i vColor = _mm_set1_epi32((int)color);
+	__m128i vAlpha = _mm_set1_epi32((int)BITMAPCOLOR_A_MASK);
+	__m128i vInv   = _mm_set1_epi16((short)inverse);
+	__m128i vOne   = _mm_set1_epi16(1);
+	__m128i zero   = _mm_setzero_si128();
+
+	for (; x + 4 <= width; x += 4) {
+		__m128i pix = _mm_loadu_si128((const __m128i*)(row + x));
+		__m128i lo  = _mm_mullo_epi16(_mm_unpacklo_epi8(pix, zero), vInv);
+		__m128i hi  = _mm_mullo_epi16(_mm_unpackhi_epi8(pix, zero), vInv);
+
+		lo  = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, vOne), _mm_srli_epi16(lo, 8)), 8);
+		hi  = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, vOne), _mm_srli_epi16(hi, 8)), 8);
+		pix = _mm_add_epi8(_mm_packus_epi16(lo, hi), vColor);
+		_mm_storeu_si128((__m128i*)(row + x), _mm_or_si128(pix, vAlpha));
+	}
+#elif defined DRAWER2D_SIMD_NEON
+	uint8x16_t vColor = vreinterpretq_u8_u32(vdupq_n_u32(color));
+	uint32x4_t vAlpha = vdupq_n_u32(BITMAPCOLOR_A_MASK);
+	uint8x8_t  vInv   = vdup_n_u8((cc_uint8)inverse);
+	uint16x8_t vOne   = vdupq_n_u16(1);
+
+	for (; x + 4 <= width; x += 4) {
+		uint8x16_t pix = vreinterpretq_u8_u32(vld1q_u32((const uint32_t*)(row + x)));
+		uint16x8_t lo  = vmull_u8(vget_low_u8(pix),  vInv);
+		uint16x8_t hi  = vmull_u8(vget_high_u8(pix), vInv);
+
+		lo  = vshrq_n_u16(vaddq_u16(vaddq_u16(lo, vOne), vshrq_n_u16(lo, 8)), 8);
+		hi  = vshrq_n_u16(vaddq_u16(vaddq_u16(hi, vOne), vshrq_n_u16(hi, 8)), 8);
+		pix = vaddq_u8(vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)), vColor);
+		vst1q_u32((uint32_t*)(row + x), vorrq_u32(vreinterpretq_u32_u8(pix), vAlpha));
+	}
+#endif
+	for (; x < width; x++) {
+		/* TODO: Not shift when multiplying */
+		R = BitmapCol_R(color) + (BitmapCol_R(row[x]) * inverse) / 255;
+		G = BitmapCol_G(color) + (BitmapCol_G(row[x]) * inverse) / 255;
+		B = BitmapCol_B(color) + (BitmapCol_B(row[x]) * inverse) / 255;
+
+		row[x] = BitmapColor_RGB(R, G, B);
+	}
+}
+
 void Context2D_Alloc(struct Context2D* ctx, int width, int height) {
 	ctx->width  = width;
 	ctx->height = height;
@@ -178,6 +257,84 @@ void Context2D_Free(struct Context2D* ctx) {
 }
 
 #define BitmapColor_Raw(r, g, b) (BitmapColor_R_Bits(r) | BitmapColor_G_Bits(g) | BitmapColor_B_Bits(b))
+
+/* Calculates the noise for as many pixels in the row as possible using SIMD instructions */
+/* Returns the number of pixels at the start of the row that were filled in */
+#if defined DRAWER2D_SIMD_SSE2
+static CC_INLINE __m128i Drawer2D_Mul32(__m128i a, __m128i b) {
+	/* SSE2 lacks 32 bit multiplication, so multiply even and odd lanes separately */
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd  = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), 
+							  _mm_shuffle_epi32(odd,  _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static int Drawer2D_NoiseRow(BitmapCol* row, int width, int n0, BitmapCol color, int variation) {
+	__m128i vN     = _mm_add_epi32(_mm_set1_epi32(n0), _mm_setr_epi32(0, 1, 2, 3));
+	__m128i vVar   = _mm_set1_epi32(variation);
+	__m128i vColor = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), _mm_setzero_si128());
+	__m128i vAlpha = _mm_set1_epi32((int)BITMAPCOLOR_A_MASK);
+	__m128i vAColor = _mm_set1_epi32((int)(color & BITMAPCOLOR_A_MASK));
+	__m128i n, t, delta, lo, hi, pix;
+	int x;
+
+	for (x = 0; x + 4 <= width; x += 4) {
+		n = _mm_xor_si128(_mm_slli_epi32(vN, 13), vN);
+		t = _mm_add_epi32(Drawer2D_Mul32(Drawer2D_Mul32(n, n), _mm_set1_epi32(15731)), _mm_set1_epi32(789221));
+		t = _mm_add_epi32(Drawer2D_Mul32(n, t), _mm_set1_epi32(1376312589));
+		t = _mm_srli_epi32(_mm_and_si128(t, _mm_set1_epi32(0x7fffffff)), 20);
+
+		t     = _mm_sub_epi32(_mm_set1_epi32(1024), t);
+		delta = _mm_srai_epi32(Drawer2D_Mul32(t, vVar), 10);
+		/* Spread each pixel's delta across its 4 color channels */
+		delta = _mm_packs_epi32(delta, delta);
+		delta = _mm_unpacklo_epi16(delta, delta);
+		lo    = _mm_add_epi16(vColor, _mm_unpacklo_epi32(delta, delta));
+		hi    = _mm_add_epi16(vColor, _mm_unpackhi_epi32(delta, delta));
+
+		pix = _mm_andnot_si128(vAlpha, _mm_packus_epi16(lo, hi));
+		_mm_storeu_si128((__m128i*)(row + x), _mm_or_si128(pix, vAColor));
+		vN  = _mm_add_epi32(vN, _mm_set1_epi32(4));
+	}
+	return x;
+}
+#elif defined DRAWER2D_SIMD_NEON
+static int Drawer2D_NoiseRow(BitmapCol* row, int width, int n0, BitmapCol color, int variation) {
+	static const int32_t offsets[4] = { 0, 1, 2, 3 };
+	int32x4_t vN     = vaddq_s32(vdupq_n_s32(n0), vld1q_s32(offsets));
+	int16x8_t vColor = vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(color))));
+	uint32x4_t vAlpha  = vdupq_n_u32(BITMAPCOLOR_A_MASK);
+	uint32x4_t vAColor = vdupq_n_u32(color & BITMAPCOLOR_A_MASK);
+	int32x4_t n, t, delta;
+	int16x4x2_t d, lo, hi;
+	uint32x4_t pix;
+	int x;
+
+	for (x = 0; x + 4 <= width; x += 4) {
+		n = veorq_s32(vshlq_n_s32(vN, 13), vN);
+		t = vaddq_s32(vmulq_s32(vmulq_s32(n, n), vdupq_n_s32(15731)), vdupq_n_s32(789221));
+		t = vaddq_s32(vmulq_s32(n, t), vdupq_n_s32(1376312589));
+		t = vreinterpretq_s32_u32(vshrq_n_u32(vandq_u32(vreinterpretq_u32_s32(t), vdupq_n_u32(0x7fffffff)), 20));
+
+		t     = vsubq_s32(vdupq_n_s32(1024), t);
+		delta = vshrq_n_s32(vmulq_s32(t, vdupq_n_s32(variation)), 10);
+		/* Spread each pixel's delta across its 4 color channels */
+		d  = vzip_s16(vqmovn_s32(delta), vqmovn_s32(delta));
+		lo = vzip_s16(d.val[0], d.val[0]);
+		hi = vzip_s16(d.val[1], d.val[1]);
+
+		pix = vreinterpretq_u32_u8(vcombine_u8(
+				vqmovun_s16(vaddq_s16(vColor, vcombine_s16(lo.val[0], lo.val[1]))),
+				vqmovun_s16(vaddq_s16(vColor, vcombine_s16(hi.val[0], hi.val[1])))));
+		vst1q_u32((uint32_t*)(row + x), vorrq_u32(vbicq_u32(pix, vAlpha), vAColor));
+		vN = vaddq_s32(vN, vdupq_n_s32(4));
+	}
+	return x;
+}
+#else
+#define Drawer2D_NoiseRow(row, width, n0, color, variation) 0
+#endif
+
 void Gradient_Noise(struct Context2D* ctx, BitmapCol color, int variation,
 					int x, int y, int width, int height) {
 	struct Bitmap* bmp = (struct Bitmap*)ctx;
@@ -191,8 +348,10 @@ void Gradient_Noise(struct Context2D* ctx, BitmapCol color, int variation,
 
 	for (yy = 0; yy < height; yy++) {
 		dst = Bitmap_GetRow(bmp, y + yy) + x;
+		xx  = Drawer2D_NoiseRow(dst, width, x + (y + yy) * 57, color, variation);
+		dst += xx;
 
-		for (xx = 0; xx < width; xx++, dst++) {
+		for (; xx < width; xx++, dst++) {
 			n = (x + xx) + (y + yy) * 57;
 			n = (n << 13) ^ n;
 
@@ -217,7 +376,7 @@ void Gradient_Vertical(struct Context2D* ctx, BitmapCol a, BitmapCol b,
 					   int x, int y, int width, int height) {
 	struct Bitmap* bmp = (struct Bitmap*)ctx;
 	BitmapCol* row, color;
-	int xx, yy;
+	int yy;
 	float t;
 	if (!Drawer2D_Clamp(ctx, &x, &y, &width, &height)) return;
 
@@ -230,16 +389,14 @@ void Gradient_Vertical(struct Context2D* ctx, BitmapCol a, BitmapCol b,
 			Math_Lerp(BitmapCol_G(a), BitmapCol_G(b), t),
 			Math_Lerp(BitmapCol_B(a), BitmapCol_B(b), t),
 			255);
-
-		for (xx = 0; xx < width; xx++) { row[xx] = color; }
+		Drawer2D_FillRow(row, width, color);
 	}
 }
 
 void Gradient_Blend(struct Context2D* ctx, BitmapCol color, int blend,
 					int x, int y, int width, int height) {
 	struct Bitmap* bmp = (struct Bitmap*)ctx;
-	BitmapCol* dst;
-	int R, G, B, xx, yy;
+	int yy;
 	if (!Drawer2D_Clamp(ctx, &x, &y, &width, &height)) return;
 
 	/* Pre compute the alpha blended source color */
@@ -252,16 +409,7 @@ void Gradient_Blend(struct Context2D* ctx, BitmapCol color, int blend,
 	blend = 255 - blend; /* inverse for existing pixels */
 
 	for (yy = 0; yy < height; yy++) {
-		dst = Bitmap_GetRow(bmp, y + yy) + x;
-
-		for (xx = 0; xx < width; xx++, dst++) {
-			/* TODO: Not shift when multiplying */
-			R = BitmapCol_R(color) + (BitmapCol_R(*dst) * blend) / 255;
-			G = BitmapCol_G(color) + (BitmapCol_G(*dst) * blend) / 255;
-			B = BitmapCol_B(color) + (BitmapCol_B(*dst) * blend) / 255;
-
-			*dst = BitmapColor_RGB(R, G, B);
-		}
+		Drawer2D_BlendRow(Bitmap_GetRow(bmp, y + yy) + x, width, color, blend);
 	}
 }
 
@@ -270,27 +418,24 @@ void Context2D_DrawPixels(struct Context2D* ctx, int x, int y, struct Bitmap* sr
 	int width = src->width, height = src->height;
 	BitmapCol* dstRow;
 	BitmapCol* srcRow;
-	int xx, yy;
+	int yy;
 	if (!Drawer2D_Clamp(ctx, &x, &y, &width, &height)) return;
 
 	for (yy = 0; yy < height; yy++) {
 		srcRow = Bitmap_GetRow(src, yy);
 		dstRow = Bitmap_GetRow(dst, y + yy) + x;
-
-		for (xx = 0; xx < width; xx++) { dstRow[xx] = srcRow[xx]; }
+		Mem_Copy(dstRow, srcRow, width * BITMAPCOLOR_SIZE);
 	}
 }
 
 void Context2D_Clear(struct Context2D* ctx, BitmapCol color,
 					int x, int y, int width, int height) {
 	struct Bitmap* bmp = (struct Bitmap*)ctx;
-	BitmapCol* row;
-	int xx, yy;
+	int yy;
 	if (!Drawer2D_Clamp(ctx, &x, &y, &width, &height)) return;
 
 	for (yy = 0; yy < height; yy++) {
-		row = Bitmap_GetRow(bmp, y + yy) + x;
-		for (xx = 0; xx < width; xx++) { row[xx] = color; }
+		Drawer2D_FillRow(Bitmap_GetRow(bmp, y + yy) + x, width, color);
 	}
 }
 
@@ -425,17 +570,12 @@ void Drawer2D_ReducePadding_Height(int* height, int point, int scale) {
 }
 
 void Drawer2D_Fill(struct Bitmap* bmp, int x, int y, int width, int height, BitmapCol color) {
-	BitmapCol* row;
-	int xx, yy;
+	int yy;
+	width  = min(x + width,  bmp->width)  - x;
+	height = min(y + height, bmp->height) - y;
 
-	for (yy = y; yy < y + height; yy++) {
-		if (yy >= bmp->height) return;
-		row = Bitmap_GetRow(bmp, yy);
-
-		for (xx = x; xx < x + width; xx++) {
-			if (xx >= bmp->width) break;
-			row[xx] = color;
-		}
+	for (yy = 0; yy < height; yy++) {
+		Drawer2D_FillRow(Bitmap_GetRow(bmp, y + yy) + x, width, color);
 	}
 }
 
@@ -648,7 +788,7 @@ static void DefaultPngProcess(struct Stream* stream, const cc_string* name) {
 	struct Bitmap bmp;
 	cc_result res;
 
-	if ((res = Png_Decode(&bmp, stream))) {
+	if ((res = TexturePack_DecodePng(&bmp, stream))) {
 		Logger_SysWarn2(res, "decoding", name);
 		Mem_Free(bmp.scan0);
 	} else if (Font_SetBitmapAtlas(&bmp)) {
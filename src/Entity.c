@@ -42,7 +42,14 @@ void Entity_Init(struct Entity* e) {
 	e->Flags      = ENTITY_FLAG_HAS_MODELVB;
 	e->uScale     = 1.0f;
 	e->vScale     = 1.0f;
+	e->uOffset    = 0.0f;
+	e->vOffset    = 0.0f;
+	e->_skinSlot  = 0;
 	e->_skinReqID = 0;
+	e->_meshKey.model = NULL;
+	e->_nameSlot  = 0;
+	e->_skinBytes = 0;
+	e->_lastDrawn = Game.Time;
 	e->SkinRaw[0] = '\0';
 	e->NameRaw[0] = '\0';
 	Entity_SetModel(e, &model);
@@ -202,9 +209,107 @@ cc_bool Entity_TouchesAnyWater(struct Entity* e) {
 }
 
 
+/*########################################################################################################################*
+*--------------------------------------------------------Skin atlas-------------------------------------------------------*
+*#########################################################################################################################*/
+/* 64x64 and 64x32 skins are packed together into a few larger textures, */
+/*  so that rendering most entities does not require changing the bound texture */
+#define SKINATLAS_SIZE      512
+#define SKINATLAS_PER_ROW   (SKINATLAS_SIZE / 64)
+#define SKINATLAS_SLOTS     (SKINATLAS_PER_ROW * SKINATLAS_PER_ROW)
+#define SKINATLAS_MAX_PAGES 8
+/* Entities created by plugins may use older struct definition which lacks the skin atlas fields */
+#define Entity_SkinSlot(e) (((e)->Flags & ENTITY_FLAG_HAS_MODELVB) ? (e)->_skinSlot : 0)
+#define Entity_SkinBytes(e) (((e)->Flags & ENTITY_FLAG_HAS_MODELVB) ? (e)->_skinBytes : 0)
+
+static GfxResourceID skinAtlas_pages[SKINATLAS_MAX_PAGES];
+static cc_uint8 skinAtlas_used[SKINATLAS_MAX_PAGES][SKINATLAS_SLOTS];
+static int skinAtlas_counts[SKINATLAS_MAX_PAGES];
+
+static cc_bool SkinAtlas_CreatePage(int page) {
+	struct Bitmap bmp;
+	if (!Gfx_CheckTextureSize(SKINATLAS_SIZE, SKINATLAS_SIZE, TEXTURE_FLAG_DYNAMIC)) return false;
+
+	Bitmap_TryAllocate(&bmp, SKINATLAS_SIZE, SKINATLAS_SIZE);
+	if (!bmp.scan0) return false;
+	Mem_Set(bmp.scan0, 0, Bitmap_DataSize(SKINATLAS_SIZE, SKINATLAS_SIZE));
+
+	skinAtlas_pages[page] = Gfx_CreateTexture(&bmp, TEXTURE_FLAG_MANAGED | TEXTURE_FLAG_DYNAMIC, false);
+	Mem_Free(bmp.scan0);
+
+	if (!skinAtlas_pages[page]) return false;
+	Game_VRAMUsage[VRAM_SKINS] += Bitmap_DataSize(SKINATLAS_SIZE, SKINATLAS_SIZE);
+	return true;
+}
+
+/* Returns 1 + index of a newly reserved slot, or 0 if no slots are free */
+static int SkinAtlas_Reserve(void) {
+	int page, slot;
+	for (page = 0; page < SKINATLAS_MAX_PAGES; page++)
+	{
+		if (skinAtlas_counts[page] == SKINATLAS_SLOTS) continue;
+		if (!skinAtlas_pages[page] && !SkinAtlas_CreatePage(page)) return 0;
+
+		for (slot = 0; slot < SKINATLAS_SLOTS; slot++)
+		{
+			if (skinAtlas_used[page][slot]) continue;
+			skinAtlas_used[page][slot] = true;
+			skinAtlas_counts[page]++;
+			return 1 + page * SKINATLAS_SLOTS + slot;
+		}
+	}
+	return 0;
+}
+
+static void SkinAtlas_Release(int id) {
+	int page = (id - 1) / SKINATLAS_SLOTS;
+	int slot = (id - 1) % SKINATLAS_SLOTS;
+
+	skinAtlas_used[page][slot] = false;
+	skinAtlas_counts[page]--;
+	/* No point keeping around a 1 MB texture that no skins use */
+	if (skinAtlas_counts[page]) return;
+
+	Gfx_DeleteTexture(&skinAtlas_pages[page]);
+	Game_VRAMUsage[VRAM_SKINS] -= Bitmap_DataSize(SKINATLAS_SIZE, SKINATLAS_SIZE);
+}
+
+/* Attempts to store the given skin in the skin atlas, instead of in its own texture */
+static cc_bool SkinAtlas_TryAdd(struct Entity* e, struct Bitmap* bmp) {
+	int id, page, slot, x, y;
+	if (bmp->width != 64 || (bmp->height != 64 && bmp->height != 32)) return false;
+	if (!(e->Flags & ENTITY_FLAG_HAS_MODELVB)) return false;
+	if (!(id = SkinAtlas_Reserve())) return false;
+
+	page = (id - 1) / SKINATLAS_SLOTS;
+	slot = (id - 1) % SKINATLAS_SLOTS;
+	x    = (slot % SKINATLAS_PER_ROW) * 64;
+	y    = (slot / SKINATLAS_PER_ROW) * 64;
+	Gfx_UpdateTexture(skinAtlas_pages[page], x, y, bmp, bmp->width, false);
+
+	e->TextureId = skinAtlas_pages[page];
+	e->_skinSlot = id;
+	e->uOffset   = (float)x / SKINATLAS_SIZE;
+	e->vOffset   = (float)y / SKINATLAS_SIZE;
+	e->uScale   *= (float)bmp->width  / SKINATLAS_SIZE;
+	e->vScale   *= (float)bmp->height / SKINATLAS_SIZE;
+	return true;
+}
+
+/* Returns 0 for entities with their own skin texture, otherwise 1 + skin atlas page */
+static int SkinAtlas_PageOf(struct Entity* e) {
+	int id = Entity_SkinSlot(e);
+	return id ? 1 + (id - 1) / SKINATLAS_SLOTS : 0;
+}
+
+
 /*########################################################################################################################*
 *------------------------------------------------------Entity skins-------------------------------------------------------*
 *#########################################################################################################################*/
+/* Skins of entities that haven't been drawn for this many seconds may be freed to stay within the VRAM budget */
+#define SKIN_EVICT_DELAY 10.0
+#define SKIN_MAX_EVICTIONS 8
+
 static struct Entity* Entity_FirstOtherWithSameSkinAndFetchedSkin(struct Entity* except) {
 	struct Entity* e;
 	cc_string skin, eSkin;
@@ -216,7 +321,9 @@ static struct Entity* Entity_FirstOtherWithSameSkinAndFetchedSkin(struct Entity*
 
 		e     = Entities.List[i];
 		eSkin = String_FromRawArray(e->SkinRaw);
-		if (e->SkinFetchState && String_Equals(&skin, &eSkin)) return e;
+		/* Entities still waiting for the skin are handled by the skin download instead */
+		if (e->SkinFetchState != SKIN_FETCH_COMPLETED) continue;
+		if (String_Equals(&skin, &eSkin)) return e;
 	}
 	return NULL;
 }
@@ -228,6 +335,17 @@ static void Entity_CopySkin(struct Entity* dst, struct Entity* src) {
 	dst->uScale       = src->uScale;
 	dst->vScale       = src->vScale;
 	dst->MobTextureId = src->MobTextureId;
+
+	if (dst->Flags & ENTITY_FLAG_HAS_MODELVB) {
+		dst->_skinSlot  = Entity_SkinSlot(src);
+		dst->_skinBytes = Entity_SkinBytes(src);
+		dst->uOffset   = dst->_skinSlot ? src->uOffset : 0.0f;
+		dst->vOffset   = dst->_skinSlot ? src->vOffset : 0.0f;
+	} else if (Entity_SkinSlot(src)) {
+		/* Can't reference region within skin atlas, so just use default skin */
+		dst->TextureId    = 0;
+		dst->MobTextureId = 0;
+	}
 }
 
 /* Resets skin data for the given entity */
@@ -236,6 +354,26 @@ static void Entity_ResetSkin(struct Entity* e) {
 	e->MobTextureId = 0;
 	e->TextureId    = 0;
 	e->SkinType     = SKIN_64x32;
+
+	if (!(e->Flags & ENTITY_FLAG_HAS_MODELVB)) return;
+	e->uOffset   = 0.0f; e->vOffset = 0.0f;
+	e->_skinSlot  = 0;
+	e->_skinBytes = 0;
+}
+
+/* Frees the texture or skin atlas slot used by the given entity's skin */
+static void Entity_FreeSkinTexture(struct Entity* e) {
+	int id = Entity_SkinSlot(e);
+	if (!id) {
+		Game_VRAMUsage[VRAM_SKINS] -= Entity_SkinBytes(e);
+		Gfx_DeleteTexture(&e->TextureId); 
+		if (e->Flags & ENTITY_FLAG_HAS_MODELVB) e->_skinBytes = 0;
+		return; 
+	}
+
+	SkinAtlas_Release(id);
+	e->TextureId = 0;
+	e->_skinSlot = 0;
 }
 
 /* Copies or resets skin data for all entity with same skin */
@@ -318,11 +456,10 @@ static cc_result EnsurePow2Skin(struct Entity* e, struct Bitmap* bmp) {
 	return 0;
 }
 
-static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, struct Stream* src, cc_string* skin) {
+static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, cc_string* skin) {
 	cc_result res;
-	if ((res = Png_Decode(bmp, src))) return res;
 
-	Gfx_DeleteTexture(&e->TextureId);
+	Entity_FreeSkinTexture(e);
 	Entity_SetSkinAll(e, true);
 	if ((res = EnsurePow2Skin(e, bmp))) return res;
 	e->SkinType = Utils_CalcSkinType(bmp);
@@ -333,7 +470,14 @@ static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, struct Stream*
 		if (e->Model->flags & MODEL_FLAG_CLEAR_HAT)
 			Entity_ClearHat(bmp, e->SkinType);
 
-		e->TextureId = Gfx_CreateTexture(bmp, TEXTURE_FLAG_MANAGED, false);
+		if (!SkinAtlas_TryAdd(e, bmp)) {
+			e->TextureId = Gfx_CreateTexture(bmp, TEXTURE_FLAG_MANAGED, false);
+			/* Skins of entities created by plugins may lack the field for tracking this */
+			if (e->TextureId && (e->Flags & ENTITY_FLAG_HAS_MODELVB)) {
+				e->_skinBytes = Bitmap_DataSize(bmp->width, bmp->height);
+				Game_VRAMUsage[VRAM_SKINS] += e->_skinBytes;
+			}
+		}
 		Entity_SetSkinAll(e, false);
 	}
 	return 0;
@@ -352,69 +496,201 @@ static void LogInvalidSkin(cc_result res, const cc_string* skin, const cc_uint8*
 	Logger_WarnFunc(&msg);
 }
 
+/* Skin downloads are tracked by skin name instead of by entity, so that each unique skin is only */
+/*  downloaded, decoded and uploaded once - even if the entity which started the download */
+/*  is removed or changes skin before the download completes */
+struct SkinDownload {
+	int reqID; /* 0 if this slot is unused */
+	cc_uint32 hash;
+	char name[STRING_SIZE];
+};
+static struct SkinDownload skinDownloads[ENTITIES_MAX_COUNT];
+static int skinDownloadsCount;
+
+static cc_uint32 SkinDownload_Hash(const cc_string* skin) {
+	return Utils_CRC32((const cc_uint8*)skin->buffer, skin->length);
+}
+
+static cc_bool SkinDownload_Exists(const cc_string* skin) {
+	cc_uint32 hash = SkinDownload_Hash(skin);
+	cc_string name;
+	int i;
+
+	for (i = 0; i < skinDownloadsCount; i++)
+	{
+		if (!skinDownloads[i].reqID || skinDownloads[i].hash != hash) continue;
+		name = String_FromRawArray(skinDownloads[i].name);
+		if (String_Equals(&name, skin)) return true;
+	}
+	return false;
+}
+
+static void SkinDownload_Start(const cc_string* skin, cc_uint8 flags) {
+	struct SkinDownload* dl;
+	int i;
+
+	for (i = 0; i < skinDownloadsCount; i++)
+	{
+		if (!skinDownloads[i].reqID) break;
+	}
+	/* Every entity is waiting on a different skin already, which should be impossible */
+	if (i == ENTITIES_MAX_COUNT) return;
+	if (i == skinDownloadsCount) skinDownloadsCount++;
+
+	dl        = &skinDownloads[i];
+	dl->reqID = Http_AsyncGetSkin(skin, flags);
+	dl->hash  = SkinDownload_Hash(skin);
+	String_CopyToRawArray(dl->name, skin);
+}
+
+/* Returns an entity with the given skin that is still waiting for the skin to be downloaded */
+static struct Entity* SkinDownload_FindTarget(const cc_string* skin) {
+	struct Entity* e;
+	cc_string eSkin;
+	int i;
+
+	for (i = 0; i < ENTITIES_MAX_COUNT; i++) 
+	{
+		e = Entities.List[i];
+		if (!e || e->SkinFetchState == SKIN_FETCH_COMPLETED) continue;
+
+		eSkin = String_FromRawArray(e->SkinRaw);
+		if (String_Equals(&eSkin, skin)) return e;
+	}
+	return NULL;
+}
+
+static void SkinDownload_Complete(struct SkinDownload* dl, struct HttpRequest* item) {
+	cc_string skin = String_FromRawArray(dl->name);
+	struct Entity* e;
+	cc_result res;
+
+	/* All the entities which were waiting on the skin might have been removed since */
+	e = SkinDownload_FindTarget(&skin);
+	if (!e) return;
+
+	if (!item->success) {
+		Entity_SetSkinAll(e, true);
+	} else {
+		/* Skin was already decoded by the http worker thread */
+		res = item->imageResult;
+		if (!res) res = ApplySkin(e, &item->image, &skin);
+		if (res) LogInvalidSkin(res, &skin, item->data, item->size);
+	}
+}
+
+/* Applies the skins of all downloads which have completed to the entities using those skins */
+static void SkinDownloads_Process(void) {
+	struct SkinDownload* dl;
+	struct HttpRequest item;
+	int i;
+
+	for (i = 0; i < skinDownloadsCount; i++)
+	{
+		dl = &skinDownloads[i];
+		if (!dl->reqID || !Http_GetResult(dl->reqID, &item)) continue;
+
+		SkinDownload_Complete(dl, &item);
+		HttpRequest_Free(&item);
+		dl->reqID = 0;
+	}
+
+	while (skinDownloadsCount && !skinDownloads[skinDownloadsCount - 1].reqID) skinDownloadsCount--;
+}
+
+static void SkinDownloads_Clear(void) {
+	int i;
+	for (i = 0; i < skinDownloadsCount; i++)
+	{
+		if (skinDownloads[i].reqID) Http_TryCancel(skinDownloads[i].reqID);
+		skinDownloads[i].reqID = 0;
+	}
+	skinDownloadsCount = 0;
+}
+
 static void Entity_CheckSkin(struct Entity* e) {
 	struct Entity* first;
-	struct HttpRequest item;
-	struct Stream mem;
-	struct Bitmap bmp;
 	cc_string skin;
 	cc_uint8 flags;
-	cc_result res;
 
 	/* Don't check skin if don't have to */
 	if (!e->Model->usesSkin) return;
 	if (e->SkinFetchState == SKIN_FETCH_COMPLETED) return;
 	skin = String_FromRawArray(e->SkinRaw);
 
+	if (e->SkinFetchState == SKIN_FETCH_EVICTED) {
+		if (Game.Time - e->_lastDrawn >= SKIN_EVICT_DELAY) return;
+		e->SkinFetchState = 0;
+	}
+
 	if (!e->SkinFetchState) {
 		first = Entity_FirstOtherWithSameSkinAndFetchedSkin(e);
 		flags = e == &LocalPlayer_Instances[0].Base ? HTTP_FLAG_NOCACHE : 0;
+		flags |= HTTP_FLAG_DECODEPNG;
 
-		if (!first) {
-			e->_skinReqID     = Http_AsyncGetSkin(&skin, flags);
-			e->SkinFetchState = SKIN_FETCH_DOWNLOADING;
-		} else {
+		if (first) {
 			Entity_CopySkin(e, first);
 			e->SkinFetchState = SKIN_FETCH_COMPLETED;
 			return;
 		}
-	}
-
-	if (!Http_GetResult(e->_skinReqID, &item)) return;
-
-	if (!item.success) {
-		Entity_SetSkinAll(e, true);
-	} else {
-		Stream_ReadonlyMemory(&mem, item.data, item.size);
 
-		if ((res = ApplySkin(e, &bmp, &mem, &skin))) {
-			LogInvalidSkin(res, &skin, item.data, item.size);
-		}
-		Mem_Free(bmp.scan0);
+		/* Another entity with the same skin may have already started downloading it */
+		if (!SkinDownload_Exists(&skin)) SkinDownload_Start(&skin, flags);
+		e->SkinFetchState = SKIN_FETCH_DOWNLOADING;
 	}
-	HttpRequest_Free(&item);
+	/* Completed downloads are applied by SkinDownloads_Process */
 }
 
 /* Returns true if no other entities are sharing this skin texture */
 static cc_bool CanDeleteTexture(struct Entity* except) {
-	int i;
+	int i, id;
 	if (!except->TextureId) return false;
+	id = Entity_SkinSlot(except);
 
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++)
 	{
 		if (!Entities.List[i] || Entities.List[i] == except)  continue;
-		if (Entities.List[i]->TextureId == except->TextureId) return false;
+		if (Entities.List[i]->TextureId != except->TextureId) continue;
+		/* Skin atlas texture is shared by many different skins */
+		if (Entity_SkinSlot(Entities.List[i]) == id) return false;
 	}
 	return true;
 }
 
 CC_NOINLINE static void DeleteSkin(struct Entity* e) {
-	if (CanDeleteTexture(e)) Gfx_DeleteTexture(&e->TextureId);
+	if (CanDeleteTexture(e)) Entity_FreeSkinTexture(e);
 
 	Entity_ResetSkin(e);
 	e->SkinFetchState = 0;
 }
 
+/* Frees the skins that have gone the longest without being drawn, while over the VRAM budget */
+/* NOTE: Skins shared with other entities are only freed once no entity is using them */
+static void Entities_EvictSkins(void) {
+	struct Entity* e;
+	struct Entity* oldest;
+	int i, evicted;
+
+	for (evicted = 0; evicted < SKIN_MAX_EVICTIONS && Game_VRAMOverBudget(100); evicted++)
+	{
+		oldest = NULL;
+		/* Local players are always drawn (e.g. held arm), so shouldn't have their skins freed */
+		for (i = 0; i < MAX_NET_PLAYERS; i++)
+		{
+			e = Entities.List[i];
+			if (!e || !(e->Flags & ENTITY_FLAG_HAS_MODELVB)) continue;
+			if (e->SkinFetchState != SKIN_FETCH_COMPLETED || !e->TextureId) continue;
+			if (Game.Time - e->_lastDrawn < SKIN_EVICT_DELAY) continue;
+
+			if (!oldest || e->_lastDrawn < oldest->_lastDrawn) oldest = e;
+		}
+		if (!oldest) return;
+
+		DeleteSkin(oldest);
+		oldest->SkinFetchState = SKIN_FETCH_EVICTED;
+	}
+}
+
 void Entity_SetSkin(struct Entity* e, const cc_string* skin) {
 	cc_string tmp; char tmpBuffer[STRING_SIZE];
 	DeleteSkin(e);
@@ -440,29 +716,210 @@ void Entity_LerpAngles(struct Entity* e, float t) {
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------------Entity grid-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Uniform grid over the X/Z plane of the map, so finding entities near a position only checks nearby cells */
+/* Entities outside the map are put in the closest cell on the border of the map */
+#define ENTITYGRID_SHIFT 3
+#define ENTITYGRID_NONE  0xFFFF
+/* How far entities might move from the cell they are in before the grid is next rebuilt */
+#define ENTITYGRID_MARGIN 2.0f
+
+static cc_uint16* grid_heads; /* First entity in each cell */
+static cc_uint16 grid_next[ENTITIES_MAX_COUNT]; /* Next entity in the same cell */
+static int grid_cells[ENTITIES_MAX_COUNT];      /* Cell each entity is in, -1 if not in the grid */
+static int grid_width, grid_length;
+
+static int EntityGrid_Coord(float value, int max) {
+	int coord;
+	if (value < 0.0f) return 0;
+
+	coord = Math_Floor(value) >> ENTITYGRID_SHIFT;
+	return min(coord, max - 1);
+}
+
+static void EntityGrid_Free(void) {
+	Mem_Free(grid_heads);
+	grid_heads  = NULL;
+	grid_width  = 0;
+	grid_length = 0;
+}
+
+/* Rebuilds the grid from the current positions of entities */
+static void EntityGrid_Rebuild(void) {
+	int w = (World.Width  + (1 << ENTITYGRID_SHIFT) - 1) >> ENTITYGRID_SHIFT;
+	int l = (World.Length + (1 << ENTITYGRID_SHIFT) - 1) >> ENTITYGRID_SHIFT;
+	struct Entity* e;
+	int i, cell;
+
+	if (w != grid_width || l != grid_length) {
+		EntityGrid_Free();
+		if (!w || !l) return;
+
+		grid_heads  = (cc_uint16*)Mem_Alloc(w * l, 2, "entity grid");
+		grid_width  = w;
+		grid_length = l;
+		Mem_Set(grid_heads, 0xFF, w * l * 2);
+	} else {
+		/* Only need to reset the cells that were used */
+		for (i = 0; i < ENTITIES_MAX_COUNT; i++)
+		{
+			if (grid_cells[i] >= 0) grid_heads[grid_cells[i]] = ENTITYGRID_NONE;
+		}
+	}
+
+	for (i = 0; i < ENTITIES_MAX_COUNT; i++)
+	{
+		e = Entities.List[i];
+		grid_cells[i] = -1;
+		if (!e) continue;
+
+		cell = EntityGrid_Coord(e->Position.z, l) * w + EntityGrid_Coord(e->Position.x, w);
+		grid_next[i]     = grid_heads[cell];
+		grid_heads[cell] = i;
+		grid_cells[i]    = cell;
+	}
+}
+
+int Entities_GetNearby(const Vec3* pos, float radius, int* ids) {
+	int x1, z1, x2, z2, x, z, i, count = 0;
+
+	/* No map, so just return all entities */
+	if (!grid_heads) {
+		for (i = 0; i < ENTITIES_MAX_COUNT; i++)
+		{
+			if (Entities.List[i]) ids[count++] = i;
+		}
+		return count;
+	}
+
+	radius += ENTITYGRID_MARGIN;
+	x1 = EntityGrid_Coord(pos->x - radius, grid_width); x2 = EntityGrid_Coord(pos->x + radius, grid_width);
+	z1 = EntityGrid_Coord(pos->z - radius, grid_length); z2 = EntityGrid_Coord(pos->z + radius, grid_length);
+
+	for (z = z1; z <= z2; z++) {
+		for (x = x1; x <= x2; x++) {
+			for (i = grid_heads[z * grid_width + x]; i != ENTITYGRID_NONE; i = grid_next[i])
+			{
+				/* Entity might have been removed since grid was last rebuilt */
+				if (Entities.List[i]) ids[count++] = i;
+			}
+		}
+	}
+	return count;
+}
+
+
 /*########################################################################################################################*
 *--------------------------------------------------------Entities---------------------------------------------------------*
 *#########################################################################################################################*/
 struct _EntitiesData Entities;
+static struct LocationUpdate queued_updates[MAX_NET_PLAYERS];
+static cc_bool queued_pending[MAX_NET_PLAYERS];
+
+/* Combines a later location update into an earlier location update */
+#define LU_HAS_ORI (LU_HAS_PITCH | LU_HAS_YAW | LU_HAS_ROTX | LU_HAS_ROTZ)
+static void LocationUpdate_Combine(struct LocationUpdate* dst, const struct LocationUpdate* src) {
+	cc_uint8 dstMode = dst->flags & LU_POS_MODEMASK;
+	cc_uint8 srcMode = src->flags & LU_POS_MODEMASK;
+	cc_uint8 interpolate;
+
+	if (!(src->flags & LU_HAS_POS)) {
+		/* Earlier position (if any) is unchanged */
+	} else if (!(dst->flags & LU_HAS_POS)) {
+		dst->pos = src->pos;
+		dstMode  = srcMode;
+	} else if (srcMode == LU_POS_ABSOLUTE_INSTANT || srcMode == LU_POS_ABSOLUTE_SMOOTH) {
+		dst->pos = src->pos;
+		/* Teleporting takes priority over smoothly moving */
+		if (dstMode != LU_POS_ABSOLUTE_INSTANT) dstMode = srcMode;
+	} else {
+		/* Relative movements just add onto the earlier position */
+		Vec3_AddBy(&dst->pos, &src->pos);
+	}
+
+	if (src->flags & LU_HAS_PITCH) dst->pitch = src->pitch;
+	if (src->flags & LU_HAS_YAW)   dst->yaw   = src->yaw;
+	if (src->flags & LU_HAS_ROTX)  dst->rotX  = src->rotX;
+	if (src->flags & LU_HAS_ROTZ)  dst->rotZ  = src->rotZ;
+
+	/* Only interpolate orientation if both updates would have */
+	interpolate = dst->flags & LU_ORI_INTERPOLATE;
+	if (!(dst->flags & LU_HAS_ORI)) {
+		interpolate = src->flags & LU_ORI_INTERPOLATE;
+	} else if (src->flags & LU_HAS_ORI) {
+		interpolate &= src->flags;
+	}
+
+	dst->flags |= src->flags;
+	dst->flags &= ~(LU_POS_MODEMASK | LU_ORI_INTERPOLATE);
+	dst->flags |= dstMode | interpolate;
+}
+
+void Entities_QueueLocation(int id, const struct LocationUpdate* update) {
+	struct Entity* e;
+	if (id >= MAX_NET_PLAYERS) {
+		e = Entities.List[id];
+		if (e) e->VTABLE->SetLocation(e, (struct LocationUpdate*)update);
+		return;
+	}
+
+	if (queued_pending[id]) {
+		LocationUpdate_Combine(&queued_updates[id], update);
+	} else {
+		queued_updates[id] = *update;
+		queued_pending[id] = true;
+	}
+}
+
+static void Entities_ApplyQueuedLocations(void) {
+	struct Entity* e;
+	int i;
+
+	for (i = 0; i < MAX_NET_PLAYERS; i++)
+	{
+		if (!queued_pending[i]) continue;
+		queued_pending[i] = false;
+
+		e = Entities.List[i];
+		if (e) e->VTABLE->SetLocation(e, &queued_updates[i]);
+	}
+}
 
 void Entities_Tick(struct ScheduledTask* task) {
 	int i;
+	Entities_ApplyQueuedLocations();
+	EntityGrid_Rebuild();
+	SkinDownloads_Process();
+
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++)
 	{
 		if (!Entities.List[i]) continue;
 		Entities.List[i]->VTABLE->Tick(Entities.List[i], task->interval);
 	}
+	Entities_EvictSkins();
 }
 
 void Entities_RenderModels(float delta, float t) {
-	int i;
+	struct Entity* e;
+	int i, page;
 	Gfx_SetAlphaTest(true);
 	
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++)
+	/* Render entities grouped by skin atlas page, to reduce texture changes */
+	for (page = 0; page <= SKINATLAS_MAX_PAGES; page++)
 	{
-		if (!Entities.List[i]) continue;
-		Entities.List[i]->VTABLE->RenderModel(Entities.List[i], delta, t);
+		for (i = 0; i < ENTITIES_MAX_COUNT; i++)
+		{
+			e = Entities.List[i];
+			if (!e || SkinAtlas_PageOf(e) != page) continue;
+			e->VTABLE->RenderModel(e, delta, t);
+
+			if (e->ShouldRender && (e->Flags & ENTITY_FLAG_HAS_MODELVB)) e->_lastDrawn = Game.Time;
+		}
 	}
+
+	EntityImpostors_Render();
 	Gfx_SetAlphaTest(false);
 }
 
@@ -486,6 +943,7 @@ static void Entities_ContextLost(void* obj) {
 
 void Entities_Remove(int id) {
 	struct Entity* e = Entities.List[id];
+	if (id < MAX_NET_PLAYERS) queued_pending[id] = false;
 	if (!e) return;
 
 	Event_RaiseInt(&EntityEvents.Removed, id);
@@ -1066,7 +1524,31 @@ void LocalPlayer_CalcDefaultSpawn(struct LocalPlayer* p, struct LocationUpdate*
 /*########################################################################################################################*
 *-------------------------------------------------------NetPlayer---------------------------------------------------------*
 *#########################################################################################################################*/
-struct NetPlayer NetPlayers_List[MAX_NET_PLAYERS];
+/* NetPlayers are allocated in blocks as needed, instead of statically reserving memory */
+/*  for every possible player (which is about 240 KB, a lot for some consoles) */
+#define NETPLAYERS_BLOCK_SIZE 16
+#define NETPLAYERS_MAX_BLOCKS ((MAX_NET_PLAYERS + NETPLAYERS_BLOCK_SIZE - 1) / NETPLAYERS_BLOCK_SIZE)
+static struct NetPlayer* netPlayerBlocks[NETPLAYERS_MAX_BLOCKS];
+
+struct NetPlayer* NetPlayers_Get(int id) {
+	int block = id / NETPLAYERS_BLOCK_SIZE;
+	if (id < 0 || id >= MAX_NET_PLAYERS) return NULL;
+
+	if (!netPlayerBlocks[block]) {
+		netPlayerBlocks[block] = (struct NetPlayer*)Mem_TryAllocCleared(NETPLAYERS_BLOCK_SIZE, sizeof(struct NetPlayer));
+		if (!netPlayerBlocks[block]) return NULL;
+	}
+	return &netPlayerBlocks[block][id % NETPLAYERS_BLOCK_SIZE];
+}
+
+static void NetPlayers_Free(void) {
+	int i;
+	for (i = 0; i < NETPLAYERS_MAX_BLOCKS; i++)
+	{
+		Mem_Free(netPlayerBlocks[i]);
+		netPlayerBlocks[i] = NULL;
+	}
+}
 
 static void NetPlayer_SetLocation(struct Entity* e, struct LocationUpdate* update) {
 	struct NetPlayer* p = (struct NetPlayer*)e;
@@ -1081,16 +1563,38 @@ static void NetPlayer_Tick(struct Entity* e, float delta) {
 	AnimatedComp_Update(e, e->prev.pos, e->next.pos, delta);
 }
 
+/* Beyond this distance, players are drawn without limb animations */
+#define NETPLAYER_LOD_ANIM_DIST     (48 * 48)
+/* Beyond this distance, players are drawn as a single box instead of their model */
+#define NETPLAYER_LOD_IMPOSTOR_DIST (128 * 128)
+
 static void NetPlayer_RenderModel(struct Entity* e, float delta, float t) {
+	float distance;
 	Vec3_Lerp(&e->Position, &e->prev.pos, &e->next.pos, t);
-	Entity_LerpAngles(e, t);
 
-	AnimatedComp_GetCurrent(e, t);
 	e->ShouldRender = Model_ShouldRender(e);
+	if (!e->ShouldRender) return;
+	distance = Model_RenderDistance(e);
+
 	/* Original classic only shows players up to 64 blocks away */
-	if (Game_ClassicMode) e->ShouldRender &= Model_RenderDistance(e) <= 64 * 64;
+	if (Game_ClassicMode) {
+		e->ShouldRender = distance <= 64 * 64;
+		if (!e->ShouldRender) return;
+	}
 
-	if (e->ShouldRender) Model_Render(e->Model, e);
+	/* Impostors are axis aligned, so angles don't need interpolating either */
+	if (distance > NETPLAYER_LOD_IMPOSTOR_DIST) {
+		AnimatedComp_SetRest(e);
+		EntityImpostors_Add(e); return;
+	}
+	Entity_LerpAngles(e, t);
+
+	if (distance > NETPLAYER_LOD_ANIM_DIST) {
+		AnimatedComp_SetRest(e);
+	} else {
+		AnimatedComp_GetCurrent(e, t);
+	}
+	Model_Render(e->Model, e);
 }
 
 static cc_bool NetPlayer_ShouldRenderName(struct Entity* e) {
@@ -1150,6 +1654,9 @@ static void Entities_Free(void) {
 		Entities_Remove(i);
 	}
 	sources_head = NULL;
+	EntityGrid_Free();
+	SkinDownloads_Clear();
+	NetPlayers_Free();
 }
 
 struct IGameComponent Entities_Component = {
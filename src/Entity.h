@@ -89,10 +89,12 @@ struct EntityVTABLE {
 #define SKIN_FETCH_DOWNLOADING 1
 /* Skin was downloaded or copied from another entity with the same skin. */
 #define SKIN_FETCH_COMPLETED   2
+/* Skin was freed to stay within the VRAM budget, and is fetched again once the entity is next drawn */
+#define SKIN_FETCH_EVICTED     3
 
 /* true to restrict model scale (needed for local player, giant model collisions are too costly) */
 #define ENTITY_FLAG_MODEL_RESTRICTED_SCALE 0x01
-/* Whether the ModelVB field of this Entity instance refers to valid memory */
+/* Whether the ModelVB field (and all fields after it) of this Entity instance refers to valid memory */
 /* This is just a hack to work around CEF plugin which declares Entity structs instances, */
 /*   but those instances are declared using the older struct definition which lacked the ModelVB field */
 /* And therefore trying to access the ModelVB Field in entity struct instances created by the CEF plugin */
@@ -102,6 +104,17 @@ struct EntityVTABLE {
 /*  to replicate the behaviour of the original vanilla classic client */
 #define ENTITY_FLAG_CLASSIC_ADJUST 0x04
 
+/* Inputs that the vertices cached in an entity's ModelVB were built from */
+/* If these still match when rendering, the cached vertices can be reused as is */
+struct ModelMeshKey {
+	struct Model* model;
+	float uScale, vScale, uOffset, vOffset;
+	PackedCol col;
+	cc_uint8 skinType;
+	cc_bool noShade;
+	int extra; /* Model specific input, e.g. block and atlas version for block models */
+};
+
 /* Contains a model, along with position, velocity, and rotation. May also contain other fields and properties. */
 struct Entity {
 	const struct EntityVTABLE* VTABLE;
@@ -133,6 +146,13 @@ struct Entity {
 	/*  Current state is linearly interpolated between prev and next */
 	struct EntityLocation prev, next;
 	GfxResourceID ModelVB;
+	/* Offset of this entity's skin within TextureId, when the skin is packed into the skin atlas */
+	float uOffset, vOffset;
+	cc_uint16 _skinSlot; /* 1 + index of slot in the skin atlas, 0 if skin has its own texture */
+	struct ModelMeshKey _meshKey;
+	cc_uint16 _nameSlot; /* 1 + index of slot in the name tag atlas, 0 if name has its own texture */
+	cc_uint32 _skinBytes; /* Bytes of video memory used by the skin, 0 if skin is in the skin atlas */
+	double _lastDrawn;    /* Value of Game.Time when this entity was last drawn */
 };
 typedef cc_bool (*Entity_TouchesCondition)(BlockID block);
 
@@ -168,15 +188,18 @@ void Entity_SetSkin(struct Entity* e, const cc_string* skin);
 void Entity_LerpAngles(struct Entity* e, float t);
 
 /* Global data for all entities */
-/* (Actual entities may point to NetPlayers_List or elsewhere) */
+/* (Actual entities may point to NetPlayers_Get storage or elsewhere) */
 CC_VAR extern struct _EntitiesData {
 	struct Entity* List[ENTITIES_MAX_COUNT];
 	cc_uint8 NamesMode, ShadowsMode;
 	struct LocalPlayer* CurPlayer;
 } Entities;
 
-/* Ticks all entities */
+/* Ticks all entities, after first applying any queued location updates */
 void Entities_Tick(struct ScheduledTask* task);
+/* Queues a location update for the given network entity, to be applied just before entities are next ticked */
+/* NOTE: Multiple updates queued for the same entity are combined into one update */
+void Entities_QueueLocation(int id, const struct LocationUpdate* update);
 /* Renders all entities */
 void Entities_RenderModels(float delta, float t);
 /* Removes the given entity, raising EntityEvents.Removed event */
@@ -184,6 +207,10 @@ void Entities_Remove(int id);
 /* Gets the ID of the closest entity to the given entity */
 /* Returns -1 if there is no other entity nearby */
 int Entities_GetClosest(struct Entity* src);
+/* Gets the IDs of the entities that may be within 'radius' blocks horizontally of the given position, */
+/*  returning the number of IDs written (which is at most ENTITIES_MAX_COUNT) */
+/* NOTE: Uses positions from the start of the current tick, so callers must still check exact distances */
+int Entities_GetNearby(const Vec3* pos, float radius, int* ids);
 
 #define TABLIST_MAX_NAMES 256
 /* Data for all entries in tab list */
@@ -224,7 +251,9 @@ struct NetPlayer {
 	struct NetInterpComp Interp;
 };
 CC_API void NetPlayer_Init(struct NetPlayer* player);
-extern struct NetPlayer NetPlayers_List[MAX_NET_PLAYERS];
+/* Returns the storage for the network player with the given ID */
+/* NOTE: Returns NULL if the ID is invalid, or if out of memory */
+struct NetPlayer* NetPlayers_Get(int id);
 
 struct LocalPlayerInput;
 struct LocalPlayerInput {
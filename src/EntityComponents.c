@@ -13,6 +13,7 @@
 #include "Physics.h"
 #include "Model.h"
 #include "Audio.h"
+#include "Server.h"
 
 /*########################################################################################################################*
 *----------------------------------------------------AnimatedComponent----------------------------------------------------*
@@ -111,6 +112,16 @@ void AnimatedComp_GetCurrent(struct Entity* e, float t) {
 	}
 }
 
+void AnimatedComp_SetRest(struct Entity* e) {
+	struct AnimatedComp* anim = &e->Anim;
+	anim->Swing    = 0.0f;
+	anim->WalkTime = anim->WalkTimeN;
+
+	anim->LeftLegX  = 0.0f; anim->LeftLegZ  = 0.0f; anim->RightLegX = 0.0f; anim->RightLegZ = 0.0f;
+	anim->LeftArmX  = 0.0f; anim->LeftArmZ  = 0.0f; anim->RightArmX = 0.0f; anim->RightArmZ = 0.0f;
+	anim->BobbingHor = 0.0f; anim->BobbingVer = 0.0f; anim->BobbingModel = 0.0f;
+}
+
 
 /*########################################################################################################################*
 *------------------------------------------------------TiltComponent------------------------------------------------------*
@@ -332,6 +343,9 @@ static void NetInterpComp_AddPosition(struct NetInterpComp* interp, Vec3 pos) {
 	interp->Positions[interp->PositionsCount++] = pos;
 }
 
+/* Max number of ticks between position updates that is considered to be regular movement */
+#define NETINTERP_MAX_INTERVAL 4
+
 static void NetInterpComp_SetPosition(struct NetInterpComp* interp, struct LocationUpdate* update, struct Entity* e, int mode) {
 	Vec3 lastPos = interp->CurPos;
 	Vec3* curPos = &interp->CurPos;
@@ -347,7 +361,14 @@ static void NetInterpComp_SetPosition(struct NetInterpComp* interp, struct Locat
 		e->prev.pos = *curPos;
 		e->next.pos = *curPos;
 		interp->PositionsCount = 0;
+
+		Vec3_Set(interp->Velocity, 0, 0, 0);
+		interp->ExtrapolatedTicks = 0;
+		interp->Buffering = false;
 	} else {
+		interp->UpdateInterval   = min(interp->TicksSinceUpdate, NETINTERP_MAX_INTERVAL);
+		interp->TicksSinceUpdate = 0;
+
 		/* Smoother interpolation by also adding midpoint */
 		Vec3_Lerp(&midPos, &lastPos, curPos, 0.5f);
 		NetInterpComp_AddPosition(interp,  midPos);
@@ -406,14 +427,88 @@ void NetInterpComp_SetLocation(struct NetInterpComp* interp, struct LocationUpda
 	}
 }
 
-void NetInterpComp_AdvanceState(struct NetInterpComp* interp, struct Entity* e) {
-	e->prev     = e->next;
-	e->Position = e->prev.pos;
+/* Max number of extra position states that are buffered to absorb jitter in packet arrival */
+#define NETINTERP_MAX_BUFFER 4
+/* Max number of ticks the position is extrapolated for when no states are queued */
+#define NETINTERP_MAX_EXTRAPOLATE 3
+/* Number of ticks without running out of states, before buffering one less state */
+#define NETINTERP_STABLE_TICKS 100
+
+/* Calculates how many position states should be queued up before they start being used */
+static int NetInterpComp_BufferTarget(struct NetInterpComp* interp) {
+	/* Higher latency connections usually also have more variance in arrival time */
+	int target = Ping_AveragePingMS() / 50 + interp->BufferExtra;
+	return min(target, NETINTERP_MAX_BUFFER);
+}
+
+static void NetInterpComp_Extrapolate(struct NetInterpComp* interp, struct Entity* e) {
+	if (interp->ExtrapolatedTicks == NETINTERP_MAX_EXTRAPOLATE) return;
+
+	/* Halve velocity each tick, to reduce overshoot when the player actually stopped */
+	Vec3_Mul1By(&interp->Velocity, 0.5f);
+	Vec3_AddBy(&e->next.pos, &interp->Velocity);
+	interp->ExtrapolatedTicks++;
+}
+
+static cc_bool NetInterpComp_IsBehind(struct NetInterpComp* interp, struct Entity* e) {
+	Vec3 delta;
+	Vec3_Sub(&delta, &interp->Positions[0], &e->prev.pos);
+	return delta.x * interp->Velocity.x + delta.y * interp->Velocity.y + delta.z * interp->Velocity.z < 0.0f;
+}
+
+static void NetInterpComp_AdvancePosition(struct NetInterpComp* interp, struct Entity* e) {
+	int target = NetInterpComp_BufferTarget(interp);
+	cc_bool expectingUpdate;
+
+	interp->TicksSinceUpdate++;
+	expectingUpdate = interp->TicksSinceUpdate <= interp->UpdateInterval * 2;
+
+	if (interp->Buffering && expectingUpdate && interp->PositionsCount < target) {
+		NetInterpComp_Extrapolate(interp, e); return;
+	}
+	interp->Buffering = false;
+
+	/* Drop oldest states when too far behind, instead of lagging further and further behind */
+	while (interp->PositionsCount > target + NETINTERP_MAX_BUFFER) {
+		NetInterpComp_RemoveOldestPosition(interp);
+	}
 
 	if (interp->PositionsCount) {
+		/* Skip over states that extrapolation already moved the entity past */
+		while (interp->ExtrapolatedTicks && interp->PositionsCount > 1 && NetInterpComp_IsBehind(interp, e)) {
+			NetInterpComp_RemoveOldestPosition(interp);
+		}
+
 		e->next.pos = interp->Positions[0];
 		NetInterpComp_RemoveOldestPosition(interp);
+
+		Vec3_Sub(&interp->Velocity, &e->next.pos, &e->prev.pos);
+		interp->ExtrapolatedTicks = 0;
+
+		if (++interp->StableTicks >= NETINTERP_STABLE_TICKS && interp->BufferExtra) {
+			interp->BufferExtra--;
+			interp->StableTicks = 0;
+		}
+	} else if (!expectingUpdate) {
+		/* Server stopped sending updates, so entity most likely stopped moving */
+		e->next.pos = interp->CurPos;
+		interp->ExtrapolatedTicks = 0;
+	} else {
+		if (!interp->ExtrapolatedTicks) {
+			/* States arrived late, so buffer more of them to avoid this happening again */
+			if (interp->BufferExtra < NETINTERP_MAX_BUFFER) interp->BufferExtra++;
+			interp->StableTicks = 0;
+			interp->Buffering   = true;
+		}
+		NetInterpComp_Extrapolate(interp, e);
 	}
+}
+
+void NetInterpComp_AdvanceState(struct NetInterpComp* interp, struct Entity* e) {
+	e->prev     = e->next;
+	e->Position = e->prev.pos;
+
+	NetInterpComp_AdvancePosition(interp, e);
 	if (interp->AnglesCount) {
 		NetInterpAngles_Copy(e->next, &interp->Angles[0]);
 		NetInterpComp_RemoveOldestAngles(interp);
@@ -1034,11 +1129,14 @@ void PhysicsComp_DoEntityPush(struct Entity* entity) {
 	cc_bool yIntersects;
 	Vec3 dir;
 	float dist, pushStrength;
-	int id;
+	int ids[ENTITIES_MAX_COUNT];
+	int i, count;
 	dir.y = 0.0f;
 
-	for (id = 0; id < ENTITIES_MAX_COUNT; id++) {
-		other = Entities.List[id];
+	/* Only entities within 1 block horizontally can push */
+	count = Entities_GetNearby(&entity->Position, 1.0f, ids);
+	for (i = 0; i < count; i++) {
+		other = Entities.List[ids[i]];
 		if (!other || other == entity) continue;
 		if (!other->Model->pushes)     continue;
 
@@ -25,6 +25,8 @@ struct AnimatedComp {
 void AnimatedComp_Init(struct AnimatedComp* anim);
 void AnimatedComp_Update(struct Entity* entity, Vec3 oldPos, Vec3 newPos, float delta);
 void AnimatedComp_GetCurrent(struct Entity* entity, float t);
+/* Resets limbs and bobbing to their rest pose, without calculating walking animation */
+void AnimatedComp_SetRest(struct Entity* entity);
 
 /* Entity component that performs tilt animation depending on movement speed and time */
 struct TiltComp {
@@ -99,6 +101,12 @@ struct NetInterpComp {
 	/* Interpolated position and orientation state */
 	int PositionsCount, AnglesCount;
 	Vec3 Positions[10]; struct NetInterpAngles Angles[10];
+	/* Movement per tick, used to extrapolate position when no states are queued */
+	Vec3 Velocity; int ExtrapolatedTicks;
+	/* Number of ticks since last position update, and between the last two updates */
+	int TicksSinceUpdate, UpdateInterval;
+	/* Adaptive jitter buffer state */
+	int BufferExtra, StableTicks; cc_bool Buffering;
 };
 
 void NetInterpComp_SetLocation(struct NetInterpComp* interp, struct LocationUpdate* update, struct Entity* e);
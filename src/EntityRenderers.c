@@ -11,6 +11,7 @@
 #include "World.h"
 #include "Particle.h"
 #include "Drawer2D.h"
+#include "Platform.h"
 
 /*########################################################################################################################*
 *------------------------------------------------------Entity Shadow------------------------------------------------------*
@@ -162,13 +163,67 @@ static cc_bool EntityShadow_GetBlocks(struct Entity* e, int x, int y, int z, str
 	return true;
 }
 
-static void EntityShadow_Draw(struct Entity* e) {
-	struct VertexTextured vertices[128]; /* TODO this is less than maxVertes */
+/* Results of probing the blocks underneath an entity, which are reused until the entity moves */
+struct ShadowCache {
+	struct Entity* owner;
+	Vec3 pos;
+	float radius;
+	cc_uint32 epoch;
+	cc_uint8 mode;
+	struct ShadowData data[4][4];
+};
+static struct ShadowCache shadows_playerCache;
+static struct ShadowCache shadows_caches[ENTITIES_MAX_COUNT];
+/* Incremented whenever blocks or the world change, which invalidates all cached probe results */
+static cc_uint32 shadows_epoch = 1;
+
+/* Shadows of all entities are accumulated into one batch, which is drawn by EntityShadows_Flush */
+#define SHADOW_BATCH_VERTS (16 * SHADOW_MAX_VERTS)
+static struct VertexTextured shadows_batch[SHADOW_BATCH_VERTS];
+static int shadows_batchCount;
+
+static void EntityShadows_Flush(void) {
+	if (!shadows_batchCount) return;
+
+	if (!shadows_boundTex) {
+		Gfx_BindTexture(shadows_tex);
+		shadows_boundTex = true;
+	}
+
+	Gfx_SetDynamicVbData(shadows_VB, shadows_batch, shadows_batchCount);
+	Gfx_DrawVb_IndexedTris(shadows_batchCount);
+	shadows_batchCount = 0;
+}
+
+static void EntityShadow_Probe(struct Entity* e, struct ShadowCache* cache, int y) {
+	int x1, z1, x2, z2;
+	Vec3 pos = e->Position;
+
+	if (Entities.ShadowsMode == SHADOW_MODE_SNAP_TO_BLOCK) {
+		x1 = Math_Floor(pos.x); z1 = Math_Floor(pos.z);
+		EntityShadow_GetBlocks(e, x1, y, z1, cache->data[0]);
+	} else {
+		x1 = Math_Floor(pos.x - shadow_radius); z1 = Math_Floor(pos.z - shadow_radius);
+		x2 = Math_Floor(pos.x + shadow_radius); z2 = Math_Floor(pos.z + shadow_radius);
+
+		EntityShadow_GetBlocks(e, x1, y, z1, cache->data[0]);
+		if (x1 != x2)             EntityShadow_GetBlocks(e, x2, y, z1, cache->data[1]);
+		if (z1 != z2)             EntityShadow_GetBlocks(e, x1, y, z2, cache->data[2]);
+		if (x1 != x2 && z1 != z2) EntityShadow_GetBlocks(e, x2, y, z2, cache->data[3]);
+	}
+
+	cache->owner  = e;
+	cache->pos    = pos;
+	cache->epoch  = shadows_epoch;
+	cache->mode   = Entities.ShadowsMode;
+}
+
+static void EntityShadow_Draw(struct Entity* e, struct ShadowCache* cache) {
 	struct VertexTextured* ptr;
-	struct ShadowData data[4];
+	struct ShadowData* data;
 	Vec3 pos;
 	float radius;
-	int y, count;
+	int y;
 	int x1, z1, x2, z2;
 
 	pos = e->Position;
@@ -179,42 +234,46 @@ static void EntityShadow_Draw(struct Entity* e) {
 	shadow_radius  = radius / 16.0f;
 	shadow_uvScale = 16.0f / (radius * 2.0f);
 
-	ptr = vertices;
+	if (cache->owner != e || !Vec3_Equals(&cache->pos, &pos) || cache->radius != radius ||
+		cache->epoch != shadows_epoch || cache->mode != Entities.ShadowsMode) {
+		cache->radius = radius;
+		EntityShadow_Probe(e, cache, y);
+	}
+
+	if (shadows_batchCount + SHADOW_MAX_VERTS > SHADOW_BATCH_VERTS) EntityShadows_Flush();
+	ptr = &shadows_batch[shadows_batchCount];
+
 	if (Entities.ShadowsMode == SHADOW_MODE_SNAP_TO_BLOCK) {
 		x1 = Math_Floor(pos.x); z1 = Math_Floor(pos.z);
-		if (!EntityShadow_GetBlocks(e, x1, y, z1, data)) return;
-
-		EntityShadow_DrawSquareShadow(&ptr, data[0].y, x1, z1);
+		EntityShadow_DrawSquareShadow(&ptr, cache->data[0][0].y, x1, z1);
 	} else {
 		x1 = Math_Floor(pos.x - shadow_radius); z1 = Math_Floor(pos.z - shadow_radius);
 		x2 = Math_Floor(pos.x + shadow_radius); z2 = Math_Floor(pos.z + shadow_radius);
 
-		if (EntityShadow_GetBlocks(e, x1, y, z1, data) && data[0].alpha > 0) {
+		data = cache->data[0];
+		if (data[0].alpha > 0) {
 			EntityShadow_DrawCircle(&ptr, e, data, (float)x1, (float)z1);
 		}
-		if (x1 != x2 && EntityShadow_GetBlocks(e, x2, y, z1, data) && data[0].alpha > 0) {
+		data = cache->data[1];
+		if (x1 != x2 && data[0].alpha > 0) {
 			EntityShadow_DrawCircle(&ptr, e, data, (float)x2, (float)z1);
 		}
-		if (z1 != z2 && EntityShadow_GetBlocks(e, x1, y, z2, data) && data[0].alpha > 0) {
+		data = cache->data[2];
+		if (z1 != z2 && data[0].alpha > 0) {
 			EntityShadow_DrawCircle(&ptr, e, data, (float)x1, (float)z2);
 		}
-		if (x1 != x2 && z1 != z2 && EntityShadow_GetBlocks(e, x2, y, z2, data) && data[0].alpha > 0) {
+		data = cache->data[3];
+		if (x1 != x2 && z1 != z2 && data[0].alpha > 0) {
 			EntityShadow_DrawCircle(&ptr, e, data, (float)x2, (float)z2);
 		}
 	}
-
-	if (ptr == vertices) return;
-
-	if (!shadows_boundTex) {
-		Gfx_BindTexture(shadows_tex);
-		shadows_boundTex = true;
-	}
-
-	count = (int)(ptr - vertices);
-	Gfx_SetDynamicVbData(shadows_VB, vertices, count);
-	Gfx_DrawVb_IndexedTris(count);
+	shadows_batchCount = (int)(ptr - shadows_batch);
 }
 
+static void EntityShadows_Invalidate(void* obj) { shadows_epoch++; }
+static void EntityShadows_EnvVarChanged(void* obj, int envVar) { shadows_epoch++; }
+void EntityShadows_OnBlockChanged(void) { shadows_epoch++; }
+
 
 /*########################################################################################################################*
 *-----------------------------------------------------Entity Shadows------------------------------------------------------*
@@ -251,23 +310,24 @@ void EntityShadows_Render(void) {
 	if (!shadows_tex) 
 		EntityShadows_MakeTexture();
 	if (!shadows_VB)
-		shadows_VB = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, SHADOW_MAX_VERTS);
+		shadows_VB = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, SHADOW_BATCH_VERTS);
 
 	Gfx_SetAlphaArgBlend(true);
 	Gfx_SetDepthWrite(false);
 	Gfx_SetAlphaBlending(true);
 
 	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
-	EntityShadow_Draw(&Entities.CurPlayer->Base);
+	EntityShadow_Draw(&Entities.CurPlayer->Base, &shadows_playerCache);
 
 	if (Entities.ShadowsMode == SHADOW_MODE_CIRCLE_ALL) {	
 		for (i = 0; i < ENTITIES_MAX_COUNT; i++) 
 		{
 			e = Entities.List[i];
 			if (!e || !e->ShouldRender || e == &Entities.CurPlayer->Base) continue;
-			EntityShadow_Draw(e);
+			EntityShadow_Draw(e, &shadows_caches[i]);
 		}
 	}
+	EntityShadows_Flush();
 
 	Gfx_SetAlphaArgBlend(false);
 	Gfx_SetDepthWrite(true);
@@ -282,6 +342,131 @@ static GfxResourceID names_VB;
 #define NAME_IS_EMPTY -30000
 #define NAME_OFFSET 3 /* offset of back layer of name above an entity */
 
+/* Name tags are packed together into a few larger textures, so that they can all be drawn in a few batches */
+#define NAMEATLAS_WIDTH     512
+#define NAMEATLAS_HEIGHT    512
+#define NAMEATLAS_SLOT_H    32
+#define NAMEATLAS_SLOTS     (NAMEATLAS_HEIGHT / NAMEATLAS_SLOT_H)
+#define NAMEATLAS_MAX_PAGES 8
+/* Entities created by plugins may use older struct definition which lacks the name atlas field */
+#define Entity_NameSlot(e) (((e)->Flags & ENTITY_FLAG_HAS_MODELVB) ? (e)->_nameSlot : 0)
+
+static GfxResourceID nameAtlas_pages[NAMEATLAS_MAX_PAGES];
+static struct Entity* nameAtlas_owners[NAMEATLAS_MAX_PAGES][NAMEATLAS_SLOTS];
+static cc_uint32 nameAtlas_lastUsed[NAMEATLAS_MAX_PAGES][NAMEATLAS_SLOTS];
+static int nameAtlas_counts[NAMEATLAS_MAX_PAGES];
+static cc_uint32 nameAtlas_frame;
+
+/* Vertices of the name tags queued for drawing from each atlas page */
+static struct VertexTextured names_batch[NAMEATLAS_MAX_PAGES][NAMEATLAS_SLOTS * 4];
+static int names_batchCount[NAMEATLAS_MAX_PAGES];
+
+static cc_bool NameAtlas_CreatePage(int page) {
+	struct Bitmap bmp;
+	int flags = TEXTURE_FLAG_DYNAMIC | TEXTURE_FLAG_LOWRES;
+	if (!Gfx_CheckTextureSize(NAMEATLAS_WIDTH, NAMEATLAS_HEIGHT, flags)) return false;
+
+	Bitmap_TryAllocate(&bmp, NAMEATLAS_WIDTH, NAMEATLAS_HEIGHT);
+	if (!bmp.scan0) return false;
+	Mem_Set(bmp.scan0, 0, Bitmap_DataSize(NAMEATLAS_WIDTH, NAMEATLAS_HEIGHT));
+
+	nameAtlas_pages[page] = Gfx_CreateTexture(&bmp, flags, false);
+	Mem_Free(bmp.scan0);
+
+	if (!nameAtlas_pages[page]) return false;
+	Game_VRAMUsage[VRAM_NAMES] += Bitmap_DataSize(NAMEATLAS_WIDTH, NAMEATLAS_HEIGHT);
+	return true;
+}
+
+static void NameAtlas_Release(int id) {
+	int page = (id - 1) / NAMEATLAS_SLOTS;
+	int slot = (id - 1) % NAMEATLAS_SLOTS;
+
+	nameAtlas_owners[page][slot] = NULL;
+	nameAtlas_counts[page]--;
+	if (nameAtlas_counts[page]) return;
+
+	Gfx_DeleteTexture(&nameAtlas_pages[page]);
+	Game_VRAMUsage[VRAM_NAMES] -= Bitmap_DataSize(NAMEATLAS_WIDTH, NAMEATLAS_HEIGHT);
+}
+
+/* Evicts the name tag that has gone the longest without being drawn */
+/* Returns false if every name tag in the atlas was drawn this frame */
+static cc_bool NameAtlas_EvictOldest(void) {
+	int page, slot, bestPage = -1, bestSlot = 0;
+	cc_uint32 oldest = nameAtlas_frame;
+
+	for (page = 0; page < NAMEATLAS_MAX_PAGES; page++)
+	{
+		if (!nameAtlas_pages[page]) continue;
+		for (slot = 0; slot < NAMEATLAS_SLOTS; slot++)
+		{
+			if (nameAtlas_lastUsed[page][slot] >= oldest) continue;
+			oldest   = nameAtlas_lastUsed[page][slot];
+			bestPage = page; bestSlot = slot;
+		}
+	}
+
+	if (bestPage == -1) return false;
+	EntityNames_Delete(nameAtlas_owners[bestPage][bestSlot]);
+	return true;
+}
+
+/* Returns 1 + index of a newly reserved slot, or 0 if no slots are free */
+static int NameAtlas_Reserve(struct Entity* owner) {
+	int page, slot;
+	for (page = 0; page < NAMEATLAS_MAX_PAGES; page++)
+	{
+		if (nameAtlas_counts[page] == NAMEATLAS_SLOTS) continue;
+		if (!nameAtlas_pages[page] && !NameAtlas_CreatePage(page)) return 0;
+
+		for (slot = 0; slot < NAMEATLAS_SLOTS; slot++)
+		{
+			if (nameAtlas_owners[page][slot]) continue;
+			nameAtlas_owners[page][slot]   = owner;
+			nameAtlas_lastUsed[page][slot] = nameAtlas_frame;
+			nameAtlas_counts[page]++;
+			return 1 + page * NAMEATLAS_SLOTS + slot;
+		}
+	}
+	return 0;
+}
+
+/* Attempts to store the given name tag in the name atlas, instead of in its own texture */
+static cc_bool NameAtlas_TryAdd(struct Entity* e, struct Context2D* ctx) {
+	int id, page, slot;
+	if (!(e->Flags & ENTITY_FLAG_HAS_MODELVB) || Gfx.NoUVSupport) return false;
+	/* Slot must exactly cover the name's bitmap, otherwise neighbouring slots would be overwritten */
+	if (ctx->bmp.width != NAMEATLAS_WIDTH || ctx->bmp.height != NAMEATLAS_SLOT_H) return false;
+
+	if (!(id = NameAtlas_Reserve(e))) {
+		if (!NameAtlas_EvictOldest()) return false;
+		if (!(id = NameAtlas_Reserve(e))) return false;
+	}
+
+	page = (id - 1) / NAMEATLAS_SLOTS;
+	slot = (id - 1) % NAMEATLAS_SLOTS;
+	Gfx_UpdateTexture(nameAtlas_pages[page], 0, slot * NAMEATLAS_SLOT_H, &ctx->bmp, ctx->bmp.width, false);
+
+	e->_nameSlot      = id;
+	e->NameTex.ID     = nameAtlas_pages[page];
+	e->NameTex.width  = ctx->width;
+	e->NameTex.height = ctx->height;
+
+	e->NameTex.uv.u1  = 0.0f;
+	e->NameTex.uv.v1  = (float)(slot * NAMEATLAS_SLOT_H) / NAMEATLAS_HEIGHT;
+	e->NameTex.uv.u2  = (float)ctx->width / NAMEATLAS_WIDTH;
+	e->NameTex.uv.v2  = (float)(slot * NAMEATLAS_SLOT_H + ctx->height) / NAMEATLAS_HEIGHT;
+	return true;
+}
+
+/* Returns the bytes of video memory used by a name tag with its own texture */
+static cc_uint32 NameTextureBytes(struct Texture* tex) {
+	/* Texture is usually only partially covered by the name tag */
+	if (Gfx.NoUVSupport) return Bitmap_DataSize(tex->width, tex->height);
+	return Bitmap_DataSize((int)(tex->width / tex->uv.u2 + 0.5f), (int)(tex->height / tex->uv.v2 + 0.5f));
+}
+
 static void MakeNameTexture(struct Entity* e) {
 	cc_string colorlessName; char colorlessBuffer[STRING_SIZE];
 	BitmapCol shadowColor = BitmapCol_Make(80, 80, 80, 255);
@@ -310,7 +495,12 @@ static void MakeNameTexture(struct Entity* e) {
 		width  += NAME_OFFSET; 
 		height = Drawer2D_TextHeight(&args) + NAME_OFFSET;
 
-		Context2D_Alloc(&ctx, width, height);
+		/* Draw into a bitmap the size of an atlas slot when possible, so it can be uploaded as is */
+		if (width <= NAMEATLAS_WIDTH && height <= NAMEATLAS_SLOT_H) {
+			Context2D_Alloc(&ctx, NAMEATLAS_WIDTH, NAMEATLAS_SLOT_H);
+		} else {
+			Context2D_Alloc(&ctx, width, height);
+		}
 		{
 			origWhiteColor = Drawer2D.Colors['f'];
 
@@ -323,26 +513,30 @@ static void MakeNameTexture(struct Entity* e) {
 			args.text = name;
 			Context2D_DrawText(&ctx, &args, 0, 0);
 		}
-		Context2D_MakeTexture(&e->NameTex, &ctx);
+		ctx.width = width; ctx.height = height;
+
+		if (!NameAtlas_TryAdd(e, &ctx)) {
+			Context2D_MakeTexture(&e->NameTex, &ctx);
+			if (e->NameTex.ID) Game_VRAMUsage[VRAM_NAMES] += NameTextureBytes(&e->NameTex);
+		}
 		Context2D_Free(&ctx);
 	}
 }
 
 static void DrawName(struct Entity* e) {
 	struct VertexTextured* vertices;
+	struct VertexTextured quad[4];
 	struct Model* model;
 	struct Matrix mat, transform;
 	Vec3 pos;
 	float scale;
 	Vec2 size;
+	int id, page;
 
 	if (!e->VTABLE->ShouldRenderName(e)) return;
 	if (e->NameTex.x == NAME_IS_EMPTY)   return;
 	if (!e->NameTex.ID) MakeNameTexture(e);
-	Gfx_BindTexture(e->NameTex.ID);
-
-	if (!names_VB)
-		names_VB = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, 4);
+	if (e->NameTex.x == NAME_IS_EMPTY)   return;
 
 	model = e->Model;
 	Model_GetEntityTransform(model, e, &transform);
@@ -359,17 +553,61 @@ static void DrawName(struct Entity* e) {
 		size.x *= scale * 0.2f; size.y *= scale * 0.2f;
 	}
 
-	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+	/* Names in the atlas are queued up and drawn together in EntityNames_Flush */
+	if ((id = Entity_NameSlot(e))) {
+		page = (id - 1) / NAMEATLAS_SLOTS;
+		nameAtlas_lastUsed[page][(id - 1) % NAMEATLAS_SLOTS] = nameAtlas_frame;
 
-	vertices = (struct VertexTextured*)Gfx_LockDynamicVb(names_VB, VERTEX_FORMAT_TEXTURED, 4);
-	Particle_DoRender(&size, &pos, &e->NameTex.uv, PACKEDCOL_WHITE, vertices);
-	Gfx_UnlockDynamicVb(names_VB);
+		if (names_batchCount[page] + 4 <= NAMEATLAS_SLOTS * 4) {
+			vertices = &names_batch[page][names_batchCount[page]];
+			Particle_DoRender(&size, &pos, &e->NameTex.uv, PACKEDCOL_WHITE, vertices);
+			names_batchCount[page] += 4;
+		}
+		return;
+	}
 
+	if (!names_VB)
+		names_VB = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, NAMEATLAS_SLOTS * 4);
+
+	Gfx_BindTexture(e->NameTex.ID);
+	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+
+	Particle_DoRender(&size, &pos, &e->NameTex.uv, PACKEDCOL_WHITE, quad);
+	Gfx_SetDynamicVbData(names_VB, quad, 4);
 	Gfx_DrawVb_IndexedTris(4);
 }
 
+/* Draws all the name tags that were queued up by DrawName */
+static void EntityNames_Flush(void) {
+	int page, count;
+
+	for (page = 0; page < NAMEATLAS_MAX_PAGES; page++)
+	{
+		count = names_batchCount[page];
+		if (!count) continue;
+		names_batchCount[page] = 0;
+
+		if (!names_VB)
+			names_VB = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, NAMEATLAS_SLOTS * 4);
+
+		Gfx_BindTexture(nameAtlas_pages[page]);
+		Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+		Gfx_SetDynamicVbData(names_VB, names_batch[page], count);
+		Gfx_DrawVb_IndexedTris(count);
+	}
+}
+
 void EntityNames_Delete(struct Entity* e) {
-	Gfx_DeleteTexture(&e->NameTex.ID);
+	int id = Entity_NameSlot(e);
+
+	if (id) {
+		NameAtlas_Release(id);
+		e->NameTex.ID = 0;
+		e->_nameSlot  = 0;
+	} else if (e->NameTex.ID) {
+		Game_VRAMUsage[VRAM_NAMES] -= NameTextureBytes(&e->NameTex);
+		Gfx_DeleteTexture(&e->NameTex.ID);
+	}
 	e->NameTex.x = 0; /* X is used as an 'empty name' flag */
 }
 
@@ -384,6 +622,7 @@ void EntityNames_Render(void) {
 	cc_bool hadFog;
 	int i;
 
+	nameAtlas_frame++;
 	if (Entities.NamesMode == NAME_MODE_NONE) return;
 	closestEntityId = Entities_GetClosest(&p->Base);
 	if (!p->Hacks.CanSeeAllNames || Entities.NamesMode != NAME_MODE_ALL) return;
@@ -397,6 +636,7 @@ void EntityNames_Render(void) {
 		if (!Entities.List[i]) continue;
 		if (i != closestEntityId) DrawName(Entities.List[i]);
 	}
+	EntityNames_Flush();
 
 	Gfx_SetAlphaTest(false);
 	if (hadFog) Gfx_SetFog(true);
@@ -433,6 +673,8 @@ void EntityNames_RenderHovered(void) {
 	}
 
 	if (!setupState) return;
+	EntityNames_Flush();
+
 	Gfx_SetAlphaTest(false);
 	Gfx_SetDepthTest(true);
 	Gfx_SetDepthWrite(true);
@@ -453,6 +695,64 @@ static void EntityNames_ChatFontChanged(void* obj) {
 }
 
 
+/*########################################################################################################################*
+*----------------------------------------------------Entity impostors-----------------------------------------------------*
+*#########################################################################################################################*/
+#define IMPOSTOR_VERTICES (6 * 4)
+static GfxResourceID impostors_VB;
+static struct Entity* impostors[ENTITIES_MAX_COUNT];
+static int impostorsCount;
+
+void EntityImpostors_Add(struct Entity* e) {
+	if (impostorsCount < ENTITIES_MAX_COUNT) impostors[impostorsCount++] = e;
+}
+
+#define Impostor_V(xx, yy, zz, col) v->x = xx; v->y = yy; v->z = zz; v->Col = col; v++;
+static struct VertexColoured* EntityImpostor_Build(struct Entity* e, struct VertexColoured* v) {
+	PackedCol col = e->VTABLE->GetCol(e);
+	PackedCol colX, colZ, colYMin;
+	struct AABB bb;
+	float x1, y1, z1, x2, y2, z2;
+
+	Entity_GetPickingBounds(e, &bb);
+	x1 = bb.Min.x; y1 = bb.Min.y; z1 = bb.Min.z;
+	x2 = bb.Max.x; y2 = bb.Max.y; z2 = bb.Max.z;
+
+	colX    = e->NoShade ? col : PackedCol_Scale(col, PACKEDCOL_SHADE_X);
+	colZ    = e->NoShade ? col : PackedCol_Scale(col, PACKEDCOL_SHADE_Z);
+	colYMin = e->NoShade ? col : PackedCol_Scale(col, PACKEDCOL_SHADE_YMIN);
+
+	Impostor_V(x1,y1,z1, colX); Impostor_V(x1,y2,z1, colX); Impostor_V(x1,y2,z2, colX); Impostor_V(x1,y1,z2, colX);
+	Impostor_V(x2,y1,z2, colX); Impostor_V(x2,y2,z2, colX); Impostor_V(x2,y2,z1, colX); Impostor_V(x2,y1,z1, colX);
+	Impostor_V(x1,y1,z1, colZ); Impostor_V(x2,y1,z1, colZ); Impostor_V(x2,y2,z1, colZ); Impostor_V(x1,y2,z1, colZ);
+	Impostor_V(x1,y1,z2, colZ); Impostor_V(x1,y2,z2, colZ); Impostor_V(x2,y2,z2, colZ); Impostor_V(x2,y1,z2, colZ);
+	Impostor_V(x1,y1,z1, colYMin); Impostor_V(x1,y1,z2, colYMin); Impostor_V(x2,y1,z2, colYMin); Impostor_V(x2,y1,z1, colYMin);
+	Impostor_V(x1,y2,z1, col); Impostor_V(x2,y2,z1, col); Impostor_V(x2,y2,z2, col); Impostor_V(x1,y2,z2, col);
+	return v;
+}
+
+void EntityImpostors_Render(void) {
+	struct VertexColoured* v;
+	int i, count = impostorsCount;
+	if (!count) return;
+	impostorsCount = 0;
+
+	if (!impostors_VB) {
+		impostors_VB = Gfx_CreateDynamicVb(VERTEX_FORMAT_COLOURED, ENTITIES_MAX_COUNT * IMPOSTOR_VERTICES);
+	}
+
+	Gfx_SetVertexFormat(VERTEX_FORMAT_COLOURED);
+	v = (struct VertexColoured*)Gfx_LockDynamicVb(impostors_VB, VERTEX_FORMAT_COLOURED, count * IMPOSTOR_VERTICES);
+	for (i = 0; i < count; i++) 
+	{
+		v = EntityImpostor_Build(impostors[i], v);
+	}
+
+	Gfx_UnlockDynamicVb(impostors_VB);
+	Gfx_DrawVb_IndexedTris(count * IMPOSTOR_VERTICES);
+}
+
+
 /*########################################################################################################################*
 *-----------------------------------------------Entity renderers component------------------------------------------------*
 *#########################################################################################################################*/
@@ -462,11 +762,16 @@ static void EntityRenderers_ContextLost(void* obj) {
 	
 	Gfx_DeleteDynamicVb(&names_VB);
 	DeleteAllNameTextures();
+	Gfx_DeleteDynamicVb(&impostors_VB);
 }
 
 static void EntityRenderers_Init(void) {
 	Event_Register_(&GfxEvents.ContextLost,  NULL, EntityRenderers_ContextLost);
 	Event_Register_(&ChatEvents.FontChanged, NULL, EntityNames_ChatFontChanged);
+
+	Event_Register_(&WorldEvents.NewMap,          NULL, EntityShadows_Invalidate);
+	Event_Register_(&WorldEvents.EnvVarChanged,   NULL, EntityShadows_EnvVarChanged);
+	Event_Register_(&BlockEvents.BlockDefChanged, NULL, EntityShadows_Invalidate);
 }
 
 static void EntityRenderers_Free(void) {
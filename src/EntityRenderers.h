@@ -12,6 +12,8 @@ struct Entity;
 
 /* Draws shadows under entities, depending on Entities.ShadowsMode */
 void EntityShadows_Render(void);
+/* Invalidates the cached blocks underneath entities that shadows are cast onto */
+void EntityShadows_OnBlockChanged(void);
 
 /* Deletes the texture containing the entity's nametag */
 void EntityNames_Delete(struct Entity* e);
@@ -20,5 +22,11 @@ void EntityNames_Render(void);
 /* Renders hovered entity name tags (these appears through blocks) */
 void EntityNames_RenderHovered(void);
 
+/* Queues the entity to be drawn as a single box the size of its model, instead of drawing its model */
+/* NOTE: Used for entities far away from the camera, where the model's details aren't visible */
+void EntityImpostors_Add(struct Entity* e);
+/* Draws all queued entity impostors in one batch, then clears the queue */
+void EntityImpostors_Render(void);
+
 CC_END_HEADER
 #endif
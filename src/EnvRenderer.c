@@ -21,6 +21,7 @@
 #include "Entity.h"
 
 cc_bool EnvRenderer_Legacy, EnvRenderer_Minimal;
+int EnvRenderer_FogCullDistance;
 
 static float CalcBlendFactor(float x) {
 	float blend = -0.13f + 0.28f * ((float)Math_Log2(x) * 0.17329f);
@@ -86,12 +87,21 @@ static void UpdateFogMinimal(float fogDensity) {
 	}
 }
 
+/* Exp fog mode: f = e^(-density*coord) */
+/* Solve coord for f = 1/255 (colour is then indistinguishable from fog colour) */
+/*   i.e. log(1/255) = -density * coord */
+#define LOG_1_255 -5.54126354515843f
+static int CalcFogCullDistance(float density) {
+	return (int)(LOG_1_255 / -density) + 1;
+}
+
 static void UpdateFogNormal(float fogDensity, PackedCol fogColor) {
 	float density;
 
 	if (fogDensity != 0.0f) {
 		Gfx_SetFogMode(FOG_EXP);
 		Gfx_SetFogDensity(fogDensity);
+		EnvRenderer_FogCullDistance = CalcFogCullDistance(fogDensity);
 	} else if (Env.ExpFog) {
 		Gfx_SetFogMode(FOG_EXP);
 		/* f = 1-z/end   f = e^(-dz)
@@ -104,9 +114,11 @@ static void UpdateFogNormal(float fogDensity, PackedCol fogColor) {
 
 		density = -LOG_001 / (Game_ViewDistance * 0.99f);
 		Gfx_SetFogDensity(density);
+		EnvRenderer_FogCullDistance = CalcFogCullDistance(density);
 	} else {
 		Gfx_SetFogMode(FOG_LINEAR);
 		Gfx_SetFogEnd((float)Game_ViewDistance);
+		EnvRenderer_FogCullDistance = Game_ViewDistance;
 	}
 	Gfx_SetFogCol(fogColor);
 	Game_SetViewDistance(Game_UserViewDistance);
@@ -121,6 +133,7 @@ void EnvRenderer_UpdateFog(void) {
 	Gfx_ClearColor(fogColor);
 
 	if (EnvRenderer_Minimal) {
+		EnvRenderer_FogCullDistance = 0;
 		UpdateFogMinimal(fogDensity);
 	} else {
 		UpdateFogNormal(fogDensity, fogColor);
@@ -131,15 +144,46 @@ void EnvRenderer_UpdateFog(void) {
 /*########################################################################################################################*
 *----------------------------------------------------------Clouds---------------------------------------------------------*
 *#########################################################################################################################*/
+/* Clouds and sky are drawn from a grid of tiles in tile units, which is scaled and moved into place with */
+/*  the view matrix. So changing view distance or clouds height usually doesn't need the mesh rebuilt */
+/*  (only when the grid is too small to cover the map and view distance) */
+
+/* Returns number of tiles along each axis needed to cover the map and view distance */
+static int CalcGridTiles(void) {
+	int extent = Utils_AdjViewDist(Game_ViewDistance);
+	int len    = max(World.Width, World.Length) + extent * 2;
+	return Math_CeilDiv(len, EnvRenderer_AxisSize());
+}
+
+/* Sets the view matrix for drawing a tile grid whose first tile starts at the given height */
+static void LoadGridMatrix(float y) {
+	struct Matrix m, scale, translate;
+	float axisSize = (float)EnvRenderer_AxisSize();
+	float extent   = (float)Utils_AdjViewDist(Game_ViewDistance);
+
+	Matrix_Scale(&scale, axisSize, 1.0f, axisSize);
+	Matrix_Translate(&translate, -extent, y, -extent);
+	Matrix_Mul(&m, &scale, &translate);
+	Matrix_MulBy(&m, &Gfx.View);
+	Gfx_LoadMatrix(MATRIX_VIEW, &m);
+}
+
 static GfxResourceID clouds_vb, clouds_tex;
-static int clouds_vertices;
+static int clouds_vertices, clouds_tiles, clouds_axisSize;
+static PackedCol clouds_col;
 
 void EnvRenderer_RenderClouds(void) {
-	float offset;
+	float offset, base;
+	int extent;
 	if (!clouds_vb || Env.CloudsHeight < -2000) return;
 	offset = (float)(Game.Time / 2048.0f * 0.6f * Env.CloudsSpeed);
 
-	Gfx_EnableTextureOffset(offset, 0);
+	/* adjust range so that largest negative uv coordinate is shifted to 0 or above. */
+	extent = Utils_AdjViewDist(Game_ViewDistance);
+	base   = (float)Math_CeilDiv(extent, 2048) - extent / 2048.0f;
+
+	LoadGridMatrix((float)Env.CloudsHeight + 0.1f);
+	Gfx_EnableTextureOffset(base + offset, base);
 	Gfx_SetAlphaTest(true);
 	Gfx_BindTexture(clouds_tex);
 	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
@@ -147,52 +191,52 @@ void EnvRenderer_RenderClouds(void) {
 	Gfx_DrawVb_IndexedTris(clouds_vertices);
 	Gfx_SetAlphaTest(false);
 	Gfx_DisableTextureOffset();
+	Gfx_LoadMatrix(MATRIX_VIEW, &Gfx.View);
 }
 
-static void DrawCloudsY(int x1, int z1, int x2, int z2, int y, struct VertexTextured* v) {
-	int endX = x2, endZ = z2, startZ = z1, axisSize = EnvRenderer_AxisSize();
-	float u1, u2, v1, v2;
-	float yy = (float)y + 0.1f; 
+static void DrawCloudsY(int tiles, struct VertexTextured* v) {
+	float scale = EnvRenderer_AxisSize() / 2048.0f;
 	PackedCol col = Env.CloudsCol;
-	/* adjust range so that largest negative uv coordinate is shifted to 0 or above. */
-	float offset = (float)Math_CeilDiv(-x1, 2048);
+	float x1, z1, x2, z2;
+	float u1, u2, v1, v2;
+	int x, z;
 
-	for (; x1 < endX; x1 += axisSize) {
-		x2 = x1 + axisSize;
-		if (x2 > endX) x2 = endX;
+	for (x = 0; x < tiles; x++) {
+		x1 = (float)x; x2 = x1 + 1.0f;
+		u1 = x1 * scale; u2 = x2 * scale;
 
-		for (z1 = startZ; z1 < endZ; z1 += axisSize) {
-			z2 = z1 + axisSize;
-			if (z2 > endZ) z2 = endZ;
+		for (z = 0; z < tiles; z++) {
+			z1 = (float)z; z2 = z1 + 1.0f;
+			v1 = z1 * scale; v2 = z2 * scale;
 
-			u1 = (float)x1 / 2048.0f + offset; u2 = (float)x2 / 2048.0f + offset;
-			v1 = (float)z1 / 2048.0f + offset; v2 = (float)z2 / 2048.0f + offset;
-
-			v->x = (float)x1; v->y = yy; v->z = (float)z1; v->Col = col; v->U = u1; v->V = v1; v++;
-			v->x = (float)x1; v->y = yy; v->z = (float)z2; v->Col = col; v->U = u1; v->V = v2; v++;
-			v->x = (float)x2; v->y = yy; v->z = (float)z2; v->Col = col; v->U = u2; v->V = v2; v++;
-			v->x = (float)x2; v->y = yy; v->z = (float)z1; v->Col = col; v->U = u2; v->V = v1; v++;
+			v->x = x1; v->y = 0.0f; v->z = z1; v->Col = col; v->U = u1; v->V = v1; v++;
+			v->x = x1; v->y = 0.0f; v->z = z2; v->Col = col; v->U = u1; v->V = v2; v++;
+			v->x = x2; v->y = 0.0f; v->z = z2; v->Col = col; v->U = u2; v->V = v2; v++;
+			v->x = x2; v->y = 0.0f; v->z = z1; v->Col = col; v->U = u2; v->V = v1; v++;
 		}
 	}
 }
 
 static void UpdateClouds(void) {
 	struct VertexTextured* data;
-	int extent;
-	int x1, z1, x2, z2;
+	int tiles;
 	
-	Gfx_DeleteVb(&clouds_vb);
-	if (!World.Loaded || Gfx.LostContext) return;
-	if (EnvRenderer_Minimal) return;
+	if (!World.Loaded || Gfx.LostContext || EnvRenderer_Minimal) {
+		Gfx_DeleteVb(&clouds_vb); return;
+	}
+	tiles = CalcGridTiles();
+	/* Existing grid can still be reused */
+	if (clouds_vb && tiles <= clouds_tiles && clouds_col == Env.CloudsCol 
+		&& clouds_axisSize == EnvRenderer_AxisSize()) return;
 
-	extent = Utils_AdjViewDist(Game_ViewDistance);
-	x1 = -extent; x2 = World.Width  + extent;
-	z1 = -extent; z2 = World.Length + extent;
-	clouds_vertices = CalcNumVertices(x2 - x1, z2 - z1);
+	clouds_tiles    = tiles;
+	clouds_col      = Env.CloudsCol;
+	clouds_axisSize = EnvRenderer_AxisSize();
+	clouds_vertices = tiles * tiles * 4;
 
 	data = (struct VertexTextured*)Gfx_RecreateAndLockVb(&clouds_vb,
 										VERTEX_FORMAT_TEXTURED, clouds_vertices);
-	DrawCloudsY(x1, z1, x2, z2, Env.CloudsHeight, data);
+	DrawCloudsY(tiles, data);
 	Gfx_UnlockVb(clouds_vb);
 }
 
@@ -201,11 +245,11 @@ static void UpdateClouds(void) {
 *------------------------------------------------------------Sky----------------------------------------------------------*
 *#########################################################################################################################*/
 static GfxResourceID sky_vb;
-static int sky_vertices;
+static int sky_vertices, sky_tiles, sky_axisSize;
+static PackedCol sky_col;
 
 void EnvRenderer_RenderSky(void) {
-	struct Matrix m;
-	float skyY, normY, dy;
+	float skyY, normY;
 	if (!sky_vb || EnvRenderer_ShouldRenderSkybox()) return;
 
 	normY = (float)World.Height + 8.0f;
@@ -213,59 +257,51 @@ void EnvRenderer_RenderSky(void) {
 	Gfx_SetVertexFormat(VERTEX_FORMAT_COLOURED);
 	Gfx_BindVb(sky_vb);
 
-	if (skyY == normY) {
-		Gfx_DrawVb_IndexedTris(sky_vertices);
-	} else {
-		m  = Gfx.View;
-		dy = skyY - normY; 
-		/* inlined Y translation matrix multiply */
-		m.row4.x += dy * m.row2.x; m.row4.y += dy * m.row2.y;
-		m.row4.z += dy * m.row2.z; m.row4.w += dy * m.row2.w;
-
-		Gfx_LoadMatrix(MATRIX_VIEW, &m);
-		Gfx_DrawVb_IndexedTris(sky_vertices);
-		Gfx_LoadMatrix(MATRIX_VIEW, &Gfx.View);
-	}
+	/* Sky is moved up with the camera when above the map */
+	LoadGridMatrix((float)(max((World.Height + 2), Env.CloudsHeight) + 6) + (skyY - normY));
+	Gfx_DrawVb_IndexedTris(sky_vertices);
+	Gfx_LoadMatrix(MATRIX_VIEW, &Gfx.View);
 }
 
-static void DrawSkyY(int x1, int z1, int x2, int z2, int y, struct VertexColoured* v) {
-	int endX = x2, endZ = z2, startZ = z1, axisSize = EnvRenderer_AxisSize();
+static void DrawSkyY(int tiles, struct VertexColoured* v) {
 	PackedCol col = Env.SkyCol;
+	float x1, z1, x2, z2;
+	int x, z;
 
-	for (; x1 < endX; x1 += axisSize) {
-		x2 = x1 + axisSize;
-		if (x2 > endX) x2 = endX;
+	for (x = 0; x < tiles; x++) {
+		x1 = (float)x; x2 = x1 + 1.0f;
 
-		for (z1 = startZ; z1 < endZ; z1 += axisSize) {
-			z2 = z1 + axisSize;
-			if (z2 > endZ) z2 = endZ;
+		for (z = 0; z < tiles; z++) {
+			z1 = (float)z; z2 = z1 + 1.0f;
 
-			v->x = (float)x1; v->y = (float)y; v->z = (float)z1; v->Col = col; v++;
-			v->x = (float)x1; v->y = (float)y; v->z = (float)z2; v->Col = col; v++;
-			v->x = (float)x2; v->y = (float)y; v->z = (float)z2; v->Col = col; v++;
-			v->x = (float)x2; v->y = (float)y; v->z = (float)z1; v->Col = col; v++;
+			v->x = x1; v->y = 0.0f; v->z = z1; v->Col = col; v++;
+			v->x = x1; v->y = 0.0f; v->z = z2; v->Col = col; v++;
+			v->x = x2; v->y = 0.0f; v->z = z2; v->Col = col; v++;
+			v->x = x2; v->y = 0.0f; v->z = z1; v->Col = col; v++;
 		}
 	}
 }
 
 static void UpdateSky(void) {
 	struct VertexColoured* data;
-	int extent, height;
-	int x1, z1, x2, z2;
+	int tiles;
 
-	Gfx_DeleteVb(&sky_vb);
-	if (!World.Loaded || Gfx.LostContext) return;
-	if (EnvRenderer_Minimal) return;
+	if (!World.Loaded || Gfx.LostContext || EnvRenderer_Minimal) {
+		Gfx_DeleteVb(&sky_vb); return;
+	}
+	tiles = CalcGridTiles();
+	/* Existing grid can still be reused */
+	if (sky_vb && tiles <= sky_tiles && sky_col == Env.SkyCol 
+		&& sky_axisSize == EnvRenderer_AxisSize()) return;
 
-	extent = Utils_AdjViewDist(Game_ViewDistance);
-	x1 = -extent; x2 = World.Width  + extent;
-	z1 = -extent; z2 = World.Length + extent;
-	sky_vertices = CalcNumVertices(x2 - x1, z2 - z1);
+	sky_tiles    = tiles;
+	sky_col      = Env.SkyCol;
+	sky_axisSize = EnvRenderer_AxisSize();
+	sky_vertices = tiles * tiles * 4;
 
-	data   = (struct VertexColoured*)Gfx_RecreateAndLockVb(&sky_vb,
+	data = (struct VertexColoured*)Gfx_RecreateAndLockVb(&sky_vb,
 										VERTEX_FORMAT_COLOURED, sky_vertices);
-	height = max((World.Height + 2), Env.CloudsHeight) + 6;
-	DrawSkyY(x1, z1, x2, z2, height, data);
+	DrawSkyY(tiles, data);
 	Gfx_UnlockVb(sky_vb);
 }
 
@@ -345,6 +381,8 @@ cc_int16* Weather_Heightmap;
 static GfxResourceID rain_tex, snow_tex, weather_vb;
 static float weather_accumulator;
 static IVec3 lastPos;
+/* Whether the cached weather columns need to be rebuilt */
+static cc_bool weather_dirty = true;
 
 #define WEATHER_EXTENT 4
 #define WEATHER_VERTS  8 /* 2 quads per tile */
@@ -353,15 +391,6 @@ static IVec3 lastPos;
 #define WEATHER_VERTS_COUNT WEATHER_RANGE * WEATHER_RANGE * WEATHER_VERTS
 #define Weather_Pack(x, z) ((x) * World.Length + (z))
 
-static void InitWeatherHeightmap(void) {
-	int i;
-	Weather_Heightmap = (cc_int16*)Mem_Alloc(World.Width * World.Length, 2, "weather heightmap");
-	
-	for (i = 0; i < World.Width * World.Length; i++) {
-		Weather_Heightmap[i] = Int16_MaxValue;
-	}
-}
-
 #define RainCalcBody(get_block)\
 for (y = maxY; y >= 0; y--, i -= World.OneY) {\
 	draw = Blocks.Draw[get_block];\
@@ -376,13 +405,15 @@ static int CalcRainHeightAt(int x, int maxY, int z, int hIndex) {
 	int i = World_Pack(x, maxY, z), y;
 	cc_uint8 draw;
 
-#ifndef EXTENDED_BLOCKS
+#if defined CC_BUILD_BRICKWORLD
+	RainCalcBody(World_GetBlock(x, y, z));
+#elif !defined EXTENDED_BLOCKS
 	RainCalcBody(World.Blocks[i]);
 #else
 	if (World.IDMask <= 0xFF) {
 		RainCalcBody(World.Blocks[i]);
 	} else {
-		RainCalcBody(World.Blocks[i] | (World.Blocks2[i] << 8));
+		RainCalcBody(World_GetRawBlock(i));
 	}
 #endif
 
@@ -390,6 +421,72 @@ static int CalcRainHeightAt(int x, int maxY, int z, int hIndex) {
 	return -1;
 }
 
+/* Calculating rain heights lazily means the first rainy frames (e.g. after loading a map) scan many */
+/*  columns top-down, so instead calculate the rain height of every column spread across multiple threads */
+/* Each slab of X rows only writes to its own part of the heightmap, so no other locking is needed */
+#if !defined CC_BUILD_COOPTHREADED && (!defined CC_BUILD_WEB || defined CC_BUILD_WEBTHREADS) && !defined CC_BUILD_LOWMEM && !defined CC_BUILD_PAGEDWORLD
+#define WEATHER_MAX_WORKERS 3
+#define WEATHER_SLAB_ROWS   16
+static void* weatherSlabsMutex;
+static int weatherSlabsNext;
+
+static void Weather_RunSlabs(void) {
+	int x, z, end;
+	for (;;)
+	{
+		Mutex_Lock(weatherSlabsMutex);
+		{
+			x = weatherSlabsNext;
+			if (x < World.Width) weatherSlabsNext += WEATHER_SLAB_ROWS;
+		}
+		Mutex_Unlock(weatherSlabsMutex);
+
+		if (x >= World.Width) return;
+		end = min(x + WEATHER_SLAB_ROWS, World.Width);
+
+		for (; x < end; x++) {
+			for (z = 0; z < World.Length; z++) {
+				CalcRainHeightAt(x, World.MaxY, z, Weather_Pack(x, z));
+			}
+		}
+	}
+}
+
+static void Weather_CalculateAll(void) {
+	void* workers[WEATHER_MAX_WORKERS];
+	int i;
+
+	weatherSlabsMutex = Mutex_Create("Weather slabs");
+	weatherSlabsNext  = 0;
+
+	for (i = 0; i < WEATHER_MAX_WORKERS; i++) 
+	{
+		Thread_Run(&workers[i], Weather_RunSlabs, 64 * 1024, "Weather worker");
+	}
+
+	/* Main thread also calculates slabs while waiting */
+	Weather_RunSlabs();
+	for (i = 0; i < WEATHER_MAX_WORKERS; i++) 
+	{
+		Thread_Join(workers[i]);
+	}
+	Mutex_Free(weatherSlabsMutex);
+}
+#else
+/* Just leave heightmap to be calculated lazily */
+static void Weather_CalculateAll(void) { }
+#endif
+
+static void InitWeatherHeightmap(void) {
+	int i;
+	Weather_Heightmap = (cc_int16*)Mem_Alloc(World.Width * World.Length, 2, "weather heightmap");
+	
+	for (i = 0; i < World.Width * World.Length; i++) {
+		Weather_Heightmap[i] = Int16_MaxValue;
+	}
+	Weather_CalculateAll();
+}
+
 static float GetRainHeight(int x, int z) {
 	int hIndex, height;
 	int y;
@@ -414,6 +511,7 @@ void EnvRenderer_OnBlockChanged(int x, int y, int z, BlockID oldBlock, BlockID n
 	/* a) rain height was not calculated to begin with (height is short.MaxValue) */
 	/* b) changed y is below current calculated rain height */
 	if (y < height) return;
+	weather_dirty = true;
 
 	if (nowBlock) {
 		/* Simple case: Rest of column below is now not visible to rain. */
@@ -425,37 +523,145 @@ void EnvRenderer_OnBlockChanged(int x, int y, int z, BlockID oldBlock, BlockID n
 	}
 }
 
+void EnvRenderer_OnBlocksChanged(int x1, int z1, int x2, int z2) {
+	int x, z;
+	for (z = z1; z <= z2; z++) {
+		for (x = x1; x <= x2; x++) {
+			Weather_Heightmap[Weather_Pack(x, z)] = Int16_MaxValue;
+		}
+	}
+	weather_dirty = true;
+}
+
 static float CalcRainAlphaAt(float x) {
 	/* Wolfram Alpha: fit {0,178},{1,169},{4,147},{9,114},{16,59},{25,9} */
 	float falloff = 0.05f * x * x - 7 * x;
 	return 178 + falloff * Env.WeatherFade;
 }
 
-struct RainCoord { int dx, dz; float y; };
+/* Weather columns around the camera are only rebuilt when the camera moves to another block, or */
+/*  when the heightmap/environment changes. Otherwise rain just scrolls the cached mesh with the */
+/*  texture offset, and snow only updates the texture coordinates of the cached mesh */
+struct RainCoord { int x, z; float y; float uSpeed1, uSpeed2, vSpeed; };
+static struct RainCoord weather_coords[WEATHER_RANGE * WEATHER_RANGE];
+static struct VertexTextured weather_verts[WEATHER_VERTS_COUNT];
+static int weather_numCoords;
+static int weather_builtType;
+static IVec3 weather_builtPos;
+static PackedCol weather_builtCol;
+static float weather_builtFade;
 static RNGState snowDirRng;
 
-void EnvRenderer_RenderWeather(float delta) {
-	struct RainCoord coords[WEATHER_RANGE * WEATHER_RANGE];
-	int i, weather, numCoords = 0;
-	struct VertexTextured* v;
-	cc_bool moved, particles;
-	float speed, vOffsetBase, vOffset;
-	IVec3 pos;
-
+static void BuildWeatherColumns(const IVec3* pos, int weather) {
+	struct VertexTextured* v = weather_verts;
+	struct RainCoord* c;
 	PackedCol color;
 	int dist, dx, dz, x, z;
 	float alpha, y, height;
-	float uOffset1, uOffset2, uSpeed;
 	float worldV, v1, v2, vPlane1Offset;
 	float x1,y1,z1, x2,y2,z2;
 
+	weather_numCoords = 0;
+	vPlane1Offset = weather == WEATHER_RAINY  ? 0 : 0.25f; /* Offset v on 1 plane while snowing to avoid the unnatural mirrored texture effect */
+
+	for (dx = -WEATHER_EXTENT; dx <= WEATHER_EXTENT; dx++) {
+		for (dz = -WEATHER_EXTENT; dz <= WEATHER_EXTENT; dz++) {
+			x = pos->x + dx; z = pos->z + dz;
+
+			y = GetRainHeight(x, z);
+			if (pos->y <= y) continue;
+
+			c = &weather_coords[weather_numCoords++];
+			c->x = x; c->y = y; c->z = z;
+			c->uSpeed1 = 0; c->uSpeed2 = 0; c->vSpeed = 1.0f;
+
+			if (weather == WEATHER_SNOWY) {
+				Random_Seed(&snowDirRng, (x + 1217 * z) & 0x7fffffff);
+
+				/* Multiply horizontal speed by a random float from -1 to 1 */
+				c->uSpeed1 = Random_Float(&snowDirRng) * 2 + -1;
+				c->uSpeed2 = Random_Float(&snowDirRng) * 2 + -1;
+
+				/* Multiply vertical speed by a random float from 1.0 to 0.25 */
+				c->vSpeed  = (float)(Random_Float(&snowDirRng) * (1.0f - 0.25f) + 0.25f);
+			}
+
+			height = pos->y - y;
+			dist   = dx * dx + dz * dz;
+			alpha  = CalcRainAlphaAt((float)dist);
+			Math_Clamp(alpha, 0.0f, 255.0f);
+			color  = (Env.SunCol & PACKEDCOL_RGB_MASK) | PackedCol_A_Bits(alpha);
+		
+			worldV = (z & 1) / 2.0f - (x & 0x0F) / 16.0f;
+			v1 = y            / 6.0f + worldV; 
+			v2 = (y + height) / 6.0f + worldV;
+			x1 = (float)x;       y1 = (float)y;            z1 = (float)z;
+			x2 = (float)(x + 1); y2 = (float)(y + height); z2 = (float)(z + 1);
+
+			v->x = x1; v->y = y1; v->z = z1; v->Col = color; v->U = 0.0f; v->V = v1 + vPlane1Offset; v++;
+			v->x = x1; v->y = y2; v->z = z1; v->Col = color; v->U = 0.0f; v->V = v2 + vPlane1Offset; v++;
+			v->x = x2; v->y = y2; v->z = z2; v->Col = color; v->U = 1.0f; v->V = v2 + vPlane1Offset; v++;
+			v->x = x2; v->y = y1; v->z = z2; v->Col = color; v->U = 1.0f; v->V = v1 + vPlane1Offset; v++;
+
+			v->x = x2; v->y = y1; v->z = z1; v->Col = color; v->U = 1.0f; v->V = v1; v++;
+			v->x = x2; v->y = y2; v->z = z1; v->Col = color; v->U = 1.0f; v->V = v2; v++;
+			v->x = x1; v->y = y2; v->z = z2; v->Col = color; v->U = 0.0f; v->V = v2; v++;
+			v->x = x1; v->y = y1; v->z = z2; v->Col = color; v->U = 0.0f; v->V = v1; v++;
+		}
+	}
+
+	weather_dirty     = false;
+	weather_builtType = weather;
+	weather_builtPos  = *pos;
+	weather_builtCol  = Env.SunCol;
+	weather_builtFade = Env.WeatherFade;
+}
+
+/* Copies the cached snow columns into the weather VB, offsetting texture coordinates of each column */
+static void UpdateSnowColumns(float vOffsetBase) {
+	struct VertexTextured* src = weather_verts;
+	struct VertexTextured* dst;
+	struct RainCoord* c;
+	float uSpeed, uOffset1, uOffset2, vOffset;
+	int i, j;
+
+	dst = (struct VertexTextured*)Gfx_LockDynamicVb(weather_vb, 
+										VERTEX_FORMAT_TEXTURED, weather_numCoords * WEATHER_VERTS);
+	uSpeed = (float)Game.Time * Env.WeatherSpeed * 0.5f;
+
+	for (i = 0; i < weather_numCoords; i++)
+	{
+		c = &weather_coords[i];
+		uOffset1 = uSpeed * c->uSpeed1;
+		uOffset2 = uSpeed * c->uSpeed2;
+		vOffset  = vOffsetBase * c->vSpeed;
+
+		for (j = 0; j < 4; j++, src++, dst++) {
+			*dst = *src; dst->U += uOffset1; dst->V += vOffset;
+		}
+		for (j = 0; j < 4; j++, src++, dst++) {
+			*dst = *src; dst->U += uOffset2; dst->V += vOffset;
+		}
+	}
+	Gfx_UnlockDynamicVb(weather_vb);
+}
+
+void EnvRenderer_RenderWeather(float delta) {
+	int i, weather;
+	cc_bool moved, particles;
+	float speed, vOffsetBase;
+	struct RainCoord* c;
+	IVec3 pos;
+
 	weather = Env.Weather;
 	if (weather == WEATHER_SUNNY) return;
 
 	if (!Weather_Heightmap) 
 		InitWeatherHeightmap();
-	if (!weather_vb)
-		weather_vb = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, WEATHER_VERTS_COUNT);
+	if (!weather_vb) {
+		weather_vb    = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, WEATHER_VERTS_COUNT);
+		weather_dirty = true;
+	}
 
 	IVec3_Floor(&pos, &Camera.CurrentPos);
 	moved   = pos.x != lastPos.x || pos.y != lastPos.y || pos.z != lastPos.z;
@@ -465,94 +671,47 @@ void EnvRenderer_RenderWeather(float delta) {
 	pos.y += 64;
 	pos.y = max(World.Height, pos.y);
 
+	if (weather_dirty || weather != weather_builtType || weather_builtCol != Env.SunCol || weather_builtFade != Env.WeatherFade
+		|| pos.x != weather_builtPos.x || pos.y != weather_builtPos.y || pos.z != weather_builtPos.z) {
+		BuildWeatherColumns(&pos, weather);
+		/* Rain columns never change until next rebuild */
+		if (weather == WEATHER_RAINY) 
+			Gfx_SetDynamicVbData(weather_vb, weather_verts, weather_numCoords * WEATHER_VERTS);
+	}
+
 	weather_accumulator += delta;
 	particles = weather == WEATHER_RAINY && (weather_accumulator >= 0.25f || moved);
 
-	for (dx = -WEATHER_EXTENT; dx <= WEATHER_EXTENT; dx++) {
-		for (dz = -WEATHER_EXTENT; dz <= WEATHER_EXTENT; dz++) {
-			x = pos.x + dx; z = pos.z + dz;
-
-			y = GetRainHeight(x, z);
-			if (pos.y <= y) continue;
-			if (particles) Particles_RainSnowEffect((float)x, y, (float)z);
-
-			coords[numCoords].dx = dx;
-			coords[numCoords].y  = y;
-			coords[numCoords].dz = dz;
-			numCoords++;
+	if (particles) {
+		for (i = 0; i < weather_numCoords; i++) 
+		{
+			c = &weather_coords[i];
+			Particles_RainSnowEffect((float)c->x, c->y, (float)c->z);
 		}
 	}
 
 	Gfx_BindTexture(weather == WEATHER_RAINY ? rain_tex : snow_tex);
 	if (particles) weather_accumulator = 0;
-	if (!numCoords) return;
+	if (!weather_numCoords) return;
 
 	Gfx_SetAlphaTest(false);
 	Gfx_SetDepthWrite(false);
 	Gfx_SetAlphaArgBlend(true);
 
 	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
-	v = (struct VertexTextured*)Gfx_LockDynamicVb(weather_vb, 
-										VERTEX_FORMAT_TEXTURED, numCoords * WEATHER_VERTS);
-
-	color = Env.SunCol;
-	speed = (weather == WEATHER_RAINY ? 1.0f : 0.2f) * Env.WeatherSpeed;
-
-	vOffsetBase   = (float)Game.Time * speed;
-	vPlane1Offset = weather == WEATHER_RAINY  ? 0 : 0.25f; /* Offset v on 1 plane while snowing to avoid the unnatural mirrored texture effect */
-
-	for (i = 0; i < numCoords; i++)
-	{
-		dx = coords[i].dx;
-		y  = coords[i].y;
-		dz = coords[i].dz;
-
-		height = pos.y - y;
-
-		dist  = dx * dx + dz * dz;
-		alpha = CalcRainAlphaAt((float)dist);
-		Math_Clamp(alpha, 0.0f, 255.0f);
-		color = (color & PACKEDCOL_RGB_MASK) | PackedCol_A_Bits(alpha);
-
-		x = dx + pos.x;
-		z = dz + pos.z;
-
-		uOffset1 = 0;
-		uOffset2 = 0;
-		if (weather == WEATHER_SNOWY) {
-			Random_Seed(&snowDirRng, (x + 1217 * z) & 0x7fffffff);
-
-			/* Multiply horizontal speed by a random float from -1 to 1 */
-			uSpeed   = (float)Game.Time * Env.WeatherSpeed * 0.5f;
-			uOffset1 = uSpeed * (Random_Float(&snowDirRng) * 2 + -1);
-			uOffset2 = uSpeed * (Random_Float(&snowDirRng) * 2 + -1);
-
-			/* Multiply vertical speed by a random float from 1.0 to 0.25 */
-			vOffset = vOffsetBase * (float)(Random_Float(&snowDirRng) * (1.0f - 0.25f) + 0.25f);
-		} else {
-			vOffset = vOffsetBase;
-		}
-		
-		worldV = vOffset + (z & 1) / 2.0f - (x & 0x0F) / 16.0f;
-		v1 = y            / 6.0f + worldV; 
-		v2 = (y + height) / 6.0f + worldV;
-		x1 = (float)x;       y1 = (float)y;            z1 = (float)z;
-		x2 = (float)(x + 1); y2 = (float)(y + height); z2 = (float)(z + 1);
-
-		v->x = x1; v->y = y1; v->z = z1; v->Col = color; v->U = uOffset1;        v->V = v1 + vPlane1Offset; v++;
-		v->x = x1; v->y = y2; v->z = z1; v->Col = color; v->U = uOffset1;        v->V = v2 + vPlane1Offset; v++;
-		v->x = x2; v->y = y2; v->z = z2; v->Col = color; v->U = uOffset1 + 1.0f; v->V = v2 + vPlane1Offset; v++;
-		v->x = x2; v->y = y1; v->z = z2; v->Col = color; v->U = uOffset1 + 1.0f; v->V = v1 + vPlane1Offset; v++;
-
-		v->x = x2; v->y = y1; v->z = z1; v->Col = color; v->U = uOffset2 + 1.0f; v->V = v1; v++;
-		v->x = x2; v->y = y2; v->z = z1; v->Col = color; v->U = uOffset2 + 1.0f; v->V = v2; v++;
-		v->x = x1; v->y = y2; v->z = z2; v->Col = color; v->U = uOffset2;        v->V = v2; v++;
-		v->x = x1; v->y = y1; v->z = z2; v->Col = color; v->U = uOffset2;        v->V = v1; v++;
+	speed       = (weather == WEATHER_RAINY ? 1.0f : 0.2f) * Env.WeatherSpeed;
+	vOffsetBase = (float)Game.Time * speed;
+
+	if (weather == WEATHER_RAINY) {
+		Gfx_BindDynamicVb(weather_vb);
+		Gfx_EnableTextureOffset(0, vOffsetBase);
+		Gfx_DrawVb_IndexedTris(weather_numCoords * WEATHER_VERTS);
+		Gfx_DisableTextureOffset();
+	} else {
+		UpdateSnowColumns(vOffsetBase);
+		Gfx_DrawVb_IndexedTris(weather_numCoords * WEATHER_VERTS);
 	}
 
-	Gfx_UnlockDynamicVb(weather_vb);
-	Gfx_DrawVb_IndexedTris(numCoords * WEATHER_VERTS);
-
 	Gfx_SetAlphaArgBlend(false);
 	Gfx_SetDepthWrite(true);
 	Gfx_SetAlphaTest(false);
@@ -894,9 +1053,6 @@ static void OnEnvVariableChanged(void* obj, int envVar) {
 		EnvRenderer_UpdateFog();
 	} else if (envVar == ENV_VAR_CLOUDS_COLOR) {
 		UpdateClouds();
-	} else if (envVar == ENV_VAR_CLOUDS_HEIGHT) {
-		UpdateSky();
-		UpdateClouds();
 	} else if (envVar == ENV_VAR_SKYBOX_COLOR) {
 		Gfx_DeleteVb(&skybox_vb);
 	}
@@ -946,7 +1102,8 @@ static void OnReset(void) {
 
 	Mem_Free(Weather_Heightmap);
 	Weather_Heightmap = NULL;
-	lastPos = IVec3_MaxValue();
+	lastPos       = IVec3_MaxValue();
+	weather_dirty = true;
 }
 
 static void OnNewMapLoaded(void) { OnContextRecreated(NULL); }
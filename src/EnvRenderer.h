@@ -19,6 +19,9 @@ void EnvRenderer_RenderSky(void);
 void EnvRenderer_RenderClouds(void);
 /* Updates current fog colour and mode. */
 void EnvRenderer_UpdateFog(void);
+/* Distance from the camera past which everything is completely hidden by fog */
+/* NOTE: 0 when fog never completely hides anything (e.g. minimal environment mode) */
+extern int EnvRenderer_FogCullDistance;
 
 /* Renders borders around map and under horizon. */
 void EnvRenderer_RenderMapSides(void);
@@ -32,6 +35,9 @@ cc_bool EnvRenderer_ShouldRenderSkybox(void);
 extern cc_int16* Weather_Heightmap;
 /* Called when a block is changed to update internal weather state. */
 void EnvRenderer_OnBlockChanged(int x, int y, int z, BlockID oldBlock, BlockID newBlock);
+/* Called when many blocks in the columns from [x1, z1] to [x2, z2] were changed at once. */
+/* (rain heights of the columns are recalculated lazily, instead of after every single block change) */
+void EnvRenderer_OnBlocksChanged(int x1, int z1, int x2, int z2);
 /* Renders rainfall/snowfall weather. */
 void EnvRenderer_RenderWeather(float delta);
 
@@ -138,5 +138,9 @@ enum CC_ERRORS {
 	SSL_ERR_CONTEXT_DEAD = 0xCCDED070UL, /* Server shutdown the SSL context and it must be recreated */
 	PNG_ERR_16BITSAMPLES = 0xCCDED071UL, /* Image uses 16 bit samples, which is unimplemented */
 	ERR_NO_NETWORKING    = 0xCCDED072UL, /* No working network connection */
+	ZIP_ERR_DATA_DESCRIPTOR = 0xCCDED073UL, /* ZIP entry sizes are stored after its data */
+	INF_ERR_OUTPUT_SIZE  = 0xCCDED074UL, /* Data decompresses to more than the expected size */
+	HTTP_ERR_INVALID_RANGE = 0xCCDED075UL, /* HTTP partial response doesn't continue from the partially downloaded data */
+	ERR_HASH_MISMATCH    = 0xCCDED076UL, /* Downloaded data doesn't match its expected hash */
 };
 #endif
@@ -1,7 +1,7 @@
 #include "Event.h"
 #include "Platform.h"
 
-int EventAPIVersion = 4;
+int EventAPIVersion = 5;
 struct _EntityEventsList        EntityEvents;
 struct _TabListEventsList       TabListEvents;
 struct _TextureEventsList       TextureEvents;
@@ -83,6 +83,7 @@ void Event_UnregisterAll(void) {
 	WorldEvents.MapLoaded.Count = 0;
 	WorldEvents.EnvVarChanged.Count = 0;
 	WorldEvents.LightingModeChanged.Count = 0;
+	WorldEvents.BlocksChanged.Count = 0;
 
 	ChatEvents.FontChanged.Count    = 0;
 	ChatEvents.ChatReceived.Count   = 0;
@@ -201,3 +202,10 @@ void Event_RaiseLightingMode(struct Event_LightingMode* handlers, cc_uint8 oldMo
 		handlers->Handlers[i](handlers->Objs[i], oldMode, fromServer);
 	}
 }
+
+void Event_RaiseBlocks(struct Event_Blocks* handlers, const struct BlockChange* changes, int count) {
+	int i;
+	for (i = 0; i < handlers->Count; i++) {
+		handlers->Handlers[i](handlers->Objs[i], changes, count);
+	}
+}
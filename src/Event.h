@@ -42,6 +42,14 @@ struct Event_Block {
 	void* Objs[EVENT_MAX_CALLBACKS]; int Count;
 };
 
+/* Describes a single block change in a batch of block changes */
+struct BlockChange { IVec3 coords; BlockID oldBlock, block; };
+typedef void (*Event_Blocks_Callback)(void* obj, const struct BlockChange* changes, int count);
+struct Event_Blocks {
+	Event_Blocks_Callback Handlers[EVENT_MAX_CALLBACKS];
+	void* Objs[EVENT_MAX_CALLBACKS]; int Count;
+};
+
 typedef void (*Event_Chat_Callback)(void* obj, const cc_string* msg, int msgType);
 struct Event_Chat {
 	Event_Chat_Callback Handlers[EVENT_MAX_CALLBACKS];
@@ -106,6 +114,8 @@ void Event_RaiseEntry(struct Event_Entry* handlers, struct Stream* stream, const
 /* Calls all registered callbacks for an event which takes block change arguments. */
 /* These are the coordinates/location of the change, block there before, block there now. */
 void Event_RaiseBlock(struct Event_Block* handlers, IVec3 coords, BlockID oldBlock, BlockID block);
+/* Calls all registered callbacks for an event which takes a batch of block changes. */
+void Event_RaiseBlocks(struct Event_Blocks* handlers, const struct BlockChange* changes, int count);
 /* Calls all registered callbacks for an event which has chat message type and contents. */
 /* See MsgType enum in Chat.h for what types of messages there are. */
 void Event_RaiseChat(struct Event_Chat* handlers, const cc_string* msg, int msgType);
@@ -131,6 +141,7 @@ void Event_UnregisterAll(void);
 /*  Version 2 - Added WindowEvents.Redrawing */
 /*  Version 3 - Changed InputEvent.Press from code page 437 to unicode character */
 /*  Version 4 - Added InputEvents.Down2 and InputEvents.Up2 */
+/*  Version 5 - Added WorldEvents.BlocksChanged */
 /* You MUST CHECK the event API version before attempting to use the events listed above, */
 /*  as otherwise if the player is using an older client that lacks some of the above events, */
 /*  you will be calling Event_Register on random data instead of the expected EventsList struct */
@@ -179,6 +190,7 @@ CC_VAR extern struct _WorldEventsList {
 	struct Event_Void  MapLoaded;     /* New world has finished loading, player can now interact with it */
 	struct Event_Int   EnvVarChanged; /* World environment variable changed by player/CPE/WoM config */
 	struct Event_LightingMode LightingModeChanged; /* Lighting mode changed. */
+	struct Event_Blocks BlocksChanged; /* Batch of blocks in the world changed (see Game_BeginBlockChanges) */
 } WorldEvents;
 
 CC_VAR extern struct _ChatEventsList {
@@ -21,6 +21,15 @@ struct LightNode {
 
 static struct Queue lightQueue;
 static struct Queue unlightQueue;
+static struct Queue respreadQueue;
+
+/* A block change whose lighting update has been deferred until the batch ends */
+struct LightChange {
+	IVec3 coords;
+	BlockID oldBlock;
+};
+static struct LightChange* batchChanges;
+static int batchCount, batchCapacity;
 
 /* Top face, X face, Z face, bottomY face*/
 #define PALETTE_SHADES 4
@@ -39,12 +48,22 @@ static struct Queue unlightQueue;
 /* E.G. myPalette[0b_0010_0001] will give us the color for lamp level 2 and lava level 1 (lowest level is 0) */
 static PackedCol* palettes[PALETTE_COUNT];
 
+/* Light levels of all the cells in a chunk for either lava or lamp light, packed as two 4 bit levels per byte */
 typedef cc_uint8* LightingChunk;
+#define LIGHT_CHUNK_BYTES (CHUNK_SIZE_3 / 2)
+#define LightingChunk_Get(data, index) (((data)[(index) >> 1] >> (((index) & 1) << 2)) & FANCY_LIGHTING_MAX_LEVEL)
+
 static cc_uint8* chunkLightingDataFlags;
 #define CHUNK_UNCALCULATED 0
 #define CHUNK_SELF_CALCULATED 1
 #define CHUNK_ALL_CALCULATED 2
-static LightingChunk* chunkLightingData;
+
+struct LightChannel {
+	LightingChunk* chunks; /* Light data of each chunk, NULL if the chunk is completely dark */
+	cc_uint16* litCells;   /* Number of cells with a light level above 0 in each chunk */
+};
+/* Lava light and lamp light are stored separately, as most chunks only contain one (or neither) */
+static struct LightChannel lightChannels[2];
 
 #define MakePaletteIndex(lampLevel, lavaLevel) ((lampLevel << FANCY_LIGHTING_LAMP_SHIFT) | lavaLevel)
 /* Fill in a palette with values based on the current light colors, shaded by the given shade value and lightened by the given ambientColor */
@@ -101,36 +120,62 @@ static void FreePalettes(void) {
 }
 
 static int chunksCount;
+static void CalculateAllChunkLighting(void);
+
 static void AllocState(void) {
+	int i;
 	ClassicLighting_AllocState();
 	InitPalettes();
 	chunksCount = World.ChunksCount;
 
 	chunkLightingDataFlags = (cc_uint8*)Mem_AllocCleared(chunksCount, sizeof(cc_uint8), "light flags");
-	chunkLightingData = (LightingChunk*)Mem_AllocCleared(chunksCount, sizeof(LightingChunk), "light chunks");
+	for (i = 0; i < 2; i++) 
+	{
+		lightChannels[i].chunks   = (LightingChunk*)Mem_AllocCleared(chunksCount, sizeof(LightingChunk), "light chunks");
+		lightChannels[i].litCells = (cc_uint16*)Mem_AllocCleared(chunksCount, sizeof(cc_uint16), "light counts");
+	}
 	Queue_Init(&lightQueue, sizeof(struct LightNode));
 	Queue_Init(&unlightQueue, sizeof(struct LightNode));
+	Queue_Init(&respreadQueue, sizeof(struct LightNode));
+	CalculateAllChunkLighting();
+}
+
+static void FreeChannel(struct LightChannel* channel) {
+	int i;
+	for (i = 0; i < chunksCount; i++) {
+		Mem_Free(channel->chunks[i]);
+	}
+
+	Mem_Free(channel->chunks);
+	Mem_Free(channel->litCells);
+	channel->chunks   = NULL;
+	channel->litCells = NULL;
 }
 
 static void FreeState(void) {
 	int i;
 	ClassicLighting_FreeState();
+
+	Mem_Free(batchChanges);
+	batchChanges  = NULL;
+	batchCount    = 0;
+	batchCapacity = 0;
 	
 	/* This function can be called multiple times without calling AllocState, so... */
 	if (!chunkLightingDataFlags) return;
 
 	FreePalettes();
 
-	for (i = 0; i < chunksCount; i++) {
-		Mem_Free(chunkLightingData[i]);
+	for (i = 0; i < 2; i++) 
+	{
+		FreeChannel(&lightChannels[i]);
 	}
 
 	Mem_Free(chunkLightingDataFlags);
-	Mem_Free(chunkLightingData);
 	chunkLightingDataFlags = NULL;
-	chunkLightingData = NULL;
 	Queue_Clear(&lightQueue);
 	Queue_Clear(&unlightQueue);
+	Queue_Clear(&respreadQueue);
 }
 
 /* Converts chunk x/y/z coordinates to the corresponding index in chunks array/list */
@@ -142,39 +187,45 @@ static void FreeState(void) {
 
 /* Sets the light level at this cell. Does NOT check that the cell is in bounds. */
 static void SetBrightness(cc_uint8 brightness, int x, int y, int z, cc_bool isLamp, cc_bool refreshChunk) {
-	cc_uint8 clearMask, shift = isLamp ? FANCY_LIGHTING_LAMP_SHIFT : 0, prevValue;
+	struct LightChannel* channel = &lightChannels[isLamp];
+	cc_uint8 prevValue, shift, *cell;
 	int cx = x >> CHUNK_SHIFT, lx = x & CHUNK_MASK;
 	int cy = y >> CHUNK_SHIFT, ly = y & CHUNK_MASK;
 	int cz = z >> CHUNK_SHIFT, lz = z & CHUNK_MASK;
 	int chunkIndex = ChunkCoordsToIndex(cx, cy, cz);
 	int localIndex = LocalCoordsToIndex(lx, ly, lz);
 
-	if (chunkLightingData[chunkIndex] == NULL) {
-		chunkLightingData[chunkIndex] = (cc_uint8*)Mem_TryAllocCleared(CHUNK_SIZE_3, sizeof(cc_uint8));
+	if (channel->chunks[chunkIndex] == NULL) {
+		/* Completely dark chunks don't need any light data */
+		if (!brightness) return;
+		channel->chunks[chunkIndex] = (cc_uint8*)Mem_TryAllocCleared(LIGHT_CHUNK_BYTES, sizeof(cc_uint8));
+		if (!channel->chunks[chunkIndex]) return;
 	}
 
-	/* 00001111 if lamp, otherwise 11110000*/
-	clearMask = ~(FANCY_LIGHTING_MAX_LEVEL << shift);
+	cell  = &channel->chunks[chunkIndex][localIndex >> 1];
+	shift = (localIndex & 1) << 2;
+	prevValue = (*cell >> shift) & FANCY_LIGHTING_MAX_LEVEL;
 
-	if (refreshChunk) {
-		prevValue = chunkLightingData[chunkIndex][localIndex];
+	*cell &= ~(FANCY_LIGHTING_MAX_LEVEL << shift);
+	*cell |= brightness << shift;
 
-		chunkLightingData[chunkIndex][localIndex] &= clearMask;
-		chunkLightingData[chunkIndex][localIndex] |= brightness << shift;
+	if (prevValue && !brightness) channel->litCells[chunkIndex]--;
+	if (!prevValue && brightness) channel->litCells[chunkIndex]++;
 
-		/* There is no reason to refresh current chunk as the builder does that automatically */
-		if (prevValue != chunkLightingData[chunkIndex][localIndex]) {
-			if (lx == CHUNK_MAX) MapRenderer_RefreshChunk(cx + 1, cy, cz);
-			if (lx == 0)         MapRenderer_RefreshChunk(cx - 1, cy, cz);
-			if (ly == CHUNK_MAX) MapRenderer_RefreshChunk(cx, cy + 1, cz);
-			if (ly == 0)         MapRenderer_RefreshChunk(cx, cy - 1, cz);
-			if (lz == CHUNK_MAX) MapRenderer_RefreshChunk(cx, cy, cz + 1);
-			if (lz == 0)         MapRenderer_RefreshChunk(cx, cy, cz - 1);
-		}
+	/* There is no reason to refresh current chunk as the builder does that automatically */
+	if (refreshChunk && prevValue != brightness) {
+		if (lx == CHUNK_MAX) MapRenderer_RefreshChunk(cx + 1, cy, cz);
+		if (lx == 0)         MapRenderer_RefreshChunk(cx - 1, cy, cz);
+		if (ly == CHUNK_MAX) MapRenderer_RefreshChunk(cx, cy + 1, cz);
+		if (ly == 0)         MapRenderer_RefreshChunk(cx, cy - 1, cz);
+		if (lz == CHUNK_MAX) MapRenderer_RefreshChunk(cx, cy, cz + 1);
+		if (lz == 0)         MapRenderer_RefreshChunk(cx, cy, cz - 1);
 	}
-	else {
-		chunkLightingData[chunkIndex][localIndex] &= clearMask;
-		chunkLightingData[chunkIndex][localIndex] |= brightness << shift;
+
+	/* The chunk became completely dark, so there's no point keeping its light data around */
+	if (!channel->litCells[chunkIndex]) {
+		Mem_Free(channel->chunks[chunkIndex]);
+		channel->chunks[chunkIndex] = NULL;
 	}
 }
 /* Returns the light level at this cell. Does NOT check that the cell is in bounds. */
@@ -182,14 +233,10 @@ static cc_uint8 GetBrightness(int x, int y, int z, cc_bool isLamp) {
 	int cx = x >> CHUNK_SHIFT, lx = x & CHUNK_MASK;
 	int cy = y >> CHUNK_SHIFT, ly = y & CHUNK_MASK;
 	int cz = z >> CHUNK_SHIFT, lz = z & CHUNK_MASK;
-	int chunkIndex = ChunkCoordsToIndex(cx, cy, cz), localIndex;
+	LightingChunk data = lightChannels[isLamp].chunks[ChunkCoordsToIndex(cx, cy, cz)];
 
-	if (chunkLightingData[chunkIndex] == NULL) { return 0; }
-	localIndex = LocalCoordsToIndex(lx, ly, lz);
-
-	return isLamp ?
-		chunkLightingData[chunkIndex][localIndex] >> FANCY_LIGHTING_LAMP_SHIFT :
-		chunkLightingData[chunkIndex][localIndex] & FANCY_LIGHTING_MAX_LEVEL;
+	if (data == NULL) { return 0; }
+	return LightingChunk_Get(data, LocalCoordsToIndex(lx, ly, lz));
 }
 
 
@@ -358,6 +405,209 @@ static void CalculateChunkLightingAll(int chunkIndex, int cx, int cy, int cz) {
 }
 
 
+/*########################################################################################################################*
+*----------------------------------------------------Parallel lighting----------------------------------------------------*
+*#########################################################################################################################*/
+/* Calculating lighting lazily means the first chunk builds after loading a map are slow, */
+/*  so instead spread light from every light source in the map across multiple threads */
+/* The map is split into regions of whole chunk rows along the Z axis, each with its own queue. */
+/* A region only ever reads or writes light data of its own chunks - light spreading into a */
+/*  neighbouring region is instead queued up and handed over between rounds. */
+/* Since light spreading only ever increases light levels up to a fixed maximum, the end result */
+/*  is always the same regardless of the order that regions and rounds are processed in. */
+#if !defined CC_BUILD_COOPTHREADED && (!defined CC_BUILD_WEB || defined CC_BUILD_WEBTHREADS) && !defined CC_BUILD_LOWMEM && !defined CC_BUILD_PAGEDWORLD
+#define LIGHT_MAX_REGIONS 4
+
+struct LightRegion {
+	struct Queue queue; /* Light nodes to spread within this region */
+	struct Queue lower; /* Light nodes spreading into the previous region */
+	struct Queue upper; /* Light nodes spreading into the next region */
+	int minZ, maxZ;
+};
+static struct LightRegion regions[LIGHT_MAX_REGIONS];
+static int regionsCount, regionsNext;
+static void* regionsMutex;
+static cc_bool regionsLamp, regionsSeed;
+
+static void LightRegion_Seed(struct LightRegion* r) {
+	cc_uint8 brightness;
+	BlockID curBlock;
+	struct LightNode entry;
+	int x, y, z;
+
+	for (y = 0; y < World.Height; y++) {
+		for (z = r->minZ; z <= r->maxZ; z++) {
+			for (x = 0; x < World.Width; x++) {
+				curBlock = World_GetBlock(x, y, z);
+				if (!Blocks.Brightness[curBlock]) continue;
+
+				/* Same as CalculateChunkLightingSelf, blocks with no lava brightness use lamp brightness */
+				brightness = GetBlockBrightness(curBlock, false);
+				if (regionsLamp) {
+					if (brightness) continue;
+					brightness = GetBlockBrightness(curBlock, true);
+				}
+
+				if (!brightness) continue;
+				LightNode_Init(entry, x, y, z, brightness);
+				Queue_Enqueue(&r->queue, &entry);
+			}
+		}
+	}
+}
+
+static void LightRegion_Spread(struct LightRegion* r, struct LightNode* ln, BlockID thisBlock, Face thisFace, Face thatFace) {
+	int x = ln->coords.x, y = ln->coords.y, z = ln->coords.z;
+
+	if (!CanLightPass(thisBlock, thisFace))                 return;
+	if (!CanLightPass(World_GetBlock(x, y, z), thatFace)) return;
+
+	/* Light data of other regions must not be touched, see above */
+	if (z < r->minZ) {
+		Queue_Enqueue(&r->lower, ln);
+	} else if (z > r->maxZ) {
+		Queue_Enqueue(&r->upper, ln);
+	} else if (GetBrightness(x, y, z, regionsLamp) < ln->brightness) {
+		Queue_Enqueue(&r->queue, ln);
+	}
+}
+
+/* Same as FlushLightQueue, but uses the region's queues */
+static void LightRegion_Flush(struct LightRegion* r) {
+	struct LightNode ln;
+	BlockID thisBlock;
+
+	while (r->queue.count > 0) {
+		ln = *(struct LightNode*)(Queue_Dequeue(&r->queue));
+
+		if (GetBrightness(ln.coords.x, ln.coords.y, ln.coords.z, regionsLamp) >= ln.brightness) continue;
+		SetBrightness(ln.brightness, ln.coords.x, ln.coords.y, ln.coords.z, regionsLamp, false);
+
+		thisBlock = World_GetBlock(ln.coords.x, ln.coords.y, ln.coords.z);
+		ln.brightness--;
+		if (ln.brightness == 0) continue;
+
+		if (ln.coords.x > 0) {
+			ln.coords.x--; LightRegion_Spread(r, &ln, thisBlock, FACE_XMAX, FACE_XMIN); ln.coords.x++;
+		}
+		if (ln.coords.x < World.MaxX) {
+			ln.coords.x++; LightRegion_Spread(r, &ln, thisBlock, FACE_XMIN, FACE_XMAX); ln.coords.x--;
+		}
+		if (ln.coords.y > 0) {
+			ln.coords.y--; LightRegion_Spread(r, &ln, thisBlock, FACE_YMAX, FACE_YMIN); ln.coords.y++;
+		}
+		if (ln.coords.y < World.MaxY) {
+			ln.coords.y++; LightRegion_Spread(r, &ln, thisBlock, FACE_YMIN, FACE_YMAX); ln.coords.y--;
+		}
+		if (ln.coords.z > 0) {
+			ln.coords.z--; LightRegion_Spread(r, &ln, thisBlock, FACE_ZMAX, FACE_ZMIN); ln.coords.z++;
+		}
+		if (ln.coords.z < World.MaxZ) {
+			ln.coords.z++; LightRegion_Spread(r, &ln, thisBlock, FACE_ZMIN, FACE_ZMAX); ln.coords.z--;
+		}
+	}
+}
+
+static void LightRegions_Run(void) {
+	int i;
+	for (;;)
+	{
+		Mutex_Lock(regionsMutex);
+		{
+			i = regionsNext;
+			if (i < regionsCount) regionsNext++;
+		}
+		Mutex_Unlock(regionsMutex);
+
+		if (i >= regionsCount) return;
+		if (regionsSeed) LightRegion_Seed(&regions[i]);
+		LightRegion_Flush(&regions[i]);
+	}
+}
+
+static void LightRegions_RunRound(void) {
+	void* workers[LIGHT_MAX_REGIONS];
+	int i;
+	regionsNext = 0;
+
+	for (i = 1; i < regionsCount; i++) 
+	{
+		Thread_Run(&workers[i], LightRegions_Run, 64 * 1024, "Lighting worker");
+	}
+
+	/* Main thread also processes regions while waiting */
+	LightRegions_Run();
+	for (i = 1; i < regionsCount; i++) 
+	{
+		Thread_Join(workers[i]);
+	}
+}
+
+static void LightRegions_Move(struct Queue* src, struct Queue* dst) {
+	while (src->count > 0) { Queue_Enqueue(dst, Queue_Dequeue(src)); }
+}
+
+/* Hands over light nodes that spread across region borders, returning whether there were any */
+static cc_bool LightRegions_Exchange(void) {
+	cc_bool any = false;
+	int i;
+
+	for (i = 0; i < regionsCount; i++) 
+	{
+		if (i > 0)                LightRegions_Move(&regions[i - 1].upper, &regions[i].queue);
+		if (i < regionsCount - 1) LightRegions_Move(&regions[i + 1].lower, &regions[i].queue);
+		any |= regions[i].queue.count > 0;
+	}
+	return any;
+}
+
+static void CalculateAllChunkLighting(void) {
+	int i, chunksZ = World.ChunksZ;
+	regionsCount = min(LIGHT_MAX_REGIONS, chunksZ);
+	/* Not worth the overhead, just leave lighting to be calculated lazily */
+	if (regionsCount < 2) return;
+
+	for (i = 0; i < regionsCount; i++) 
+	{
+		Queue_Init(&regions[i].queue, sizeof(struct LightNode));
+		Queue_Init(&regions[i].lower, sizeof(struct LightNode));
+		Queue_Init(&regions[i].upper, sizeof(struct LightNode));
+
+		regions[i].minZ = (i       * chunksZ / regionsCount) * CHUNK_SIZE;
+		regions[i].maxZ = ((i + 1) * chunksZ / regionsCount) * CHUNK_SIZE - 1;
+	}
+	regions[regionsCount - 1].maxZ = World.MaxZ;
+	regionsMutex = Mutex_Create("Lighting regions");
+
+	for (i = 0; i < 2; i++) 
+	{
+		regionsLamp = i == 1;
+		regionsSeed = true;
+		do {
+			LightRegions_RunRound();
+			regionsSeed = false;
+		} while (LightRegions_Exchange());
+	}
+
+	for (i = 0; i < chunksCount; i++) 
+	{
+		chunkLightingDataFlags[i] = CHUNK_ALL_CALCULATED;
+	}
+
+	for (i = 0; i < regionsCount; i++) 
+	{
+		Queue_Clear(&regions[i].queue);
+		Queue_Clear(&regions[i].lower);
+		Queue_Clear(&regions[i].upper);
+	}
+	Mutex_Free(regionsMutex);
+}
+#else
+/* Just leave lighting to be calculated lazily */
+static void CalculateAllChunkLighting(void) { }
+#endif
+
+
 #define Light_TryUnSpreadInto(axis, dir, limit, AXIS, thisFace, thatFace) \
 		if (neighborCoords.axis dir ## = limit && \
 			CanLightPass(thisBlock, FACE_ ## AXIS ## thisFace) && \
@@ -379,7 +629,11 @@ static void CalculateChunkLightingAll(int chunkIndex, int cx, int cy, int cz) {
 					Queue_Enqueue(&unlightQueue, &otherNode); \
 				} \
 				/* This neighbor is brighter or same, mark this spot as needing to be re-spread */ \
-				else { \
+				else if (deferRespread) { \
+					/* Another source being unlit might still darken the neighbor, see CalcBatchedChanges */ \
+					LightNode_Init(otherNode, neighborCoords.x, neighborCoords.y, neighborCoords.z, neighborBrightness); \
+					Queue_Enqueue(&respreadQueue, &otherNode); \
+				} else { \
 					/* But only if the neighbor actually *can* spread to this block */ \
 					if ( \
 						CanLightPass(thisBlockTrue, FACE_ ## AXIS ## thisFace) && \
@@ -394,26 +648,22 @@ static void CalculateChunkLightingAll(int chunkIndex, int cx, int cy, int cz) {
 			} \
 		} \
 
-/* Spreads darkness out from this point and relights any necessary areas afterward */
-static void CalcUnlight(int x, int y, int z, cc_uint8 brightness, cc_bool isLamp) {
+/* Spreads darkness out from the first 'seeds' points in the unlight queue */
+static void FlushUnlightQueue(int seeds, cc_bool isLamp, cc_bool deferRespread) {
 	int count = 0;
 	struct LightNode curNode, otherNode;
 	cc_uint8 neighborBrightness, neighborBlockBrightness;
 	IVec3 neighborCoords;
 	BlockID thisBlockTrue, thisBlock;
 
-	SetBrightness(0, x, y, z, isLamp, true);
-	LightNode_Init(curNode, x, y, z, brightness);
-	Queue_Enqueue(&unlightQueue, &curNode);
-
 	while (unlightQueue.count > 0) {
 		curNode = *(struct LightNode*)(Queue_Dequeue(&unlightQueue));
 		neighborCoords = curNode.coords;
 
 		thisBlockTrue = World_GetBlock(neighborCoords.x, neighborCoords.y, neighborCoords.z);
-		/* For the original cell in the queue, assume this block is air
+		/* For the original cells in the queue, assume this block is air
 		so that light can unspread "out" of it in the case of a solid blocks. */
-		thisBlock = count == 0 ? BLOCK_AIR : thisBlockTrue;
+		thisBlock = count < seeds ? BLOCK_AIR : thisBlockTrue;
 
 		count++;
 
@@ -434,7 +684,17 @@ static void CalcUnlight(int x, int y, int z, cc_uint8 brightness, cc_bool isLamp
 		neighborCoords.z += 2;
 		Light_TryUnSpreadInto(z, <, World.MaxZ, Z, MIN, MAX)
 	}
+}
+
+/* Spreads darkness out from this point and relights any necessary areas afterward */
+static void CalcUnlight(int x, int y, int z, cc_uint8 brightness, cc_bool isLamp) {
+	struct LightNode curNode;
+
+	SetBrightness(0, x, y, z, isLamp, true);
+	LightNode_Init(curNode, x, y, z, brightness);
+	Queue_Enqueue(&unlightQueue, &curNode);
 
+	FlushUnlightQueue(1, isLamp, false);
 	FlushLightQueue(isLamp, true);
 }
 static void CalcBlockChange(int x, int y, int z, BlockID oldBlock, BlockID newBlock, cc_bool isLamp) {
@@ -461,14 +721,85 @@ static void CalcBlockChange(int x, int y, int z, BlockID oldBlock, BlockID newBl
 	CalcUnlight(x, y, z, oldLightLevelHere, isLamp);
 }
 static void OnBlockChanged(int x, int y, int z, BlockID oldBlock, BlockID newBlock) {
+	struct LightChange* change;
 	/* For some reason this is a possible case */
 	if (oldBlock == newBlock) { return; }
 
 	ClassicLighting_OnBlockChanged(x, y, z, oldBlock, newBlock);
 
+	if (Lighting_Batching) {
+		if (batchCount == batchCapacity) {
+			batchCapacity = max(256, batchCapacity * 2);
+			batchChanges  = (struct LightChange*)Mem_Realloc(batchChanges, batchCapacity, sizeof(struct LightChange), "lighting changes");
+		}
+
+		change = &batchChanges[batchCount++];
+		change->coords.x = x; change->coords.y = y; change->coords.z = z;
+		change->oldBlock = oldBlock;
+		return;
+	}
+
 	CalcBlockChange(x, y, z, oldBlock, newBlock, false);
 	CalcBlockChange(x, y, z, oldBlock, newBlock, true);
 }
+
+/* Same as CalcBlockChange, but unlights from all the changed blocks in one pass and then relights just once */
+static void CalcBatchedChanges(cc_bool isLamp) {
+	struct LightChange* change;
+	struct LightNode entry;
+	cc_uint8 oldBlockLightLevel, newBlockLightLevel, oldLightLevelHere;
+	BlockID newBlock;
+	int i, x, y, z, seeds = 0;
+
+	for (i = 0; i < batchCount; i++) 
+	{
+		change = &batchChanges[i];
+		x = change->coords.x; y = change->coords.y; z = change->coords.z;
+
+		/* Block may have been changed multiple times during the batch */
+		newBlock = World_GetBlock(x, y, z);
+		oldBlockLightLevel = GetBlockBrightness(change->oldBlock, isLamp);
+		newBlockLightLevel = GetBlockBrightness(newBlock, isLamp);
+		oldLightLevelHere  = GetBrightness(x, y, z, isLamp);
+
+		if (!oldLightLevelHere && !newBlockLightLevel && IsFullOpaque(newBlock)) continue;
+
+		if (oldLightLevelHere < newBlockLightLevel) {
+			LightNode_Init(entry, x, y, z, newBlockLightLevel);
+			Queue_Enqueue(&lightQueue, &entry);
+			continue;
+		}
+		if (IsFullTransparent(change->oldBlock) && IsFullTransparent(newBlock) && !oldBlockLightLevel && !newBlockLightLevel) continue;
+
+		SetBrightness(0, x, y, z, isLamp, true);
+		LightNode_Init(entry, x, y, z, oldLightLevelHere);
+		Queue_Enqueue(&unlightQueue, &entry);
+		seeds++;
+	}
+	FlushUnlightQueue(seeds, isLamp, true);
+
+	/* Only respread from cells once all the unlighting is done, as otherwise they might */
+	/*  respread light that was later removed by unlighting from another changed block */
+	while (respreadQueue.count > 0) {
+		entry = *(struct LightNode*)(Queue_Dequeue(&respreadQueue));
+		entry.brightness = GetBrightness(entry.coords.x, entry.coords.y, entry.coords.z, isLamp);
+		if (!entry.brightness) continue;
+
+		/* Cell must be cleared first, as otherwise flushing assumes it has already spread */
+		SetBrightness(0, entry.coords.x, entry.coords.y, entry.coords.z, isLamp, false);
+		Queue_Enqueue(&lightQueue, &entry);
+	}
+	FlushLightQueue(isLamp, true);
+}
+
+static void FlushBatch(void) {
+	ClassicLighting_FlushBatch();
+	if (!batchCount) return;
+
+	CalcBatchedChanges(false);
+	CalcBatchedChanges(true);
+	batchCount = 0;
+}
 /* Invalidates/Resets lighting state for all of the blocks in the world */
 /*  (e.g. because a block changed whether it is full bright or not) */
 static void Refresh(void) {
@@ -485,7 +816,8 @@ static cc_bool IsLit_Fast(int x, int y, int z) { return ClassicLighting_IsLit_Fa
 	}
 
 static PackedCol Color_Core(int x, int y, int z, int paletteFace) {
-	cc_uint8 lightData;
+	LightingChunk lava, lamp;
+	cc_uint8 lightData = 0;
 	int cx, cy, cz, chunkIndex;
 	int chunkCoordsIndex;
 
@@ -497,12 +829,12 @@ static PackedCol Color_Core(int x, int y, int z, int paletteFace) {
 	CalcForChunkIfNeeded(cx, cy, cz, chunkIndex);
 
 	/* There might be no light data in this chunk even after it was calculated */
-	if (chunkLightingData[chunkIndex] == NULL) {
-		lightData = 0;
-	} else {
-		chunkCoordsIndex = GlobalCoordsToChunkCoordsIndex(x, y, z);
-		lightData = chunkLightingData[chunkIndex][chunkCoordsIndex];
-	}
+	lava = lightChannels[false].chunks[chunkIndex];
+	lamp = lightChannels[true].chunks[chunkIndex];
+	chunkCoordsIndex = GlobalCoordsToChunkCoordsIndex(x, y, z);
+
+	if (lava) lightData |= LightingChunk_Get(lava, chunkCoordsIndex);
+	if (lamp) lightData |= LightingChunk_Get(lamp, chunkCoordsIndex) << FANCY_LIGHTING_LAMP_SHIFT;
 
 	/* This cell is exposed to sunlight */
 	if (y > ClassicLighting_GetLightHeight(x, z)) {
@@ -566,6 +898,7 @@ void FancyLighting_SetActive(void) {
 	Lighting.FreeState  = FreeState;
 	Lighting.AllocState = AllocState;
 	Lighting.LightHint  = LightHint;
+	Lighting.FlushBatch = FlushBatch;
 }
 
 static void OnEnvVariableChanged(void* obj, int envVar) {
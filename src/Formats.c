@@ -16,12 +16,20 @@
 #include "Chat.h"
 #include "TexturePack.h"
 #include "Utils.h"
+#include "Options.h"
+#include "Jobs.h"
+#include "Generator.h"
 
 #ifdef CC_BUILD_FILESYSTEM
 static struct LocationUpdate* spawn_point;
 static struct MapImporter* imp_head;
 static struct MapImporter* imp_tail;
 
+/* Map files are only indexed for the load level menu when they can be read on a background thread */
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_WEB && !defined CC_BUILD_LOWMEM
+#define MAP_INDEX_THREADED
+#endif
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------General----------------------------------------------------------*
@@ -45,6 +53,108 @@ static cc_result Map_SkipGZipHeader(struct Stream* stream) {
 	return 0;
 }
 
+/* Builds the thumbnail of a map from its blocks, as they are read in XZY order */
+struct MapThumb {
+	struct MapInfo* info;
+	const cc_uint8* table; /* Converts raw block IDs (NULL if not needed) */
+	int x, y, z;           /* Coordinates of the next block */
+	int row, nextRow;      /* Thumbnail row of the current z (-1 if not sampled), and next row to sample */
+	int col;               /* Next thumbnail column to sample in the current row */
+	int sampleX[MAPINFO_THUMB_SIZE], sampleZ[MAPINFO_THUMB_SIZE];
+};
+
+#ifdef MAP_INDEX_THREADED
+/* Set when reading map info should be abandoned as soon as possible (see Map index section) */
+static volatile cc_bool mapInfo_stopping;
+
+static void MapThumb_NextRow(struct MapThumb* t) {
+	if (t->nextRow < t->info->thumbLength && t->sampleZ[t->nextRow] == t->z) {
+		t->row = t->nextRow++;
+	} else {
+		t->row = -1;
+	}
+}
+
+static void MapThumb_Init(struct MapThumb* t, struct MapInfo* info, const cc_uint8* table) {
+	int width = info->width, length = info->length, i;
+	Mem_Set(t, 0, sizeof(*t));
+	t->info  = info;
+	t->table = table;
+
+	Mem_Set(info->thumbBlocks,  BLOCK_AIR, sizeof(info->thumbBlocks));
+	Mem_Set(info->thumbHeights, 0,         sizeof(info->thumbHeights));
+	info->thumbWidth  = 0;
+	info->thumbLength = 0;
+	if (width <= 0 || length <= 0 || info->height <= 0) return;
+
+	/* Preserve the aspect ratio of the map */
+	if (width >= length) {
+		info->thumbWidth  = min(width, MAPINFO_THUMB_SIZE);
+		info->thumbLength = max(1, info->thumbWidth * length / width);
+	} else {
+		info->thumbLength = min(length, MAPINFO_THUMB_SIZE);
+		info->thumbWidth  = max(1, info->thumbLength * width / length);
+	}
+
+	/* Sample the column in the middle of each thumbnail cell */
+	for (i = 0; i < info->thumbWidth; i++) {
+		t->sampleX[i] = (2 * i + 1) * width  / (2 * info->thumbWidth);
+	}
+	for (i = 0; i < info->thumbLength; i++) {
+		t->sampleZ[i] = (2 * i + 1) * length / (2 * info->thumbLength);
+	}
+	MapThumb_NextRow(t);
+}
+
+static void MapThumb_Add(struct MapThumb* t, const BlockRaw* blocks, cc_uint32 count) {
+	struct MapInfo* info = t->info;
+	int width = info->width, run, i, b;
+	if (!info->thumbWidth) return;
+
+	while (count && t->y < info->height) 
+	{
+		run = (int)min(count, (cc_uint32)(width - t->x));
+
+		/* Blocks are read bottom to top, so the last non-air block in a column is the highest */
+		for (; t->row >= 0 && t->col < info->thumbWidth && t->sampleX[t->col] < t->x + run; t->col++) 
+		{
+			b = blocks[t->sampleX[t->col] - t->x];
+			if (t->table) b = t->table[b];
+			if (b == BLOCK_AIR) continue;
+
+			i = t->row * MAPINFO_THUMB_SIZE + t->col;
+			info->thumbBlocks[i]  = b;
+			info->thumbHeights[i] = t->y * 255 / max(1, info->height - 1);
+		}
+
+		blocks += run; count -= run; t->x += run;
+		if (t->x < width) continue;
+
+		t->x   = 0;
+		t->col = 0;
+		if (++t->z == info->length) { t->z = 0; t->y++; t->nextRow = 0; }
+		MapThumb_NextRow(t);
+	}
+}
+
+static cc_result MapThumb_Read(struct MapThumb* t, struct Stream* stream, cc_uint32 count) {
+	cc_uint8 buffer[8192];
+	cc_uint32 read;
+	cc_result res;
+
+	for (; count; count -= read)
+	{
+		/* No point reading the rest of the map when indexing is being stopped */
+		if (mapInfo_stopping) return ERR_END_OF_STREAM;
+
+		read = min(count, sizeof(buffer));
+		if ((res = Stream_Read(stream, buffer, read))) return res;
+		MapThumb_Add(t, buffer, read);
+	}
+	return 0;
+}
+#endif
+
 void MapImporter_Register(struct MapImporter* imp) {
 	LinkedList_Append(imp, imp_head, imp_tail);
 }
@@ -61,32 +171,70 @@ struct MapImporter* MapImporter_Find(const cc_string* path) {
 	return NULL;
 }
 
+/* Identifies the cached uncompressed copy of a map file (see Map cache section) */
+struct MapCacheKey {
+	cc_uint32 length, crc32;
+	cc_string path;
+	char _pathBuffer[FILENAME_SIZE];
+};
+static cc_result MapCache_MakeKey(struct MapCacheKey* key, const cc_string* path, struct Stream* src);
+static cc_bool   MapCache_Load(const struct MapCacheKey* key);
+static void      MapCache_Save(const struct MapCacheKey* key);
+static cc_bool   Journal_Replay(const cc_string* mapPath, cc_uint32 mapSize);
+static void      Map_WaitForSave(const cc_string* path);
+
 cc_result Map_LoadFrom(const cc_string* path) {
 	cc_string relPath, fileName, fileExt;
 	struct LocationUpdate update = { 0 };
 	struct MapImporter* imp;
-	struct Stream stream;
+	struct MapCacheKey cache;
+	struct Stream stream, buffered, *src;
+	cc_uint8* buffer;
+	cc_uint32 fileSize = 0;
+	cc_bool useCache;
 	cc_result res;
+	/* Map index reads maps using the same reader state (e.g. nbt_arrayFilter) */
+	MapIndex_Stop();
+	Map_WaitForSave(path);
 	Game_Reset();
 	
 	spawn_point = &update;
 	res = Stream_OpenFile(&stream, path);
 	if (res) { Logger_SysWarn2(res, "opening", path); return res; }
 
-	imp = MapImporter_Find(path);
-	if (!imp) {
+	/* Read through a buffer, since some formats read in many small pieces */
+	src    = &stream;
+	buffer = (cc_uint8*)Mem_TryAlloc(STREAM_FILE_BUFFER_SIZE, 1);
+	if (buffer) {
+		Stream_ReadonlyBuffered(&buffered, &stream, buffer, STREAM_FILE_BUFFER_SIZE);
+		src = &buffered;
+	}
+
+	useCache = Options_GetBool(OPT_MAP_CACHE, false) && !MapCache_MakeKey(&cache, path, src);
+	imp      = MapImporter_Find(path);
+
+	if (useCache && MapCache_Load(&cache)) {
+		/* Cache is already up to date */
+		useCache = false;
+	} else if (!imp) {
 		res = ERR_NOT_SUPPORTED;
-	} else if ((res = imp->import(&stream))) {
+	} else if ((res = imp->import(src))) {
 		World_Reset();
 	}
 
 	/* No point logging error for closing readonly file */
+	(void)stream.Length(&stream, &fileSize);
 	(void)stream.Close(&stream);
+	Mem_Free(buffer);
 	if (res) Logger_SysWarn2(res, "decoding", path);
 
+	/* Cache must only ever contain what is in the map file itself */
+	if (!res && Journal_Replay(path, fileSize)) useCache = false;
+
 	World_SetNewMap(World.Blocks, World.Width, World.Height, World.Length);
 	if (!spawn_point) LocalPlayer_CalcDefaultSpawn(Entities.CurPlayer, &update);
 	LocalPlayers_MoveToSpawn(&update);
+	if (useCache && !res) MapCache_Save(&cache);
 
 	relPath = *path;
 	Utils_UNSAFE_GetFilename(&relPath);
@@ -155,11 +303,14 @@ static cc_result Lvl_ReadCustomBlocks(struct Stream* stream) {
 				baseIndex = World_Pack(x, y, z);
 
 				if ((x + LVL_CHUNKSIZE) <= adjWidth && (y + LVL_CHUNKSIZE) <= adjHeight && (z + LVL_CHUNKSIZE) <= adjLength) {
-					for (i = 0; i < sizeof(chunk); i++) {
-						xx = i & 0xF; yy = (i >> 8) & 0xF; zz = (i >> 4) & 0xF;
-
-						index = baseIndex + World_Pack(xx, yy, zz);
-						World.Blocks[index] = World.Blocks[index] == LVL_CUSTOMTILE ? chunk[i] : World.Blocks[index];
+					/* Chunk data is stored in XZY order too, so merge one row at a time */
+					for (i = 0; i < sizeof(chunk); i += LVL_CHUNKSIZE) {
+						yy = (i >> 8) & 0xF; zz = (i >> 4) & 0xF;
+						index = baseIndex + World_Pack(0, yy, zz);
+
+						for (xx = 0; xx < LVL_CHUNKSIZE; xx++, index++) {
+							if (World.Blocks[index] == LVL_CUSTOMTILE) World.Blocks[index] = chunk[i + xx];
+						}
 					}
 				} else {
 					for (i = 0; i < sizeof(chunk); i++) {
@@ -236,6 +387,36 @@ static cc_result Lvl_Load(struct Stream* stream) {
 	return res;
 }
 
+#ifdef MAP_INDEX_THREADED
+/* Reads the dimensions, spawn and thumbnail of a .lvl map file, without loading it */
+static cc_result Lvl_ReadInfo(struct Stream* stream, struct MapInfo* info) {
+	cc_uint8 header[18];
+	struct MapThumb thumb;
+	cc_result res;
+
+	struct Stream compStream;
+	struct InflateState state;
+	Inflate_MakeStream2(&compStream, &state, stream);
+	
+	if ((res = Map_SkipGZipHeader(stream)))                       return res;
+	if ((res = Stream_Read(&compStream, header, sizeof(header)))) return res;
+	if (Stream_GetU16_LE(&header[0]) != 1874) return LVL_ERR_VERSION;
+
+	info->width  = Stream_GetU16_LE(&header[2]);
+	info->length = Stream_GetU16_LE(&header[4]);
+	info->height = Stream_GetU16_LE(&header[6]);
+
+	info->hasSpawn = true;
+	info->spawnX   = Stream_GetU16_LE(&header[8]);
+	info->spawnZ   = Stream_GetU16_LE(&header[10]);
+	info->spawnY   = Stream_GetU16_LE(&header[12]);
+
+	/* Custom blocks section is ignored, as only the lower 8 bits are used for thumbnails */
+	MapThumb_Init(&thumb, info, Lvl_table);
+	return MapThumb_Read(&thumb, &compStream, (cc_uint32)info->width * info->height * info->length);
+}
+#endif
+
 
 /*########################################################################################################################*
 *----------------------------------------------------fCraft map format----------------------------------------------------*
@@ -414,6 +595,13 @@ static cc_result Nbt_ReadString(struct Stream* stream, cc_string* str) {
 }
 
 typedef void (*Nbt_Callback)(struct NbtTag* tag);
+/* Returns whether the data of the given large byte array tag is needed */
+typedef cc_bool (*Nbt_ArrayFilter)(struct NbtTag* tag);
+static Nbt_ArrayFilter nbt_arrayFilter;
+/* Reads the data of the given large byte array tag directly from the stream */
+typedef cc_result (*Nbt_ArrayReader)(struct NbtTag* tag, struct Stream* stream);
+static Nbt_ArrayReader nbt_arrayReader;
+
 static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream* stream, 
 							struct NbtTag* parent, Nbt_Callback callback, int listIndex) {
 	struct NbtTag tag;
@@ -456,6 +644,11 @@ static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream
 
 		if (NbtTag_IsSmall(&tag)) {
 			res = Stream_Read(stream, tag.value.small, tag.dataSize);
+		} else if (nbt_arrayReader) {
+			return nbt_arrayReader(&tag, stream);
+		} else if (!nbt_arrayFilter(&tag)) {
+			/* Skip unused large arrays (e.g. block metadata), rather than reading them into a temp allocation */
+			return stream->Skip(stream, tag.dataSize);
 		} else {
 			tag.value.big = (cc_uint8*)Mem_TryAlloc(tag.dataSize, 1);
 			if (!tag.value.big) return ERR_OUT_OF_MEMORY;
@@ -515,12 +708,15 @@ static BlockRaw* Nbt_TakeArray(struct NbtTag* tag, const char* type) {
 	return ptr;
 }
 
-static cc_result Nbt_Read(struct Stream* stream, Nbt_Callback callback) {
+static cc_result Nbt_Read(struct Stream* stream, Nbt_Callback callback, 
+						Nbt_ArrayFilter arrayFilter, Nbt_ArrayReader arrayReader) {
 	struct Stream compStream;
 	struct InflateState state;
 	cc_result res;
 	cc_uint8 tag;
 
+	nbt_arrayFilter = arrayFilter;
+	nbt_arrayReader = arrayReader;
 	Inflate_MakeStream2(&compStream, &state, stream);
 	if ((res = Map_SkipGZipHeader(stream))) return res;
 	if ((res = compStream.ReadU8(&compStream, &tag))) return res;
@@ -871,11 +1067,78 @@ static void Cw_Callback(struct NbtTag* tag) {
 	        0             1         2        3          4   */
 }
 
+/* Only the block arrays are large enough to not be stored inline in the tag */
+static cc_bool Cw_WantsArray(struct NbtTag* tag) {
+	if (!tag->parent || tag->parent->parent) return false;
+	if (IsTag(tag, "BlockArray"))  return true;
+#ifdef EXTENDED_BLOCKS
+	if (IsTag(tag, "BlockArray2")) return true;
+#endif
+	return false;
+}
+
 /* Imports a world from a .cw ClassicWorld map file */
 /* Used by ClassiCube/ClassicalSharp */
 static cc_result Cw_Load(struct Stream* stream) {
-	return Nbt_Read(stream, Cw_Callback);
+	return Nbt_Read(stream, Cw_Callback, Cw_WantsArray, NULL);
+}
+
+#ifdef MAP_INDEX_THREADED
+static struct MapInfo* cw_info;
+static struct MapThumb cw_thumb;
+static cc_bool cw_infoDone;
+
+static void Cw_InfoCallback(struct NbtTag* tag) {
+	struct NbtTag* tmp = tag->parent;
+	int depth = 0;
+	while (tmp) { depth++; tmp = tmp->parent; }
+
+	if (depth == 1) {
+		if (IsTag(tag, "X")) { cw_info->width  = NbtTag_U16(tag); return; }
+		if (IsTag(tag, "Y")) { cw_info->height = NbtTag_U16(tag); return; }
+		if (IsTag(tag, "Z")) { cw_info->length = NbtTag_U16(tag); return; }
+
+		/* Only tiny maps have a block array small enough to be stored inline in the tag */
+		if (IsTag(tag, "BlockArray") && tag->type == NBT_I8S) {
+			MapThumb_Init(&cw_thumb, cw_info, NULL);
+			MapThumb_Add(&cw_thumb, tag->value.small, tag->dataSize);
+			cw_infoDone = true;
+			tag->result = ERR_END_OF_STREAM;
+		}
+	} else if (depth == 2 && IsTag(tag->parent, "Spawn")) {
+		cw_info->hasSpawn = true;
+
+		if (IsTag(tag, "X")) { cw_info->spawnX = NbtTag_I16(tag); return; }
+		if (IsTag(tag, "Y")) { cw_info->spawnY = NbtTag_I16(tag); return; }
+		if (IsTag(tag, "Z")) { cw_info->spawnZ = NbtTag_I16(tag); return; }
+	}
+}
+
+/* Builds the thumbnail directly from the stream, instead of reading the blocks into memory */
+static cc_result Cw_ReadInfoArray(struct NbtTag* tag, struct Stream* stream) {
+	cc_result res;
+	if (!IsTag(tag, "BlockArray") || !tag->parent || tag->parent->parent) 
+		return stream->Skip(stream, tag->dataSize);
+
+	MapThumb_Init(&cw_thumb, cw_info, NULL);
+	if ((res = MapThumb_Read(&cw_thumb, stream, tag->dataSize))) return res;
+
+	/* Nothing after the blocks is needed, so stop reading early */
+	cw_infoDone = true;
+	return ERR_END_OF_STREAM;
+}
+
+/* Reads the dimensions, spawn and thumbnail of a .cw map file, without loading it */
+static cc_result Cw_ReadInfo(struct Stream* stream, struct MapInfo* info) {
+	cc_result res;
+	cw_info     = info;
+	cw_infoDone = false;
+
+	res = Nbt_Read(stream, Cw_InfoCallback, NULL, Cw_ReadInfoArray);
+	nbt_arrayReader = NULL;
+	return cw_infoDone ? 0 : res;
 }
+#endif
 
 
 /*########################################################################################################################*
@@ -1137,10 +1400,9 @@ static cc_result Java_ReadNewString(struct Stream* stream, struct JUnion* object
 	return Java_ReadString(stream, object->Value.String);
 }
 
-static cc_result Java_ReadNewObject(struct Stream* stream, struct JUnion* object) {
+static cc_result Java_ReadNewObjectFields(struct Stream* stream, struct JUnion* object) {
 	struct JClassDesc* head;
 	cc_result res;
-	if ((res = Java_ReadClassDesc(stream, &object->Value.Object))) return res;
 	Java_AddReference();
 
 	/* Linked list of classes, with most superclass fist as head */
@@ -1158,6 +1420,12 @@ static cc_result Java_ReadNewObject(struct Stream* stream, struct JUnion* object
 	return 0;
 }
 
+static cc_result Java_ReadNewObject(struct Stream* stream, struct JUnion* object) {
+	cc_result res;
+	if ((res = Java_ReadClassDesc(stream, &object->Value.Object))) return res;
+	return Java_ReadNewObjectFields(stream, object);
+}
+
 static cc_result Java_ReadNewArray(struct Stream* stream, struct JUnion* object) {
 	struct JArray* array = &object->Value.Array;
 	union JValue value;
@@ -1285,13 +1553,171 @@ static cc_result Dat_LoadFormat1(struct Stream* stream) {
 	return Map_ReadBlocks(stream);
 }
 
+static void Dat_ApplyField(struct JFieldDesc* field) {
+	cc_string fieldName = String_FromRaw((char*)field->FieldName, JNAME_SIZE);
+
+	if (String_CaselessEqualsConst(&fieldName, "width")) {
+		World.Width  = Java_I32(field);
+	} else if (String_CaselessEqualsConst(&fieldName, "height")) {
+		World.Length = Java_I32(field);
+	} else if (String_CaselessEqualsConst(&fieldName, "depth")) {
+		World.Height = Java_I32(field);
+	} else if (String_CaselessEqualsConst(&fieldName, "blocks")) {
+		if (field->Type != JFIELD_ARRAY) Process_Abort("Blocks field must be Array");
+		World.Blocks = field->Value.Array.Ptr;
+		World.Volume = field->Value.Array.Size;
+	} else if (String_CaselessEqualsConst(&fieldName, "xSpawn")) {
+		spawn_point->pos.x = (float)Java_I32(field);
+		spawn_point->flags = LU_HAS_POS;
+	} else if (String_CaselessEqualsConst(&fieldName, "ySpawn")) {
+		spawn_point->pos.y = (float)Java_I32(field);
+		spawn_point->flags = LU_HAS_POS;
+	} else if (String_CaselessEqualsConst(&fieldName, "zSpawn")) {
+		spawn_point->pos.z = (float)Java_I32(field);
+		spawn_point->flags = LU_HAS_POS;
+	}
+}
+
+static int Dat_FindField(struct JClassDesc* desc, const char* name, cc_uint8 type) {
+	cc_string fieldName;
+	int i;
+
+	for (i = 0; i < desc->FieldsCount; i++)
+	{
+		fieldName = String_FromRaw((char*)desc->Fields[i].FieldName, JNAME_SIZE);
+		if (!String_CaselessEqualsConst(&fieldName, name)) continue;
+		return desc->Fields[i].Type == type ? i : -1;
+	}
+	return -1;
+}
+
+/* Whether the root object is a plain com.mojang.minecraft.level.Level instance, */
+/*  with the map dimensions serialised before any of its object fields */
+static cc_bool Dat_IsStandardLevel(struct JClassDesc* desc) {
+	cc_string className = String_FromRaw((char*)desc->ClassName, JNAME_SIZE);
+	int i, width, height, depth, blocks;
+
+	if (!String_CaselessEqualsConst(&className, "com.mojang.minecraft.level.Level")) return false;
+	if (desc->SuperClass || desc->Flags != SC_SERIALIZABLE) return false;
+
+	width  = Dat_FindField(desc, "width",  JFIELD_I32);
+	height = Dat_FindField(desc, "height", JFIELD_I32);
+	depth  = Dat_FindField(desc, "depth",  JFIELD_I32);
+	blocks = Dat_FindField(desc, "blocks", JFIELD_ARRAY);
+	if (width < 0 || height < 0 || depth < 0 || blocks < 0) return false;
+
+	for (i = 0; i < desc->FieldsCount; i++)
+	{
+		if (desc->Fields[i].Type != JFIELD_ARRAY && desc->Fields[i].Type != JFIELD_OBJECT) continue;
+		return width < i && height < i && depth < i;
+	}
+	return false;
+}
+
+#define DAT_SCAN_SIZE 4096
+/* TC_ARRAY TC_CLASSDESC "[B" (8 bytes serialVersionUID, flags, 0 fields, TC_ENDBLOCKDATA, TC_NULL) */
+#define DAT_ARRAY_HEADER (2 + 4 + 8 + 1 + 2 + 2)
+/* Enough bytes to check the array header preceding the count */
+#define DAT_SCAN_KEEP (DAT_ARRAY_HEADER + 4)
+
+static cc_bool Dat_IsBlocksHeader(const cc_uint8* data, int i) {
+	const cc_uint8* h;
+	/* TC_ARRAY TC_REFERENCE (handle), when "[B" class was already described earlier */
+	if (i >= 6 && data[i - 6] == TC_ARRAY && data[i - 5] == TC_REFERENCE
+		&& data[i - 4] == 0x00 && data[i - 3] == 0x7E) return true;
+	if (i < DAT_ARRAY_HEADER) return false;
+
+	h = data + i - DAT_ARRAY_HEADER;
+	return h[0]  == TC_ARRAY && h[1]  == TC_CLASSDESC && h[2] == 0x00 && h[3] == 0x02 
+		&& h[4]  == '['      && h[5]  == 'B'
+		&& h[15] == 0x00     && h[16] == 0x00 && h[17] == TC_ENDBLOCKDATA && h[18] == TC_NULL;
+}
+
+/* Skips over the serialised data of objects without parsing them, until the */
+/*  header of a byte array with exactly the number of blocks in the map is found */
+/* The blocks are then passed to the given thumbnail, or read into the world if NULL */
+static cc_result Dat_SeekBlocks(struct Stream* stream, cc_uint32 volume, struct MapThumb* thumb) {
+	cc_uint8 buffer[DAT_SCAN_KEEP + DAT_SCAN_SIZE];
+	cc_uint8 count[4];
+	cc_uint32 len = 0, read, avail;
+	cc_result res;
+	int i;
+	Stream_SetU32_BE(count, volume);
+
+	for (;;)
+	{
+		res = stream->Read(stream, buffer + len, DAT_SCAN_SIZE, &read);
+		if (res)   return res;
+		if (!read) return ERR_END_OF_STREAM;
+		len += read;
+
+		for (i = 0; i + 4 <= len; i++)
+		{
+			if (buffer[i] != count[0] || !Mem_Equal(buffer + i, count, 4)) continue;
+			if (!Dat_IsBlocksHeader(buffer, i)) continue;
+
+			i    += 4;
+			avail = min(len - i, volume);
+#ifdef MAP_INDEX_THREADED
+			if (thumb) {
+				MapThumb_Add(thumb, buffer + i, avail);
+				return MapThumb_Read(thumb, stream, volume - avail);
+			}
+#endif
+
+			World.Blocks = (BlockRaw*)Mem_TryAlloc(volume, 1);
+			if (!World.Blocks) return ERR_OUT_OF_MEMORY;
+			World.Volume = volume;
+
+			Mem_Copy(World.Blocks, buffer + i, avail);
+			return Stream_Read(stream, World.Blocks + avail, volume - avail);
+		}
+
+		/* Keep the last few bytes, in case the array header was split across reads */
+		avail = min(len, DAT_SCAN_KEEP);
+		Mem_Move(buffer, buffer + len - avail, avail);
+		len   = avail;
+	}
+}
+
+/* Reads only the fields of a standard Level object needed to load the map, then stops */
+static cc_result Dat_LoadLevel(struct Stream* stream, struct JClassDesc* desc) {
+	struct JFieldDesc* field;
+	cc_string fieldName;
+	cc_uint8 typeCode;
+	cc_result res;
+	int i;
+	Java_AddReference();
+
+	for (i = 0; i < desc->FieldsCount; i++)
+	{
+		field     = &desc->Fields[i];
+		fieldName = String_FromRaw((char*)field->FieldName, JNAME_SIZE);
+
+		if (String_CaselessEqualsConst(&fieldName, "blocks")) {
+			if ((res = Java_ReadValue(stream, field->Type, &field->Value))) return res;
+			/* Nothing after the blocks array is needed */
+			Dat_ApplyField(field);
+			return 0;
+		} else if (field->Type == JFIELD_ARRAY || field->Type == JFIELD_OBJECT) {
+			if ((res = stream->ReadU8(stream, &typeCode))) return res;
+			if (typeCode == TC_NULL) continue;
+
+			/* e.g. blockMap of survival maps, which contains every entity */
+			return Dat_SeekBlocks(stream, (cc_uint32)World.Width * World.Height * World.Length, NULL);
+		} else {
+			if ((res = Java_ReadValue(stream, field->Type, &field->Value))) return res;
+			Dat_ApplyField(field);
+		}
+	}
+	return 0;
+}
+
 static cc_result Dat_LoadFormat2(struct Stream* stream) {
 	struct JClassDesc classes[CLASS_CAPACITY];
 	cc_uint8 header[2 + 2];
 	struct JUnion obj;
 	struct JClassDesc* desc;
-	struct JFieldDesc* field;
-	cc_string fieldName;
 	cc_result res;
 	int i;
 	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
@@ -1305,35 +1731,18 @@ static cc_result Dat_LoadFormat2(struct Stream* stream) {
 	if (Stream_GetU16_BE(header + 0) != 0xACED) return DAT_ERR_JIDENTIFIER;
 	if (Stream_GetU16_BE(header + 2) != 0x0005) return DAT_ERR_JVERSION;
 
-	if ((res = Java_ReadObject(stream, &obj)))  return res;
-	if (obj.Type != TC_OBJECT)                  return DAT_ERR_ROOT_OBJECT;
+	if ((res = stream->ReadU8(stream, &obj.Type))) return res;
+	if (obj.Type != TC_OBJECT)                     return DAT_ERR_ROOT_OBJECT;
+
+	/* Fast path for the usual Level object, which avoids deserialising every entity */
+	if ((res = Java_ReadClassDesc(stream, &obj.Value.Object))) return res;
 	desc = obj.Value.Object;
+	if (Dat_IsStandardLevel(desc)) return Dat_LoadLevel(stream, desc);
 
+	if ((res = Java_ReadNewObjectFields(stream, &obj))) return res;
 	for (i = 0; i < desc->FieldsCount; i++) 
 	{
-		field     = &desc->Fields[i];
-		fieldName = String_FromRaw((char*)field->FieldName, JNAME_SIZE);
-
-		if (String_CaselessEqualsConst(&fieldName, "width")) {
-			World.Width  = Java_I32(field);
-		} else if (String_CaselessEqualsConst(&fieldName, "height")) {
-			World.Length = Java_I32(field);
-		} else if (String_CaselessEqualsConst(&fieldName, "depth")) {
-			World.Height = Java_I32(field);
-		} else if (String_CaselessEqualsConst(&fieldName, "blocks")) {
-			if (field->Type != JFIELD_ARRAY) Process_Abort("Blocks field must be Array");
-			World.Blocks = field->Value.Array.Ptr;
-			World.Volume = field->Value.Array.Size;
-		} else if (String_CaselessEqualsConst(&fieldName, "xSpawn")) {
-			spawn_point->pos.x = (float)Java_I32(field);
-			spawn_point->flags = LU_HAS_POS;
-		} else if (String_CaselessEqualsConst(&fieldName, "ySpawn")) {
-			spawn_point->pos.y = (float)Java_I32(field);
-			spawn_point->flags = LU_HAS_POS;
-		} else if (String_CaselessEqualsConst(&fieldName, "zSpawn")) {
-			spawn_point->pos.z = (float)Java_I32(field);
-			spawn_point->flags = LU_HAS_POS;
-		}
+		Dat_ApplyField(&desc->Fields[i]);
 	}
 	return 0;
 }
@@ -1375,6 +1784,138 @@ static cc_result Dat_Load(struct Stream* stream) {
 	}
 }
 
+#ifdef MAP_INDEX_THREADED
+static void Dat_ApplyInfoField(struct JFieldDesc* field, struct MapInfo* info) {
+	cc_string fieldName = String_FromRaw((char*)field->FieldName, JNAME_SIZE);
+	/* Java_I32 aborts for other types of fields, which is not acceptable for just reading info */
+	if (field->Type != JFIELD_I32) return;
+
+	if (String_CaselessEqualsConst(&fieldName, "width")) {
+		info->width  = Java_I32(field);
+	} else if (String_CaselessEqualsConst(&fieldName, "height")) {
+		info->length = Java_I32(field);
+	} else if (String_CaselessEqualsConst(&fieldName, "depth")) {
+		info->height = Java_I32(field);
+	} else if (String_CaselessEqualsConst(&fieldName, "xSpawn")) {
+		info->spawnX   = Java_I32(field);
+		info->hasSpawn = true;
+	} else if (String_CaselessEqualsConst(&fieldName, "ySpawn")) {
+		info->spawnY   = Java_I32(field);
+		info->hasSpawn = true;
+	} else if (String_CaselessEqualsConst(&fieldName, "zSpawn")) {
+		info->spawnZ   = Java_I32(field);
+		info->hasSpawn = true;
+	}
+}
+
+/* Same as Dat_LoadLevel, except that the blocks are only used to build the thumbnail */
+static cc_result Dat_ReadLevelInfo(struct Stream* stream, struct JClassDesc* desc, struct MapInfo* info) {
+	struct JFieldDesc* field;
+	struct MapThumb thumb;
+	cc_string fieldName;
+	cc_uint8 typeCode;
+	cc_result res;
+	int i;
+	Java_AddReference();
+
+	for (i = 0; i < desc->FieldsCount; i++)
+	{
+		field     = &desc->Fields[i];
+		fieldName = String_FromRaw((char*)field->FieldName, JNAME_SIZE);
+
+		/* Dat_SeekBlocks also finds the blocks array when it immediately follows */
+		if (String_CaselessEqualsConst(&fieldName, "blocks")) break;
+
+		if (field->Type == JFIELD_ARRAY || field->Type == JFIELD_OBJECT) {
+			if ((res = stream->ReadU8(stream, &typeCode))) return res;
+			if (typeCode != TC_NULL) break;
+		} else {
+			if ((res = Java_ReadValue(stream, field->Type, &field->Value))) return res;
+			Dat_ApplyInfoField(field, info);
+		}
+	}
+
+	MapThumb_Init(&thumb, info, NULL);
+	return Dat_SeekBlocks(stream, (cc_uint32)info->width * info->height * info->length, &thumb);
+}
+
+static cc_result Dat_ReadFormat2Info(struct Stream* stream, struct MapInfo* info) {
+	struct JClassDesc classes[CLASS_CAPACITY];
+	cc_uint8 header[2 + 2];
+	struct JClassDesc* desc;
+	cc_uint8 typeCode;
+	cc_result res;
+	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
+
+	/* Reset state for Java Serialisation */
+	class_cache  = classes;
+	class_count  = 0;
+	reference_id = 0x7E0000;
+
+	/* Java seralisation headers */
+	if (Stream_GetU16_BE(header + 0) != 0xACED) return DAT_ERR_JIDENTIFIER;
+	if (Stream_GetU16_BE(header + 2) != 0x0005) return DAT_ERR_JVERSION;
+
+	if ((res = stream->ReadU8(stream, &typeCode))) return res;
+	if (typeCode != TC_OBJECT)                     return DAT_ERR_ROOT_OBJECT;
+
+	/* Deserialising every entity of unusual maps just for a thumbnail isn't worth it */
+	if ((res = Java_ReadClassDesc(stream, &desc))) return res;
+	if (!Dat_IsStandardLevel(desc)) return ERR_NOT_SUPPORTED;
+	return Dat_ReadLevelInfo(stream, desc, info);
+}
+
+/* Reads the dimensions, spawn and thumbnail of a .dat map file, without loading it */
+static cc_result Dat_ReadInfo(struct Stream* stream, struct MapInfo* info) {
+	static const BlockRaw stone[5] = { BLOCK_STONE, BLOCK_STONE, BLOCK_STONE, BLOCK_STONE, BLOCK_STONE };
+	cc_uint8 level_name[JNAME_SIZE];
+	cc_uint8 level_author[JNAME_SIZE];
+	cc_uint8 header[8 + 2 + 2 + 2];
+	struct MapThumb thumb;
+	cc_result res;
+
+	struct Stream compStream;
+	struct InflateState state;
+	Inflate_MakeStream2(&compStream, &state, stream);
+	if ((res = Map_SkipGZipHeader(stream)))                 return res;
+	if ((res = Stream_Read(&compStream, header, 4 + 1)))    return res;
+
+	switch (Stream_GetU32_BE(header + 0))
+	{
+	case 0x271BB788: break;
+	case 0x01010101:
+		info->width  = 256;
+		info->height =  64;
+		info->length = 256;
+
+		/* First 5 bytes already read earlier as .dat header */
+		MapThumb_Init(&thumb, info, NULL);
+		MapThumb_Add(&thumb, stone, sizeof(stone));
+		return MapThumb_Read(&thumb, &compStream, PC_VOLUME - sizeof(stone));
+	default:
+		return DAT_ERR_IDENTIFIER;
+	}
+
+	switch (header[4])
+	{
+	case 0x01: break;
+	case 0x02: return Dat_ReadFormat2Info(&compStream, info);
+	default:   return DAT_ERR_VERSION;
+	}
+
+	if ((res = Java_ReadString(&compStream,   level_name))) return res;
+	if ((res = Java_ReadString(&compStream, level_author))) return res;
+	if ((res = Stream_Read(&compStream, header, sizeof(header)))) return res;
+
+	info->width  = Stream_GetU16_BE(header +  8);
+	info->length = Stream_GetU16_BE(header + 10);
+	info->height = Stream_GetU16_BE(header + 12);
+
+	MapThumb_Init(&thumb, info, NULL);
+	return MapThumb_Read(&thumb, &compStream, (cc_uint32)info->width * info->height * info->length);
+}
+#endif
+
 
 /*########################################################################################################################*
 *-----------------------------------------------------MCLevel format------------------------------------------------------*
@@ -1471,10 +2012,15 @@ static void MCLevel_Callback(struct NbtTag* tag) {
 			0					1				 2 */
 }
 
+/* The per block "data" array is ignored, since only the block IDs are imported */
+static cc_bool MCLevel_WantsArray(struct NbtTag* tag) {
+	return IsTag(tag, "blocks") && tag->parent && IsTag(tag->parent, "Map");
+}
+
 /* Imports a world from a .mclevel NBT map file */
 /* Used by Minecraft Indev client */
 static cc_result MCLevel_Load(struct Stream* stream) {
-	cc_result res = Nbt_Read(stream, MCLevel_Callback);
+	cc_result res = Nbt_Read(stream, MCLevel_Callback, MCLevel_WantsArray, NULL);
 
 	Env.EdgeHeight  = mcl_edgeHeight;
 	Env.SidesOffset = mcl_sidesHeight - mcl_edgeHeight;
@@ -1570,7 +2116,16 @@ static cc_result Cw_WriteBockDef(struct Stream* stream, int b) {
 	return Stream_Write(stream, buffer, (int)(cur - buffer));
 }
 
-cc_result Cw_Save(struct Stream* stream) {
+static cc_result Cw_WriteBlocks(struct Stream* stream) {
+#ifdef CC_BUILD_BRICKWORLD
+	return World_WriteBlocks(stream, false);
+#else
+	return Stream_Write(stream, World.Blocks, World.Volume);
+#endif
+}
+
+/* Writes the ClassicWorld NBT data, optionally leaving out the lower 8 bits "BlockArray" */
+static cc_result Cw_WriteMap(struct Stream* stream, cc_bool blocks) {
 	struct LocalPlayer* p = Entities.CurPlayer;
 	cc_uint8 buffer[2048];
 	cc_uint8* cur;
@@ -1600,18 +2155,18 @@ cc_result Cw_Save(struct Stream* stream) {
 		cur  = Nbt_WriteUInt8(cur,  "H", Math_Deg2Packed(p->SpawnYaw));
 		cur  = Nbt_WriteUInt8(cur,  "P", Math_Deg2Packed(p->SpawnPitch));
 	} *cur++ = NBT_END;
-	cur = Nbt_WriteArray(cur, "BlockArray", World.Volume);
+	if (blocks) cur = Nbt_WriteArray(cur, "BlockArray", World.Volume);
 
 	if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
-	if ((res = Stream_Write(stream, World.Blocks, World.Volume)))  return res;
+	if (blocks && (res = Cw_WriteBlocks(stream)))                  return res;
 
 #ifdef EXTENDED_BLOCKS
-	if (World.Blocks != World.Blocks2) {
+	if (World.IDMask > 0xFF) {
 		cur = buffer;
 		cur = Nbt_WriteArray(cur, "BlockArray2", World.Volume);
 
 		if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
-		if ((res = Stream_Write(stream, World.Blocks2, World.Volume))) return res;
+		if ((res = World_WriteBlocks(stream, true))) return res;
 	}
 #endif
 
@@ -1677,6 +2232,8 @@ cc_result Cw_Save(struct Stream* stream) {
 	return Stream_Write(stream, cw_end, sizeof(cw_end));
 }
 
+cc_result Cw_Save(struct Stream* stream) { return Cw_WriteMap(stream, true); }
+
 
 /*########################################################################################################################*
 *---------------------------------------------------Schematic export------------------------------------------------------*
@@ -1711,7 +2268,11 @@ cc_result Schematic_Save(struct Stream* stream) {
 		Stream_SetU32_BE(&tmp[74], World.Volume);
 	}
 	if ((res = Stream_Write(stream, tmp, sizeof(sc_begin)))) return res;
+#ifdef CC_BUILD_BRICKWORLD
+	if ((res = World_WriteBlocks(stream, false)))                return res;
+#else
 	if ((res = Stream_Write(stream, World.Blocks, World.Volume))) return res;
+#endif
 
 	Mem_Copy(tmp, sc_data, sizeof(sc_data));
 	{
@@ -1857,28 +2418,1204 @@ cc_result Dat_Save(struct Stream* stream) {
 
 
 /*########################################################################################################################*
-*-------------------------------------------------------Formats component-------------------------------------------------*
+*--------------------------------------------------------Map cache--------------------------------------------------------*
 *#########################################################################################################################*/
-static struct MapImporter cw_imp    = { ".cw",      Cw_Load };
-static struct MapImporter dat_imp   = { ".dat",     Dat_Load };
-static struct MapImporter lvl_imp   = { ".lvl",     Lvl_Load };
-static struct MapImporter mine_imp  = { ".mine",    Dat_Load };
-static struct MapImporter fcm_imp   = { ".fcm",     Fcm_Load };
-static struct MapImporter mclvl_imp = { ".mclevel", MCLevel_Load };
+/* Map caches are uncompressed copies of large maps, so that loading the same map again is much faster.
+	U8[4] "Magic"        ("CWMC")
+	U32   "SourceLength" (length of the map file the cache was made from)
+	U32   "SourceCRC32"  (CRC32 of the contents of that map file)
+	U32   "BlocksOffset" (multiple of MAPCACHE_ALIGN)
+	NBT   "ClassicWorld" (uncompressed, without "BlockArray")
+	U8*   "Blocks"       (lower 8 bits, at BlocksOffset)
+The lower 8 bits are aligned so that they can be directly memory mapped as the world's blocks */
+#define MAPCACHE_HEADER_SIZE 16
+#define MAPCACHE_MIN_VOLUME  (256 * 64 * 256)
+#ifdef CC_BUILD_FILEMAP
+#define MAPCACHE_ALIGN FILE_MAP_ALIGNMENT
+#else
+#define MAPCACHE_ALIGN (64 * 1024)
+#endif
+static const cc_uint8 mc_magic[4] = { 'C','W','M','C' };
 
-static void OnInit(void) {
-	MapImporter_Register(&cw_imp);
-	MapImporter_Register(&dat_imp);
-	MapImporter_Register(&lvl_imp);
-	MapImporter_Register(&mine_imp);
-	MapImporter_Register(&fcm_imp);
-	MapImporter_Register(&mclvl_imp);
-}
+static cc_result MapCache_MakeKey(struct MapCacheKey* key, const cc_string* path, struct Stream* src) {
+	cc_string file = *path;
+	cc_uint8 buffer[8192];
+	cc_uint32 read, crc = 0xffffffffUL;
+	cc_result res;
 
-static void OnFree(void) {
-	imp_head = NULL;
+	key->length = 0;
+	for (;;) {
+		if ((res = src->Read(src, buffer, sizeof(buffer), &read))) return res;
+		if (!read) break;
+
+		crc = Utils_CRC32Update(crc, buffer, read);
+		key->length += read;
+	}
+	key->crc32 = crc ^ 0xffffffffUL;
+
+	Utils_UNSAFE_GetFilename(&file);
+	String_InitArray(key->path, key->_pathBuffer);
+	String_Format1(&key->path, "mapcache/%s.cwmc", &file);
+	return src->Seek(src, 0);
 }
-#else
+
+static cc_result MapCache_ReadBlocks(struct Stream* stream, cc_uint32 offset, cc_uint32 volume) {
+	cc_result res;
+#ifdef CC_BUILD_FILEMAP
+	void* data;
+
+	if (!File_Map(stream->meta.file, offset, volume, &data)) {
+		World.Blocks = (BlockRaw*)data;
+		World_SetBlocksMapped(volume);
+		return 0;
+	}
+	/* Fallback to reading the blocks normally */
+#endif
+	World.Blocks = (BlockRaw*)Mem_TryAlloc(volume, 1);
+	if (!World.Blocks) return ERR_OUT_OF_MEMORY;
+
+	if ((res = stream->Seek(stream, offset))) return res;
+	return Stream_Read(stream, World.Blocks, volume);
+}
+
+static cc_result MapCache_Read(struct Stream* stream, cc_uint32 offset) {
+	struct Stream buffered;
+	cc_uint8 buffer[8192];
+	cc_uint32 length, volume;
+	cc_uint8 tag;
+	cc_result res;
+
+	Stream_ReadonlyBuffered(&buffered, stream, buffer, sizeof(buffer));
+	if ((res = buffered.ReadU8(&buffered, &tag))) return res;
+
+	if (tag != NBT_DICT) return CW_ERR_ROOT_TAG;
+	/* Array reader state may have been left behind by whatever map was last imported */
+	nbt_arrayFilter = Cw_WantsArray;
+	nbt_arrayReader = NULL;
+	if ((res = Nbt_ReadTag(NBT_DICT, true, &buffered, NULL, Cw_Callback, 0))) return res;
+
+	volume = World.Width * World.Height * World.Length;
+	if ((res = stream->Length(stream, &length))) return res;
+
+	if (!volume || offset % MAPCACHE_ALIGN || offset > length || volume > length - offset)
+		return ERR_END_OF_STREAM;
+
+	World.Volume = volume;
+	return MapCache_ReadBlocks(stream, offset, volume);
+}
+
+static cc_bool MapCache_Load(const struct MapCacheKey* key) {
+	cc_uint8 header[MAPCACHE_HEADER_SIZE];
+	struct Stream stream;
+	cc_bool loaded = false;
+	cc_result res;
+
+	/* Cache not existing yet is the common case, so don't log an error for that */
+	if (Stream_OpenFile(&stream, &key->path)) return false;
+	res = Stream_Read(&stream, header, sizeof(header));
+
+	/* Caches made from a different version of the map file are just ignored */
+	if (!res && Mem_Equal(header, mc_magic, sizeof(mc_magic))
+			&& Stream_GetU32_BE(&header[4]) == key->length 
+			&& Stream_GetU32_BE(&header[8]) == key->crc32) {
+
+		if ((res = MapCache_Read(&stream, Stream_GetU32_BE(&header[12])))) {
+			Logger_SysWarn2(res, "decoding", &key->path);
+			/* Discard any partially loaded state before importing the map normally */
+			Game_Reset();
+			spawn_point->flags = 0;
+		} else {
+			loaded = true;
+		}
+	}
+
+	/* No point logging error for closing readonly file */
+	(void)stream.Close(&stream);
+	return loaded;
+}
+
+static cc_result MapCache_Write(struct Stream* stream, const struct MapCacheKey* key) {
+	cc_uint8 header[MAPCACHE_HEADER_SIZE] = { 0 };
+	cc_uint8 padding[4096] = { 0 };
+	cc_uint32 offset, count;
+	cc_result res;
+
+	/* Real header is written last, so that a partially written cache is never treated as valid */
+	if ((res = Stream_Write(stream, header, sizeof(header)))) return res;
+	if ((res = Cw_WriteMap(stream, false)))                   return res;
+	if ((res = stream->Position(stream, &offset)))            return res;
+
+	for (; offset % MAPCACHE_ALIGN; offset += count) {
+		count = min(sizeof(padding), MAPCACHE_ALIGN - offset % MAPCACHE_ALIGN);
+		if ((res = Stream_Write(stream, padding, count))) return res;
+	}
+	if ((res = Cw_WriteBlocks(stream))) return res;
+
+	Mem_Copy(header, mc_magic, sizeof(mc_magic));
+	Stream_SetU32_BE(&header[4],  key->length);
+	Stream_SetU32_BE(&header[8],  key->crc32);
+	Stream_SetU32_BE(&header[12], offset);
+
+	if ((res = stream->Seek(stream, 0))) return res;
+	return Stream_Write(stream, header, sizeof(header));
+}
+
+static void MapCache_Save(const struct MapCacheKey* key) {
+	struct Stream stream;
+	cc_result res, closeRes;
+
+	/* Small maps load quickly enough anyways */
+	if (World.Volume < MAPCACHE_MIN_VOLUME) return;
+	if (!Utils_EnsureDirectory("mapcache")) return;
+
+	res = Stream_CreateFile(&stream, &key->path);
+	if (res) { Logger_SysWarn2(res, "creating", &key->path); return; }
+
+	res      = MapCache_Write(&stream, key);
+	closeRes = stream.Close(&stream);
+	if (!res) res = closeRes;
+	if (res) Logger_SysWarn2(res, "saving", &key->path);
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Autosave journal-----------------------------------------------------*
+*#########################################################################################################################*/
+/* The journal is a sidecar file next to the map that has changed chunks appended to it, */
+/*  so that changes since the last full save can be recovered much more cheaply */
+/* Header: U8[4] "CCJ\1", U16 width, height, length, U16 unused, U32 size of the saved map file */
+/* Then records: U32 compressed size, U8 has upper blocks, DEFLATE compressed chunks */
+/* Chunk: U16 chunk x, y, z, U8* lower 8 bits of blocks, U8* upper 8 bits (only if has upper) */
+#define JOURNAL_HEADER_SIZE 16
+#define JOURNAL_RECORD_SIZE 5
+#define JOURNAL_CHUNK_SIZE  6
+/* Once the journal grows beyond this, it is compacted by doing a full save instead */
+#define JOURNAL_MAX_SIZE (2 * 1024 * 1024)
+static const cc_uint8 journal_magic[4] = { 'C', 'C', 'J', 1 };
+
+/* One bit per chunk, set when any block in the chunk changes */
+static cc_uint8* journal_dirty;
+static int journal_dirtyCount;
+/* Whether changes are tracked, and whether the journal file is ready to be appended to */
+static cc_bool journal_tracking, journal_ready;
+static cc_uint32 journal_size;
+static double journal_interval, journal_lastWrite;
+
+static char journal_pathBuffer[FILENAME_SIZE];
+static cc_string journal_path = String_FromArray(journal_pathBuffer);
+
+static void Journal_MakePath(cc_string* path, const cc_string* mapPath) {
+	path->length = 0;
+	String_AppendString(path, mapPath);
+	String_AppendConst(path,  ".journal");
+}
+
+static void Journal_OnBlocksChanged(void* obj, const struct BlockChange* changes, int count) {
+	int i, index;
+	if (!journal_tracking) return;
+
+	if (!journal_dirty) {
+		journal_dirty = (cc_uint8*)Mem_TryAllocCleared((World.ChunksCount + 7) >> 3, 1);
+		/* Without tracking, changes just won't be journalled until the next full save */
+		if (!journal_dirty) { journal_tracking = false; journal_ready = false; return; }
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		index = World_ChunkPack(changes[i].coords.x >> CHUNK_SHIFT, 
+					changes[i].coords.y >> CHUNK_SHIFT, changes[i].coords.z >> CHUNK_SHIFT);
+		if (journal_dirty[index >> 3] & (1 << (index & 7))) continue;
+
+		journal_dirty[index >> 3] |= 1 << (index & 7);
+		journal_dirtyCount++;
+	}
+}
+
+static void Journal_ClearDirty(void) {
+	if (journal_dirty) Mem_Set(journal_dirty, 0, (World.ChunksCount + 7) >> 3);
+	journal_dirtyCount = 0;
+}
+
+static void Journal_Free(void) {
+	Mem_Free(journal_dirty);
+	journal_dirty      = NULL;
+	journal_dirtyCount = 0;
+	journal_tracking   = false;
+	journal_ready      = false;
+}
+
+/* Starts tracking changes made after the map was snapshotted for saving to the given path */
+static void Journal_Begin(const cc_string* mapPath) {
+	if (!journal_interval) return;
+	Journal_MakePath(&journal_path, mapPath);
+
+	journal_tracking = true;
+	journal_ready    = false;
+	Journal_ClearDirty();
+}
+
+/* Discards all records, since the map file they were relative to has been replaced */
+static void Journal_Reset(cc_uint32 mapSize) {
+	cc_uint8 header[JOURNAL_HEADER_SIZE] = { 0 };
+	cc_result res;
+	if (!journal_tracking) return;
+
+	Mem_Copy(header, journal_magic, sizeof(journal_magic));
+	Stream_SetU16_BE(&header[4], World.Width);
+	Stream_SetU16_BE(&header[6], World.Height);
+	Stream_SetU16_BE(&header[8], World.Length);
+	Stream_SetU32_BE(&header[12], mapSize);
+
+	res = Stream_WriteAllTo(&journal_path, header, sizeof(header));
+	if (res) { Logger_SysWarn2(res, "creating", &journal_path); return; }
+
+	journal_ready     = true;
+	journal_size      = sizeof(header);
+	journal_lastWrite = Game.Time;
+}
+
+static cc_result Journal_WriteChunk(struct Stream* s, int cx, int cy, int cz, cc_bool upper) {
+	cc_uint8 header[JOURNAL_CHUNK_SIZE];
+	BlockRaw lower[CHUNK_SIZE_3], upperData[CHUNK_SIZE_3];
+	int x1 = cx << CHUNK_SHIFT, x2 = min(World.Width,  x1 + CHUNK_SIZE);
+	int y1 = cy << CHUNK_SHIFT, y2 = min(World.Height, y1 + CHUNK_SIZE);
+	int z1 = cz << CHUNK_SHIFT, z2 = min(World.Length, z1 + CHUNK_SIZE);
+	int x, y, z, count = 0;
+	BlockID block;
+	cc_result res;
+
+	for (y = y1; y < y2; y++)
+		for (z = z1; z < z2; z++)
+			for (x = x1; x < x2; x++, count++)
+			{
+				block = World_GetBlock(x, y, z);
+				lower[count]     = (BlockRaw)block;
+				upperData[count] = (BlockRaw)(block >> 8);
+			}
+
+	Stream_SetU16_BE(&header[0], cx);
+	Stream_SetU16_BE(&header[2], cy);
+	Stream_SetU16_BE(&header[4], cz);
+
+	if ((res = Stream_Write(s, header, sizeof(header)))) return res;
+	if ((res = Stream_Write(s, lower, count)))           return res;
+	return upper ? Stream_Write(s, upperData, count) : 0;
+}
+
+static cc_result Journal_WriteChunks(struct Stream* s, cc_bool upper) {
+	int cx, cy, cz, index = 0;
+	cc_result res;
+
+	for (cz = 0; cz < World.ChunksZ; cz++)
+		for (cy = 0; cy < World.ChunksY; cy++)
+			for (cx = 0; cx < World.ChunksX; cx++, index++)
+			{
+				if (!(journal_dirty[index >> 3] & (1 << (index & 7)))) continue;
+				if ((res = Journal_WriteChunk(s, cx, cy, cz, upper))) return res;
+			}
+	return 0;
+}
+
+static cc_result Journal_Append(void) {
+	struct Stream mem, comp, file;
+	struct DeflateState* state;
+	cc_uint8 header[JOURNAL_RECORD_SIZE];
+	cc_uint32 size = 0;
+	cc_bool upper  = false;
+	cc_result res, closeRes;
+#ifdef EXTENDED_BLOCKS
+	upper = World.IDMask > 0xFF;
+#endif
+
+	state = (struct DeflateState*)Mem_TryAlloc(1, sizeof(struct DeflateState));
+	if (!state) return ERR_OUT_OF_MEMORY;
+
+	/* Compress into memory first, so the record is appended to the file in one go */
+	Stream_WriteonlyMemory(&mem);
+	Deflate_MakeStream(&comp, state, &mem);
+	Deflate_SetLevel(state, DEFLATE_LEVEL_FAST);
+
+	res = Journal_WriteChunks(&comp, upper);
+	if (!res) res = comp.Close(&comp);
+	if (!res) res = mem.Position(&mem, &size);
+	Mem_Free(state);
+
+	if (!res) {
+		Stream_SetU32_BE(&header[0], size);
+		header[4] = upper;
+		res = Stream_AppendFile(&file, &journal_path);
+	}
+
+	if (!res) {
+		res = Stream_Write(&file, header, sizeof(header));
+		if (!res) res = Stream_Write(&file, mem.meta.mem.base, size);
+
+		closeRes = file.Close(&file);
+		if (!res) res = closeRes;
+	}
+
+	Mem_Free(mem.meta.mem.base);
+	if (!res) journal_size += sizeof(header) + size;
+	return res;
+}
+
+/* Appends any changed chunks to the journal if the journal interval has elapsed */
+/* Returns the size of the journal, or 0 if journalling is not currently possible */
+static cc_uint32 Journal_Update(void) {
+	cc_result res;
+	if (!journal_ready) return 0;
+	if (!journal_dirtyCount || Game.Time - journal_lastWrite < journal_interval) return journal_size;
+
+	journal_lastWrite = Game.Time;
+	res = Journal_Append();
+	if (res) { Logger_SysWarn2(res, "appending to", &journal_path); journal_ready = false; return 0; }
+
+	Journal_ClearDirty();
+	return journal_size;
+}
+
+static cc_result Journal_ApplyChunk(struct Stream* s, cc_bool upper) {
+	cc_uint8 header[JOURNAL_CHUNK_SIZE];
+	BlockRaw lower[CHUNK_SIZE_3], upperData[CHUNK_SIZE_3];
+	int chunksX, chunksY, chunksZ;
+	int cx, cy, cz, x1, x2, y1, y2, z1, z2;
+	int x, y, z, count;
+	BlockRaw* upperBlocks = NULL;
+	cc_result res;
+
+	if ((res = Stream_Read(s, header, sizeof(header)))) return res;
+	cx = Stream_GetU16_BE(&header[0]);
+	cy = Stream_GetU16_BE(&header[2]);
+	cz = Stream_GetU16_BE(&header[4]);
+
+	/* Replayed before World_SetNewMap, so World.ChunksX/Y/Z have not been calculated yet */
+	chunksX = (World.Width  + CHUNK_MAX) >> CHUNK_SHIFT;
+	chunksY = (World.Height + CHUNK_MAX) >> CHUNK_SHIFT;
+	chunksZ = (World.Length + CHUNK_MAX) >> CHUNK_SHIFT;
+	if (cx >= chunksX || cy >= chunksY || cz >= chunksZ) return ERR_INVALID_ARGUMENT;
+
+	x1 = cx << CHUNK_SHIFT; x2 = min(World.Width,  x1 + CHUNK_SIZE);
+	y1 = cy << CHUNK_SHIFT; y2 = min(World.Height, y1 + CHUNK_SIZE);
+	z1 = cz << CHUNK_SHIFT; z2 = min(World.Length, z1 + CHUNK_SIZE);
+	count = (x2 - x1) * (y2 - y1) * (z2 - z1);
+
+	if ((res = Stream_Read(s, lower, count))) return res;
+	if (upper && (res = Stream_Read(s, upperData, count))) return res;
+
+#ifdef EXTENDED_BLOCKS
+	if (upper) {
+		upperBlocks = World_GetMapUpper();
+		if (!upperBlocks) {
+			upperBlocks = (BlockRaw*)Mem_TryAllocCleared(World.Volume, 1);
+			if (!upperBlocks) return ERR_OUT_OF_MEMORY;
+			World_SetMapUpper(upperBlocks);
+		}
+	}
+#endif
+
+	count = 0;
+	for (y = y1; y < y2; y++)
+		for (z = z1; z < z2; z++)
+			for (x = x1; x < x2; x++, count++)
+			{
+				World.Blocks[World_Pack(x, y, z)] = lower[count];
+				if (upperBlocks) upperBlocks[World_Pack(x, y, z)] = upperData[count];
+			}
+	return 0;
+}
+
+static int Journal_ApplyRecord(struct Stream* s, struct InflateState* state) {
+	struct Stream mem, comp;
+	cc_uint8 header[JOURNAL_RECORD_SIZE];
+	cc_uint8* data;
+	cc_uint32 size;
+	int chunks = -1;
+
+	if (Stream_Read(s, header, sizeof(header))) return -1;
+	size = Stream_GetU32_BE(&header[0]);
+
+	data = (cc_uint8*)Mem_TryAlloc(size, 1);
+	if (!data) return -1;
+
+	/* A partially written record (e.g. game crashed while appending) is ignored */
+	if (!Stream_Read(s, data, size)) {
+		Stream_ReadonlyMemory(&mem, data, size);
+		Inflate_MakeStream2(&comp, state, &mem);
+		for (chunks = 0; !Journal_ApplyChunk(&comp, header[4]); chunks++) { }
+	}
+
+	Mem_Free(data);
+	return chunks;
+}
+
+/* Applies changes from the journal for the given map file, if the journal was for that map */
+/* NOTE: Must be called after the map has been imported, but before World_SetNewMap */
+static cc_bool Journal_Replay(const cc_string* mapPath, cc_uint32 mapSize) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_uint8 header[JOURNAL_HEADER_SIZE];
+	cc_uint8 buffer[STREAM_FILE_BUFFER_SIZE / 4];
+	struct Stream stream, buffered;
+	struct InflateState* state;
+	int chunks, total = 0;
+
+	String_InitArray(path, pathBuffer);
+	Journal_MakePath(&path, mapPath);
+	if (!World.Blocks || Stream_OpenFile(&stream, &path)) return false;
+	Stream_ReadonlyBuffered(&buffered, &stream, buffer, sizeof(buffer));
+
+	state = (struct InflateState*)Mem_TryAlloc(1, sizeof(struct InflateState));
+	if (state && !Stream_Read(&buffered, header, sizeof(header))
+		&& Mem_Equal(header, journal_magic, sizeof(journal_magic))
+		&& Stream_GetU16_BE(&header[4])  == World.Width
+		&& Stream_GetU16_BE(&header[6])  == World.Height
+		&& Stream_GetU16_BE(&header[8])  == World.Length
+		&& Stream_GetU32_BE(&header[12]) == mapSize) {
+
+		while ((chunks = Journal_ApplyRecord(&buffered, state)) >= 0) total += chunks;
+	}
+
+	Mem_Free(state);
+	(void)stream.Close(&stream);
+
+	if (total) Chat_Add1("&eRestored %i changed chunks from map journal", &total);
+	return total > 0;
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Background saving-----------------------------------------------------*
+*#########################################################################################################################*/
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_WEB && !defined CC_BUILD_LOWMEM
+#define MAP_SAVE_THREADED
+#endif
+#define SAVE_CHUNK_SIZE (64 * 1024)
+
+/* Uncompressed snapshot of the map being saved */
+static cc_uint8* save_data;
+static cc_uint32 save_size, save_capacity;
+/* Number of bytes of the snapshot compressed so far */
+static volatile cc_uint32 save_written;
+static volatile cc_bool save_done;
+static cc_result save_result;
+/* Size of the compressed map file written */
+static cc_uint32 save_fileSize;
+static void* save_thread;
+static int save_level;
+
+static char save_pathBuffer[FILENAME_SIZE];
+static cc_string save_path     = String_FromArray(save_pathBuffer);
+/* Path the current map was last saved to (used for autosaving) */
+static char save_lastPathBuffer[FILENAME_SIZE];
+static cc_string save_lastPath = String_FromArray(save_lastPathBuffer);
+static double save_interval;
+
+MapExportFunc Map_FindExporter(const cc_string* path) {
+	static const cc_string schematic = String_FromConst(".schematic");
+	static const cc_string mine      = String_FromConst(".mine");
+
+	if (String_CaselessEnds(path, &schematic)) return Schematic_Save;
+	if (String_CaselessEnds(path, &mine))      return Dat_Save;
+	return Cw_Save;
+}
+
+static cc_result Snapshot_Write(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	cc_uint32 capacity;
+	cc_uint8* buffer;
+	*modified = 0;
+
+	if (save_size + count > save_capacity) {
+		capacity = max(save_capacity + save_capacity / 2, save_size + count + SAVE_CHUNK_SIZE);
+		buffer   = (cc_uint8*)Mem_TryRealloc(save_data, capacity, 1);
+		if (!buffer) return ERR_OUT_OF_MEMORY;
+
+		save_data     = buffer;
+		save_capacity = capacity;
+	}
+
+	Mem_Copy(save_data + save_size, data, count);
+	save_size += count;
+	*modified  = count;
+	return 0;
+}
+
+static void Snapshot_Free(void) {
+	Mem_Free(save_data);
+	save_data     = NULL;
+	save_size     = 0;
+	save_capacity = 0;
+}
+
+static cc_result Map_CompressSnapshot(struct Stream* stream) {
+	struct Stream compStream;
+	struct GZipState* state;
+	cc_uint32 count;
+	cc_result res = 0;
+
+	state = (struct GZipState*)Mem_TryAlloc(1, sizeof(struct GZipState));
+	if (!state) return ERR_OUT_OF_MEMORY;
+
+	GZip_MakeStream(&compStream, state, stream);
+	Deflate_SetLevel(&state->Base, save_level);
+
+	for (save_written = 0; !res && save_written < save_size; save_written += count) {
+		count = min(save_size - save_written, SAVE_CHUNK_SIZE);
+		res   = Stream_Write(&compStream, save_data + save_written, count);
+	}
+	if (!res) res = compStream.Close(&compStream);
+
+	Mem_Free(state);
+	return res;
+}
+
+#ifdef MAP_SAVE_THREADED
+/* Large snapshots are split into segments, which are then compressed in parallel on job worker threads */
+/* The compressed segments are concatenated together in order, so the result is still one gzip stream */
+#define SAVE_SEGMENT_SIZE (1024 * 1024)
+
+struct SaveSegment {
+	struct Job job;
+	cc_uint32 offset, size;
+	cc_uint8* output;
+	cc_uint32 outputSize;
+	cc_result result;
+};
+static struct SaveSegment* save_segments;
+static int save_numSegments;
+static void* save_segmentsWaitable;
+
+static void SaveSegment_Run(struct Job* job) {
+	struct SaveSegment* seg = (struct SaveSegment*)job->Obj;
+	struct Stream mem, compStream;
+	struct DeflateState* state;
+	cc_result res;
+
+	state = (struct DeflateState*)Mem_TryAlloc(1, sizeof(struct DeflateState));
+	if (state) {
+		Stream_WriteonlyMemory(&mem);
+		Deflate_MakeStream(&compStream, state, &mem);
+		Deflate_SetLevel(state, save_level);
+		Deflate_SetPartial(state, seg->offset + seg->size < save_size);
+
+		/* Priming with the end of the previous segment keeps compression close to compressing serially */
+		if (seg->offset) Deflate_SetDictionary(state, save_data + seg->offset - DEFLATE_BLOCK_SIZE, DEFLATE_BLOCK_SIZE);
+
+		res = Stream_Write(&compStream, save_data + seg->offset, seg->size);
+		if (!res) res = compStream.Close(&compStream);
+		if (!res) res = mem.Position(&mem, &seg->outputSize);
+
+		seg->output = mem.meta.mem.base;
+		Mem_Free(state);
+	} else {
+		res = ERR_OUT_OF_MEMORY;
+	}
+
+	seg->result = res;
+	Waitable_Signal(save_segmentsWaitable);
+}
+
+static void Map_AllocSegments(void) {
+	int i, count = (int)((save_size + SAVE_SEGMENT_SIZE - 1) / SAVE_SEGMENT_SIZE);
+	/* Compressing in parallel only helps when there are multiple workers to do it */
+	if (Jobs_WorkersCount() < 2 || count < 2) return;
+
+	save_segments = (struct SaveSegment*)Mem_TryAllocCleared(count, sizeof(struct SaveSegment));
+	if (!save_segments) return;
+	save_numSegments = count;
+	if (!save_segmentsWaitable) save_segmentsWaitable = Waitable_Create("Map save segments");
+
+	for (i = 0; i < count; i++)
+	{
+		save_segments[i].offset = i * SAVE_SEGMENT_SIZE;
+		save_segments[i].size   = min(save_size - save_segments[i].offset, SAVE_SEGMENT_SIZE);
+
+		save_segments[i].job.Run      = SaveSegment_Run;
+		save_segments[i].job.Obj      = &save_segments[i];
+		save_segments[i].job.Priority = JOB_PRIORITY_LOW;
+	}
+}
+
+/* Whether the jobs pool has finished with the segment's job (i.e. it was completed, cancelled, or never submitted) */
+#define SaveSegment_Released(seg) ((seg)->job.Status == JOB_STATUS_COMPLETED || (seg)->job.Status == JOB_STATUS_NONE)
+
+static void Map_FreeSegments(void) {
+	int i;
+	/* A worker still accesses the job for a short while after Run returns, until Jobs_Finish marks it completed */
+	for (i = 0; i < save_numSegments; i++)
+	{
+		while (!SaveSegment_Released(&save_segments[i])) Thread_Sleep(1);
+	}
+	/* The jobs pool may still reference the jobs until their completion has been processed */
+	if (save_segments) Jobs_ProcessCompleted();
+
+	Mem_Free(save_segments);
+	save_segments    = NULL;
+	save_numSegments = 0;
+}
+
+static cc_result Map_CompressSegments(struct Stream* stream) {
+	static const cc_uint8 header[10] = { 0x1F, 0x8B, 0x08 }; /* GZip header */
+	struct SaveSegment* seg;
+	cc_uint8 footer[8];
+	cc_uint32 crc32;
+	cc_result res;
+	int i;
+
+	for (i = 0; i < save_numSegments; i++) 
+	{
+		Jobs_Submit(&save_segments[i].job);
+	}
+
+	/* Checksum while the workers are compressing */
+	crc32 = Utils_CRC32(save_data, save_size);
+	res   = Stream_Write(stream, header, sizeof(header));
+
+	/* NOTE: Must wait for every segment even after an error, since they read from the snapshot */
+	for (i = 0; i < save_numSegments; i++)
+	{
+		seg = &save_segments[i];
+		while (seg->job.Status != JOB_STATUS_COMPLETED) 
+		{
+			/* Compress on this thread instead if no worker has started on the segment yet */
+			/* (also ensures saving completes even if the workers were stopped) */
+			if (Jobs_Cancel(&seg->job) || seg->job.Status == JOB_STATUS_NONE) {
+				SaveSegment_Run(&seg->job); break;
+			}
+			Waitable_WaitFor(save_segmentsWaitable, 100);
+		}
+
+		if (!res) res = seg->result;
+		if (!res) res = Stream_Write(stream, seg->output, seg->outputSize);
+
+		Mem_Free(seg->output);
+		seg->output  = NULL;
+		save_written = seg->offset + seg->size;
+	}
+	if (res) return res;
+
+	Stream_SetU32_LE(&footer[0], crc32);
+	Stream_SetU32_LE(&footer[4], save_size);
+	return Stream_Write(stream, footer, sizeof(footer));
+}
+#else
+static int save_numSegments;
+static void Map_FreeSegments(void)  { }
+static cc_result Map_CompressSegments(struct Stream* stream) { return ERR_NOT_SUPPORTED; }
+#endif
+
+/* Compresses the snapshot and writes it to the destination file */
+/* NOTE: When threading is supported, this is called from the background save thread */
+static cc_result Map_WriteSnapshot(void) {
+	struct Stream stream;
+	cc_result res, closeRes;
+
+	res = Stream_CreateFile(&stream, &save_path);
+	if (res) return res;
+
+	if (save_numSegments) {
+		res = Map_CompressSegments(&stream);
+	} else {
+		res = Map_CompressSnapshot(&stream);
+	}
+	if (!res) res = stream.Position(&stream, &save_fileSize);
+
+	closeRes = stream.Close(&stream);
+	if (!res) res = closeRes;
+	return res;
+}
+
+static void Map_FinishSave(void) {
+	if (save_thread) {
+		Thread_Join(save_thread);
+		save_thread = NULL;
+	}
+	Map_FreeSegments();
+	Snapshot_Free();
+	Chat_AddOf(&String_Empty, MSG_TYPE_STATUS_1);
+
+	if (save_result) {
+		Logger_SysWarn2(save_result, "saving", &save_path);
+	} else {
+		Chat_Add1("&eSaved map to: %s", &save_path);
+		Journal_Reset(save_fileSize);
+	}
+}
+
+#ifdef MAP_SAVE_THREADED
+static void Map_SaveWorker(void) {
+	save_result = Map_WriteSnapshot();
+	save_done   = true;
+}
+#endif
+
+cc_result Map_SaveAsync(const cc_string* path) {
+	struct Stream stream;
+	cc_result res;
+
+	/* Only one save can be in progress at a time */
+	if (save_thread) Map_FinishSave();
+	/* Columns which have not been generated yet would otherwise be saved as just air */
+	Gen_GenerateColumns(0, 0, World.MaxX, World.MaxZ);
+
+	Stream_Init(&stream);
+	stream.Write = Snapshot_Write;
+
+	res = Map_FindExporter(path)(&stream);
+	if (res) { Snapshot_Free(); Logger_SysWarn2(res, "encoding", path); return res; }
+
+	String_Copy(&save_path,     path);
+	String_Copy(&save_lastPath, path);
+	save_level     = Options_GetInt(OPT_MAP_COMPRESSION, DEFLATE_LEVEL_FAST, DEFLATE_LEVEL_BEST, DEFLATE_LEVEL_DEFAULT);
+	save_written   = 0;
+	save_done      = false;
+	World.LastSave = Game.Time;
+	Journal_Begin(path);
+
+#ifdef MAP_SAVE_THREADED
+	Map_AllocSegments();
+	Thread_Run(&save_thread, Map_SaveWorker, 64 * 1024, "Map save");
+#else
+	save_result = Map_WriteSnapshot();
+	Map_FinishSave();
+#endif
+	return 0;
+}
+
+cc_bool Map_IsSaving(void) { return save_thread != NULL; }
+
+/* Importing a map file that is still being written would fail to decode it */
+static void Map_WaitForSave(const cc_string* path) {
+	if (save_thread && String_CaselessEquals(&save_path, path)) Map_FinishSave();
+}
+
+static void Map_CheckAutosave(void) {
+	cc_bool compact;
+	if (!save_lastPath.length) return;
+	if (!Server.IsSinglePlayer || !World.Loaded) return;
+
+	/* Once the journal is large enough, loading it would be slower than loading a fully saved map */
+	compact = Journal_Update() >= JOURNAL_MAX_SIZE;
+	if (!compact && (!save_interval || Game.Time - World.LastSave < save_interval)) return;
+
+	/* Map_SaveAsync resets World.LastSave, but still need to avoid retrying every tick on failure */
+	if (Map_SaveAsync(&save_lastPath)) { World.LastSave = Game.Time; Journal_Free(); }
+}
+
+static void Map_SaveTick(struct ScheduledTask* task) {
+	cc_string msg; char msgBuffer[STRING_SIZE];
+	int percent;
+
+	if (!save_thread) { Map_CheckAutosave(); return; }
+	if (save_done)    { Map_FinishSave();    return; }
+
+	percent = (int)((cc_uint64)save_written * 100 / save_size);
+	String_InitArray(msg, msgBuffer);
+	String_Format1(&msg, "&eSaving map.. &7%i%%", &percent);
+	Chat_AddOf(&msg, MSG_TYPE_STATUS_1);
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Map index--------------------------------------------------------*
+*#########################################################################################################################*/
+/* The map index caches the summary of each map in the maps folder, so that the summaries can be shown
+    in the load level menu without needing to read every map file each time the menu is opened.
+	U8[4] "Magic" ("CWMI")
+	U32   "Count"
+	ENTRY {
+		U16   "PathLength"
+		U8*   "Path"        (relative to maps folder)
+		U32   "FileLength"  (length of the map file the summary was read from)
+		U8[8] "FileTrailer" (last 8 bytes of that map file, i.e. the CRC32 and size of GZIP compressed maps)
+		U8    "State"       (whether reading the summary succeeded)
+		U16   "Width", "Height", "Length"
+		U16   "SpawnX", "SpawnY", "SpawnZ"
+		U8    "HasSpawn"
+		U8    "ThumbWidth", "ThumbLength"
+		U8*   "ThumbBlocks", "ThumbHeights" (MAPINFO_THUMB_SIZE * MAPINFO_THUMB_SIZE each)
+	}
+There is no portable way of getting when a file was last modified, so a map file is instead
+ treated as changed when its length or trailer is different */
+#ifdef MAP_INDEX_THREADED
+#define MAPINDEX_HEADER_SIZE 8
+#define MAPINDEX_ENTRY_SIZE (4 + 8 + 1 + 6 * 2 + 1 + 2)
+#define MAPINDEX_TRAILER_SIZE 8
+enum MapIndexState { MAPINDEX_UNKNOWN, MAPINDEX_VALID, MAPINDEX_FAILED };
+static const cc_uint8 mi_magic[4] = { 'C','W','M','I' };
+static const cc_string mi_path = String_FromConst("mapcache/mapindex.bin");
+
+typedef cc_result (*MapInfoFunc)(struct Stream* stream, struct MapInfo* info);
+static const struct MapInfoReader { const char* fileExt; MapInfoFunc read; } mi_readers[] = {
+	{ ".cw",   Cw_ReadInfo  }, { ".dat", Dat_ReadInfo },
+	{ ".mine", Dat_ReadInfo }, { ".lvl", Lvl_ReadInfo }
+};
+
+struct MapIndexEntry {
+	cc_uint32 fileLength;
+	cc_uint8  trailer[MAPINDEX_TRAILER_SIZE];
+	cc_uint8  state;
+	cc_bool   listed; /* Whether the map is in the list of maps currently being indexed */
+	cc_uint16 pathLength;
+	char path[FILENAME_SIZE];
+	struct MapInfo info;
+};
+static struct MapIndexEntry* mi_entries;
+static int mi_count, mi_capacity;
+
+/* NOTE: Only the background thread modifies entries while it is running, */
+/*  which is done while holding the mutex so that MapIndex_Get can read entries */
+static void* mi_mutex;
+static void* mi_thread;
+static volatile int mi_version;
+static cc_bool mi_loaded, mi_dirty;
+
+static struct MapIndexEntry* MapIndex_Find(const cc_string* file) {
+	cc_string path;
+	int i;
+
+	for (i = 0; i < mi_count; i++)
+	{
+		path = String_Init(mi_entries[i].path, mi_entries[i].pathLength, FILENAME_SIZE);
+		if (String_Equals(&path, file)) return &mi_entries[i];
+	}
+	return NULL;
+}
+
+static struct MapIndexEntry* MapIndex_Add(const cc_string* file) {
+	struct MapIndexEntry* entry;
+	void* entries;
+
+	if (mi_count == mi_capacity) {
+		entries = Mem_TryRealloc(mi_entries, mi_capacity + 32, sizeof(struct MapIndexEntry));
+		if (!entries) return NULL;
+
+		mi_entries   = (struct MapIndexEntry*)entries;
+		mi_capacity += 32;
+	}
+
+	entry = &mi_entries[mi_count++];
+	Mem_Set(entry, 0, sizeof(*entry));
+	entry->pathLength = min(file->length, FILENAME_SIZE);
+	Mem_Copy(entry->path, file->buffer, entry->pathLength);
+	return entry;
+}
+
+static cc_result MapIndex_Read(struct Stream* stream) {
+	cc_uint8 header[MAPINDEX_HEADER_SIZE];
+	cc_uint8 data[MAPINDEX_ENTRY_SIZE];
+	char pathBuffer[FILENAME_SIZE];
+	struct MapIndexEntry* entry;
+	struct MapInfo* info;
+	cc_uint32 i, count, len;
+	cc_string path;
+	cc_result res;
+
+	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
+	/* Indexes from a different version of the format are just ignored */
+	if (!Mem_Equal(header, mi_magic, sizeof(mi_magic)))     return 0;
+	count = Stream_GetU32_LE(&header[4]);
+
+	for (i = 0; i < count; i++)
+	{
+		if ((res = Stream_Read(stream, data, 2)))  return res;
+		len = Stream_GetU16_LE(data);
+
+		if (len > FILENAME_SIZE) return ERR_INVALID_ARGUMENT;
+		if ((res = Stream_Read(stream, (cc_uint8*)pathBuffer, len))) return res;
+		path = String_Init(pathBuffer, len, FILENAME_SIZE);
+
+		entry = MapIndex_Add(&path);
+		if (!entry) return ERR_OUT_OF_MEMORY;
+		info  = &entry->info;
+		if ((res = Stream_Read(stream, data, sizeof(data)))) return res;
+
+		entry->fileLength = Stream_GetU32_LE(&data[0]);
+		Mem_Copy(entry->trailer, &data[4], MAPINDEX_TRAILER_SIZE);
+
+		info->width    = Stream_GetU16_LE(&data[13]);
+		info->height   = Stream_GetU16_LE(&data[15]);
+		info->length   = Stream_GetU16_LE(&data[17]);
+		info->spawnX   = (cc_int16)Stream_GetU16_LE(&data[19]);
+		info->spawnY   = (cc_int16)Stream_GetU16_LE(&data[21]);
+		info->spawnZ   = (cc_int16)Stream_GetU16_LE(&data[23]);
+		info->hasSpawn = data[25];
+
+		info->thumbWidth  = min(data[26], MAPINFO_THUMB_SIZE);
+		info->thumbLength = min(data[27], MAPINFO_THUMB_SIZE);
+		if ((res = Stream_Read(stream, info->thumbBlocks,  sizeof(info->thumbBlocks))))  return res;
+		if ((res = Stream_Read(stream, info->thumbHeights, sizeof(info->thumbHeights)))) return res;
+
+		/* Only set once fully read, so a partially read entry is just indexed again */
+		entry->state = data[12];
+	}
+	return 0;
+}
+
+static void MapIndex_Load(void) {
+	struct Stream stream, buffered;
+	cc_uint8 buffer[8192];
+	cc_result res;
+
+	/* Index not existing yet is the common case, so don't log an error for that */
+	if (Stream_OpenFile(&stream, &mi_path)) return;
+	Stream_ReadonlyBuffered(&buffered, &stream, buffer, sizeof(buffer));
+
+	res = MapIndex_Read(&buffered);
+	if (res) Logger_SysWarn2(res, "decoding", &mi_path);
+
+	/* No point logging error for closing readonly file */
+	(void)stream.Close(&stream);
+}
+
+static cc_result MapIndex_Write(struct Stream* stream) {
+	cc_uint8 header[MAPINDEX_HEADER_SIZE];
+	cc_uint8 data[MAPINDEX_ENTRY_SIZE];
+	struct MapIndexEntry* entry;
+	struct MapInfo* info;
+	cc_result res;
+	int i, count = 0;
+
+	for (i = 0; i < mi_count; i++)
+	{
+		if (mi_entries[i].state != MAPINDEX_UNKNOWN) count++;
+	}
+	Mem_Copy(header, mi_magic, sizeof(mi_magic));
+	Stream_SetU32_LE(&header[4], count);
+	if ((res = Stream_Write(stream, header, sizeof(header)))) return res;
+
+	for (i = 0; i < mi_count; i++)
+	{
+		entry = &mi_entries[i];
+		info  = &entry->info;
+		if (entry->state == MAPINDEX_UNKNOWN) continue;
+
+		Stream_SetU16_LE(data, entry->pathLength);
+		if ((res = Stream_Write(stream, data, 2))) return res;
+		if ((res = Stream_Write(stream, (cc_uint8*)entry->path, entry->pathLength))) return res;
+
+		Stream_SetU32_LE(&data[0], entry->fileLength);
+		Mem_Copy(&data[4], entry->trailer, MAPINDEX_TRAILER_SIZE);
+		data[12] = entry->state;
+
+		Stream_SetU16_LE(&data[13], info->width);
+		Stream_SetU16_LE(&data[15], info->height);
+		Stream_SetU16_LE(&data[17], info->length);
+		Stream_SetU16_LE(&data[19], info->spawnX);
+		Stream_SetU16_LE(&data[21], info->spawnY);
+		Stream_SetU16_LE(&data[23], info->spawnZ);
+		data[25] = info->hasSpawn;
+		data[26] = info->thumbWidth;
+		data[27] = info->thumbLength;
+
+		if ((res = Stream_Write(stream, data, sizeof(data)))) return res;
+		if ((res = Stream_Write(stream, info->thumbBlocks,  sizeof(info->thumbBlocks))))  return res;
+		if ((res = Stream_Write(stream, info->thumbHeights, sizeof(info->thumbHeights)))) return res;
+	}
+	return 0;
+}
+
+/* NOTE: Errors aren't logged, as this is called from the background thread */
+/*  (and the index is only a cache anyways, which is just rebuilt next time) */
+static void MapIndex_Save(void) {
+	struct Stream file, stream;
+	cc_uint8 buffer[8192];
+
+	if (Stream_CreateFile(&file, &mi_path)) return;
+
+	/* Closing the buffered stream also closes the file */
+	Stream_WriteonlyBuffered(&stream, &file, buffer, sizeof(buffer));
+	(void)MapIndex_Write(&stream);
+	(void)stream.Close(&stream);
+}
+
+static cc_result MapIndex_ReadKey(struct Stream* stream, cc_uint32* length, cc_uint8* trailer) {
+	cc_result res;
+	Mem_Set(trailer, 0, MAPINDEX_TRAILER_SIZE);
+
+	if ((res = stream->Length(stream, length))) return res;
+	if (*length >= MAPINDEX_TRAILER_SIZE) {
+		if ((res = stream->Seek(stream, *length - MAPINDEX_TRAILER_SIZE)))     return res;
+		if ((res = Stream_Read(stream, trailer, MAPINDEX_TRAILER_SIZE)))      return res;
+	}
+	return stream->Seek(stream, 0);
+}
+
+static cc_result MapIndex_ReadInfo(struct Stream* stream, const cc_string* file, struct MapInfo* info) {
+	cc_string ext;
+	int i;
+	Mem_Set(info, 0, sizeof(*info));
+
+	for (i = 0; i < Array_Elems(mi_readers); i++)
+	{
+		ext = String_FromReadonly(mi_readers[i].fileExt);
+		if (String_CaselessEnds(file, &ext)) return mi_readers[i].read(stream, info);
+	}
+	return ERR_NOT_SUPPORTED;
+}
+
+/* Reads the summary of the given map again, if the map file has changed since it was last indexed */
+static void MapIndex_Update(struct MapIndexEntry* entry) {
+	cc_string file = String_Init(entry->path, entry->pathLength, FILENAME_SIZE);
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_uint8 trailer[MAPINDEX_TRAILER_SIZE];
+	struct MapInfo info;
+	struct Stream stream;
+	cc_uint32 length;
+	cc_result res;
+
+	String_InitArray(path, pathBuffer);
+	String_Format1(&path, "maps/%s", &file);
+	/* Map may have been deleted since the list of maps was made */
+	if (Stream_OpenFile(&stream, &path)) return;
+
+	if (MapIndex_ReadKey(&stream, &length, trailer) || (entry->state != MAPINDEX_UNKNOWN
+			&& entry->fileLength == length && Mem_Equal(entry->trailer, trailer, sizeof(trailer)))) {
+		(void)stream.Close(&stream); return;
+	}
+
+	res = MapIndex_ReadInfo(&stream, &file, &info);
+	(void)stream.Close(&stream);
+	/* Summary is incomplete when indexing was stopped partway through the map */
+	if (mapInfo_stopping) return;
+
+	Mutex_Lock(mi_mutex);
+	{
+		entry->fileLength = length;
+		entry->state      = res ? MAPINDEX_FAILED : MAPINDEX_VALID;
+		entry->info       = info;
+		Mem_Copy(entry->trailer, trailer, sizeof(trailer));
+	}
+	Mutex_Unlock(mi_mutex);
+
+	mi_dirty = true;
+	mi_version++;
+}
+
+static void MapIndex_Worker(void) {
+	int i;
+	for (i = 0; i < mi_count && !mapInfo_stopping; i++)
+	{
+		if (mi_entries[i].listed) MapIndex_Update(&mi_entries[i]);
+	}
+	if (mi_dirty) MapIndex_Save();
+}
+
+void MapIndex_Start(struct StringsBuffer* files) {
+	struct MapIndexEntry* entry;
+	cc_string file;
+	int i;
+
+	MapIndex_Stop();
+	if (!mi_mutex)  mi_mutex = Mutex_Create("Map index");
+	if (!mi_loaded) { mi_loaded = true; MapIndex_Load(); }
+
+	for (i = 0; i < mi_count; i++)
+	{
+		mi_entries[i].listed = false;
+	}
+	for (i = 0; i < files->count; i++)
+	{
+		file  = StringsBuffer_UNSAFE_Get(files, i);
+		entry = MapIndex_Find(&file);
+
+		if (!entry) entry = MapIndex_Add(&file);
+		if (entry)  entry->listed = true;
+	}
+
+	/* Done here, since the background thread can't log errors */
+	Utils_EnsureDirectory("mapcache");
+	mapInfo_stopping = false;
+	mi_dirty         = false;
+	/* Reading .dat maps needs a lot of stack space for the Java class descriptions */
+	Thread_Run(&mi_thread, MapIndex_Worker, 256 * 1024, "Map index");
+}
+
+void MapIndex_Stop(void) {
+	if (!mi_thread) return;
+	mapInfo_stopping = true;
+
+	Thread_Join(mi_thread);
+	mi_thread = NULL;
+}
+
+cc_bool MapIndex_Get(const cc_string* file, struct MapInfo* info) {
+	struct MapIndexEntry* entry;
+	cc_bool found = false;
+	if (!mi_mutex) return false;
+
+	Mutex_Lock(mi_mutex);
+	{
+		entry = MapIndex_Find(file);
+		if (entry && entry->state == MAPINDEX_VALID) { *info = entry->info; found = true; }
+	}
+	Mutex_Unlock(mi_mutex);
+	return found;
+}
+
+int MapIndex_Version(void) { return mi_version; }
+
+static void MapIndex_Free(void) {
+	MapIndex_Stop();
+	Mem_Free(mi_entries);
+	mi_entries  = NULL;
+	mi_count    = 0;
+	mi_capacity = 0;
+	mi_loaded   = false;
+
+	if (mi_mutex) Mutex_Free(mi_mutex);
+	mi_mutex = NULL;
+}
+#else
+/* Reading every map on the main thread would make opening the load level menu too slow */
+void MapIndex_Start(struct StringsBuffer* files) { }
+void MapIndex_Stop(void) { }
+cc_bool MapIndex_Get(const cc_string* file, struct MapInfo* info) { return false; }
+int MapIndex_Version(void) { return 0; }
+static void MapIndex_Free(void) { }
+#endif
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Formats component-------------------------------------------------*
+*#########################################################################################################################*/
+static struct MapImporter cw_imp    = { ".cw",      Cw_Load };
+static struct MapImporter dat_imp   = { ".dat",     Dat_Load };
+static struct MapImporter lvl_imp   = { ".lvl",     Lvl_Load };
+static struct MapImporter mine_imp  = { ".mine",    Dat_Load };
+static struct MapImporter fcm_imp   = { ".fcm",     Fcm_Load };
+static struct MapImporter mclvl_imp = { ".mclevel", MCLevel_Load };
+
+static void OnInit(void) {
+	save_interval    = Options_GetInt(OPT_AUTOSAVE_INTERVAL, 0, 24 * 60, 0) * 60.0;
+	journal_interval = Options_GetInt(OPT_AUTOSAVE_JOURNAL,  0, 60 * 60, 0);
+	ScheduledTask_Add(0.5, Map_SaveTick);
+	Event_Register_(&WorldEvents.BlocksChanged, NULL, Journal_OnBlocksChanged);
+
+	MapImporter_Register(&cw_imp);
+	MapImporter_Register(&dat_imp);
+	MapImporter_Register(&lvl_imp);
+	MapImporter_Register(&mine_imp);
+	MapImporter_Register(&fcm_imp);
+	MapImporter_Register(&mclvl_imp);
+}
+
+static void OnFree(void) {
+	/* Make sure any in progress save gets fully written to disc */
+	if (save_thread) Map_FinishSave();
+	imp_head = NULL;
+	Journal_Free();
+	MapIndex_Free();
+#ifdef MAP_SAVE_THREADED
+	if (save_segmentsWaitable) Waitable_Free(save_segmentsWaitable);
+	save_segmentsWaitable = NULL;
+#endif
+}
+
+static void OnNewMap(void) {
+	/* Don't autosave a different map over the previous one */
+	save_lastPath.length = 0;
+	Journal_Free();
+}
+#else
 /* No point including map format code when can't save/load maps anyways */
 struct MapImporter* MapImporter_Find(const cc_string* path) { return NULL; }
 cc_result Map_LoadFrom(const cc_string* path) { return ERR_NOT_SUPPORTED; }
@@ -1887,11 +3624,23 @@ cc_result Cw_Save(struct Stream* stream)  { return ERR_NOT_SUPPORTED; }
 cc_result Dat_Save(struct Stream* stream) { return ERR_NOT_SUPPORTED; }
 cc_result Schematic_Save(struct Stream* stream) { return ERR_NOT_SUPPORTED; }
 
-static void OnInit(void) { }
-static void OnFree(void) { }
+MapExportFunc Map_FindExporter(const cc_string* path) { return Cw_Save; }
+cc_result Map_SaveAsync(const cc_string* path) { return ERR_NOT_SUPPORTED; }
+cc_bool Map_IsSaving(void) { return false; }
+
+void MapIndex_Start(struct StringsBuffer* files) { }
+void MapIndex_Stop(void) { }
+cc_bool MapIndex_Get(const cc_string* file, struct MapInfo* info) { return false; }
+int MapIndex_Version(void) { return 0; }
+
+static void OnInit(void)   { }
+static void OnFree(void)   { }
+static void OnNewMap(void) { }
 #endif
 
 struct IGameComponent Formats_Component = {
-	OnInit, /* Init  */
-	OnFree  /* Free  */
+	OnInit,   /* Init  */
+	OnFree,   /* Free  */
+	NULL,     /* Reset */
+	OnNewMap  /* OnNewMap */
 };
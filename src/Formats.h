@@ -8,6 +8,7 @@ CC_BEGIN_HEADER
 */
 
 struct Stream; 
+struct StringsBuffer;
 struct IGameComponent;
 extern struct IGameComponent Formats_Component;
 
@@ -39,5 +40,40 @@ cc_result Schematic_Save(struct Stream* stream);
 /* Used by MineCraft Classic */
 cc_result Dat_Save(struct Stream* stream);
 
+/* Exports a world encoded in a particular map file format */
+typedef cc_result (*MapExportFunc)(struct Stream* stream);
+/* Returns the exporter for the map format based on filename (.cw if unknown) */
+MapExportFunc Map_FindExporter(const cc_string* path);
+/* Saves the world to the given file. The world is first copied into an uncompressed snapshot, */
+/*  which is then compressed and written to disc on a background thread (if supported) */
+/* NOTE: Save progress and completion are reported in chat */
+cc_result Map_SaveAsync(const cc_string* path);
+/* Whether a background save is currently in progress */
+cc_bool Map_IsSaving(void);
+
+#define MAPINFO_THUMB_SIZE 32
+/* Summary of a map file, read from just its header and blocks without loading the map */
+struct MapInfo {
+	int width, height, length;
+	int spawnX, spawnY, spawnZ;
+	cc_bool hasSpawn;
+	/* Size of the thumbnail, which preserves the aspect ratio of the map (0 if no thumbnail) */
+	cc_uint8 thumbWidth, thumbLength;
+	/* Highest non-air block in evenly spaced columns of the map, and its height (scaled to 0-255) */
+	/* (indexed by z * MAPINFO_THUMB_SIZE + x) */
+	BlockRaw thumbBlocks[MAPINFO_THUMB_SIZE * MAPINFO_THUMB_SIZE];
+	cc_uint8 thumbHeights[MAPINFO_THUMB_SIZE * MAPINFO_THUMB_SIZE];
+};
+
+/* Starts indexing the given map files (relative to maps folder) on a background thread */
+/* Maps already in the index file are only read again if they have changed since */
+void MapIndex_Start(struct StringsBuffer* files);
+/* Stops the background indexing, if it is running */
+void MapIndex_Stop(void);
+/* Retrieves the summary of the given map file (relative to maps folder), if it has been indexed */
+cc_bool MapIndex_Get(const cc_string* file, struct MapInfo* info);
+/* Incremented whenever a map file has been indexed */
+int MapIndex_Version(void);
+
 CC_END_HEADER
 #endif
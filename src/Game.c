@@ -38,9 +38,12 @@
 #include "Protocol.h"
 #include "Picking.h"
 #include "Animations.h"
+#include "Jobs.h"
 #include "SystemFonts.h"
 #include "Formats.h"
 #include "EntityRenderers.h"
+#include "IsometricDrawer.h"
+#include "BlockPhysics.h"
 
 struct _GameData Game;
 static cc_uint64 frameStart;
@@ -50,11 +53,15 @@ struct RayTracer Game_SelectedPos;
 int Game_ViewDistance     = DEFAULT_VIEWDIST;
 int Game_UserViewDistance = DEFAULT_VIEWDIST;
 int Game_MaxViewDistance  = DEFAULT_MAX_VIEWDIST;
+cc_uint32 Game_VRAMUsage[VRAM_USAGE_COUNT];
+cc_uint32 Game_VRAMBudget;
 
 int     Game_FpsLimit, Game_Vertices;
 cc_bool Game_SimpleArmsAnim;
 static cc_bool gameRunning;
 static float gfx_minFrameMs;
+/* Whether to reduce input latency, at the cost of slightly less consistent frame times */
+static cc_bool Game_LowLatency;
 
 cc_bool Game_ClassicMode, Game_ClassicHacks;
 cc_bool Game_AllowCustomBlocks;
@@ -103,6 +110,125 @@ int ScheduledTask_Add(double interval, ScheduledTaskCallback callback) {
 	return tasksCount - 1;
 }
 
+const char* const Profiler_Names[PROFILE_COUNT] = {
+	"Frame", "Map update", "Map normal", "Map translucent",
+	"Entities", "Particles", "Environment",
+	"Entities tick", "Server tick", "GUI"
+};
+static cc_uint64 profiler_beg[PROFILE_COUNT];
+static cc_uint32 profiler_cur[PROFILE_COUNT];
+/* Microseconds spent in each subsystem over the last PROFILER_HISTORY frames */
+static cc_uint32 profiler_history[PROFILER_HISTORY][PROFILE_COUNT];
+/* Microseconds between the end of each of the last PROFILER_HISTORY frames */
+static cc_uint32 profiler_intervals[PROFILER_HISTORY];
+static cc_uint64 profiler_lastFrame;
+static int profiler_head, profiler_frames;
+
+void Profiler_Begin(int section) {
+	profiler_beg[section] = Stopwatch_Measure();
+}
+
+void Profiler_End(int section) {
+	cc_uint64 end = Stopwatch_Measure();
+	profiler_cur[section] += (cc_uint32)Stopwatch_ElapsedMicroseconds(profiler_beg[section], end);
+}
+
+static void Profiler_EndFrame(void) {
+	cc_uint64 now = Stopwatch_Measure();
+	cc_uint64 elapsed = profiler_lastFrame ? Stopwatch_ElapsedMicroseconds(profiler_lastFrame, now) : 0;
+	profiler_lastFrame = now;
+
+	Mem_Copy(profiler_history[profiler_head], profiler_cur, sizeof(profiler_cur));
+	Mem_Set(profiler_cur, 0, sizeof(profiler_cur));
+	profiler_intervals[profiler_head] = (cc_uint32)min(elapsed, 5000000);
+
+	profiler_head = (profiler_head + 1) % PROFILER_HISTORY;
+	if (profiler_frames < PROFILER_HISTORY) profiler_frames++;
+}
+
+void Profiler_CalcStats(int section, struct ProfilerStats* stats) {
+	cc_uint32 value, lo, hi;
+	cc_uint64 total;
+	int i;
+
+	if (!profiler_frames) { stats->min = 0; stats->avg = 0; stats->max = 0; return; }
+	lo = profiler_history[0][section];
+	hi = lo; total = 0;
+
+	for (i = 0; i < profiler_frames; i++) 
+	{
+		value  = profiler_history[i][section];
+		total += value;
+		lo     = min(lo, value);
+		hi     = max(hi, value);
+	}
+
+	stats->min = lo / 1000.0f;
+	stats->max = hi / 1000.0f;
+	stats->avg = (float)(total / 1000.0 / profiler_frames);
+}
+
+/* Sorts the given values, then returns the value at the given percentile */
+static cc_uint32 Profiler_Percentile(cc_uint32* values, int count, int percent) {
+	cc_uint32 value;
+	int i, j;
+
+	/* Insertion sort is fine for PROFILER_HISTORY entries */
+	for (i = 1; i < count; i++) 
+	{
+		value = values[i];
+		for (j = i; j > 0 && values[j - 1] > value; j--) values[j] = values[j - 1];
+		values[j] = value;
+	}
+	return values[(count - 1) * percent / 100];
+}
+
+static cc_uint32 Profiler_IntervalPercentile(int percent) {
+	cc_uint32 values[PROFILER_HISTORY];
+	Mem_Copy(values, profiler_intervals, sizeof(values));
+	return Profiler_Percentile(values, profiler_frames, percent);
+}
+
+void Profiler_CalcFrameTimes(struct FrameTimeStats* stats) {
+	if (!profiler_frames) { stats->p50 = 0; stats->p99 = 0; return; }
+
+	stats->p50 = Profiler_IntervalPercentile(50) / 1000.0f;
+	stats->p99 = Profiler_IntervalPercentile(99) / 1000.0f;
+}
+
+cc_result Profiler_WriteCSV(struct Stream* s) {
+	cc_string line; char lineBuffer[STRING_SIZE * 4];
+	int i, j, frame, count = profiler_frames;
+	float value;
+	cc_result res;
+
+	String_InitArray(line, lineBuffer);
+	String_AppendConst(&line, "Frame index");
+	for (j = 0; j < PROFILE_COUNT; j++) 
+	{
+		String_Format1(&line, ",%c (ms)", Profiler_Names[j]);
+	}
+	String_AppendConst(&line, "\r\n");
+	if ((res = Stream_Write(s, (cc_uint8*)line.buffer, line.length))) return res;
+
+	/* Oldest frame first */
+	for (i = 0; i < count; i++) 
+	{
+		frame = (profiler_head - count + i + PROFILER_HISTORY) % PROFILER_HISTORY;
+		line.length = 0;
+		String_AppendInt(&line, i);
+
+		for (j = 0; j < PROFILE_COUNT; j++) 
+		{
+			value = profiler_history[frame][j] / 1000.0f;
+			String_Format1(&line, ",%f3", &value);
+		}
+		String_AppendConst(&line, "\r\n");
+		if ((res = Stream_Write(s, (cc_uint8*)line.buffer, line.length))) return res;
+	}
+	return 0;
+}
+
 
 void Game_ToggleFullscreen(void) {
 	int state = Window_GetWindowState();
@@ -165,6 +291,20 @@ cc_bool Game_ReduceVRAM(void) {
 	return true;
 }
 
+cc_uint32 Game_VRAMUsed(void) {
+	cc_uint32 total = 0;
+	int i;
+
+	for (i = 0; i < VRAM_USAGE_COUNT; i++) total += Game_VRAMUsage[i];
+	return total;
+}
+
+cc_bool Game_VRAMOverBudget(int percent) {
+	if (!Game_VRAMBudget) return false;
+	/* Compare in KB to avoid overflowing when multiplying by percent */
+	return (Game_VRAMUsed() >> 10) * 100 > (Game_VRAMBudget >> 10) * percent;
+}
+
 
 void Game_SetViewDistance(int distance) {
 	distance = min(distance, Game_MaxViewDistance);
@@ -196,13 +336,67 @@ void Game_Reset(void) {
 	}
 }
 
+#define BLOCK_CHANGES_BATCH 256
+static struct BlockChange blockChanges[BLOCK_CHANGES_BATCH];
+static int blockChangesCount, blockChangesDepth;
+static cc_bool blockChangesRaising;
+
+static void FlushBlockChanges(void) {
+	int count = blockChangesCount;
+	if (!count) return;
+
+	/* Blocks changed by handlers are raised as separate batches */
+	blockChangesCount   = 0;
+	blockChangesRaising = true;
+	Event_RaiseBlocks(&WorldEvents.BlocksChanged, blockChanges, count);
+	blockChangesRaising = false;
+}
+
+static void QueueBlockChange(int x, int y, int z, BlockID old, BlockID now) {
+	struct BlockChange* change;
+	if (!WorldEvents.BlocksChanged.Count || old == now) return;
+	if (blockChangesRaising) {
+		struct BlockChange single;
+		single.coords.x = x; single.coords.y = y; single.coords.z = z;
+		single.oldBlock = old; single.block = now;
+		Event_RaiseBlocks(&WorldEvents.BlocksChanged, &single, 1);
+		return;
+	}
+
+	change = &blockChanges[blockChangesCount++];
+	change->coords.x = x; change->coords.y = y; change->coords.z = z;
+	change->oldBlock = old; change->block = now;
+
+	if (!blockChangesDepth || blockChangesCount == BLOCK_CHANGES_BATCH) FlushBlockChanges();
+}
+
+void Game_BeginBlockChanges(void) { blockChangesDepth++; }
+
+void Game_EndBlockChanges(void) {
+	if (!blockChangesDepth) return;
+	if (--blockChangesDepth) return;
+	FlushBlockChanges();
+}
+
+static void BlockChanges_NewMap(void* obj) {
+	/* Pending changes refer to the previous map */
+	blockChangesCount = 0;
+}
+
 void Game_UpdateBlock(int x, int y, int z, BlockID block) {
 	BlockID old = World_GetBlock(x, y, z);
 	World_SetBlock(x, y, z, block);
+	QueueBlockChange(x, y, z, old, block);
+	Physics_OnBlockUpdated(x, y, z, old, block);
+	EntityShadows_OnBlockChanged();
 
 	if (Weather_Heightmap) {
 		EnvRenderer_OnBlockChanged(x, y, z, old, block);
 	}
+
+	/* Avoid rebuilding chunks when the change can't be seen anyways */
+	/* (e.g. during mass edits of blocks that are underground) */
+	if (MapRenderer_IsHiddenChange(x, y, z, old, block)) return;
 	Lighting.OnBlockChanged(x, y, z, old, block);
 	MapRenderer_OnBlockChanged(x, y, z, block);
 }
@@ -213,6 +407,58 @@ void Game_ChangeBlock(int x, int y, int z, BlockID block) {
 	Server.SendBlock(x, y, z, old, block);
 }
 
+static void ChangeBlocks(int x1, int y1, int z1, int x2, int y2, int z2, Game_ChangeBlocksFunc getBlock, cc_bool notify) {
+	/* Bounds of all changed blocks, and of the changed blocks which affect chunk meshes */
+	IVec3 min = { Int32_MaxValue, Int32_MaxValue, Int32_MaxValue }, max = { -1, -1, -1 };
+	IVec3 visMin = min, visMax = max;
+	BlockID old, now;
+	int x, y, z;
+
+	Game_BeginBlockChanges();
+	Lighting_BeginBatch();
+	for (y = y1; y <= y2; y++) {
+		for (z = z1; z <= z2; z++) {
+			for (x = x1; x <= x2; x++) {
+				old = World_GetBlock(x, y, z);
+				now = getBlock(x, y, z, old);
+				if (old == now) continue;
+
+				World_SetBlock(x, y, z, now);
+				QueueBlockChange(x, y, z, old, now);
+				Physics_OnBlockUpdated(x, y, z, old, now);
+				min.x = min(min.x, x); min.y = min(min.y, y); min.z = min(min.z, z);
+				max.x = max(max.x, x); max.y = max(max.y, y); max.z = max(max.z, z);
+
+				if (!MapRenderer_IsHiddenChange(x, y, z, old, now)) {
+					/* Lighting changes are deferred until the batch ends */
+					Lighting.OnBlockChanged(x, y, z, old, now);
+					visMin.x = min(visMin.x, x); visMin.y = min(visMin.y, y); visMin.z = min(visMin.z, z);
+					visMax.x = max(visMax.x, x); visMax.y = max(visMax.y, y); visMax.z = max(visMax.z, z);
+				}
+				if (notify) Server.SendBlock(x, y, z, old, now);
+			}
+		}
+	}
+	Lighting_EndBatch();
+	Game_EndBlockChanges();
+	if (max.x == -1) return;
+
+	EntityShadows_OnBlockChanged();
+	if (Weather_Heightmap) {
+		EnvRenderer_OnBlocksChanged(min.x, min.z, max.x, max.z);
+	}
+	if (visMax.x == -1) return;
+	MapRenderer_OnBlocksChanged(visMin.x, visMin.y, visMin.z, visMax.x, visMax.y, visMax.z);
+}
+
+void Game_ChangeBlocks(int x1, int y1, int z1, int x2, int y2, int z2, Game_ChangeBlocksFunc getBlock) {
+	ChangeBlocks(x1, y1, z1, x2, y2, z2, getBlock, true);
+}
+
+void Game_UpdateBlocks(int x1, int y1, int z1, int x2, int y2, int z2, Game_ChangeBlocksFunc getBlock) {
+	ChangeBlocks(x1, y1, z1, x2, y2, z2, getBlock, false);
+}
+
 cc_bool Game_CanPick(BlockID block) {
 	if (Blocks.Draw[block] == DRAW_GAS)    return false;
 	if (Blocks.Draw[block] == DRAW_SPRITE) return true;
@@ -225,7 +471,7 @@ cc_bool Game_UpdateTexture(GfxResourceID* texId, struct Stream* src, const cc_st
 	cc_bool success;
 	cc_result res;
 	
-	res = Png_Decode(&bmp, src);
+	res = TexturePack_DecodePng(&bmp, src);
 	if (res) { Logger_SysWarn2(res, "decoding", file); }
 	
 	/* E.g. gui.png only need top half of the texture loaded */
@@ -352,8 +598,10 @@ static void LoadOptions(void) {
 	Game_BreakableLiquids    = !Game_ClassicMode && Options_GetBool(OPT_MODIFIABLE_LIQUIDS, false);
 	Game_AllowServerTextures = !Game_ClassicMode && Options_GetBool(OPT_SERVER_TEXTURES,    true);
 
+	Game_LowLatency       = Options_GetBool(OPT_LOW_LATENCY, false);
 	Game_ViewDistance     = Options_GetInt(OPT_VIEW_DISTANCE, 8, 4096, DEFAULT_VIEWDIST);
 	Game_UserViewDistance = Game_ViewDistance;
+	Game_VRAMBudget       = (cc_uint32)Options_GetInt(OPT_VRAM_BUDGET, 0, 4095, 0) << 20;
 	/* TODO: Do we need to support option to skip SSL */
 	/*cc_bool skipSsl = Options_GetBool("skip-ssl-check", false);
 	if (skipSsl) {
@@ -409,6 +657,13 @@ static void LoadPlugins(void) { }
 #endif
 
 static void Game_PendingClose(void* obj) { gameRunning = false; }
+static void Game_TickEntities(struct ScheduledTask* task) {
+	Profiler_Begin(PROFILE_ENTITIES_TICK);
+	Entities_Tick(task);
+	Profiler_End(PROFILE_ENTITIES_TICK);
+}
+
+static void DynRes_Init(void);
 static void Game_Load(void) {
 	struct IGameComponent* comp;
 	Game_UpdateDimensions();
@@ -417,10 +672,12 @@ static void Game_Load(void) {
 	
 	Logger_WarnFunc = Game_WarnFunc;
 	LoadOptions();
+	DynRes_Init();
 	GameVersion_Load();
 	Utils_EnsureDirectory("maps");
 
 	Event_Register_(&WorldEvents.NewMap,           NULL, HandleOnNewMap);
+	Event_Register_(&WorldEvents.NewMap,           NULL, BlockChanges_NewMap);
 	Event_Register_(&WorldEvents.MapLoaded,        NULL, HandleOnNewMapLoaded);
 	Event_Register_(&WindowEvents.Resized,         NULL, Game_OnResize);
 	Event_Register_(&WindowEvents.Closing,         NULL, Game_PendingClose);
@@ -443,6 +700,7 @@ static void Game_Load(void) {
 	Game_AddComponent(&Models_Component);
 	Game_AddComponent(&Entities_Component);
 	Game_AddComponent(&Http_Component);
+	Game_AddComponent(&Jobs_Component);
 	Game_AddComponent(&Lighting_Component);
 
 	Game_AddComponent(&Animations_Component);
@@ -462,21 +720,26 @@ static void Game_Load(void) {
 	Game_AddComponent(&AxisLinesRenderer_Component);
 	Game_AddComponent(&Formats_Component);
 	Game_AddComponent(&EntityRenderers_Component);
+	Game_AddComponent(&IsometricDrawer_Component);
 
 	LoadPlugins();
 	for (comp = comps_head; comp; comp = comp->next) {
 		if (comp->Init) comp->Init();
 	}
 
+	/* In multiplayer, start connecting first so that the connection */
+	/*  can be established while the texture pack is being extracted */
+	if (!Server.IsSinglePlayer) Server.BeginConnect();
+
 	TexturePack_ExtractCurrent(true);
 	if (TexturePack_DefaultMissing) {
 		Window_ShowDialog("Missing file",
 			"Both default.zip and classicube.zip are missing,\n try downloading resources first.\n\nClassiCube will still run, but without any textures.");
 	}
 
-	entTaskI = ScheduledTask_Add(GAME_DEF_TICKS, Entities_Tick);
+	entTaskI = ScheduledTask_Add(GAME_DEF_TICKS, Game_TickEntities);
 	if (Gfx_WarnIfNecessary()) EnvRenderer_SetMode(EnvRenderer_Minimal | ENV_LEGACY);
-	Server.BeginConnect();
+	if (Server.IsSinglePlayer) Server.BeginConnect();
 }
 
 void Game_SetFpsLimit(int method) {
@@ -505,6 +768,22 @@ void Game_SetMinFrameTime(float frameTimeMS) {
 }
 #endif
 
+static void Game_RenderTranslucent(float delta) {
+	Profiler_Begin(PROFILE_MAP_TRANSLUCENT);
+	MapRenderer_RenderTranslucent(delta);
+	Profiler_End(PROFILE_MAP_TRANSLUCENT);
+}
+
+static void Game_RenderMapEdges(void) {
+	Profiler_Begin(PROFILE_ENVIRONMENT);
+	EnvRenderer_RenderMapEdges();
+	Profiler_End(PROFILE_ENVIRONMENT);
+}
+
+/* Whether the frame is being rendered for the second eye in stereo 3D mode */
+/* NOTE: CPU work that doesn't depend on the eye (e.g. chunk visibility) is skipped then */
+static cc_bool stereoSecondEye;
+
 static void Render3DFrame(float delta, float t) {
 	struct Matrix mvp;
 	Vec3 pos;
@@ -516,18 +795,40 @@ static void Render3DFrame(float delta, float t) {
 	Gfx_LoadMVP(&Gfx.View, &Gfx.Projection, &mvp);
 	FrustumCulling_CalcFrustumEquations(&mvp);
 
+	Profiler_Begin(PROFILE_ENVIRONMENT);
 	if (EnvRenderer_ShouldRenderSkybox()) EnvRenderer_RenderSkybox();
+	Profiler_End(PROFILE_ENVIRONMENT);
 	AxisLinesRenderer_Render();
+
+	Profiler_Begin(PROFILE_ENTITIES);
 	Entities_RenderModels(delta, t);
 	EntityNames_Render();
+	Profiler_End(PROFILE_ENTITIES);
 
+	Profiler_Begin(PROFILE_PARTICLES);
 	Particles_Render(t);
+	Profiler_End(PROFILE_PARTICLES);
+
+	Profiler_Begin(PROFILE_ENVIRONMENT);
 	EnvRenderer_RenderSky();
 	EnvRenderer_RenderClouds();
+	Profiler_End(PROFILE_ENVIRONMENT);
+
+	/* The eyes are only slightly offset, so the chunks visible to the first eye are */
+	/*  reused for the second eye (this also avoids building chunks twice per frame) */
+	if (!stereoSecondEye) {
+		Profiler_Begin(PROFILE_MAP_UPDATE);
+		MapRenderer_Update(delta);
+		Profiler_End(PROFILE_MAP_UPDATE);
+	}
 
-	MapRenderer_Update(delta);
+	Profiler_Begin(PROFILE_MAP_NORMAL);
 	MapRenderer_RenderNormal(delta);
+	Profiler_End(PROFILE_MAP_NORMAL);
+
+	Profiler_Begin(PROFILE_ENVIRONMENT);
 	EnvRenderer_RenderMapSides();
+	Profiler_End(PROFILE_ENVIRONMENT);
 
 	EntityShadows_Render();
 	if (Game_SelectedPos.valid && !Game_HideGui) {
@@ -537,11 +838,11 @@ static void Render3DFrame(float delta, float t) {
 	/* Render water over translucent blocks when under the water outside the map for proper alpha blending */
 	pos = Camera.CurrentPos;
 	if (pos.y < Env.EdgeHeight && (pos.x < 0 || pos.z < 0 || pos.x > World.Width || pos.z > World.Length)) {
-		MapRenderer_RenderTranslucent(delta);
-		EnvRenderer_RenderMapEdges();
+		Game_RenderTranslucent(delta);
+		Game_RenderMapEdges();
 	} else {
-		EnvRenderer_RenderMapEdges();
-		MapRenderer_RenderTranslucent(delta);
+		Game_RenderMapEdges();
+		Game_RenderTranslucent(delta);
 	}
 
 	/* Need to render again over top of translucent block, as the selection outline */
@@ -563,26 +864,168 @@ static void Render3D_Anaglyph(float delta, float t) {
 	Render3DFrame(delta, t);
 
 	Gfx_Set3DRight(&proj, &view);
+	stereoSecondEye = true;
 	Render3DFrame(delta, t);
+	stereoSecondEye = false;
 
 	Gfx_End3D(&proj, &view);
 }
 
+#ifdef CC_BUILD_GFX_COPYSCENE
+/* The 3D scene is rendered into the bottom left of the backbuffer at a reduced scale, */
+/*  then copied into a texture which is stretched over the whole window before the GUI */
+#define DYNRES_MIN_SCALE 0.5f
+#define DYNRES_STEP      0.05f
+static cc_bool dynRes_enabled;
+static float dynRes_scale = 1.0f, dynRes_target, dynRes_frameTime, dynRes_elapsed;
+static struct Texture dynRes_tex;
+static int dynRes_texWidth, dynRes_texHeight;
+
+static void DynRes_FreeTexture(void* obj) {
+	Gfx_DeleteTexture(&dynRes_tex.ID);
+	dynRes_texWidth  = 0;
+	dynRes_texHeight = 0;
+}
+
+static cc_bool DynRes_CreateTexture(void) {
+	int width  = Math_NextPowOf2(Game.Width);
+	int height = Math_NextPowOf2(Game.Height);
+	struct Bitmap bmp;
+	if (dynRes_tex.ID && width <= dynRes_texWidth && height <= dynRes_texHeight) return true;
+
+	DynRes_FreeTexture(NULL);
+	if (!Gfx_CheckTextureSize(width, height, 0)) return false;
+	Bitmap_TryAllocate(&bmp, width, height);
+	if (!bmp.scan0) return false;
+
+	dynRes_tex.ID = Gfx_CreateTexture(&bmp, TEXTURE_FLAG_BILINEAR, false);
+	Mem_Free(bmp.scan0);
+	if (!dynRes_tex.ID) return false;
+
+	dynRes_texWidth  = width;
+	dynRes_texHeight = height;
+	return true;
+}
+
+static void DynRes_UpdateScale(float delta) {
+	/* Smooth out frame time spikes, so the scale doesn't constantly fluctuate */
+	dynRes_frameTime = dynRes_frameTime * 0.9f + delta * 0.1f;
+	dynRes_elapsed  += delta;
+	if (dynRes_elapsed < 0.5f) return;
+	dynRes_elapsed = 0.0f;
+
+	if (dynRes_frameTime > dynRes_target * 1.1f) {
+		dynRes_scale = max(dynRes_scale - DYNRES_STEP, DYNRES_MIN_SCALE);
+	} else if (dynRes_frameTime < dynRes_target * 0.85f) {
+		dynRes_scale = min(dynRes_scale + DYNRES_STEP, 1.0f);
+	}
+}
+
+static void Render3D_Scaled(float delta, float t) {
+	int width, height;
+	DynRes_UpdateScale(delta);
+	width  = max(1, (int)(Game.Width  * dynRes_scale));
+	height = max(1, (int)(Game.Height * dynRes_scale));
+
+	if (width >= Game.Width || !DynRes_CreateTexture()) {
+		Render3DFrame(delta, t); return;
+	}
+
+	Gfx_SetViewport(0, 0, width, height);
+	Render3DFrame(delta, t);
+	Gfx_SetViewport(0, 0, Game.Width, Game.Height);
+	Gfx_CopyBackbuffer(dynRes_tex.ID, width, height);
+
+	/* Backbuffer rows are copied in bottom-up order, so the texture is drawn flipped */
+	Tex_SetRect(dynRes_tex, 0, 0, Game.Width, Game.Height);
+	Tex_SetUV(dynRes_tex, 0, (float)height / dynRes_texHeight, (float)width / dynRes_texWidth, 0);
+
+	Gfx_Begin2D(Game.Width, Game.Height);
+	Gfx_SetAlphaBlending(false);
+	Texture_Render(&dynRes_tex);
+	Gfx_End2D();
+}
+
+static void DynRes_Init(void) {
+	int fps = Options_GetInt(OPT_DYNAMIC_RES_FPS, 10, 1000, 60);
+	dynRes_enabled   = Options_GetBool(OPT_DYNAMIC_RES, false);
+	dynRes_target    = 1.0f / fps;
+	dynRes_frameTime = dynRes_target;
+	Event_Register_(&GfxEvents.ContextLost, NULL, DynRes_FreeTexture);
+}
+#else
+static cc_bool dynRes_enabled;
+static void Render3D_Scaled(float delta, float t) { Render3DFrame(delta, t); }
+static void DynRes_Init(void) { }
+#endif
+
+/* Maximum number of times a scheduled task is run to catch up in a single frame */
+#define TASK_MAX_CATCHUP_RUNS 3
+
 static void PerformScheduledTasks(double time) {
 	struct ScheduledTask* task;
-	int i;
+	int i, runs;
 
 	for (i = 0; i < tasksCount; i++) {
 		task = &tasks[i];
 		task->accumulator += time;
 
-		while (task->accumulator >= task->interval) {
+		for (runs = 0; task->accumulator >= task->interval; runs++) {
+			/* After a long frame hitch, running every missed tick back to back would just make */
+			/*  the next frame take even longer. So drop the missed time instead, but keep */
+			/*  the remaining fraction of a tick so that render interpolation stays smooth */
+			if (runs == TASK_MAX_CATCHUP_RUNS) {
+				task->accumulator -= (int)(task->accumulator / task->interval) * task->interval;
+				break;
+			}
+
 			task->Callback(task);
 			task->accumulator -= task->interval;
 		}
 	}
 }
 
+#ifndef CC_BUILD_WEB
+static void Game_OnScreenshotSaved(const cc_string* path, cc_result res, void* obj) {
+	cc_string filename = *path;
+	struct Bitmap* bmp = (struct Bitmap*)obj;
+
+	if (bmp) { Mem_Free(bmp->scan0); Mem_Free(bmp); }
+	if (res) { Logger_SysWarn2(res, "saving to", path); return; }
+
+	Utils_UNSAFE_GetFilename(&filename);
+	Chat_Add1("&eTaken screenshot as: %s", &filename);
+#ifdef CC_BUILD_MOBILE
+	Platform_ShareScreenshot(&filename);
+#endif
+}
+#endif
+
+#if defined CC_BUILD_GFX_READSCREENSHOT && !defined CC_BUILD_WEB
+static BitmapCol* Game_GetScreenshotRow(struct Bitmap* bmp, int y, void* ctx) {
+	/* Backbuffer is read back in bottom-up order, so flip order when saving */
+	return Bitmap_GetRow(bmp, (bmp->height - 1) - y);
+}
+
+/* Called on a background thread, so encoding a large screenshot doesn't stall the game */
+static cc_result Game_EncodeScreenshot(struct Stream* s, void* obj) {
+	return Png_EncodeFast((struct Bitmap*)obj, s, Game_GetScreenshotRow, false, NULL);
+}
+
+/* Only reads back the backbuffer on the main thread, leaving encoding and saving to a background thread */
+static cc_bool Game_ScreenshotAsync(const cc_string* path) {
+	struct Bitmap* bmp = (struct Bitmap*)Mem_TryAlloc(1, sizeof(struct Bitmap));
+	cc_result res;
+	if (!bmp) return false;
+
+	res = Gfx_ReadScreenshot(bmp);
+	if (res) { Mem_Free(bmp); return false; }
+
+	File_WriteAsync(path, Game_EncodeScreenshot, Game_OnScreenshotSaved, bmp);
+	return true;
+}
+#endif
+
 void Game_TakeScreenshot(void) {
 	cc_string filename; char fileBuffer[STRING_SIZE];
 	cc_string path;     char pathBuffer[FILENAME_SIZE];
@@ -592,6 +1035,7 @@ void Game_TakeScreenshot(void) {
 	cc_filepath str;
 #else
 	struct Stream stream;
+	cc_uint32 length;
 #endif
 	Game_ScreenshotRequested = false;
 	DateTime_CurrentLocal(&now);
@@ -609,21 +1053,20 @@ void Game_TakeScreenshot(void) {
 	String_InitArray(path, pathBuffer);
 	String_Format1(&path, "screenshots/%s", &filename);
 
-	res = Stream_CreateFile(&stream, &path);
-	if (res) { Logger_SysWarn2(res, "creating", &path); return; }
+#ifdef CC_BUILD_GFX_READSCREENSHOT
+	if (Game_ScreenshotAsync(&path)) return;
+#endif
 
+	/* Encode into memory, then write to disk in the background to avoid stalling the frame */
+	Stream_WriteonlyMemory(&stream);
 	res = Gfx_TakeScreenshot(&stream);
+	if (!res) res = stream.Position(&stream, &length);
+
 	if (res) {
-		Logger_SysWarn2(res, "saving to", &path); stream.Close(&stream); return;
+		Logger_SysWarn2(res, "saving to", &path); 
+		Mem_Free(stream.meta.mem.base); return;
 	}
-
-	res = stream.Close(&stream);
-	if (res) { Logger_SysWarn2(res, "closing", &path); return; }
-	Chat_Add1("&eTaken screenshot as: %s", &filename);
-
-#ifdef CC_BUILD_MOBILE
-	Platform_ShareScreenshot(&filename);
-#endif
+	File_WriteAllAsync(&path, stream.meta.mem.base, length, Game_OnScreenshotSaved, NULL);
 #endif
 }
 
@@ -633,8 +1076,22 @@ static void LimitFPS(void) {
 	/* Can't use Thread_Sleep on the web. (spinwaits instead of sleeping) */
 	/* Instead the web browser manages the frame timing */
 }
+static void DelayForLatency(cc_uint64 workEnd) { }
 #else
 static float gfx_targetTime, gfx_actualTime;
+/* Sleeping can overshoot by up to this many microseconds, so the rest of the wait is spent spinning instead */
+#define FRAME_SPIN_MICROS 1000
+
+/* Waits until the given number of microseconds have elapsed since the given time */
+static void WaitUntil(cc_uint64 beg, cc_uint32 micros) {
+	cc_uint64 elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	if (elapsed >= micros) return;
+
+	if (micros - elapsed > FRAME_SPIN_MICROS) 
+		Thread_SleepPrecise((cc_uint32)(micros - elapsed) - FRAME_SPIN_MICROS);
+
+	while (Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure()) < micros) { }
+}
 
 static CC_INLINE float ElapsedMilliseconds(cc_uint64 beg, cc_uint64 end) {
 	cc_uint64 elapsed = Stopwatch_ElapsedMicroseconds(beg, end);
@@ -657,9 +1114,9 @@ static void LimitFPS(void) {
 	/* going faster than FPS limit - sleep to slow down */
 	if (gfx_actualTime < gfx_targetTime) {
 		float cooldown = gfx_targetTime - gfx_actualTime;
-		Thread_Sleep((int)(cooldown + 0.5f));
+		WaitUntil(frameEnd, (cc_uint32)(cooldown * 1000.0f));
 
-		/* also accumulate Thread_Sleep duration, as actual sleep */
+		/* also accumulate waiting duration, as actual sleep */
 		/*  duration can significantly deviate from requested time */
 		/*  (e.g. requested 4ms, but actually slept for 8ms) */
 		sleepEnd = Stopwatch_Measure();
@@ -669,6 +1126,31 @@ static void LimitFPS(void) {
 	/* reset accumulated time to avoid excessive FPS drift */
 	if (gfx_targetTime >= 1000) { gfx_actualTime = 0; gfx_targetTime = 0; }
 }
+
+#define LATENCY_HISTORY 60
+/* Microseconds spent on the CPU side (i.e. excluding presenting) of the last LATENCY_HISTORY frames */
+static cc_uint32 latency_work[LATENCY_HISTORY];
+static int latency_head, latency_frames;
+
+/* With VSync, the frame is usually finished well before the next vertical blank and then blocks */
+/*  when presenting - so input sampled at the start of the next frame is already stale by then. */
+/* Low latency mode instead waits after presenting, so processing input and rendering happen just */
+/*  in time for the next vertical blank. (using the worst recent CPU time, plus a safety margin) */
+static void DelayForLatency(cc_uint64 workEnd) {
+	cc_uint32 work, interval, values[LATENCY_HISTORY];
+	
+	latency_work[latency_head] = (cc_uint32)Stopwatch_ElapsedMicroseconds(frameStart, workEnd);
+	latency_head = (latency_head + 1) % LATENCY_HISTORY;
+	if (latency_frames < LATENCY_HISTORY) { latency_frames++; return; }
+
+	Mem_Copy(values, latency_work, sizeof(values));
+	work     = Profiler_Percentile(values, LATENCY_HISTORY, 99);
+	interval = Profiler_IntervalPercentile(50);
+	
+	/* Don't delay when the GPU can't keep up with the refresh rate anyway */
+	if (interval <= work + 2000 || interval > 100000) return;
+	WaitUntil(Stopwatch_Measure(), interval - work - 2000);
+}
 #endif
 
 static CC_INLINE void Game_DrawFrame(float delta, float t) {
@@ -681,6 +1163,8 @@ static CC_INLINE void Game_DrawFrame(float delta, float t) {
 
 		if (Game_Anaglyph3D) {
 			Render3D_Anaglyph(delta, t);
+		} else if (dynRes_enabled && Game_NumStates == 1) {
+			Render3D_Scaled(delta, t);
 		} else {
 			Render3DFrame(delta, t);
 		}
@@ -689,11 +1173,13 @@ static CC_INLINE void Game_DrawFrame(float delta, float t) {
 	}
 
 	Gfx_Begin2D(Game.Width, Game.Height);
+	Profiler_Begin(PROFILE_GUI);
 	Gui_RenderGui(delta);
 	for (i = 0; i < Array_Elems(Game.Draw2DHooks); i++)
 	{
 		if (Game.Draw2DHooks[i]) Game.Draw2DHooks[i](delta);
 	}
+	Profiler_End(PROFILE_GUI);
 
 /* TODO find a better solution than this */
 #ifdef CC_BUILD_3DS
@@ -728,8 +1214,25 @@ int Game_MapState(int deviceIndex) {
 }
 #endif
 
+static CC_INLINE void Game_UpdateMouse(float delta) {
+#ifdef CC_BUILD_SPLITSCREEN
+	/* TODO: find a better solution */
+	for (int i = 0; i < Game_NumStates; i++)
+	{
+		Game.CurrentState  = i;
+		Entities.CurPlayer = &LocalPlayer_Instances[i];
+		Camera.Active->UpdateMouse(Entities.CurPlayer, delta);
+	}
+	Game.CurrentState  = 0;
+	Entities.CurPlayer = &LocalPlayer_Instances[0];
+#else
+	Camera.Active->UpdateMouse(Entities.CurPlayer, delta);
+#endif
+}
+
 static CC_INLINE void Game_RenderFrame(void) {
 	struct ScheduledTask entTask;
+	cc_uint64 workEnd;
 	double deltaD;
 	float t, delta;
 
@@ -760,25 +1263,13 @@ static CC_INLINE void Game_RenderFrame(void) {
 		}
 	}
 
+	Profiler_Begin(PROFILE_FRAME);
 	Gfx_BeginFrame();
 	Gfx_BindIb(Gfx.DefaultIb);
 	Game.Time += deltaD;
 	Game_Vertices = 0;
 	Gamepad_Tick(delta);
-
-#ifdef CC_BUILD_SPLITSCREEN
-	/* TODO: find a better solution */
-	for (int i = 0; i < Game_NumStates; i++)
-	{
-		Game.CurrentState  = i;
-		Entities.CurPlayer = &LocalPlayer_Instances[i];
-		Camera.Active->UpdateMouse(Entities.CurPlayer, delta);
-	}
-	Game.CurrentState  = 0;
-	Entities.CurPlayer = &LocalPlayer_Instances[0];
-#else
-	Camera.Active->UpdateMouse(Entities.CurPlayer, delta);
-#endif
+	if (!Game_LowLatency) Game_UpdateMouse(delta);
 
 	if (!Window_Main.Focused && !Gui.InputGrab) Gui_ShowPauseMenu();
 
@@ -787,8 +1278,18 @@ static CC_INLINE void Game_RenderFrame(void) {
 	}
 
 	PerformScheduledTasks(deltaD);
+	File_ProcessAsync();
+	Jobs_ProcessCompleted();
+	Block_FlushPendingDefs();
 	entTask = tasks[entTaskI];
 	t = (float)(entTask.accumulator / entTask.interval);
+
+	/* Ticking can take a while, so pick up any mouse movement that happened meanwhile */
+	/*  right before the camera orientation for this frame is calculated */
+	if (Game_LowLatency) {
+		Window_ProcessEvents(0.0f);
+		Game_UpdateMouse(delta);
+	}
 	LocalPlayer_SetInterpPosition(Entities.CurPlayer, t);
 
 	Camera.CurrentPos = Camera.Active->GetPosition(t);
@@ -825,8 +1326,17 @@ static CC_INLINE void Game_RenderFrame(void) {
 #endif
 
 	if (Game_ScreenshotRequested) Game_TakeScreenshot();
+	workEnd = Stopwatch_Measure();
 	Gfx_EndFrame();
-	if (gfx_minFrameMs) LimitFPS();
+	Gfx_ResetStats();
+	Profiler_End(PROFILE_FRAME);
+	Profiler_EndFrame();
+
+	if (gfx_minFrameMs) {
+		LimitFPS();
+	} else if (Game_LowLatency && Game_FpsLimit == FPS_LIMIT_VSYNC) {
+		DelayForLatency(workEnd);
+	}
 }
 
 
@@ -845,6 +1355,8 @@ static void Game_Free(void) {
 
 	gameRunning     = false;
 	Logger_WarnFunc = Logger_DialogWarn;
+	/* Make sure screenshots/cache files queued for writing actually make it to disk */
+	File_FlushAsync();
 	Gfx_Free();
 	Options_SaveIfChanged();
 	Window_DisableRawMouse();
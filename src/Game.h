@@ -10,6 +10,9 @@ CC_BEGIN_HEADER
 struct Bitmap;
 struct Stream;
 typedef void (*Game_Draw2DHook)(float delta);
+/* Returns the block that the block at the given coordinates should be changed to */
+/* NOTE: Returning the current block leaves it unchanged */
+typedef BlockID (*Game_ChangeBlocksFunc)(int x, int y, int z, BlockID cur);
 
 CC_VAR extern struct _GameData {
 	/* Width and height of the window. (1 at minimum) */
@@ -94,6 +97,18 @@ void Game_CycleViewDistance(void);
 /* Returns false if VRAM cannot be reduced any further */
 cc_bool Game_ReduceVRAM(void);
 
+/* Kinds of resources whose video memory usage counts towards Game_VRAMBudget */
+enum VRAMUsage_ { VRAM_CHUNKS, VRAM_SKINS, VRAM_NAMES, VRAM_ATLASES, VRAM_USAGE_COUNT };
+/* Estimated bytes of video memory currently used by each kind of resource */
+extern cc_uint32 Game_VRAMUsage[VRAM_USAGE_COUNT];
+/* Max bytes of video memory that the above resources should use, 0 for no limit */
+/* When exceeded, the furthest chunks and least recently drawn skins are freed */
+extern cc_uint32 Game_VRAMBudget;
+/* Returns estimated bytes of video memory used by all the above resources */
+cc_uint32 Game_VRAMUsed(void);
+/* Returns whether the video memory used is over the given percentage of the budget */
+cc_bool Game_VRAMOverBudget(int percent);
+
 void Game_SetViewDistance(int distance);
 void Game_UserSetViewDistance(int distance);
 void Game_Disconnect(const cc_string* title, const cc_string* reason);
@@ -106,6 +121,21 @@ CC_API void Game_UpdateBlock(int x, int y, int z, BlockID block);
 /* Calls Game_UpdateBlock, then informs server connection of the block change. */
 /* In multiplayer this is sent to the server, in singleplayer just activates physics. */
 CC_API void Game_ChangeBlock(int x, int y, int z, BlockID block);
+/* Same as calling Game_ChangeBlock for every block in the region [x1, y1, z1] to [x2, y2, z2], */
+/*  with the new block for each coordinate provided by getBlock */
+/* However, state associated with the blocks is only updated once per affected chunk/column */
+/*  (e.g. lighting, weather heightmap, chunk meshes), instead of separately for every block */
+/* NOTE: Region must be entirely inside the map */
+CC_API void Game_ChangeBlocks(int x1, int y1, int z1, int x2, int y2, int z2, Game_ChangeBlocksFunc getBlock);
+/* Same as Game_ChangeBlocks, but does NOT notify the server of the block changes */
+/* (e.g. for applying region edits that were sent by the server) */
+CC_API void Game_UpdateBlocks(int x1, int y1, int z1, int x2, int y2, int z2, Game_ChangeBlocksFunc getBlock);
+/* Begins deferring WorldEvents.BlocksChanged, so that block changes are raised in batches */
+/*  (e.g. once per network tick) rather than separately for every block */
+/* NOTE: Calls can be nested, changes are only raised once the outermost batch ends */
+CC_API void Game_BeginBlockChanges(void);
+/* Raises WorldEvents.BlocksChanged for any block changes that occurred since Game_BeginBlockChanges */
+CC_API void Game_EndBlockChanges(void);
 
 cc_bool Game_CanPick(BlockID block);
 /* Updates Game_Width and Game_Height. */
@@ -163,5 +193,30 @@ typedef void (*ScheduledTaskCallback)(struct ScheduledTask* task);
 /* Adds a task to list of scheduled tasks. (always at end) */
 CC_API int ScheduledTask_Add(double interval, ScheduledTaskCallback callback);
 
+/* Subsystems whose time spent each frame is measured by the frame profiler */
+enum ProfilerSection_ {
+	PROFILE_FRAME, PROFILE_MAP_UPDATE, PROFILE_MAP_NORMAL, PROFILE_MAP_TRANSLUCENT,
+	PROFILE_ENTITIES, PROFILE_PARTICLES, PROFILE_ENVIRONMENT, 
+	PROFILE_ENTITIES_TICK, PROFILE_SERVER_TICK, PROFILE_GUI,
+	PROFILE_COUNT
+};
+/* Number of frames that rolling profiler statistics are calculated over */
+#define PROFILER_HISTORY 120
+struct ProfilerStats { float min, avg, max; };
+struct FrameTimeStats { float p50, p99; };
+extern const char* const Profiler_Names[PROFILE_COUNT];
+
+/* Starts measuring time spent in the given subsystem */
+CC_API void Profiler_Begin(int section);
+/* Stops measuring time spent in the given subsystem */
+/* NOTE: Time is accumulated, so a subsystem can be measured multiple times per frame */
+CC_API void Profiler_End(int section);
+/* Calculates rolling min/avg/max time (in milliseconds) spent in the given subsystem */
+void Profiler_CalcStats(int section, struct ProfilerStats* stats);
+/* Calculates median and 99th percentile time (in milliseconds) between the last PROFILER_HISTORY frames */
+void Profiler_CalcFrameTimes(struct FrameTimeStats* stats);
+/* Writes the time spent in each subsystem for the last PROFILER_HISTORY frames as CSV */
+cc_result Profiler_WriteCSV(struct Stream* s);
+
 CC_END_HEADER
 #endif
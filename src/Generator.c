@@ -7,6 +7,7 @@
 #include "Utils.h"
 #include "Game.h"
 #include "Window.h"
+#include "Event.h"
 
 const struct MapGenerator* Gen_Active;
 BlockRaw* Gen_Blocks;
@@ -83,8 +84,15 @@ static void Gen_Reset(void) {
 	gen_done = false;
 }
 
+/* Maps with at least this many blocks are generated on demand, if the generator supports that */
+#define GEN_ONDEMAND_VOLUME (64 * 1024 * 1024)
+static cc_bool Gen_StartOnDemand(void);
+
 void Gen_Start(void) {
 	Gen_Reset();
+	if (Gen_Active->GenerateColumn && World.Volume >= GEN_ONDEMAND_VOLUME) {
+		if (Gen_StartOnDemand()) return;
+	}
 	Gen_Blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
 
 	if (!Gen_Blocks || !Gen_Active->Prepare()) {
@@ -96,6 +104,146 @@ void Gen_Start(void) {
 }
 
 
+/*########################################################################################################################*
+*--------------------------------------------------On-demand generation---------------------------------------------------*
+*#########################################################################################################################*/
+/* Generating a very large map entirely up front takes a long time, so instead for generators that */
+/*  support it, each column of chunks is only generated once the map renderer first needs its blocks */
+/* Generated columns are applied with Game_UpdateBlocks, so that lighting/meshes/etc get updated too */
+cc_bool Gen_OnDemand;
+static const struct MapGenerator* columnsGen;
+static cc_uint8* columnsDone;
+static BlockRaw* columnBlocks;
+static int columnX, columnZ, columnWidth, columnLength;
+
+static BlockID Gen_GetColumnBlock(int x, int y, int z, BlockID cur) {
+	return columnBlocks[(y * columnLength + (z - columnZ)) * columnWidth + (x - columnX)];
+}
+
+static void Gen_GenerateColumn(int cx, int cz) {
+	columnX      = cx << CHUNK_SHIFT;
+	columnZ      = cz << CHUNK_SHIFT;
+	columnWidth  = min(CHUNK_SIZE, World.Width  - columnX);
+	columnLength = min(CHUNK_SIZE, World.Length - columnZ);
+	columnsDone[cz * World.ChunksX + cx] = true;
+
+	Mem_Set(columnBlocks, BLOCK_AIR, columnWidth * columnLength * World.Height);
+	columnsGen->GenerateColumn(columnX, columnZ, columnWidth, columnLength, columnBlocks);
+	Game_UpdateBlocks(columnX, 0, columnZ, columnX + columnWidth - 1, World.MaxY, 
+					columnZ + columnLength - 1, Gen_GetColumnBlock);
+}
+
+void Gen_GenerateColumns(int x1, int z1, int x2, int z2) {
+	int cx, cz;
+	if (!Gen_OnDemand) return;
+
+	x1 = max(x1, 0); x2 = min(x2, World.MaxX);
+	z1 = max(z1, 0); z2 = min(z2, World.MaxZ);
+
+	for (cz = z1 >> CHUNK_SHIFT; cz <= (z2 >> CHUNK_SHIFT); cz++) {
+		for (cx = x1 >> CHUNK_SHIFT; cx <= (x2 >> CHUNK_SHIFT); cx++) {
+			if (!columnsDone[cz * World.ChunksX + cx]) Gen_GenerateColumn(cx, cz);
+		}
+	}
+}
+
+static void Gen_StopOnDemand(void* obj) {
+	Mem_Free(columnsDone);
+	Mem_Free(columnBlocks);
+	columnsDone  = NULL;
+	columnBlocks = NULL;
+	Gen_OnDemand = false;
+}
+
+static cc_bool Gen_StartOnDemand(void) {
+	static cc_bool registered;
+	columnsDone  = (cc_uint8*)Mem_TryAllocCleared(World.ChunksX * World.ChunksZ, 1);
+	columnBlocks = (BlockRaw*)Mem_TryAlloc(CHUNK_SIZE * CHUNK_SIZE, World.Height);
+	/* Ungenerated columns are just air */
+	Gen_Blocks   = (BlockRaw*)Mem_TryAllocCleared(World.Volume, 1);
+	Gen_OnDemand = true;
+	columnsGen   = Gen_Active;
+
+	if (!columnsDone || !columnBlocks || !Gen_Blocks || !Gen_Active->Prepare()) {
+		Gen_StopOnDemand(NULL);
+		Mem_Free(Gen_Blocks);
+		Gen_Blocks = NULL;
+		/* Fall back to normal generation (which shows an error if there isn't enough memory) */
+		return false;
+	}
+
+	/* The world is always reset before the next map is generated or loaded */
+	/*  (handler is never unregistered, since that's unsafe while the event is being raised) */
+	if (!registered) Event_Register_(&WorldEvents.NewMap, NULL, Gen_StopOnDemand);
+	registered = true;
+	gen_done   = true;
+	return true;
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Parallel generation---------------------------------------------------*
+*#########################################################################################################################*/
+/* Some generation steps calculate each Z row of the map independently of all other rows, */
+/*  which means the rows can be generated across multiple threads at once */
+/* Each row is still generated identically, so the output for a given seed doesn't change */
+typedef void (*Gen_RowFunc)(int z);
+
+#if !defined CC_BUILD_COOPTHREADED && (!defined CC_BUILD_WEB || defined CC_BUILD_WEBTHREADS) && !defined CC_BUILD_LOWMEM
+#define GEN_MAX_WORKERS 3
+static void* rowsMutex;
+static Gen_RowFunc rowsFunc;
+static int rowsNext;
+
+static void Gen_RunRows(void) {
+	int z;
+	for (;;)
+	{
+		Mutex_Lock(rowsMutex);
+		{
+			z = rowsNext < World.Length ? rowsNext++ : -1;
+		}
+		Mutex_Unlock(rowsMutex);
+
+		if (z < 0) return;
+		Gen_CurrentProgress = (float)z / World.Length;
+		rowsFunc(z);
+	}
+}
+
+static void Gen_ForEachRow(Gen_RowFunc func) {
+	void* workers[GEN_MAX_WORKERS];
+	int i;
+
+	rowsMutex = Mutex_Create("Gen rows");
+	rowsFunc  = func;
+	rowsNext  = 0;
+
+	for (i = 0; i < GEN_MAX_WORKERS; i++) 
+	{
+		Thread_Run(&workers[i], Gen_RunRows, 64 * 1024, "Map gen worker");
+	}
+
+	/* Generator thread also generates rows while waiting */
+	Gen_RunRows();
+	for (i = 0; i < GEN_MAX_WORKERS; i++) 
+	{
+		Thread_Join(workers[i]);
+	}
+	Mutex_Free(rowsMutex);
+}
+#else
+static void Gen_ForEachRow(Gen_RowFunc func) {
+	int z;
+	for (z = 0; z < World.Length; z++) 
+	{
+		Gen_CurrentProgress = (float)z / World.Length;
+		func(z);
+	}
+}
+#endif
+
+
 /*########################################################################################################################*
 *-----------------------------------------------------Flatgrass gen-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -131,9 +279,20 @@ static void FlatgrassGen_Generate(void) {
 	gen_done = true;
 }
 
+static void FlatgrassGen_GenerateColumn(int x1, int z1, int xCount, int zCount, BlockRaw* blocks) {
+	int oneY = xCount * zCount;
+	int y, grassY = World.Height / 2 - 1;
+
+	for (y = 0; y < grassY; y++) {
+		Mem_Set(blocks + y * oneY, BLOCK_DIRT, oneY);
+	}
+	if (grassY >= 0) Mem_Set(blocks + grassY * oneY, BLOCK_GRASS, oneY);
+}
+
 const struct MapGenerator FlatgrassGen = {
 	FlatgrassGen_Prepare,
-	FlatgrassGen_Generate
+	FlatgrassGen_Generate,
+	FlatgrassGen_GenerateColumn
 };
 
 
@@ -266,72 +425,110 @@ static void NotchyGen_FillOblateSpheroid(int x, int y, int z, float radius, Bloc
 }
 
 #define STACK_FAST 8192
+struct FillStack {
+	int* values;
+	int count, limit;
+	int fast[STACK_FAST]; /* avoid allocating memory if possible */
+};
+
+/* Pushes the start of each contiguous run of air blocks in the given X span of a row */
+static void NotchyGen_PushSpans(struct FillStack* s, int rowIndex, int beg, int end) {
+	int x = beg;
+
+	while (x <= end) {
+		if (Gen_Blocks[rowIndex + x] != BLOCK_AIR) { x++; continue; }
+
+		if (s->count == s->limit) {
+			Utils_Resize((void**)&s->values, &s->limit, 4, STACK_FAST, STACK_FAST);
+		}
+		s->values[s->count++] = rowIndex + x;
+
+		/* Rest of the run will be filled in when the pushed seed is expanded */
+		while (x <= end && Gen_Blocks[rowIndex + x] == BLOCK_AIR) x++;
+	}
+}
+
+/* Fills all air blocks reachable from the given block through -X, +X, -Z, +Z or -Y neighbours */
+/* Rather than pushing each individual block, whole X runs of air are filled at once, */
+/*  which keeps the stack small and follows the X-major layout of the blocks array */
 static void NotchyGen_FloodFill(int index, BlockRaw block) {
-	int* stack;
-	int stack_default[STACK_FAST]; /* avoid allocating memory if possible */
-	int count = 0, limit = STACK_FAST;
-	int x, y, z;
+	struct FillStack s;
+	int x, y, z, beg, end, rowIndex;
 
-	stack = stack_default;
 	if (index < 0) return; /* y below map, don't bother starting */
-	stack[count++] = index;
-
-	while (count) {
-		index = stack[--count];
+	s.values = s.fast;
+	s.limit  = STACK_FAST;
+	s.count  = 0;
+	s.values[s.count++] = index;
 
+	while (s.count) {
+		index = s.values[--s.count];
 		if (Gen_Blocks[index] != BLOCK_AIR) continue;
-		Gen_Blocks[index] = block;
 
 		x = index  % World.Width;
 		y = index  / World.OneY;
 		z = (index / World.Width) % World.Length;
+		rowIndex = index - x;
 
-		/* need to increase stack */
-		if (count >= limit - FACE_COUNT) {
-			Utils_Resize((void**)&stack, &limit, 4, STACK_FAST, STACK_FAST);
-		}
+		for (beg = x; beg > 0          && Gen_Blocks[rowIndex + beg - 1] == BLOCK_AIR; beg--) { }
+		for (end = x; end < World.MaxX && Gen_Blocks[rowIndex + end + 1] == BLOCK_AIR; end++) { }
+		Mem_Set(Gen_Blocks + rowIndex + beg, block, end - beg + 1);
 
-		if (x > 0)          { stack[count++] = index - 1; }
-		if (x < World.MaxX) { stack[count++] = index + 1; }
-		if (z > 0)          { stack[count++] = index - World.Width; }
-		if (z < World.MaxZ) { stack[count++] = index + World.Width; }
-		if (y > 0)          { stack[count++] = index - World.OneY; }
+		if (z > 0)          NotchyGen_PushSpans(&s, rowIndex - World.Width, beg, end);
+		if (z < World.MaxZ) NotchyGen_PushSpans(&s, rowIndex + World.Width, beg, end);
+		if (y > 0)          NotchyGen_PushSpans(&s, rowIndex - World.OneY,  beg, end);
 	}
-	if (limit > STACK_FAST) Mem_Free(stack);
+	if (s.limit > STACK_FAST) Mem_Free(s.values);
 }
 
 
-static void NotchyGen_CreateHeightmap(void) {
+/* Noise used by the row functions (which may be called from multiple threads) */
+static const struct CombinedNoise* rowNoise1;
+static const struct CombinedNoise* rowNoise2;
+static const struct OctaveNoise*   rowNoise3;
+
+static int NotchyGen_CalcHeight(const struct CombinedNoise* n1, const struct CombinedNoise* n2, 
+								const struct OctaveNoise* n3, int x, int z) {
 	float hLow, hHigh, height;
-	int hIndex = 0, adjHeight;
-	int x, z;
+	hLow   = CombinedNoise_Calc(n1, x * 1.3f, z * 1.3f) / 6 - 4;
+	height = hLow;
+
+	if (OctaveNoise_Calc(n3, (float)x, (float)z) <= 0) {
+		hHigh = CombinedNoise_Calc(n2, x * 1.3f, z * 1.3f) / 5 + 6;
+		height = max(hLow, hHigh);
+	}
+
+	height *= 0.5f;
+	if (height < 0) height *= 0.8f;
+	return (int)(height + waterLevel);
+}
+
+static void NotchyGen_HeightmapRow(int z) {
+	int hIndex = z * World.Width;
+	int x;
+
+	for (x = 0; x < World.Width; x++) {
+		heightmap[hIndex++] = NotchyGen_CalcHeight(rowNoise1, rowNoise2, rowNoise3, x, z);
+	}
+}
+
+static void NotchyGen_CreateHeightmap(void) {
 	struct CombinedNoise n1, n2;
 	struct OctaveNoise n3;
+	int i, count;
 
 	CombinedNoise_Init(&n1, &rnd, 8, 8);
 	CombinedNoise_Init(&n2, &rnd, 8, 8);	
 	OctaveNoise_Init(&n3, &rnd, 6);
+	rowNoise1 = &n1; rowNoise2 = &n2; rowNoise3 = &n3;
 
 	Gen_CurrentState = "Building heightmap";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
-
-		for (x = 0; x < World.Width; x++) {
-			hLow   = CombinedNoise_Calc(&n1, x * 1.3f, z * 1.3f) / 6 - 4;
-			height = hLow;
-
-			if (OctaveNoise_Calc(&n3, (float)x, (float)z) <= 0) {
-				hHigh = CombinedNoise_Calc(&n2, x * 1.3f, z * 1.3f) / 5 + 6;
-				height = max(hLow, hHigh);
-			}
+	Gen_ForEachRow(NotchyGen_HeightmapRow);
 
-			height *= 0.5f;
-			if (height < 0) height *= 0.8f;
-
-			adjHeight = (int)(height + waterLevel);
-			minHeight = min(adjHeight, minHeight);
-			heightmap[hIndex++] = adjHeight;
-		}
+	count = World.Width * World.Length;
+	for (i = 0; i < count; i++) 
+	{
+		minHeight = min(heightmap[i], minHeight);
 	}
 }
 
@@ -364,43 +561,46 @@ static int NotchyGen_CreateStrataFast(void) {
 	return max(stoneHeight, 1);
 }
 
-static void NotchyGen_CreateStrata(void) {
+static int strataMinStoneY;
+static void NotchyGen_StrataRow(int z) {
 	int dirtThickness, dirtHeight;
-	int minStoneY, stoneHeight;
-	int hIndex = 0, maxY = World.MaxY, index = 0;
-	int x, y, z;
-	struct OctaveNoise n;
+	int minStoneY = strataMinStoneY, stoneHeight;
+	int hIndex = z * World.Width, maxY = World.MaxY, index;
+	int x, y;
 
-	/* Try to bulk fill bottom of the map if possible */
-	minStoneY = NotchyGen_CreateStrataFast();
-	OctaveNoise_Init(&n, &rnd, 8);
-
-	Gen_CurrentState = "Creating strata";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
-
-		for (x = 0; x < World.Width; x++) {
-			dirtThickness = (int)(OctaveNoise_Calc(&n, (float)x, (float)z) / 24 - 4);
-			dirtHeight    = heightmap[hIndex++];
-			stoneHeight   = dirtHeight + dirtThickness;
+	for (x = 0; x < World.Width; x++) {
+		dirtThickness = (int)(OctaveNoise_Calc(rowNoise3, (float)x, (float)z) / 24 - 4);
+		dirtHeight    = heightmap[hIndex++];
+		stoneHeight   = dirtHeight + dirtThickness;
 
-			stoneHeight = min(stoneHeight, maxY);
-			dirtHeight  = min(dirtHeight,  maxY);
+		stoneHeight = min(stoneHeight, maxY);
+		dirtHeight  = min(dirtHeight,  maxY);
 
-			index = World_Pack(x, minStoneY, z);
-			for (y = minStoneY; y <= stoneHeight; y++) {
-				Gen_Blocks[index] = BLOCK_STONE; index += World.OneY;
-			}
+		index = World_Pack(x, minStoneY, z);
+		for (y = minStoneY; y <= stoneHeight; y++) {
+			Gen_Blocks[index] = BLOCK_STONE; index += World.OneY;
+		}
 
-			stoneHeight = max(stoneHeight, 0);
-			index = World_Pack(x, (stoneHeight + 1), z);
-			for (y = stoneHeight + 1; y <= dirtHeight; y++) {
-				Gen_Blocks[index] = BLOCK_DIRT; index += World.OneY;
-			}
+		stoneHeight = max(stoneHeight, 0);
+		index = World_Pack(x, (stoneHeight + 1), z);
+		for (y = stoneHeight + 1; y <= dirtHeight; y++) {
+			Gen_Blocks[index] = BLOCK_DIRT; index += World.OneY;
 		}
 	}
 }
 
+static void NotchyGen_CreateStrata(void) {
+	struct OctaveNoise n;
+
+	/* Try to bulk fill bottom of the map if possible */
+	strataMinStoneY = NotchyGen_CreateStrataFast();
+	OctaveNoise_Init(&n, &rnd, 8);
+	rowNoise3 = &n;
+
+	Gen_CurrentState = "Creating strata";
+	Gen_ForEachRow(NotchyGen_StrataRow);
+}
+
 static void NotchyGen_CarveCaves(void) {
 	int cavesCount, caveLen;
 	float caveX, caveY, caveZ;
@@ -693,11 +893,28 @@ static void NotchyGen_PlantTrees(void) {
 	}
 }
 
+/* Noise used when generating columns on demand */
+/* NOTE: Initialised in the same order as full generation, so terrain shape matches for the same seed */
+static struct NotchyColumnNoise {
+	struct CombinedNoise height1, height2;
+	struct OctaveNoise height3, strata, sand, gravel;
+} colNoise;
+
 static cc_bool NotchyGen_Prepare(void) {
 	Random_Seed(&rnd, Gen_Seed);
 	waterLevel = World.Height / 2;	
 	minHeight  = World.Height;
 
+	if (Gen_OnDemand) {
+		CombinedNoise_Init(&colNoise.height1, &rnd, 8, 8);
+		CombinedNoise_Init(&colNoise.height2, &rnd, 8, 8);
+		OctaveNoise_Init(&colNoise.height3,   &rnd, 6);
+		OctaveNoise_Init(&colNoise.strata,    &rnd, 8);
+		OctaveNoise_Init(&colNoise.sand,      &rnd, 8);
+		OctaveNoise_Init(&colNoise.gravel,    &rnd, 8);
+		return true;
+	}
+
 	heightmap  = (cc_int16*)Mem_TryAlloc(World.Width * World.Length, 2);
 	return heightmap != NULL;
 }
@@ -726,9 +943,122 @@ static void NotchyGen_Generate(void) {
 	gen_done  = true;
 }
 
+#define Column_Pack(x, y, z) (((y) * zCount + (z)) * xCount + (x))
+
+static cc_bool NotchyGen_ColumnCanGrow(int x, int y, int z, int treeHeight, int xCount, int zCount, BlockRaw* blocks) {
+	int baseHeight = treeHeight - 4;
+	int xx, yy, zz, size;
+
+	for (yy = y; yy < y + treeHeight; yy++) {
+		size = yy < y + baseHeight ? 1 : 2;
+
+		for (zz = z - size; zz <= z + size; zz++) {
+			for (xx = x - size; xx <= x + size; xx++) {
+				if (blocks[Column_Pack(xx, yy, zz)] != BLOCK_AIR) return false;
+			}
+		}
+	}
+	return true;
+}
+
+/* Trees are kept away from the edges of the column, so that they never need blocks from neighbouring columns */
+static void NotchyGen_PlantColumnTrees(int xCount, int zCount, BlockRaw* blocks, 
+										const cc_int16* heights, RNGState* rnd) {
+	IVec3 coords[TREE_MAX_COUNT];
+	BlockRaw treeBlocks[TREE_MAX_COUNT];
+	int x, y, z, treeHeight;
+	int i, m, count;
+	if (xCount < 5 || zCount < 5) return;
+
+	Tree_Rnd = rnd;
+	for (i = 0; i < 4; i++) {
+		x = 2 + Random_Next(rnd, xCount - 4);
+		z = 2 + Random_Next(rnd, zCount - 4);
+		treeHeight = 5 + Random_Next(rnd, 3);
+		if (Random_Float(rnd) >= 0.5f) continue;
+
+		y = heights[z * xCount + x] + 1;
+		if (y <= 0 || y + treeHeight > World.Height) continue;
+		if (blocks[Column_Pack(x, y - 1, z)] != BLOCK_GRASS) continue;
+		if (!NotchyGen_ColumnCanGrow(x, y, z, treeHeight, xCount, zCount, blocks)) continue;
+
+		count = TreeGen_Grow(x, y, z, treeHeight, coords, treeBlocks);
+		for (m = 0; m < count; m++) {
+			blocks[Column_Pack(coords[m].x, coords[m].y, coords[m].z)] = treeBlocks[m];
+		}
+	}
+}
+
+static void NotchyGen_PlantColumnFlowers(int xCount, int zCount, BlockRaw* blocks, 
+										const cc_int16* heights, RNGState* rnd) {
+	int x, y, z, i, index;
+	if (Game_Version.Version < VERSION_0023) return;
+
+	for (i = 0; i < 3; i++) {
+		x = Random_Next(rnd, xCount);
+		z = Random_Next(rnd, zCount);
+		y = heights[z * xCount + x] + 1;
+		if (y <= 0 || y >= World.Height) continue;
+
+		index = Column_Pack(x, y, z);
+		if (blocks[index] == BLOCK_AIR && blocks[index - xCount * zCount] == BLOCK_GRASS)
+			blocks[index] = (BlockRaw)(BLOCK_DANDELION + Random_Next(rnd, 2));
+	}
+}
+
+/* Only the terrain shape, strata, water and surface of full map generation are recreated */
+/*  (steps like caves and flood-filled water would need to know about the entire map) */
+static void NotchyGen_GenerateColumn(int x1, int z1, int xCount, int zCount, BlockRaw* blocks) {
+	cc_int16 heights[CHUNK_SIZE * CHUNK_SIZE];
+	int dirtThickness, dirtHeight, stoneHeight;
+	int x, y, z, maxY = World.MaxY;
+	BlockRaw above;
+	RNGState colRnd;
+	cc_uint32 seed;
+
+	for (z = 0; z < zCount; z++) {
+		for (x = 0; x < xCount; x++) {
+			dirtHeight    = NotchyGen_CalcHeight(&colNoise.height1, &colNoise.height2, &colNoise.height3, x1 + x, z1 + z);
+			dirtThickness = (int)(OctaveNoise_Calc(&colNoise.strata, (float)(x1 + x), (float)(z1 + z)) / 24 - 4);
+			heights[z * xCount + x] = dirtHeight;
+
+			stoneHeight = min(dirtHeight + dirtThickness, maxY);
+			dirtHeight  = min(dirtHeight, maxY);
+
+			blocks[Column_Pack(x, 0, z)] = BLOCK_STILL_LAVA;
+			for (y = 1; y <= stoneHeight; y++) {
+				blocks[Column_Pack(x, y, z)] = BLOCK_STONE;
+			}
+			for (y = max(stoneHeight, 0) + 1; y <= dirtHeight; y++) {
+				blocks[Column_Pack(x, y, z)] = BLOCK_DIRT;
+			}
+			for (y = max(dirtHeight, 0) + 1; y < waterLevel; y++) {
+				blocks[Column_Pack(x, y, z)] = BLOCK_STILL_WATER;
+			}
+
+			y = heights[z * xCount + x];
+			if (y < 0 || y > maxY) continue;
+			above = y >= maxY ? BLOCK_AIR : blocks[Column_Pack(x, y + 1, z)];
+
+			if (above == BLOCK_STILL_WATER && (OctaveNoise_Calc(&colNoise.gravel, (float)(x1 + x), (float)(z1 + z)) > 12)) {
+				blocks[Column_Pack(x, y, z)] = BLOCK_GRAVEL;
+			} else if (above == BLOCK_AIR) {
+				blocks[Column_Pack(x, y, z)] = (y <= waterLevel && (OctaveNoise_Calc(&colNoise.sand, (float)(x1 + x), (float)(z1 + z)) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
+			}
+		}
+	}
+
+	/* Features only depend on the seed and the column's coordinates */
+	seed = (cc_uint32)Gen_Seed ^ ((cc_uint32)x1 * 73856093u) ^ ((cc_uint32)z1 * 19349663u);
+	Random_Seed(&colRnd, (int)seed);
+	NotchyGen_PlantColumnTrees(xCount, zCount, blocks, heights, &colRnd);
+	NotchyGen_PlantColumnFlowers(xCount, zCount, blocks, heights, &colRnd);
+}
+
 const struct MapGenerator NotchyGen = {
 	NotchyGen_Prepare,
-	NotchyGen_Generate
+	NotchyGen_Generate,
+	NotchyGen_GenerateColumn
 };
 
 
@@ -738,6 +1068,13 @@ const struct MapGenerator NotchyGen = {
 BlockRaw* Tree_Blocks;
 RNGState* Tree_Rnd;
 
+/* With brick storage, physics has no flat blocks array to give to the tree generator */
+#ifdef CC_BUILD_BRICKWORLD
+#define Tree_GetBlock(x, y, z, index) (Tree_Blocks ? Tree_Blocks[index] : (BlockRaw)World_GetBlock(x, y, z))
+#else
+#define Tree_GetBlock(x, y, z, index) Tree_Blocks[index]
+#endif
+
 cc_bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight) {
 	int baseHeight = treeHeight - 4;
 	int index;
@@ -750,7 +1087,7 @@ cc_bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight) {
 
 				if (!World_Contains(x, y, z)) return false;
 				index = World_Pack(x, y, z);
-				if (Tree_Blocks[index] != BLOCK_AIR) return false;
+				if (Tree_GetBlock(x, y, z, index) != BLOCK_AIR) return false;
 			}
 		}
 	}
@@ -762,7 +1099,7 @@ cc_bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight) {
 
 				if (!World_Contains(x, y, z)) return false;
 				index = World_Pack(x, y, z);
-				if (Tree_Blocks[index] != BLOCK_AIR) return false;
+				if (Tree_GetBlock(x, y, z, index) != BLOCK_AIR) return false;
 			}
 		}
 	}
@@ -22,10 +22,20 @@ void Gen_Start(void);
 /* Checks whether the map generator has completed yet */
 cc_bool Gen_IsDone(void);
 
+/* Whether the current map is being generated one column of chunks at a time, as each column is needed */
+/* NOTE: Only used for very large maps, and only if the generator supports GenerateColumn */
+extern cc_bool Gen_OnDemand;
+/* Generates any columns of chunks overlapping the given area which have not been generated yet */
+/* NOTE: Does nothing if the current map is not being generated on demand */
+void Gen_GenerateColumns(int x1, int z1, int x2, int z2);
+
 
 struct MapGenerator {
 	cc_bool (*Prepare)(void);
 	void   (*Generate)(void);
+	/* Generates the blocks of the given xCount x World.Height x zCount column (NULL if not supported) */
+	/* NOTE: blocks is indexed by ((y * zCount) + z) * xCount + x, and is initially all air */
+	void   (*GenerateColumn)(int x1, int z1, int xCount, int zCount, BlockRaw* blocks);
 };
 
 extern const struct MapGenerator* Gen_Active;
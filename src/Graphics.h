@@ -28,11 +28,26 @@ struct MenuOptionsScreen;
 extern struct IGameComponent Gfx_Component;
 
 typedef enum VertexFormat_ {
-	VERTEX_FORMAT_COLOURED, VERTEX_FORMAT_TEXTURED
+	VERTEX_FORMAT_COLOURED, VERTEX_FORMAT_TEXTURED, 
+	VERTEX_FORMAT_PACKED, /* NOTE: Only valid when Gfx.SupportsPackedVertices is true */
+	VERTEX_FORMAT_PARTICLE /* NOTE: Only valid when Gfx.SupportsParticleVertices is true */
 } VertexFormat;
 
 #define SIZEOF_VERTEX_COLOURED 16
 #define SIZEOF_VERTEX_TEXTURED 24
+#define SIZEOF_VERTEX_PACKED   16
+#define SIZEOF_VERTEX_PARTICLE 60
+
+/* Fixed point scale of packed vertex position components (i.e. 1/32 of a block) */
+#define VERTEX_PACKED_POS_SCALE 32.0f
+/* Fixed point scale of packed vertex U coordinate (i.e. U ranges from 0 to 32) */
+#define VERTEX_PACKED_U_SCALE 2048.0f
+/* Fixed point scale of packed vertex V coordinate (i.e. V ranges from 0 to 1) */
+#define VERTEX_PACKED_V_SCALE 65536.0f
+/* Offset added to packed vertex position components, as sprites extend slightly below 0 */
+#define VERTEX_PACKED_POS_BIAS 1
+/* Maximum coordinate of a packed vertex position component */
+#define VERTEX_PACKED_MAX_COORD (65535 / 32 - VERTEX_PACKED_POS_BIAS)
 
 #if defined CC_BUILD_PSP
 /* 3 floats for position (XYZ), 4 bytes for colour */
@@ -45,6 +60,19 @@ struct VertexColoured { float x, y, z; PackedCol Col; };
 /* 3 floats for position (XYZ), 2 floats for texture coordinates (UV), 4 bytes for colour */
 struct VertexTextured { float x, y, z; PackedCol Col; float U, V; };
 #endif
+/* 3 fixed point shorts for position (XYZ), 1 short for texture array layer, 4 bytes for colour, */
+/*  2 fixed point shorts for texture coordinates (UV) */
+/* Used for world geometry (i.e. chunk meshes) to reduce memory usage */
+struct VertexPacked { cc_uint16 x, y, z, layer; PackedCol Col; cc_uint16 U, V; };
+/* Billboarded particle vertex whose position is calculated by the GPU (see Gfx_SetParticleTime) */
+/*  position = (x,y,z) + vel * 3 * elapsed - (0, 1.5 * gravity * elapsed^2, 0) + offset along camera axes */
+/*  U = U + floor(elapsed * frameRate) * frameU, where elapsed is time since spawnTime (at least 0) */
+struct VertexParticle { 
+	float x, y, z; PackedCol Col; float U, V;
+	float velX, velY, velZ, spawnTime;
+	float gravity, offsetX, offsetY, frameRate;
+	float frameU;
+};
 
 void Gfx_Create(void);
 void Gfx_Free(void);
@@ -73,7 +101,8 @@ CC_VAR extern struct _GfxData {
 	cc_bool NoUVSupport;
 	/* Type of the backend (e.g. OpenGL, Direct3D 9, etc)*/
 	cc_uint8 BackendType;
-	cc_bool __pad;
+	/* Whether the graphics backend supports VERTEX_FORMAT_PACKED */
+	cc_bool SupportsPackedVertices;
 	/* Maximum total size in pixels a low resolution texture can consist of */
 	/* NOTE: Not all graphics backends specify a value for this */
 	int MaxLowResTexSize;
@@ -82,8 +111,26 @@ CC_VAR extern struct _GfxData {
 	int MinTexWidth, MinTexHeight;
 	cc_bool  ReducedPerfMode;
 	cc_uint8 ReducedPerfModeCooldown;
+	/* Whether Gfx_DrawIndexedTris_T2fC4b_Ranges submits all the ranges in one draw call */
+	/* If not, it is just equivalent to calling Gfx_DrawIndexedTris_T2fC4b for each range */
+	cc_bool SupportsMultiDraw;
 	/* Default index buffer for a triangle list representing quads */
 	GfxResourceID DefaultIb;
+	/* Whether the graphics backend supports TEXTURE_FLAG_COMPRESSED */
+	cc_bool SupportsCompression;
+	/* Whether terrain textures should be created with TEXTURE_FLAG_COMPRESSED */
+	cc_bool CompressTextures;
+	/* Whether the graphics backend supports Gfx_CreateTextureArray (at least 64 layers) */
+	cc_bool SupportsTextureArrays;
+	/* Whether the graphics backend supports VERTEX_FORMAT_PARTICLE */
+	cc_bool SupportsParticleVertices;
+	/* Whether the graphics backend supports Gfx_UpdateVbPart */
+	cc_bool SupportsPartialVbUpdates;
+	/* Whether the graphics backend supports occlusion queries (e.g. Gfx_CreateQuery) */
+	cc_bool SupportsOcclusionQueries;
+	/* Whether mipmaps are generated by the GPU, from the whole texture rather than just the updated region */
+	/* NOTE: When true, it's cheaper to only request mipmaps for the last of several texture updates */
+	cc_bool GpuMipmaps;
 } Gfx;
 
 extern const cc_string Gfx_LowPerfMessage;
@@ -113,6 +160,9 @@ SUMMARY:
 #define TEXTURE_FLAG_LOWRES      0x08
 /* Texture should be rendered using bilinear filtering if possible */
 #define TEXTURE_FLAG_BILINEAR    0x10
+/* Texture can be stored using lossy GPU texture compression (if backend supports it) */
+/* NOTE: Partial updates of compressed textures should be aligned to 4x4 blocks */
+#define TEXTURE_FLAG_COMPRESSED  0x20
 
 cc_bool Gfx_CheckTextureSize(int width, int height, cc_uint8 flags);
 /* Creates a new texture. (and also generates mipmaps if mipmaps) */
@@ -130,6 +180,17 @@ CC_API void Gfx_UpdateTexturePart(GfxResourceID texId, int x, int y, struct Bitm
 void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, int rowWidth, cc_bool mipmaps);
 /* Sets the currently active texture */
 CC_API void Gfx_BindTexture(GfxResourceID texId);
+
+/* Creates a new texture array, where each of the layers is a texture of the given size */
+/* NOTE: Layers contain undefined data until they are filled with Gfx_UpdateTextureArray */
+/* NOTE: Returns 0 when the backend does not support texture arrays */
+GfxResourceID Gfx_CreateTextureArray(int width, int height, int layers, cc_uint8 flags, cc_bool mipmaps);
+/* Updates a region of the given layer of a texture array. (and mipmapped regions if mipmaps) */
+void Gfx_UpdateTextureArray(GfxResourceID texId, int x, int y, int layer, struct Bitmap* part, int rowWidth, cc_bool mipmaps);
+/* Sets the currently active texture to a texture array */
+/* Layer is picked by vertex data for VERTEX_FORMAT_PACKED, and otherwise by spreading V across all layers */
+/*  (i.e. V from 0 to 1/layers is the first layer, 1/layers to 2/layers is the second layer, etc) */
+void Gfx_BindTextureArray(GfxResourceID texId, int layers);
 /* Deletes the given texture, then sets it to 0 */
 CC_API void Gfx_DeleteTexture(GfxResourceID* texId);
 
@@ -297,6 +358,9 @@ CC_API void Gfx_DeleteVb(GfxResourceID* vb);
 CC_API void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count);
 /* Submits the changed contents of a vertex buffer */
 CC_API void  Gfx_UnlockVb(GfxResourceID vb);
+/* Updates part of the data of a vertex buffer, starting at the given vertex */
+/* NOTE: Only supported when Gfx.SupportsPartialVbUpdates is true, and the vertex buffer must not be locked */
+void Gfx_UpdateVbPart(GfxResourceID vb, VertexFormat fmt, int offset, int count, void* vertices);
 
 /* TODO: How to make LockDynamicVb work with OpenGL 1.1 Builder stupidity. */
 #ifdef CC_BUILD_GL11
@@ -323,6 +387,12 @@ CC_API void  Gfx_UnlockDynamicVb(GfxResourceID vb);
 
 /* Updates the data of a dynamic vertex buffer */
 CC_API void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount);
+/* Updates part of the data of a dynamic vertex buffer, starting at the given vertex */
+/* NOTE: Only supported when Gfx.SupportsParticleVertices is true, and the vertex buffer must not be locked */
+void Gfx_UpdateDynamicVbPart(GfxResourceID vb, VertexFormat fmt, int offset, int count, void* vertices);
+/* Sets the time that VERTEX_FORMAT_PARTICLE vertices are simulated at */
+/* NOTE: Particles are billboarded using the current Gfx.View matrix */
+void Gfx_SetParticleTime(float time);
 
 
 /*########################################################################################################################*
@@ -350,6 +420,40 @@ CC_API void Gfx_DrawVb_IndexedTris(int verticesCount);
 /* Special case Gfx_DrawVb_IndexedTris_Range for map renderer */
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex);
 
+/* Describes a range of vertices in the currently bound vertex buffer */
+struct GfxDrawRange { int verticesCount, startVertex; };
+/* Maximum number of ranges that can be drawn by one Gfx_DrawIndexedTris_T2fC4b_Ranges call */
+#define GFX_MAX_DRAW_RANGES 16
+/* Special case Gfx_DrawIndexedTris_T2fC4b for map renderer, that draws multiple ranges at once */
+/* NOTE: Only actually reduces the number of draw calls when Gfx.SupportsMultiDraw is true */
+/* NOTE: Like Gfx_DrawIndexedTris_T2fC4b, each range can have at most GFX_MAX_VERTICES vertices */
+void Gfx_DrawIndexedTris_T2fC4b_Ranges(const struct GfxDrawRange* ranges, int count);
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Occlusion queries----------------------------------------------------*
+*#########################################################################################################################*/
+/*
+SUMMARY:
+	Occlusion queries check whether any pixels drawn between Gfx_BeginQuery and Gfx_EndQuery passed the depth test
+IMPLEMENTATION NOTES:
+	Only supported when Gfx.SupportsOcclusionQueries is true
+USAGE NOTES:
+	The result is usually only available one or more frames later, as the GPU runs behind the CPU
+	Beginning a query again before its result has been retrieved discards that result
+*/
+/* Creates a new occlusion query, returning 0 if it could not be created */
+GfxResourceID Gfx_CreateQuery(void);
+/* Deletes the given occlusion query, then sets it to 0 */
+void Gfx_DeleteQuery(GfxResourceID* query);
+/* Starts counting the pixels drawn that pass the depth test */
+void Gfx_BeginQuery(GfxResourceID query);
+/* Stops counting the pixels drawn that pass the depth test */
+void Gfx_EndQuery(GfxResourceID query);
+/* Returns whether the result of the given query is available yet, without waiting for the GPU */
+/* If so, visible is set to whether any pixels passed the depth test */
+cc_bool Gfx_GetQueryResult(GfxResourceID query, cc_bool* visible);
+
 
 /*########################################################################################################################*
 *-----------------------------------------------------Vertex transform----------------------------------------------------*
@@ -412,6 +516,16 @@ CC_API void Gfx_SetScissor (int x, int y, int w, int h);
 *#########################################################################################################################*/
 /* Outputs a .png screenshot of the backbuffer */
 cc_result Gfx_TakeScreenshot(struct Stream* output);
+#if CC_GFX_BACKEND_IS_GL()
+#define CC_BUILD_GFX_READSCREENSHOT
+/* Reads back the contents of the backbuffer, so it can be encoded elsewhere (e.g. on a background thread) */
+/* NOTE: bmp->scan0 is allocated with Mem_TryAlloc, and rows are stored in bottom-up order */
+cc_result Gfx_ReadScreenshot(struct Bitmap* bmp);
+#define CC_BUILD_GFX_COPYSCENE
+/* Copies the bottom left width x height region of the backbuffer into the bottom left of the given texture */
+/* NOTE: The texture must be at least as large as the copied region */
+void Gfx_CopyBackbuffer(GfxResourceID texId, int width, int height);
+#endif
 /* Warns in chat if the graphics backend has problems with the user's GPU */
 /* Returns whether legacy rendering mode for borders/sky/clouds is needed */
 cc_bool Gfx_WarnIfNecessary(void);
@@ -421,6 +535,22 @@ cc_bool Gfx_GetUIOptions(struct MenuOptionsScreen* s);
 /* NOTE: Each line is separated by \n */
 void Gfx_GetApiInfo(cc_string* info);
 
+/* Counters for the rendering work submitted by the CPU */
+struct GfxStats {
+	int drawCalls;    /* Number of Gfx_DrawVb_XYZ/Gfx_DrawIndexedTris_XYZ calls */
+	int vertices;     /* Total number of vertices drawn */
+	int textureBinds; /* Number of Gfx_BindTexture calls */
+	int stateChanges; /* Number of alpha test/alpha blending/color write changes */
+	int vbLocks;      /* Number of times vertex data was locked or set for updating */
+	cc_uint32 bytesUploaded; /* Total size of vertex data locked or set */
+};
+/* Rendering counters for the frame currently being rendered */
+extern struct GfxStats Gfx_Stats;
+/* Rendering counters for the most recently completed frame */
+extern struct GfxStats Gfx_LastStats;
+/* Moves counters for the current frame into Gfx_LastStats and then resets them */
+void Gfx_ResetStats(void);
+
 /* Updates state when the window's dimensions have changed */
 /* NOTE: This may require recreating the context depending on the backend */
 void Gfx_OnWindowResize(void);
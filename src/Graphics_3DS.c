@@ -433,6 +433,7 @@ void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, i
 	ToMortonTexture(&tex->texture, x, y, part, rowWidth);
 }
 void Gfx_DeleteTexture(GfxResourceID* texId) {
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	GPUTexture_Unref(texId);
 }
 
@@ -440,6 +441,7 @@ void Gfx_EnableMipmaps(void) { }
 void Gfx_DisableMipmaps(void) { }
 
 void Gfx_BindTexture(GfxResourceID texId) {
+	GFX_STATS_BIND();
 	if (!texId) texId = white_square; 
  	struct GPUTexture* tex = (struct GPUTexture*)texId;
 	
@@ -692,10 +694,14 @@ void Gfx_BindVb(GfxResourceID vb) {
 	gfx_vertices = buffer->data;
 }
 
-void Gfx_DeleteVb(GfxResourceID* vb) { GPUBuffer_Unref(vb); }
+void Gfx_DeleteVb(GfxResourceID* vb) {
+	Mem_Untrack(MEM_TRACK_VB, *vb);
+	GPUBuffer_Unref(vb);
+}
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
 	struct GPUBuffer* buffer = (struct GPUBuffer*)vb;
+	GFX_STATS_LOCK(fmt, count);
 	return buffer->data;
 }
 
@@ -713,6 +719,7 @@ void Gfx_BindDynamicVb(GfxResourceID vb) { Gfx_BindVb(vb); }
 
 void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) { 
 	struct GPUBuffer* buffer = (struct GPUBuffer*)vb;
+	GFX_STATS_LOCK(fmt, count);
 	return buffer->data;
 }
 
@@ -951,6 +958,7 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	/* TODO */
 }
 
@@ -984,16 +992,19 @@ static void SetVertexSource(int startVertex) {
 }
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	SetVertexSource(startVertex);
 	C3D_DrawElements(GPU_TRIANGLES, ICOUNT(verticesCount));
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	SetVertexSource(0);
 	C3D_DrawElements(GPU_TRIANGLES, ICOUNT(verticesCount));
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	SetVertexSource(startVertex);
 	C3D_DrawElements(GPU_TRIANGLES, ICOUNT(verticesCount));
 }
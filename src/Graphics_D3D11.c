@@ -53,6 +53,7 @@ static void VS_UpdateShader(void);
 static void PS_UpdateShader(void);
 static void InitPipeline(void);
 static void FreePipeline(void);
+static void FreeStagingBuffer(void);
 
 #ifdef CC_BUILD_UWP
 static void LoadD3D11Library(void) { }
@@ -186,7 +187,13 @@ void Gfx_Create(void) {
 
 	Gfx.Created         = true;
 	Gfx.BackendType     = CC_GFX_BACKEND_D3D11;
+	Gfx.SupportsOcclusionQueries = true;
 	customMipmapsLevels = true;
+
+	// Mipmaps can only be generated on the GPU if the texture format can also be rendered to
+	UINT support = 0;
+	ID3D11Device_CheckFormatSupport(device, DXGI_FORMAT_B8G8R8A8_UNORM, &support);
+	Gfx.GpuMipmaps = (support & D3D11_FORMAT_SUPPORT_MIP_AUTOGEN) != 0;
 	Gfx_RestoreState();
 }
 
@@ -226,6 +233,7 @@ static void Gfx_FreeState(void) {
 	FreeDefaultResources();
 	FreePipeline();
 	Gfx_DeleteTexture(&white_square);
+	FreeStagingBuffer();
 }
 
 static void Gfx_RestoreState(void) {
@@ -312,6 +320,12 @@ GfxResourceID Gfx_AllocTexture(struct Bitmap* bmp, int rowWidth, cc_uint8 flags,
 		src = NULL;
 	}
 
+	// GenerateMips requires the texture to be both a render target and shader resource
+	if (mipmaps && Gfx.GpuMipmaps) {
+		desc.BindFlags |= D3D11_BIND_RENDER_TARGET;
+		desc.MiscFlags  = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+	}
+
 	while ((hr = ID3D11Device_CreateTexture2D(device, &desc, src, &tex)))
 	{
 		if (hr == E_OUTOFMEMORY) {
@@ -348,13 +362,19 @@ void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, i
 	ID3D11ShaderResourceView_GetResource(view, &res);
 	ID3D11DeviceContext_UpdateSubresource(context, res, 0, &box, part->scan0, stride, stride * part->height);
 
-	if (mipmaps) D3D11_DoMipmaps(res, x, y, part, rowWidth);
+	// NOTE: GenerateMips regenerates mipmaps for the entire texture, not just the updated region
+	if (mipmaps && Gfx.GpuMipmaps) {
+		ID3D11DeviceContext_GenerateMips(context, view);
+	} else if (mipmaps) {
+		D3D11_DoMipmaps(res, x, y, part, rowWidth);
+	}
 	ID3D11Resource_Release(res);
 }
 
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	ID3D11ShaderResourceView* view = (ID3D11ShaderResourceView*)(*texId);
 	ID3D11Resource* res = NULL;
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 
 	if (view) {
 		ID3D11ShaderResourceView_GetResource(view, &res);
@@ -424,21 +444,84 @@ static GfxResourceID Gfx_AllocStaticVb(VertexFormat fmt, int count) {
 
 void Gfx_DeleteVb(GfxResourceID* vb) { 
 	ID3D11Buffer* buffer = (ID3D11Buffer*)(*vb);
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (buffer) ID3D11Buffer_Release(buffer);
 	*vb = NULL;
 }
 
+// Static VB data is written into a dynamic 'staging' buffer, then copied into the VB by the GPU
+//  (avoids UpdateSubresource, where the driver often has to make its own copy of the data on the CPU)
+// The staging buffer is appended to with NO_OVERWRITE, and discarded once full, so mapping never waits on the GPU
+#define STAGING_VERTICES (128 * 1024)
+#define STAGING_SIZE (STAGING_VERTICES * SIZEOF_VERTEX_TEXTURED)
+static ID3D11Buffer* staging;
+static UINT staging_used, staging_offset, staging_size;
+static cc_bool staging_locked;
+
+static void FreeStagingBuffer(void) {
+	if (staging) ID3D11Buffer_Release(staging);
+	staging      = NULL;
+	staging_used = 0;
+}
+
+static void* Staging_Lock(UINT size) {
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	D3D11_MAP mode = D3D11_MAP_WRITE_NO_OVERWRITE;
+	UINT offset    = (staging_used + 15) & ~15; // keep vertex data 16 byte aligned
+	if (size > STAGING_SIZE) return NULL;
+
+	if (!staging) {
+		staging = CreateVertexBuffer(VERTEX_FORMAT_TEXTURED, STAGING_VERTICES, true);
+		offset  = STAGING_SIZE; // force discard for first use
+	}
+	if (offset + size > STAGING_SIZE) { offset = 0; mode = D3D11_MAP_WRITE_DISCARD; }
+
+	HRESULT hr = ID3D11DeviceContext_Map(context, staging, 0, mode, 0, &mapped);
+	if (hr) return NULL;
+
+	staging_offset = offset;
+	staging_size   = size;
+	staging_used   = offset + size;
+	return (cc_uint8*)mapped.pData + offset;
+}
+
+static void Staging_Unlock(ID3D11Buffer* buffer) {
+	D3D11_BOX box;
+	box.left   = staging_offset;
+	box.right  = staging_offset + staging_size;
+	box.top    = 0;
+	box.bottom = 1;
+	box.front  = 0;
+	box.back   = 1;
+
+	ID3D11DeviceContext_Unmap(context, staging, 0);
+	ID3D11DeviceContext_CopySubresourceRegion(context, buffer, 0, 0, 0, 0, staging, 0, &box);
+}
+
 static void* tmp;
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	UINT size = count * strideSizes[fmt];
+	GFX_STATS_LOCK(fmt, count);
+
+	tmp = Staging_Lock(size);
+	staging_locked = tmp != NULL;
+	if (staging_locked) return tmp;
+
 	tmp = Mem_TryAlloc(count, strideSizes[fmt]);
 	return tmp;
 }
 
 void Gfx_UnlockVb(GfxResourceID vb) {
 	ID3D11Buffer* buffer = (ID3D11Buffer*)vb;
-	ID3D11DeviceContext_UpdateSubresource(context, buffer, 0, NULL, tmp, 0, 0);
-	Mem_Free(tmp);
+
+	if (staging_locked) {
+		Staging_Unlock(buffer);
+	} else {
+		ID3D11DeviceContext_UpdateSubresource(context, buffer, 0, NULL, tmp, 0, 0);
+		Mem_Free(tmp);
+	}
 	tmp = NULL;
+	staging_locked = false;
 }
 
 
@@ -451,6 +534,7 @@ static GfxResourceID Gfx_AllocDynamicVb(VertexFormat fmt, int maxVertices) {
 
 void Gfx_DeleteDynamicVb(GfxResourceID* vb) { 
 	ID3D11Buffer* buffer = (ID3D11Buffer*)(*vb);
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (buffer) ID3D11Buffer_Release(buffer);
 	*vb = NULL;
 }
@@ -458,6 +542,7 @@ void Gfx_DeleteDynamicVb(GfxResourceID* vb) {
 static D3D11_MAPPED_SUBRESOURCE mapDesc;
 void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
 	ID3D11Buffer* buffer = (ID3D11Buffer*)vb;
+	GFX_STATS_LOCK(fmt, count);
 	mapDesc.pData = NULL;
 
 	HRESULT hr = ID3D11DeviceContext_Map(context, buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapDesc);
@@ -486,24 +571,66 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	ID3D11DeviceContext_IASetPrimitiveTopology(context, D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
 	ID3D11DeviceContext_Draw(context, verticesCount, 0);
 	ID3D11DeviceContext_IASetPrimitiveTopology(context, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	ID3D11DeviceContext_DrawIndexed(context, ICOUNT(verticesCount), 0, 0);
 }
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	ID3D11DeviceContext_DrawIndexed(context, ICOUNT(verticesCount), 0, startVertex);
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	ID3D11DeviceContext_DrawIndexed(context, ICOUNT(verticesCount), 0, startVertex);
 }
 
 
+/*########################################################################################################################*
+*----------------------------------------------------Occlusion queries----------------------------------------------------*
+*#########################################################################################################################*/
+GfxResourceID Gfx_CreateQuery(void) {
+	// Predicate queries only track whether any pixels passed, which is all that's needed
+	D3D11_QUERY_DESC desc = { D3D11_QUERY_OCCLUSION_PREDICATE, 0 };
+	ID3D11Query* query = NULL;
+
+	HRESULT hr = ID3D11Device_CreateQuery(device, &desc, &query);
+	return SUCCEEDED(hr) ? query : NULL;
+}
+
+void Gfx_DeleteQuery(GfxResourceID* query) {
+	ID3D11Query* q = (ID3D11Query*)(*query);
+	if (q) ID3D11Query_Release(q);
+	*query = NULL;
+}
+
+void Gfx_BeginQuery(GfxResourceID query) {
+	ID3D11DeviceContext_Begin(context, (ID3D11Asynchronous*)query);
+}
+
+void Gfx_EndQuery(GfxResourceID query) {
+	ID3D11DeviceContext_End(context, (ID3D11Asynchronous*)query);
+}
+
+cc_bool Gfx_GetQueryResult(GfxResourceID query, cc_bool* visible) {
+	BOOL passed = FALSE;
+	// S_FALSE is returned when the result is not available yet
+	HRESULT hr = ID3D11DeviceContext_GetData(context, (ID3D11Asynchronous*)query, 
+						&passed, sizeof(passed), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+	if (hr != S_OK) return false;
+
+	*visible = passed != FALSE;
+	return true;
+}
+
+
 /*########################################################################################################################*
 *---------------------------------------------------------Matrices--------------------------------------------------------*
 *#########################################################################################################################*/
@@ -927,6 +1054,7 @@ static void SetAlphaTest(cc_bool enabled) {
 void Gfx_SetAlphaArgBlend(cc_bool enabled) { }
 
 void Gfx_BindTexture(GfxResourceID texId) {
+	GFX_STATS_BIND();
 	/* defasult texture is otherwise transparent black */
 	if (!texId) texId = white_square;
 
@@ -375,10 +375,14 @@ void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, i
 
 void Gfx_BindTexture(GfxResourceID texId) {
 	cc_result res = IDirect3DDevice9_SetTexture(device, 0, (IDirect3DBaseTexture9*)texId);
+	GFX_STATS_BIND();
 	if (res) Process_Abort2(res, "D3D9_BindTexture");
 }
 
-void Gfx_DeleteTexture(GfxResourceID* texId) { D3D9_FreeResource(*texId); *texId = NULL; }
+void Gfx_DeleteTexture(GfxResourceID* texId) {
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
+	D3D9_FreeResource(*texId); *texId = NULL;
+}
 
 void Gfx_EnableMipmaps(void) {
 	if (!Gfx.Mipmaps) return;
@@ -614,7 +618,10 @@ static GfxResourceID Gfx_AllocStaticVb(VertexFormat fmt, int count) {
 	return D3D9_AllocVertexBuffer(fmt, count, D3DUSAGE_WRITEONLY);
 }
 
-void Gfx_DeleteVb(GfxResourceID* vb) { D3D9_FreeResource(*vb); *vb = NULL; }
+void Gfx_DeleteVb(GfxResourceID* vb) {
+	Mem_Untrack(MEM_TRACK_VB, *vb);
+	D3D9_FreeResource(*vb); *vb = NULL;
+}
 
 void Gfx_BindVb(GfxResourceID vb) {
 	IDirect3DVertexBuffer9* vbuffer = (IDirect3DVertexBuffer9*)vb;
@@ -623,6 +630,7 @@ void Gfx_BindVb(GfxResourceID vb) {
 }
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	return D3D9_LockVb(vb, fmt, count, 0);
 }
 
@@ -640,7 +648,10 @@ static GfxResourceID Gfx_AllocDynamicVb(VertexFormat fmt, int maxVertices) {
 	return D3D9_AllocVertexBuffer(fmt, maxVertices, D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY);
 }
 
-void Gfx_DeleteDynamicVb(GfxResourceID* vb) { D3D9_FreeResource(*vb); *vb = NULL; }
+void Gfx_DeleteDynamicVb(GfxResourceID* vb) {
+	Mem_Untrack(MEM_TRACK_VB, *vb);
+	D3D9_FreeResource(*vb); *vb = NULL;
+}
 
 void Gfx_BindDynamicVb(GfxResourceID vb) {
 	IDirect3DVertexBuffer9* vbuffer = (IDirect3DVertexBuffer9*)vb;
@@ -649,6 +660,7 @@ void Gfx_BindDynamicVb(GfxResourceID vb) {
 }
 
 void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	return D3D9_LockVb(vb, fmt, count, D3DLOCK_DISCARD);
 }
 
@@ -662,6 +674,7 @@ void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
 	IDirect3DVertexBuffer9* buffer = (IDirect3DVertexBuffer9*)vb;
 	cc_result res;
 	
+	GFX_STATS_LOCK(gfx_format, vCount);
 	D3D9_SetVbData(buffer, vertices, size, D3DLOCK_DISCARD);
 	res = IDirect3DDevice9_SetStreamSource(device, 0, buffer, 0, gfx_stride);
 	if (res) Process_Abort2(res, "D3D9_SetDynamicVbData - Bind");
@@ -691,21 +704,25 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	/* NOTE: Skip checking return result for Gfx_DrawXYZ for performance */
 	IDirect3DDevice9_DrawPrimitive(device, D3DPT_LINELIST, 0, verticesCount >> 1);
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	IDirect3DDevice9_DrawIndexedPrimitive(device, D3DPT_TRIANGLELIST,
 		0, 0, verticesCount, 0, verticesCount >> 1);
 }
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	IDirect3DDevice9_DrawIndexedPrimitive(device, D3DPT_TRIANGLELIST,
 		startVertex, 0, verticesCount, 0, verticesCount >> 1);
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	IDirect3DDevice9_DrawIndexedPrimitive(device, D3DPT_TRIANGLELIST,
 		startVertex, 0, verticesCount, 0, verticesCount >> 1);
 }
@@ -402,11 +402,13 @@ void Gfx_BindVb(GfxResourceID vb) { gfx_vertices = vb; }
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	GfxResourceID data = *vb;
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (data) Mem_Free(data);
 	*vb = 0;
 }
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	vb_size = count * strideSizes[fmt];
 	return vb;
 }
@@ -424,6 +426,7 @@ static GfxResourceID Gfx_AllocDynamicVb(VertexFormat fmt, int maxVertices) {
 void Gfx_BindDynamicVb(GfxResourceID vb) { Gfx_BindVb(vb); }
 
 void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	vb_size = count * strideSizes[fmt];
 	return vb; 
 }
@@ -591,12 +594,14 @@ void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, i
 }
 
 void Gfx_BindTexture(GfxResourceID texId) {
+    GFX_STATS_BIND();
     TEXTURE_ACTIVE = (TextureObject*)texId;
 	stateDirty     = true;
 }
 
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	TextureObject* tex = (TextureObject*)(*texId);
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	if (!tex) return;
 
 	cc_uint32 size = tex->width * tex->height * 2;
@@ -674,10 +679,8 @@ static int textureOffset;
 static float vp_scaleX, vp_scaleY, vp_offsetX, vp_offsetY;
 static matrix_t __attribute__((aligned(32))) mat_vp;
 
-void Gfx_LoadMatrix(MatrixType type, const struct Matrix* matrix) {
-	if (type == MATRIX_PROJ) memcpy(&_proj, matrix, sizeof(struct Matrix));
-	if (type == MATRIX_VIEW) memcpy(&_view, matrix, sizeof(struct Matrix));
-
+// Combines viewport, projection and view matrices in the SH4's XMTRX matrix register
+static void UpdateTransformMatrix(void) {
 	memcpy(&mat_vp, &Matrix_Identity, sizeof(struct Matrix));
 	mat_vp[0][0] = vp_scaleX;
 	mat_vp[1][1] = vp_scaleY;
@@ -689,9 +692,17 @@ void Gfx_LoadMatrix(MatrixType type, const struct Matrix* matrix) {
 	mat_apply(&_view);
 }
 
+void Gfx_LoadMatrix(MatrixType type, const struct Matrix* matrix) {
+	if (type == MATRIX_PROJ) memcpy(&_proj, matrix, sizeof(struct Matrix));
+	if (type == MATRIX_VIEW) memcpy(&_view, matrix, sizeof(struct Matrix));
+	UpdateTransformMatrix();
+}
+
 void Gfx_LoadMVP(const struct Matrix* view, const struct Matrix* proj, struct Matrix* mvp) {
-	Gfx_LoadMatrix(MATRIX_VIEW, view);
-	Gfx_LoadMatrix(MATRIX_PROJ, proj);
+	// Only recalculate the combined transform once, instead of once per matrix
+	memcpy(&_view, view, sizeof(struct Matrix));
+	memcpy(&_proj, proj, sizeof(struct Matrix));
+	UpdateTransformMatrix();
 	Matrix_Mul(mvp, view, proj);
 }
 
@@ -802,12 +813,14 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	//SetupVertices(0);
 	//glDrawArrays(GL_LINES, 0, verticesCount);
 }
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
 	void* src;
+	GFX_STATS_DRAW(verticesCount);
 	if (gfx_format == VERTEX_FORMAT_TEXTURED) {
 		src = gfx_vertices + startVertex * SIZEOF_VERTEX_TEXTURED;
 	} else {
@@ -818,12 +831,14 @@ void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	if (textureOffset) ShiftTextureCoords(verticesCount);
 	DrawQuads(verticesCount, gfx_vertices);
 	if (textureOffset) UnshiftTextureCoords(verticesCount);
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	if (renderingDisabled) return;
 	
 	void* src = gfx_vertices + startVertex * SIZEOF_VERTEX_TEXTURED;
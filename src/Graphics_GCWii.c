@@ -168,6 +168,7 @@ void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, i
 
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	GfxResourceID data = *texId;
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	if (data) Mem_Free(data);
 	*texId = NULL;
 }
@@ -177,6 +178,7 @@ void Gfx_DisableMipmaps(void) { }
 
 void Gfx_BindTexture(GfxResourceID texId) {
 	CCTexture* tex = (CCTexture*)texId;
+	GFX_STATS_BIND();
 	if (!tex) tex = white_square;
 
 	GXTexRegion* reg = regionCB(&tex->obj, GX_TEXMAP0);
@@ -355,11 +357,13 @@ void Gfx_BindVb(GfxResourceID vb) { gfx_vertices = vb; }
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	GfxResourceID data = *vb;
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (data) Mem_Free(data);
 	*vb = 0;
 }
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	vb_size = count * strideSizes[fmt];
 	return vb;
 }
@@ -367,6 +371,7 @@ void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
 void Gfx_UnlockVb(GfxResourceID vb) { 
 	gfx_vertices = vb; 
 	DCFlushRange(vb, vb_size);
+	GX_InvVtxCache();
 }
 
 
@@ -377,6 +382,7 @@ static GfxResourceID Gfx_AllocDynamicVb(VertexFormat fmt, int maxVertices) {
 void Gfx_BindDynamicVb(GfxResourceID vb) { Gfx_BindVb(vb); }
 
 void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	vb_size = count * strideSizes[fmt];
 	return vb; 
 }
@@ -384,6 +390,7 @@ void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
 void Gfx_UnlockDynamicVb(GfxResourceID vb) { 
 	gfx_vertices = vb;
 	DCFlushRange(vb, vb_size);
+	GX_InvVtxCache();
 }
 
 void Gfx_DeleteDynamicVb(GfxResourceID* vb) { Gfx_DeleteVb(vb); }
@@ -570,11 +577,13 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 	gfx_format = fmt;
 	gfx_stride = strideSizes[fmt];
 
+	// Vertices are fetched by the GPU directly out of the vertex buffer memory
+	//  (see SetVertexArrays), so only 16 bit indices need to be written per vertex
 	GX_ClearVtxDesc();
 	if (fmt == VERTEX_FORMAT_TEXTURED) {
-		GX_SetVtxDesc(GX_VA_POS,  GX_DIRECT);
-		GX_SetVtxDesc(GX_VA_CLR0, GX_DIRECT);
-		GX_SetVtxDesc(GX_VA_TEX0, GX_DIRECT);
+		GX_SetVtxDesc(GX_VA_POS,  GX_INDEX16);
+		GX_SetVtxDesc(GX_VA_CLR0, GX_INDEX16);
+		GX_SetVtxDesc(GX_VA_TEX0, GX_INDEX16);
 
 		GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_POS,  GX_POS_XYZ,  GX_F32,   0);
 		GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_CLR0, GX_CLR_RGBA, GX_RGBA8, 0);
@@ -586,8 +595,8 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 		GX_SetTevOrder(GX_TEVSTAGE0, GX_TEXCOORD0, GX_TEXMAP0, GX_COLOR0A0);
 		GX_SetTevOp(GX_TEVSTAGE0, GX_MODULATE);
 	} else {
-		GX_SetVtxDesc(GX_VA_POS,  GX_DIRECT);
-		GX_SetVtxDesc(GX_VA_CLR0, GX_DIRECT);
+		GX_SetVtxDesc(GX_VA_POS,  GX_INDEX16);
+		GX_SetVtxDesc(GX_VA_CLR0, GX_INDEX16);
 
 		GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_POS,  GX_POS_XYZ,  GX_F32,   0);
 		GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_CLR0, GX_CLR_RGBA, GX_RGBA8, 0);
@@ -599,52 +608,149 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
+}
+
+
+// VertexTextured/VertexColoured are already laid out in a format GX natively understands,
+//  so rather than converting every vertex on the CPU per draw, just point the GPU at them
+static void SetVertexArrays(int startVertex) {
+	cc_uint8* data = gfx_vertices + startVertex * gfx_stride;
+
+	GX_SetArray(GX_VA_POS,  data,      gfx_stride);
+	GX_SetArray(GX_VA_CLR0, data + 12, gfx_stride);
+	if (gfx_format == VERTEX_FORMAT_TEXTURED)
+		GX_SetArray(GX_VA_TEX0, data + 16, gfx_stride);
+}
+
+// Since vertex arrays are relative to the start vertex, the index stream for drawing
+//  N vertices is always the same (0, 1, 2 .. N - 1). So rather than having the CPU
+//  write out indices per vertex each frame, pre-record index streams of power of two
+//  lengths into display lists once, and then only replay those display lists per draw
+#define DL_LEVELS 12 // 4, 8, 16 .. 8192 vertices
+static void* dl_lists[2][DL_LEVELS];
+static cc_uint32 dl_sizes[2][DL_LEVELS];
+static cc_bool dl_failed[2];
+
+static void* RecordDisplayList(VertexFormat fmt, int verticesCount, cc_uint32* size) {
+	// 3 bytes for primitive header, then a 2 byte index for each attribute
+	int stride    = fmt == VERTEX_FORMAT_TEXTURED ? 6 : 4;
+	cc_uint32 len = (3 + verticesCount * stride + 63) & ~31;
+	void* list    = memalign(32, len);
+	if (!list) return NULL;
+
+	DCInvalidateRange(list, len);
+	GX_BeginDispList(list, len);
+	GX_Begin(GX_QUADS, GX_VTXFMT0, verticesCount);
+	for (int i = 0; i < verticesCount; i++) 
+	{
+		GX_Position1x16(i);
+		GX_Color1x16(i);
+		if (fmt == VERTEX_FORMAT_TEXTURED) GX_TexCoord1x16(i);
+	}
+	GX_End();
+
+	*size = GX_EndDispList();
+	if (*size) return list;
+
+	Mem_Free(list);
+	return NULL;
+}
+
+static void FreeDisplayLists(VertexFormat fmt) {
+	for (int i = 0; i < DL_LEVELS; i++) 
+	{
+		if (dl_lists[fmt][i]) Mem_Free(dl_lists[fmt][i]);
+		dl_lists[fmt][i] = NULL;
+	}
+}
+
+static cc_bool InitDisplayLists(VertexFormat fmt) {
+	if (dl_lists[fmt][0]) return true;
+	if (dl_failed[fmt])   return false;
+
+	for (int i = 0; i < DL_LEVELS; i++) 
+	{
+		dl_lists[fmt][i] = RecordDisplayList(fmt, 4 << i, &dl_sizes[fmt][i]);
+		if (dl_lists[fmt][i]) continue;
+
+		FreeDisplayLists(fmt);
+		dl_failed[fmt] = true;
+		return false;
+	}
+	return true;
 }
 
+static void Draw_DisplayLists(int verticesCount, int startVertex) {
+	int fmt = gfx_format;
+	
+	while (verticesCount >= 4)
+	{
+		int level = DL_LEVELS - 1;
+		while ((4 << level) > verticesCount) level--;
+
+		SetVertexArrays(startVertex);
+		GX_CallDispList(dl_lists[fmt][level], dl_sizes[fmt][level]);
+
+		verticesCount -= 4 << level; 
+		startVertex   += 4 << level;
+	}
+}
 
 static void Draw_ColouredTriangles(int verticesCount, int startVertex) {
+	SetVertexArrays(startVertex);
 	GX_Begin(GX_QUADS, GX_VTXFMT0, verticesCount);
 	// TODO: Ditch indexed rendering and use GX_QUADS instead ??
 	for (int i = 0; i < verticesCount; i++) 
 	{
-		struct VertexColoured* v = (struct VertexColoured*)gfx_vertices + startVertex + i;
-		
-		GX_Position3f32(v->x, v->y, v->z);
-		GX_Color1u32(v->Col);
+		GX_Position1x16(i);
+		GX_Color1x16(i);
 	}
 	GX_End();
 }
 
 static void Draw_TexturedTriangles(int verticesCount, int startVertex) {
+	SetVertexArrays(startVertex);
 	GX_Begin(GX_QUADS, GX_VTXFMT0, verticesCount);
 	for (int i = 0; i < verticesCount; i++) 
 	{
-		struct VertexTextured* v = (struct VertexTextured*)gfx_vertices + startVertex + i;
-		
-		GX_Position3f32(v->x, v->y, v->z);
-		GX_Color1u32(v->Col);
-		GX_TexCoord2f32(v->U, v->V);
+		GX_Position1x16(i);
+		GX_Color1x16(i);
+		GX_TexCoord1x16(i);
 	}
 	GX_End();
 }
 
-void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
-	if (gfx_format == VERTEX_FORMAT_TEXTURED) {
-		Draw_TexturedTriangles(verticesCount, startVertex);
-	} else {
-		Draw_ColouredTriangles(verticesCount, startVertex);
+static void DrawTriangles(int verticesCount, int startVertex) {
+	if (InitDisplayLists(gfx_format)) {
+		Draw_DisplayLists(verticesCount, startVertex); return;
+	}
+
+	// 16 bit indices can only address 65536 vertices at once
+	while (verticesCount > 0) {
+		int count = min(verticesCount, 0xFFFC);
+
+		if (gfx_format == VERTEX_FORMAT_TEXTURED) {
+			Draw_TexturedTriangles(count, startVertex);
+		} else {
+			Draw_ColouredTriangles(count, startVertex);
+		}
+		verticesCount -= count; startVertex += count;
 	}
 }
 
+void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
+	DrawTriangles(verticesCount, startVertex);
+}
+
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
-	if (gfx_format == VERTEX_FORMAT_TEXTURED) {
-		Draw_TexturedTriangles(verticesCount, 0);
-	} else {
-		Draw_ColouredTriangles(verticesCount, 0);
-	}
+	GFX_STATS_DRAW(verticesCount);
+	DrawTriangles(verticesCount, 0);
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
-	Draw_TexturedTriangles(verticesCount, startVertex);
+	GFX_STATS_DRAW(verticesCount);
+	DrawTriangles(verticesCount, startVertex);
 }
 #endif
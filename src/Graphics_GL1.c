@@ -153,17 +153,28 @@ void Gfx_BindVb(GfxResourceID vb) {
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	GfxResourceID id = *vb;
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (id) _glDeleteBuffers(1, (GLuint*)&id);
 	*vb = 0;
 }
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	return FastAllocTempMem(count * strideSizes[fmt]);
 }
 
 void Gfx_UnlockVb(GfxResourceID vb) {
 	_glBufferData(GL_ARRAY_BUFFER, tmpSize, tmpData, GL_STATIC_DRAW);
 }
+
+void Gfx_UpdateVbPart(GfxResourceID vb, VertexFormat fmt, int offset, int count, void* vertices) {
+	int stride = strideSizes[fmt];
+	if (!vb) return;
+	GFX_STATS_LOCK(fmt, count);
+
+	_glBindBuffer(GL_ARRAY_BUFFER, vb);
+	_glBufferSubData(GL_ARRAY_BUFFER, offset * stride, count * stride, vertices);
+}
 #else
 static GfxResourceID Gfx_AllocStaticVb(VertexFormat fmt, int count) { 
 	return glGenLists(1); 
@@ -172,6 +183,7 @@ void Gfx_BindVb(GfxResourceID vb) { activeList = ptr_to_uint(vb); }
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	GLuint id = ptr_to_uint(*vb);
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (id) glDeleteLists(id, 1);
 	*vb = 0;
 }
@@ -197,6 +209,7 @@ static void UpdateDisplayList(GLuint list, void* vertices, VertexFormat fmt, int
 static VertexFormat tmpFormat;
 static int tmpCount;
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	tmpFormat = fmt;
 	tmpCount  = count;
 	return FastAllocTempMem(count * strideSizes[fmt]);
@@ -234,11 +247,13 @@ void Gfx_BindDynamicVb(GfxResourceID vb) {
 
 void Gfx_DeleteDynamicVb(GfxResourceID* vb) {
 	GfxResourceID id = *vb;
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (id) _glDeleteBuffers(1, (GLuint*)&id);
 	*vb = 0;
 }
 
 void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	return FastAllocTempMem(count * strideSizes[fmt]);
 }
 
@@ -249,6 +264,7 @@ void Gfx_UnlockDynamicVb(GfxResourceID vb) {
 
 void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
 	cc_uint32 size = vCount * gfx_stride;
+	GFX_STATS_LOCK(gfx_format, vCount);
 	_glBindBuffer(GL_ARRAY_BUFFER, vb);
 	_glBufferSubData(GL_ARRAY_BUFFER, 0, size, vertices);
 }
@@ -264,14 +280,19 @@ void Gfx_BindDynamicVb(GfxResourceID vb) {
 
 void Gfx_DeleteDynamicVb(GfxResourceID* vb) {
 	void* addr = *vb;
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (addr) Mem_Free(addr);
 	*vb = 0;
 }
 
-void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) { return vb; }
+void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
+	return vb;
+}
 void  Gfx_UnlockDynamicVb(GfxResourceID vb) { Gfx_BindDynamicVb(vb); }
 
 void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
+	GFX_STATS_LOCK(gfx_format, vCount);
 	Gfx_BindDynamicVb(vb);
 	Mem_Copy(vb, vertices, vCount * gfx_stride);
 }
@@ -337,10 +358,12 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 
 void Gfx_DrawVb_Lines(int verticesCount) {
 	gfx_setupVBFunc();
+	GFX_STATS_DRAW(verticesCount);
 	_glDrawArrays(GL_LINES, 0, verticesCount);
 }
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 #ifdef CC_BUILD_GL11
 	if (activeList != gl_DYNAMICLISTID) { glCallList(activeList); return; }
 #endif
@@ -349,6 +372,7 @@ void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 #ifdef CC_BUILD_GL11
 	if (activeList != gl_DYNAMICLISTID) { glCallList(activeList); return; }
 #endif
@@ -357,10 +381,14 @@ void Gfx_DrawVb_IndexedTris(int verticesCount) {
 }
 
 #ifdef CC_BUILD_GL11
-void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) { glCallList(activeList); }
+void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
+	glCallList(activeList);
+}
 #else
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
 	cc_uint32 offset = startVertex * SIZEOF_VERTEX_TEXTURED;
+	GFX_STATS_DRAW(verticesCount);
 	_glVertexPointer(3, GL_FLOAT,        SIZEOF_VERTEX_TEXTURED, VB_PTR + offset +  0);
 	_glColorPointer(4, GL_UNSIGNED_BYTE, SIZEOF_VERTEX_TEXTURED, VB_PTR + offset + 12);
 	_glTexCoordPointer(2, GL_FLOAT,      SIZEOF_VERTEX_TEXTURED, VB_PTR + offset + 16);
@@ -373,6 +401,7 @@ void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
 *---------------------------------------------------------Textures--------------------------------------------------------*
 *#########################################################################################################################*/
 void Gfx_BindTexture(GfxResourceID texId) {
+	GFX_STATS_BIND();
 	_glBindTexture(GL_TEXTURE_2D, ptr_to_uint(texId));
 }
 
@@ -560,7 +589,7 @@ static void APIENTRY legacy_bufferData(GLenum target, cc_uintptr size, const GLv
 
 static void APIENTRY legacy_bufferSubData(GLenum target, cc_uintptr offset, cc_uintptr size, const GLvoid* data) {
 	legacy_buffer* buffer = *legacy_GetBuffer(target);
-	Mem_Copy(buffer->data, data, size);
+	Mem_Copy((cc_uint8*)buffer->data + offset, data, size);
 }
 
 
@@ -727,6 +756,7 @@ static void GLBackend_Init(void) {
 #endif
 	customMipmapsLevels = true;
 	Gfx.BackendType     = CC_GFX_BACKEND_GL1;
+	Gfx.SupportsPartialVbUpdates = true;
 
 	/* Supported in core since 1.5 */
 	if (major > 1 || (major == 1 && minor >= 5)) {
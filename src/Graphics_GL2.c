@@ -8,6 +8,9 @@
 #include "Errors.h"
 #include "Window.h"
 #include "Menus.h"
+#include "Options.h"
+#include "Utils.h"
+#include "Stream.h"
 
 /* OpenGL 2.0 backend (alternative modern-ish backend) */
 #include "../misc/opengl/GLCommon.h"
@@ -46,9 +49,47 @@ static const struct DynamicLibSym core_funcs[] = {
 #define _glTexImage2D     glTexImage2D
 #define _glTexSubImage2D  glTexSubImage2D
 
+static void Ring_EndFrame(void);
+static cc_bool Ring_UploadTexture(int x, int y, struct Bitmap* part, int rowWidth);
+static cc_uint32 gfx_vbOffset;
+typedef void (*GL_SetupVBFunc)(void);
+typedef void (*GL_SetupVBRangeFunc)(int startVertex);
+static GL_SetupVBFunc gfx_setupVBFunc;
+static GL_SetupVBRangeFunc gfx_setupVBRangeFunc;
 #include "_GLShared.h"
 static GfxResourceID white_square;
+/* Dynamically loaded, as OpenGL ES doesn't provide it */
+typedef void (APIENTRY *FP_glMultiDrawElements)(GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawcount);
+static FP_glMultiDrawElements _glMultiDrawElements;
+/* Dynamically loaded, as program binaries are only core since OpenGL 4.1 and OpenGL ES 3.0 */
+typedef void (APIENTRY *FP_glGetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRY *FP_glProgramBinary)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRY *FP_glProgramParameteri)(GLuint program, GLenum pname, GLint value);
+static FP_glGetProgramBinary  _glGetProgramBinary;
+static FP_glProgramBinary     _glProgramBinary;
+static FP_glProgramParameteri _glProgramParameteri;
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
 static int postProcess;
+static GLuint gfx_ib;
+
+#ifdef CC_BUILD_WEB
+/* OpenGL ES 3.0 functions are statically linked by emscripten when WebGL 2 is enabled (-s MAX_WEBGL_VERSION=2) */
+GLAPI void APIENTRY glTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels);
+GLAPI void APIENTRY glTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels);
+GLAPI void APIENTRY glGenVertexArrays(GLsizei n, GLuint* arrays);
+GLAPI void APIENTRY glBindVertexArray(GLuint array);
+GLAPI void APIENTRY glDeleteVertexArrays(GLsizei n, const GLuint* arrays);
+GLAPI void APIENTRY glGenQueries(GLsizei n, GLuint* ids);
+GLAPI void APIENTRY glDeleteQueries(GLsizei n, const GLuint* ids);
+GLAPI void APIENTRY glBeginQuery(GLenum target, GLuint id);
+GLAPI void APIENTRY glEndQuery(GLenum target);
+GLAPI void APIENTRY glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint* params);
+#define GLES3_Load(func, type, name) func = name
+#else
+#define GLES3_Load(func, type, name) func = (type)GLContext_GetAddress(#name)
+#endif
 enum PostProcess { POSTPROCESS_NONE, POSTPROCESS_GRAYSCALE };
 static const char* const postProcess_Names[2] = { "NONE", "GRAYSCALE" };
 
@@ -63,10 +104,16 @@ static GLuint GL_GenAndBind(GLenum target) {
 	return id;
 }
 
+static void VAO_Detach(void);
+
 GfxResourceID Gfx_CreateIb2(int count, Gfx_FillIBFunc fillFunc, void* obj) {
 	cc_uint16 indices[GFX_MAX_INDICES];
-	GLuint id      = GL_GenAndBind(GL_ELEMENT_ARRAY_BUFFER);
 	cc_uint32 size = count * sizeof(cc_uint16);
+	GLuint id;
+
+	VAO_Detach();
+	id = GL_GenAndBind(GL_ELEMENT_ARRAY_BUFFER);
+	gfx_ib = id;
 
 	fillFunc(indices, count, obj);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, GL_STATIC_DRAW);
@@ -74,7 +121,9 @@ GfxResourceID Gfx_CreateIb2(int count, Gfx_FillIBFunc fillFunc, void* obj) {
 }
 
 void Gfx_BindIb(GfxResourceID ib) { 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ptr_to_uint(ib)); 
+	VAO_Detach();
+	gfx_ib = ptr_to_uint(ib);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gfx_ib); 
 }
 
 void Gfx_DeleteIb(GfxResourceID* ib) {
@@ -88,64 +137,357 @@ void Gfx_DeleteIb(GfxResourceID* ib) {
 /*########################################################################################################################*
 *------------------------------------------------------Vertex buffers-----------------------------------------------------*
 *#########################################################################################################################*/
+struct GLStaticVb {
+	GLuint id;
+	GLuint vao;        /* VAO that the vertex attributes of this buffer are recorded in (0 if none) */
+	GLuint vaoIb;      /* Index buffer that was bound when the VAO was recorded */
+	cc_uint8 vaoFormat; /* Vertex format that was active when the VAO was recorded */
+	cc_bool large;     /* Whether the buffer has more vertices than can be drawn with just an index offset */
+};
+static void VAO_Free(struct GLStaticVb* vb);
+
 static GfxResourceID Gfx_AllocStaticVb(VertexFormat fmt, int count) {
-	GLuint id = GL_GenAndBind(GL_ARRAY_BUFFER);
-	return uint_to_ptr(id);
+	struct GLStaticVb* vb = (struct GLStaticVb*)Mem_TryAllocCleared(1, sizeof(struct GLStaticVb));
+	if (!vb) return 0;
+
+	vb->id    = GL_GenAndBind(GL_ARRAY_BUFFER);
+	vb->large = count > GFX_MAX_VERTICES;
+	return vb;
 }
 
-void Gfx_BindVb(GfxResourceID vb) { 
-	glBindBuffer(GL_ARRAY_BUFFER, ptr_to_uint(vb)); 
+void Gfx_BindVb(GfxResourceID vb_) { 
+	struct GLStaticVb* vb = (struct GLStaticVb*)vb_;
+	VAO_Detach();
+	glBindBuffer(GL_ARRAY_BUFFER, vb ? vb->id : 0); 
+	gfx_vbOffset = 0;
 }
 
-void Gfx_DeleteVb(GfxResourceID* vb) {
-	GLuint id = ptr_to_uint(*vb);
-	if (id) glDeleteBuffers(1, &id);
-	*vb = 0;
+void Gfx_DeleteVb(GfxResourceID* vb_) {
+	struct GLStaticVb* vb = (struct GLStaticVb*)(*vb_);
+	Mem_Untrack(MEM_TRACK_VB, *vb_);
+	if (!vb) return;
+
+	VAO_Free(vb);
+	glDeleteBuffers(1, &vb->id);
+	Mem_Free(vb);
+	*vb_ = 0;
 }
 
+static void* Ring_AllocStaging(cc_uint32 size);
+static void  Ring_CopyStaging(GLuint id);
+static cc_bool staging_locked;
+
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
-	return FastAllocTempMem(count * strideSizes[fmt]);
+	cc_uint32 size = count * strideSizes[fmt];
+	void* data;
+	GFX_STATS_LOCK(fmt, count);
+
+	data = Ring_AllocStaging(size);
+	staging_locked = data != NULL;
+	return data ? data : FastAllocTempMem(size);
 }
 
 void Gfx_UnlockVb(GfxResourceID vb) {
-	glBufferData(GL_ARRAY_BUFFER, tmpSize, tmpData, GL_STATIC_DRAW);
+	if (staging_locked) {
+		Ring_CopyStaging(((struct GLStaticVb*)vb)->id);
+	} else {
+		glBufferData(GL_ARRAY_BUFFER, tmpSize, tmpData, GL_STATIC_DRAW);
+	}
+	staging_locked = false;
+}
+
+void Gfx_UpdateVbPart(GfxResourceID vb, VertexFormat fmt, int offset, int count, void* vertices) {
+	int stride = strideSizes[fmt];
+	if (!vb) return;
+	GFX_STATS_LOCK(fmt, count);
+
+	Gfx_BindVb(vb);
+	glBufferSubData(GL_ARRAY_BUFFER, offset * stride, count * stride, vertices);
 }
 
 
 /*########################################################################################################################*
 *--------------------------------------------------Dynamic vertex buffers-------------------------------------------------*
 *#########################################################################################################################*/
+/* When supported, dynamic vertex buffer data is written directly into a persistently mapped 'ring' buffer */
+/* The ring buffer is split into one section per frame in flight, with a fence used to know when */
+/*  the GPU has finished with a section, so that locking a dynamic VB is usually just a pointer bump */
+/* Dynamic VBs that are not updated every frame have their data copied into their own buffer at end of frame */
+/* Static VB data is also staged in the ring buffer, so that the copy into the VB is done by the GPU */
+struct GLDynamicVb {
+	GLuint id;          /* Buffer used when the data is not in the ring buffer */
+	cc_uint32 capacity; /* Size of the vertex buffer in bytes */
+	cc_uint32 offset;   /* Offset of the data in the ring buffer */
+	cc_uint32 size;     /* Size of the data in the ring buffer in bytes */
+	int frame;          /* Frame data was written into the ring buffer, -1 if data is in own buffer */
+	cc_bool inRing;     /* Whether the current lock is using the ring buffer */
+	struct GLDynamicVb* next;
+};
+static struct GLDynamicVb* dynamicVbs;
+
+#ifndef CC_BUILD_GLES
+#define RING_FRAMES 3
+#define RING_SECTION_SIZE (2 * 1024 * 1024)
+typedef struct __GLsync* GLsync;
+typedef void   (APIENTRY *FP_glBufferStorage)(GLenum target, cc_uintptr size, const void* data, GLuint flags);
+typedef void*  (APIENTRY *FP_glMapBufferRange)(GLenum target, cc_uintptr offset, cc_uintptr length, GLuint access);
+typedef GLsync (APIENTRY *FP_glFenceSync)(GLenum condition, GLuint flags);
+typedef GLenum (APIENTRY *FP_glClientWaitSync)(GLsync sync, GLuint flags, cc_uint64 timeout);
+typedef void   (APIENTRY *FP_glDeleteSync)(GLsync sync);
+typedef void   (APIENTRY *FP_glCopyBufferSubData)(GLenum readTarget, GLenum writeTarget, cc_uintptr readOffset, cc_uintptr writeOffset, cc_uintptr size);
+static FP_glBufferStorage     _glBufferStorage;
+static FP_glMapBufferRange    _glMapBufferRange;
+static FP_glFenceSync         _glFenceSync;
+static FP_glClientWaitSync    _glClientWaitSync;
+static FP_glDeleteSync        _glDeleteSync;
+static FP_glCopyBufferSubData _glCopyBufferSubData;
+
+#define _GL_MAP_WRITE_BIT      0x0002
+#define _GL_MAP_PERSISTENT_BIT 0x0040
+#define _GL_MAP_COHERENT_BIT   0x0080
+#define _GL_COPY_READ_BUFFER   0x8F36
+#define _GL_COPY_WRITE_BUFFER  0x8F37
+#define _GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define _GL_SYNC_FLUSH_COMMANDS_BIT    0x0001
+#define _GL_TIMEOUT_EXPIRED            0x911B
+#define _GL_PIXEL_UNPACK_BUFFER        0x88EC
+
+static cc_bool ring_supported;
+static GLuint ring_id;
+static cc_uint8* ring_data;
+static GLsync ring_fences[RING_FRAMES];
+static cc_uint32 ring_used;
+static int ring_frame;
+
+static void Ring_Create(void) {
+	GLuint flags = _GL_MAP_WRITE_BIT | _GL_MAP_PERSISTENT_BIT | _GL_MAP_COHERENT_BIT;
+	if (!ring_supported) return;
+
+	ring_id = GL_GenAndBind(GL_ARRAY_BUFFER);
+	_glBufferStorage(GL_ARRAY_BUFFER, RING_FRAMES * RING_SECTION_SIZE, NULL, flags);
+	ring_data = (cc_uint8*)_glMapBufferRange(GL_ARRAY_BUFFER, 0, RING_FRAMES * RING_SECTION_SIZE, flags);
+	ring_used = 0;
+}
+
+static void Ring_Free(void) {
+	struct GLDynamicVb* vb;
+	int i;
+	for (vb = dynamicVbs; vb; vb = vb->next) vb->frame = -1;
+
+	for (i = 0; i < RING_FRAMES; i++) 
+	{
+		if (ring_fences[i]) _glDeleteSync(ring_fences[i]);
+		ring_fences[i] = NULL;
+	}
+
+	if (ring_id) glDeleteBuffers(1, &ring_id);
+	ring_id   = 0;
+	ring_data = NULL;
+}
+
+/* Returns pointer to space in the current frame's section of the ring buffer, or NULL if out of space */
+static void* Ring_Alloc(struct GLDynamicVb* vb, cc_uint32 size) {
+	cc_uint32 offset = (ring_used + 15) & ~15; /* keep vertex data 16 byte aligned */
+	if (!ring_data || offset + size > RING_SECTION_SIZE) return NULL;
+
+	ring_used  = offset + size;
+	vb->offset = (ring_frame % RING_FRAMES) * RING_SECTION_SIZE + offset;
+	vb->size   = size;
+	return ring_data + vb->offset;
+}
+
+static cc_uint32 staging_offset, staging_size;
+/* Returns pointer to space in the current frame's section of the ring buffer for static VB or texture data, or NULL if out of space */
+/* NOTE: Staged data is limited to the first half of the section, so there is still room for dynamic VB data */
+static void* Ring_AllocStaging(cc_uint32 size) {
+	cc_uint32 offset = (ring_used + 15) & ~15;
+	if (!ring_data || offset + size > RING_SECTION_SIZE / 2) return NULL;
+
+	ring_used      = offset + size;
+	staging_offset = (ring_frame % RING_FRAMES) * RING_SECTION_SIZE + offset;
+	staging_size   = size;
+	return ring_data + staging_offset;
+}
+
+/* Allocates storage for the static VB, then queues a copy of the staged data into it */
+static void Ring_CopyStaging(GLuint id) {
+	glBindBuffer(_GL_COPY_WRITE_BUFFER, id);
+	glBufferData(_GL_COPY_WRITE_BUFFER, staging_size, NULL, GL_STATIC_DRAW);
+	glBindBuffer(_GL_COPY_READ_BUFFER,  ring_id);
+	_glCopyBufferSubData(_GL_COPY_READ_BUFFER, _GL_COPY_WRITE_BUFFER, staging_offset, 0, staging_size);
+}
+
+/* Stages the texture update in the ring buffer, then queues the texture to be updated from it */
+/* This avoids the driver having to copy the pixels (or stall) during glTexSubImage2D */
+static cc_bool Ring_UploadTexture(int x, int y, struct Bitmap* part, int rowWidth) {
+	cc_uint32 stride = part->width * BITMAPCOLOR_SIZE;
+	void* data = Ring_AllocStaging(stride * part->height);
+	if (!data) return false;
+
+	CopyTextureData(data, stride, part, rowWidth * BITMAPCOLOR_SIZE);
+	glBindBuffer(_GL_PIXEL_UNPACK_BUFFER, ring_id);
+	_glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, part->width, part->height, PIXEL_FORMAT, TRANSFER_FORMAT, 
+						(void*)(cc_uintptr)staging_offset);
+	glBindBuffer(_GL_PIXEL_UNPACK_BUFFER, 0);
+	return true;
+}
+
+/* Copies data from the ring buffer into the vertex buffer's own buffer */
+static void Ring_Evict(struct GLDynamicVb* vb) {
+	glBindBuffer(_GL_COPY_READ_BUFFER,  ring_id);
+	glBindBuffer(_GL_COPY_WRITE_BUFFER, vb->id);
+	_glCopyBufferSubData(_GL_COPY_READ_BUFFER, _GL_COPY_WRITE_BUFFER, vb->offset, 0, min(vb->size, vb->capacity));
+	vb->frame = -1;
+}
+
+static void Ring_EndFrame(void) {
+	struct GLDynamicVb* vb;
+	GLsync fence;
+	if (!ring_data) return;
+
+	/* Data from previous frames must be moved out, before the section is reused */
+	for (vb = dynamicVbs; vb; vb = vb->next)
+	{
+		if (vb->frame >= 0 && vb->frame != ring_frame) Ring_Evict(vb);
+	}
+
+	/* Fence is signalled once the GPU has finished everything in this frame */
+	ring_fences[ring_frame % RING_FRAMES] = _glFenceSync(_GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	ring_frame++;
+	ring_used = 0;
+
+	/* Next section was last read from by data evicted two frames ago */
+	fence = ring_fences[(ring_frame + 1) % RING_FRAMES];
+	if (!fence) return;
+
+	while (_glClientWaitSync(fence, _GL_SYNC_FLUSH_COMMANDS_BIT, 1000 * 1000 * 1000) == _GL_TIMEOUT_EXPIRED) { }
+	_glDeleteSync(fence);
+	ring_fences[(ring_frame + 1) % RING_FRAMES] = NULL;
+}
+
+static void Ring_Init(void) {
+	_glBufferStorage     = (FP_glBufferStorage)    GLContext_GetAddress("glBufferStorage");
+	_glMapBufferRange    = (FP_glMapBufferRange)   GLContext_GetAddress("glMapBufferRange");
+	_glFenceSync         = (FP_glFenceSync)        GLContext_GetAddress("glFenceSync");
+	_glClientWaitSync    = (FP_glClientWaitSync)   GLContext_GetAddress("glClientWaitSync");
+	_glDeleteSync        = (FP_glDeleteSync)       GLContext_GetAddress("glDeleteSync");
+	_glCopyBufferSubData = (FP_glCopyBufferSubData)GLContext_GetAddress("glCopyBufferSubData");
+
+	ring_supported = _glBufferStorage && _glMapBufferRange && _glFenceSync 
+					&& _glClientWaitSync && _glDeleteSync && _glCopyBufferSubData;
+}
+#else
+static void  Ring_Create(void) { }
+static void  Ring_Free(void)   { }
+static void  Ring_EndFrame(void) { }
+static void  Ring_Init(void)   { }
+static void* Ring_Alloc(struct GLDynamicVb* vb, cc_uint32 size) { return NULL; }
+static void* Ring_AllocStaging(cc_uint32 size) { return NULL; }
+static cc_bool Ring_UploadTexture(int x, int y, struct Bitmap* part, int rowWidth) { return false; }
+static void  Ring_CopyStaging(GLuint id) { }
+#define ring_id 0
+#define ring_frame 0
+#endif
+
 static GfxResourceID Gfx_AllocDynamicVb(VertexFormat fmt, int maxVertices) {
-	GLuint id      = GL_GenAndBind(GL_ARRAY_BUFFER);
-	cc_uint32 size = maxVertices * strideSizes[fmt];
+	struct GLDynamicVb* vb = (struct GLDynamicVb*)Mem_TryAllocCleared(1, sizeof(struct GLDynamicVb));
+	if (!vb) return 0;
 
-	glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
-	return uint_to_ptr(id);
+	vb->id       = GL_GenAndBind(GL_ARRAY_BUFFER);
+	vb->capacity = maxVertices * strideSizes[fmt];
+	vb->frame    = -1;
+	glBufferData(GL_ARRAY_BUFFER, vb->capacity, NULL, GL_DYNAMIC_DRAW);
+
+	vb->next   = dynamicVbs;
+	dynamicVbs = vb;
+	return vb;
+}
+
+void Gfx_BindDynamicVb(GfxResourceID vb_) {
+	struct GLDynamicVb* vb = (struct GLDynamicVb*)vb_;
+	if (!vb) { Gfx_BindVb(0); return; }
+	VAO_Detach();
+
+	if (vb->frame >= 0) {
+		glBindBuffer(GL_ARRAY_BUFFER, ring_id);
+		gfx_vbOffset = vb->offset;
+	} else {
+		glBindBuffer(GL_ARRAY_BUFFER, vb->id);
+		gfx_vbOffset = 0;
+	}
 }
 
-void Gfx_BindDynamicVb(GfxResourceID vb) {
-	glBindBuffer(GL_ARRAY_BUFFER, ptr_to_uint(vb)); 
+void Gfx_DeleteDynamicVb(GfxResourceID* vb_) {
+	struct GLDynamicVb* vb = (struct GLDynamicVb*)(*vb_);
+	struct GLDynamicVb** cur;
+	Mem_Untrack(MEM_TRACK_VB, *vb_);
+	if (!vb) return;
+
+	for (cur = &dynamicVbs; *cur; cur = &(*cur)->next)
+	{
+		if (*cur == vb) { *cur = vb->next; break; }
+	}
+
+	glDeleteBuffers(1, &vb->id);
+	Mem_Free(vb);
+	*vb_ = 0;
 }
 
-void Gfx_DeleteDynamicVb(GfxResourceID* vb) {
-	GLuint id = ptr_to_uint(*vb);
-	if (id) glDeleteBuffers(1, &id);
-	*vb = 0;
+void* Gfx_LockDynamicVb(GfxResourceID vb_, VertexFormat fmt, int count) {
+	struct GLDynamicVb* vb = (struct GLDynamicVb*)vb_;
+	cc_uint32 size = count * strideSizes[fmt];
+	void* data;
+	GFX_STATS_LOCK(fmt, count);
+	if (!vb) return FastAllocTempMem(size);
+
+	data       = Ring_Alloc(vb, size);
+	vb->inRing = data != NULL;
+	return data ? data : FastAllocTempMem(size);
 }
 
-void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
-	return FastAllocTempMem(count * strideSizes[fmt]);
+void Gfx_UnlockDynamicVb(GfxResourceID vb_) {
+	struct GLDynamicVb* vb = (struct GLDynamicVb*)vb_;
+	if (!vb) return;
+
+	if (vb->inRing) {
+		vb->frame = ring_frame;
+	} else {
+		vb->frame = -1;
+		glBindBuffer(GL_ARRAY_BUFFER, vb->id);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, tmpSize, tmpData);
+	}
+	Gfx_BindDynamicVb(vb);
 }
 
-void Gfx_UnlockDynamicVb(GfxResourceID vb) {
-	glBindBuffer(GL_ARRAY_BUFFER, ptr_to_uint(vb));
-	glBufferSubData(GL_ARRAY_BUFFER, 0, tmpSize, tmpData);
+void Gfx_UpdateDynamicVbPart(GfxResourceID vb_, VertexFormat fmt, int offset, int count, void* vertices) {
+	struct GLDynamicVb* vb = (struct GLDynamicVb*)vb_;
+	int stride = strideSizes[fmt];
+	if (!vb) return;
+
+	/* Partial updates always go into the vertex buffer's own storage */
+	vb->frame = -1;
+	glBindBuffer(GL_ARRAY_BUFFER, vb->id);
+	glBufferSubData(GL_ARRAY_BUFFER, offset * stride, count * stride, vertices);
+	Gfx_BindDynamicVb(vb);
 }
 
-void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
+void Gfx_SetDynamicVbData(GfxResourceID vb_, void* vertices, int vCount) {
+	struct GLDynamicVb* vb = (struct GLDynamicVb*)vb_;
 	cc_uint32 size = vCount * gfx_stride;
-	glBindBuffer(GL_ARRAY_BUFFER, ptr_to_uint(vb));
-	glBufferSubData(GL_ARRAY_BUFFER, 0, size, vertices);
+	void* data;
+	if (!vb) return;
+
+	GFX_STATS_LOCK(gfx_format, vCount);
+	data = Ring_Alloc(vb, size);
+	if (data) {
+		Mem_Copy(data, vertices, size);
+		vb->frame = ring_frame;
+	} else {
+		vb->frame = -1;
+		glBindBuffer(GL_ARRAY_BUFFER, vb->id);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, vertices);
+	}
+	Gfx_BindDynamicVb(vb);
 }
 
 
@@ -157,15 +499,20 @@ void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
 #define FTR_TEX_OFFSET (1 << 2)
 #define FTR_LINEAR_FOG (1 << 3)
 #define FTR_DENSIT_FOG (1 << 4)
+#define FTR_PACKED_VTX (1 << 5)
 #define FTR_HASANY_FOG (FTR_LINEAR_FOG | FTR_DENSIT_FOG)
+#define FTR_TEX_ARRAY  (1 << 6)
 #define FTR_FS_MEDIUMP (1 << 7)
+#define FTR_PARTICLE   (1 << 8)
 
 #define UNI_MVP_MATRIX (1 << 0)
 #define UNI_TEX_OFFSET (1 << 1)
 #define UNI_FOG_COL    (1 << 2)
 #define UNI_FOG_END    (1 << 3)
 #define UNI_FOG_DENS   (1 << 4)
-#define UNI_MASK_ALL   0x1F
+#define UNI_TEX_LAYERS (1 << 5)
+#define UNI_PARTICLE   (1 << 6)
+#define UNI_MASK_ALL   0x7F
 
 /* cached uniforms (cached for multiple programs */
 static struct Matrix _view, _proj, _mvp;
@@ -174,14 +521,20 @@ static float _texX, _texY;
 static PackedCol gfx_fogColor;
 static float gfx_fogEnd = -1.0f, gfx_fogDensity = -1.0f;
 static int gfx_fogMode = -1;
+static cc_bool gfx_texArray;
+static int gfx_texLayers;
+static cc_bool gfx_glsl3; /* Whether texture array shaders are written in GLSL ES 3.00 */
+static float gfx_particleTime;
+static Vec3 gfx_camRight, gfx_camUp;
 
 /* shader programs (emulate fixed function) */
 static struct GLShader {
 	int features;     /* what features are enabled for this shader */
 	int uniforms;     /* which associated uniforms need to be resent to GPU */
 	GLuint program;   /* OpenGL program ID (0 if not yet compiled) */
-	int locations[5]; /* location of uniforms (not constant) */
-} shaders[6 * 3] = {
+	int locations[9]; /* location of uniforms (not constant) */
+	cc_uint32 srcHash; /* hash of the shader source code, for the program binary cache */
+} shaders[8 * 3 * 2 + 6] = {
 	/* no fog */
 	{ 0              },
 	{ 0              | FTR_ALPHA_TEST },
@@ -189,6 +542,8 @@ static struct GLShader {
 	{ FTR_TEXTURE_UV | FTR_ALPHA_TEST },
 	{ FTR_TEXTURE_UV | FTR_TEX_OFFSET },
 	{ FTR_TEXTURE_UV | FTR_TEX_OFFSET | FTR_ALPHA_TEST },
+	{ FTR_TEXTURE_UV | FTR_PACKED_VTX },
+	{ FTR_TEXTURE_UV | FTR_PACKED_VTX | FTR_ALPHA_TEST },
 	/* linear fog */
 	{ FTR_LINEAR_FOG | 0              },
 	{ FTR_LINEAR_FOG | 0              | FTR_ALPHA_TEST },
@@ -196,6 +551,8 @@ static struct GLShader {
 	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_ALPHA_TEST },
 	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET },
 	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET | FTR_ALPHA_TEST },
+	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_PACKED_VTX },
+	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_PACKED_VTX | FTR_ALPHA_TEST },
 	/* density fog */
 	{ FTR_DENSIT_FOG | 0              },
 	{ FTR_DENSIT_FOG | 0              | FTR_ALPHA_TEST },
@@ -203,27 +560,111 @@ static struct GLShader {
 	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_ALPHA_TEST },
 	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET },
 	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET | FTR_ALPHA_TEST },
+	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_PACKED_VTX },
+	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_PACKED_VTX | FTR_ALPHA_TEST },
+
+	/* no fog, texture array */
+	{ FTR_TEX_ARRAY | 0              },
+	{ FTR_TEX_ARRAY | 0              | FTR_ALPHA_TEST },
+	{ FTR_TEX_ARRAY | FTR_TEXTURE_UV },
+	{ FTR_TEX_ARRAY | FTR_TEXTURE_UV | FTR_ALPHA_TEST },
+	{ FTR_TEX_ARRAY | FTR_TEXTURE_UV | FTR_TEX_OFFSET },
+	{ FTR_TEX_ARRAY | FTR_TEXTURE_UV | FTR_TEX_OFFSET | FTR_ALPHA_TEST },
+	{ FTR_TEX_ARRAY | FTR_TEXTURE_UV | FTR_PACKED_VTX },
+	{ FTR_TEX_ARRAY | FTR_TEXTURE_UV | FTR_PACKED_VTX | FTR_ALPHA_TEST },
+	/* linear fog, texture array */
+	{ FTR_TEX_ARRAY | FTR_LINEAR_FOG | 0              },
+	{ FTR_TEX_ARRAY | FTR_LINEAR_FOG | 0              | FTR_ALPHA_TEST },
+	{ FTR_TEX_ARRAY | FTR_LINEAR_FOG | FTR_TEXTURE_UV },
+	{ FTR_TEX_ARRAY | FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_ALPHA_TEST },
+	{ FTR_TEX_ARRAY | FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET },
+	{ FTR_TEX_ARRAY | FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET | FTR_ALPHA_TEST },
+	{ FTR_TEX_ARRAY | FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_PACKED_VTX },
+	{ FTR_TEX_ARRAY | FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_PACKED_VTX | FTR_ALPHA_TEST },
+	/* density fog, texture array */
+	{ FTR_TEX_ARRAY | FTR_DENSIT_FOG | 0              },
+	{ FTR_TEX_ARRAY | FTR_DENSIT_FOG | 0              | FTR_ALPHA_TEST },
+	{ FTR_TEX_ARRAY | FTR_DENSIT_FOG | FTR_TEXTURE_UV },
+	{ FTR_TEX_ARRAY | FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_ALPHA_TEST },
+	{ FTR_TEX_ARRAY | FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET },
+	{ FTR_TEX_ARRAY | FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET | FTR_ALPHA_TEST },
+	{ FTR_TEX_ARRAY | FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_PACKED_VTX },
+	{ FTR_TEX_ARRAY | FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_PACKED_VTX | FTR_ALPHA_TEST },
+
+	/* particles */
+	{ FTR_PARTICLE | FTR_TEXTURE_UV },
+	{ FTR_PARTICLE | FTR_TEXTURE_UV | FTR_ALPHA_TEST },
+	{ FTR_PARTICLE | FTR_TEXTURE_UV | FTR_LINEAR_FOG },
+	{ FTR_PARTICLE | FTR_TEXTURE_UV | FTR_LINEAR_FOG | FTR_ALPHA_TEST },
+	{ FTR_PARTICLE | FTR_TEXTURE_UV | FTR_DENSIT_FOG },
+	{ FTR_PARTICLE | FTR_TEXTURE_UV | FTR_DENSIT_FOG | FTR_ALPHA_TEST },
 };
+#define PARTICLE_SHADERS (8 * 3 * 2)
 static struct GLShader* gfx_activeShader;
 
+/* Generates source code for a GLSL vertex shader that simulates particles (see struct VertexParticle) */
+static void GenParticleVertexShader(cc_string* dst) {
+	String_AppendConst(dst, "attribute vec3 in_pos;\n");
+	String_AppendConst(dst, "attribute vec4 in_col;\n");
+	String_AppendConst(dst, "attribute vec2 in_uv;\n");
+	String_AppendConst(dst, "attribute vec4 in_vel;\n");
+	String_AppendConst(dst, "attribute vec4 in_sim;\n");
+	String_AppendConst(dst, "attribute float in_frameU;\n");
+	String_AppendConst(dst, "varying vec4 out_col;\n");
+	String_AppendConst(dst, "varying vec2 out_uv;\n");
+	String_AppendConst(dst, "uniform mat4 mvp;\n");
+	String_AppendConst(dst, "uniform float particleTime;\n");
+	String_AppendConst(dst, "uniform vec3 camRight;\n");
+	String_AppendConst(dst, "uniform vec3 camUp;\n");
+
+	String_AppendConst(dst, "void main() {\n");
+	String_AppendConst(dst, "  float t = max(particleTime - in_vel.w, 0.0);\n");
+	String_AppendConst(dst, "  vec3 pos = in_pos + in_vel.xyz * (3.0 * t);\n");
+	String_AppendConst(dst, "  pos.y  -= 1.5 * in_sim.x * t * t;\n");
+	String_AppendConst(dst, "  pos    += camRight * in_sim.y + camUp * in_sim.z;\n");
+	String_AppendConst(dst, "  gl_Position = mvp * vec4(pos, 1.0);\n");
+	String_AppendConst(dst, "  out_col = in_col;\n");
+	String_AppendConst(dst, "  out_uv  = in_uv + vec2(floor(t * in_sim.w) * in_frameU, 0.0);\n");
+	String_AppendConst(dst, "}");
+}
+
 /* Generates source code for a GLSL vertex shader, based on shader's flags */
 static void GenVertexShader(const struct GLShader* shader, cc_string* dst) {
 	int uv = shader->features & FTR_TEXTURE_UV;
 	int tm = shader->features & FTR_TEX_OFFSET;
+	int pk = shader->features & FTR_PACKED_VTX;
+	/* Packed vertices store the texture array layer in the otherwise unused 4th position component */
+	int pl = pk && (shader->features & FTR_TEX_ARRAY);
+	if (shader->features & FTR_PARTICLE) { GenParticleVertexShader(dst); return; }
+
+	/* OpenGL ES 3.0 doesn't provide GL_EXT_texture_array, so texture arrays require GLSL ES 3.00 */
+	/*  (and the vertex and fragment shaders of a program must use the same version) */
+	if (gfx_glsl3 && (shader->features & FTR_TEX_ARRAY)) {
+		String_AppendConst(dst, "#version 300 es\n");
+		String_AppendConst(dst, "#define attribute in\n");
+		String_AppendConst(dst, "#define varying out\n");
+	}
 
-	String_AppendConst(dst,         "attribute vec3 in_pos;\n");
+	if (pl) String_AppendConst(dst, "attribute vec4 in_pos;\n");
+	else    String_AppendConst(dst, "attribute vec3 in_pos;\n");
 	String_AppendConst(dst,         "attribute vec4 in_col;\n");
 	if (uv) String_AppendConst(dst, "attribute vec2 in_uv;\n");
 	String_AppendConst(dst,         "varying vec4 out_col;\n");
 	if (uv) String_AppendConst(dst, "varying vec2 out_uv;\n");
+	if (pl) String_AppendConst(dst, "varying float out_layer;\n");
 	String_AppendConst(dst,         "uniform mat4 mvp;\n");
 	if (tm) String_AppendConst(dst, "uniform vec2 texOffset;\n");
 
 	String_AppendConst(dst,         "void main() {\n");
-	String_AppendConst(dst,         "  gl_Position = mvp * vec4(in_pos, 1.0);\n");
+	/* Packed vertices store position and UV as fixed point unsigned shorts (see VERTEX_PACKED_POS_SCALE etc) */
+	/*  NOTE: The subtracted 1.0 must match VERTEX_PACKED_POS_BIAS */
+	if (pk) String_AppendConst(dst, "  gl_Position = mvp * vec4(in_pos.xyz * (1.0 / 32.0) - 1.0, 1.0);\n");
+	else    String_AppendConst(dst, "  gl_Position = mvp * vec4(in_pos, 1.0);\n");
 	String_AppendConst(dst,         "  out_col = in_col;\n");
-	if (uv) String_AppendConst(dst, "  out_uv  = in_uv;\n");
+	if (pk) String_AppendConst(dst, "  out_uv  = in_uv * vec2(1.0 / 2048.0, 1.0 / 65536.0);\n");
+	else if (uv) String_AppendConst(dst, "  out_uv  = in_uv;\n");
 	if (tm) String_AppendConst(dst, "  out_uv  = out_uv + texOffset;\n");
+	if (pl) String_AppendConst(dst, "  out_layer = in_pos.w;\n");
 	String_AppendConst(dst,         "}");
 }
 
@@ -243,23 +684,47 @@ static void GenFragmentShader(const struct GLShader* shader, cc_string* dst) {
 	int fl = shader->features & FTR_LINEAR_FOG;
 	int fd = shader->features & FTR_DENSIT_FOG;
 	int fm = shader->features & FTR_HASANY_FOG;
-
+	int ar = uv && (shader->features & FTR_TEX_ARRAY);
+	int pl = ar && (shader->features & FTR_PACKED_VTX);
+	int v3 = gfx_glsl3 && (shader->features & FTR_TEX_ARRAY);
+
+	if (v3) {
+		String_AppendConst(dst, "#version 300 es\n");
+		String_AppendConst(dst, "#define varying in\n");
+		String_AppendConst(dst, "#define texture2D texture\n");
+		String_AppendConst(dst, "#define texture2DArray texture\n");
+	} else if (ar) {
+		String_AppendConst(dst, "#extension GL_EXT_texture_array : enable\n");
+	}
 #ifdef CC_BUILD_GLES
 	int mp = shader->features & FTR_FS_MEDIUMP;
 	if (mp) String_AppendConst(dst, "precision mediump float;\n");
 	else    String_AppendConst(dst, "precision highp float;\n");
 #endif
+	if (v3) String_AppendConst(dst, "out vec4 fragColor;\n");
 
 	String_AppendConst(dst,         "varying vec4 out_col;\n");
 	if (uv) String_AppendConst(dst, "varying vec2 out_uv;\n");
-	if (uv) String_AppendConst(dst, "uniform sampler2D texImage;\n");
+	if (pl) String_AppendConst(dst, "varying float out_layer;\n");
+	if (ar) String_AppendConst(dst, "uniform sampler2DArray texImage;\n");
+	else if (uv) String_AppendConst(dst, "uniform sampler2D texImage;\n");
+	if (ar && !pl) String_AppendConst(dst, "uniform float texLayers;\n");
 	if (fm) String_AppendConst(dst, "uniform vec3 fogCol;\n");
 	if (fl) String_AppendConst(dst, "uniform float fogEnd;\n");
 	if (fd) String_AppendConst(dst, "uniform float fogDensity;\n");
 
 	String_AppendConst(dst,         "void main() {\n");
-	if (uv) String_AppendConst(dst, "  vec4 col = texture2D(texImage, out_uv) * out_col;\n");
-	else    String_AppendConst(dst, "  vec4 col = out_col;\n");
+	/* Other vertices have the V coordinate spread across all the layers of the texture array */
+	if (pl) {
+		String_AppendConst(dst, "  vec4 col = texture2DArray(texImage, vec3(out_uv, out_layer)) * out_col;\n");
+	} else if (ar) {
+		String_AppendConst(dst, "  float layer = out_uv.y * texLayers;\n");
+		String_AppendConst(dst, "  vec4 col = texture2DArray(texImage, vec3(out_uv.x, fract(layer), floor(layer))) * out_col;\n");
+	} else if (uv) {
+		String_AppendConst(dst, "  vec4 col = texture2D(texImage, out_uv) * out_col;\n");
+	} else {
+		String_AppendConst(dst, "  vec4 col = out_col;\n");
+	}
 	if (al) String_AppendConst(dst, "  if (col.a < 0.5) discard;\n");
 	if (fm) String_AppendConst(dst, "  float depth = 1.0 / gl_FragCoord.w;\n");
 	if (fl) String_AppendConst(dst, "  float f = clamp((fogEnd - depth) / fogEnd, 0.0, 1.0);\n");
@@ -267,7 +732,8 @@ static void GenFragmentShader(const struct GLShader* shader, cc_string* dst) {
 	if (fm) String_AppendConst(dst, "  col.rgb = mix(fogCol, col.rgb, f);\n");
 	
 	if (fl || fd || fm) AddPostProcessing(dst);
-	String_AppendConst(dst,         "  gl_FragColor = col;\n");
+	if (v3) String_AppendConst(dst, "  fragColor = col;\n");
+	else    String_AppendConst(dst, "  gl_FragColor = col;\n");
 	String_AppendConst(dst,         "}");
 }
 
@@ -300,6 +766,20 @@ static void ShaderFailed(GLint shader) {
 	Process_Abort("Failed to compile shader");
 }
 
+static void GetUniformLocations(struct GLShader* shader) {
+	GLuint program = shader->program;
+
+	shader->locations[0] = glGetUniformLocation(program, "mvp");
+	shader->locations[1] = glGetUniformLocation(program, "texOffset");
+	shader->locations[2] = glGetUniformLocation(program, "fogCol");
+	shader->locations[3] = glGetUniformLocation(program, "fogEnd");
+	shader->locations[4] = glGetUniformLocation(program, "fogDensity");
+	shader->locations[5] = glGetUniformLocation(program, "texLayers");
+	shader->locations[6] = glGetUniformLocation(program, "particleTime");
+	shader->locations[7] = glGetUniformLocation(program, "camRight");
+	shader->locations[8] = glGetUniformLocation(program, "camUp");
+}
+
 /* Tries to compile vertex and fragment shaders, then link into an OpenGL program */
 static void CompileProgram(struct GLShader* shader) {
 	char tmpBuffer[2048]; cc_string tmp;
@@ -342,7 +822,12 @@ static void CompileProgram(struct GLShader* shader) {
 	glBindAttribLocation(program, 0, "in_pos");
 	glBindAttribLocation(program, 1, "in_col");
 	glBindAttribLocation(program, 2, "in_uv");
+	glBindAttribLocation(program, 3, "in_vel");
+	glBindAttribLocation(program, 4, "in_sim");
+	glBindAttribLocation(program, 5, "in_frameU");
 
+	/* Some drivers only allow retrieving the binary of a program if requested before linking */
+	if (_glProgramParameteri) _glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
 	glLinkProgram(program);
 	glGetProgramiv(program, GL_LINK_STATUS, &temp);
 
@@ -352,12 +837,7 @@ static void CompileProgram(struct GLShader* shader) {
 
 		glDeleteShader(vs);
 		glDeleteShader(fs);
-
-		shader->locations[0] = glGetUniformLocation(program, "mvp");
-		shader->locations[1] = glGetUniformLocation(program, "texOffset");
-		shader->locations[2] = glGetUniformLocation(program, "fogCol");
-		shader->locations[3] = glGetUniformLocation(program, "fogEnd");
-		shader->locations[4] = glGetUniformLocation(program, "fogDensity");
+		GetUniformLocations(shader);
 		return;
 	}
 	temp = 0;
@@ -407,6 +887,16 @@ static void ReloadUniforms(void) {
 		glUniform1f(s->locations[4], -gfx_fogDensity);
 		s->uniforms &= ~UNI_FOG_DENS;
 	}
+	if ((s->uniforms & UNI_TEX_LAYERS) && (s->features & FTR_TEX_ARRAY)) {
+		glUniform1f(s->locations[5], (float)gfx_texLayers);
+		s->uniforms &= ~UNI_TEX_LAYERS;
+	}
+	if ((s->uniforms & UNI_PARTICLE) && (s->features & FTR_PARTICLE)) {
+		glUniform1f(s->locations[6], gfx_particleTime);
+		glUniform3f(s->locations[7], gfx_camRight.x, gfx_camRight.y, gfx_camRight.z);
+		glUniform3f(s->locations[8], gfx_camUp.x,    gfx_camUp.y,    gfx_camUp.z);
+		s->uniforms &= ~UNI_PARTICLE;
+	}
 }
 
 /* Switches program to one that duplicates current fixed function state */
@@ -416,13 +906,21 @@ static void SwitchProgram(void) {
 	int index = 0;
 
 	if (gfx_fogEnabled) {
-		index += 6;                       /* linear fog */
-		if (gfx_fogMode >= 1) index += 6; /* exp fog */
+		index += 8;                       /* linear fog */
+		if (gfx_fogMode >= 1) index += 8; /* exp fog */
 	}
 
-	if (gfx_format == VERTEX_FORMAT_TEXTURED) index += 2;
-	if (gfx_texTransform) index += 2;
-	if (gfx_alphaTest)    index += 1;
+	if (gfx_format == VERTEX_FORMAT_PARTICLE) {
+		/* Particle shaders are ordered by fog mode, then alpha testing */
+		index = PARTICLE_SHADERS + (index / 8) * 2;
+	} else if (gfx_format == VERTEX_FORMAT_PACKED) {
+		index += 6;
+	} else {
+		if (gfx_format == VERTEX_FORMAT_TEXTURED) index += 2;
+		if (gfx_texTransform) index += 2;
+	}
+	if (gfx_alphaTest) index += 1;
+	if (gfx_texArray && gfx_format != VERTEX_FORMAT_COLOURED && gfx_format != VERTEX_FORMAT_PARTICLE) index += 24;
 
 	shader = &shaders[index];
 	if (shader == gfx_activeShader) { ReloadUniforms(); return; }
@@ -434,23 +932,411 @@ static void SwitchProgram(void) {
 }
 
 
+/*########################################################################################################################*
+*---------------------------------------------------Shader precompiling---------------------------------------------------*
+*#########################################################################################################################*/
+/* Compiling and linking programs can take tens of milliseconds each with some drivers, so */
+/*  all programs are compiled up front instead of the first time they're needed mid-frame */
+/* When supported, the linked program binaries are also cached to disc for future runs */
+static const cc_string shaderCachePath = String_FromConst("shadercache/gl2.bin");
+static const cc_uint8 sc_magic[4] = { 'C','C','S','C' };
+/* Hash of driver name and version, since program binaries are specific to the driver */
+static cc_uint32 shaderCacheKey;
+#define SHADERCACHE_MAX_BINARY (1024 * 1024)
+
+static void InitProgramBinaries(void) {
+#ifndef CC_BUILD_WEB
+	char keyBuffer[768]; cc_string key;
+	GLint formats = 0;
+	if (!Options_GetBool(OPT_SHADER_CACHE, true)) return;
+
+	_glGetProgramBinary = (FP_glGetProgramBinary)GLContext_GetAddress("glGetProgramBinary");
+	_glProgramBinary    = (FP_glProgramBinary)GLContext_GetAddress("glProgramBinary");
+	/* Also provided by GL_OES_get_program_binary for OpenGL ES 2.0 */
+	if (!_glGetProgramBinary || !_glProgramBinary) {
+		_glGetProgramBinary = (FP_glGetProgramBinary)GLContext_GetAddress("glGetProgramBinaryOES");
+		_glProgramBinary    = (FP_glProgramBinary)GLContext_GetAddress("glProgramBinaryOES");
+	}
+	if (_glGetProgramBinary && _glProgramBinary) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+	/* Some drivers provide the functions, but don't actually support any binary formats */
+	if (formats <= 0) { _glGetProgramBinary = NULL; _glProgramBinary = NULL; return; }
+	_glProgramParameteri = (FP_glProgramParameteri)GLContext_GetAddress("glProgramParameteri");
+
+	String_InitArray(key, keyBuffer);
+	String_AppendConst(&key, (const char*)glGetString(GL_VENDOR));
+	String_AppendConst(&key, (const char*)glGetString(GL_RENDERER));
+	String_AppendConst(&key, (const char*)glGetString(GL_VERSION));
+	shaderCacheKey = Utils_CRC32((const cc_uint8*)key.buffer, key.length);
+#endif
+}
+
+static cc_bool IsShaderUsable(const struct GLShader* shader) {
+	return Gfx.SupportsTextureArrays || !(shader->features & FTR_TEX_ARRAY);
+}
+
+static cc_uint32 HashShaderSource(struct GLShader* shader) {
+	char tmpBuffer[4096]; cc_string tmp;
+	int features = shader->features;
+	/* Hash should be the same regardless of whether highp fallback was required */
+	shader->features &= ~FTR_FS_MEDIUMP;
+
+	String_InitArray(tmp, tmpBuffer);
+	GenVertexShader(shader, &tmp);
+	GenFragmentShader(shader, &tmp);
+
+	shader->features = features;
+	return Utils_CRC32((const cc_uint8*)tmp.buffer, tmp.length);
+}
+
+static void LoadProgramBinary(struct GLShader* shader, GLenum format, const void* data, GLsizei length) {
+	GLuint program = glCreateProgram();
+	GLint linked   = 0;
+	if (!program) return;
+
+	_glProgramBinary(program, format, data, length);
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+	/* Drivers can reject previously valid binaries (e.g. after a driver update) */
+	if (!linked) { glDeleteProgram(program); return; }
+	shader->program = program;
+	GetUniformLocations(shader);
+}
+
+static void LoadProgramCache(void) {
+	cc_uint8 header[12], entry[16];
+	cc_uint32 i, count, index, length;
+	struct Stream stream;
+	void* data;
+
+	if (!_glProgramBinary) return;
+	/* Cache not existing yet is the common case, so don't log an error for that */
+	if (Stream_OpenFile(&stream, &shaderCachePath)) return;
+
+	if (!Stream_Read(&stream, header, sizeof(header)) && Mem_Equal(header, sc_magic, sizeof(sc_magic))
+			&& Stream_GetU32_BE(&header[4]) == shaderCacheKey) {
+		count = Stream_GetU32_BE(&header[8]);
+
+		for (i = 0; i < count; i++) {
+			if (Stream_Read(&stream, entry, sizeof(entry))) break;
+			index  = Stream_GetU32_BE(&entry[0]);
+			length = Stream_GetU32_BE(&entry[12]);
+			if (length > SHADERCACHE_MAX_BINARY) break;
+
+			data = Mem_TryAlloc(length + 1, 1);
+			if (!data) break;
+			if (Stream_Read(&stream, (cc_uint8*)data, length)) { Mem_Free(data); break; }
+
+			/* Binaries of programs whose source code has since changed are just ignored */
+			if (length && index < Array_Elems(shaders) && !shaders[index].program
+					&& shaders[index].srcHash == Stream_GetU32_BE(&entry[4])) {
+				LoadProgramBinary(&shaders[index], Stream_GetU32_BE(&entry[8]), data, length);
+			}
+			Mem_Free(data);
+		}
+	}
+
+	/* No point logging error for closing readonly file */
+	(void)stream.Close(&stream);
+}
+
+static cc_result WriteProgramCache(struct Stream* stream) {
+	cc_uint8 header[12], entry[16];
+	cc_uint32 i, count = 0;
+	GLint length; GLsizei written;
+	GLenum format;
+	cc_result res;
+	void* data;
+
+	for (i = 0; i < Array_Elems(shaders); i++) {
+		if (shaders[i].program) count++;
+	}
+	Mem_Copy(header, sc_magic, sizeof(sc_magic));
+	Stream_SetU32_BE(&header[4], shaderCacheKey);
+	Stream_SetU32_BE(&header[8], count);
+	if ((res = Stream_Write(stream, header, sizeof(header)))) return res;
+
+	for (i = 0; i < Array_Elems(shaders); i++) {
+		if (!shaders[i].program) continue;
+		length = 0; written = 0; format = 0;
+		glGetProgramiv(shaders[i].program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+		data = length > 0 ? Mem_TryAlloc(length, 1) : NULL;
+		if (data) _glGetProgramBinary(shaders[i].program, length, &written, &format, data);
+
+		/* Programs which can't be retrieved are written as empty, so they get compiled next time */
+		Stream_SetU32_BE(&entry[0],  i);
+		Stream_SetU32_BE(&entry[4],  shaders[i].srcHash);
+		Stream_SetU32_BE(&entry[8],  format);
+		Stream_SetU32_BE(&entry[12], written);
+
+		res = Stream_Write(stream, entry, sizeof(entry));
+		if (!res && written) res = Stream_Write(stream, (const cc_uint8*)data, written);
+		Mem_Free(data);
+		if (res) return res;
+	}
+	return 0;
+}
+
+static void SaveProgramCache(void) {
+	struct Stream stream;
+	cc_result res, closeRes;
+
+	if (!_glGetProgramBinary) return;
+	if (!Utils_EnsureDirectory("shadercache")) return;
+
+	res = Stream_CreateFile(&stream, &shaderCachePath);
+	if (res) { Logger_SysWarn2(res, "creating", &shaderCachePath); return; }
+
+	res      = WriteProgramCache(&stream);
+	closeRes = stream.Close(&stream);
+	if (!res) res = closeRes;
+	if (res) Logger_SysWarn2(res, "saving", &shaderCachePath);
+}
+
+static void PrecompileShaders(void) {
+	int i, compiled = 0;
+
+	for (i = 0; i < Array_Elems(shaders); i++) {
+		if (IsShaderUsable(&shaders[i])) shaders[i].srcHash = HashShaderSource(&shaders[i]);
+	}
+	LoadProgramCache();
+
+	for (i = 0; i < Array_Elems(shaders); i++) {
+		if (!IsShaderUsable(&shaders[i]) || shaders[i].program) continue;
+		CompileProgram(&shaders[i]);
+		compiled++;
+	}
+	/* Cache only needs to be updated when some programs weren't in it */
+	if (compiled) SaveProgramCache();
+}
+
+
 /*########################################################################################################################*
 *---------------------------------------------------------Textures--------------------------------------------------------*
 *#########################################################################################################################*/
 void Gfx_BindTexture(GfxResourceID texId) {
+	GFX_STATS_BIND();
 	/* Texture 0 has different behaviour depending on backend */
 	/*   Desktop OpenGL  - pure white 1x1 texture */
 	/*   WebGL/OpenGL ES - pure black 1x1 texture */
 	/* So for consistency, always use a 1x1 pure white texture */
 	if (!texId) texId = white_square;
 	glBindTexture(GL_TEXTURE_2D, ptr_to_uint(texId));
+
+	if (!gfx_texArray) return;
+	gfx_texArray = false;
+	SwitchProgram();
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Texture arrays-----------------------------------------------------*
+*#########################################################################################################################*/
+#define _GL_TEXTURE_2D_ARRAY 0x8C1A
+/* Dynamically loaded, as OpenGL 1.1 on Windows and OpenGL ES 2.0 don't provide it */
+typedef void (APIENTRY *FP_glTexImage3D)(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels);
+typedef void (APIENTRY *FP_glTexSubImage3D)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels);
+static FP_glTexImage3D    _glTexImage3D;
+static FP_glTexSubImage3D _glTexSubImage3D;
+
+static void InitTextureArrays(void) {
+#ifndef CC_BUILD_GLES
+	static const cc_string arrayExt = String_FromConst("GL_EXT_texture_array");
+	cc_string exts = String_FromReadonly((const char*)glGetString(GL_EXTENSIONS));
+	if (!String_CaselessContains(&exts, &arrayExt)) return;
+
+	/* NOTE: GL_EXT_texture_array guarantees at least 64 layers are supported */
+	_glTexImage3D    = (FP_glTexImage3D)   GLContext_GetAddress("glTexImage3D");
+	_glTexSubImage3D = (FP_glTexSubImage3D)GLContext_GetAddress("glTexSubImage3D");
+	Gfx.SupportsTextureArrays = _glTexImage3D && _glTexSubImage3D;
+#endif
+}
+
+#ifdef CC_BUILD_GLES
+/* Texture arrays are core in OpenGL ES 3.0 (and hence WebGL 2), but only usable from GLSL ES 3.00 shaders */
+static void InitGLES3TextureArrays(void) {
+	GLES3_Load(_glTexImage3D,    FP_glTexImage3D,    glTexImage3D);
+	GLES3_Load(_glTexSubImage3D, FP_glTexSubImage3D, glTexSubImage3D);
+	Gfx.SupportsTextureArrays = _glTexImage3D && _glTexSubImage3D;
+	gfx_glsl3 = Gfx.SupportsTextureArrays;
+}
+#endif
+
+GfxResourceID Gfx_CreateTextureArray(int width, int height, int layers, cc_uint8 flags, cc_bool mipmaps) {
+	int lvl, lvls = mipmaps ? CalcMipmapsLevels(width, height) : 0;
+	GLuint id;
+	if (!Gfx.SupportsTextureArrays || Gfx.LostContext) return 0;
+
+	glGenTextures(1, &id);
+	/* Mipmaps use roughly an extra third of the base level's memory */
+	Mem_Track(MEM_TRACK_TEXTURE, uint_to_ptr(id), width * height * layers * 4 * (mipmaps ? 4 : 3) / 3, "texture arrays");
+	glBindTexture(_GL_TEXTURE_2D_ARRAY, id);
+	glTexParameteri(_GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, (flags & TEXTURE_FLAG_BILINEAR) ? GL_LINEAR : GL_NEAREST);
+
+	if (mipmaps) {
+		glTexParameteri(_GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+		glTexParameteri(_GL_TEXTURE_2D_ARRAY, _GL_TEXTURE_MAX_LEVEL, lvls);
+	} else {
+		glTexParameteri(_GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, (flags & TEXTURE_FLAG_BILINEAR) ? GL_LINEAR : GL_NEAREST);
+	}
+
+	/* Only allocate storage here, the contents are uploaded later using Gfx_UpdateTextureArray */
+	for (lvl = 0; lvl <= lvls; lvl++)
+	{
+		_glTexImage3D(_GL_TEXTURE_2D_ARRAY, lvl, GL_RGBA, width, height, layers, 0, PIXEL_FORMAT, TRANSFER_FORMAT, NULL);
+		if (width > 1)  width  /= 2;
+		if (height > 1) height /= 2;
+	}
+	return uint_to_ptr(id);
+}
+
+static void UpdateTextureLayer(int lvl, int x, int y, int layer, struct Bitmap* part, int rowWidth) {
+	void* ptr = part->scan0;
+
+	if (part->width != rowWidth) {
+		ptr = Mem_Alloc(part->width * part->height, BITMAPCOLOR_SIZE, "Gfx_UpdateTextureArray temp");
+		CopyTextureData(ptr, part->width * BITMAPCOLOR_SIZE,
+						part, rowWidth   * BITMAPCOLOR_SIZE);
+	}
+
+	_glTexSubImage3D(_GL_TEXTURE_2D_ARRAY, lvl, x, y, layer, part->width, part->height, 1, 
+					PIXEL_FORMAT, TRANSFER_FORMAT, ptr);
+	if (ptr != part->scan0) Mem_Free(ptr);
+}
+
+void Gfx_UpdateTextureArray(GfxResourceID texId, int x, int y, int layer, struct Bitmap* part, int rowWidth, cc_bool mipmaps) {
+	struct Bitmap prev, cur;
+	int lvl, lvls;
+
+	glBindTexture(_GL_TEXTURE_2D_ARRAY, ptr_to_uint(texId));
+	UpdateTextureLayer(0, x, y, layer, part, rowWidth);
+	if (!mipmaps) return;
+	/* NOTE: This regenerates the mipmaps of all layers, not just the updated region */
+	if (_glGenerateMipmap) { _glGenerateMipmap(_GL_TEXTURE_2D_ARRAY); return; }
+
+	lvls = CalcMipmapsLevels(part->width, part->height);
+	prev = *part;
+
+	for (lvl = 1; lvl <= lvls; lvl++)
+	{
+		x /= 2; y /= 2;
+		cur.width  = prev.width  > 1 ? prev.width  / 2 : 1;
+		cur.height = prev.height > 1 ? prev.height / 2 : 1;
+
+		cur.scan0 = (BitmapCol*)Mem_Alloc(cur.width * cur.height, BITMAPCOLOR_SIZE, "mipmaps");
+		GenMipmaps(cur.width, cur.height, cur.scan0, prev.scan0, rowWidth);
+		UpdateTextureLayer(lvl, x, y, layer, &cur, cur.width);
+
+		if (prev.scan0 != part->scan0) Mem_Free(prev.scan0);
+		prev     = cur;
+		rowWidth = cur.width;
+	}
+	if (prev.scan0 != part->scan0) Mem_Free(prev.scan0);
+}
+
+void Gfx_BindTextureArray(GfxResourceID texId, int layers) {
+	GFX_STATS_BIND();
+	glBindTexture(_GL_TEXTURE_2D_ARRAY, ptr_to_uint(texId));
+
+	if (layers != gfx_texLayers) {
+		gfx_texLayers = layers;
+		DirtyUniform(UNI_TEX_LAYERS);
+	}
+
+	if (gfx_texArray) { ReloadUniforms(); return; }
+	gfx_texArray = true;
+	SwitchProgram();
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Vertex array objects--------------------------------------------------*
+*#########################################################################################################################*/
+/* Drawing a static vertex buffer requires binding it and then setting up each vertex attribute, which is */
+/*  relatively expensive with WebGL since every GL call is validated in JavaScript. So when supported, the */
+/*  attribute setup of each static vertex buffer is recorded into a VAO once, which is then just rebound */
+typedef void (APIENTRY *FP_glGenVertexArrays)(GLsizei n, GLuint* arrays);
+typedef void (APIENTRY *FP_glBindVertexArray)(GLuint array);
+typedef void (APIENTRY *FP_glDeleteVertexArrays)(GLsizei n, const GLuint* arrays);
+static FP_glGenVertexArrays    _glGenVertexArrays;
+static FP_glBindVertexArray    _glBindVertexArray;
+static FP_glDeleteVertexArrays _glDeleteVertexArrays;
+static cc_bool vao_supported;
+static struct GLStaticVb* vao_bound;
+
+#ifdef CC_BUILD_GLES
+static void InitGLES3VertexArrays(void) {
+	GLES3_Load(_glGenVertexArrays,    FP_glGenVertexArrays,    glGenVertexArrays);
+	GLES3_Load(_glBindVertexArray,    FP_glBindVertexArray,    glBindVertexArray);
+	GLES3_Load(_glDeleteVertexArrays, FP_glDeleteVertexArrays, glDeleteVertexArrays);
+	vao_supported = _glGenVertexArrays && _glBindVertexArray && _glDeleteVertexArrays;
+}
+#endif
+
+/* Switches back to the default VAO, which all other vertex attribute/buffer state changes apply to */
+static void VAO_Detach(void) {
+	if (!vao_bound) return;
+	_glBindVertexArray(0);
+	vao_bound = NULL;
+}
+
+static void VAO_Free(struct GLStaticVb* vb) {
+	if (!vb->vao) return;
+	/* Deleting the currently bound VAO reverts to the default VAO */
+	if (vao_bound == vb) vao_bound = NULL;
+
+	_glDeleteVertexArrays(1, &vb->vao);
+	vb->vao = 0;
+}
+
+static void VAO_Record(struct GLStaticVb* vb) {
+	int i, attribs = 3;
+	if (gfx_format == VERTEX_FORMAT_COLOURED) attribs = 2;
+	if (gfx_format == VERTEX_FORMAT_PARTICLE) attribs = 6;
+
+	_glGenVertexArrays(1, &vb->vao);
+	_glBindVertexArray(vb->vao);
+	vao_bound = vb;
+
+	glBindBuffer(GL_ARRAY_BUFFER,         vb->id);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gfx_ib);
+	for (i = 0; i < attribs; i++) glEnableVertexAttribArray(i);
+
+	gfx_vbOffset = 0;
+	gfx_setupVBFunc();
+	vb->vaoFormat = gfx_format;
+	vb->vaoIb     = gfx_ib;
+}
+
+static void VAO_Bind(struct GLStaticVb* vb) {
+	/* VAO was recorded with different state */
+	if (vb->vao && (vb->vaoFormat != gfx_format || vb->vaoIb != gfx_ib)) VAO_Free(vb);
+	if (!vb->vao) { VAO_Record(vb); return; }
+
+	if (vao_bound == vb) return;
+	_glBindVertexArray(vb->vao);
+	vao_bound = vb;
+}
+
+/* Vertex attributes of the VAO must be left as recorded, so switch to the same buffer without the VAO */
+static void VAO_Restore(void) {
+	GLuint id = vao_bound->id;
+	VAO_Detach();
+	glBindBuffer(GL_ARRAY_BUFFER, id);
+	gfx_vbOffset = 0;
 }
 
 
 /*########################################################################################################################*
 *-----------------------------------------------------State management----------------------------------------------------*
 *#########################################################################################################################*/
-void Gfx_SetFog(cc_bool enabled) { gfx_fogEnabled = enabled; SwitchProgram(); }
+void Gfx_SetFog(cc_bool enabled) {
+	/* Avoid looking up the program again when fog state doesn't actually change */
+	if (gfx_fogEnabled == enabled) return;
+	gfx_fogEnabled = enabled;
+	SwitchProgram();
+}
 void Gfx_SetFogCol(PackedCol color) {
 	if (color == gfx_fogColor) return;
 	gfx_fogColor = color;
@@ -512,12 +1398,96 @@ void Gfx_EnableTextureOffset(float x, float y) {
 	SwitchProgram();
 }
 
+void Gfx_SetParticleTime(float time) {
+	struct Matrix* view = &Gfx.View;
+	gfx_particleTime = time;
+
+	gfx_camRight.x = view->row1.x; gfx_camRight.y = view->row2.x; gfx_camRight.z = view->row3.x;
+	gfx_camUp.x    = view->row1.y; gfx_camUp.y    = view->row2.y; gfx_camUp.z    = view->row3.y;
+	DirtyUniform(UNI_PARTICLE);
+	ReloadUniforms();
+}
+
 void Gfx_DisableTextureOffset(void) {
 	gfx_texTransform = false;
 	SwitchProgram();
 }
 
 
+/*########################################################################################################################*
+*----------------------------------------------------Occlusion queries----------------------------------------------------*
+*#########################################################################################################################*/
+#define _GL_QUERY_RESULT           0x8866
+#define _GL_QUERY_RESULT_AVAILABLE 0x8867
+#define _GL_SAMPLES_PASSED         0x8914
+#define _GL_ANY_SAMPLES_PASSED     0x8C2F
+/* Dynamically loaded, as queries are only core since OpenGL 1.5 and OpenGL ES 3.0 */
+typedef void (APIENTRY *FP_glGenQueries)(GLsizei n, GLuint* ids);
+typedef void (APIENTRY *FP_glDeleteQueries)(GLsizei n, const GLuint* ids);
+typedef void (APIENTRY *FP_glBeginQuery)(GLenum target, GLuint id);
+typedef void (APIENTRY *FP_glEndQuery)(GLenum target);
+typedef void (APIENTRY *FP_glGetQueryObjectuiv)(GLuint id, GLenum pname, GLuint* params);
+static FP_glGenQueries        _glGenQueries;
+static FP_glDeleteQueries     _glDeleteQueries;
+static FP_glBeginQuery        _glBeginQuery;
+static FP_glEndQuery          _glEndQuery;
+static FP_glGetQueryObjectuiv _glGetQueryObjectuiv;
+/* OpenGL ES only supports checking whether any samples passed, instead of counting them */
+static GLenum query_target;
+
+#ifdef CC_BUILD_GLES
+static void InitOcclusionQueries(void) {
+	GLES3_Load(_glGenQueries,        FP_glGenQueries,        glGenQueries);
+	GLES3_Load(_glDeleteQueries,     FP_glDeleteQueries,     glDeleteQueries);
+	GLES3_Load(_glBeginQuery,        FP_glBeginQuery,        glBeginQuery);
+	GLES3_Load(_glEndQuery,          FP_glEndQuery,          glEndQuery);
+	GLES3_Load(_glGetQueryObjectuiv, FP_glGetQueryObjectuiv, glGetQueryObjectuiv);
+	query_target = _GL_ANY_SAMPLES_PASSED;
+
+	Gfx.SupportsOcclusionQueries = _glGenQueries && _glDeleteQueries && _glBeginQuery 
+									&& _glEndQuery && _glGetQueryObjectuiv;
+}
+#else
+static void InitOcclusionQueries(void) {
+	_glGenQueries        = (FP_glGenQueries)       GLContext_GetAddress("glGenQueries");
+	_glDeleteQueries     = (FP_glDeleteQueries)    GLContext_GetAddress("glDeleteQueries");
+	_glBeginQuery        = (FP_glBeginQuery)       GLContext_GetAddress("glBeginQuery");
+	_glEndQuery          = (FP_glEndQuery)         GLContext_GetAddress("glEndQuery");
+	_glGetQueryObjectuiv = (FP_glGetQueryObjectuiv)GLContext_GetAddress("glGetQueryObjectuiv");
+	query_target = _GL_SAMPLES_PASSED;
+
+	Gfx.SupportsOcclusionQueries = _glGenQueries && _glDeleteQueries && _glBeginQuery 
+									&& _glEndQuery && _glGetQueryObjectuiv;
+}
+#endif
+
+GfxResourceID Gfx_CreateQuery(void) {
+	GLuint id = 0;
+	_glGenQueries(1, &id);
+	return uint_to_ptr(id);
+}
+
+void Gfx_DeleteQuery(GfxResourceID* query) {
+	GLuint id = ptr_to_uint(*query);
+	if (id) _glDeleteQueries(1, &id);
+	*query = 0;
+}
+
+void Gfx_BeginQuery(GfxResourceID query) { _glBeginQuery(query_target, ptr_to_uint(query)); }
+void Gfx_EndQuery(GfxResourceID query)   { _glEndQuery(query_target); }
+
+cc_bool Gfx_GetQueryResult(GfxResourceID query, cc_bool* visible) {
+	GLuint id = ptr_to_uint(query), value = 0;
+
+	_glGetQueryObjectuiv(id, _GL_QUERY_RESULT_AVAILABLE, &value);
+	if (!value) return false;
+
+	_glGetQueryObjectuiv(id, _GL_QUERY_RESULT, &value);
+	*visible = value != 0;
+	return true;
+}
+
+
 /*########################################################################################################################*
 *-------------------------------------------------------State setup-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -534,6 +1504,19 @@ static void GLBackend_Init(void) {
 	GLContext_GetAll(core_funcs, Array_Elems(core_funcs));
 #endif
 	Gfx.BackendType = CC_GFX_BACKEND_GL2;
+	Gfx.SupportsPackedVertices   = true;
+	Gfx.SupportsParticleVertices = true;
+	Gfx.SupportsPartialVbUpdates = true;
+
+#ifndef CC_BUILD_GLES
+	/* glMultiDrawElements is core since OpenGL 1.4, but is not in OpenGL ES 2.0 */
+	_glMultiDrawElements  = (FP_glMultiDrawElements)GLContext_GetAddress("glMultiDrawElements");
+	Gfx.SupportsMultiDraw = _glMultiDrawElements != NULL;
+	InitOcclusionQueries();
+#endif
+	InitTextureArrays();
+	InitProgramBinaries();
+	Ring_Init();
 
 #ifdef CC_BUILD_GLES
 	// OpenGL ES 2.0 doesn't support custom mipmaps levels, but 3.2 does
@@ -547,6 +1530,9 @@ static void GLBackend_Init(void) {
 	glGetIntegerv(_GL_MAJOR_VERSION, &major);
 	glGetIntegerv(_GL_MINOR_VERSION, &minor);
 	customMipmapsLevels = major >= 3 && minor >= 2;
+	if (major >= 3) InitGLES3TextureArrays();
+	if (major >= 3) InitGLES3VertexArrays();
+	if (major >= 3) InitOcclusionQueries();
 #else
     customMipmapsLevels = true;
     const GLubyte* ver  = glGetString(GL_VERSION);
@@ -577,16 +1563,20 @@ static void DeleteShaders(void) {
 }
 
 static void Gfx_FreeState(void) {
+	VAO_Detach();
 	FreeDefaultResources();
+	Ring_Free();
 	DeleteShaders();
 	Gfx_DeleteTexture(&white_square);
 }
 
 static void Gfx_RestoreState(void) {
+	Ring_Create();
 	InitDefaultResources();
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
-	gfx_format = -1;
+	gfx_format   = -1;
+	gfx_texArray = false;
 
 	DirtyUniform(UNI_MASK_ALL);
 	GL_ClearColor(gfx_clearColor);
@@ -598,6 +1588,7 @@ static void Gfx_RestoreState(void) {
 	BitmapCol pixels[1] = { BITMAPCOLOR_WHITE };
 	Bitmap_Init(bmp, 1, 1, pixels);
 	Gfx_RecreateTexture(&white_square, &bmp, 0, false);
+	PrecompileShaders();
 }
 
 cc_bool Gfx_WarnIfNecessary(void) { 
@@ -631,44 +1622,82 @@ cc_bool Gfx_GetUIOptions(struct MenuOptionsScreen* s) {
 /*########################################################################################################################*
 *----------------------------------------------------------Drawing--------------------------------------------------------*
 *#########################################################################################################################*/
-typedef void (*GL_SetupVBFunc)(void);
-typedef void (*GL_SetupVBRangeFunc)(int startVertex);
-static GL_SetupVBFunc gfx_setupVBFunc;
-static GL_SetupVBRangeFunc gfx_setupVBRangeFunc;
-
 static void GL_SetupVbColoured(void) {
-	glVertexAttribPointer(0, 3, GL_FLOAT,         false, SIZEOF_VERTEX_COLOURED, uint_to_ptr( 0));
-	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  SIZEOF_VERTEX_COLOURED, uint_to_ptr(12));
+	glVertexAttribPointer(0, 3, GL_FLOAT,         false, SIZEOF_VERTEX_COLOURED, uint_to_ptr(gfx_vbOffset     ));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  SIZEOF_VERTEX_COLOURED, uint_to_ptr(gfx_vbOffset + 12));
 }
 
 static void GL_SetupVbTextured(void) {
-	glVertexAttribPointer(0, 3, GL_FLOAT,         false, SIZEOF_VERTEX_TEXTURED, uint_to_ptr( 0));
-	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  SIZEOF_VERTEX_TEXTURED, uint_to_ptr(12));
-	glVertexAttribPointer(2, 2, GL_FLOAT,         false, SIZEOF_VERTEX_TEXTURED, uint_to_ptr(16));
+	glVertexAttribPointer(0, 3, GL_FLOAT,         false, SIZEOF_VERTEX_TEXTURED, uint_to_ptr(gfx_vbOffset     ));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  SIZEOF_VERTEX_TEXTURED, uint_to_ptr(gfx_vbOffset + 12));
+	glVertexAttribPointer(2, 2, GL_FLOAT,         false, SIZEOF_VERTEX_TEXTURED, uint_to_ptr(gfx_vbOffset + 16));
+}
+
+static void GL_SetupVbPacked(void) {
+	glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, false, SIZEOF_VERTEX_PACKED, uint_to_ptr(gfx_vbOffset     ));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE,  true,  SIZEOF_VERTEX_PACKED, uint_to_ptr(gfx_vbOffset +  8));
+	glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, false, SIZEOF_VERTEX_PACKED, uint_to_ptr(gfx_vbOffset + 12));
+}
+
+static void GL_SetupVbParticle_Range(int startVertex) {
+	cc_uint32 offset = gfx_vbOffset + startVertex * SIZEOF_VERTEX_PARTICLE;
+	glVertexAttribPointer(0, 3, GL_FLOAT,         false, SIZEOF_VERTEX_PARTICLE, uint_to_ptr(offset     ));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  SIZEOF_VERTEX_PARTICLE, uint_to_ptr(offset + 12));
+	glVertexAttribPointer(2, 2, GL_FLOAT,         false, SIZEOF_VERTEX_PARTICLE, uint_to_ptr(offset + 16));
+	glVertexAttribPointer(3, 4, GL_FLOAT,         false, SIZEOF_VERTEX_PARTICLE, uint_to_ptr(offset + 24));
+	glVertexAttribPointer(4, 4, GL_FLOAT,         false, SIZEOF_VERTEX_PARTICLE, uint_to_ptr(offset + 40));
+	glVertexAttribPointer(5, 1, GL_FLOAT,         false, SIZEOF_VERTEX_PARTICLE, uint_to_ptr(offset + 56));
 }
+static void GL_SetupVbParticle(void) { GL_SetupVbParticle_Range(0); }
 
 static void GL_SetupVbColoured_Range(int startVertex) {
-	cc_uint32 offset = startVertex * SIZEOF_VERTEX_COLOURED;
+	cc_uint32 offset = gfx_vbOffset + startVertex * SIZEOF_VERTEX_COLOURED;
 	glVertexAttribPointer(0, 3, GL_FLOAT,         false, SIZEOF_VERTEX_COLOURED, uint_to_ptr(offset     ));
 	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  SIZEOF_VERTEX_COLOURED, uint_to_ptr(offset + 12));
 }
 
 static void GL_SetupVbTextured_Range(int startVertex) {
-	cc_uint32 offset = startVertex * SIZEOF_VERTEX_TEXTURED;
+	cc_uint32 offset = gfx_vbOffset + startVertex * SIZEOF_VERTEX_TEXTURED;
 	glVertexAttribPointer(0, 3, GL_FLOAT,         false, SIZEOF_VERTEX_TEXTURED, uint_to_ptr(offset     ));
 	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  SIZEOF_VERTEX_TEXTURED, uint_to_ptr(offset + 12));
 	glVertexAttribPointer(2, 2, GL_FLOAT,         false, SIZEOF_VERTEX_TEXTURED, uint_to_ptr(offset + 16));
 }
 
+static void GL_SetupVbPacked_Range(int startVertex) {
+	cc_uint32 offset = gfx_vbOffset + startVertex * SIZEOF_VERTEX_PACKED;
+	glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, false, SIZEOF_VERTEX_PACKED, uint_to_ptr(offset     ));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE,  true,  SIZEOF_VERTEX_PACKED, uint_to_ptr(offset +  8));
+	glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, false, SIZEOF_VERTEX_PACKED, uint_to_ptr(offset + 12));
+}
+
 void Gfx_SetVertexFormat(VertexFormat fmt) {
 	if (fmt == gfx_format) return;
+	VAO_Detach();
+
+	if (fmt == VERTEX_FORMAT_PARTICLE) {
+		glEnableVertexAttribArray(3);
+		glEnableVertexAttribArray(4);
+		glEnableVertexAttribArray(5);
+	} else if (gfx_format == VERTEX_FORMAT_PARTICLE) {
+		glDisableVertexAttribArray(3);
+		glDisableVertexAttribArray(4);
+		glDisableVertexAttribArray(5);
+	}
 	gfx_format = fmt;
 	gfx_stride = strideSizes[fmt];
 
-	if (fmt == VERTEX_FORMAT_TEXTURED) {
+	if (fmt == VERTEX_FORMAT_PARTICLE) {
+		glEnableVertexAttribArray(2);
+		gfx_setupVBFunc      = GL_SetupVbParticle;
+		gfx_setupVBRangeFunc = GL_SetupVbParticle_Range;
+	} else if (fmt == VERTEX_FORMAT_TEXTURED) {
 		glEnableVertexAttribArray(2);
 		gfx_setupVBFunc      = GL_SetupVbTextured;
 		gfx_setupVBRangeFunc = GL_SetupVbTextured_Range;
+	} else if (fmt == VERTEX_FORMAT_PACKED) {
+		glEnableVertexAttribArray(2);
+		gfx_setupVBFunc      = GL_SetupVbPacked;
+		gfx_setupVBRangeFunc = GL_SetupVbPacked_Range;
 	} else {
 		glDisableVertexAttribArray(2);
 		gfx_setupVBFunc      = GL_SetupVbColoured;
@@ -678,33 +1707,69 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	if (vao_bound) VAO_Restore();
 	gfx_setupVBFunc();
+	GFX_STATS_DRAW(verticesCount);
 	glDrawArrays(GL_LINES, 0, verticesCount);
 }
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	if (vao_bound) VAO_Restore();
 	gfx_setupVBRangeFunc(startVertex);
+	GFX_STATS_DRAW(verticesCount);
 	glDrawElements(GL_TRIANGLES, ICOUNT(verticesCount), GL_UNSIGNED_SHORT, NULL);
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	if (vao_bound) VAO_Restore();
 	gfx_setupVBFunc();
+	GFX_STATS_DRAW(verticesCount);
 	glDrawElements(GL_TRIANGLES, ICOUNT(verticesCount), GL_UNSIGNED_SHORT, NULL);
 }
 
-void Gfx_BindVb_Textured(GfxResourceID vb) {
-	Gfx_BindVb(vb);
-	GL_SetupVbTextured();
+/* NOTE: Also used to draw chunk meshes with VERTEX_FORMAT_PACKED */
+void Gfx_BindVb_Textured(GfxResourceID vb_) {
+	struct GLStaticVb* vb = (struct GLStaticVb*)vb_;
+	/* Large buffers need their vertex attributes changed to draw some ranges, so can't use a VAO */
+	if (vao_supported && vb && !vb->large) { VAO_Bind(vb); return; }
+
+	Gfx_BindVb(vb_);
+	gfx_setupVBFunc();
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	if (startVertex + verticesCount > GFX_MAX_VERTICES) {
-		GL_SetupVbTextured_Range(startVertex);
+		gfx_setupVBRangeFunc(startVertex);
 		glDrawElements(GL_TRIANGLES, ICOUNT(verticesCount), GL_UNSIGNED_SHORT, NULL);
-		GL_SetupVbTextured();
+		gfx_setupVBFunc();
 	} else {
 		/* ICOUNT(startVertex) * 2 = startVertex * 3  */
 		glDrawElements(GL_TRIANGLES, ICOUNT(verticesCount), GL_UNSIGNED_SHORT, uint_to_ptr(startVertex * 3));
 	}
 }
+
+void Gfx_DrawIndexedTris_T2fC4b_Ranges(const struct GfxDrawRange* ranges, int count) {
+	GLsizei counts[GFX_MAX_DRAW_RANGES];
+	const void* offsets[GFX_MAX_DRAW_RANGES];
+	int i, j = 0;
+
+	for (i = 0; i < count; i++) 
+	{
+		/* Vertices past the 65536th can't be drawn using just an offset into the index buffer */
+		if (!_glMultiDrawElements || ranges[i].startVertex + ranges[i].verticesCount > GFX_MAX_VERTICES) {
+			Gfx_DrawIndexedTris_T2fC4b(ranges[i].verticesCount, ranges[i].startVertex);
+			continue;
+		}
+
+		counts[j]  = ICOUNT(ranges[i].verticesCount);
+		offsets[j] = uint_to_ptr(ranges[i].startVertex * 3);
+		Gfx_Stats.vertices += ranges[i].verticesCount;
+		j++;
+	}
+	if (!j) return;
+
+	Gfx_Stats.drawCalls++;
+	_glMultiDrawElements(GL_TRIANGLES, counts, GL_UNSIGNED_SHORT, offsets, j);
+}
 #endif
@@ -186,6 +186,7 @@ GfxResourceID Gfx_AllocTexture(struct Bitmap* bmp, int rowWidth, cc_uint8 flags,
 
 void Gfx_BindTexture(GfxResourceID texId) {
 	CCTexture* tex = (CCTexture*)texId;
+	GFX_STATS_BIND();
 	GLuint glID = tex ? tex->textureID : 0;
 	//Platform_Log1("BIND: %i", &glID);
 	
@@ -222,6 +223,7 @@ void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, i
 
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	CCTexture* tex = (CCTexture*)(*texId);
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	if (!tex) return;
 	
 	glDeleteTextures(1, &tex->textureID);
@@ -383,6 +385,7 @@ void Gfx_BindVb(GfxResourceID vb) {
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	GfxResourceID data = *vb;
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (!data) return;
 
 	VB_ClearCache(data);
@@ -392,6 +395,7 @@ void Gfx_DeleteVb(GfxResourceID* vb) {
 }
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	vb_size = count * strideSizes[fmt];
 	return ((struct VertexBuffer*)vb)->vertices;
 }
@@ -512,10 +516,12 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 }
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
 	rspq_block_t* block = VB_GetCached(gfx_vb, startVertex, verticesCount);
+	GFX_STATS_DRAW(verticesCount);
 
 	if (block) {
 		rspq_block_run(block);
@@ -527,6 +533,7 @@ void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
 	rspq_block_t* block = VB_GetCached(gfx_vb, 0, verticesCount);
+	GFX_STATS_DRAW(verticesCount);
 
 	if (block) {
 		rspq_block_run(block);
@@ -537,6 +544,7 @@ void Gfx_DrawVb_IndexedTris(int verticesCount) {
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	if (depthOnlyRendering) return;
 	rspq_block_t* block = VB_GetCached(gfx_vb, startVertex, verticesCount);
 
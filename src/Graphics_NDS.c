@@ -133,6 +133,7 @@ GfxResourceID Gfx_AllocTexture(struct Bitmap* bmp, int rowWidth, cc_uint8 flags,
 }
 
 void Gfx_BindTexture(GfxResourceID texId) {
+    GFX_STATS_BIND();
     glBindTexture(0, (int)texId);
 
 	tex_width  = 0;
@@ -166,6 +167,7 @@ void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, i
 
 void Gfx_DeleteTexture(GfxResourceID* texId) {
     int texture = (int)(*texId);
+    Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
     if (texture) glDeleteTextures(1, &texture);
     *texId = 0;
 }
@@ -326,11 +328,13 @@ void Gfx_BindVb(GfxResourceID vb) { gfx_vertices = vb; }
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	GfxResourceID data = *vb;
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (data) Mem_Free(data);
 	*vb = 0;
 }
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+    GFX_STATS_LOCK(fmt, count);
     buf_fmt   = fmt;
     buf_count = count;
 	return vb;
@@ -465,6 +469,7 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 }
 
 
@@ -508,6 +513,7 @@ static void Draw_TexturedTriangles(int verticesCount, int startVertex) {
 }
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	if (gfx_format == VERTEX_FORMAT_TEXTURED) {
 		Draw_TexturedTriangles(verticesCount, startVertex);
 	} else {
@@ -516,6 +522,7 @@ void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	if (gfx_format == VERTEX_FORMAT_TEXTURED) {
 		Draw_TexturedTriangles(verticesCount, 0);
 	} else {
@@ -524,6 +531,7 @@ void Gfx_DrawVb_IndexedTris(int verticesCount) {
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	if (skipRendering) return;
 	Draw_TexturedTriangles(verticesCount, startVertex);
 }
@@ -284,12 +284,14 @@ GfxResourceID Gfx_AllocTexture(struct Bitmap* bmp, int rowWidth, cc_uint8 flags,
 }
 
 void Gfx_BindTexture(GfxResourceID texId) {
+	GFX_STATS_BIND();
 	if (!texId) texId = white_square;
 	curTex = (GPUTexture*)texId;
 }
 		
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	GfxResourceID data = *texId;
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	if (!data) return;
 	GPUTexture* tex = (GPUTexture*)data;
 
@@ -475,11 +477,13 @@ void Gfx_BindVb(GfxResourceID vb) { gfx_vertices = vb; }
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	GfxResourceID data = *vb;
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (data) Mem_Free(data);
 	*vb = 0;
 }
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+    GFX_STATS_LOCK(fmt, count);
     buf_fmt   = fmt;
     buf_count = count;
 	return vb;
@@ -642,6 +646,7 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 
 }
 
@@ -941,14 +946,17 @@ static void DrawQuads(int verticesCount, int startVertex) {
 
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	DrawQuads(verticesCount, startVertex);
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	DrawQuads(verticesCount, 0);
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	DrawTexturedQuads3D(verticesCount, startVertex);
 }
 
@@ -191,6 +191,7 @@ static void UpdateTextureBuffer(int context, texbuffer_t *texture, CCTexture* te
 }
 
 void Gfx_BindTexture(GfxResourceID texId) {
+	GFX_STATS_BIND();
 	if (!texId) texId = white_square;
 	CCTexture* tex = (CCTexture*)texId;
 	
@@ -222,6 +223,7 @@ void Gfx_BindTexture(GfxResourceID texId) {
 		
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	GfxResourceID data = *texId;
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	if (data) Mem_Free(data);
 	*texId = NULL;
 }
@@ -403,11 +405,13 @@ void Gfx_BindVb(GfxResourceID vb) { gfx_vertices = vb; }
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	GfxResourceID data = *vb;
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (data) Mem_Free(data);
 	*vb = 0;
 }
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+    GFX_STATS_LOCK(fmt, count);
     buf_fmt   = fmt;
     buf_count = count;
 	return vb;
@@ -453,10 +457,14 @@ void Gfx_LoadMatrix(MatrixType type, const struct Matrix* matrix) {
 	LoadMvpMatrix(&mvp);
 }
 
-void Gfx_LoadMVP(const struct Matrix* view, const struct Matrix* proj, struct Matrix* mvp) {
-	Gfx_LoadMatrix(MATRIX_VIEW, view);
-	Gfx_LoadMatrix(MATRIX_PROJ, proj);
-	Matrix_Mul(mvp, view, proj);
+void Gfx_LoadMVP(const struct Matrix* view, const struct Matrix* proj, struct Matrix* result) {
+	// Only combine and upload to VU0 once, instead of once per matrix
+	_view = *view;
+	_proj = *proj;
+
+	Matrix_Mul(&mvp, &_view, &_proj);
+	LoadMvpMatrix(&mvp);
+	*result = mvp;
 }
 
 void Gfx_EnableTextureOffset(float x, float y) {
@@ -711,21 +719,25 @@ static void SetPrimitiveType(int type) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	//SetPrimitiveType(PRIM_LINE);
 } /* TODO */
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	//SetPrimitiveType(PRIM_TRIANGLE);
 	DrawTriangles(verticesCount, startVertex);
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	//SetPrimitiveType(PRIM_TRIANGLE);
 	DrawTriangles(verticesCount, 0);
 	// TODO
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	//SetPrimitiveType(PRIM_TRIANGLE);
 	DrawTriangles(verticesCount, startVertex);
 	// TODO
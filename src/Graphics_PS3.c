@@ -538,11 +538,13 @@ void Gfx_BindVb(GfxResourceID vb) {
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	GfxResourceID data = *vb;/* TODO */
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (data) rsxFree(data);
 	*vb = 0;
 }
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	vb_size = count * strideSizes[fmt];
 	return vb;
 }
@@ -560,6 +562,7 @@ static GfxResourceID Gfx_AllocDynamicVb(VertexFormat fmt, int maxVertices) {
 void Gfx_BindDynamicVb(GfxResourceID vb) { Gfx_BindVb(vb); }
 
 void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	vb_size = count * strideSizes[fmt];
 	return vb;
 }
@@ -594,6 +597,7 @@ GfxResourceID Gfx_AllocTexture(struct Bitmap* bmp, int rowWidth, cc_uint8 flags,
 
 void Gfx_BindTexture(GfxResourceID texId) {
 	CCTexture* tex = (CCTexture*)texId;
+	GFX_STATS_BIND();
 	if (!tex) tex  = white_square; 
 	/* TODO */
 	
@@ -631,6 +635,7 @@ void Gfx_BindTexture(GfxResourceID texId) {
 
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	GfxResourceID data = *texId;
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	if (data) rsxFree(data);
 	*texId = NULL;
 }
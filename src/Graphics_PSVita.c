@@ -707,6 +707,7 @@ void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, i
 }
 
 void Gfx_DeleteTexture(GfxResourceID* texId) {
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	GPUTexture_Unref(texId);
 }
 
@@ -714,6 +715,7 @@ void Gfx_EnableMipmaps(void) { }
 void Gfx_DisableMipmaps(void) { }
 
 void Gfx_BindTexture(GfxResourceID texId) {
+	GFX_STATS_BIND();
 	if (!texId) texId = white_square;
  
  	struct GPUTexture* tex = (struct GPUTexture*)texId;
@@ -926,10 +928,14 @@ void Gfx_BindVb(GfxResourceID vb) {
 	sceGxmSetVertexStream(gxm_context, 0, buffer->data);
 }
 
-void Gfx_DeleteVb(GfxResourceID* vb) { GPUBuffer_Unref(vb); }
+void Gfx_DeleteVb(GfxResourceID* vb) {
+	Mem_Untrack(MEM_TRACK_VB, *vb);
+	GPUBuffer_Unref(vb);
+}
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
 	struct GPUBuffer* buffer = (struct GPUBuffer*)vb;
+	GFX_STATS_LOCK(fmt, count);
 	return buffer->data;
 }
 
@@ -944,6 +950,7 @@ void Gfx_BindDynamicVb(GfxResourceID vb) { Gfx_BindVb(vb); }
 
 void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
 	struct GPUBuffer* buffer = (struct GPUBuffer*)vb;
+	GFX_STATS_LOCK(fmt, count);
 	return buffer->data;
 }
 
@@ -1076,11 +1083,13 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+ GFX_STATS_DRAW(verticesCount);
  // TODO
 }
 
 // TODO probably wrong to offset index buffer
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	//Platform_Log2("DRAW1: %i, %i", &verticesCount, &startVertex); Thread_Sleep(100);
 	sceGxmDraw(gxm_context, SCE_GXM_PRIMITIVE_TRIANGLES,
 			SCE_GXM_INDEX_FORMAT_U16, gfx_indices + ICOUNT(startVertex), ICOUNT(verticesCount));
@@ -1088,6 +1097,7 @@ void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
 
 // TODO probably wrong to offset index buffer
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	//Platform_Log1("DRAW2: %i", &verticesCount); Thread_Sleep(100);
 	sceGxmDraw(gxm_context, SCE_GXM_PRIMITIVE_TRIANGLES,
 			SCE_GXM_INDEX_FORMAT_U16, gfx_indices, ICOUNT(verticesCount));
@@ -1095,6 +1105,7 @@ void Gfx_DrawVb_IndexedTris(int verticesCount) {
 
 // TODO probably wrong to offset index buffer
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	//Platform_Log2("DRAW3: %i, %i", &verticesCount, &startVertex); Thread_Sleep(100);
 	sceGxmDraw(gxm_context, SCE_GXM_PRIMITIVE_TRIANGLES,
 			SCE_GXM_INDEX_FORMAT_U16, gfx_indices + ICOUNT(startVertex), ICOUNT(verticesCount));
@@ -158,6 +158,7 @@ GfxResourceID Gfx_AllocTexture(struct Bitmap* bmp, int rowWidth, cc_uint8 flags,
 }
 
 void Gfx_BindTexture(GfxResourceID texId) {
+	GFX_STATS_BIND();
 	if (!texId) texId = white_square;
 	CCTexture* tex = (CCTexture*)texId;
 
@@ -168,6 +169,7 @@ void Gfx_BindTexture(GfxResourceID texId) {
 
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	CCTexture* tex = *texId;
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	// TODO properly free vram
 	if (tex) {
 		// This is mainly to avoid leak with text in top left
@@ -315,11 +317,13 @@ void Gfx_BindVb(GfxResourceID vb) { gfx_vertices = vb; }
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	GfxResourceID data = *vb;
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (data) Mem_Free(data);
 	*vb = 0;
 }
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+    GFX_STATS_LOCK(fmt, count);
     buf_fmt   = fmt;
     buf_count = count;
 	return vb;
@@ -452,6 +456,7 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 
 }
 
@@ -591,6 +596,7 @@ static void DrawTexturedQuads3D(int verticesCount, int startVertex) {
 }
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	if (gfx_rendering2D) {
 		if (gfx_format == VERTEX_FORMAT_TEXTURED) {
 			DrawTexturedQuads2D(verticesCount, startVertex);
@@ -611,6 +617,7 @@ void Gfx_DrawVb_IndexedTris(int verticesCount) {
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	DrawTexturedQuads3D(verticesCount, startVertex);
 }
 
@@ -3,6 +3,7 @@
 #include "_GraphicsBase.h"
 #include "Errors.h"
 #include "Window.h"
+#include "Event.h"
 
 static cc_bool faceCulling;
 static int fb_width, fb_height; 
@@ -20,8 +21,18 @@ static cc_bool depthTest  = true;
 static cc_bool depthWrite = true;
 static int db_stride;
 
+// Farthest depth in each 4x4 block of the depth buffer, used to reject occluded blocks early
+#define HIZ_SHIFT 2
+#define HIZ_SIZE  (1 << HIZ_SHIFT)
+static float* hizBuffer;
+static int hiz_stride, hiz_size;
+
 static void* gfx_vertices;
 static GfxResourceID white_square;
+static void InitDamageTracking(void);
+static void FlushTriangles(void);
+static void AllocTileBuffers(void);
+static void FreeTileBuffers(void);
 
 void Gfx_RestoreState(void) {
 	InitDefaultResources();
@@ -50,18 +61,23 @@ void Gfx_Create(void) {
 	Gfx.Created      = true;
 	Gfx.BackendType  = CC_GFX_BACKEND_SOFTGPU;
 	
+	InitDamageTracking();
 	Gfx_RestoreState();
 }
 
 static void DestroyBuffers(void) {
+	FlushTriangles();
 	Window_FreeFramebuffer(&fb_bmp);
 	Mem_Free(depthBuffer);
 	depthBuffer = NULL;
+	Mem_Free(hizBuffer);
+	hizBuffer   = NULL;
 }
 
 void Gfx_Free(void) { 
 	Gfx_FreeState();
 	DestroyBuffers();
+	FreeTileBuffers();
 }
 
 
@@ -70,12 +86,37 @@ typedef struct CCTexture {
 	BitmapCol pixels[];
 } CCTexture;
 
+// Textures whose dimensions are multiples of 4 are stored as 4x4 tiles of texels (i.e. 64 bytes per tile),
+//  so that sampling down or across a rotated face touches far fewer cache lines than with row-major order
+#define Texture_IsTiled(width, height) ((((width) | (height)) & 3) == 0)
+#define Texture_TiledIndex(x, y, width) (((y) & ~3) * (width) + (((x) & ~3) << 2) + (((y) & 3) << 2) + ((x) & 3))
+
+static CC_INLINE BitmapCol Texture_Sample(const BitmapCol* pixels, int x, int y, int width, cc_bool tiled) {
+	return tiled ? pixels[Texture_TiledIndex(x, y, width)] : pixels[y * width + x];
+}
+
+static void CopyTextureTiled(CCTexture* tex, int x, int y, const struct Bitmap* src, int rowWidth) {
+	BitmapCol* dst = tex->pixels;
+	int xx, yy;
+
+	for (yy = 0; yy < src->height; yy++)
+	{
+		const BitmapCol* row = src->scan0 + yy * rowWidth;
+		for (xx = 0; xx < src->width; xx++)
+		{
+			dst[Texture_TiledIndex(x + xx, y + yy, tex->width)] = row[xx];
+		}
+	}
+}
+
 static CCTexture* curTexture;
 static BitmapCol* curTexPixels;
 static int curTexWidth, curTexHeight;
 static int texWidthMask, texHeightMask;
+static cc_bool curTexTiled;
 		
 void Gfx_BindTexture(GfxResourceID texId) {
+	GFX_STATS_BIND();
 	if (!texId) texId = white_square;
 	CCTexture* tex = texId;
 
@@ -83,6 +124,7 @@ void Gfx_BindTexture(GfxResourceID texId) {
 	curTexPixels = tex->pixels;
 	curTexWidth  = tex->width;
 	curTexHeight = tex->height;
+	curTexTiled  = Texture_IsTiled(tex->width, tex->height);
 
 	texWidthMask  = (1 << Math_ilog2(tex->width))  - 1;
 	texHeightMask = (1 << Math_ilog2(tex->height)) - 1;
@@ -90,7 +132,11 @@ void Gfx_BindTexture(GfxResourceID texId) {
 		
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	GfxResourceID data = *texId;
-	if (data) Mem_Free(data);
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
+	if (!data) return;
+
+	FlushTriangles(); /* queued triangles might still be using the texture */
+	Mem_Free(data);
 	*texId = NULL;
 }
 		
@@ -99,8 +145,13 @@ GfxResourceID Gfx_AllocTexture(struct Bitmap* bmp, int rowWidth, cc_uint8 flags,
 
 	tex->width  = bmp->width;
 	tex->height = bmp->height;
-	CopyTextureData(tex->pixels, bmp->width * BITMAPCOLOR_SIZE,
-					bmp, rowWidth * BITMAPCOLOR_SIZE);
+
+	if (Texture_IsTiled(bmp->width, bmp->height)) {
+		CopyTextureTiled(tex, 0, 0, bmp, rowWidth);
+	} else {
+		CopyTextureData(tex->pixels, bmp->width * BITMAPCOLOR_SIZE,
+						bmp, rowWidth * BITMAPCOLOR_SIZE);
+	}
 	return tex;
 }
 
@@ -108,8 +159,13 @@ void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, i
 	CCTexture* tex = (CCTexture*)texId;
 	BitmapCol* dst = (tex->pixels + x) + y * tex->width;
 
-	CopyTextureData(dst, tex->width * BITMAPCOLOR_SIZE,
-					part, rowWidth  * BITMAPCOLOR_SIZE);
+	FlushTriangles();
+	if (Texture_IsTiled(tex->width, tex->height)) {
+		CopyTextureTiled(tex, x, y, part, rowWidth);
+	} else {
+		CopyTextureData(dst, tex->width * BITMAPCOLOR_SIZE,
+						part, rowWidth  * BITMAPCOLOR_SIZE);
+	}
 }
 
 void Gfx_EnableMipmaps(void)  { }
@@ -159,10 +215,12 @@ static void ClearDepthBuffer(void) {
 #ifndef SOFTGPU_DISABLE_ZBUFFER
 	int i, size = fb_width * fb_height;
 	for (i = 0; i < size; i++) depthBuffer[i] = 100000000.0f;
+	for (i = 0; i < hiz_size; i++) hizBuffer[i] = 100000000.0f;
 #endif
 }
 
 void Gfx_ClearBuffers(GfxBuffers buffers) {
+	FlushTriangles();
 	if (buffers & GFX_BUFFER_COLOR) ClearColorBuffer();
 	if (buffers & GFX_BUFFER_DEPTH) ClearDepthBuffer();
 }
@@ -215,11 +273,13 @@ void Gfx_BindVb(GfxResourceID vb) { gfx_vertices = vb; }
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	GfxResourceID data = *vb;
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (data) Mem_Free(data);
 	*vb = 0;
 }
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	return vb;
 }
 
@@ -235,6 +295,7 @@ static GfxResourceID Gfx_AllocDynamicVb(VertexFormat fmt, int maxVertices) {
 void Gfx_BindDynamicVb(GfxResourceID vb) { Gfx_BindVb(vb); }
 
 void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
 	return vb; 
 }
 
@@ -343,12 +404,8 @@ static void TransformVertex2D(int index, Vertex* vertex) {
 static int TransformVertex3D(int index, Vertex* vertex) {
 	// TODO: avoid the multiply, just add down in DrawTriangles
 	char* ptr = (char*)gfx_vertices + index * gfx_stride;
-	Vector3* pos = (Vector3*)ptr;
-
-	vertex->x = pos->x * _mvp.row1.x + pos->y * _mvp.row2.x + pos->z * _mvp.row3.x + _mvp.row4.x;
-	vertex->y = pos->x * _mvp.row1.y + pos->y * _mvp.row2.y + pos->z * _mvp.row3.y + _mvp.row4.y;
-	vertex->z = pos->x * _mvp.row1.z + pos->y * _mvp.row2.z + pos->z * _mvp.row3.z + _mvp.row4.z;
-	vertex->w = pos->x * _mvp.row1.w + pos->y * _mvp.row2.w + pos->z * _mvp.row3.w + _mvp.row4.w;
+	// x/y/z/w are stored consecutively in Vertex, so can be transformed all at once
+	Vec3_Transform4((struct Vec4*)&vertex->x, (Vec3*)ptr, &_mvp);
 
 	if (gfx_format != VERTEX_FORMAT_TEXTURED) {
 		struct VertexColoured* v = (struct VertexColoured*)ptr;
@@ -438,9 +495,7 @@ static void DrawTriangle2D(Vertex* V0, Vertex* V1, Vertex* V2) {
 				float v = ic0 * v0 + ic1 * v1 + ic2 * v2;
 				int texX = ((int)u) & texWidthMask;
 				int texY = ((int)v) & texHeightMask;
-				int texIndex = texY * curTexWidth + texX;
-
-				BitmapCol tColor = curTexPixels[texIndex];
+				BitmapCol tColor = Texture_Sample(curTexPixels, texX, texY, curTexWidth, curTexTiled);
 				int a1 = PackedCol_A(color), a2 = BitmapCol_A(tColor);
 				A = ( a1 * a2 ) >> 8;
 				int r1 = PackedCol_R(color), r2 = BitmapCol_R(tColor);
@@ -475,124 +530,559 @@ static void DrawTriangle2D(Vertex* V0, Vertex* V1, Vertex* V2) {
 	}
 }
 
-static void DrawTriangle3D(Vertex* V0, Vertex* V1, Vertex* V2) {
+// Render state captured when a triangle is submitted, as rasterisation may be deferred
+#define TRI_TEXTURED    0x01
+#define TRI_DEPTH_TEST  0x02
+#define TRI_DEPTH_WRITE 0x04
+#define TRI_COL_WRITE   0x08
+#define TRI_ALPHA_TEST  0x10
+#define TRI_ALPHA_BLEND 0x20
+#define TRI_FIXED_POINT 0x40
+#define TRI_TEX_TILED   0x80
+
+typedef struct Triangle3D_ {
+	Vertex v0, v1, v2;
+	int minX, minY, maxX, maxY;
+	float minZ; // nearest depth of any pixel in the triangle
+	BitmapCol* texPixels;
+	int texWidth, texHeight, texWidthMask, texHeightMask;
+	int flags;
+} Triangle3D;
+
+#ifndef SOFTGPU_DISABLE_ZBUFFER
+static float CalcBlockFarthestDepth(int bx, int by) {
+	int endX = min(bx + HIZ_SIZE, fb_width);
+	int endY = min(by + HIZ_SIZE, fb_height);
+	float farZ = depthBuffer[by * db_stride + bx];
+
+	for (int y = by; y < endY; y++)
+		for (int x = bx; x < endX; x++)
+	{
+		farZ = max(farZ, depthBuffer[y * db_stride + x]);
+	}
+	return farZ;
+}
+#endif
+
+// Writes the colour of a pixel, returning false if the pixel was discarded
+static CC_INLINE cc_bool ShadePixel3D(int flags, PackedCol color, BitmapCol tColor, int cb_index) {
+	int R, G, B, A;
+	if (flags & TRI_TEXTURED) {
+		int a1 = PackedCol_A(color), a2 = BitmapCol_A(tColor);
+		A = ( a1 * a2 ) >> 8;
+		int r1 = PackedCol_R(color), r2 = BitmapCol_R(tColor);
+		R = ( r1 * r2 ) >> 8;
+		int g1 = PackedCol_G(color), g2 = BitmapCol_G(tColor);
+		G = ( g1 * g2 ) >> 8;
+		int b1 = PackedCol_B(color), b2 = BitmapCol_B(tColor);
+		B = ( b1 * b2 ) >> 8;
+	} else {
+		R = PackedCol_R(color);
+		G = PackedCol_G(color);
+		B = PackedCol_B(color);
+		A = PackedCol_A(color);
+	}
+
+	if ((flags & TRI_ALPHA_TEST) && A < 0x80) return false;
+	
+	if (flags & TRI_ALPHA_BLEND) {
+		BitmapCol dst = colorBuffer[cb_index];
+		int dstR = BitmapCol_R(dst);
+		int dstG = BitmapCol_G(dst);
+		int dstB = BitmapCol_B(dst);
+
+		R = (R * A + dstR * (255 - A)) >> 8;
+		G = (G * A + dstG * (255 - A)) >> 8;
+		B = (B * A + dstB * (255 - A)) >> 8;
+	}
+
+	colorBuffer[cb_index] = BitmapCol_Make(R, G, B, 0xFF);
+	return true;
+}
+
+#ifdef SOFTGPU_FIXED_TEXTURING
+// Fixed point rasteriser, where inside tests use integer edge functions and texture coordinates are only
+//  perspective corrected at the ends of each row of a 4x4 block, then interpolated in 16.16 fixed point
+// This is mainly intended for devices with no or slow FPUs, at the cost of some texturing accuracy
+#define FIXED_SHIFT 16
+#define FIXED_ONE   (1 << FIXED_SHIFT)
+// Larger vertex coordinates may overflow the integer edge functions
+#define FIXED_COORD_LIMIT 8192
+
+static void RasteriseTriangle3D_Fixed(const Triangle3D* tri, int minX, int minY, int maxX, int maxY) {
+	const Vertex* V0 = &tri->v0;
+	const Vertex* V1 = &tri->v1;
+	const Vertex* V2 = &tri->v2;
 	int x0 = (int)V0->x, y0 = (int)V0->y;
 	int x1 = (int)V1->x, y1 = (int)V1->y;
 	int x2 = (int)V2->x, y2 = (int)V2->y;
-	int minX = min(x0, min(x1, x2));
-	int minY = min(y0, min(y1, y2));
-	int maxX = max(x0, max(x1, x2));
-	int maxY = max(y0, max(y1, y2));
 
+	// Flip edge functions for counter clockwise triangles, so inside is always >= 0
 	int area = edgeFunction(x0,y0, x1,y1, x2,y2);
-	if (faceCulling) {
-		// https://gamedev.stackexchange.com/questions/203694/how-to-make-backface-culling-work-correctly-in-both-orthographic-and-perspective
-		if (area < 0) return;
+	int sign = area < 0 ? -1 : 1;
+	// Edge functions below are doubled so pixel centres can be evaluated in integers
+	float factor = 1.0f / (2 * area * sign);
+	float w0 = V0->w, w1 = V1->w, w2 = V2->w;
+
+	float z0 = V0->z, z1 = V1->z, z2 = V2->z;
+	float u0 = V0->u, u1 = V1->u, u2 = V2->u;
+	float v0 = V0->v, v1 = V1->v, v2 = V2->v;
+	PackedCol color = V0->c;
+	int flags       = tri->flags;
+	
+	BitmapCol* texPixels = tri->texPixels;
+	int texWidth  = tri->texWidth,     texHeight  = tri->texHeight;
+	int widthMask = tri->texWidthMask, heightMask = tri->texHeightMask;
+
+	int dx01 = 2 * sign * (y0 - y1), dy01 = 2 * sign * (x1 - x0);
+	int dx12 = 2 * sign * (y1 - y2), dy12 = 2 * sign * (x2 - x1);
+	int dx20 = 2 * sign * (y2 - y0), dy20 = 2 * sign * (x0 - x2);
+
+	int bc0_origin = sign * ((x2 - x1) * (2 * minY + 1 - 2 * y1) - (y2 - y1) * (2 * minX + 1 - 2 * x1));
+	int bc1_origin = sign * ((x0 - x2) * (2 * minY + 1 - 2 * y2) - (y0 - y2) * (2 * minX + 1 - 2 * x2));
+	int bc2_origin = sign * ((x1 - x0) * (2 * minY + 1 - 2 * y0) - (y1 - y0) * (2 * minX + 1 - 2 * x0));
+
+	for (int by = minY & ~(HIZ_SIZE - 1); by <= maxY; by += HIZ_SIZE)
+	{
+		int begY = max(by, minY), endY = min(by + HIZ_SIZE - 1, maxY);
+
+		for (int bx = minX & ~(HIZ_SIZE - 1); bx <= maxX; bx += HIZ_SIZE)
+		{
+			int begX = max(bx, minX), endX = min(bx + HIZ_SIZE - 1, maxX);
+#ifndef SOFTGPU_DISABLE_ZBUFFER
+			float* hiz = &hizBuffer[(by >> HIZ_SHIFT) * hiz_stride + (bx >> HIZ_SHIFT)];
+			if ((flags & TRI_DEPTH_TEST) && tri->minZ > *hiz) continue;
+			cc_bool wroteDepth = false;
+#endif
+			int ox = begX - minX, oy = begY - minY;
+			int ex = endX - begX, ey = endY - begY;
+
+			int bc0 = bc0_origin + ox * dx12 + oy * dy12;
+			int bc1 = bc1_origin + ox * dx20 + oy * dy20;
+			int bc2 = bc2_origin + ox * dx01 + oy * dy01;
+
+			// Skip block when all 4 corners are outside the same edge
+			if (bc0 < 0 && bc0 + ex * dx12 < 0 && bc0 + ey * dy12 < 0 && bc0 + ex * dx12 + ey * dy12 < 0) continue;
+			if (bc1 < 0 && bc1 + ex * dx20 < 0 && bc1 + ey * dy20 < 0 && bc1 + ex * dx20 + ey * dy20 < 0) continue;
+			if (bc2 < 0 && bc2 + ex * dx01 < 0 && bc2 + ey * dy01 < 0 && bc2 + ex * dx01 + ey * dy01 < 0) continue;
+
+			for (int y = begY; y <= endY; y++, bc0 += dy12, bc1 += dy20, bc2 += dy01)
+			{
+				// Perspective correct attributes at both ends of the row
+				float ic0 = bc0 * factor, ic1 = bc1 * factor, ic2 = bc2 * factor;
+				float w   = 1 / (ic0 * w0 + ic1 * w1 + ic2 * w2);
+				float zS  = (ic0 * z0 + ic1 * z1 + ic2 * z2) * w;
+				float uS  = (ic0 * u0 + ic1 * u1 + ic2 * u2) * w;
+				float vS  = (ic0 * v0 + ic1 * v1 + ic2 * v2) * w;
+
+				ic0 = (bc0 + ex * dx12) * factor; ic1 = (bc1 + ex * dx20) * factor; ic2 = (bc2 + ex * dx01) * factor;
+				w   = 1 / (ic0 * w0 + ic1 * w1 + ic2 * w2);
+				float zE = (ic0 * z0 + ic1 * z1 + ic2 * z2) * w;
+				float uE = (ic0 * u0 + ic1 * u1 + ic2 * u2) * w;
+				float vE = (ic0 * v0 + ic1 * v1 + ic2 * v2) * w;
+
+				// Interpolate affinely in between
+				float baseU = (float)FastFloor(uS), baseV = (float)FastFloor(vS);
+				int uF  = (int)((uS - baseU) * texWidth  * FIXED_ONE);
+				int vF  = (int)((vS - baseV) * texHeight * FIXED_ONE);
+				int duF = ex ? ((int)((uE - baseU) * texWidth  * FIXED_ONE) - uF) / ex : 0;
+				int dvF = ex ? ((int)((vE - baseV) * texHeight * FIXED_ONE) - vF) / ex : 0;
+				float z = zS, dz = ex ? (zE - zS) / ex : 0;
+
+				int e0 = bc0, e1 = bc1, e2 = bc2;
+				for (int x = begX; x <= endX; x++, e0 += dx12, e1 += dx20, e2 += dx01, uF += duF, vF += dvF, z += dz)
+				{
+					if ((e0 | e1 | e2) < 0) continue;
+					int db_index = y * db_stride + x;
+
+#ifndef SOFTGPU_DISABLE_ZBUFFER
+					if ((flags & TRI_DEPTH_TEST) && (z < 0 || z > depthBuffer[db_index])) continue;
+					if (!(flags & TRI_COL_WRITE)) {
+						if (flags & TRI_DEPTH_WRITE) { depthBuffer[db_index] = z; wroteDepth = true; }
+						continue;
+					}
+#else
+					if (!(flags & TRI_COL_WRITE)) continue;
+#endif
+
+					BitmapCol tColor = 0;
+					if (flags & TRI_TEXTURED) {
+						int texX = (uF >> FIXED_SHIFT) & widthMask;
+						int texY = (vF >> FIXED_SHIFT) & heightMask;
+						tColor   = Texture_Sample(texPixels, texX, texY, texWidth, flags & TRI_TEX_TILED);
+					}
+					if (!ShadePixel3D(flags, color, tColor, y * cb_stride + x)) continue;
+
+#ifndef SOFTGPU_DISABLE_ZBUFFER
+					if (flags & TRI_DEPTH_WRITE) { depthBuffer[db_index] = z; wroteDepth = true; }
+#endif
+				}
+			}
+#ifndef SOFTGPU_DISABLE_ZBUFFER
+			if (wroteDepth) *hiz = CalcBlockFarthestDepth(bx, by);
+#endif
+		}
 	}
+}
+#endif
 
-	// Reject triangles completely outside
-	if (maxX < 0 || minX > fb_maxX) return;
-	if (maxY < 0 || minY > fb_maxY) return;
+// Rasterises the portion of the triangle inside the given rectangle
+// Edge functions are first evaluated at the corners of each 4x4 block of pixels,
+//  so that blocks completely outside the triangle can be skipped entirely
+static void RasteriseTriangle3D(const Triangle3D* tri, int rectMinX, int rectMinY, int rectMaxX, int rectMaxY) {
+	const Vertex* V0 = &tri->v0;
+	const Vertex* V1 = &tri->v1;
+	const Vertex* V2 = &tri->v2;
+	int x0 = (int)V0->x, y0 = (int)V0->y;
+	int x1 = (int)V1->x, y1 = (int)V1->y;
+	int x2 = (int)V2->x, y2 = (int)V2->y;
 
-	// Perform scissoring
-	minX = max(minX, 0); maxX = min(maxX, fb_maxX);
-	minY = max(minY, 0); maxY = min(maxY, fb_maxY);
+	int minX = max(tri->minX, rectMinX), maxX = min(tri->maxX, rectMaxX);
+	int minY = max(tri->minY, rectMinY), maxY = min(tri->maxY, rectMaxY);
+	if (minX > maxX || minY > maxY) return;
+#ifdef SOFTGPU_FIXED_TEXTURING
+	if (tri->flags & TRI_FIXED_POINT) { RasteriseTriangle3D_Fixed(tri, minX, minY, maxX, maxY); return; }
+#endif
 
+	// Flip edge functions for counter clockwise triangles, so inside is always >= 0
+	int area   = edgeFunction(x0,y0, x1,y1, x2,y2);
+	float sign = area < 0 ? -1.0f : 1.0f;
 	// NOTE: W in frag variables below is actually 1/W 
-	float factor = 1.0f / area;
+	float factor = sign / area;
 	float w0 = V0->w, w1 = V1->w, w2 = V2->w;
-	
-	// TODO proper clipping
-	if (w0 <= 0 || w1 <= 0 || w2 <= 0) {
-		return;
-	}
 
 	float z0 = V0->z, z1 = V1->z, z2 = V2->z;
 	float u0 = V0->u, u1 = V1->u, u2 = V2->u;
 	float v0 = V0->v, v1 = V1->v, v2 = V2->v;
 	PackedCol color = V0->c;
+	int flags       = tri->flags;
+	
+	BitmapCol* texPixels = tri->texPixels;
+	int texWidth  = tri->texWidth,     texHeight     = tri->texHeight;
+	int widthMask = tri->texWidthMask, heightMask    = tri->texHeightMask;
 	
 	// https://fgiesen.wordpress.com/2013/02/10/optimizing-the-basic-rasterizer/
 	// Essentially these are the deltas of edge functions between X/Y and X/Y + 1 (i.e. one X/Y step)
-	int dx01  = y0 - y1, dy01 = x1 - x0;
-	int dx12  = y1 - y2, dy12 = x2 - x1;
-	int dx20  = y2 - y0, dy20 = x0 - x2;
+	float dx01 = sign * (y0 - y1), dy01 = sign * (x1 - x0);
+	float dx12 = sign * (y1 - y2), dy12 = sign * (x2 - x1);
+	float dx20 = sign * (y2 - y0), dy20 = sign * (x0 - x2);
 
-	float bc0_start = edgeFunction(x1,y1, x2,y2, minX+0.5f,minY+0.5f);
-	float bc1_start = edgeFunction(x2,y2, x0,y0, minX+0.5f,minY+0.5f);
-	float bc2_start = edgeFunction(x0,y0, x1,y1, minX+0.5f,minY+0.5f);
+	float bc0_origin = sign * edgeFunction(x1,y1, x2,y2, minX+0.5f,minY+0.5f);
+	float bc1_origin = sign * edgeFunction(x2,y2, x0,y0, minX+0.5f,minY+0.5f);
+	float bc2_origin = sign * edgeFunction(x0,y0, x1,y1, minX+0.5f,minY+0.5f);
 
-	for (int y = minY; y <= maxY; y++, bc0_start += dy12, bc1_start += dy20, bc2_start += dy01) 
+	// Blocks are aligned to the hierarchical depth buffer's 4x4 blocks
+	for (int by = minY & ~(HIZ_SIZE - 1); by <= maxY; by += HIZ_SIZE)
 	{
-		float bc0 = bc0_start;
-		float bc1 = bc1_start;
-		float bc2 = bc2_start;
+		int begY = max(by, minY), endY = min(by + HIZ_SIZE - 1, maxY);
 
-		for (int x = minX; x <= maxX; x++, bc0 += dx12, bc1 += dx20, bc2 += dx01) 
+		for (int bx = minX & ~(HIZ_SIZE - 1); bx <= maxX; bx += HIZ_SIZE)
 		{
-			float ic0 = bc0 * factor;
-			float ic1 = bc1 * factor;
-			float ic2 = bc2 * factor;
-			if (ic0 < 0 || ic1 < 0 || ic2 < 0) continue;
-			int db_index = y * db_stride + x;
+			int begX = max(bx, minX), endX = min(bx + HIZ_SIZE - 1, maxX);
+#ifndef SOFTGPU_DISABLE_ZBUFFER
+			// Skip block when the whole triangle is behind everything already drawn there
+			float* hiz = &hizBuffer[(by >> HIZ_SHIFT) * hiz_stride + (bx >> HIZ_SHIFT)];
+			if ((flags & TRI_DEPTH_TEST) && tri->minZ > *hiz) continue;
+#endif
+			float ox = (float)(begX - minX), oy = (float)(begY - minY);
+			float ex = (float)(endX - begX), ey = (float)(endY - begY);
+#ifndef SOFTGPU_DISABLE_ZBUFFER
+			cc_bool wroteDepth = false;
+#endif
+
+			float bc0 = bc0_origin + ox * dx12 + oy * dy12;
+			float bc1 = bc1_origin + ox * dx20 + oy * dy20;
+			float bc2 = bc2_origin + ox * dx01 + oy * dy01;
+
+			// Skip block when all 4 corners are outside the same edge
+			if (bc0 < 0 && bc0 + ex * dx12 < 0 && bc0 + ey * dy12 < 0 && bc0 + ex * dx12 + ey * dy12 < 0) continue;
+			if (bc1 < 0 && bc1 + ex * dx20 < 0 && bc1 + ey * dy20 < 0 && bc1 + ex * dx20 + ey * dy20 < 0) continue;
+			if (bc2 < 0 && bc2 + ex * dx01 < 0 && bc2 + ey * dy01 < 0 && bc2 + ex * dx01 + ey * dy01 < 0) continue;
+
+			for (int y = begY; y <= endY; y++, bc0 += dy12, bc1 += dy20, bc2 += dy01)
+			{
+				float ic0_row = bc0, ic1_row = bc1, ic2_row = bc2;
 
-			float w = 1 / (ic0 * w0 + ic1 * w1 + ic2 * w2);
-			float z = (ic0 * z0 + ic1 * z1 + ic2 * z2) * w;
+				for (int x = begX; x <= endX; x++, ic0_row += dx12, ic1_row += dx20, ic2_row += dx01)
+				{
+					float ic0 = ic0_row * factor;
+					float ic1 = ic1_row * factor;
+					float ic2 = ic2_row * factor;
+					if (ic0 < 0 || ic1 < 0 || ic2 < 0) continue;
+					int db_index = y * db_stride + x;
+
+					float w = 1 / (ic0 * w0 + ic1 * w1 + ic2 * w2);
+					float z = (ic0 * z0 + ic1 * z1 + ic2 * z2) * w;
 
 #ifndef SOFTGPU_DISABLE_ZBUFFER
-			if (depthTest && (z < 0 || z > depthBuffer[db_index])) continue;
-			if (!colWrite) {
-				if (depthWrite) depthBuffer[db_index] = z;
-				continue;
-			}
+					if ((flags & TRI_DEPTH_TEST) && (z < 0 || z > depthBuffer[db_index])) continue;
+					if (!(flags & TRI_COL_WRITE)) {
+						if (flags & TRI_DEPTH_WRITE) { depthBuffer[db_index] = z; wroteDepth = true; }
+						continue;
+					}
 #else
-			if (!colWrite) continue;
+					if (!(flags & TRI_COL_WRITE)) continue;
 #endif
 
-			int R, G, B, A;
-			if (gfx_format == VERTEX_FORMAT_TEXTURED) {
-				float u = (ic0 * u0 + ic1 * u1 + ic2 * u2) * w;
-				float v = (ic0 * v0 + ic1 * v1 + ic2 * v2) * w;
-				int texX = ((int)(Math_AbsF(u - FastFloor(u)) * curTexWidth )) & texWidthMask;
-				int texY = ((int)(Math_AbsF(v - FastFloor(v)) * curTexHeight)) & texHeightMask;
-				int texIndex = texY * curTexWidth + texX;
+					BitmapCol tColor = 0;
+					if (flags & TRI_TEXTURED) {
+						float u = (ic0 * u0 + ic1 * u1 + ic2 * u2) * w;
+						float v = (ic0 * v0 + ic1 * v1 + ic2 * v2) * w;
+						int texX = ((int)(Math_AbsF(u - FastFloor(u)) * texWidth )) & widthMask;
+						int texY = ((int)(Math_AbsF(v - FastFloor(v)) * texHeight)) & heightMask;
+						tColor   = Texture_Sample(texPixels, texX, texY, texWidth, flags & TRI_TEX_TILED);
+					}
+					if (!ShadePixel3D(flags, color, tColor, y * cb_stride + x)) continue;
 
-				BitmapCol tColor = curTexPixels[texIndex];
-				int a1 = PackedCol_A(color), a2 = BitmapCol_A(tColor);
-				A = ( a1 * a2 ) >> 8;
-				int r1 = PackedCol_R(color), r2 = BitmapCol_R(tColor);
-				R = ( r1 * r2 ) >> 8;
-				int g1 = PackedCol_G(color), g2 = BitmapCol_G(tColor);
-				G = ( g1 * g2 ) >> 8;
-				int b1 = PackedCol_B(color), b2 = BitmapCol_B(tColor);
-				B = ( b1 * b2 ) >> 8;
-			} else {
-				R = PackedCol_R(color);
-				G = PackedCol_G(color);
-				B = PackedCol_B(color);
-				A = PackedCol_A(color);
+#ifndef SOFTGPU_DISABLE_ZBUFFER
+					if (flags & TRI_DEPTH_WRITE) { depthBuffer[db_index] = z; wroteDepth = true; }
+#endif
+				}
 			}
+#ifndef SOFTGPU_DISABLE_ZBUFFER
+			if (wroteDepth) *hiz = CalcBlockFarthestDepth(bx, by);
+#endif
+		}
+	}
+}
 
-			if (gfx_alphaTest && A < 0x80) continue;
-			int cb_index = y * cb_stride + x;
-			
-			if (gfx_alphaBlend) {
-				BitmapCol dst = colorBuffer[cb_index];
-				int dstR = BitmapCol_R(dst);
-				int dstG = BitmapCol_G(dst);
-				int dstB = BitmapCol_B(dst);
 
-				R = (R * A + dstR * (255 - A)) >> 8;
-				G = (G * A + dstG * (255 - A)) >> 8;
-				B = (B * A + dstB * (255 - A)) >> 8;
-			}
+/*########################################################################################################################*
+*-----------------------------------------------------Tiled rasteriser----------------------------------------------------*
+*#########################################################################################################################*/
+// 3D triangles are queued up and binned into screen tiles, which are then rasterised in parallel
+// Since each tile is only ever rasterised by one thread, in submission order, the results are
+//  identical to rasterising each triangle immediately
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_WEB && !defined CC_BUILD_LOWMEM && !defined CC_BUILD_CONSOLE
+#define SOFTGPU_TILED
+
+#define TILE_SHIFT 6
+#define TILE_SIZE  (1 << TILE_SHIFT)
+#define TRI_QUEUE_SIZE 16384
+#define RASTER_WORKERS 3
+
+static Triangle3D* tri_queue;
+static int tri_count;
+static int tilesX, tilesY;
+static int* tile_offsets; // start of each tile's list of triangles in tile_tris
+static int* tile_tris;
+static int tile_trisCapacity;
+
+static void* raster_threads[RASTER_WORKERS];
+static void* raster_start[RASTER_WORKERS];
+static void* raster_done[RASTER_WORKERS];
+static void* raster_mutex;
+static int raster_nextTile, raster_nextWorker;
+static volatile cc_bool raster_quit;
+
+static void RasteriseTiles(void) {
+	for (;;)
+	{
+		Mutex_Lock(raster_mutex);
+		int tile = raster_nextTile++;
+		Mutex_Unlock(raster_mutex);
+		if (tile >= tilesX * tilesY) return;
 
-#ifndef SOFTGPU_DISABLE_ZBUFFER
-			if (depthWrite) depthBuffer[db_index] = z;
-#endif
-			colorBuffer[cb_index] = BitmapCol_Make(R, G, B, 0xFF);
+		int minX = (tile % tilesX) << TILE_SHIFT;
+		int minY = (tile / tilesX) << TILE_SHIFT;
+		int maxX = minX + TILE_SIZE - 1;
+		int maxY = minY + TILE_SIZE - 1;
+
+		for (int i = tile_offsets[tile]; i < tile_offsets[tile + 1]; i++)
+		{
+			RasteriseTriangle3D(&tri_queue[tile_tris[i]], minX, minY, maxX, maxY);
+		}
+	}
+}
+
+static void RasterWorker(void) {
+	Mutex_Lock(raster_mutex);
+	int id = raster_nextWorker++;
+	Mutex_Unlock(raster_mutex);
+
+	for (;;)
+	{
+		Waitable_Wait(raster_start[id]);
+		if (raster_quit) return;
+
+		RasteriseTiles();
+		Waitable_Signal(raster_done[id]);
+	}
+}
+
+static void StartRasterWorkers(void) {
+	raster_mutex = Mutex_Create("Raster tiles");
+	raster_quit  = false;
+
+	for (int i = 0; i < RASTER_WORKERS; i++)
+	{
+		raster_start[i] = Waitable_Create("Raster start");
+		raster_done[i]  = Waitable_Create("Raster done");
+		Thread_Run(&raster_threads[i], RasterWorker, 64 * 1024, "Rasteriser");
+	}
+}
+
+static void StopRasterWorkers(void) {
+	if (!raster_mutex) return;
+	raster_quit = true;
+
+	for (int i = 0; i < RASTER_WORKERS; i++) 
+	{
+		Waitable_Signal(raster_start[i]);
+		Thread_Join(raster_threads[i]);
+		Waitable_Free(raster_start[i]);
+		Waitable_Free(raster_done[i]);
+	}
+	Mutex_Free(raster_mutex);
+	raster_mutex = NULL;
+}
+
+static void BinTriangles(void) {
+	int numTiles = tilesX * tilesY, total = 0;
+	Mem_Set(tile_offsets, 0, (numTiles + 1) * sizeof(int));
+
+	// Count how many triangles overlap each tile
+	for (int i = 0; i < tri_count; i++)
+	{
+		Triangle3D* t = &tri_queue[i];
+		for (int ty = t->minY >> TILE_SHIFT; ty <= (t->maxY >> TILE_SHIFT); ty++)
+			for (int tx = t->minX >> TILE_SHIFT; tx <= (t->maxX >> TILE_SHIFT); tx++)
+		{
+			tile_offsets[ty * tilesX + tx + 1]++;
+		}
+	}
+
+	for (int i = 1; i <= numTiles; i++) 
+	{
+		total += tile_offsets[i];
+		tile_offsets[i] = total;
+	}
+
+	if (total > tile_trisCapacity) {
+		Mem_Free(tile_tris);
+		tile_trisCapacity = total + total / 2;
+		tile_tris         = (int*)Mem_Alloc(tile_trisCapacity, sizeof(int), "tile triangles");
+	}
+
+	// Fill in each tile's list of triangles, preserving submission order
+	for (int i = 0; i < tri_count; i++)
+	{
+		Triangle3D* t = &tri_queue[i];
+		for (int ty = t->minY >> TILE_SHIFT; ty <= (t->maxY >> TILE_SHIFT); ty++)
+			for (int tx = t->minX >> TILE_SHIFT; tx <= (t->maxX >> TILE_SHIFT); tx++)
+		{
+			tile_tris[tile_offsets[ty * tilesX + tx]++] = i;
 		}
 	}
+
+	// Offsets now point at the end of each tile's list, shift them back to the start
+	for (int i = numTiles; i > 0; i--) tile_offsets[i] = tile_offsets[i - 1];
+	tile_offsets[0] = 0;
+}
+
+static void FlushTriangles(void) {
+	if (!tri_count) return;
+	if (!raster_mutex) StartRasterWorkers();
+
+	BinTriangles();
+	raster_nextTile = 0;
+	for (int i = 0; i < RASTER_WORKERS; i++) Waitable_Signal(raster_start[i]);
+
+	// Main thread also rasterises tiles
+	RasteriseTiles();
+	for (int i = 0; i < RASTER_WORKERS; i++) Waitable_Wait(raster_done[i]);
+	tri_count = 0;
+}
+
+static void AllocTileBuffers(void) {
+	tilesX = (fb_width  + TILE_SIZE - 1) >> TILE_SHIFT;
+	tilesY = (fb_height + TILE_SIZE - 1) >> TILE_SHIFT;
+
+	Mem_Free(tile_offsets);
+	tile_offsets = (int*)Mem_Alloc(tilesX * tilesY + 1, sizeof(int), "tile offsets");
+	if (!tri_queue) tri_queue = (Triangle3D*)Mem_Alloc(TRI_QUEUE_SIZE, sizeof(Triangle3D), "triangle queue");
+}
+
+static void FreeTileBuffers(void) {
+	StopRasterWorkers();
+	Mem_Free(tri_queue);    tri_queue    = NULL;
+	Mem_Free(tile_offsets); tile_offsets = NULL;
+	Mem_Free(tile_tris);    tile_tris    = NULL;
+	tile_trisCapacity = 0;
+	tri_count = 0;
+}
+
+static Triangle3D* AllocTriangle(void) {
+	if (tri_count == TRI_QUEUE_SIZE) FlushTriangles();
+	return &tri_queue[tri_count++];
+}
+#else
+static Triangle3D tri_single;
+static void FlushTriangles(void)   { }
+static void AllocTileBuffers(void) { }
+static void FreeTileBuffers(void)  { }
+
+static Triangle3D* AllocTriangle(void) { return &tri_single; }
+#endif
+
+static void DrawTriangle3D(Vertex* V0, Vertex* V1, Vertex* V2) {
+	int x0 = (int)V0->x, y0 = (int)V0->y;
+	int x1 = (int)V1->x, y1 = (int)V1->y;
+	int x2 = (int)V2->x, y2 = (int)V2->y;
+	int minX = min(x0, min(x1, x2));
+	int minY = min(y0, min(y1, y2));
+	int maxX = max(x0, max(x1, x2));
+	int maxY = max(y0, max(y1, y2));
+
+	int area = edgeFunction(x0,y0, x1,y1, x2,y2);
+	if (faceCulling) {
+		// https://gamedev.stackexchange.com/questions/203694/how-to-make-backface-culling-work-correctly-in-both-orthographic-and-perspective
+		if (area < 0) return;
+	}
+	if (area == 0) return;
+
+	// Reject triangles completely outside
+	if (maxX < 0 || minX > fb_maxX) return;
+	if (maxY < 0 || minY > fb_maxY) return;
+	
+	// TODO proper clipping
+	if (V0->w <= 0 || V1->w <= 0 || V2->w <= 0) {
+		return;
+	}
+
+	Triangle3D* tri = AllocTriangle();
+	tri->v0 = *V0; tri->v1 = *V1; tri->v2 = *V2;
+
+	// Perform scissoring
+	tri->minX = max(minX, 0); tri->maxX = min(maxX, fb_maxX);
+	tri->minY = max(minY, 0); tri->maxY = min(maxY, fb_maxY);
+	tri->minZ = min(V0->z / V0->w, min(V1->z / V1->w, V2->z / V2->w));
+
+	tri->texPixels     = curTexPixels;
+	tri->texWidth      = curTexWidth;
+	tri->texHeight     = curTexHeight;
+	tri->texWidthMask  = texWidthMask;
+	tri->texHeightMask = texHeightMask;
+
+	tri->flags = 0;
+	if (gfx_format == VERTEX_FORMAT_TEXTURED) tri->flags |= TRI_TEXTURED;
+	if (curTexTiled)    tri->flags |= TRI_TEX_TILED;
+	if (depthTest)      tri->flags |= TRI_DEPTH_TEST;
+	if (depthWrite)     tri->flags |= TRI_DEPTH_WRITE;
+	if (colWrite)       tri->flags |= TRI_COL_WRITE;
+	if (gfx_alphaTest)  tri->flags |= TRI_ALPHA_TEST;
+	if (gfx_alphaBlend) tri->flags |= TRI_ALPHA_BLEND;
+
+#ifdef SOFTGPU_FIXED_TEXTURING
+	if (max(Math_AbsI(x0), max(Math_AbsI(x1), Math_AbsI(x2))) < FIXED_COORD_LIMIT &&
+		max(Math_AbsI(y0), max(Math_AbsI(y1), Math_AbsI(y2))) < FIXED_COORD_LIMIT) {
+		tri->flags |= TRI_FIXED_POINT;
+	}
+#endif
+
+#ifndef SOFTGPU_TILED
+	RasteriseTriangle3D(tri, tri->minX, tri->minY, tri->maxX, tri->maxY);
+#endif
 }
 
 #define V0_VIS (1 << 0)
@@ -863,6 +1353,7 @@ void DrawQuads(int startVertex, int verticesCount) {
 	int j = startVertex;
 
 	if (gfx_rendering2D) {
+		FlushTriangles();
 		// 4 vertices = 1 quad = 2 triangles
 		for (int i = 0; i < verticesCount / 4; i++, j += 4)
 		{
@@ -910,14 +1401,17 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 void Gfx_DrawVb_Lines(int verticesCount) { } /* TODO */
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	DrawQuads(startVertex, verticesCount);
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	DrawQuads(0, verticesCount);
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	DrawQuads(startVertex, verticesCount);
 }
 
@@ -932,6 +1426,7 @@ static BitmapCol* CB_GetRow(struct Bitmap* bmp, int y, void* ctx) {
 cc_result Gfx_TakeScreenshot(struct Stream* output) {
 	struct Bitmap bmp;
 	Bitmap_Init(bmp, fb_width, fb_height, NULL);
+	FlushTriangles();
 	return Png_Encode(&bmp, output, CB_GetRow, false, NULL);
 }
 
@@ -940,16 +1435,71 @@ cc_bool Gfx_GetUIOptions(struct MenuOptionsScreen* s) { return false; }
 
 void Gfx_BeginFrame(void) { }
 
+
+/*########################################################################################################################*
+*-----------------------------------------------------Damage tracking-----------------------------------------------------*
+*#########################################################################################################################*/
+// Window backends which retain previously presented contents, so only rows that changed need presenting
+// (presenting can be very slow, e.g. for terminal output or QuickDraw on classic Mac OS)
+#if CC_WIN_BACKEND == CC_WIN_BACKEND_TERMINAL || CC_WIN_BACKEND == CC_WIN_BACKEND_X11 || CC_WIN_BACKEND == CC_WIN_BACKEND_WIN32 || \
+	CC_WIN_BACKEND == CC_WIN_BACKEND_SDL2 || CC_WIN_BACKEND == CC_WIN_BACKEND_SDL3 || defined CC_BUILD_MACCLASSIC
+static cc_uint32* row_hashes;
+static cc_bool fb_invalidated = true;
+
+static void AllocRowHashes(void) {
+	Mem_Free(row_hashes);
+	row_hashes     = (cc_uint32*)Mem_Alloc(fb_height, 4, "row hashes");
+	fb_invalidated = true;
+}
+
+static void OnRedrawNeeded(void* obj) { fb_invalidated = true; }
+static void InitDamageTracking(void) {
+	Event_Register_(&WindowEvents.RedrawNeeded, NULL, OnRedrawNeeded);
+}
+
+static cc_uint32 HashRow(const BitmapCol* row, int width) {
+	cc_uint32 hash = 2166136261U;
+	for (int x = 0; x < width; x++) hash = (hash ^ row[x]) * 16777619U;
+	return hash;
+}
+
+void Gfx_EndFrame(void) {
+	int minY = fb_height, maxY = -1;
+	FlushTriangles();
+
+	for (int y = 0; y < fb_height; y++)
+	{
+		cc_uint32 hash = HashRow(colorBuffer + y * cb_stride, fb_width);
+		if (!fb_invalidated && row_hashes[y] == hash) continue;
+
+		row_hashes[y] = hash;
+		minY = min(minY, y);
+		maxY = y;
+	}
+	fb_invalidated = false;
+	// Nothing changed since last frame was presented
+	if (maxY < minY) return;
+
+	Rect2D r = { 0, minY, fb_width, maxY - minY + 1 };
+	Window_DrawFramebuffer(r, &fb_bmp);
+}
+#else
+static void AllocRowHashes(void)     { }
+static void InitDamageTracking(void) { }
+
 void Gfx_EndFrame(void) {
 	Rect2D r = { 0, 0, fb_width, fb_height };
+	FlushTriangles();
 	Window_DrawFramebuffer(r, &fb_bmp);
 }
+#endif
 
 void Gfx_SetVSync(cc_bool vsync) {
 	gfx_vsync = vsync;
 }
 
 void Gfx_OnWindowResize(void) {
+	FlushTriangles();
 	if (depthBuffer) DestroyBuffers();
 
 	fb_width   = Game.Width;
@@ -958,10 +1508,16 @@ void Gfx_OnWindowResize(void) {
 	Window_AllocFramebuffer(&fb_bmp, Game.Width, Game.Height);
 	colorBuffer = fb_bmp.scan0;
 	cb_stride   = fb_bmp.width;
+	AllocRowHashes();
+	AllocTileBuffers();
 
 #ifndef SOFTGPU_DISABLE_ZBUFFER
 	depthBuffer = Mem_Alloc(fb_width * fb_height, 4, "depth buffer");
 	db_stride   = fb_width;
+
+	hiz_stride = (fb_width + HIZ_SIZE - 1) >> HIZ_SHIFT;
+	hiz_size   = hiz_stride * ((fb_height + HIZ_SIZE - 1) >> HIZ_SHIFT);
+	hizBuffer  = Mem_Alloc(hiz_size, 4, "hi-z buffer");
 #endif
 
 	Gfx_SetViewport(0, 0, Game.Width, Game.Height);
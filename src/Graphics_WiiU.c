@@ -120,6 +120,7 @@ void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, i
 }
 
 void Gfx_BindTexture(GfxResourceID texId) {
+	GFX_STATS_BIND();
 	if (!texId) texId = white_square;
 	pendingTex = (GX2Texture*)texId;
 	// Texture is bound to active shader, so might need to defer it in
@@ -136,6 +137,7 @@ static void BindPendingTexture(void) {
 }
 
 void Gfx_DeleteTexture(GfxResourceID* texId) {
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	if (*texId == pendingTex) pendingTex = NULL;
 	// TODO free memory ???
 }
@@ -261,6 +263,7 @@ static GfxResourceID Gfx_AllocStaticVb(VertexFormat fmt, int count) {
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	GX2RBuffer* buf = *vb;
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (!buf) return;
 	
 	GX2RDestroyBufferEx(buf, 0);
@@ -276,6 +279,7 @@ void Gfx_BindVb(GfxResourceID vb) {
 
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
 	GX2RBuffer* buf = (GX2RBuffer*)vb;
+	GFX_STATS_LOCK(fmt, count);
 	return GX2RLockBufferEx(buf, 0);
 }
 
@@ -318,21 +322,25 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	BindPendingTexture();
 	GX2DrawEx(GX2_PRIMITIVE_MODE_LINES, verticesCount, 0, 1);
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	BindPendingTexture();
 	GX2DrawEx(GX2_PRIMITIVE_MODE_QUADS, verticesCount, 0, 1);
 }
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	BindPendingTexture();
 	GX2DrawEx(GX2_PRIMITIVE_MODE_QUADS, verticesCount, startVertex, 1);
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	BindPendingTexture();
 	GX2DrawEx(GX2_PRIMITIVE_MODE_QUADS, verticesCount, startVertex, 1);
 }
@@ -235,6 +235,7 @@ void Gfx_UpdateTexture(GfxResourceID texId, int originX, int originY, struct Bit
 
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	CCTexture* tex = (CCTexture*)(*texId);
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	if (!tex) return;
 
 	MmFreeContiguousMemory(tex->pixels);
@@ -247,6 +248,7 @@ void Gfx_DisableMipmaps(void) { }
 
 void Gfx_BindTexture(GfxResourceID texId) {
 	CCTexture* tex = (CCTexture*)texId;
+	GFX_STATS_BIND();
 	if (!tex) tex  = white_square;
 	
 	unsigned log_u = Math_ilog2(tex->width);
@@ -439,9 +441,15 @@ void Gfx_BindVb(GfxResourceID vb) {
 	pb_end(p);
 }
 
-void Gfx_DeleteVb(GfxResourceID* vb) { FreeBuffer(vb); }
+void Gfx_DeleteVb(GfxResourceID* vb) {
+	Mem_Untrack(MEM_TRACK_VB, *vb);
+	FreeBuffer(vb);
+}
 
-void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) { return vb; }
+void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	GFX_STATS_LOCK(fmt, count);
+	return vb;
+}
 
 void Gfx_UnlockVb(GfxResourceID vb) { }
 
@@ -453,6 +461,7 @@ static GfxResourceID Gfx_AllocDynamicVb(VertexFormat fmt, int maxVertices) {
 void Gfx_BindDynamicVb(GfxResourceID vb) { Gfx_BindVb(vb); }
 
 void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) { 
+	GFX_STATS_LOCK(fmt, count);
 	return vb;
 }
 
@@ -680,6 +689,7 @@ static void DrawArrays(int mode, int start, int count) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	DrawArrays(NV097_SET_BEGIN_END_OP_LINES, 0, verticesCount);
 }
 
@@ -688,14 +698,17 @@ static void DrawIndexedVertices(int verticesCount, int startVertex) {
 }
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	DrawIndexedVertices(verticesCount, startVertex);
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	DrawIndexedVertices(verticesCount, 0);
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	DrawIndexedVertices(verticesCount, startVertex);
 }
 #endif
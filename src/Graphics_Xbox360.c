@@ -115,11 +115,13 @@ void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, i
 
 void Gfx_BindTexture(GfxResourceID texId) {
 	struct XenosSurface* xtex = (struct XenosSurface*)texId;
+	GFX_STATS_BIND();
 	Xe_SetTexture(xe, 0, xtex);
 }
 
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	struct XenosSurface* xtex = (struct XenosSurface*)(*texId);
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	if (xtex) Xe_DestroyTexture(xe, xtex);
 	*texId = NULL;
 }
@@ -224,6 +226,7 @@ static GfxResourceID Gfx_AllocStaticVb(VertexFormat fmt, int count) {
 
 void Gfx_DeleteVb(GfxResourceID* vb) {
 	struct XenosVertexBuffer* xvb = (struct XenosVertexBuffer*)(*vb);
+	Mem_Untrack(MEM_TRACK_VB, *vb);
 	if (xvb) Xe_DestroyVertexBuffer(xe, xvb);
 	*vb = NULL;
 }
@@ -236,6 +239,7 @@ void Gfx_BindVb(GfxResourceID vb) {
 void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
 	struct XenosVertexBuffer* xvb = (struct XenosVertexBuffer*)vb;
 	int size = count * strideSizes[fmt];
+	GFX_STATS_LOCK(fmt, count);
 	return Xe_VB_Lock(xe, xvb, 0, size, XE_LOCK_WRITE);
 }
 
@@ -283,21 +287,25 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	Platform_Log1("DRAW_LINES: %i", &verticesCount);
 	Xe_DrawPrimitive(xe, XE_PRIMTYPE_LINELIST, 0, verticesCount >> 1);
 }
 
 void Gfx_DrawVb_IndexedTris(int verticesCount) {
+	GFX_STATS_DRAW(verticesCount);
 	Platform_Log1("DRAW_TRIS: %i", &verticesCount);
 	Xe_DrawPrimitive(xe, XE_PRIMTYPE_QUADLIST, 0, verticesCount >> 2);
 }
 
 void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	Platform_Log1("DRAW_TRIS_RANGE: %i", &verticesCount);
 	Xe_DrawPrimitive(xe, XE_PRIMTYPE_QUADLIST, startVertex, verticesCount >> 2);
 }
 
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
+	GFX_STATS_DRAW(verticesCount);
 	Platform_Log1("DRAW_TRIS_MAP: %i", &verticesCount);
 	Xe_DrawPrimitive(xe, XE_PRIMTYPE_QUADLIST, startVertex, verticesCount >> 2);
 }
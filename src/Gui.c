@@ -429,6 +429,40 @@ void TextAtlas_AddInt(struct TextAtlas* atlas, int value, struct VertexTextured*
 	}
 }
 
+void TextAtlas_MakeGlyphs(struct TextAtlas* atlas, struct FontDesc* font) {
+	char glyphsBuffer[TEXTATLAS_NUM_GLYPHS];
+	cc_string glyphs = String_FromArray(glyphsBuffer);
+	int i;
+
+	for (i = 0; i < TEXTATLAS_NUM_GLYPHS; i++) 
+	{
+		String_Append(&glyphs, (char)(TEXTATLAS_FIRST_GLYPH + i));
+	}
+	TextAtlas_Make(atlas, &glyphs, font, &String_Empty);
+}
+
+static int TextAtlas_GlyphIndex(char c) {
+	int i = (cc_uint8)c - TEXTATLAS_FIRST_GLYPH;
+	return i >= 0 && i < TEXTATLAS_NUM_GLYPHS ? i : '?' - TEXTATLAS_FIRST_GLYPH;
+}
+
+int TextAtlas_TextWidth(struct TextAtlas* atlas, const cc_string* text) {
+	int i, width = 0;
+	for (i = 0; i < text->length; i++) 
+	{
+		width += atlas->widths[TextAtlas_GlyphIndex(text->buffer[i])];
+	}
+	return width;
+}
+
+void TextAtlas_AddString(struct TextAtlas* atlas, const cc_string* text, struct VertexTextured** vertices) {
+	int i;
+	for (i = 0; i < text->length; i++) 
+	{
+		TextAtlas_Add(atlas, TextAtlas_GlyphIndex(text->buffer[i]), vertices);
+	}
+}
+
 
 /*########################################################################################################################*
 *-------------------------------------------------------Widget base-------------------------------------------------------*
@@ -489,6 +523,62 @@ void Widget_SetDisabled(void* widget, int disabled) {
 /*########################################################################################################################*
 *-------------------------------------------------------Screen base-------------------------------------------------------*
 *#########################################################################################################################*/
+/* Deferred quads drawn from a screen's vertex buffer */
+struct GuiDrawCmd { GfxResourceID tex; int count, offset; };
+#define GUI_MAX_DRAW_CMDS 256
+static struct GuiDrawCmd gui_cmds[GUI_MAX_DRAW_CMDS];
+static int gui_cmdsCount;
+static GfxResourceID gui_batchVb;
+
+void Gui_DrawQuads(GfxResourceID tex, int count, int offset) {
+	struct GuiDrawCmd* cmd;
+	if (!gui_batchVb) {
+		Gfx_BindTexture(tex);
+		Gfx_DrawVb_IndexedTris_Range(count, offset);
+		return;
+	}
+
+	if (gui_cmdsCount == GUI_MAX_DRAW_CMDS) Gui_FlushQuads();
+	cmd = &gui_cmds[gui_cmdsCount++];
+	cmd->tex    = tex;
+	cmd->count  = count;
+	cmd->offset = offset;
+}
+
+void Gui_FlushQuads(void) {
+	GfxResourceID tex;
+	int i, j, count, offset;
+	if (!gui_cmdsCount) return;
+
+	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+	Gfx_BindDynamicVb(gui_batchVb);
+
+	/* Draw all quads using the same texture together, merging adjacent ranges */
+	for (i = 0; i < gui_cmdsCount; i++)
+	{
+		if (!gui_cmds[i].count) continue;
+		tex    = gui_cmds[i].tex;
+		count  = gui_cmds[i].count;
+		offset = gui_cmds[i].offset;
+		Gfx_BindTexture(tex);
+
+		for (j = i + 1; j < gui_cmdsCount; j++)
+		{
+			if (!gui_cmds[j].count || gui_cmds[j].tex != tex) continue;
+
+			if (gui_cmds[j].offset != offset + count) {
+				Gfx_DrawVb_IndexedTris_Range(count, offset);
+				offset = gui_cmds[j].offset;
+				count  = 0;
+			}
+			count += gui_cmds[j].count;
+			gui_cmds[j].count = 0;
+		}
+		Gfx_DrawVb_IndexedTris_Range(count, offset);
+	}
+	gui_cmdsCount = 0;
+}
+
 void Screen_Render2Widgets(void* screen, float delta) {
 	struct Screen* s = (struct Screen*)screen;
 	struct Widget** widgets = s->widgets;
@@ -496,12 +586,16 @@ void Screen_Render2Widgets(void* screen, float delta) {
 
 	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
 	Gfx_BindDynamicVb(s->vb);
+	gui_batchVb = s->vb;
 
 	for (i = 0; i < s->numWidgets; i++) 
 	{
 		if (!widgets[i]) continue;
 		offset = Widget_Render2(widgets[i], offset);
 	}
+
+	Gui_FlushQuads();
+	gui_batchVb = NULL;
 }
 
 void Screen_UpdateVb(void* screen) {
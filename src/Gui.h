@@ -134,7 +134,14 @@ struct ScreenVTABLE {
 /* Represents a container of widgets and other 2D elements. May cover entire window. */
 struct Screen { Screen_Body };
 /* Calls Widget_Render2 on each widget in the screen. */
+/* NOTE: Quads drawn by widgets using Gui_DrawQuads are grouped by texture, in the order */
+/*  each texture was first used. Widgets should avoid overlapping earlier widgets for this reason. */
 void Screen_Render2Widgets(void* screen, float delta);
+/* Draws quads from the given range of the currently bound screen vertex buffer */
+/* NOTE: Draws are deferred when the screen's widgets are being batched */
+void Gui_DrawQuads(GfxResourceID tex, int count, int offset);
+/* Draws any deferred quads. Must be called by widgets before binding another vertex buffer. */
+void Gui_FlushQuads(void);
 void Screen_UpdateVb(void* screen);
 struct VertexTextured* Screen_LockVb(void* screen);
 int Screen_DoPointerDown(void* screen, int id, int x, int y);
@@ -242,6 +249,7 @@ enum GuiPriority {
 	GUI_PRIORITY_INVENTORY  = 20,
 	GUI_PRIORITY_TABLIST    = 17,
 	GUI_PRIORITY_CHAT       = 15,
+	GUI_PRIORITY_PROFILER   = 12,
 	GUI_PRIORITY_HUD        = 10,
 	GUI_PRIORITY_LOADING    =  5
 };
@@ -285,7 +293,10 @@ void Gui_RefreshAll(void);
 void Gui_Refresh(struct Screen* s);
 void Gui_RenderGui(float delta);
 
-#define TEXTATLAS_MAX_WIDTHS 16
+#define TEXTATLAS_MAX_WIDTHS 96
+/* Glyph atlases contain every printable ASCII character, from ' ' to '~' */
+#define TEXTATLAS_FIRST_GLYPH ' '
+#define TEXTATLAS_NUM_GLYPHS  ('~' - ' ' + 1)
 struct TextAtlas {
 	struct Texture tex;
 	int offset, curX;
@@ -297,6 +308,13 @@ void TextAtlas_Make(struct TextAtlas* atlas, const cc_string* chars, struct Font
 void TextAtlas_Free(struct TextAtlas* atlas);
 void TextAtlas_Add(struct TextAtlas* atlas, int charI, struct VertexTextured** vertices);
 void TextAtlas_AddInt(struct TextAtlas* atlas, int value, struct VertexTextured** vertices);
+/* Rasterises every printable ASCII character once, so strings can be drawn without any texture uploads */
+void TextAtlas_MakeGlyphs(struct TextAtlas* atlas, struct FontDesc* font);
+/* Returns width of the given text when drawn using a glyph atlas */
+int  TextAtlas_TextWidth(struct TextAtlas* atlas, const cc_string* text);
+/* Adds a quad for each character in the given text using a glyph atlas */
+/* NOTE: Colour codes are not handled, and non ASCII characters are drawn as '?' */
+void TextAtlas_AddString(struct TextAtlas* atlas, const cc_string* text, struct VertexTextured** vertices);
 
 #define Elem_Render(elem, delta) (elem)->VTABLE->Render(elem, delta)
 #define Elem_Free(elem)          (elem)->VTABLE->Free(elem)
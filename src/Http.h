@@ -1,7 +1,7 @@
 #ifndef CC_HTTP_H
 #define CC_HTTP_H
 #include "Constants.h"
-#include "Core.h"
+#include "Bitmap.h"
 CC_BEGIN_HEADER
 
 /* 
@@ -16,6 +16,14 @@ struct StringsBuffer;
 #define URL_MAX_SIZE (STRING_SIZE * 2)
 #define HTTP_FLAG_PRIORITY 0x01
 #define HTTP_FLAG_NOCACHE  0x02
+/* Response is stored on disk, and later requests for the same URL revalidate it with a conditional GET */
+#define HTTP_FLAG_DISKCACHE 0x04
+/* Response data can be taken with Http_TakePartial while it is still being downloaded */
+#define HTTP_FLAG_STREAMING 0x08
+/* Response data is also decoded as a PNG image by the worker thread, instead of the main thread */
+#define HTTP_FLAG_DECODEPNG 0x10
+/* Partially downloaded data is kept on disk if the request fails, and later requests for the same URL resume from it */
+#define HTTP_FLAG_RESUMABLE 0x20
 
 extern struct IGameComponent Http_Component;
 
@@ -38,13 +46,23 @@ struct HttpRequest {
 	cc_uint8*   data; /* Contents of the response. (i.e. result data) */
 	cc_uint32   size; /* Size of the contents. */
 	cc_uint32 _capacity; /* (private) Maximum size of data buffer */
+	cc_uint32 _streamed; /* (private) Amount of data already taken by Http_TakePartial */
 	void* meta;          /* Pointer to backend specific data */
 	char* error;         /* Pointer to dynamically allocated error message */
+	struct Bitmap image; /* Image decoded from the contents (if HTTP_FLAG_DECODEPNG and success) */
+	cc_result imageResult; /* 0 if image was successfully decoded, otherwise PNG decoding error */
 
 	char lastModified[STRING_SIZE]; /* Time item cached at (if at all) */
 	char etag[STRING_SIZE];         /* ETag of cached item (if any) */
+	char _resumeTag[STRING_SIZE];   /* (private) ETag or Last-Modified of the partially downloaded data */
+	cc_uint32 _resumeFrom;          /* (private) Amount of data downloaded by an earlier request being resumed from */
+	cc_uint32 _rangeStart;          /* (private) Offset the data of a 206 Partial Content response starts at */
 	cc_uint8 requestType;           /* See the various REQUEST_TYPE_ */
 	cc_bool success;                /* Whether Result is 0, status is 200, and data is not NULL */
+	cc_bool _diskCached;            /* (private) Whether response is stored in the disk cache */
+	cc_bool _streaming;             /* (private) Whether data can currently be taken by Http_TakePartial */
+	cc_bool _decodePng;             /* (private) Whether contents still need to be decoded into image */
+	cc_bool _resumable;             /* (private) Whether partially downloaded data is kept for resuming later */
 	struct StringsBuffer* cookies;  /* Cookie list sent in requests. May be modified by the response. */
 };
 
@@ -79,6 +97,12 @@ cc_bool Http_DescribeError(cc_result res, cc_string* dst);
 /* NOTE: You MUST check Success for whether it completed successfully. */
 /* (Data may still be non NULL even on error, e.g. on a http 404 error) */
 cc_bool Http_GetResult(int reqID, struct HttpRequest* item);
+/* Takes the response data downloaded so far for a request made with HTTP_FLAG_STREAMING. */
+/* Returns the number of bytes taken, or 0 if no new data has been downloaded yet. */
+/* NOTE: You MUST Mem_Free the returned data. */
+/* NOTE: Data remaining once the request completes is instead returned by Http_GetResult. */
+/*   (Success is then true even if the remaining data is empty) */
+cc_uint32 Http_TakePartial(int reqID, cc_uint8** data);
 /* Retrieves information about the request currently being processed. */
 cc_bool Http_GetCurrent(int* reqID, int* progress);
 /* Retrieves information about the download progress of the given request. */
@@ -26,6 +26,27 @@ cc_bool Http_GetCurrent(int* reqID, int* progress) {
 	return 0;
 }
 
+cc_uint32 Http_TakePartial(int reqID, cc_uint8** data) {
+	struct HttpRequest* req;
+	cc_uint32 size;
+	int idx = RequestList_Find(&workingReqs, reqID);
+	*data   = NULL;
+
+	if (idx == -1) return 0;
+	req = &workingReqs.entries[idx];
+	/* Don't hand out the body of e.g. redirects or error pages */
+	if (!req->_streaming || req->statusCode != 200 || !req->size) return 0;
+
+	*data = req->data;
+	size  = req->size;
+	req->_streamed += size;
+
+	req->data      = NULL;
+	req->size      = 0;
+	req->_capacity = 0;
+	return size;
+}
+
 int Http_CheckProgress(int reqID) {
 	int idx = RequestList_Find(&workingReqs, reqID);
 	if (idx == -1) return HTTP_PROGRESS_NOT_WORKING_ON;
@@ -86,6 +107,99 @@ static void Http_StartNextDownload(void) {
 	}
 }
 
+/* Ensures data buffer has enough space left to append amount bytes */
+static cc_bool Http_BufferExpand(struct HttpRequest* req, cc_uint32 amount) {
+	cc_uint32 newSize = req->size + amount;
+	cc_uint8* ptr;
+	if (newSize <= req->_capacity) return true;
+
+	if (!req->_capacity) {
+		/* Allocate initial storage */
+		/* (streamed data is regularly taken, so don't allocate space for the entire response) */
+		req->_capacity = req->contentLength && !req->_streaming ? req->contentLength : 1;
+		req->_capacity = max(req->_capacity, newSize);
+
+		ptr = (cc_uint8*)Mem_TryAlloc(req->_capacity, 1);
+	} else {
+		/* Fetch provides data in small chunks, so grow geometrically to avoid many reallocations */
+		/* (Content-Length is the compressed size when the response is e.g. gzip encoded) */
+		req->_capacity = max(newSize, req->_capacity * 2);
+		ptr = (cc_uint8*)Mem_TryRealloc(req->data, req->_capacity, 1);
+	}
+
+	if (!ptr) return false;
+	req->data = ptr;
+	return true;
+}
+
+/* Whether the response has the same validators as the cached data that the request was made with */
+static cc_bool Http_IsUnmodified(struct HttpRequest* req, const char* etag, const char* lastModified) {
+	cc_string cur, value;
+
+	if (etag && req->etag[0]) {
+		cur   = String_FromRawArray(req->etag);
+		value = String_FromReadonly(etag);
+		return String_Equals(&cur, &value);
+	}
+	if (lastModified && req->lastModified[0]) {
+		cur   = String_FromRawArray(req->lastModified);
+		value = String_FromReadonly(lastModified);
+		return String_Equals(&cur, &value);
+	}
+	return false;
+}
+
+/* Called once the response headers have been received */
+/* Returns false if the response body should be skipped, as the cached data is still up to date */
+EMSCRIPTEN_KEEPALIVE cc_bool Http_OnResponseStart(int reqID, int status, int length, 
+												const char* etag, const char* lastModified) {
+	struct HttpRequest* req;
+	cc_string value;
+	int idx = RequestList_Find(&workingReqs, reqID);
+	if (idx == -1) return true;
+
+	req = &workingReqs.entries[idx];
+	req->statusCode    = status;
+	req->contentLength = length;
+	req->progress      = HTTP_PROGRESS_FETCHING_DATA;
+
+	/* Browsers send a CORS preflight request when If-None-Match or If-Modified-Since is set, */
+	/*  which many texture pack hosts don't support. So instead the validators of the response */
+	/*  itself are compared, and the body is left undownloaded if the cached data is still valid */
+	if (status == 200 && Http_IsUnmodified(req, etag, lastModified)) {
+		req->statusCode = 304; return false;
+	}
+
+	if (etag) {
+		value = String_FromReadonly(etag);
+		String_CopyToRawArray(req->etag, &value);
+	}
+	if (lastModified) {
+		value = String_FromReadonly(lastModified);
+		String_CopyToRawArray(req->lastModified, &value);
+	}
+	return true;
+}
+
+/* Returns where in the wasm heap the next len bytes of the response body should be copied to */
+/* This avoids needing a JS ArrayBuffer of the entire response, that then gets copied into the heap */
+EMSCRIPTEN_KEEPALIVE cc_uint8* Http_ReserveData(int reqID, int len) {
+	struct HttpRequest* req;
+	cc_uint8* dst;
+	int idx = RequestList_Find(&workingReqs, reqID);
+	if (idx == -1) return NULL;
+
+	req = &workingReqs.entries[idx];
+	if (!Http_BufferExpand(req, len)) {
+		req->result = ERR_OUT_OF_MEMORY; return NULL;
+	}
+
+	dst = req->data + req->size;
+	req->size += len;
+	if (req->contentLength) req->progress = min(100, (int)(100.0f * (req->size + req->_streamed) / req->contentLength));
+	return dst;
+}
+
 EMSCRIPTEN_KEEPALIVE void Http_OnUpdateProgress(int reqID, int read, int total) {
 	int idx = RequestList_Find(&workingReqs, reqID);
 	if (idx == -1 || !total) return;
@@ -103,13 +217,20 @@ EMSCRIPTEN_KEEPALIVE void Http_OnFinishedAsync(int reqID, void* data, int len, i
 		Platform_Log1("Ignoring invalid request (%i)", &reqID);
 	} else {
 		req = &workingReqs.entries[idx];
-		req->data          = data;
-		req->size          = len;
-		req->statusCode    = status;
-		req->contentLength = len;
+		req->statusCode = status;
+
+		/* data is NULL when the response was instead copied into the request through Http_ReserveData */
+		if (data) {
+			Mem_Free(req->data);
+			req->data          = data;
+			req->size          = len;
+			req->contentLength = len;
+		} else if (!req->contentLength) {
+			req->contentLength = req->size + req->_streamed;
+		}
 
 		/* Usually this happens when denied by CORS */
-		if (!status && !data) req->result = ERR_DOWNLOAD_INVALID;
+		if (!status && !req->result) req->result = ERR_DOWNLOAD_INVALID;
 
 		if (req->data) Platform_Log1("HTTP returned data: %i bytes", &req->size);
 		Http_FinishRequest(req);
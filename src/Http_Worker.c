@@ -1,6 +1,8 @@
 #include "Core.h"
 #ifndef CC_BUILD_WEB
 #include "_HttpBase.h"
+/* Protects the data of requests that can be taken with Http_TakePartial */
+static void* streamMutex;
 
 /* Ensures data buffer has enough space left to append amount bytes */
 static cc_bool Http_BufferExpand(struct HttpRequest* req, cc_uint32 amount) {
@@ -10,7 +12,8 @@ static cc_bool Http_BufferExpand(struct HttpRequest* req, cc_uint32 amount) {
 
 	if (!req->_capacity) {
 		/* Allocate initial storage */
-		req->_capacity = req->contentLength ? req->contentLength : 1;
+		/* (streamed data is regularly taken, so don't allocate space for the entire response) */
+		req->_capacity = req->contentLength && !req->_streaming ? req->contentLength : 1;
 		req->_capacity = max(req->_capacity, newSize);
 
 		ptr = (cc_uint8*)Mem_TryAlloc(req->_capacity, 1);
@@ -28,7 +31,30 @@ static cc_bool Http_BufferExpand(struct HttpRequest* req, cc_uint32 amount) {
 /* Increases size and updates current progress */
 static void Http_BufferExpanded(struct HttpRequest* req, cc_uint32 read) {
 	req->size += read;
-	if (req->contentLength) req->progress = (int)(100.0f * req->size / req->contentLength);
+	/* Compressed responses can decode to more data than Content-Length */
+	if (req->contentLength) req->progress = min(100, (int)(100.0f * (req->size + req->_streamed) / req->contentLength));
+}
+
+static void Http_LockData(struct HttpRequest* req) {
+	if (req->_streaming) Mutex_Lock(streamMutex);
+}
+static void Http_UnlockData(struct HttpRequest* req) {
+	if (req->_streaming) Mutex_Unlock(streamMutex);
+}
+
+/* Appends data to the end of the response data */
+static cc_bool Http_AppendData(struct HttpRequest* req, const void* data, cc_uint32 len) {
+	cc_bool ok;
+	Http_LockData(req);
+	{
+		ok = Http_BufferExpand(req, len);
+		if (ok) {
+			Mem_Copy(req->data + req->size, data, len);
+			Http_BufferExpanded(req, len);
+		}
+	}
+	Http_UnlockData(req);
+	return ok;
 }
 
 
@@ -55,6 +81,18 @@ static void Http_ParseContentLength(struct HttpRequest* req, const cc_string* va
 	req->contentLength = contentLen;
 }
 
+static void Http_ParseContentRange(struct HttpRequest* req, const cc_string* value) {
+	cc_string unit, range, start, end;
+	cc_uint64 offset;
+	/* Content-Range is: bytes 1000-1999/5000 */
+	String_UNSAFE_Separate(value, ' ', &unit, &range);
+	String_UNSAFE_Separate(&range, '-', &start, &end);
+
+	if (!String_CaselessEqualsConst(&unit, "bytes")) return;
+	if (!Convert_ParseUInt64(&start, &offset) || offset > Int32_MaxValue) return;
+	req->_rangeStart = (cc_uint32)offset;
+}
+
 /* Parses a HTTP header */
 static void Http_ParseHeader(struct HttpRequest* req, const cc_string* line) {
 	static const cc_string httpVersion = String_FromConst("HTTP");
@@ -79,6 +117,8 @@ static void Http_ParseHeader(struct HttpRequest* req, const cc_string* line) {
 		Http_ParseContentLength(req, &value);
 	} else if (String_CaselessEqualsConst(&name, "Last-Modified")) {
 		String_CopyToRawArray(req->lastModified, &value);
+	} else if (String_CaselessEqualsConst(&name, "Content-Range")) {
+		Http_ParseContentRange(req, &value);
 	} else if (req->cookies && String_CaselessEqualsConst(&name, "Set-Cookie")) {
 		Http_ParseCookie(req, &value);
 	}
@@ -90,9 +130,25 @@ static void Http_AddHeader(struct HttpRequest* req, const char* key, const cc_st
 /* Adds all the appropriate headers for a request. */
 static void Http_SetRequestHeaders(struct HttpRequest* req) {
 	static const cc_string contentType = String_FromConst("application/x-www-form-urlencoded");
+	static const cc_string identity    = String_FromConst("identity");
 	cc_string str, cookies; char cookiesBuffer[1024];
+	cc_string range; char rangeBuffer[32];
 	int i;
 
+	/* Offsets of the partially downloaded data are only meaningful for uncompressed responses */
+	if (req->_resumable) Http_AddHeader(req, "Accept-Encoding", &identity);
+	if (req->_resumeFrom) {
+		String_InitArray(range, rangeBuffer);
+		String_AppendConst(&range, "bytes=");
+		String_AppendUInt32(&range, req->_resumeFrom);
+		String_Append(&range, '-');
+		Http_AddHeader(req, "Range", &range);
+
+		/* Server sends the full data instead if it has changed since */
+		str = String_FromRawArray(req->_resumeTag);
+		Http_AddHeader(req, "If-Range", &str);
+	}
+
 	if (req->lastModified[0]) {
 		str = String_FromRawArray(req->lastModified);
 		Http_AddHeader(req, "If-Modified-Since", &str);
@@ -158,6 +214,7 @@ typedef int CURLcode;
 #define CURLOPT_HTTPGET        (0     + 80)
 #define CURLOPT_SSL_VERIFYHOST (0     + 81)
 #define CURLOPT_HTTP_VERSION   (0     + 84)
+#define CURLOPT_ACCEPT_ENCODING (10000 + 102)
 
 #define CURL_HTTP_VERSION_1_1   2L /* stick to HTTP 1.1 */
 
@@ -283,11 +340,8 @@ static size_t Http_ProcessHeader(char* buffer, size_t size, size_t nitems, void*
 static size_t Http_ProcessData(char *buffer, size_t size, size_t nitems, void* userdata) {
 	struct HttpRequest* req = (struct HttpRequest*)userdata;
 
-	int ok = Http_BufferExpand(req, nitems);
+	int ok = Http_AppendData(req, buffer, nitems);
 	if (!ok) Process_Abort("Out of memory for HTTP request");
-
-	Mem_Copy(&req->data[req->size], buffer, nitems);
-	Http_BufferExpanded(req, nitems);
 	return nitems;
 }
 
@@ -297,6 +351,8 @@ static void Http_SetCurlOpts(struct HttpRequest* req) {
 	_curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
 	_curl_easy_setopt(curl, CURLOPT_MAXREDIRS,      20L);
 	_curl_easy_setopt(curl, CURLOPT_HTTP_VERSION,   CURL_HTTP_VERSION_1_1);
+	/* Empty string = advertise and decode all compression methods curl was built with */
+	_curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, req->_resumable ? NULL : "");
 
 	_curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, Http_ProcessHeader);
 	_curl_easy_setopt(curl, CURLOPT_HEADERDATA,     req);
@@ -365,6 +421,7 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 #include "Errors.h"
 #include "PackedCol.h"
 #include "SSL.h"
+#include "Deflate.h"
 
 /*########################################################################################################################*
 *---------------------------------------------------------HttpUrl---------------------------------------------------------*
@@ -444,9 +501,16 @@ struct HttpConnection {
 	cc_socket socket;
 	void* sslCtx;
 	cc_bool valid;
+	/* Data that was received, but belongs to the next response */
+	cc_uint8* unread;
+	cc_uint32 unreadLen;
 };
 
 static void HttpConnection_Close(struct HttpConnection* conn) {
+	Mem_Free(conn->unread);
+	conn->unread    = NULL;
+	conn->unreadLen = 0;
+
 	if (conn->sslCtx) {
 		SSL_Free(conn->sslCtx);
 		conn->sslCtx = NULL;
@@ -489,16 +553,18 @@ static cc_result HttpConnection_Open(struct HttpConnection* conn, const struct H
 	conn->socket = -1;
 	conn->sslCtx = NULL;
 
-	if ((res = Socket_ParseAddress(&host, portNum, addrs, &numValidAddrs))) return res;
+	if ((res = Socket_ResolveAddress(&host, portNum, addrs, &numValidAddrs))) return res;
 	res = ERR_INVALID_ARGUMENT; /* in case 0 valid addresses */
 
-	/* TODO: Connect in parallel instead of serial, but that's a lot of work */
+	/* NOTE: Connects serially, since the rest of the HTTP client relies on blocking sockets */
+	/*  However, addresses which failed to connect are tried last by later requests */
 	for (i = 0; i < numValidAddrs; i++)
 	{
 		res = Socket_Create(&conn->socket, &addrs[i], false);
 		if (res) { HttpConnection_Close(conn); continue; }
 
 		res = Socket_Connect(conn->socket, &addrs[i]);
+		Socket_ReportAddress(&host, portNum, &addrs[i], !res);
 		if (res) { HttpConnection_Close(conn); continue; }
 
 		break; /* Successful connection */
@@ -511,12 +577,35 @@ static cc_result HttpConnection_Open(struct HttpConnection* conn, const struct H
 }
 
 static cc_result HttpConnection_Read(struct HttpConnection* conn, cc_uint8* data, cc_uint32 count, cc_uint32* read) {
+	if (conn->unreadLen) {
+		count = min(count, conn->unreadLen);
+		Mem_Copy(data, conn->unread, count);
+		*read = count;
+
+		conn->unreadLen -= count;
+		Mem_Move(conn->unread, conn->unread + count, conn->unreadLen);
+		if (!conn->unreadLen) { Mem_Free(conn->unread); conn->unread = NULL; }
+		return 0;
+	}
+
 	if (conn->sslCtx)
 		return SSL_Read(conn->sslCtx, data, count, read);
 
 	return Socket_Read(conn->socket,  data, count, read);
 }
 
+/* Pushes back data so that it is returned first by the next HttpConnection_Read call */
+static cc_result HttpConnection_Unread(struct HttpConnection* conn, const cc_uint8* data, cc_uint32 count) {
+	cc_uint8* unread = (cc_uint8*)Mem_TryRealloc(conn->unread, conn->unreadLen + count, 1);
+	if (!unread) return ERR_OUT_OF_MEMORY;
+
+	Mem_Move(unread + count, unread, conn->unreadLen);
+	Mem_Copy(unread, data, count);
+	conn->unread     = unread;
+	conn->unreadLen += count;
+	return 0;
+}
+
 static cc_result HttpConnection_Write(struct HttpConnection* conn, const cc_uint8* data, cc_uint32 count) {
 	if (conn->sslCtx) 
 		return SSL_WriteAll(conn->sslCtx, data, count);
@@ -533,41 +622,77 @@ static struct ConnectionPoolEntry {
 	cc_string addr;
 	char addrBuffer[STRING_SIZE];
 	cc_bool https;
+	cc_bool inUse; /* Whether a worker is currently using this connection */
 } connection_pool[10];
+static void* connection_poolMutex;
 
-static cc_result ConnectionPool_Insert(int i, struct HttpConnection** conn, const struct HttpUrl* url) {
-	struct ConnectionPoolEntry* e = &connection_pool[i];
-	*conn = &e->conn;
-
-	String_InitArray(e->addr, e->addrBuffer);
-	String_Copy(&e->addr, &url->address);
-	e->https = url->https;
-	return HttpConnection_Open(&e->conn, url);
-}
-
-static cc_result ConnectionPool_Open(struct HttpConnection** conn, const struct HttpUrl* url) {
+/* Finds an existing connection that can be reused, or otherwise an entry to open a new connection in */
+/* NOTE: Entries in use by other workers are never returned */
+static struct ConnectionPoolEntry* ConnectionPool_Find(const struct HttpUrl* url) {
 	struct ConnectionPoolEntry* e;
-	int i;
+	int i, j;
 
 	for (i = 0; i < Array_Elems(connection_pool); i++)
 	{
 		e = &connection_pool[i];
-		if (e->conn.valid && e->https == url->https && String_Equals(&e->addr, &url->address)) {
-			*conn = &connection_pool[i].conn;
-			return 0;
-		}
+		if (e->inUse) continue;
+		if (e->conn.valid && e->https == url->https && String_Equals(&e->addr, &url->address)) return e;
 	}
 
 	for (i = 0; i < Array_Elems(connection_pool); i++)
 	{
 		e = &connection_pool[i];
-		if (!e->conn.valid) return ConnectionPool_Insert(i, conn, url);
+		if (!e->inUse && !e->conn.valid) return e;
 	}
 
 	/* TODO: Should we be consistent in which entry gets evicted? */
 	i = (cc_uint8)Stopwatch_Measure() % Array_Elems(connection_pool);
-	HttpConnection_Close(&connection_pool[i].conn);
-	return ConnectionPool_Insert(i, conn, url);
+	for (j = 0; j < Array_Elems(connection_pool); j++)
+	{
+		e = &connection_pool[(i + j) % Array_Elems(connection_pool)];
+		if (!e->inUse) return e;
+	}
+	return NULL;
+}
+
+static cc_result ConnectionPool_Open(struct HttpConnection** conn, const struct HttpUrl* url) {
+	struct ConnectionPoolEntry* e;
+	cc_bool reuse = false;
+
+	Mutex_Lock(connection_poolMutex);
+	{
+		e = ConnectionPool_Find(url);
+		if (e) {
+			e->inUse = true;
+			reuse    = e->conn.valid && e->https == url->https && String_Equals(&e->addr, &url->address);
+		}
+	}
+	Mutex_Unlock(connection_poolMutex);
+
+	/* Should never happen, as there are more pool entries than workers */
+	if (!e) Process_Abort("No free HTTP connection pool entries");
+	*conn = &e->conn;
+	if (reuse) return 0;
+
+	/* Connecting is slow, so this is done outside the lock */
+	if (e->conn.valid) HttpConnection_Close(&e->conn);
+	String_InitArray(e->addr, e->addrBuffer);
+	String_Copy(&e->addr, &url->address);
+	e->https = url->https;
+	return HttpConnection_Open(&e->conn, url);
+}
+
+/* Allows the given connection to be used by other workers again */
+static void ConnectionPool_Release(struct HttpConnection* conn) {
+	int i;
+	Mutex_Lock(connection_poolMutex);
+	{
+		for (i = 0; i < Array_Elems(connection_pool); i++)
+		{
+			if (conn == &connection_pool[i].conn) connection_pool[i].inUse = false;
+		}
+	}
+	Mutex_Unlock(connection_poolMutex);
 }
 
 
@@ -584,6 +709,7 @@ enum HTTP_RESPONSE_STATE {
 	HTTP_RESPONSE_STATE_CHUNK_TRAILERS,
 	HTTP_RESPONSE_STATE_DONE
 };
+enum HTTP_CONTENT_ENCODING { HTTP_ENCODING_NONE, HTTP_ENCODING_GZIP, HTTP_ENCODING_ZLIB };
 #define HTTP_HEADER_MAX_LENGTH   4096
 #define HTTP_LOCATION_MAX_LENGTH 256
 
@@ -594,6 +720,10 @@ struct HttpClientState {
 	cc_uint32 dataLeft; /* Number of bytes still to read from the current chunk or body */
 	int chunked;
 	cc_bool autoClose;
+	cc_uint8 encoding;  /* Content-Encoding of the response body (see HTTP_CONTENT_ENCODING enum) */
+	struct InflateState* inflate; /* Decompressor for the response body, if it is encoded */
+	struct GZipHeader gzipHeader;
+	struct ZLibHeader zlibHeader;
 	cc_string header, location;
 	struct HttpUrl url;
 	char _headerBuffer[HTTP_HEADER_MAX_LENGTH];
@@ -605,6 +735,8 @@ static void HttpClientState_Reset(struct HttpClientState* state) {
 	state->chunked     = 0;
 	state->dataLeft    = 0;
 	state->autoClose   = false;
+	state->encoding    = HTTP_ENCODING_NONE;
+	state->inflate     = NULL;
 	String_InitArray(state->header,   state->_headerBuffer);
 	String_InitArray(state->location, state->_locationBuffer);
 }
@@ -616,6 +748,7 @@ static void HttpClientState_Init(struct HttpClientState* state) {
 
 static void HttpClient_Serialise(struct HttpClientState* state) {
 	static const char* verbs[] = { "GET", "HEAD", "POST" };
+	static const cc_string encodings = String_FromConst("gzip, deflate");
 
 	struct HttpRequest* req = state->req;
 	cc_string* buffer = (cc_string*)req->meta;
@@ -626,6 +759,7 @@ static void HttpClient_Serialise(struct HttpClientState* state) {
 
 	Http_AddHeader(req, "Host",       &state->url.address);
 	Http_AddHeader(req, "User-Agent", Http_GetUserAgent_UNSAFE());
+	if (!req->_resumable) Http_AddHeader(req, "Accept-Encoding", &encodings);
 	if (req->data) String_Format1(buffer, "Content-Length: %i\r\n", &req->size);
 
 	Http_SetRequestHeaders(req);
@@ -662,6 +796,10 @@ static void HttpClient_ParseHeader(struct HttpClientState* state, const cc_strin
 
 	if (String_CaselessEqualsConst(&name, "Transfer-Encoding")) {
 		state->chunked = String_CaselessEqualsConst(&value, "chunked");
+	} else if (String_CaselessEqualsConst(&name, "Content-Encoding")) {
+		if (String_CaselessEqualsConst(&value, "gzip"))    state->encoding = HTTP_ENCODING_GZIP;
+		if (String_CaselessEqualsConst(&value, "x-gzip"))  state->encoding = HTTP_ENCODING_GZIP;
+		if (String_CaselessEqualsConst(&value, "deflate")) state->encoding = HTTP_ENCODING_ZLIB;
 	} else if (String_CaselessEqualsConst(&name, "Location")) {
 		String_Copy(&state->location, &value);
 	} else if (String_CaselessEqualsConst(&name, "Connection")) {
@@ -695,6 +833,81 @@ static int HttpClient_BeginBody(struct HttpRequest* req, struct HttpClientState*
 	return HTTP_RESPONSE_STATE_DONE;
 }
 
+/* RFC 7231, section 3.1.2.2 - Content-Encoding */
+static cc_result HttpClient_BeginDecoding(struct HttpClientState* state) {
+	if (!state->encoding) return 0;
+
+	state->inflate = (struct InflateState*)Mem_TryAlloc(1, sizeof(struct InflateState));
+	if (!state->inflate) return ERR_OUT_OF_MEMORY;
+
+	Inflate_Init2(state->inflate, NULL);
+	GZipHeader_Init(&state->gzipHeader);
+	ZLibHeader_Init(&state->zlibHeader);
+	return 0;
+}
+
+static void HttpClient_EndDecoding(struct HttpClientState* state) {
+	Mem_Free(state->inflate);
+	state->inflate = NULL;
+}
+
+/* Decompresses the given part of the response body, then appends the decompressed data to the response */
+static cc_result HttpClient_Decode(struct HttpClientState* state, cc_uint8* data, cc_uint32 len) {
+	struct InflateState* inflate = state->inflate;
+	struct HttpRequest* req      = state->req;
+	cc_uint8 output[4096];
+	cc_uint32 produced;
+	struct Stream mem;
+	cc_result res;
+
+	/* Header may be split across multiple parts of the body */
+	if (!state->gzipHeader.done && !state->zlibHeader.done) {
+		Stream_ReadonlyMemory(&mem, data, len);
+		if (state->encoding == HTTP_ENCODING_GZIP) {
+			res = GZipHeader_Read(&mem, &state->gzipHeader);
+		} else {
+			res = ZLibHeader_Read(&mem, &state->zlibHeader);
+		}
+
+		if (res == ERR_END_OF_STREAM) return 0;
+		if (res) return res;
+		data += len - mem.meta.mem.left;
+		len   = mem.meta.mem.left;
+	}
+
+	inflate->NextIn  = data;
+	inflate->AvailIn = len;
+
+	/* Trailing checksum/size after the compressed data is ignored */
+	while (!Inflate_IsDone(inflate))
+	{
+		inflate->Output   = output;
+		inflate->AvailOut = sizeof(output);
+		Inflate_Process(inflate);
+		produced = sizeof(output) - inflate->AvailOut;
+
+		/* Grow by doubling, since decompressed size isn't known beforehand */
+		if (!req->_streaming && req->size + produced > req->_capacity && req->_capacity) {
+			if (!Http_BufferExpand(req, max(produced, req->size))) return ERR_OUT_OF_MEMORY;
+		}
+		if (produced && !Http_AppendData(req, output, produced)) return ERR_OUT_OF_MEMORY;
+
+		/* Output wasn't filled, so all input has been used up */
+		if (inflate->AvailOut) break;
+	}
+
+	/* Input data is only valid for this call, but partial bits are kept in the bit buffer */
+	inflate->NextIn  = inflate->Input;
+	inflate->AvailIn = 0;
+	return Inflate_IsDone(inflate) ? inflate->result : 0;
+}
+
+static cc_result HttpClient_AppendBody(struct HttpClientState* state, cc_uint8* data, cc_uint32 len) {
+	if (state->inflate) return HttpClient_Decode(state, data, len);
+
+	return Http_AppendData(state->req, data, len) ? 0 : ERR_OUT_OF_MEMORY;
+}
+
 /* RFC 7230, section 4.1 - Chunked Transfer Coding */
 static int HttpClient_GetChunkLength(const cc_string* line) {
 	int length = 0, i, part;
@@ -713,10 +926,12 @@ static int HttpClient_GetChunkLength(const cc_string* line) {
 }
 
 /* https://httpwg.org/specs/rfc7230.html */
-static cc_result HttpClient_Process(struct HttpClientState* state, char* buffer, int total) {
+/* Processes the given response data, setting used to how many bytes actually belonged to the response */
+static cc_result HttpClient_Process(struct HttpClientState* state, char* buffer, int total, int* used) {
 	struct HttpRequest* req = state->req;
 	cc_uint32 left, avail, read;
 	int offset = 0, chunkLen, ok;
+	cc_result res;
 
 	while (offset < total) {
 		switch (state->state) {
@@ -742,11 +957,12 @@ static cc_result HttpClient_Process(struct HttpClientState* state, char* buffer,
 				/* Zero length header = end of message headers */
 				if (state->header.length == 0) {
 					state->state = HttpClient_BeginBody(req, state);
+					if (state->state != HTTP_RESPONSE_STATE_DONE && (res = HttpClient_BeginDecoding(state))) return res;
 
 					/* The rest of the request body is just content/data */
 					if (state->state == HTTP_RESPONSE_STATE_DATA) {
 						state->dataLeft = req->contentLength;
-						ok = Http_BufferExpand(req, state->dataLeft);
+						ok = req->_streaming || Http_BufferExpand(req, state->dataLeft);
 						if (!ok) return ERR_OUT_OF_MEMORY;
 					}
 					break;
@@ -765,8 +981,8 @@ static cc_result HttpClient_Process(struct HttpClientState* state, char* buffer,
 			avail = state->dataLeft;
 			read  = min(left, avail);
 
-			Mem_Copy(req->data + req->size, buffer + offset, read);
-			Http_BufferExpanded(req, read); 
+			res = HttpClient_AppendBody(state, (cc_uint8*)buffer + offset, read);
+			if (res) return res;
 
 			state->dataLeft -= read;
 			offset += read;
@@ -797,7 +1013,7 @@ static cc_result HttpClient_Process(struct HttpClientState* state, char* buffer,
 					state->state = HTTP_RESPONSE_STATE_DATA;
 
 					state->dataLeft = chunkLen;
-					ok = Http_BufferExpand(req, state->dataLeft);
+					ok = req->_streaming || Http_BufferExpand(req, state->dataLeft);
 					if (!ok) return ERR_OUT_OF_MEMORY;
 				}
 				break;
@@ -838,23 +1054,28 @@ static cc_result HttpClient_Process(struct HttpClientState* state, char* buffer,
 		break;
 
 		default:
+			*used = offset;
 			return 0;
 		}
 	}
+	*used = offset;
 	return 0;
 }
 
 #define INPUT_BUFFER_LEN 8192
-static cc_result HttpClient_ParseResponse(struct HttpClientState* state) {
+static cc_result HttpClient_ReadResponse(struct HttpClientState* state) {
 	struct HttpRequest* req = state->req;
 	cc_uint8 buffer[INPUT_BUFFER_LEN];
 	cc_uint8* dst;
 	cc_uint32 total;
 	cc_result res;
+	int used;
 
 	for (;;) 
 	{
-		dst = state->dataLeft > INPUT_BUFFER_LEN ? (req->data + req->size) : buffer;
+		/* Streamed data may be taken at any time, so can't read directly into it */
+		/* Compressed data also has to be decompressed before being added to the response */
+		dst = state->dataLeft > INPUT_BUFFER_LEN && !req->_streaming && !state->inflate ? (req->data + req->size) : buffer;
 		res = HttpConnection_Read(state->conn, dst, INPUT_BUFFER_LEN, &total);
 		if (res) return res;
 
@@ -870,7 +1091,11 @@ static cc_result HttpClient_ParseResponse(struct HttpClientState* state) {
 			Http_BufferExpanded(req, total); 
 			state->dataLeft -= total;
 		} else {
-			res = HttpClient_Process(state, (char*)buffer, total);
+			res = HttpClient_Process(state, (char*)buffer, total, &used);
+			if (res) return res;
+
+			/* With pipelining, the start of the next response may also have been received */
+			if (used < (int)total) res = HttpConnection_Unread(state->conn, buffer + used, total - used);
 		}
 
 		if (res) return res;
@@ -878,6 +1103,15 @@ static cc_result HttpClient_ParseResponse(struct HttpClientState* state) {
 	}
 }
 
+static cc_result HttpClient_ParseResponse(struct HttpClientState* state) {
+	cc_result res = HttpClient_ReadResponse(state);
+
+	/* Body ended before all of the compressed data was received */
+	if (!res && state->inflate && !Inflate_IsDone(state->inflate)) res = ERR_END_OF_STREAM;
+	HttpClient_EndDecoding(state);
+	return res;
+}
+
 static cc_bool HttpClient_IsRedirect(struct HttpRequest* req) {
 	return req->statusCode >= 300 && req->statusCode <= 399 && req->statusCode != 304;
 }
@@ -886,7 +1120,9 @@ static cc_result HttpClient_HandleRedirect(struct HttpClientState* state) {
 	cc_result res = HttpUrl_ResolveRedirect(&state->url, &state->location);
 	if (res) return res;
 
+	Http_LockData(state->req);
 	HttpRequest_Free(state->req);
+	Http_UnlockData(state->req);
 	Platform_Log1("  Redirecting to: %s", &state->location);
 	state->req->contentLength = 0; /* TODO */
 	return 0;
@@ -897,6 +1133,7 @@ static cc_result HttpClient_HandleRedirect(struct HttpClientState* state) {
 *-----------------------------------------------Http backend implementation-----------------------------------------------*
 *#########################################################################################################################*/
 static void HttpBackend_Init(void) {
+	connection_poolMutex = Mutex_Create("HTTP connection pool");
 	SSLBackend_Init(httpsVerify);
 	//httpOnly = true; // TODO: insecure
 }
@@ -905,7 +1142,7 @@ static void Http_AddHeader(struct HttpRequest* req, const char* key, const cc_st
 	String_Format2((cc_string*)req->meta, "%c:%s\r\n", key, value);
 }
 
-static cc_result HttpBackend_PerformRequest(struct HttpClientState* state) {
+static cc_result HttpBackend_DoPerformRequest(struct HttpClientState* state) {
 	cc_result res;
 
 	res = ConnectionPool_Open(&state->conn, &state->url);
@@ -915,52 +1152,138 @@ static cc_result HttpBackend_PerformRequest(struct HttpClientState* state) {
 	if (res) { HttpConnection_Close(state->conn); return res; }
 
 	res = HttpClient_ParseResponse(state);
-	if (res) HttpConnection_Close(state->conn);
+	if (res || state->autoClose) HttpConnection_Close(state->conn);
 
 	return res;
 }
 
-static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* urlStr) {
-	struct HttpClientState state;
-	cc_bool retried = false;
-	int redirects   = 0;
+static cc_result HttpBackend_PerformRequest(struct HttpClientState* state) {
 	cc_result res;
+	state->conn = NULL;
 
-	HttpClientState_Init(&state);
-	HttpUrl_Parse(urlStr, &state.url);
-	state.req = req;
+	res = HttpBackend_DoPerformRequest(state);
+	if (state->conn) ConnectionPool_Release(state->conn);
+	return res;
+}
+
+/* Performs the request (retrying and following redirects if necessary) */
+/* If hasResponse is true, the response to the request has already been received */
+static cc_result HttpBackend_Perform(struct HttpClientState* state, cc_bool hasResponse) {
+	cc_bool retried = false;
+	int redirects   = 0;
+	cc_result res   = 0;
 
 	for (;;) {
-		res = HttpBackend_PerformRequest(&state);
+		if (!hasResponse) res = HttpBackend_PerformRequest(state);
+		hasResponse = false;
+		/* Retrying would duplicate response data that was already taken */
+		if (state->req->_streamed) retried = true;
+
 		/* TODO: Can we handle this while preserving the TCP connection */
 		if (res == SSL_ERR_CONTEXT_DEAD && !retried) {
 			Platform_LogConst("Resetting connection due to SSL context being dropped..");
-			res = HttpBackend_PerformRequest(&state);
+			res = HttpBackend_PerformRequest(state);
 			retried = true;
 		}
 		if (res == HTTP_ERR_NO_RESPONSE && !retried) {
 			Platform_LogConst("Resetting connection due to empty response..");
-			res = HttpBackend_PerformRequest(&state);
+			res = HttpBackend_PerformRequest(state);
 			retried = true;
 		}
 		if (res == ReturnCode_SocketDropped && !retried) {
 			Platform_LogConst("Resetting connection due to being dropped..");
-			res = HttpBackend_PerformRequest(&state);
+			res = HttpBackend_PerformRequest(state);
 			retried = true;
 		}
 
-		if (res || !HttpClient_IsRedirect(req)) break;
+		if (res || !HttpClient_IsRedirect(state->req)) break;
 		if (redirects >= 20) return HTTP_ERR_REDIRECTS;
 
 		/* TODO FOLLOW LOCATION PROPERLY */
 		redirects++;
-		res = HttpClient_HandleRedirect(&state);
+		res = HttpClient_HandleRedirect(state);
 		if (res) break;
-		HttpClientState_Reset(&state);
+		HttpClientState_Reset(state);
 	}
 	return res;
 }
 
+static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* urlStr) {
+	struct HttpClientState state;
+
+	HttpClientState_Init(&state);
+	HttpUrl_Parse(urlStr, &state.url);
+	state.req = req;
+	return HttpBackend_Perform(&state, false);
+}
+
+#ifndef CC_BUILD_LOWMEM
+/* Max number of requests that are sent at once over the same connection */
+#define HTTP_MAX_PIPELINE 4
+
+/* Sends all requests over the same connection before reading any responses */
+/* Returns the number of requests that had their response fully received */
+static int HttpBackend_Pipeline(struct HttpClientState* states, int count) {
+	struct HttpConnection* conn;
+	cc_bool closed = false;
+	cc_result res;
+	int i, received = 0;
+
+	res = ConnectionPool_Open(&conn, &states[0].url);
+	for (i = 0; i < count && !res; i++)
+	{
+		states[i].conn = conn;
+		res = HttpClient_SendRequest(&states[i]);
+	}
+
+	for (i = 0; i < count && !res; i++)
+	{
+		res = HttpClient_ParseResponse(&states[i]);
+		if (res) break;
+
+		received++;
+		/* Server won't respond to any of the remaining requests */
+		if (states[i].autoClose) { closed = true; break; }
+	}
+
+	if (res || closed) HttpConnection_Close(conn);
+	ConnectionPool_Release(conn);
+	return received;
+}
+
+/* Performs multiple GET or HEAD requests to the same server */
+/* NOTE: Requests without a response are then performed again individually */
+static void HttpBackend_DoPipelined(struct HttpRequest* reqs, cc_string* urls, int count) {
+	struct HttpClientState states[HTTP_MAX_PIPELINE];
+	int i, received;
+
+	for (i = 0; i < count; i++)
+	{
+		HttpClientState_Init(&states[i]);
+		HttpUrl_Parse(&urls[i], &states[i].url);
+		states[i].req = &reqs[i];
+
+		/* Only requests to the same server can be sent over one connection */
+		if (states[i].url.https != states[0].url.https || !String_Equals(&states[i].url.address, &states[0].url.address)) break;
+	}
+	received = HttpBackend_Pipeline(states, i);
+
+	for (i = 0; i < count; i++)
+	{
+		if (i >= received) {
+			/* Discard any partially received response */
+			HttpRequest_Free(&reqs[i]);
+			reqs[i].statusCode    = 0;
+			reqs[i].contentLength = 0;
+			HttpClientState_Init(&states[i]);
+			HttpUrl_Parse(&urls[i], &states[i].url);
+			states[i].req = &reqs[i];
+		}
+		reqs[i].result = HttpBackend_Perform(&states[i], i < received);
+	}
+}
+#endif
+
 static cc_bool HttpBackend_DescribeError(cc_result res, cc_string* dst) {
 	return SSLBackend_DescribeError(res, dst);
 }
@@ -1003,26 +1326,46 @@ static void Http_AddHeader(struct HttpRequest* req, const char* key, const cc_st
 	(*env)->DeleteLocalRef(env, args[1].l);
 }
 
-/* Processes a HTTP header downloaded from the server */
-static void JNICALL java_HttpParseHeader(JNIEnv* env, jobject o, jstring header) {
-	char buffer[NATIVE_STR_LEN];
-	cc_string line = JavaGetString(env, header, buffer);
-	Http_ParseHeader(java_req, &line);
+/* Processes all the HTTP headers downloaded from the server (each header is on a separate line) */
+/* NOTE: Headers are provided all at once, to avoid a JNI call and string conversion per header */
+static void JNICALL java_HttpParseHeaders(JNIEnv* env, jobject o, jstring headers) {
+	const char* src = (*env)->GetStringUTFChars(env, headers, NULL);
+	int i, beg = 0, len = (*env)->GetStringUTFLength(env, headers);
+	cc_string line;
+	
+	for (i = 0; i <= len; i++)
+	{
+		if (i < len && src[i] != '\n') continue;
+
+		/* Headers are plain ASCII, so no need to convert the modified UTF8 */
+		line = String_Init((char*)src + beg, i - beg, i - beg);
+		if (line.length) Http_ParseHeader(java_req, &line);
+		beg  = i + 1;
+	}
+	(*env)->ReleaseStringUTFChars(env, headers, src);
 }
 
 /* Processes a chunk of data downloaded from the web server */
-static void JNICALL java_HttpAppendData(JNIEnv* env, jobject o, jbyteArray arr, jint len) {
+/* NOTE: The data is read straight into a direct ByteBuffer, so it doesn't need copying into a Java byte array first */
+static void JNICALL java_HttpAppendData(JNIEnv* env, jobject o, jobject buffer, jint len) {
 	struct HttpRequest* req = java_req;
-	int ok = Http_BufferExpand(req, len);	
-	if (!ok) Process_Abort("Out of memory for HTTP request");
+	void* src = (*env)->GetDirectBufferAddress(env, buffer);
+	int ok;
 
-	(*env)->GetByteArrayRegion(env, arr, 0, len, (jbyte*)(&req->data[req->size]));
-	Http_BufferExpanded(req, len);
+	Http_LockData(req);
+	{
+		ok = Http_BufferExpand(req, len);
+		if (!ok) Process_Abort("Out of memory for HTTP request");
+
+		Mem_Copy(&req->data[req->size], src, len);
+		Http_BufferExpanded(req, len);
+	}
+	Http_UnlockData(req);
 }
 
 static const JNINativeMethod methods[] = {
-	{ "httpParseHeader", "(Ljava/lang/String;)V", java_HttpParseHeader },
-	{ "httpAppendData",  "([BI)V",                java_HttpAppendData }
+	{ "httpParseHeaders", "(Ljava/lang/String;)V",    java_HttpParseHeaders },
+	{ "httpAppendData",   "(Ljava/nio/ByteBuffer;I)V", java_HttpAppendData }
 };
 static void CacheMethodRefs(JNIEnv* env) {
 	JAVA_httpInit      = JavaGetSMethod(env, "httpInit",      "(Ljava/lang/String;Ljava/lang/String;)I");
@@ -1187,11 +1530,8 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
             if ((result = ParseResponseHeaders(req, stream))) break;
         }
         
-        int ok = Http_BufferExpand(req, read);
+        int ok = Http_AppendData(req, buf, read);
 		if (!ok) { result = ERR_OUT_OF_MEMORY; break; }
-        
-        Mem_Copy(&req->data[req->size], buf, read);
-        Http_BufferExpanded(req, read);
     }
     
     if (!gotHeaders)
@@ -1222,14 +1562,28 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 #endif
 
 
+#if CC_NET_BACKEND == CC_NET_BACKEND_BUILTIN && !defined CC_BUILD_LOWMEM && !defined CC_BUILD_COOPTHREADED
+	#define HTTP_MAX_WORKERS 4
+#else
+	/* Other backends reuse the same native state for every request */
+	#define HTTP_MAX_WORKERS 1
+#endif
+/* Max number of workers performing requests to the same host at once */
+#define HTTP_MAX_PER_HOST 2
+#ifndef HTTP_MAX_PIPELINE
+	#define HTTP_MAX_PIPELINE 1
+#endif
+
 static void* workerWaitable;
-static void* workerThread;
+static void* workerThreads[HTTP_MAX_WORKERS];
+static int workersStarted;
 
 static void* pendingMutex;
 static struct RequestList pendingReqs;
 
+/* Requests currently being performed by each worker (id is 0 if unused) */
 static void* curRequestMutex;
-static struct HttpRequest http_curRequest;
+static struct HttpRequest http_curRequests[HTTP_MAX_WORKERS * HTTP_MAX_PIPELINE];
 
 
 /*########################################################################################################################*
@@ -1244,24 +1598,76 @@ cc_bool Http_GetResult(int reqID, struct HttpRequest* item) {
 		if (i >= 0) RequestList_RemoveAt(&processedReqs, i);
 	}
 	Mutex_Unlock(processedMutex);
+
+#ifdef CC_BUILD_TINYSTACK
+	if (i >= 0) Http_DecodeImage(item);
+#endif
 	return i >= 0;
 }
 
 cc_bool Http_GetCurrent(int* reqID, int* progress) {
+	int i;
+	*reqID    = 0;
+	*progress = HTTP_PROGRESS_NOT_WORKING_ON;
+
 	Mutex_Lock(curRequestMutex);
 	{
-		*reqID    = http_curRequest.id;
-		*progress = http_curRequest.progress;
+		/* Report the oldest request that is still being performed */
+		for (i = 0; i < Array_Elems(http_curRequests); i++)
+		{
+			if (!http_curRequests[i].id) continue;
+			if (*reqID && http_curRequests[i].id > *reqID) continue;
+
+			*reqID    = http_curRequests[i].id;
+			*progress = http_curRequests[i].progress;
+		}
 	}
 	Mutex_Unlock(curRequestMutex);
 	return *reqID != 0;
 }
 
+cc_uint32 Http_TakePartial(int reqID, cc_uint8** data) {
+	struct HttpRequest* req;
+	cc_uint32 size = 0;
+	int i;
+	*data = NULL;
+
+	Mutex_Lock(curRequestMutex);
+	Mutex_Lock(streamMutex);
+	{
+		for (i = 0; i < Array_Elems(http_curRequests); i++)
+		{
+			req = &http_curRequests[i];
+			if (req->id != reqID || !req->_streaming) continue;
+			/* Don't hand out the body of e.g. redirects or error pages */
+			if (req->statusCode != 200 || !req->size) break;
+
+			*data = req->data;
+			size  = req->size;
+			req->_streamed += size;
+
+			req->data      = NULL;
+			req->size      = 0;
+			req->_capacity = 0;
+			break;
+		}
+	}
+	Mutex_Unlock(streamMutex);
+	Mutex_Unlock(curRequestMutex);
+	return size;
+}
+
 int Http_CheckProgress(int reqID) {
-	int curReqID, progress;
-	Http_GetCurrent(&curReqID, &progress);
+	int i, progress = HTTP_PROGRESS_NOT_WORKING_ON;
 
-	if (reqID != curReqID) progress = HTTP_PROGRESS_NOT_WORKING_ON;
+	Mutex_Lock(curRequestMutex);
+	{
+		for (i = 0; i < Array_Elems(http_curRequests); i++)
+		{
+			if (http_curRequests[i].id == reqID) progress = http_curRequests[i].progress;
+		}
+	}
+	Mutex_Unlock(curRequestMutex);
 	return progress;
 }
 
@@ -1291,76 +1697,184 @@ void Http_TryCancel(int reqID) {
 /*########################################################################################################################*
 *-----------------------------------------------------Http worker---------------------------------------------------------*
 *#########################################################################################################################*/
-/* Sets up state to begin a http request */
+/* Logs the details of the request about to be performed */
 static void PrepareCurrentRequest(struct HttpRequest* req, cc_string* url) {
 	static const char* verbs[] = { "GET", "HEAD", "POST" };
 	Http_GetUrl(req, url);
-	Platform_Log2("Fetching %s (%c)", url, verbs[req->requestType]);
+	if (Platform_LogEnabled(LOG_CATEGORY_NETWORK, LOG_LEVEL_INFO))
+		Platform_Log2("Fetching %s (%c)", url, verbs[req->requestType]);
 	/* TODO change to verbs etc */
-
-	Mutex_Lock(curRequestMutex);
-	{
-		HttpRequest_Copy(&http_curRequest, req);
-		http_curRequest.progress = HTTP_PROGRESS_MAKING_REQUEST;
-	}
-	Mutex_Unlock(curRequestMutex);
 }
 
-static void PerformRequest(struct HttpRequest* req, cc_string* url) {
+static void PerformRequests(struct HttpRequest* reqs, cc_string* urls, int count) {
 	cc_uint64 beg, end;
-	int elapsed;
+	int i, elapsed;
 
 	beg = Stopwatch_Measure();
-	req->result = HttpBackend_Do(req, url);
+#if HTTP_MAX_PIPELINE > 1
+	if (count > 1) {
+		HttpBackend_DoPipelined(reqs, urls, count);
+	} else {
+		reqs[0].result = HttpBackend_Do(&reqs[0], &urls[0]);
+	}
+#else
+	reqs[0].result = HttpBackend_Do(&reqs[0], &urls[0]);
+#endif
 	end = Stopwatch_Measure();
 
 	elapsed = Stopwatch_ElapsedMS(beg, end);
-	Platform_Log4("HTTP: result %e (http %i) in %i ms (%i bytes)",
-		&req->result, &req->statusCode, &elapsed, &req->size);
+	for (i = 0; i < count; i++)
+	{
+		/* Any remaining data is returned as part of the result instead */
+		Mutex_Lock(streamMutex);
+		{
+			reqs[i]._streaming = false;
+		}
+		Mutex_Unlock(streamMutex);
 
-	Http_FinishRequest(req);
+		if (Platform_LogEnabled(LOG_CATEGORY_NETWORK, LOG_LEVEL_INFO))
+			Platform_Log4("HTTP: result %e (http %i) in %i ms (%i bytes)",
+				&reqs[i].result, &reqs[i].statusCode, &elapsed, &reqs[i].size);
+		Http_FinishRequest(&reqs[i]);
+	}
 }
 
-static void ClearCurrentRequest(void) {
+static void ClearCurrentRequest(struct HttpRequest* req) {
 	Mutex_Lock(curRequestMutex);
 	{
-		http_curRequest.id       = 0;
-		http_curRequest.progress = HTTP_PROGRESS_NOT_WORKING_ON;
+		req->id       = 0;
+		req->progress = HTTP_PROGRESS_NOT_WORKING_ON;
 	}
 	Mutex_Unlock(curRequestMutex);
 }
 
-static void DoRequest(struct HttpRequest* request) {
-	char urlBuffer[URL_MAX_SIZE]; cc_string url;
+/* Performs the given requests, which must be entries in http_curRequests */
+static void DoRequests(struct HttpRequest* reqs, int count) {
+	char urlBuffers[HTTP_MAX_PIPELINE][URL_MAX_SIZE];
+	cc_string urls[HTTP_MAX_PIPELINE];
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		String_InitArray(urls[i], urlBuffers[i]);
+		PrepareCurrentRequest(&reqs[i], &urls[i]);
+	}
+	PerformRequests(reqs, urls, count);
+
+	for (i = 0; i < count; i++)
+	{
+		ClearCurrentRequest(&reqs[i]);
+	}
+}
+
+/* Retrieves the scheme and host of the given request's URL (e.g. "http://example.com" for "http://example.com/abc") */
+static cc_string Http_GetOrigin(struct HttpRequest* req) {
+	cc_string url = String_FromRawArray(req->url);
+	int beg, end;
 
-	String_InitArray(url, urlBuffer);
-	PrepareCurrentRequest(request, &url);
-	PerformRequest(&http_curRequest, &url);
-	ClearCurrentRequest();
+	beg = String_IndexOfConst(&url, "://");
+	beg = beg >= 0 ? beg + 3 : 0;
+	end = String_IndexOfAt(&url, beg, '/');
+
+	if (end >= 0) url.length = end;
+	return url;
 }
 
-static void WorkerLoop(void) {
-	struct HttpRequest request;
-	cc_bool hasRequest;
+/* Whether a request to the same origin as the given request can be started */
+/* NOTE: Must be called with curRequestMutex held */
+static cc_bool Http_CanStartFor(struct HttpRequest* req) {
+	cc_string origin = Http_GetOrigin(req);
+	cc_string other;
+	int i, j, active = 0;
 
-	for (;;) {
-		hasRequest = false;
+	for (i = 0; i < HTTP_MAX_WORKERS; i++)
+	{
+		for (j = 0; j < HTTP_MAX_PIPELINE; j++)
+		{
+			struct HttpRequest* cur = &http_curRequests[i * HTTP_MAX_PIPELINE + j];
+			if (!cur->id) continue;
+
+			other = Http_GetOrigin(cur);
+			if (String_CaselessEquals(&origin, &other)) { active++; break; }
+		}
+	}
+	return active < HTTP_MAX_PER_HOST;
+}
 
-		Mutex_Lock(pendingMutex);
+/* Whether the given request can be sent over the same connection as the first request */
+static cc_bool Http_CanPipeline(struct HttpRequest* first, struct HttpRequest* req) {
+	cc_string origin, other;
+	if (req->requestType == REQUEST_TYPE_POST) return false;
+	/* Partially received pipelined responses are requested again, which would duplicate streamed data */
+	if (first->_streaming || req->_streaming)  return false;
+
+	origin = Http_GetOrigin(first);
+	other  = Http_GetOrigin(req);
+	return String_CaselessEquals(&origin, &other);
+}
+
+/* Moves pending requests that can be started into the given worker's current requests */
+/* NOTE: Pending requests are ordered by priority, so higher priority requests are started first */
+static int TakePendingRequests(struct HttpRequest* cur) {
+	cc_bool hasMore;
+	int i, count = 0;
+
+	Mutex_Lock(pendingMutex);
+	{
+		Mutex_Lock(curRequestMutex);
+		for (i = 0; i < pendingReqs.count; i++)
 		{
-			if (pendingReqs.count) {
-				HttpRequest_Copy(&request, &pendingReqs.entries[0]);
-				hasRequest = true;
-				RequestList_RemoveAt(&pendingReqs, 0);
+			if (!Http_CanStartFor(&pendingReqs.entries[i])) continue;
+
+			HttpRequest_Copy(&cur[0], &pendingReqs.entries[i]);
+			cur[0].progress = HTTP_PROGRESS_MAKING_REQUEST;
+			RequestList_RemoveAt(&pendingReqs, i);
+			count = 1;
+			break;
+		}
+
+		/* Other requests to the same server may be able to be sent at the same time too */
+		if (count && cur[0].requestType != REQUEST_TYPE_POST) {
+			while (i < pendingReqs.count && count < HTTP_MAX_PIPELINE)
+			{
+				if (!Http_CanPipeline(&cur[0], &pendingReqs.entries[i])) { i++; continue; }
+
+				HttpRequest_Copy(&cur[count], &pendingReqs.entries[i]);
+				cur[count].progress = HTTP_PROGRESS_MAKING_REQUEST;
+				RequestList_RemoveAt(&pendingReqs, i);
+				count++;
 			}
 		}
-		Mutex_Unlock(pendingMutex);
+		Mutex_Unlock(curRequestMutex);
+		hasMore = pendingReqs.count > 0;
+	}
+	Mutex_Unlock(pendingMutex);
+
+	/* Wake up another worker to start on the remaining requests */
+	if (count && hasMore) Waitable_Signal(workerWaitable);
+	return count;
+}
+
+static void WorkerLoop(void) {
+	struct HttpRequest* cur;
+	int count;
+
+	Mutex_Lock(curRequestMutex);
+	{
+		cur = &http_curRequests[workersStarted * HTTP_MAX_PIPELINE];
+		workersStarted++;
+	}
+	Mutex_Unlock(curRequestMutex);
 
-		if (hasRequest) {
-			DoRequest(&request);
+	for (;;) {
+		count = TakePendingRequests(cur);
+
+		if (count) {
+			DoRequests(cur, count);
 		} else {
 			/* Block until another thread submits a request to do */
-			Platform_LogConst("Download queue empty, going back to sleep...");
+			if (Platform_LogEnabled(LOG_CATEGORY_NETWORK, LOG_LEVEL_DEBUG))
+				Platform_LogConst("Download queue empty, going back to sleep...");
 			Waitable_Wait(workerWaitable);
 		}
 	}
@@ -1370,7 +1884,8 @@ static void WorkerLoop(void) {
 static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags) {
 #if defined CC_BUILD_PSP || defined CC_BUILD_NDS
 	/* TODO why doesn't threading work properly on PSP */
-	DoRequest(req);
+	HttpRequest_Copy(&http_curRequests[0], req);
+	DoRequests(&http_curRequests[0], 1);
 #else
 	Mutex_Lock(pendingMutex);
 	{
@@ -1385,10 +1900,14 @@ static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags) {
 *-----------------------------------------------------Http component------------------------------------------------------*
 *#########################################################################################################################*/
 static void Http_Init(void) {
+	int i;
 	Http_InitCommon();
-	http_curRequest.progress = HTTP_PROGRESS_NOT_WORKING_ON;
+	for (i = 0; i < Array_Elems(http_curRequests); i++)
+	{
+		http_curRequests[i].progress = HTTP_PROGRESS_NOT_WORKING_ON;
+	}
 	/* Http component gets initialised multiple times on Android */
-	if (workerThread) return;
+	if (workerThreads[0]) return;
 
 	HttpBackend_Init();
 	RequestList_Init(&pendingReqs);
@@ -1398,7 +1917,11 @@ static void Http_Init(void) {
 	pendingMutex    = Mutex_Create("HTTP pending");
 	processedMutex  = Mutex_Create("HTTP processed");
 	curRequestMutex = Mutex_Create("HTTP current");
+	streamMutex     = Mutex_Create("HTTP stream");
 	
-	Thread_Run(&workerThread, WorkerLoop, 128 * 1024, "HTTP");
+	for (i = 0; i < HTTP_MAX_WORKERS; i++)
+	{
+		Thread_Run(&workerThreads[i], WorkerLoop, 128 * 1024, "HTTP");
+	}
 }
 #endif
@@ -718,6 +718,11 @@ static cc_bool BindTriggered_IDOverlay(int key, struct InputDevice* device) {
 	return true;
 }
 
+static cc_bool BindTriggered_Profiler(int key, struct InputDevice* device) {
+	ProfilerOverlay_Toggle();
+	return true;
+}
+
 static cc_bool BindTriggered_BreakLiquids(int key, struct InputDevice* device) {
 	if (Gui.InputGrab) return false;
 	
@@ -765,6 +770,7 @@ static void HookInputBinds(void) {
 	Bind_OnTriggered[BIND_DROP_BLOCK]    = BindTriggered_DropBlock;
 	Bind_OnTriggered[BIND_IDOVERLAY]     = BindTriggered_IDOverlay;
 	Bind_OnTriggered[BIND_BREAK_LIQUIDS] = BindTriggered_BreakLiquids;
+	Bind_OnTriggered[BIND_PROFILER]      = BindTriggered_Profiler;
 }
 
 
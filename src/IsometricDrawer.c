@@ -7,6 +7,8 @@
 #include "TexturePack.h"
 #include "Block.h"
 #include "Game.h"
+#include "Event.h"
+#include "Platform.h"
 
 static struct VertexTextured* iso_vertices;
 static struct VertexTextured* iso_vertices_base;
@@ -29,12 +31,118 @@ static void IsometricDrawer_InitCache(void) {
 		&iso_colorXSide, &iso_colorZSide, &iso_colorYBottom);
 }
 
-static TextureLoc IsometricDrawer_GetTexLoc(BlockID block, Face face) {
-	TextureLoc loc = Block_Tex(block, face);
-	*iso_state++   = Atlas1D_Index(loc);
+
+/*########################################################################################################################*
+*-------------------------------------------------------Icons cache-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Angled blocks are tessellated once at unit scale, then just scaled and offset for each icon */
+/* NOTE: Geometry only depends on the block's definition and the terrain atlas layout */
+#define ICON_FACES 3
+struct IsoIcon {
+	struct VertexTextured vertices[ICON_FACES * 4];
+	int texIndices[ICON_FACES];
+};
+
+static struct IsoIcon* iso_icons; /* NULL if not allocated (or allocation failed) */
+static struct IsoIcon  iso_tmpIcon;
+static cc_bool iso_iconCached[BLOCK_COUNT];
+
+static void IsometricDrawer_InvalidateIcons(void* obj) {
+	Mem_Set(iso_iconCached, 0, sizeof(iso_iconCached));
+}
+
+static TextureLoc IsometricDrawer_GetTexLoc(struct IsoIcon* icon, BlockID block, Face face, int i) {
+	TextureLoc loc     = Block_Tex(block, face);
+	icon->texIndices[i] = Atlas1D_Index(loc);
 	return loc;
 }
 
+static void IsometricDrawer_MakeIcon(BlockID block, struct IsoIcon* icon) {
+	cc_bool bright;
+	Vec3 min, max;
+	struct VertexTextured* v = icon->vertices;
+	float x, y;
+	int i;
+
+	Drawer.MinBB = Blocks.MinBB[block]; Drawer.MinBB.y = 1.0f - Drawer.MinBB.y;
+	Drawer.MaxBB = Blocks.MaxBB[block]; Drawer.MaxBB.y = 1.0f - Drawer.MaxBB.y;
+	min = Blocks.MinBB[block]; max = Blocks.MaxBB[block];
+
+	Drawer.X1 = 1.0f - min.x * 2.0f;
+	Drawer.X2 = 1.0f - max.x * 2.0f;
+	Drawer.Y1 = 1.0f - min.y * 2.0f;
+	Drawer.Y2 = 1.0f - max.y * 2.0f;
+	Drawer.Z1 = 1.0f - min.z * 2.0f;
+	Drawer.Z2 = 1.0f - max.z * 2.0f;
+
+	bright = Blocks.Brightness[block];
+	Drawer.Tinted  = Blocks.Tinted[block];
+	Drawer.TintCol = Blocks.FogCol[block];
+
+	Drawer_XMax(1, bright ? PACKEDCOL_WHITE : iso_colorXSide,
+		IsometricDrawer_GetTexLoc(icon, block, FACE_XMAX, 0), &v);
+	Drawer_ZMin(1, bright ? PACKEDCOL_WHITE : iso_colorZSide,
+		IsometricDrawer_GetTexLoc(icon, block, FACE_ZMIN, 1), &v);
+	Drawer_YMax(1, PACKEDCOL_WHITE,
+		IsometricDrawer_GetTexLoc(icon, block, FACE_YMAX, 2), &v);
+
+	for (i = 0, v = icon->vertices; i < ICON_FACES * 4; i++, v++)
+	{
+		/* Cut down form of: */
+		/*   Matrix_RotateY(&rotY,  45.0f * MATH_DEG2RAD); */
+		/*   Matrix_RotateX(&rotX, -30.0f * MATH_DEG2RAD); */
+		/*   Matrix_Mul(&iso_transform, &rotY, &rotX); */
+		/*   ...                                       */
+		/*   Vec3 vec = { v.x, v.y, v.z }; */
+		/*   Vec3_Transform(&vec, &vec, &iso_transform); */
+		/* With all unnecessary operations either simplified or removed */
+		x = v->x * iso_cosY                              + v->z * -iso_sinY;
+		y = v->x * iso_sinX * iso_sinY + v->y * iso_cosX + v->z * iso_sinX * iso_cosY;
+
+		v->x = x;
+		v->y = y;
+	}
+}
+
+static struct IsoIcon* IsometricDrawer_GetIcon(BlockID block) {
+	if (!iso_icons) {
+		iso_icons = (struct IsoIcon*)Mem_TryAlloc(BLOCK_COUNT, sizeof(struct IsoIcon));
+		IsometricDrawer_InvalidateIcons(NULL);
+	}
+
+	/* Fallback to tessellating every time when out of memory */
+	if (!iso_icons) {
+		IsometricDrawer_MakeIcon(block, &iso_tmpIcon);
+		return &iso_tmpIcon;
+	}
+
+	if (!iso_iconCached[block]) {
+		IsometricDrawer_MakeIcon(block, &iso_icons[block]);
+		iso_iconCached[block] = true;
+	}
+	return &iso_icons[block];
+}
+
+static void IsometricDrawer_Init(void) {
+	Event_Register_(&BlockEvents.BlockDefChanged, NULL, IsometricDrawer_InvalidateIcons);
+	Event_Register_(&TextureEvents.AtlasChanged,  NULL, IsometricDrawer_InvalidateIcons);
+}
+
+static void IsometricDrawer_Free(void) {
+	Mem_Free(iso_icons);
+	iso_icons = NULL;
+}
+
+struct IGameComponent IsometricDrawer_Component = {
+	IsometricDrawer_Init, /* Init */
+	IsometricDrawer_Free  /* Free */
+};
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------IsometricDrawer-----------------------------------------------------*
+*#########################################################################################################################*/
+
 static void IsometricDrawer_Flat(BlockID block, float size) {
 	int texIndex;
 	TextureLoc loc = Block_Tex(block, FACE_ZMAX);
@@ -68,54 +176,26 @@ static void IsometricDrawer_Flat(BlockID block, float size) {
 }
 
 static void IsometricDrawer_Angled(BlockID block, float size) {
-	cc_bool bright;
-	Vec3 min, max;
-	struct VertexTextured* beg = iso_vertices;
-	struct VertexTextured* v;
-	float x, y, scale;
+	struct IsoIcon* icon = IsometricDrawer_GetIcon(block);
+	struct VertexTextured* src = icon->vertices;
+	struct VertexTextured* v   = iso_vertices;
+	float scale;
+	int i;
 
 	/* isometric coords size: cosY * -scale - sinY * scale */
 	/* we need to divide by (2 * cosY), as the calling function expects size to be in pixels. */
 	scale = size / (2.0f * iso_cosY);
 
-	Drawer.MinBB = Blocks.MinBB[block]; Drawer.MinBB.y = 1.0f - Drawer.MinBB.y;
-	Drawer.MaxBB = Blocks.MaxBB[block]; Drawer.MaxBB.y = 1.0f - Drawer.MaxBB.y;
-	min = Blocks.MinBB[block]; max = Blocks.MaxBB[block];
+	for (i = 0; i < ICON_FACES; i++) { *iso_state++ = icon->texIndices[i]; }
 
-	Drawer.X1 = scale * (1.0f - min.x * 2.0f);
-	Drawer.X2 = scale * (1.0f - max.x * 2.0f);
-	Drawer.Y1 = scale * (1.0f - min.y * 2.0f);
-	Drawer.Y2 = scale * (1.0f - max.y * 2.0f);
-	Drawer.Z1 = scale * (1.0f - min.z * 2.0f);
-	Drawer.Z2 = scale * (1.0f - max.z * 2.0f);
-
-	bright = Blocks.Brightness[block];
-	Drawer.Tinted  = Blocks.Tinted[block];
-	Drawer.TintCol = Blocks.FogCol[block];
-
-	Drawer_XMax(1, bright ? PACKEDCOL_WHITE : iso_colorXSide,
-		IsometricDrawer_GetTexLoc(block, FACE_XMAX), &iso_vertices);
-	Drawer_ZMin(1, bright ? PACKEDCOL_WHITE : iso_colorZSide,
-		IsometricDrawer_GetTexLoc(block, FACE_ZMIN), &iso_vertices);
-	Drawer_YMax(1, PACKEDCOL_WHITE,
-		IsometricDrawer_GetTexLoc(block, FACE_YMAX), &iso_vertices);
-
-	for (v = beg; v < iso_vertices; v++)
+	for (i = 0; i < ICON_FACES * 4; i++, v++, src++)
 	{
-		/* Cut down form of: */
-		/*   Matrix_RotateY(&rotY,  45.0f * MATH_DEG2RAD); */
-		/*   Matrix_RotateX(&rotX, -30.0f * MATH_DEG2RAD); */
-		/*   Matrix_Mul(&iso_transform, &rotY, &rotX); */
-		/*   ...                                       */
-		/*   Vec3 vec = { v.x, v.y, v.z }; */
-		/*   Vec3_Transform(&vec, &vec, &iso_transform); */
-		/* With all unnecessary operations either simplified or removed */
-		x = v->x * iso_cosY                              + v->z * -iso_sinY;
-		y = v->x * iso_sinX * iso_sinY + v->y * iso_cosX + v->z * iso_sinX * iso_cosY;
-
-		v->x = x + iso_posX;
-		v->y = y + iso_posY;
+		*v   = *src;
+		v->x = src->x * scale + iso_posX;
+		v->y = src->y * scale + iso_posY;
+		v->z = src->z * scale;
 	}
+	iso_vertices = v;
 }
 
 void IsometricDrawer_BeginBatch(struct VertexTextured* vertices, int* state) {
@@ -7,6 +7,8 @@ CC_BEGIN_HEADER
    Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 */
 struct VertexTextured;
+struct IGameComponent;
+extern struct IGameComponent IsometricDrawer_Component;
 
 /* Maximum number of vertices used to draw a block in isometric way. */
 #define ISOMETRICDRAWER_MAXVERTICES 12
@@ -0,0 +1,263 @@
+#include "Jobs.h"
+#include "Platform.h"
+#include "Options.h"
+#include "Game.h"
+
+static struct Job* queued_head[JOB_PRIORITY_COUNT];
+static struct Job* queued_tail[JOB_PRIORITY_COUNT];
+static struct Job* done_head;
+static struct Job* done_tail;
+
+static void Jobs_Enqueue(struct Job* job) {
+	int priority = job->Priority;
+	if (priority >= JOB_PRIORITY_COUNT) priority = JOB_PRIORITY_LOW;
+
+	job->Status = JOB_STATUS_QUEUED;
+	job->next   = NULL;
+	if (queued_tail[priority]) {
+		queued_tail[priority]->next = job;
+	} else {
+		queued_head[priority] = job;
+	}
+	queued_tail[priority] = job;
+}
+
+static struct Job* Jobs_Dequeue(void) {
+	struct Job* job;
+	int i;
+
+	for (i = 0; i < JOB_PRIORITY_COUNT; i++)
+	{
+		job = queued_head[i];
+		if (!job) continue;
+
+		queued_head[i] = job->next;
+		if (!queued_head[i]) queued_tail[i] = NULL;
+		job->Status = JOB_STATUS_RUNNING;
+		return job;
+	}
+	return NULL;
+}
+
+static cc_bool Jobs_Remove(struct Job* job) {
+	struct Job* prev;
+	struct Job* cur;
+	int i;
+
+	for (i = 0; i < JOB_PRIORITY_COUNT; i++)
+	{
+		for (prev = NULL, cur = queued_head[i]; cur; prev = cur, cur = cur->next)
+		{
+			if (cur != job) continue;
+
+			if (prev) { prev->next = cur->next; } else { queued_head[i] = cur->next; }
+			if (queued_tail[i] == cur) queued_tail[i] = prev;
+			job->Status = JOB_STATUS_NONE;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void Jobs_Finish(struct Job* job) {
+	job->Status = JOB_STATUS_COMPLETED;
+	job->next   = NULL;
+	if (done_tail) {
+		done_tail->next = job;
+	} else {
+		done_head = job;
+	}
+	done_tail = job;
+}
+
+static void Jobs_ClearQueued(void) {
+	struct Job* job;
+	int i;
+
+	for (i = 0; i < JOB_PRIORITY_COUNT; i++)
+	{
+		for (job = queued_head[i]; job; job = job->next) job->Status = JOB_STATUS_NONE;
+		queued_head[i] = NULL;
+		queued_tail[i] = NULL;
+	}
+	done_head = NULL;
+	done_tail = NULL;
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Worker threads---------------------------------------------------*
+*#########################################################################################################################*/
+/* Systems without preemptive multitasking gain nothing from running jobs on other threads */
+#if !defined CC_BUILD_COOPTHREADED && (!defined CC_BUILD_WEB || defined CC_BUILD_WEBTHREADS)
+#define JOBS_MAX_THREADS 16
+
+struct JobsWorker {
+	void* thread;
+	void* wakeup;
+};
+
+static struct JobsWorker workers[JOBS_MAX_THREADS];
+static int workersCount, workersStarted;
+static volatile cc_bool workersQuit;
+static void* jobsMutex;
+
+static void WorkerLoop(void) {
+	struct JobsWorker* worker;
+	struct Job* job;
+
+	Mutex_Lock(jobsMutex);
+	worker = &workers[workersStarted++];
+	Mutex_Unlock(jobsMutex);
+
+	while (!workersQuit)
+	{
+		Mutex_Lock(jobsMutex);
+		job = Jobs_Dequeue();
+		Mutex_Unlock(jobsMutex);
+
+		if (!job) { Waitable_Wait(worker->wakeup); continue; }
+		job->Run(job);
+
+		Mutex_Lock(jobsMutex);
+		Jobs_Finish(job);
+		Mutex_Unlock(jobsMutex);
+	}
+}
+
+void Jobs_Submit(struct Job* job) {
+	int i;
+	if (!workersCount) {
+		Jobs_Enqueue(job); return;
+	}
+
+	Mutex_Lock(jobsMutex);
+	Jobs_Enqueue(job);
+	Mutex_Unlock(jobsMutex);
+
+	/* Any idle worker can pick up the job, busy ones just check the queue again */
+	for (i = 0; i < workersCount; i++)
+	{
+		Waitable_Signal(workers[i].wakeup);
+	}
+}
+
+cc_bool Jobs_Cancel(struct Job* job) {
+	cc_bool removed;
+	if (!workersCount) return Jobs_Remove(job);
+
+	Mutex_Lock(jobsMutex);
+	removed = Jobs_Remove(job);
+	Mutex_Unlock(jobsMutex);
+	return removed;
+}
+
+int Jobs_WorkersCount(void) { return workersCount; }
+
+static struct Job* Jobs_TakeCompleted(void) {
+	struct Job* job;
+	/* Without worker threads, queued jobs are instead run here on the main thread */
+	if (!workersCount) {
+		while ((job = Jobs_Dequeue())) { job->Run(job); Jobs_Finish(job); }
+		job       = done_head;
+		done_head = NULL;
+		done_tail = NULL;
+		return job;
+	}
+
+	Mutex_Lock(jobsMutex);
+	job       = done_head;
+	done_head = NULL;
+	done_tail = NULL;
+	Mutex_Unlock(jobsMutex);
+	return job;
+}
+
+static void Jobs_StartWorkers(void) {
+	int i, count;
+#if defined CC_BUILD_CONSOLE || defined CC_BUILD_LOWMEM
+	count = Options_GetInt(OPT_JOB_THREADS, 0, JOBS_MAX_THREADS, 1);
+#else
+	count = Options_GetInt(OPT_JOB_THREADS, 0, JOBS_MAX_THREADS, 2);
+#endif
+	if (!count) return;
+
+	jobsMutex      = Mutex_Create("Jobs queue");
+	workersQuit    = false;
+	workersStarted = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		workers[i].wakeup = Waitable_Create("Jobs wakeup");
+	}
+	workersCount = count;
+
+	for (i = 0; i < workersCount; i++)
+	{
+		Thread_Run(&workers[i].thread, WorkerLoop, 256 * 1024, "Job worker");
+	}
+}
+
+static void Jobs_StopWorkers(void) {
+	int i;
+	workersQuit = true;
+
+	for (i = 0; i < workersCount; i++)
+	{
+		Waitable_Signal(workers[i].wakeup);
+		Thread_Join(workers[i].thread);
+		Waitable_Free(workers[i].wakeup);
+	}
+	if (!jobsMutex) return;
+
+	Mutex_Free(jobsMutex);
+	workersCount = 0;
+	jobsMutex    = NULL;
+}
+#else
+void Jobs_Submit(struct Job* job) { Jobs_Enqueue(job); }
+cc_bool Jobs_Cancel(struct Job* job) { return Jobs_Remove(job); }
+int Jobs_WorkersCount(void) { return 0; }
+
+static struct Job* Jobs_TakeCompleted(void) {
+	struct Job* job;
+	while ((job = Jobs_Dequeue())) { job->Run(job); Jobs_Finish(job); }
+
+	job       = done_head;
+	done_head = NULL;
+	done_tail = NULL;
+	return job;
+}
+
+static void Jobs_StartWorkers(void) { }
+static void Jobs_StopWorkers(void)  { }
+#endif
+
+void Jobs_ProcessCompleted(void) {
+	struct Job* job;
+	struct Job* next;
+
+	for (job = Jobs_TakeCompleted(); job; job = next)
+	{
+		/* Complete may free or resubmit the job */
+		next = job->next;
+		if (job->Complete) job->Complete(job);
+	}
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Jobs component--------------------------------------------------*
+*#########################################################################################################################*/
+static void OnInit(void) { Jobs_StartWorkers(); }
+
+static void OnFree(void) {
+	Jobs_StopWorkers();
+	/* Jobs which haven't completed yet will never have their callbacks called */
+	Jobs_ClearQueued();
+}
+
+struct IGameComponent Jobs_Component = {
+	OnInit, /* Init */
+	OnFree  /* Free */
+};
@@ -0,0 +1,43 @@
+#ifndef CC_JOBS_H
+#define CC_JOBS_H
+#include "Core.h"
+CC_BEGIN_HEADER
+
+/*
+Runs work on a shared pool of background threads, with completion callbacks run on the main thread
+  Plugins should use this instead of creating their own threads with Thread_Run
+Copyright 2014-2023 ClassiCube | Licensed under BSD-3
+*/
+struct IGameComponent;
+extern struct IGameComponent Jobs_Component;
+
+enum JobPriority { JOB_PRIORITY_HIGH, JOB_PRIORITY_NORMAL, JOB_PRIORITY_LOW, JOB_PRIORITY_COUNT };
+enum JobStatus   { JOB_STATUS_NONE, JOB_STATUS_QUEUED, JOB_STATUS_RUNNING, JOB_STATUS_COMPLETED };
+
+struct Job;
+typedef void (*Job_Func)(struct Job* job);
+struct Job {
+	Job_Func Run;      /* Called on a worker thread to perform the work */
+	Job_Func Complete; /* Called on the main thread once Run has finished (can be NULL) */
+	void* Obj;         /* Arbitrary data for use by the Run and Complete callbacks */
+	cc_uint8 Priority; /* Higher priority jobs are started first (see JobPriority enum) */
+	volatile cc_uint8 Status; /* Current state of the job (see JobStatus enum) */
+	struct Job* next;
+};
+
+/* Queues the given job to be run on a worker thread. */
+/* NOTE: Run must NOT access game state (e.g. the world) without synchronising with the main thread */
+/* NOTE: The job must remain valid until Complete has been called, or Jobs_Cancel succeeds */
+/* NOTE: If the platform does not support threading, jobs are instead run on the main thread */
+CC_API void Jobs_Submit(struct Job* job);
+/* Removes the given job from the queue, if it has not been started by a worker thread yet. */
+/* Returns whether the job was removed (in which case neither Run nor Complete will be called) */
+CC_API cc_bool Jobs_Cancel(struct Job* job);
+/* Returns the number of worker threads in the pool. (0 when jobs run on the main thread) */
+CC_API int Jobs_WorkersCount(void);
+/* Invokes the Complete callbacks of all jobs which have finished since the last call. */
+/* NOTE: This is automatically called every frame by the game */
+void Jobs_ProcessCompleted(void);
+
+CC_END_HEADER
+#endif
@@ -27,6 +27,7 @@
 #include "Stream.h"
 #include "Logger.h"
 #include "Errors.h"
+#include "Http.h"
 
 struct FontDesc titleFont, textFont, hintFont, logoFont, rowFont;
 /* Contains the pixels that are drawn to the window */
@@ -125,14 +126,12 @@ static void LBackend_ScaleFlag(struct Bitmap* bmp) {
 	*bmp = scaled;
 }
 
-void LBackend_DecodeFlag(struct Flag* flag, cc_uint8* data, cc_uint32 len) {
-	struct Stream s;
-	cc_result res;
-
-	Stream_ReadonlyMemory(&s, data, len);
-	res = Png_Decode(&flag->bmp, &s);
-	if (res) Logger_SysWarn(res, "decoding flag");
+void LBackend_DecodeFlag(struct Flag* flag, struct HttpRequest* req) {
+	/* Flag was already decoded by the http worker thread */
+	if (req->imageResult) Logger_SysWarn(req->imageResult, "decoding flag");
+	flag->bmp  = req->image;
 	flag->meta = NULL;
+	req->image.scan0 = NULL;
 
 	LBackend_ScaleFlag(&flag->bmp);
 }
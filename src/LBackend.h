@@ -18,6 +18,7 @@ struct LLine;
 struct LSlider;
 struct LTable;
 struct Flag;
+struct HttpRequest;
 
 typedef void (*LBackend_DrawHook)(struct Context2D* ctx);
 extern LBackend_DrawHook LBackend_Hooks[4];
@@ -30,7 +31,7 @@ void LBackend_CloseScreen(struct LScreen* s);
 void LBackend_UpdateTitleFont(void);
 void LBackend_DrawTitle(struct Context2D* ctx, const char* title);
 
-void LBackend_DecodeFlag(struct Flag* flag, cc_uint8* data, cc_uint32 len);
+void LBackend_DecodeFlag(struct Flag* flag, struct HttpRequest* req);
 void LBackend_TableFlagAdded(struct LTable* w);
 
 /* Marks the entire launcher contents as needing to be redrawn */
@@ -12,6 +12,7 @@
 #include "LScreens.h"
 #include "Gui.h"
 #include "LWeb.h"
+#include "Http.h"
 #include "Funcs.h"
 #include "Window.h"
 #include <UIKit/UIKit.h>
@@ -583,6 +584,7 @@ static void LTable_UpdateCell(UITableView* table, UITableViewCell* cell, int row
     LTable_FormatUptime(&desc, server->uptime);
     if (server->software.length) String_Format1(&desc, " | %s", &server->software);
     
+    if (!flag) FetchFlagsTask_Add(server);
     if (flag && flag->meta)
         cell.imageView.image = (__bridge UIImage*)flag->meta;
         
@@ -611,8 +613,8 @@ void LBackend_TableFlagAdded(struct LTable* w) {
 /*########################################################################################################################*
  *------------------------------------------------------UI Backend--------------------------------------------------------*
  *#########################################################################################################################*/
-void LBackend_DecodeFlag(struct Flag* flag, cc_uint8* data, cc_uint32 len) {
-	NSData* ns_data = [NSData dataWithBytes:data length:len];
+void LBackend_DecodeFlag(struct Flag* flag, struct HttpRequest* req) {
+	NSData* ns_data = [NSData dataWithBytes:req->data length:req->size];
 	UIImage* img = [UIImage imageWithData:ns_data];
 	if (!img) return;
 	
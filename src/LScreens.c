@@ -976,8 +976,16 @@ static void MainScreen_ServersError(struct HttpRequest* req) {
 
 static void MainScreen_TickFetchServers(struct MainScreen* s) {
 	if (!FetchServersTask.Base.working)   return;
+	FetchServersTask_Poll();
 	LWebTask_Tick(&FetchServersTask.Base, MainScreen_ServersError);
 
+	/* Show the servers list as soon as the first servers have arrived */
+	if (!Launcher_AutoHash.length && FetchServersTask.numServers) {
+		s->signingIn = false;
+		ServersScreen_SetActive();
+		return;
+	}
+
 	if (!FetchServersTask.Base.completed) return;
 	if (!FetchServersTask.Base.success)   return;
 
@@ -1287,14 +1295,9 @@ static void ServersScreen_OnSelectedChanged(void) {
 	LBackend_NeedsRedraw(&s->table);
 }
 
+/* Flags are only downloaded when a server row is first drawn */
 static void ServersScreen_ReloadServers(struct ServersScreen* s) {
-	int i;
 	LTable_Sort(&s->table);
-
-	for (i = 0; i < FetchServersTask.numServers; i++) 
-	{
-		FetchFlagsTask_Add(&FetchServersTask.servers[i]);
-	}
 }
 
 static void ServersScreen_AddWidgets(struct ServersScreen* s) {
@@ -1346,12 +1349,16 @@ static void ServersScreen_Tick(struct LScreen* s_) {
 	LScreen_Tick(s_);
 
 	flagsCount = FetchFlagsTask.count;
-	LWebTask_Tick(&FetchFlagsTask.Base, NULL);
+	FetchFlagsTask_Tick();
 	if (flagsCount != FetchFlagsTask.count) {
 		LBackend_TableFlagAdded(&s->table);
 	}
 
 	if (!FetchServersTask.Base.working) return;
+	if (FetchServersTask_Poll()) {
+		ServersScreen_ReloadServers(s);
+		LBackend_NeedsRedraw(&s->table);
+	}
 	LWebTask_Tick(&FetchServersTask.Base, NULL);
 	if (!FetchServersTask.Base.completed) return;
 
@@ -12,6 +12,7 @@
 #include "Utils.h"
 #include "Http.h"
 #include "LBackend.h"
+#include "Funcs.h"
 
 /*########################################################################################################################*
 *----------------------------------------------------------JSON-----------------------------------------------------------*
@@ -218,6 +219,7 @@ static void LWebTask_Reset(struct LWebTask* task) {
 	task->completed = false;
 	task->working   = true;
 	task->success   = false;
+	task->HandleRequest = NULL;
 }
 
 void LWebTask_Tick(struct LWebTask* task, LWebTask_ErrorCallback errorCallback) {
@@ -230,7 +232,9 @@ void LWebTask_Tick(struct LWebTask* task, LWebTask_ErrorCallback errorCallback)
 	task->completed = true;
 	task->success   = item.success;
 
-	if (item.success) {
+	if (item.success && task->HandleRequest) {
+		task->HandleRequest(&item);
+	} else if (item.success) {
 		task->Handle(item.data, item.size);
 	} else if (errorCallback) {
 		errorCallback(&item);
@@ -470,47 +474,140 @@ void FetchServerTask_Run(const cc_string* hash) {
 > ]}
 */
 struct FetchServersData FetchServersTask;
-static void FetchServersTask_Count(struct JsonContext* ctx) {
-	/* JSON is expected in this format: */
-	/*  { "servers" :      (depth = 1)  */
-	/*    [                (depth = 2)  */
-	/*	     { server1 },  (depth = 3)  */
-	/*		 { server2 },  (depth = 3)  */
-	/*          ...                     */
-	if (ctx->depth != 3) return;
+static int serversCapacity;
+
+/* The response is parsed incrementally as it downloads, by tracking nesting depth */
+/*  to find the end of each server object, and then parsing each object by itself */
+/* JSON is expected in this format: */
+/*  { "servers" :      (depth = 1)  */
+/*    [                (depth = 2)  */
+/*	     { server1 },  (depth = 3)  */
+/*		 { server2 },  (depth = 3)  */
+/*          ...                     */
+static struct ServersParser {
+	cc_uint8* data;     /* Response data not yet fully parsed */
+	cc_uint32 len, capacity;
+	cc_uint32 objStart; /* Offset in data of the server object currently being parsed */
+	int depth;
+	cc_bool inString, escaped, started, failed;
+} serversParser;
+
+static void FetchServersTask_Clear(void) {
+	Mem_Free(FetchServersTask.servers);
+	Mem_Free(FetchServersTask.orders);
+
+	FetchServersTask.numServers = 0;
+	FetchServersTask.servers    = NULL;
+	FetchServersTask.orders     = NULL;
+	serversCapacity = 0;
+}
+
+static void FetchServersTask_AddServer(cc_uint8* data, cc_uint32 len) {
+	int i, count = FetchServersTask.numServers;
+
+	if (count == serversCapacity) {
+		serversCapacity = serversCapacity ? serversCapacity * 2 : 64;
+		FetchServersTask.servers = (struct ServerInfo*)Mem_Realloc(FetchServersTask.servers, 
+										serversCapacity, sizeof(struct ServerInfo), "servers list");
+		FetchServersTask.orders  = (cc_uint16*)Mem_Realloc(FetchServersTask.orders, 
+										serversCapacity, 2, "servers order");
+
+		/* strings point to buffers inside each server, which have now moved */
+		for (i = 0; i < count; i++) 
+		{
+			curServer = &FetchServersTask.servers[i];
+			curServer->hash.buffer     = curServer->_hashBuffer;
+			curServer->name.buffer     = curServer->_nameBuffer;
+			curServer->ip.buffer       = curServer->_ipBuffer;
+			curServer->mppass.buffer   = curServer->_mppassBuffer;
+			curServer->software.buffer = curServer->_softBuffer;
+		}
+	}
+
+	curServer = &FetchServersTask.servers[count];
+	ServerInfo_Init(curServer);
+	if (!Json_Handle(data, len, ServerInfo_Parse, NULL, NULL)) serversParser.failed = true;
+
+	FetchServersTask.orders[count] = count;
 	FetchServersTask.numServers++;
 }
 
-static void FetchServersTask_Next(struct JsonContext* ctx) {
-	if (ctx->depth != 3) return;
-	curServer++;
-	ServerInfo_Init(curServer);
+/* Parses any server objects that have been completely downloaded */
+/* Returns whether the servers list was changed */
+static cc_bool FetchServersTask_Append(cc_uint8* data, cc_uint32 len) {
+	struct ServersParser* p = &serversParser;
+	cc_bool changed = !p->started;
+	cc_uint32 i, keep;
+	char c;
+
+	/* Only replace the old list once the new list starts arriving */
+	if (!p->started) { FetchServersTask_Clear(); p->started = true; }
+
+	if (p->len + len > p->capacity) {
+		p->capacity = max(p->capacity * 2, p->len + len);
+		p->data     = (cc_uint8*)Mem_Realloc(p->data, p->capacity, 1, "servers JSON");
+	}
+	Mem_Copy(p->data + p->len, data, len);
+	i = p->len; p->len += len;
+
+	for (; i < p->len; i++) 
+	{
+		c = p->data[i];
+		if (p->inString) {
+			if (p->escaped)     p->escaped  = false;
+			else if (c == '\\') p->escaped  = true;
+			else if (c == '"')  p->inString = false;
+			continue;
+		}
+
+		if (c == '"') {
+			p->inString = true;
+		} else if (c == '{' || c == '[') {
+			p->depth++;
+			if (p->depth == 3 && c == '{') p->objStart = i;
+		} else if (c == '}' || c == ']') {
+			if (p->depth == 3 && c == '}') {
+				FetchServersTask_AddServer(p->data + p->objStart, i + 1 - p->objStart);
+				changed = true;
+			}
+			p->depth--;
+		}
+	}
+
+	/* Discard data that no longer needs to be kept around */
+	keep = p->depth >= 3 ? p->objStart : p->len;
+	Mem_Move(p->data, p->data + keep, p->len - keep);
+	p->len      -= keep;
+	p->objStart -= keep;
+
+	return changed;
 }
 
-static void FetchServersTask_Handle(cc_uint8* data, cc_uint32 len) {
-	static cc_string err_msg = String_FromConst("Error parsing servers list response JSON");
+cc_bool FetchServersTask_Poll(void) {
+	cc_uint8* data;
+	cc_uint32 size;
+	cc_bool changed;
+	if (!FetchServersTask.Base.working) return false;
 
-	int count;
-	cc_bool success;
-	Mem_Free(FetchServersTask.servers);
-	Mem_Free(FetchServersTask.orders);
-	Session_Save();
+	size = Http_TakePartial(FetchServersTask.Base.reqID, &data);
+	if (!size) return false;
 
-	FetchServersTask.numServers = 0;
-	FetchServersTask.servers    = NULL;
-	FetchServersTask.orders     = NULL;
+	changed = FetchServersTask_Append(data, size);
+	Mem_Free(data);
+	return changed;
+}
 
-	FetchServersTask.numServers = 0;
-	success = Json_Handle(data, len, NULL, NULL, FetchServersTask_Count);
-	count   = FetchServersTask.numServers;
+static void FetchServersTask_Handle(cc_uint8* data, cc_uint32 len) {
+	static cc_string err_msg = String_FromConst("Error parsing servers list response JSON");
+	struct ServersParser* p  = &serversParser;
+	Session_Save();
 
-	if (!success) Logger_WarnFunc(&err_msg);
-	if (count <= 0) return;
-	FetchServersTask.servers = (struct ServerInfo*)Mem_Alloc(count, sizeof(struct ServerInfo), "servers list");
-	FetchServersTask.orders  = (cc_uint16*)Mem_Alloc(count, 2, "servers order");
+	FetchServersTask_Append(data, len);
+	if (p->failed || p->depth || p->inString) Logger_WarnFunc(&err_msg);
 
-	curServer = FetchServersTask.servers - 1;
-	Json_Handle(data, len, ServerInfo_Parse, NULL, FetchServersTask_Next);
+	Mem_Free(p->data);
+	p->data     = NULL;
+	p->capacity = 0;
 }
 
 void FetchServersTask_Run(void) {
@@ -521,8 +618,11 @@ void FetchServersTask_Run(void) {
 	String_InitArray(url, urlBuffer);
 	String_Format1(&url, "%s/servers", &servicesServer);
 
+	Mem_Free(serversParser.data);
+	Mem_Set(&serversParser, 0, sizeof(serversParser));
+
 	FetchServersTask.Base.Handle = FetchServersTask_Handle;
-	FetchServersTask.Base.reqID  = Http_AsyncGetDataEx(&url, 0, NULL, NULL, &ccCookies);
+	FetchServersTask.Base.reqID  = Http_AsyncGetDataEx(&url, HTTP_FLAG_STREAMING, NULL, NULL, &ccCookies);
 }
 
 void FetchServersTask_ResetOrder(void) {
@@ -628,28 +728,49 @@ struct FetchFlagsData FetchFlagsTask;
 static int flagsCount, flagsCapacity;
 static struct Flag* flags;
 
-static void FetchFlagsTask_DownloadNext(void);
-static void FetchFlagsTask_Handle(cc_uint8* data, cc_uint32 len) {
-	struct Flag* flag = &flags[FetchFlagsTask.count];
-	LBackend_DecodeFlag(flag, data, len);
-	
-	FetchFlagsTask.count++;
-	FetchFlagsTask_DownloadNext();
-}
+/* Max number of flags being downloaded at once */
+#define FLAGS_MAX_REQUESTS 4
+static int flagsRequesting, flagsNextQueued;
 
+/* Flags are downloaded and decoded by the http worker threads, and are cached on disk */
 static void FetchFlagsTask_DownloadNext(void) {
 	cc_string url; char urlBuffer[URL_MAX_SIZE];
-	String_InitArray(url, urlBuffer);
+	struct Flag* flag;
+
+	for (; flagsNextQueued < flagsCount && flagsRequesting < FLAGS_MAX_REQUESTS; flagsNextQueued++) 
+	{
+		flag = &flags[flagsNextQueued];
+		String_InitArray(url, urlBuffer);
+		String_Format2(&url, RESOURCE_SERVER "/img/flags/%r%r.png",
+				&flag->country[0], &flag->country[1]);
 
-	if (FetchFlagsTask.Base.working)        return;
-	if (FetchFlagsTask.count == flagsCount) return;
+		flag->reqID = Http_AsyncGetData(&url, HTTP_FLAG_DECODEPNG | HTTP_FLAG_DISKCACHE);
+		flagsRequesting++;
+	}
+}
 
-	LWebTask_Reset(&FetchFlagsTask.Base);
-	String_Format2(&url, RESOURCE_SERVER "/img/flags/%r%r.png",
-			&flags[FetchFlagsTask.count].country[0], &flags[FetchFlagsTask.count].country[1]);
+void FetchFlagsTask_Tick(void) {
+	struct HttpRequest item;
+	struct Flag* flag;
+	int i;
+	if (!flagsRequesting) return;
 
-	FetchFlagsTask.Base.Handle = FetchFlagsTask_Handle;
-	FetchFlagsTask.Base.reqID  = Http_AsyncGetData(&url, 0);
+	for (i = 0; i < flagsNextQueued; i++) 
+	{
+		flag = &flags[i];
+		if (!flag->reqID || !Http_GetResult(flag->reqID, &item)) continue;
+
+		flag->reqID = 0;
+		flagsRequesting--;
+
+		if (item.success) {
+			LBackend_DecodeFlag(flag, &item);
+			flag->loaded = true;
+			FetchFlagsTask.count++;
+		}
+		HttpRequest_Free(&item);
+	}
+	FetchFlagsTask_DownloadNext();
 }
 
 static void FetchFlagsTask_Ensure(void) {
@@ -677,7 +798,9 @@ void FetchFlagsTask_Add(const struct ServerInfo* server) {
 	Bitmap_Init(flags[flagsCount].bmp, 0, 0, NULL);
 	flags[flagsCount].country[0] = server->country[0];
 	flags[flagsCount].country[1] = server->country[1];
-	flags[flagsCount].meta = NULL;
+	flags[flagsCount].meta   = NULL;
+	flags[flagsCount].reqID  = 0;
+	flags[flagsCount].loaded = false;
 
 	flagsCount++;
 	FetchFlagsTask_DownloadNext();
@@ -685,23 +808,25 @@ void FetchFlagsTask_Add(const struct ServerInfo* server) {
 
 struct Flag* Flags_Get(const struct ServerInfo* server) {
 	int i;
-	for (i = 0; i < FetchFlagsTask.count; i++) 
+	for (i = 0; i < flagsCount; i++) 
 	{
 		if (flags[i].country[0] != server->country[0]) continue;
 		if (flags[i].country[1] != server->country[1]) continue;
-		return &flags[i];
+		return flags[i].loaded ? &flags[i] : NULL;
 	}
 	return NULL;
 }
 
 void Flags_Free(void) {
 	int i;
-	for (i = 0; i < FetchFlagsTask.count; i++) {
+	for (i = 0; i < flagsCount; i++) {
 		Mem_Free(flags[i].bmp.scan0);
 	}
 
     flagsCount = 0;
     FetchFlagsTask.count = 0;
+    flagsRequesting = 0;
+    flagsNextQueued = 0;
 }
 
 
@@ -50,6 +50,8 @@ struct Flag {
 	struct Bitmap bmp;
 	char country[2]; /* ISO 3166-1 alpha-2 */
 	void* meta; /* Backend specific meta */
+	int reqID;  /* (internal) ID of request downloading this flag, 0 if none */
+	cc_bool loaded;
 };
 
 struct LWebTask {
@@ -60,6 +62,8 @@ struct LWebTask {
 	int reqID; /* Unique request identifier for this web task. */
 	/* Called when task successfully downloaded/uploaded data. */
 	void (*Handle)(cc_uint8* data, cc_uint32 len);
+	/* If not NULL, called instead of Handle with the entire completed request. (e.g. for its image) */
+	void (*HandleRequest)(struct HttpRequest* req);
 };
 typedef void (*LWebTask_ErrorCallback)(struct HttpRequest* req);
 
@@ -98,6 +102,8 @@ extern struct FetchServersData {
 	int numServers;             /* Number of public servers. */
 } FetchServersTask;
 void FetchServersTask_Run(void);
+/* Parses any servers that have been downloaded so far, returning whether the list changed */
+cc_bool FetchServersTask_Poll(void);
 void FetchServersTask_ResetOrder(void);
 #define Servers_Get(i) (&FetchServersTask.servers[FetchServersTask.orders[i]])
 
@@ -121,13 +127,14 @@ void FetchUpdateTask_Run(cc_bool release, int buildIndex);
 
 
 extern struct FetchFlagsData { 
-	struct LWebTask Base;
 	/* Number of flags downloaded. */
 	int count;
 } FetchFlagsTask;
 
 /* Asynchronously downloads the flag associated with the given server's country. */
 void FetchFlagsTask_Add(const struct ServerInfo* server);
+/* Processes any flags which have finished downloading. */
+void FetchFlagsTask_Tick(void);
 /* Gets the country flag associated with the given server's country. */
 struct Flag* Flags_Get(const struct ServerInfo* server);
 /* Frees all flag bitmaps. */
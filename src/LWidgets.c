@@ -499,7 +499,7 @@ void LSlider_SetProgress(struct LSlider* w, int progress) {
 *#########################################################################################################################*/
 static void FlagColumn_Draw(struct ServerInfo* row, struct DrawTextArgs* args, struct LTableCell* cell, struct Context2D* ctx) {
 	struct Flag* flag = Flags_Get(row);
-	if (!flag) return;
+	if (!flag) { FetchFlagsTask_Add(row); return; }
 	Context2D_DrawPixels(ctx, cell->x + flagXOffset, cell->y + flagYOffset, &flag->bmp);
 }
 
@@ -504,15 +504,18 @@ CC_NOINLINE static void ClearTile(int x, int y, int width, int height,
 	struct Bitmap* dst = (struct Bitmap*)ctx;
 	BitmapCol* dstRow;
 	BitmapCol* srcRow;
-	int xx, yy;
+	int xx, yy, srcX, count;
 	if (!Drawer2D_Clamp(ctx, &x, &y, &width, &height)) return;
 
 	for (yy = 0; yy < height; yy++) {
 		srcRow = Bitmap_GetRow(src, (y + yy) % TILESIZE);
 		dstRow = Bitmap_GetRow(dst, y + yy) + x;
 
-		for (xx = 0; xx < width; xx++) {
-			dstRow[xx] = srcRow[(x + xx) % TILESIZE];
+		/* Copy each run of pixels up to the tile's right edge at once */
+		for (xx = 0; xx < width; xx += count) {
+			srcX  = (x + xx) % TILESIZE;
+			count = min(TILESIZE - srcX, width - xx);
+			Mem_Copy(dstRow + xx, srcRow + srcX, count * BITMAPCOLOR_SIZE);
 		}
 	}
 }
@@ -29,12 +29,52 @@ void Lighting_SetMode(cc_uint8 mode, cc_bool fromServer) {
 	Event_RaiseLightingMode(&WorldEvents.LightingModeChanged, oldMode, fromServer);
 }
 
+cc_bool Lighting_Batching;
+static int batchDepth;
+
+void Lighting_BeginBatch(void) {
+	batchDepth++;
+	Lighting_Batching = true;
+}
+
+void Lighting_EndBatch(void) {
+	if (--batchDepth > 0) return;
+
+	batchDepth        = 0;
+	Lighting_Batching = false;
+	Lighting.FlushBatch();
+}
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Classic lighting-----------------------------------------------------*
 *#########################################################################################################################*/
-static cc_int16* classic_heightmap;
+cc_int16* ClassicLighting_Heightmap;
+cc_uint8* ClassicLighting_Heightmap8;
 #define HEIGHT_UNCALCULATED Int16_MaxValue
+/* Maps with few enough Y levels store each column's light height in just 1 byte */
+/* (biased so that -10 (nothing blocks light) and -1 are still representable) */
+#define HEIGHTMAP8_UNCALCULATED 0xFF
+#define HEIGHTMAP8_MAX_HEIGHT   (HEIGHTMAP8_UNCALCULATED - CLASSIC_HEIGHTMAP8_BIAS)
+
+static CC_INLINE int Heightmap_Get(int hIndex) {
+	int height;
+	if (!ClassicLighting_Heightmap8) return ClassicLighting_Heightmap[hIndex];
+
+	height = ClassicLighting_Heightmap8[hIndex];
+	if (height == HEIGHTMAP8_UNCALCULATED) return HEIGHT_UNCALCULATED;
+	return height ? height - CLASSIC_HEIGHTMAP8_BIAS : -10;
+}
+
+static CC_INLINE void Heightmap_Set(int hIndex, int height) {
+	if (!ClassicLighting_Heightmap8) {
+		ClassicLighting_Heightmap[hIndex] = (cc_int16)height;
+	} else if (height == HEIGHT_UNCALCULATED) {
+		ClassicLighting_Heightmap8[hIndex] = HEIGHTMAP8_UNCALCULATED;
+	} else {
+		ClassicLighting_Heightmap8[hIndex] = height == -10 ? 0 : (cc_uint8)(height + CLASSIC_HEIGHTMAP8_BIAS);
+	}
+}
 
 #define ClassicLighting_CalcBody(get_block)\
 for (y = maxY; y >= 0; y--, i -= World.OneY) {\
@@ -42,7 +82,7 @@ for (y = maxY; y >= 0; y--, i -= World.OneY) {\
 \
 	if (Blocks.BlocksLight[block]) {\
 		offset = (Blocks.LightOffset[block] >> LIGHT_FLAG_SHADES_FROM_BELOW) & 1;\
-		classic_heightmap[hIndex] = y - offset;\
+		Heightmap_Set(hIndex, y - offset);\
 		return y - offset;\
 	}\
 }
@@ -52,23 +92,25 @@ static int ClassicLighting_CalcHeightAt(int x, int maxY, int z, int hIndex) {
 	BlockID block;
 	int y, offset;
 
-#ifndef EXTENDED_BLOCKS
+#if defined CC_BUILD_BRICKWORLD
+	ClassicLighting_CalcBody(World_GetBlock(x, y, z));
+#elif !defined EXTENDED_BLOCKS
 	ClassicLighting_CalcBody(World.Blocks[i]);
 #else
 	if (World.IDMask <= 0xFF) {
 		ClassicLighting_CalcBody(World.Blocks[i]);
 	} else {
-		ClassicLighting_CalcBody(World.Blocks[i] | (World.Blocks2[i] << 8));
+		ClassicLighting_CalcBody(World_GetRawBlock(i));
 	}
 #endif
 
-	classic_heightmap[hIndex] = -10;
+	Heightmap_Set(hIndex, -10);
 	return -10;
 }
 
 int ClassicLighting_GetLightHeight(int x, int z) {
 	int hIndex = Lighting_Pack(x, z);
-	int lightH = classic_heightmap[hIndex];
+	int lightH = Heightmap_Get(hIndex);
 	return lightH == HEIGHT_UNCALCULATED ? ClassicLighting_CalcHeightAt(x, World.Height - 1, z, hIndex) : lightH;
 }
 
@@ -78,7 +120,7 @@ cc_bool ClassicLighting_IsLit(int x, int y, int z) {
 }
 
 cc_bool ClassicLighting_IsLit_Fast(int x, int y, int z) {
-	return y > classic_heightmap[Lighting_Pack(x, z)];
+	return y > Heightmap_Get(Lighting_Pack(x, z));
 }
 
 static PackedCol ClassicLighting_Color(int x, int y, int z) {
@@ -98,30 +140,36 @@ static PackedCol ClassicLighting_Color_XSide(int x, int y, int z) {
 }
 
 static PackedCol ClassicLighting_Color_Sprite_Fast(int x, int y, int z) {
-	return y > classic_heightmap[Lighting_Pack(x, z)] ? Env.SunCol : Env.ShadowCol;
+	return y > Heightmap_Get(Lighting_Pack(x, z)) ? Env.SunCol : Env.ShadowCol;
 }
 
 static PackedCol ClassicLighting_Color_YMax_Fast(int x, int y, int z) {
-	return y > classic_heightmap[Lighting_Pack(x, z)] ? Env.SunCol : Env.ShadowCol;
+	return y > Heightmap_Get(Lighting_Pack(x, z)) ? Env.SunCol : Env.ShadowCol;
 }
 
 static PackedCol ClassicLighting_Color_YMin_Fast(int x, int y, int z) {
-	return y > classic_heightmap[Lighting_Pack(x, z)] ? Env.SunYMin : Env.ShadowYMin;
+	return y > Heightmap_Get(Lighting_Pack(x, z)) ? Env.SunYMin : Env.ShadowYMin;
 }
 
 static PackedCol ClassicLighting_Color_XSide_Fast(int x, int y, int z) {
-	return y > classic_heightmap[Lighting_Pack(x, z)] ? Env.SunXSide : Env.ShadowXSide;
+	return y > Heightmap_Get(Lighting_Pack(x, z)) ? Env.SunXSide : Env.ShadowXSide;
 }
 
 static PackedCol ClassicLighting_Color_ZSide_Fast(int x, int y, int z) {
-	return y > classic_heightmap[Lighting_Pack(x, z)] ? Env.SunZSide : Env.ShadowZSide;
+	return y > Heightmap_Get(Lighting_Pack(x, z)) ? Env.SunZSide : Env.ShadowZSide;
 }
 
+static void ClassicLighting_ClearBatch(void);
 void ClassicLighting_Refresh(void) {
 	int i;
-	for (i = 0; i < World.Width * World.Length; i++) {
-		classic_heightmap[i] = HEIGHT_UNCALCULATED;
+	if (ClassicLighting_Heightmap8) {
+		Mem_Set(ClassicLighting_Heightmap8, HEIGHTMAP8_UNCALCULATED, World.Width * World.Length);
+	} else {
+		for (i = 0; i < World.Width * World.Length; i++) {
+			ClassicLighting_Heightmap[i] = HEIGHT_UNCALCULATED;
+		}
 	}
+	ClassicLighting_ClearBatch();
 }
 
 
@@ -143,7 +191,7 @@ static void ClassicLighting_UpdateLighting(int x, int y, int z, BlockID oldBlock
 
 	if ((y - newOffset) >= lightH) {
 		if (nowBlocks) {
-			classic_heightmap[index] = y - newOffset;
+			Heightmap_Set(index, y - newOffset);
 		} else {
 			/* Part of the column is now visible to light, we don't know how exactly how high it should be though. */
 			/* However, we know that if the block Y was above or equal to old light height, then the new light height must be <= block Y */
@@ -156,7 +204,7 @@ static void ClassicLighting_UpdateLighting(int x, int y, int z, BlockID oldBlock
 		if (Blocks.BlocksLight[above]) return;
 
 		if (nowBlocks) {
-			classic_heightmap[index] = y - newOffset;
+			Heightmap_Set(index, y - newOffset);
 		} else {
 			ClassicLighting_CalcHeightAt(x, y - 1, z, index);
 		}
@@ -179,13 +227,15 @@ static cc_bool ClassicLighting_NeedsNeighour(BlockID block, int i, int minY, int
 	BlockID other;
 	cc_bool affected;
 
-#ifndef EXTENDED_BLOCKS
+#if defined CC_BUILD_BRICKWORLD
+	ClassicLighting_NeedsNeighourBody(World_GetRawBlock(i));
+#elif !defined EXTENDED_BLOCKS
 	ClassicLighting_NeedsNeighourBody(World.Blocks[i]);
 #else
 	if (World.IDMask <= 0xFF) {
 		ClassicLighting_NeedsNeighourBody(World.Blocks[i]);
 	} else {
-		ClassicLighting_NeedsNeighourBody(World.Blocks[i] | (World.Blocks2[i] << 8));
+		ClassicLighting_NeedsNeighourBody(World_GetRawBlock(i));
 	}
 #endif
 	return false;
@@ -255,17 +305,89 @@ static void ClassicLighting_RefreshAffected(int x, int y, int z, BlockID block,
 	}
 }
 
+/*########################################################################################################################*
+*----------------------------------------------------Batched updates------------------------------------------------------*
+*#########################################################################################################################*/
+/* While batching, columns are only marked as dirty instead of updating the heightmap for every */
+/*  single block change, and then the heightmap of each dirty column is recalculated just once */
+static cc_uint8* dirtyFlags;
+static int* dirtyColumns;
+static int dirtyCount, dirtyCapacity;
+#define ClassicLighting_IsDirty(hIndex) (dirtyFlags[(hIndex) >> 3] & (1 << ((hIndex) & 7)))
+
+static void ClassicLighting_MarkDirty(int hIndex) {
+	if (!dirtyFlags) {
+		dirtyFlags = (cc_uint8*)Mem_AllocCleared((World.Width * World.Length + 7) >> 3, 1, "lighting dirty flags");
+	}
+	if (ClassicLighting_IsDirty(hIndex)) return;
+
+	if (dirtyCount == dirtyCapacity) {
+		dirtyCapacity = max(256, dirtyCapacity * 2);
+		dirtyColumns  = (int*)Mem_Realloc(dirtyColumns, dirtyCapacity, sizeof(int), "lighting dirty columns");
+	}
+
+	dirtyFlags[hIndex >> 3] |= 1 << (hIndex & 7);
+	dirtyColumns[dirtyCount++] = hIndex;
+}
+
+static void ClassicLighting_ClearBatch(void) {
+	int i, hIndex;
+	for (i = 0; i < dirtyCount; i++) 
+	{
+		hIndex = dirtyColumns[i];
+		dirtyFlags[hIndex >> 3] = 0;
+	}
+	dirtyCount = 0;
+}
+
+static void ClassicLighting_FreeBatch(void) {
+	Mem_Free(dirtyFlags);
+	Mem_Free(dirtyColumns);
+
+	dirtyFlags    = NULL;
+	dirtyColumns  = NULL;
+	dirtyCount    = 0;
+	dirtyCapacity = 0;
+}
+
+void ClassicLighting_FlushBatch(void) {
+	int i, x, y, z, hIndex;
+	int oldHeight, newHeight;
+
+	for (i = 0; i < dirtyCount; i++) 
+	{
+		hIndex = dirtyColumns[i];
+		x = hIndex % World.Width;
+		z = hIndex / World.Width;
+
+		oldHeight = Heightmap_Get(hIndex);
+		newHeight = ClassicLighting_CalcHeightAt(x, World.MaxY, z, hIndex);
+		if (oldHeight == newHeight) continue;
+
+		y = max(newHeight, 0);
+		ClassicLighting_RefreshAffected(x, y, z, World_GetBlock(x, y, z), oldHeight + 1, newHeight + 1);
+	}
+	ClassicLighting_ClearBatch();
+}
+
 void ClassicLighting_OnBlockChanged(int x, int y, int z, BlockID oldBlock, BlockID newBlock) {
 	int hIndex = Lighting_Pack(x, z);
-	int lightH = classic_heightmap[hIndex];
+	int lightH = Heightmap_Get(hIndex);
 	int newHeight;
 
 	/* Since light wasn't checked to begin with, means column never had meshes for any of its chunks built. */
 	/* So we don't need to do anything. */
 	if (lightH == HEIGHT_UNCALCULATED) return;
 
+	if (Lighting_Batching) {
+		ClassicLighting_MarkDirty(hIndex);
+		/* Chunks around the block still need refreshing, same as when the light height doesn't change */
+		ClassicLighting_RefreshAffected(x, y, z, newBlock, lightH + 1, lightH + 1);
+		return;
+	}
+
 	ClassicLighting_UpdateLighting(x, y, z, oldBlock, newBlock, hIndex, lightH);
-	newHeight = classic_heightmap[hIndex] + 1;
+	newHeight = Heightmap_Get(hIndex) + 1;
 	ClassicLighting_RefreshAffected(x, y, z, newBlock, lightH + 1, newHeight);
 }
 
@@ -280,7 +402,7 @@ static int Heightmap_InitialCoverage(int x1, int z1, int xCount, int zCount, int
 	for (z = 0; z < zCount; z++) {
 		hIndex = Lighting_Pack(x1, z1 + z);
 		for (x = 0; x < xCount; x++) {
-			lightH = classic_heightmap[hIndex++];
+			lightH = Heightmap_Get(hIndex++);
 
 			skip[index] = 0;
 			if (lightH == HEIGHT_UNCALCULATED) {
@@ -312,7 +434,7 @@ for (y = World.Height - 1; y >= 0; y--) {\
 \
 			if (x < xCount && Blocks.BlocksLight[get_block]) {\
 				lightOffset = (Blocks.LightOffset[get_block] >> LIGHT_FLAG_SHADES_FROM_BELOW) & 1;\
-				classic_heightmap[hIndex + x] = (cc_int16)(y - lightOffset);\
+				Heightmap_Set(hIndex + x, y - lightOffset);\
 				elemsLeft--;\
 				skip[index] = 0;\
 \
@@ -346,13 +468,15 @@ static cc_bool Heightmap_CalculateCoverage(int x1, int z1, int xCount, int zCoun
 	int mapIndex, hIndex, baseIndex, index;
 	int x, y, z;
 
-#ifndef EXTENDED_BLOCKS
+#if defined CC_BUILD_BRICKWORLD
+	Heightmap_CalculateBody(World_GetBlock(x1 + x, y, z1 + z));
+#elif !defined EXTENDED_BLOCKS
 	Heightmap_CalculateBody(World.Blocks[mapIndex]);
 #else
 	if (World.IDMask <= 0xFF) {
 		Heightmap_CalculateBody(World.Blocks[mapIndex]);
 	} else {
-		Heightmap_CalculateBody(World.Blocks[mapIndex] | (World.Blocks2[mapIndex] << 8));
+		Heightmap_CalculateBody(World_GetRawBlock(mapIndex));
 	}
 #endif
 	return false;
@@ -364,10 +488,10 @@ static void Heightmap_FinishCoverage(int x1, int z1, int xCount, int zCount) {
 	for (z = 0; z < zCount; z++) {
 		hIndex = Lighting_Pack(x1, z1 + z);
 		for (x = 0; x < xCount; x++, hIndex++) {
-			lightH = classic_heightmap[hIndex];
+			lightH = Heightmap_Get(hIndex);
 
 			if (lightH == HEIGHT_UNCALCULATED) {
-				classic_heightmap[hIndex] = -10;
+				Heightmap_Set(hIndex, -10);
 			}
 		}
 	}
@@ -386,15 +510,81 @@ void ClassicLighting_LightHint(int startX, int startY, int startZ) {
 	}
 }
 
+
+/*########################################################################################################################*
+*---------------------------------------------------Parallel heightmap----------------------------------------------------*
+*#########################################################################################################################*/
+/* Calculating the heightmap lazily means the first chunk builds after loading a map are slow, */
+/*  so instead calculate the heightmap for the entire map spread across multiple threads */
+/* Each slab of Z rows only writes to its own part of the heightmap, so no other locking is needed */
+#if !defined CC_BUILD_COOPTHREADED && (!defined CC_BUILD_WEB || defined CC_BUILD_WEBTHREADS) && !defined CC_BUILD_LOWMEM && !defined CC_BUILD_PAGEDWORLD
+#define HEIGHTMAP_MAX_WORKERS 3
+static void* slabsMutex;
+static int slabsNext;
+
+static void Heightmap_RunSlabs(void) {
+	int x, z;
+	for (;;)
+	{
+		Mutex_Lock(slabsMutex);
+		{
+			z = slabsNext;
+			if (z < World.Length) slabsNext += EXTCHUNK_SIZE;
+		}
+		Mutex_Unlock(slabsMutex);
+
+		if (z >= World.Length) return;
+		for (x = 0; x < World.Width; x += EXTCHUNK_SIZE) 
+		{
+			ClassicLighting_LightHint(x, 0, z);
+		}
+	}
+}
+
+static void Heightmap_CalculateAll(void) {
+	void* workers[HEIGHTMAP_MAX_WORKERS];
+	int i;
+
+	slabsMutex = Mutex_Create("Heightmap slabs");
+	slabsNext  = 0;
+
+	for (i = 0; i < HEIGHTMAP_MAX_WORKERS; i++) 
+	{
+		Thread_Run(&workers[i], Heightmap_RunSlabs, 64 * 1024, "Heightmap worker");
+	}
+
+	/* Main thread also calculates slabs while waiting */
+	Heightmap_RunSlabs();
+	for (i = 0; i < HEIGHTMAP_MAX_WORKERS; i++) 
+	{
+		Thread_Join(workers[i]);
+	}
+	Mutex_Free(slabsMutex);
+}
+#else
+/* Just leave heightmap to be calculated lazily */
+static void Heightmap_CalculateAll(void) { }
+#endif
+
 void ClassicLighting_FreeState(void) {
-	Mem_Free(classic_heightmap);
-	classic_heightmap = NULL;
+	Mem_Free(ClassicLighting_Heightmap);
+	Mem_Free(ClassicLighting_Heightmap8);
+	ClassicLighting_Heightmap  = NULL;
+	ClassicLighting_Heightmap8 = NULL;
+	ClassicLighting_FreeBatch();
 }
 
 void ClassicLighting_AllocState(void) {
-	classic_heightmap = (cc_int16*)Mem_TryAlloc(World.Width * World.Length, 2);
-	if (classic_heightmap) {
+	void* heightmap;
+	if (World.Height <= HEIGHTMAP8_MAX_HEIGHT) {
+		heightmap = ClassicLighting_Heightmap8 = (cc_uint8*)Mem_TryAlloc(World.Width * World.Length, 1);
+	} else {
+		heightmap = ClassicLighting_Heightmap  = (cc_int16*)Mem_TryAlloc(World.Width * World.Length, 2);
+	}
+
+	if (heightmap) {
 		ClassicLighting_Refresh();
+		Heightmap_CalculateAll();
 	} else {
 		World_OutOfMemory();
 	}
@@ -420,6 +610,7 @@ static void ClassicLighting_SetActive(void) {
 	Lighting.FreeState  = ClassicLighting_FreeState;
 	Lighting.AllocState = ClassicLighting_AllocState;
 	Lighting.LightHint  = ClassicLighting_LightHint;
+	Lighting.FlushBatch = ClassicLighting_FlushBatch;
 }
 
 
@@ -26,6 +26,15 @@ extern cc_bool Lighting_ModeSetByServer;
 extern cc_uint8 Lighting_ModeUserCached;
 void Lighting_SetMode(cc_uint8 mode, cc_bool fromServer);
 
+/* Whether lighting updates from block changes are currently being deferred */
+extern cc_bool Lighting_Batching;
+/* Starts deferring lighting updates from block changes until Lighting_EndBatch */
+/*  (so that e.g. changing thousands of blocks at once only updates affected lighting once) */
+/* NOTE: Batches can be nested, lighting is only updated when the outermost batch ends */
+void Lighting_BeginBatch(void);
+/* Resolves all the lighting updates deferred since Lighting_BeginBatch */
+void Lighting_EndBatch(void);
+
 
 /* How much ambient occlusion to apply in fancy lighting where 1.0f = none and 0.0f = maximum*/
 #define FANCY_AO 0.5F
@@ -72,6 +81,10 @@ CC_VAR extern struct _Lighting {
 	PackedCol (*Color_YMin_Fast)(int x, int y, int z);
 	PackedCol (*Color_XSide_Fast)(int x, int y, int z);
 	PackedCol (*Color_ZSide_Fast)(int x, int y, int z);
+
+	/* Resolves lighting updates from block changes that were deferred while batching */
+	/* NOTE: Implementations ***MUST*** mark all chunks affected by these lighting changes as needing to be refreshed. */
+	void (*FlushBatch)(void);
 } Lighting;
 
 void FancyLighting_SetActive(void);
@@ -86,6 +99,18 @@ void ClassicLighting_LightHint(int startX, int startY, int startZ);
 cc_bool ClassicLighting_IsLit(int x, int y, int z);
 cc_bool ClassicLighting_IsLit_Fast(int x, int y, int z);
 void ClassicLighting_OnBlockChanged(int x, int y, int z, BlockID oldBlock, BlockID newBlock);
+void ClassicLighting_FlushBatch(void);
+
+/* Y coordinate of the highest block which is in shadow, for each column of the map */
+extern cc_int16* ClassicLighting_Heightmap;
+/* Same as ClassicLighting_Heightmap, but with 1 byte per column (only used when World.Height is small enough) */
+/* NOTE: Light heights are stored biased by CLASSIC_HEIGHTMAP8_BIAS */
+extern cc_uint8* ClassicLighting_Heightmap8;
+#define CLASSIC_HEIGHTMAP8_BIAS 2
+/* Same as ClassicLighting_IsLit_Fast, but can be inlined by hot code (e.g. chunk mesh builders) */
+#define ClassicLighting_IsLit_Inline(x, y, z) (ClassicLighting_Heightmap8 ?\
+	((y) + CLASSIC_HEIGHTMAP8_BIAS) > ClassicLighting_Heightmap8[(x) + World.Width * (z)] :\
+	(y) > ClassicLighting_Heightmap[(x) + World.Width * (z)])
 
 CC_END_HEADER
 #endif
@@ -94,6 +94,10 @@ static const char* GetCCErrorDesc(cc_result res) {
 	case PNG_ERR_INVALID_SCANLINE: return "Invalid PNG scanline type";
 	case PNG_ERR_16BITSAMPLES:     return "16 bpp PNGs unsupported";
 
+	case INF_ERR_OUTPUT_SIZE: return "Compressed data larger than expected";
+	case HTTP_ERR_INVALID_RANGE: return "Server returned the wrong part of a resumed download";
+	case ERR_HASH_MISMATCH:   return "Downloaded data is corrupted";
+
 	case NBT_ERR_UNKNOWN:   return "Unknown NBT tag type";
 	case CW_ERR_ROOT_TAG:   return "Invalid root NBT tag";
 	case CW_ERR_STRING_LEN: return "NBT string too long";
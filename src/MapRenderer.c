@@ -14,13 +14,26 @@
 #include "Utils.h"
 #include "World.h"
 #include "Options.h"
+#include "Generator.h"
 
 int MapRenderer_1DUsedCount;
+cc_bool MapRenderer_OcclusionCulling;
+cc_bool MapRenderer_RegionBatching;
+cc_bool MapRenderer_SortTranslucent;
 struct ChunkPartInfo* MapRenderer_PartsNormal;
 struct ChunkPartInfo* MapRenderer_PartsTranslucent;
 
 static cc_bool inTranslucent;
-static IVec3 chunkPos;
+/* Chunk that the camera of each split-screen view is in */
+/* NOTE: All views share the same chunk meshes and build queue, with chunks */
+/*  prioritised by their distance to the closest view */
+static IVec3 chunkPos[MAX_LOCAL_PLAYERS];
+#define CUR_VIEW Game.CurrentState
+
+static void InvalidateSortOrder(void) {
+	int i;
+	for (i = 0; i < MAX_LOCAL_PLAYERS; i++) chunkPos[i] = IVec3_MaxValue();
+}
 
 /* The number of non-empty Normal/Translucent ChunkPartInfos (across entire world) for each 1D atlas batch. */
 /* 1D atlas batches that do not have any ChunkPartInfos can be entirely skipped. */
@@ -42,16 +55,94 @@ static struct ChunkInfo** renderChunks;
 static int renderChunksCount;
 /* Distance of each chunk from the camera. */
 static cc_uint32* distances;
+/* Temporary arrays for sorting sortedChunks and distances */
+static struct ChunkInfo** sortTmpChunks;
+static cc_uint32* sortTmpDistances;
+/* Centre coordinates of each chunk in sortedChunks, as separate arrays so several can be frustum culled at once */
+static float* sortedCentresX;
+static float* sortedCentresY;
+static float* sortedCentresZ;
+/* Bitmask of the chunks in sortedChunks whose centres are inside the view frustum */
+static cc_uint32* inFrustum;
+#define InFrustum_Get(i) (inFrustum[(i) >> 5] & (1u << ((i) & 31)))
+/* Bitset of the chunks in mapChunks that currently have a mesh built (i.e. noData is false) */
+static cc_uint32* loadedChunks;
+#define LoadedChunks_Set(info)   loadedChunks[((info) - mapChunks) >> 5] |=  (1u << (((info) - mapChunks) & 31))
+#define LoadedChunks_Clear(info) loadedChunks[((info) - mapChunks) >> 5] &= ~(1u << (((info) - mapChunks) & 31))
 /* Maximum number of chunk updates that can be performed in one frame. */
 static int maxChunkUpdates;
+#define MAX_CHUNK_UPDATES 1024
+/* Maximum number of bytes of chunk vertex data that should be uploaded to the GPU per frame (0 for no limit) */
+static cc_uint32 uploadBudget;
+/* Number of bytes of chunk vertex data uploaded in previous frames that exceeded the per frame budget */
+static cc_uint32 uploadDebt;
 /* Cached number of chunks in the world */
 static int chunksCount;
+/* Max distance from camera that chunks are built within to stay within the VRAM budget */
+static int budgetDistSquared = Int32_MaxValue;
+/* Queue of (chunk, entry face, travelled directions) used by the occlusion culling flood fill */
+static cc_uint32* occlusionQueue;
+
+#ifndef CC_BUILD_GL11
+/* Describes the portion of a region's vertex buffer for one 1D atlas */
+/* Vertices are grouped by face, so the same face of every chunk in the region can be drawn at once */
+struct RegionPartInfo {
+	int offset;      /* -1 if no vertices at all */
+	int spriteCount; /* Sprite vertices count */
+	int counts[FACE_COUNT]; /* Counts per face */
+};
+
+/* Describes a region of (up to) 4x4x4 chunks whose non-translucent parts are drawn together */
+struct RegionInfo {
+	GfxResourceID vb;
+	cc_uint8 dirty  : 1; /* Whether the vertex buffer needs to be rebuilt, as a chunk in the region changed */
+	cc_uint8 listed : 1; /* Whether the region is already in the renderRegions array */
+	cc_uint8 : 0;        /* pad to next byte*/
+
+	cc_uint8 drawXMin : 1;
+	cc_uint8 drawXMax : 1;
+	cc_uint8 drawZMin : 1;
+	cc_uint8 drawZMax : 1;
+	cc_uint8 drawYMin : 1;
+	cc_uint8 drawYMax : 1;
+	cc_uint8 : 0;          /* pad to next byte */
+};
+#define REGION_SHIFT 2
+#define REGION_MAX_CHUNKS (1 << (REGION_SHIFT * 3))
+
+/* Render info for all regions in the world */
+static struct RegionInfo* mapRegions;
+/* Pointers to render info for regions containing at least one chunk in the renderChunks array */
+static struct RegionInfo** renderRegions;
+static int renderRegionsCount;
+/* Buffer for all region parts. There are (regionsCount * MapRenderer_1DUsedCount) parts in the buffer */
+static struct RegionPartInfo* regionParts;
+static int regionsX, regionsY, regionsZ, regionsCount;
+/* Whether any region needs to have its vertex buffer rebuilt */
+static cc_bool regionsDirty;
+
+#define Region_Pack(rx, ry, rz) (((rz) * regionsY + (ry)) * regionsX + (rx))
+/* Returns the region the given chunk is in */
+static struct RegionInfo* GetRegion(struct ChunkInfo* info) {
+	int rx = info->centreX >> (CHUNK_SHIFT + REGION_SHIFT);
+	int ry = info->centreY >> (CHUNK_SHIFT + REGION_SHIFT);
+	int rz = info->centreZ >> (CHUNK_SHIFT + REGION_SHIFT);
+	return &mapRegions[Region_Pack(rx, ry, rz)];
+}
+
+static void MarkRegionDirty(struct ChunkInfo* info) {
+	if (!mapRegions) return;
+	GetRegion(info)->dirty = true;
+	regionsDirty = true;
+}
+#endif
 
 static void ChunkInfo_Reset(struct ChunkInfo* chunk, int x, int y, int z) {
 	chunk->centreX = x + HALF_CHUNK_SIZE; chunk->centreY = y + HALF_CHUNK_SIZE; 
 	chunk->centreZ = z + HALF_CHUNK_SIZE;
 #ifndef CC_BUILD_GL11
-	chunk->vb = 0;
+	chunk->vb        = 0;
+	chunk->poolBlock = -1;
 #endif
 
 	chunk->visible = true;  
@@ -63,8 +154,14 @@ static void ChunkInfo_Reset(struct ChunkInfo* chunk, int x, int y, int z) {
 	chunk->drawXMin = false; chunk->drawXMax = false; chunk->drawZMin = false;
 	chunk->drawZMax = false; chunk->drawYMin = false; chunk->drawYMax = false;
 
+	Mem_Set(chunk->connects, 0x3F, sizeof(chunk->connects));
+	chunk->occlusionEntry = OCCLUSION_START;
+
 	chunk->normalParts      = NULL;
 	chunk->translucentParts = NULL;
+#ifndef CC_BUILD_GL11
+	chunk->vertices         = NULL;
+#endif
 }
 
 /* Index of maximum used 1D atlas + 1 */
@@ -79,6 +176,503 @@ CC_NOINLINE static int MapRenderer_UsedAtlases(void) {
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------------Far terrain-------------------------------------------------------*
+*#########################################################################################################################*/
+int MapRenderer_DetailDistance;
+/* Far terrain is split into tiles of 4x4 chunk columns, with one vertex buffer per tile */
+#define FAR_TILE_SHIFT 6
+#define FAR_TILE_SIZE  (1 << FAR_TILE_SHIFT)
+#define FAR_TILE_CHUNKS (FAR_TILE_SIZE >> CHUNK_SHIFT)
+#define FAR_TILE_COLUMNS (FAR_TILE_CHUNKS * FAR_TILE_CHUNKS)
+/* Cells are at least 2x2 blocks, each with a top quad and up to 4 wall quads */
+#define FAR_MAX_CELLS (FAR_TILE_SIZE / 2)
+#define FAR_MAX_VERTICES (FAR_MAX_CELLS * FAR_MAX_CELLS * 5 * 4)
+/* How far walls on tile edges extend below the surface, to hide cracks between tiles of different detail */
+#define FAR_SKIRT_DEPTH 8.0f
+#define FAR_MAX_TILE_BUILDS 2
+
+struct FarTile {
+	GfxResourceID vb;
+	cc_uint8 step;  /* Width of each mesh cell in blocks (0 if mesh not built yet) */
+	cc_bool dirty;  /* Whether blocks in the tile have changed since the mesh was built */
+	float maxY;     /* Highest surface in the tile */
+	/* Range of vertices in the vertex buffer for each chunk column in the tile */
+	cc_uint16 offsets[FAR_TILE_COLUMNS], counts[FAR_TILE_COLUMNS];
+};
+static struct FarTile* farTiles;
+static int farTilesX, farTilesZ;
+/* Chunk columns further away than this (horizontally) from the camera have no full detail chunks */
+static int farStartDistSq;
+/* Max distance from camera that far terrain is rendered within */
+static int farEndDistSq;
+
+static struct VertexColoured* farVertices;
+static int farVerticesCount;
+static float farHeights[(FAR_MAX_CELLS + 2) * (FAR_MAX_CELLS + 2)];
+static BlockID farBlocks[(FAR_MAX_CELLS + 2) * (FAR_MAX_CELLS + 2)];
+/* Average colour of the top face texture of each block */
+static PackedCol farBlockCols[BLOCK_COUNT];
+static cc_bool farBlockColsSet[BLOCK_COUNT];
+
+static PackedCol CalcFarBlockColor(BlockID block) {
+	TextureLoc texLoc = Block_Tex(block, FACE_YMAX);
+	int size = Atlas2D.TileSize, x, y;
+	cc_uint32 r = 0, g = 0, b = 0, count = 0;
+	BitmapCol* row;
+	BitmapCol src;
+	PackedCol col = PACKEDCOL_WHITE;
+
+	if (Atlas2D.Bmp.scan0 && Atlas2D_TileY(texLoc) < Atlas2D.RowsCount) {
+		for (y = 0; y < size; y++) 
+		{
+			row = Bitmap_GetRow(&Atlas2D.Bmp, Atlas2D_TileY(texLoc) * size + y) + Atlas2D_TileX(texLoc) * size;
+			for (x = 0; x < size; x++) 
+			{
+				src = row[x];
+				/* Ignore the see-through parts of e.g. leaves */
+				if (BitmapCol_A(src) < 128) continue;
+				r += BitmapCol_R(src); g += BitmapCol_G(src); b += BitmapCol_B(src); count++;
+			}
+		}
+		if (count) col = PackedCol_Make(r / count, g / count, b / count, 255);
+	}
+
+	if (Blocks.Tinted[block]) col = PackedCol_Tint(col, Blocks.FogCol[block]);
+	return col;
+}
+
+static PackedCol GetFarBlockColor(BlockID block) {
+	if (!farBlockColsSet[block]) {
+		farBlockCols[block]    = CalcFarBlockColor(block);
+		farBlockColsSet[block] = true;
+	}
+	return farBlockCols[block];
+}
+
+/* Returns the top block of the given column, and sets height to the top of that block */
+static BlockID GetFarSurface(int x, int z, float* height) {
+	BlockID block;
+	int y;
+	*height = (float)Builder_SidesLevel;
+	if (!World_ContainsXZ(x, z)) return BLOCK_AIR;
+
+	for (y = World.MaxY; y >= 0; y--) 
+	{
+		block = World_GetBlock(x, y, z);
+		if (Blocks.Draw[block] == DRAW_GAS || Blocks.Draw[block] == DRAW_SPRITE) continue;
+
+		*height = y + Blocks.MaxBB[block].y;
+		return block;
+	}
+	*height = 0.0f;
+	return BLOCK_AIR;
+}
+
+static void AddFarQuad(float x1, float y1, float z1, float x2, float y2, float z2, PackedCol col) {
+	struct VertexColoured* v = &farVertices[farVerticesCount];
+	farVerticesCount += 4;
+
+	v[0].x = x1; v[0].y = y1; v[0].z = z1;
+	if (y1 == y2) {
+		v[1].x = x1; v[1].y = y1; v[1].z = z2;
+		v[2].x = x2; v[2].y = y1; v[2].z = z2;
+		v[3].x = x2; v[3].y = y1; v[3].z = z1;
+	} else {
+		v[1].x = x1; v[1].y = y2; v[1].z = z1;
+		v[2].x = x2; v[2].y = y2; v[2].z = z2;
+		v[3].x = x2; v[3].y = y1; v[3].z = z2;
+	}
+	v[0].Col = col; v[1].Col = col; v[2].Col = col; v[3].Col = col;
+}
+
+/* Returns the height that a wall between a cell and its neighbour extends down to */
+static float GetFarWallBottom(float height, int neighbour, cc_bool tileEdge) {
+	float bottom = farHeights[neighbour];
+	/* Neighbouring tile might be drawn with a different cell width */
+	if (tileEdge) bottom = max(0.0f, min(bottom, height) - FAR_SKIRT_DEPTH);
+	return bottom;
+}
+
+static void BuildFarTile(struct FarTile* tile, int tx, int tz, int step) {
+	int cells = FAR_TILE_SIZE / step, stride = cells + 2, perChunk = CHUNK_SIZE / step;
+	int baseX = tx << FAR_TILE_SHIFT, baseZ = tz << FAR_TILE_SHIFT;
+	int i, j, ci, cj, column, idx;
+	float x1, z1, x2, z2, y, bottom;
+	PackedCol col, top, sideX, sideZ;
+	BlockID block;
+	void* data;
+
+	/* Sample the surface of each cell, and of the cells just outside the tile */
+	for (j = -1; j <= cells; j++) {
+		for (i = -1; i <= cells; i++) {
+			idx = (j + 1) * stride + (i + 1);
+			farBlocks[idx] = GetFarSurface(baseX + i * step + step / 2, baseZ + j * step + step / 2, &farHeights[idx]);
+		}
+	}
+
+	farVerticesCount = 0;
+	tile->maxY       = 0.0f;
+	/* Vertices are grouped by chunk column, so columns with full detail chunks can be skipped when drawing */
+	for (column = 0; column < FAR_TILE_COLUMNS; column++) 
+	{
+		tile->offsets[column] = farVerticesCount;
+
+		for (cj = 0; cj < perChunk; cj++) {
+			for (ci = 0; ci < perChunk; ci++) {
+				i = (column % FAR_TILE_CHUNKS) * perChunk + ci;
+				j = (column / FAR_TILE_CHUNKS) * perChunk + cj;
+				x1 = (float)(baseX + i * step); x2 = x1 + step;
+				z1 = (float)(baseZ + j * step); z2 = z1 + step;
+				if (x1 >= World.Width || z1 >= World.Length) continue;
+
+				x2  = min(x2, (float)World.Width); z2 = min(z2, (float)World.Length);
+				idx = (j + 1) * stride + (i + 1);
+				block = farBlocks[idx];
+				if (Blocks.Draw[block] == DRAW_GAS) continue;
+
+				col   = GetFarBlockColor(block);
+				top   = PackedCol_Tint(col, Env.SunCol);
+				sideX = PackedCol_Tint(col, Env.SunXSide);
+				sideZ = PackedCol_Tint(col, Env.SunZSide);
+				y     = farHeights[idx];
+				tile->maxY = max(tile->maxY, y);
+				AddFarQuad(x1, y, z1, x2, y, z2, top);
+
+				/* Walls are only added by the higher of two neighbouring cells */
+				bottom = GetFarWallBottom(y, idx - 1, i == 0 && x1 > 0);
+				if (bottom < y) AddFarQuad(x1, bottom, z1, x1, y, z2, sideX);
+				bottom = GetFarWallBottom(y, idx + 1, i == cells - 1 && x2 < World.Width);
+				if (bottom < y) AddFarQuad(x2, bottom, z1, x2, y, z2, sideX);
+				bottom = GetFarWallBottom(y, idx - stride, j == 0 && z1 > 0);
+				if (bottom < y) AddFarQuad(x1, bottom, z1, x2, y, z1, sideZ);
+				bottom = GetFarWallBottom(y, idx + stride, j == cells - 1 && z2 < World.Length);
+				if (bottom < y) AddFarQuad(x1, bottom, z2, x2, y, z2, sideZ);
+			}
+		}
+		tile->counts[column] = farVerticesCount - tile->offsets[column];
+	}
+
+	tile->step  = step;
+	tile->dirty = false;
+	Gfx_DeleteVb(&tile->vb);
+	if (!farVerticesCount) return;
+
+	tile->vb = Gfx_CreateVb(VERTEX_FORMAT_COLOURED, farVerticesCount);
+	if (!tile->vb) return;
+	data = Gfx_LockVb(tile->vb, VERTEX_FORMAT_COLOURED, farVerticesCount);
+	Mem_Copy(data, farVertices, farVerticesCount * SIZEOF_VERTEX_COLOURED);
+	Gfx_UnlockVb(tile->vb);
+}
+
+/* Calculates the squared horizontal distances from the closest view to the nearest chunk column */
+/*  centre in the given tile, and from the furthest view to the furthest chunk column centre */
+static void CalcFarTileDists(int tx, int tz, int* nearest, int* furthest) {
+	int x1 = (tx << FAR_TILE_SHIFT) + HALF_CHUNK_SIZE, x2 = x1 + FAR_TILE_SIZE - CHUNK_SIZE;
+	int z1 = (tz << FAR_TILE_SHIFT) + HALF_CHUNK_SIZE, z2 = z1 + FAR_TILE_SIZE - CHUNK_SIZE;
+	int i, dx, dz, fx, fz;
+	*nearest = Int32_MaxValue; *furthest = 0;
+
+	for (i = 0; i < Game_NumStates; i++)
+	{
+		if (chunkPos[i].x == Int32_MaxValue) continue;
+		dx = max(0, max(x1 - chunkPos[i].x, chunkPos[i].x - x2));
+		dz = max(0, max(z1 - chunkPos[i].z, chunkPos[i].z - z2));
+		fx = max(Math_AbsI(x1 - chunkPos[i].x), Math_AbsI(x2 - chunkPos[i].x));
+		fz = max(Math_AbsI(z1 - chunkPos[i].z), Math_AbsI(z2 - chunkPos[i].z));
+
+		*nearest  = min(*nearest,  dx * dx + dz * dz);
+		*furthest = max(*furthest, fx * fx + fz * fz);
+	}
+}
+
+static void UpdateFarTerrain(void) {
+	int detailSq = MapRenderer_DetailDistance * MapRenderer_DetailDistance;
+	int tx, tz, nearest, furthest, step, built = 0;
+	struct FarTile* tile;
+	if (!farTiles) return;
+
+	for (tz = 0; tz < farTilesZ; tz++) {
+		for (tx = 0; tx < farTilesX; tx++) {
+			tile = &farTiles[tz * farTilesX + tx];
+			CalcFarTileDists(tx, tz, &nearest, &furthest);
+			/* Tiles beyond view distance, or completely covered by full detail chunks, are never drawn */
+			if (nearest > farEndDistSq || furthest <= farStartDistSq) continue;
+
+			/* Coarser cells are used further away */
+			step = nearest < 4 * detailSq ? 2 : (nearest < 16 * detailSq ? 4 : 8);
+			if (tile->step == step && !tile->dirty) continue;
+
+			BuildFarTile(tile, tx, tz, step);
+			if (++built >= FAR_MAX_TILE_BUILDS) return;
+		}
+	}
+}
+
+#ifndef CC_BUILD_GL11
+/* Draws each run of chunk columns with the given bits set in the mask */
+static void DrawFarColumns(struct FarTile* tile, int mask) {
+	int column, count = 0, offset = 0;
+
+	for (column = 0; column < FAR_TILE_COLUMNS; column++) 
+	{
+		if (mask & (1 << column)) {
+			if (!count) offset = tile->offsets[column];
+			count += tile->counts[column];
+		} else if (count) {
+			Gfx_DrawVb_IndexedTris_Range(count, offset);
+			count = 0;
+		}
+	}
+	if (count) Gfx_DrawVb_IndexedTris_Range(count, offset);
+}
+#endif
+
+static void RenderFarTerrain(void) {
+	IVec3 pos = chunkPos[CUR_VIEW];
+	int tx, tz, x1, z1, dx, dz, column, mask;
+	struct FarTile* tile;
+	float radius;
+	if (!farTiles || pos.x == Int32_MaxValue) return;
+
+	Gfx_SetVertexFormat(VERTEX_FORMAT_COLOURED);
+	for (tz = 0; tz < farTilesZ; tz++) {
+		for (tx = 0; tx < farTilesX; tx++) {
+			tile = &farTiles[tz * farTilesX + tx];
+			if (!tile->vb) continue;
+
+			x1 = tx << FAR_TILE_SHIFT; z1 = tz << FAR_TILE_SHIFT;
+			dx = max(0, max(x1 - pos.x, pos.x - (x1 + FAR_TILE_SIZE)));
+			dz = max(0, max(z1 - pos.z, pos.z - (z1 + FAR_TILE_SIZE)));
+			if (dx * dx + dz * dz > farEndDistSq) continue;
+
+			radius = Math_SqrtF(2 * (FAR_TILE_SIZE / 2) * (FAR_TILE_SIZE / 2) + tile->maxY * tile->maxY * 0.25f);
+			if (!FrustumCulling_SphereInFrustum(x1 + FAR_TILE_SIZE / 2, tile->maxY * 0.5f, z1 + FAR_TILE_SIZE / 2, radius)) continue;
+
+			/* Only chunk columns past full detail range are drawn */
+			mask = 0;
+			for (column = 0; column < FAR_TILE_COLUMNS; column++) 
+			{
+				dx = x1 + (column % FAR_TILE_CHUNKS) * CHUNK_SIZE + HALF_CHUNK_SIZE - pos.x;
+				dz = z1 + (column / FAR_TILE_CHUNKS) * CHUNK_SIZE + HALF_CHUNK_SIZE - pos.z;
+				if (dx * dx + dz * dz > farStartDistSq) mask |= 1 << column;
+			}
+
+#ifdef CC_BUILD_GL11
+			/* Display lists can only be drawn whole */
+			if (mask != (1 << FAR_TILE_COLUMNS) - 1) continue;
+			Gfx_BindVb(tile->vb);
+			Gfx_DrawVb_IndexedTris(tile->offsets[FAR_TILE_COLUMNS - 1] + tile->counts[FAR_TILE_COLUMNS - 1]);
+#else
+			if (!mask) continue;
+			Gfx_BindVb(tile->vb);
+			DrawFarColumns(tile, mask);
+#endif
+		}
+	}
+}
+
+/* Marks all far terrain tiles as needing to be rebuilt (e.g. after textures or sun colour changed) */
+static void InvalidateFarTerrain(void) {
+	int i;
+	Mem_Set(farBlockColsSet, 0, sizeof(farBlockColsSet));
+	if (!farTiles) return;
+
+	for (i = 0; i < farTilesX * farTilesZ; i++) farTiles[i].dirty = true;
+}
+
+static void MarkFarTilesDirty(int x1, int z1, int x2, int z2) {
+	int tx, tz;
+	if (!farTiles) return;
+
+	for (tz = z1 >> FAR_TILE_SHIFT; tz <= (z2 >> FAR_TILE_SHIFT); tz++) {
+		for (tx = x1 >> FAR_TILE_SHIFT; tx <= (x2 >> FAR_TILE_SHIFT); tx++) {
+			farTiles[tz * farTilesX + tx].dirty = true;
+		}
+	}
+}
+
+static void DeleteFarTiles(void) {
+	int i;
+	if (!farTiles) return;
+
+	for (i = 0; i < farTilesX * farTilesZ; i++) {
+		Gfx_DeleteVb(&farTiles[i].vb);
+		farTiles[i].step = 0;
+	}
+}
+
+static void FreeFarTiles(void) {
+	DeleteFarTiles();
+	Mem_Free(farTiles);
+	Mem_Free(farVertices);
+	farTiles    = NULL;
+	farVertices = NULL;
+}
+
+static void AllocateFarTiles(void) {
+	if (!MapRenderer_DetailDistance) return;
+	farTilesX = (World.Width  + FAR_TILE_SIZE - 1) >> FAR_TILE_SHIFT;
+	farTilesZ = (World.Length + FAR_TILE_SIZE - 1) >> FAR_TILE_SHIFT;
+
+	farTiles    = (struct FarTile*)Mem_TryAllocCleared(farTilesX * farTilesZ, sizeof(struct FarTile));
+	farVertices = (struct VertexColoured*)Mem_TryAlloc(FAR_MAX_VERTICES, SIZEOF_VERTEX_COLOURED);
+	/* Far terrain is optional, so just don't draw it when out of memory */
+	if (!farTiles || !farVertices) FreeFarTiles();
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Occlusion queries----------------------------------------------------*
+*#########################################################################################################################*/
+cc_bool MapRenderer_OcclusionQueries;
+/* Number of query results in a row a chunk's bounding box must be hidden for, before the chunk is skipped */
+#define QUERY_OCCLUDED_FRAMES 3
+/* Max number of bounding boxes drawn from the dynamic vertex buffer at once */
+#define QUERY_BATCH_BOXES 256
+#define QUERY_BOX_VERTICES 24
+
+struct ChunkQuery {
+	GfxResourceID query;
+	cc_uint16 frame;   /* Value of queryFrame when the chunk was last in the render list */
+	cc_bool pending;   /* Whether the query's result has not been retrieved yet */
+	cc_uint8 occluded; /* Number of query results in a row where the chunk's bounding box was hidden */
+};
+static struct ChunkQuery* chunkQueries;
+/* Chunks whose bounding boxes are tested against the depth buffer after this frame's world is drawn */
+static struct ChunkInfo** queryChunks;
+static int queryChunksCount;
+static cc_uint16 queryFrame;
+static GfxResourceID queryVb;
+
+/* Corners of each face of a chunk's bounding box (bit 0 = max X, bit 1 = max Y, bit 2 = max Z) */
+static const cc_uint8 queryBoxCorners[QUERY_BOX_VERTICES] = {
+	0,2,6,4, 1,3,7,5, 0,1,5,4, 2,3,7,6, 0,1,3,2, 4,5,7,6
+};
+
+/* Whether the camera is inside or very close to the bounding box of the given chunk */
+/* NOTE: Faces of the box behind the near plane are clipped, so the box would wrongly be reported as hidden */
+static cc_bool CameraNearChunk(struct ChunkInfo* info) {
+	Vec3 pos = Camera.CurrentPos;
+	return
+		Math_AbsF(pos.x - info->centreX) <= HALF_CHUNK_SIZE + 1 &&
+		Math_AbsF(pos.y - info->centreY) <= HALF_CHUNK_SIZE + 1 &&
+		Math_AbsF(pos.z - info->centreZ) <= HALF_CHUNK_SIZE + 1;
+}
+
+/* Retrieves the available results of the queries issued in previous frames, */
+/*  then removes chunks that have been hidden for several frames in a row from the render list */
+/* Returns whether any chunks were added to or removed from the render list because of this */
+static cc_bool UpdateOcclusionQueries(void) {
+	struct ChunkQuery* cq;
+	struct ChunkInfo* info;
+	cc_bool visible, wasHidden, changed = false;
+	int i, j = 0;
+
+	queryFrame++;
+	queryChunksCount = 0;
+
+	for (i = 0; i < renderChunksCount; i++) 
+	{
+		info = renderChunks[i];
+		cq   = &chunkQueries[info - mapChunks];
+
+		/* Results from before the chunk last went out of view are out of date */
+		if (cq->frame != (cc_uint16)(queryFrame - 1)) cq->occluded = 0;
+		cq->frame = queryFrame;
+		wasHidden = cq->occluded >= QUERY_OCCLUDED_FRAMES;
+
+		if (cq->pending && Gfx_GetQueryResult(cq->query, &visible)) {
+			cq->pending  = false;
+			cq->occluded = visible ? 0 : min(cq->occluded + 1, 255);
+		}
+
+		if (CameraNearChunk(info)) {
+			cq->occluded = 0;
+		} else if (!cq->pending) {
+			queryChunks[queryChunksCount++] = info;
+		}
+
+		if (wasHidden != (cq->occluded >= QUERY_OCCLUDED_FRAMES)) changed = true;
+		if (cq->occluded < QUERY_OCCLUDED_FRAMES) renderChunks[j++] = info;
+	}
+	renderChunksCount = j;
+	return changed;
+}
+
+static void AddQueryBox(struct ChunkInfo* info, struct VertexColoured* v) {
+	/* Slightly larger than the chunk, so the box is always in front of the chunk's own faces */
+	float x1 = info->centreX - (HALF_CHUNK_SIZE + 0.5f), x2 = info->centreX + (HALF_CHUNK_SIZE + 0.5f);
+	float y1 = info->centreY - (HALF_CHUNK_SIZE + 0.5f), y2 = info->centreY + (HALF_CHUNK_SIZE + 0.5f);
+	float z1 = info->centreZ - (HALF_CHUNK_SIZE + 0.5f), z2 = info->centreZ + (HALF_CHUNK_SIZE + 0.5f);
+	int i, corner;
+
+	for (i = 0; i < QUERY_BOX_VERTICES; i++, v++)
+	{
+		corner = queryBoxCorners[i];
+		v->x   = (corner & 1) ? x2 : x1;
+		v->y   = (corner & 2) ? y2 : y1;
+		v->z   = (corner & 4) ? z2 : z1;
+		v->Col = PACKEDCOL_WHITE;
+	}
+}
+
+/* Tests the bounding boxes of the chunks in the render list against the depth buffer */
+/* NOTE: Must be called after the world has been drawn, so the depth buffer contains the world */
+static void IssueOcclusionQueries(void) {
+	struct VertexColoured* v;
+	struct ChunkQuery* cq;
+	int i, j, count;
+
+	if (!queryChunksCount) return;
+	if (!queryVb) queryVb = Gfx_CreateDynamicVb(VERTEX_FORMAT_COLOURED, QUERY_BATCH_BOXES * QUERY_BOX_VERTICES);
+	if (!queryVb) return;
+
+	Gfx_SetVertexFormat(VERTEX_FORMAT_COLOURED);
+	Gfx_DepthOnlyRendering(true);
+	Gfx_SetDepthWrite(false);
+
+	for (i = 0; i < queryChunksCount; i += count) 
+	{
+		count = min(queryChunksCount - i, QUERY_BATCH_BOXES);
+		v     = (struct VertexColoured*)Gfx_LockDynamicVb(queryVb, VERTEX_FORMAT_COLOURED, count * QUERY_BOX_VERTICES);
+
+		for (j = 0; j < count; j++) AddQueryBox(queryChunks[i + j], v + j * QUERY_BOX_VERTICES);
+		Gfx_UnlockDynamicVb(queryVb);
+
+		for (j = 0; j < count; j++) 
+		{
+			cq = &chunkQueries[queryChunks[i + j] - mapChunks];
+			if (!cq->query && !(cq->query = Gfx_CreateQuery())) continue;
+
+			Gfx_BeginQuery(cq->query);
+			Gfx_DrawVb_IndexedTris_Range(QUERY_BOX_VERTICES, j * QUERY_BOX_VERTICES);
+			Gfx_EndQuery(cq->query);
+			cq->pending = true;
+		}
+	}
+	/* Only need to test each box once per frame (e.g. not again for the other eye in anaglyph 3D) */
+	queryChunksCount = 0;
+
+	Gfx_SetDepthWrite(true);
+	Gfx_DepthOnlyRendering(false);
+}
+
+static void DeleteQueries(void) {
+	int i;
+	Gfx_DeleteDynamicVb(&queryVb);
+	if (!chunkQueries) return;
+
+	for (i = 0; i < chunksCount; i++) 
+	{
+		Gfx_DeleteQuery(&chunkQueries[i].query);
+		chunkQueries[i].pending  = false;
+		chunkQueries[i].occluded = 0;
+	}
+	queryChunksCount = 0;
+}
+
+
 /*########################################################################################################################*
 *-------------------------------------------------------Map rendering-----------------------------------------------------*
 *#########################################################################################################################*/
@@ -121,12 +715,86 @@ if (drawMin && drawMax) { \
 	Game_Vertices += part.counts[maxFace]; \
 }
 
+#ifndef CC_BUILD_GL11
+static struct GfxDrawRange drawRanges[GFX_MAX_DRAW_RANGES];
+static int drawRangesCount;
+#define DrawFacesMask(obj) (((obj)->drawXMin << FACE_XMIN) | ((obj)->drawXMax << FACE_XMAX) | \
+	((obj)->drawZMin << FACE_ZMIN) | ((obj)->drawZMax << FACE_ZMAX) | ((obj)->drawYMin << FACE_YMIN) | ((obj)->drawYMax << FACE_YMAX))
+
+static void DrawRanges(void) {
+	if (!drawRangesCount) return;
+	Gfx_DrawIndexedTris_T2fC4b_Ranges(drawRanges, drawRangesCount);
+	drawRangesCount = 0;
+}
+
+/* Adds a range of vertices to be drawn by the next DrawRanges call */
+static void AddDrawRange(int count, int offset) {
+	struct GfxDrawRange* range;
+	int n;
+	Game_Vertices += count;
+
+	for (; count > 0; count -= n, offset += n) {
+		n = min(count, GFX_MAX_VERTICES);
+
+		/* Merge with previous range when directly after it */
+		if (drawRangesCount) {
+			range = &drawRanges[drawRangesCount - 1];
+
+			if (range->startVertex + range->verticesCount == offset && range->verticesCount + n <= GFX_MAX_VERTICES) {
+				range->verticesCount += n; continue;
+			}
+		}
+
+		if (drawRangesCount == GFX_MAX_DRAW_RANGES) DrawRanges();
+		range = &drawRanges[drawRangesCount++];
+		range->verticesCount = n;
+		range->startVertex   = offset;
+	}
+}
+
+/* Adds the ranges of the sprites and faces of a part that need to be drawn */
+/* NOTE: Vertices of a part are stored as sprites first, then faces in FACE_XMIN to FACE_YMAX order */
+static void AddPartRanges(int offset, int spriteCount, const int* counts, int faces) {
+	int face, count = spriteCount >> 2; /* 4 per sprite */
+	cc_bool xMin = faces & (1 << FACE_XMIN), xMax = faces & (1 << FACE_XMAX);
+	cc_bool zMin = faces & (1 << FACE_ZMIN), zMax = faces & (1 << FACE_ZMAX);
+
+	if (count) {
+		if (xMax || zMin) AddDrawRange(count, offset);
+		offset += count;
+		if (xMin || zMax) AddDrawRange(count, offset);
+		offset += count;
+		if (xMin || zMin) AddDrawRange(count, offset);
+		offset += count;
+		if (xMax || zMax) AddDrawRange(count, offset);
+		offset += count;
+	}
+
+	for (face = 0; face < FACE_COUNT; face++) {
+		if (faces & (1 << face)) AddDrawRange(counts[face], offset);
+		offset += counts[face];
+	}
+}
+
+static void AddChunkPartRanges(const struct ChunkPartInfo* part, int faces) {
+	int face, counts[FACE_COUNT];
+	for (face = 0; face < FACE_COUNT; face++) counts[face] = part->counts[face];
+
+	AddPartRanges(part->offset, part->spriteCount, counts, faces);
+}
+#endif
+
 static void RenderNormalBatch(int batch) {
 	int batchOffset = chunksCount * batch;
 	struct ChunkInfo* info;
 	struct ChunkPartInfo part;
 	cc_bool drawMin, drawMax;
 	int i, offset, count;
+#ifndef CC_BUILD_GL11
+	GfxResourceID boundVb = 0;
+	/* Face culling is harmless when only drawing one face of a pair, as only front faces are drawn then */
+	if (Gfx.SupportsMultiDraw) Gfx_SetFaceCulling(true);
+#endif
 
 	for (i = 0; i < renderChunksCount; i++) {
 		info = renderChunks[i];
@@ -137,7 +805,17 @@ static void RenderNormalBatch(int batch) {
 		hasNormParts[batch] = true;
 
 #ifndef CC_BUILD_GL11
-		Gfx_BindVb_Textured(info->vb);
+		/* Chunks in the same shared vertex buffer are drawn without rebinding */
+		if (info->vb != boundVb) {
+			DrawRanges();
+			Gfx_BindVb_Textured(info->vb);
+			boundVb = info->vb;
+		}
+
+		if (Gfx.SupportsMultiDraw) {
+			AddChunkPartRanges(&part, DrawFacesMask(info));
+			continue;
+		}
 #endif
 
 		offset  = part.offset + part.spriteCount;
@@ -185,13 +863,96 @@ static void RenderNormalBatch(int batch) {
 		}
 		Gfx_SetFaceCulling(false);
 	}
+
+#ifndef CC_BUILD_GL11
+	DrawRanges();
+	if (Gfx.SupportsMultiDraw) Gfx_SetFaceCulling(false);
+#endif
+}
+
+#ifndef CC_BUILD_GL11
+/* Draws the given range of a region's vertices, splitting it up into multiple draw calls if necessary */
+static void DrawRegionRange(int count, int offset) {
+	int n;
+	Game_Vertices += count;
+
+	for (; count > 0; count -= n, offset += n) {
+		n = min(count, GFX_MAX_VERTICES);
+		Gfx_DrawIndexedTris_T2fC4b(n, offset);
+	}
 }
 
+#define DrawRegionFaces(minFace, maxFace) \
+if (drawMin && drawMax) { \
+	Gfx_SetFaceCulling(true); \
+	DrawRegionRange(part->counts[minFace] + part->counts[maxFace], offset); \
+	Gfx_SetFaceCulling(false); \
+} else if (drawMin) { \
+	DrawRegionRange(part->counts[minFace], offset); \
+} else if (drawMax) { \
+	DrawRegionRange(part->counts[maxFace], offset + part->counts[minFace]); \
+}
+
+static void RenderNormalRegions(int batch) {
+	int batchOffset = regionsCount * batch;
+	struct RegionInfo* region;
+	struct RegionPartInfo* part;
+	cc_bool drawMin, drawMax;
+	int i, offset, count;
+
+	for (i = 0; i < renderRegionsCount; i++) {
+		region = renderRegions[i];
+		part   = &regionParts[batchOffset + (int)(region - mapRegions)];
+		if (part->offset < 0) continue;
+		hasNormParts[batch] = true;
+
+		Gfx_BindVb_Textured(region->vb);
+
+		if (Gfx.SupportsMultiDraw) {
+			AddPartRanges(part->offset, part->spriteCount, part->counts, DrawFacesMask(region));
+			Gfx_SetFaceCulling(true);
+			DrawRanges();
+			Gfx_SetFaceCulling(false);
+			continue;
+		}
+
+		offset  = part->offset + part->spriteCount;
+		drawMin = region->drawXMin && part->counts[FACE_XMIN];
+		drawMax = region->drawXMax && part->counts[FACE_XMAX];
+		DrawRegionFaces(FACE_XMIN, FACE_XMAX);
+
+		offset  += part->counts[FACE_XMIN] + part->counts[FACE_XMAX];
+		drawMin = region->drawZMin && part->counts[FACE_ZMIN];
+		drawMax = region->drawZMax && part->counts[FACE_ZMAX];
+		DrawRegionFaces(FACE_ZMIN, FACE_ZMAX);
+
+		offset  += part->counts[FACE_ZMIN] + part->counts[FACE_ZMAX];
+		drawMin = region->drawYMin && part->counts[FACE_YMIN];
+		drawMax = region->drawYMax && part->counts[FACE_YMAX];
+		DrawRegionFaces(FACE_YMIN, FACE_YMAX);
+
+		if (!part->spriteCount) continue;
+		offset = part->offset;
+		count  = part->spriteCount >> 2; /* 4 per sprite */
+
+		Gfx_SetFaceCulling(true);
+		if (region->drawXMax || region->drawZMin) DrawRegionRange(count, offset);
+		offset += count;
+		if (region->drawXMin || region->drawZMax) DrawRegionRange(count, offset);
+		offset += count;
+		if (region->drawXMin || region->drawZMin) DrawRegionRange(count, offset);
+		offset += count;
+		if (region->drawXMax || region->drawZMax) DrawRegionRange(count, offset);
+		Gfx_SetFaceCulling(false);
+	}
+}
+#endif
+
 void MapRenderer_RenderNormal(float delta) {
 	int batch;
 	if (!mapChunks) return;
 
-	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+	Gfx_SetVertexFormat(Builder_PackedVertices ? VERTEX_FORMAT_PACKED : VERTEX_FORMAT_TEXTURED);
 	Gfx_SetAlphaTest(true);
 	
 	Gfx_EnableMipmaps();
@@ -200,11 +961,21 @@ void MapRenderer_RenderNormal(float delta) {
 		if (normPartsCount[batch] <= 0) continue;
 		if (hasNormParts[batch] || checkNormParts[batch]) {
 			Atlas1D_Bind(batch);
+#ifndef CC_BUILD_GL11
+			if (MapRenderer_RegionBatching) {
+				RenderNormalRegions(batch);
+			} else {
+				RenderNormalBatch(batch);
+			}
+#else
 			RenderNormalBatch(batch);
+#endif
 			checkNormParts[batch] = false;
 		}
 	}
 	Gfx_DisableMipmaps();
+	if (queryChunksCount) IssueOcclusionQueries();
+	RenderFarTerrain();
 
 	CheckWeather(delta);
 	Gfx_SetAlphaTest(false);
@@ -231,9 +1002,13 @@ static void RenderTranslucentBatch(int batch) {
 	struct ChunkPartInfo part;
 	cc_bool drawMin, drawMax;
 	int i, offset;
+#ifndef CC_BUILD_GL11
+	GfxResourceID vb, boundVb = 0;
+#endif
 
 	for (i = 0; i < renderChunksCount; i++) {
-		info = renderChunks[i];
+		/* Render list is ordered from nearest to furthest */
+		info = MapRenderer_SortTranslucent ? renderChunks[renderChunksCount - 1 - i] : renderChunks[i];
 		if (!info->translucentParts) continue;
 
 		part = info->translucentParts[batchOffset];
@@ -241,7 +1016,19 @@ static void RenderTranslucentBatch(int batch) {
 		hasTranParts[batch] = true;
 
 #ifndef CC_BUILD_GL11
-		Gfx_BindVb_Textured(info->vb);
+		/* With region batching, translucent parts are stored in the region's vertex buffer instead */
+		vb = MapRenderer_RegionBatching ? GetRegion(info)->vb : info->vb;
+		/* Chunks in the same shared vertex buffer are drawn without rebinding */
+		if (vb != boundVb) {
+			DrawRanges();
+			Gfx_BindVb_Textured(vb);
+			boundVb = vb;
+		}
+
+		if (Gfx.SupportsMultiDraw) {
+			AddChunkPartRanges(&part, inTranslucent ? 0x3F : DrawFacesMask(info));
+			continue;
+		}
 #endif
 
 		offset  = part.offset;
@@ -259,6 +1046,9 @@ static void RenderTranslucentBatch(int batch) {
 		drawMax = (inTranslucent || info->drawYMax) && part.counts[FACE_YMAX];
 		DrawTranslucentFaces(FACE_YMIN, FACE_YMAX);
 	}
+#ifndef CC_BUILD_GL11
+	DrawRanges();
+#endif
 }
 
 void MapRenderer_RenderTranslucent(float delta) {
@@ -267,33 +1057,38 @@ void MapRenderer_RenderTranslucent(float delta) {
 
 	/* First fill depth buffer */
 	vertices = Game_Vertices;
-	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+	Gfx_SetVertexFormat(Builder_PackedVertices ? VERTEX_FORMAT_PACKED : VERTEX_FORMAT_TEXTURED);
 	Gfx_SetAlphaBlending(false);
-	Gfx_DepthOnlyRendering(true);
 
-	for (batch = 0; batch < MapRenderer_1DUsedCount; batch++) 
-	{
-		if (tranPartsCount[batch] <= 0) continue;
-		if (hasTranParts[batch] || checkTranParts[batch]) {
-			RenderTranslucentBatch(batch);
-			checkTranParts[batch] = false;
+	/* With sorted translucent quads, the closest faces are already drawn last */
+	if (!MapRenderer_SortTranslucent) {
+		Gfx_DepthOnlyRendering(true);
+
+		for (batch = 0; batch < MapRenderer_1DUsedCount; batch++) 
+		{
+			if (tranPartsCount[batch] <= 0) continue;
+			if (hasTranParts[batch] || checkTranParts[batch]) {
+				RenderTranslucentBatch(batch);
+				checkTranParts[batch] = false;
+			}
 		}
+		Gfx_DepthOnlyRendering(false);
 	}
 	Game_Vertices = vertices;
 
 	/* Then actually draw the transluscent blocks */
 	Gfx_SetAlphaBlending(true);
-	Gfx_DepthOnlyRendering(false);
 	Gfx_SetDepthWrite(false); /* already calculated depth values in depth pass */
 
 	Gfx_EnableMipmaps();
 	for (batch = 0; batch < MapRenderer_1DUsedCount; batch++) 
 	{
 		if (tranPartsCount[batch] <= 0) continue;
-		if (!hasTranParts[batch]) continue;
+		if (!hasTranParts[batch] && !checkTranParts[batch]) continue;
 
 		Atlas1D_Bind(batch);
 		RenderTranslucentBatch(batch);
+		checkTranParts[batch] = false;
 	}
 	Gfx_DisableMipmaps();
 
@@ -304,13 +1099,194 @@ void MapRenderer_RenderTranslucent(float delta) {
 		EnvRenderer_RenderWeather(delta);
 		Gfx_SetAlphaTest(false);
 	}
-	Gfx_SetAlphaBlending(false);
+	Gfx_SetAlphaBlending(false);
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Chunk vertex pool-----------------------------------------------------*
+*#########################################################################################################################*/
+#ifndef CC_BUILD_GL11
+cc_bool MapRenderer_PooledVertices;
+/* Chunk meshes are sub-allocated from a few large vertex buffers ('slabs') using a buddy allocator, */
+/*  which avoids creating and deleting a vertex buffer every time a chunk is loaded or unloaded */
+/* Blocks are allocated in units of 64 vertices, both halves of a free block being merged back when freed */
+#define POOL_UNIT_SHIFT 6
+#define POOL_MAX_ORDER  12
+#define POOL_SLAB_UNITS (1 << POOL_MAX_ORDER)
+#define POOL_SLAB_VERTICES (POOL_SLAB_UNITS << POOL_UNIT_SHIFT)
+#define POOL_MAX_SLABS 16
+#define PoolBlock_Pack(slab, unit) (((slab) << POOL_MAX_ORDER) | (unit))
+
+struct PoolSlab {
+	GfxResourceID vb;
+	cc_int16 freeHead[POOL_MAX_ORDER + 1];  /* First free block of each size (-1 if none) */
+	cc_int16 next[POOL_SLAB_UNITS], prev[POOL_SLAB_UNITS];
+	cc_uint8 order[POOL_SLAB_UNITS];   /* Size of the block starting at each unit, as 1 << order units */
+	cc_bool  isFree[POOL_SLAB_UNITS];  /* Whether a free block starts at each unit */
+};
+static struct PoolSlab* poolSlabs[POOL_MAX_SLABS];
+static VertexFormat poolFormat;
+/* Number of chunks with vertices currently in the pool */
+static int poolBlocksUsed;
+
+static void PoolSlab_Push(struct PoolSlab* slab, int unit, int order) {
+	int head = slab->freeHead[order];
+	slab->order[unit]  = order;
+	slab->isFree[unit] = true;
+	slab->prev[unit]   = -1;
+	slab->next[unit]   = head;
+
+	if (head >= 0) slab->prev[head] = unit;
+	slab->freeHead[order] = unit;
+}
+
+static void PoolSlab_Remove(struct PoolSlab* slab, int unit) {
+	int prev = slab->prev[unit], next = slab->next[unit];
+	if (prev >= 0) { slab->next[prev] = next; } else { slab->freeHead[slab->order[unit]] = next; }
+	if (next >= 0) { slab->prev[next] = prev; }
+	slab->isFree[unit] = false;
+}
+
+static int PoolSlab_Alloc(struct PoolSlab* slab, int order) {
+	int unit, k;
+	for (k = order; k <= POOL_MAX_ORDER && slab->freeHead[k] < 0; k++) { }
+	if (k > POOL_MAX_ORDER) return -1;
+
+	unit = slab->freeHead[k];
+	PoolSlab_Remove(slab, unit);
+	/* Split the block in half until it is the requested size */
+	while (k > order) {
+		k--;
+		PoolSlab_Push(slab, unit + (1 << k), k);
+	}
+	slab->order[unit] = order;
+	return unit;
+}
+
+static void PoolSlab_Free(struct PoolSlab* slab, int unit) {
+	int order = slab->order[unit], buddy;
+
+	for (; order < POOL_MAX_ORDER; order++) 
+	{
+		buddy = unit ^ (1 << order);
+		if (!slab->isFree[buddy] || slab->order[buddy] != order) break;
+
+		PoolSlab_Remove(slab, buddy);
+		unit = min(unit, buddy);
+	}
+	PoolSlab_Push(slab, unit, order);
+}
+
+static struct PoolSlab* PoolSlab_Create(void) {
+	struct PoolSlab* slab;
+	int i;
+	if (Gfx.LostContext) return NULL;
+
+	slab = (struct PoolSlab*)Mem_TryAllocCleared(1, sizeof(struct PoolSlab));
+	if (!slab) return NULL;
+
+	for (i = 0; i <= POOL_MAX_ORDER; i++) slab->freeHead[i] = -1;
+	PoolSlab_Push(slab, 0, POOL_MAX_ORDER);
+
+	/* Contents are filled in later by Gfx_UpdateVbPart */
+	slab->vb = Gfx_CreateVb(poolFormat, POOL_SLAB_VERTICES);
+	Gfx_LockVb(slab->vb, poolFormat, POOL_SLAB_VERTICES);
+	Gfx_UnlockVb(slab->vb);
+	return slab;
+}
+
+static void DeletePool(void) {
+	int i;
+	for (i = 0; i < POOL_MAX_SLABS; i++) 
+	{
+		if (!poolSlabs[i]) continue;
+		Gfx_DeleteVb(&poolSlabs[i]->vb);
+		Mem_Free(poolSlabs[i]);
+		poolSlabs[i] = NULL;
+	}
+}
+
+/* Adds the given offset to the vertex offsets of all of the parts of the given chunk */
+static void OffsetChunkParts(struct ChunkPartInfo* ptr, int offset) {
+	int i;
+	if (!ptr) return;
+
+	for (i = 0; i < MapRenderer_1DUsedCount; i++, ptr += chunksCount) {
+		if (ptr->offset >= 0) ptr->offset += offset;
+	}
+}
+
+cc_bool MapRenderer_PoolVertices(struct ChunkInfo* info, void* vertices, int count) {
+	VertexFormat fmt = Builder_PackedVertices ? VERTEX_FORMAT_PACKED : VERTEX_FORMAT_TEXTURED;
+	/* Extra vertex to fix crashing on some GPUs, same as with a chunk's own vertex buffer */
+	int units = (count + 1 + (1 << POOL_UNIT_SHIFT) - 1) >> POOL_UNIT_SHIFT;
+	int i, unit, order = 0;
+
+	if (fmt != poolFormat) {
+		/* Existing slabs can only be reused once every chunk using the old format has been deleted */
+		if (poolBlocksUsed) return false;
+		DeletePool();
+		poolFormat = fmt;
+	}
+	while ((1 << order) < units) order++;
+	if (order > POOL_MAX_ORDER) return false;
+
+	for (i = 0; i < POOL_MAX_SLABS; i++) 
+	{
+		if (!poolSlabs[i] && !(poolSlabs[i] = PoolSlab_Create())) return false;
+		unit = PoolSlab_Alloc(poolSlabs[i], order);
+		if (unit < 0) continue;
+
+		info->vb        = poolSlabs[i]->vb;
+		info->poolBlock = PoolBlock_Pack(i, unit);
+		poolBlocksUsed++;
+
+		Gfx_UpdateVbPart(info->vb, fmt, unit << POOL_UNIT_SHIFT, count, vertices);
+		OffsetChunkParts(info->normalParts,      unit << POOL_UNIT_SHIFT);
+		OffsetChunkParts(info->translucentParts, unit << POOL_UNIT_SHIFT);
+		return true;
+	}
+	return false;
+}
+
+static void FreePoolBlock(struct ChunkInfo* info) {
+	int slab = info->poolBlock >> POOL_MAX_ORDER;
+	PoolSlab_Free(poolSlabs[slab], info->poolBlock & (POOL_SLAB_UNITS - 1));
+
+	info->vb        = 0;
+	info->poolBlock = -1;
+	poolBlocksUsed--;
 }
+#endif
 
 
 /*########################################################################################################################*
 *---------------------------------------------------Chunk functionality---------------------------------------------------*
 *#########################################################################################################################*/
+static int PartVerticesCount(const struct ChunkPartInfo* part) {
+	return part->spriteCount + 
+		part->counts[FACE_XMIN] + part->counts[FACE_XMAX] + part->counts[FACE_ZMIN] + 
+		part->counts[FACE_ZMAX] + part->counts[FACE_YMIN] + part->counts[FACE_YMAX];
+}
+
+static cc_uint32 PartsVerticesCount(struct ChunkPartInfo* ptr) {
+	cc_uint32 count = 0;
+	int i;
+	if (!ptr) return 0;
+
+	for (i = 0; i < MapRenderer_1DUsedCount; i++, ptr += chunksCount) {
+		if (ptr->offset >= 0) count += PartVerticesCount(ptr);
+	}
+	return count;
+}
+
+/* Returns the estimated bytes of video memory used by the mesh of the given chunk */
+static cc_uint32 ChunkVRAMSize(struct ChunkInfo* info) {
+	cc_uint32 count = PartsVerticesCount(info->normalParts) + PartsVerticesCount(info->translucentParts);
+	return count * (Builder_PackedVertices ? SIZEOF_VERTEX_PACKED : SIZEOF_VERTEX_TEXTURED);
+}
+
 /* Deletes vertex buffer associated with the given chunk and updates internal state */
 static void DeleteChunk(struct ChunkInfo* info) {
 	struct ChunkPartInfo* ptr;
@@ -318,16 +1294,23 @@ static void DeleteChunk(struct ChunkInfo* info) {
 #ifdef CC_BUILD_GL11
 	int j;
 #else
-	Gfx_DeleteVb(&info->vb);
+	if (info->poolBlock >= 0) {
+		FreePoolBlock(info);
+	} else {
+		Gfx_DeleteVb(&info->vb);
+	}
+	Mem_Free(info->vertices);
+	info->vertices = NULL;
+	MarkRegionDirty(info);
 #endif
+	LoadedChunks_Clear(info);
+	Game_VRAMUsage[VRAM_CHUNKS] -= ChunkVRAMSize(info);
 
 	info->empty  = false; 
 	info->allAir = false;
 	info->noData = true;
-#ifdef OCCLUSION
-	info.OcclusionFlags = 0;
-	info.OccludedFlags = 0;
-#endif
+	/* Assume chunk can be seen through until it is rebuilt */
+	Mem_Set(info->connects, 0x3F, sizeof(info->connects));
 
 	if (info->normalParts) {
 		ptr = info->normalParts;
@@ -354,19 +1337,31 @@ static void DeleteChunk(struct ChunkInfo* info) {
 	}
 }
 
-/* Builds the mesh (hence vertex buffer) for the given chunk, and updates internal state */
-static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
-	struct ChunkPartInfo* ptr;
-	int i;
+/* Chunks which are waiting for their mesh to be built this frame */
+static struct ChunkInfo* buildChunks[MAX_CHUNK_UPDATES];
+static int buildChunksCount;
 
+/* Adds the given chunk to the list of chunks whose meshes are built at the end of this frame's update */
+static void QueueChunk(struct ChunkInfo* info, int* chunkUpdates) {
 	Game.ChunkUpdates++;
 	(*chunkUpdates)++;
-	Builder_MakeChunk(info);
+	buildChunks[buildChunksCount++] = info;
+}
+
+/* Updates internal state after the mesh (hence vertex buffer) for the given chunk has been built */
+static void FinishChunk(struct ChunkInfo* info) {
+	struct ChunkPartInfo* ptr;
+	int i;
 
 	info->dirty  = false;
 	info->noData = !info->normalParts && !info->translucentParts;
 	info->empty  = info->noData;
 	if (info->empty) return;
+#ifndef CC_BUILD_GL11
+	MarkRegionDirty(info);
+#endif
+	LoadedChunks_Set(info);
+	Game_VRAMUsage[VRAM_CHUNKS] += ChunkVRAMSize(info);
 	
 	if (info->normalParts) {
 		ptr = info->normalParts;
@@ -384,6 +1379,210 @@ static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------Region batching-----------------------------------------------------*
+*#########################################################################################################################*/
+#ifndef CC_BUILD_GL11
+/* Returns the chunks in the given region that have vertices */
+static int GetRegionChunks(int index, struct ChunkInfo** chunks) {
+	int rx = index % regionsX, ry = (index / regionsX) % regionsY, rz = index / (regionsX * regionsY);
+	int x1 = rx << REGION_SHIFT, x2 = min(World.ChunksX, x1 + (1 << REGION_SHIFT));
+	int y1 = ry << REGION_SHIFT, y2 = min(World.ChunksY, y1 + (1 << REGION_SHIFT));
+	int z1 = rz << REGION_SHIFT, z2 = min(World.ChunksZ, z1 + (1 << REGION_SHIFT));
+	struct ChunkInfo* info;
+	int cx, cy, cz, count = 0;
+
+	for (cz = z1; cz < z2; cz++) {
+		for (cy = y1; cy < y2; cy++) {
+			for (cx = x1; cx < x2; cx++) {
+				info = &mapChunks[World_ChunkPack(cx, cy, cz)];
+				if (info->vertices) chunks[count++] = info;
+			}
+		}
+	}
+	return count;
+}
+
+/* Calculates the number of vertices in each face of the merged parts, returning total number of vertices */
+static int CountRegionParts(int index, struct ChunkInfo** chunks, int count) {
+	struct RegionPartInfo* dst;
+	struct ChunkPartInfo* src;
+	int i, batch, face, total = 0;
+
+	for (batch = 0; batch < MapRenderer_1DUsedCount; batch++) {
+		dst = &regionParts[regionsCount * batch + index];
+		Mem_Set(dst, 0, sizeof(struct RegionPartInfo));
+		dst->offset = -1;
+
+		for (i = 0; i < count; i++) {
+			if (!chunks[i]->normalParts) continue;
+			src = &chunks[i]->normalParts[chunksCount * batch];
+			if (src->offset < 0) continue;
+
+			dst->offset       = 0;
+			dst->spriteCount += src->spriteCount;
+			for (face = 0; face < FACE_COUNT; face++) dst->counts[face] += src->counts[face];
+			total += PartVerticesCount(src);
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!chunks[i]->translucentParts) continue;
+
+		for (batch = 0; batch < MapRenderer_1DUsedCount; batch++) {
+			src = &chunks[i]->translucentParts[chunksCount * batch];
+			if (src->offset >= 0) total += PartVerticesCount(src);
+		}
+	}
+	return total;
+}
+
+static cc_uint8* regionData;
+static int regionStride, regionOffset;
+/* Appends the given range of a chunk's vertices to the region vertex buffer */
+static void CopyRegionVertices(struct ChunkInfo* info, int offset, int count) {
+	Mem_Copy(regionData + regionOffset * regionStride, 
+			(cc_uint8*)info->vertices + offset * regionStride, count * regionStride);
+	regionOffset += count;
+}
+
+static void CopyNormalParts(int index, struct ChunkInfo** chunks, int count) {
+	struct RegionPartInfo* dst;
+	struct ChunkPartInfo* src;
+	int i, j, batch, face, offset;
+
+	for (batch = 0; batch < MapRenderer_1DUsedCount; batch++) {
+		dst = &regionParts[regionsCount * batch + index];
+		if (dst->offset < 0) continue;
+		dst->offset = regionOffset;
+
+		/* Each of the 4 groups of sprite vertices is drawn separately */
+		for (j = 0; j < 4; j++) {
+			for (i = 0; i < count; i++) {
+				if (!chunks[i]->normalParts) continue;
+				src = &chunks[i]->normalParts[chunksCount * batch];
+				if (src->offset < 0) continue;
+				CopyRegionVertices(chunks[i], src->offset + j * (src->spriteCount >> 2), src->spriteCount >> 2);
+			}
+		}
+
+		for (face = 0; face < FACE_COUNT; face++) {
+			for (i = 0; i < count; i++) {
+				if (!chunks[i]->normalParts) continue;
+				src = &chunks[i]->normalParts[chunksCount * batch];
+				if (src->offset < 0) continue;
+
+				offset = src->offset + src->spriteCount;
+				for (j = 0; j < face; j++) offset += src->counts[j];
+				CopyRegionVertices(chunks[i], offset, src->counts[face]);
+			}
+		}
+	}
+}
+
+/* Translucent parts are still drawn per chunk, so are just moved into the region's vertex buffer */
+/* NOTE: Parts are stored in (normal 0, translucent 0, normal 1, translucent 1 ...) order in chunk vertices */
+static void CopyTranslucentParts(struct ChunkInfo** chunks, int count) {
+	struct ChunkPartInfo* src;
+	int i, batch, offset, vertices;
+
+	for (i = 0; i < count; i++) {
+		if (!chunks[i]->translucentParts) continue;
+		offset = 0;
+
+		for (batch = 0; batch < MapRenderer_1DUsedCount; batch++) {
+			if (chunks[i]->normalParts) {
+				src = &chunks[i]->normalParts[chunksCount * batch];
+				if (src->offset >= 0) offset += PartVerticesCount(src);
+			}
+
+			src = &chunks[i]->translucentParts[chunksCount * batch];
+			if (src->offset < 0) continue;
+			vertices    = PartVerticesCount(src);
+			src->offset = regionOffset;
+
+			CopyRegionVertices(chunks[i], offset, vertices);
+			offset += vertices;
+		}
+	}
+}
+
+/* Rebuilds the vertex buffer of the given region from the vertices of the chunks in it */
+static void BuildRegion(int index) {
+	struct RegionInfo* region = &mapRegions[index];
+	struct ChunkInfo* chunks[REGION_MAX_CHUNKS];
+	VertexFormat fmt;
+	int count, total;
+
+	region->dirty = false;
+	Gfx_DeleteVb(&region->vb);
+
+	count = GetRegionChunks(index, chunks);
+	total = CountRegionParts(index, chunks, count);
+	if (!total) return;
+
+	fmt          = Builder_PackedVertices ? VERTEX_FORMAT_PACKED : VERTEX_FORMAT_TEXTURED;
+	regionStride = Builder_PackedVertices ? SIZEOF_VERTEX_PACKED : SIZEOF_VERTEX_TEXTURED;
+	regionOffset = 0;
+	/* add an extra element to fix crashing on some GPUs */
+	regionData   = (cc_uint8*)Gfx_RecreateAndLockVb(&region->vb, fmt, total + 1);
+
+	CopyNormalParts(index, chunks, count);
+	CopyTranslucentParts(chunks, count);
+	Gfx_UnlockVb(region->vb);
+}
+
+static void DeleteRegions(void) {
+	int i;
+	if (!mapRegions) return;
+
+	for (i = 0; i < regionsCount; i++) {
+		Gfx_DeleteVb(&mapRegions[i].vb);
+		mapRegions[i].dirty  = true;
+		mapRegions[i].listed = false;
+	}
+	renderRegionsCount = 0;
+	regionsDirty       = true;
+}
+
+/* Rebuilds changed regions, then calculates which regions need to be rendered */
+static void UpdateRegions(void) {
+	struct RegionInfo* region;
+	struct ChunkInfo* info;
+	int i, j = 0;
+
+	if (regionsDirty) {
+		for (i = 0; i < regionsCount; i++) {
+			if (mapRegions[i].dirty) BuildRegion(i);
+		}
+		regionsDirty = false;
+	}
+
+	for (i = 0; i < renderRegionsCount; i++) {
+		renderRegions[i]->listed = false;
+	}
+
+	/* renderChunks is sorted by distance, so renderRegions is also roughly sorted by distance */
+	for (i = 0; i < renderChunksCount; i++) {
+		info   = renderChunks[i];
+		region = GetRegion(info);
+
+		if (!region->listed) {
+			region->listed   = true;
+			region->drawXMin = false; region->drawXMax = false; region->drawZMin = false;
+			region->drawZMax = false; region->drawYMin = false; region->drawYMax = false;
+			renderRegions[j++] = region;
+		}
+
+		region->drawXMin |= info->drawXMin; region->drawXMax |= info->drawXMax;
+		region->drawZMin |= info->drawZMin; region->drawZMax |= info->drawZMax;
+		region->drawYMin |= info->drawYMin; region->drawYMax |= info->drawYMax;
+	}
+	renderRegionsCount = j;
+}
+#endif
+
+
 /*########################################################################################################################*
 *----------------------------------------------------Chunks mangagement---------------------------------------------------*
 *#########################################################################################################################*/
@@ -391,6 +1590,10 @@ static void FreeParts(void) {
 	Mem_Free(MapRenderer_PartsNormal);
 	MapRenderer_PartsNormal      = NULL;
 	MapRenderer_PartsTranslucent = NULL;
+#ifndef CC_BUILD_GL11
+	Mem_Free(regionParts);
+	regionParts = NULL;
+#endif
 }
 
 static void FreeChunks(void) {
@@ -398,11 +1601,35 @@ static void FreeChunks(void) {
 	Mem_Free(sortedChunks);
 	Mem_Free(renderChunks);
 	Mem_Free(distances);
+	Mem_Free(loadedChunks);
+	Mem_Free(occlusionQueue);
+	Mem_Free(sortedCentresX);
+	Mem_Free(inFrustum);
+	Mem_Free(sortTmpChunks);
+	Mem_Free(sortTmpDistances);
+	Mem_Free(chunkQueries);
+	Mem_Free(queryChunks);
 
 	mapChunks    = NULL;
 	sortedChunks = NULL;
 	renderChunks = NULL;
 	distances    = NULL;
+	loadedChunks = NULL;
+	occlusionQueue = NULL;
+	sortedCentresX = NULL;
+	inFrustum      = NULL;
+	sortTmpChunks    = NULL;
+	sortTmpDistances = NULL;
+	chunkQueries     = NULL;
+	queryChunks      = NULL;
+	queryChunksCount = 0;
+#ifndef CC_BUILD_GL11
+	Mem_Free(mapRegions);
+	Mem_Free(renderRegions);
+	mapRegions    = NULL;
+	renderRegions = NULL;
+	renderRegionsCount = 0;
+#endif
 }
 
 static void AllocateParts(void) {
@@ -412,6 +1639,12 @@ static void AllocateParts(void) {
 	ptr = (struct ChunkPartInfo*)Mem_AllocCleared(count * 2, sizeof(struct ChunkPartInfo), "chunk parts");
 	MapRenderer_PartsNormal      = ptr;
 	MapRenderer_PartsTranslucent = ptr + count;
+
+#ifndef CC_BUILD_GL11
+	if (!mapRegions) return;
+	regionParts = (struct RegionPartInfo*)Mem_Alloc(regionsCount * MapRenderer_1DUsedCount, 
+											sizeof(struct RegionPartInfo), "region parts");
+#endif
 }
 
 static void AllocateChunks(void) {
@@ -419,6 +1652,34 @@ static void AllocateChunks(void) {
 	sortedChunks = (struct ChunkInfo**)Mem_Alloc(chunksCount, sizeof(struct ChunkInfo*), "sorted chunk info");
 	renderChunks = (struct ChunkInfo**)Mem_Alloc(chunksCount, sizeof(struct ChunkInfo*), "render chunk info");
 	distances    = (cc_uint32*)Mem_Alloc(chunksCount, 4, "chunk distances");
+	sortTmpChunks    = (struct ChunkInfo**)Mem_Alloc(chunksCount, sizeof(struct ChunkInfo*), "sorting chunk info");
+	sortTmpDistances = (cc_uint32*)Mem_Alloc(chunksCount, 4, "sorting chunk distances");
+	loadedChunks = (cc_uint32*)Mem_AllocCleared((chunksCount + 31) >> 5, 4, "loaded chunks");
+	inFrustum    = (cc_uint32*)Mem_Alloc((chunksCount + 31) >> 5, 4, "chunks in frustum");
+
+	sortedCentresX = (float*)Mem_Alloc(chunksCount * 3, sizeof(float), "chunk centres");
+	sortedCentresY = sortedCentresX + chunksCount;
+	sortedCentresZ = sortedCentresY + chunksCount;
+
+	if (MapRenderer_OcclusionCulling) {
+		/* Each chunk can be entered at most once through each of its faces */
+		occlusionQueue = (cc_uint32*)Mem_Alloc(chunksCount * FACE_COUNT + 1, 4, "occlusion queue");
+	}
+	if (MapRenderer_OcclusionQueries) {
+		chunkQueries = (struct ChunkQuery*)Mem_AllocCleared(chunksCount, sizeof(struct ChunkQuery), "chunk queries");
+		queryChunks  = (struct ChunkInfo**)Mem_Alloc(chunksCount, sizeof(struct ChunkInfo*),         "query chunks");
+	}
+
+#ifndef CC_BUILD_GL11
+	if (!MapRenderer_RegionBatching) return;
+	regionsX = (World.ChunksX + (1 << REGION_SHIFT) - 1) >> REGION_SHIFT;
+	regionsY = (World.ChunksY + (1 << REGION_SHIFT) - 1) >> REGION_SHIFT;
+	regionsZ = (World.ChunksZ + (1 << REGION_SHIFT) - 1) >> REGION_SHIFT;
+	regionsCount = regionsX * regionsY * regionsZ;
+
+	mapRegions    = (struct RegionInfo*) Mem_AllocCleared(regionsCount, sizeof(struct RegionInfo), "region info");
+	renderRegions = (struct RegionInfo**)Mem_Alloc(regionsCount, sizeof(struct RegionInfo*), "render region info");
+#endif
 }
 
 static void ResetPartFlags(void) {
@@ -439,6 +1700,18 @@ static void ResetPartCounts(void) {
 	}
 }
 
+static void UpdateSortedCentres(void) {
+	struct ChunkInfo* info;
+	int i;
+
+	for (i = 0; i < chunksCount; i++) {
+		info = sortedChunks[i];
+		sortedCentresX[i] = info->centreX;
+		sortedCentresY[i] = info->centreY;
+		sortedCentresZ[i] = info->centreZ;
+	}
+}
+
 static void InitChunks(void) {
 	int x, y, z, index = 0;
 	for (z = 0; z < World.Length; z += CHUNK_SIZE) {
@@ -452,6 +1725,7 @@ static void InitChunks(void) {
 			}
 		}
 	}
+	UpdateSortedCentres();
 }
 
 static void ResetChunks(void) {
@@ -473,14 +1747,19 @@ static void DeleteChunks(void) {
 	for (i = 0; i < chunksCount; i++) {
 		DeleteChunk(&mapChunks[i]);
 	}
+	Game_VRAMUsage[VRAM_CHUNKS] = 0;
 	ResetPartCounts();
+#ifndef CC_BUILD_GL11
+	DeleteRegions();
+#endif
 }
 
 void MapRenderer_Refresh(void) {
 	int oldCount;
-	chunkPos = IVec3_MaxValue();
+	InvalidateSortOrder();
+	budgetDistSquared = Int32_MaxValue;
 
-	if (mapChunks && World.Blocks) {
+	if (mapChunks && World_HasBlocks()) {
 		DeleteChunks();
 		ResetChunks();
 
@@ -493,6 +1772,7 @@ void MapRenderer_Refresh(void) {
 		}
 	}
 	ResetPartCounts();
+	InvalidateFarTerrain();
 }
 
 /* Refreshes chunks on the border of the map whose y is less than 'maxHeight'. */
@@ -500,8 +1780,8 @@ static void RefreshBorderChunks(int maxHeight) {
 	int cx, cy, cz;
 	cc_bool onBorder;
 
-	chunkPos = IVec3_MaxValue();
-	if (!mapChunks || !World.Blocks) return;
+	InvalidateSortOrder();
+	if (!mapChunks || !World_HasBlocks()) return;
 
 	for (cz = 0; cz < World.ChunksZ; cz++) {
 		for (cy = 0; cy < World.ChunksY; cy++) {
@@ -517,19 +1797,107 @@ static void RefreshBorderChunks(int maxHeight) {
 }
 
 
+/*########################################################################################################################*
+*---------------------------------------------------Occlusion culling-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Flood fills outwards from the chunk the camera is in, through the faces of chunks that connect to each other. */
+/* Chunks which are never reached can't be seen from the camera (e.g. caves underground when above the surface) */
+/* NOTE: The flood fill can never travel back in the opposite direction to a direction it has already travelled, */
+/*  and only travels through chunks in the view frustum. (see "Advanced Cave Culling Algorithm" by Tommaso Checchi) */
+#define Occlusion_Pack(index, dirs, face) (((index) << 9) | ((dirs) << 3) | (face))
+static const cc_int8 occlusionOffsets[FACE_COUNT][3] = { { -1,0,0 }, { 1,0,0 }, { 0,0,-1 }, { 0,0,1 }, { 0,-1,0 }, { 0,1,0 } };
+
+static void CalcOcclusion(void) {
+	struct ChunkInfo* info;
+	struct ChunkInfo* other;
+	int head = 0, tail = 0, i, index;
+	int cx, cy, cz, nx, ny, nz, face, entry, dirs;
+	cc_uint32 value;
+	IVec3 pos;
+
+	IVec3_Floor(&pos, &Camera.CurrentPos);
+	cx = pos.x >> CHUNK_SHIFT; cy = pos.y >> CHUNK_SHIFT; cz = pos.z >> CHUNK_SHIFT;
+
+	/* Camera outside the map (e.g. flying above it), so can't easily tell what can be seen */
+	if (!World_Contains(pos.x, pos.y, pos.z)) {
+		for (i = 0; i < chunksCount; i++) mapChunks[i].occlusionEntry = OCCLUSION_START;
+		return;
+	}
+	for (i = 0; i < chunksCount; i++) mapChunks[i].occlusionEntry = 0;
+
+	index = World_ChunkPack(cx, cy, cz);
+	mapChunks[index].occlusionEntry = OCCLUSION_START;
+	occlusionQueue[tail++] = Occlusion_Pack(index, 0, FACE_COUNT);
+
+	while (head < tail) {
+		value = occlusionQueue[head++];
+		index = value >> 9; dirs = (value >> 3) & 0x3F; entry = value & 0x07;
+
+		info = &mapChunks[index];
+		cx = info->centreX >> CHUNK_SHIFT; cy = info->centreY >> CHUNK_SHIFT; cz = info->centreZ >> CHUNK_SHIFT;
+
+		for (face = 0; face < FACE_COUNT; face++) 
+		{
+			/* Never go back towards the camera */
+			if (dirs & (1 << (face ^ 1))) continue;
+			/* Can the given face be seen through this chunk from the face it was entered through */
+			if (entry != FACE_COUNT && !(info->connects[entry] & (1 << face))) continue;
+
+			nx = cx + occlusionOffsets[face][0]; ny = cy + occlusionOffsets[face][1]; nz = cz + occlusionOffsets[face][2];
+			if (nx < 0 || ny < 0 || nz < 0 || nx >= World.ChunksX || ny >= World.ChunksY || nz >= World.ChunksZ) continue;
+
+			/* Neighbour is entered through the opposite face to the one this chunk is left through */
+			i     = World_ChunkPack(nx, ny, nz);
+			other = &mapChunks[i];
+			if (other->occlusionEntry & (1 << (face ^ 1))) continue;
+			if (!FrustumCulling_SphereInFrustum(other->centreX, other->centreY, other->centreZ, 14)) continue;
+
+			other->occlusionEntry |= 1 << (face ^ 1);
+			occlusionQueue[tail++] = Occlusion_Pack(i, dirs | (1 << face), face ^ 1);
+		}
+	}
+}
+
+
 /*########################################################################################################################*
 *--------------------------------------------------Chunks updating/sorting------------------------------------------------*
 *#########################################################################################################################*/
 #define CHUNK_TARGET_TIME ((1.0f/30) + 0.01f)
 static int chunksTarget = 12;
-static Vec3 lastCamPos;
-static float lastYaw, lastPitch;
+/* Number of chunks that can be queued for building this frame */
+static int chunksAllowed;
+static Vec3 lastCamPos[MAX_LOCAL_PLAYERS];
+static float lastYaw[MAX_LOCAL_PLAYERS], lastPitch[MAX_LOCAL_PLAYERS];
 /* Max distance from camera that chunks are rendered within */
 /* This may differ from the view distance configured by the user */
 static int renderDistSquared;
 /* Max distance from camera that chunks are built within */
 /* Chunks past this distance are automatically unloaded */
 static int buildDistSquared;
+/* Value of EnvRenderer_FogCullDistance when view distances were last calculated */
+static int fogCullDist;
+
+static void InvalidateVisibility(void) {
+	int i;
+	for (i = 0; i < MAX_LOCAL_PLAYERS; i++) lastCamPos[i] = Vec3_BigPos();
+}
+
+/* Returns squared distance from the given chunk to the closest view's chunk */
+static cc_uint32 CalcChunkDistance(struct ChunkInfo* info) {
+	cc_uint32 dist, minDist = Int32_MaxValue;
+	int i, dx, dy, dz;
+
+	for (i = 0; i < Game_NumStates; i++) 
+	{
+		/* View hasn't been rendered yet */
+		if (chunkPos[i].x == Int32_MaxValue) continue;
+
+		dx = info->centreX - chunkPos[i].x; dy = info->centreY - chunkPos[i].y; dz = info->centreZ - chunkPos[i].z;
+		dist    = dx * dx + dy * dy + dz * dz;
+		minDist = min(minDist, dist);
+	}
+	return minDist;
+}
 
 static int AdjustDist(int dist) {
 	if (dist < CHUNK_SIZE) dist = CHUNK_SIZE;
@@ -538,19 +1906,75 @@ static int AdjustDist(int dist) {
 }
 
 static void CalcViewDists(void) {
-	buildDistSquared  = AdjustDist(Game_UserViewDistance);
-	renderDistSquared = AdjustDist(Game_ViewDistance);
+	int buildDist = Game_UserViewDistance, renderDist = Game_ViewDistance, viewDist;
+	/* Chunks that are completely fogged out would just be drawn in the fog colour anyways */
+	/* NOTE: Build distance is unaffected, so chunks don't need rebuilding once fog clears */
+	fogCullDist = EnvRenderer_FogCullDistance;
+	if (fogCullDist) renderDist = min(renderDist, fogCullDist);
+	viewDist = renderDist;
+
+	/* Chunks past the detail distance are drawn as low detail far terrain instead */
+	if (MapRenderer_DetailDistance) {
+		buildDist  = min(buildDist,  MapRenderer_DetailDistance);
+		renderDist = min(renderDist, MapRenderer_DetailDistance);
+	}
+
+	buildDistSquared  = AdjustDist(buildDist);
+	renderDistSquared = AdjustDist(renderDist);
+	farStartDistSq    = buildDistSquared;
+	farEndDistSq      = AdjustDist(viewDist);
+}
+
+/* Returns the number of chunks at the start of sortedChunks that are close enough */
+/*  to the camera to possibly need building, unloading or rendering */
+/* NOTE: Chunks past this are never visible, so per frame work only has to scale with chunks in view */
+static int CountNearChunks(void) {
+	cc_uint32 maxDist = max(renderDistSquared, buildDistSquared + 32 * 16);
+	int lo = 0, hi = chunksCount, mid;
+
+	/* Distances are sorted from nearest to furthest */
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if (distances[mid] <= maxDist) { lo = mid + 1; } else { hi = mid; }
+	}
+	return lo;
+}
+
+/* Unloads chunks that are too far away, but are past the chunks checked by CountNearChunks */
+static void UnloadFarChunks(void) {
+	int unloadDistSqr = buildDistSquared + 32 * 16;
+	struct ChunkInfo* info;
+	int i, bit;
+	cc_uint32 bits;
+
+	for (i = 0; i < (chunksCount + 31) >> 5; i++) 
+	{
+		bits = loadedChunks[i];
+		for (bit = 0; bits; bit++, bits >>= 1) 
+		{
+			if (!(bits & 1)) continue;
+			info = &mapChunks[(i << 5) + bit];
+
+			if (CalcChunkDistance(info) >= unloadDistSqr) DeleteChunk(info);
+		}
+	}
 }
 
 static int UpdateChunksAndVisibility(int* chunkUpdates) {
 	int renderDistSqr = renderDistSquared;
-	int buildDistSqr  = buildDistSquared;
+	int buildDistSqr  = min(buildDistSquared, budgetDistSquared);
+	int nearCount     = CountNearChunks();
 
 	struct ChunkInfo* info;
 	int i, j = 0, distSqr;
 	cc_bool noData;
 
-	for (i = 0; i < chunksCount; i++) {
+	if (MapRenderer_OcclusionCulling) CalcOcclusion();
+	UnloadFarChunks();
+	FrustumCulling_SpheresInFrustum(sortedCentresX, sortedCentresY, sortedCentresZ,
+									nearCount, 14, inFrustum); /* 14 ~ sqrt(3 * 8^2) */
+
+	for (i = 0; i < nearCount; i++) {
 		info = sortedChunks[i];
 		if (info->empty) continue;
 
@@ -563,13 +1987,13 @@ static int UpdateChunksAndVisibility(int* chunkUpdates) {
 		}
 		noData |= info->dirty;
 
-		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget) {
+		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksAllowed) {
 			DeleteChunk(info);
-			BuildChunk(info, chunkUpdates);
+			QueueChunk(info, chunkUpdates);
 		}
 
-		info->visible = distSqr <= renderDistSqr &&
-			FrustumCulling_SphereInFrustum(info->centreX, info->centreY, info->centreZ, 14); /* 14 ~ sqrt(3 * 8^2) */
+		info->visible = distSqr <= renderDistSqr && InFrustum_Get(i) &&
+			(!MapRenderer_OcclusionCulling || info->occlusionEntry);
 		if (info->visible && !info->empty) { renderChunks[j] = info; j++; }
 	}
 	return j;
@@ -577,13 +2001,14 @@ static int UpdateChunksAndVisibility(int* chunkUpdates) {
 
 static int UpdateChunksStill(int* chunkUpdates) {
 	int renderDistSqr = renderDistSquared;
-	int buildDistSqr  = buildDistSquared;
+	int buildDistSqr  = min(buildDistSquared, budgetDistSquared);
+	int nearCount     = CountNearChunks();
 
 	struct ChunkInfo* info;
 	int i, j = 0, distSqr;
 	cc_bool noData;
 
-	for (i = 0; i < chunksCount; i++) {
+	for (i = 0; i < nearCount; i++) {
 		info = sortedChunks[i];
 		if (info->empty) continue;
 
@@ -596,13 +2021,14 @@ static int UpdateChunksStill(int* chunkUpdates) {
 		}
 		noData |= info->dirty;
 
-		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget) {
+		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksAllowed) {
 			DeleteChunk(info);
-			BuildChunk(info, chunkUpdates);
+			QueueChunk(info, chunkUpdates);
 
 			/* only need to update the visibility of chunks in range. */
 			info->visible = distSqr <= renderDistSqr &&
-				FrustumCulling_SphereInFrustum(info->centreX, info->centreY, info->centreZ, 14); /* 14 ~ sqrt(3 * 8^2) */
+				FrustumCulling_SphereInFrustum(info->centreX, info->centreY, info->centreZ, 14) && /* 14 ~ sqrt(3 * 8^2) */
+				(!MapRenderer_OcclusionCulling || info->occlusionEntry);
 			if (info->visible && !info->empty) { renderChunks[j] = info; j++; }
 		} else if (info->visible) {
 			renderChunks[j] = info; j++;
@@ -611,49 +2037,186 @@ static int UpdateChunksStill(int* chunkUpdates) {
 	return j;
 }
 
+/* Builds all the queued chunks at once (possibly in parallel) */
+static void BuildQueuedChunks(void) {
+	struct ChunkInfo* info;
+	int i, j = 0;
+
+	/* Blocks in and just around the chunks must exist before their meshes can be built */
+	for (i = 0; Gen_OnDemand && i < buildChunksCount; i++) {
+		info = buildChunks[i];
+		Gen_GenerateColumns(info->centreX - HALF_CHUNK_SIZE - 1, info->centreZ - HALF_CHUNK_SIZE - 1,
+							info->centreX + HALF_CHUNK_SIZE,     info->centreZ + HALF_CHUNK_SIZE);
+	}
+	Builder_MakeChunks(buildChunks, buildChunksCount);
+	for (i = 0; i < buildChunksCount; i++) {
+		FinishChunk(buildChunks[i]);
+	}
+	buildChunksCount = 0;
+
+	/* Queued chunks were added to the render list before knowing whether they were empty */
+	for (i = 0; i < renderChunksCount; i++) {
+		info = renderChunks[i];
+		if (!info->empty) { renderChunks[j] = info; j++; }
+	}
+	renderChunksCount = j;
+}
+
+/* Chunks closer than this are never freed to stay within the VRAM budget */
+#define BUDGET_MIN_DIST (2 * CHUNK_SIZE * 2 * CHUNK_SIZE)
+#define BUDGET_MAX_EVICTIONS 16
+/* How much further away chunks can be built each frame, once back under the VRAM budget */
+#define BUDGET_GROW_DIST (CHUNK_SIZE * CHUNK_SIZE * 4)
+
+/* Frees the meshes of the furthest chunks (and stops them being rebuilt) while over the VRAM budget */
+/* NOTE: Chunks further away are allowed to be built again slowly once usage drops back under 90% of the budget */
+static void UpdateVRAMBudget(void) {
+	struct ChunkInfo* info;
+	int i, evicted = 0;
+
+	if (!Game_VRAMOverBudget(100)) {
+		if (budgetDistSquared == Int32_MaxValue || Game_VRAMOverBudget(90)) return;
+
+		budgetDistSquared += BUDGET_GROW_DIST;
+		if (budgetDistSquared >= buildDistSquared) budgetDistSquared = Int32_MaxValue;
+		return;
+	}
+
+	/* Distances are sorted from nearest to furthest */
+	for (i = CountNearChunks() - 1; i >= 0 && evicted < BUDGET_MAX_EVICTIONS; i--)
+	{
+		if (distances[i] < BUDGET_MIN_DIST) break;
+		info = sortedChunks[i];
+		if (info->noData) continue;
+
+		DeleteChunk(info);
+		info->visible     = false;
+		budgetDistSquared = distances[i] - 1;
+		evicted++;
+		if (!Game_VRAMOverBudget(100)) break;
+	}
+}
+
+#ifdef CC_BUILD_SPLITSCREEN
+/* Which faces of a chunk need to be drawn depends on the camera, so must be recalculated for each view */
+static void UpdateViewDrawFlags(void) {
+	IVec3 pos = chunkPos[CUR_VIEW];
+	struct ChunkInfo* info;
+	int i, dx, dy, dz;
+
+	for (i = 0; i < renderChunksCount; i++) 
+	{
+		info = renderChunks[i];
+		dx = info->centreX - pos.x; dy = info->centreY - pos.y; dz = info->centreZ - pos.z;
+
+		info->drawXMin = dx >= 0; info->drawXMax = dx <= 0;
+		info->drawZMin = dz >= 0; info->drawZMax = dz <= 0;
+		info->drawYMin = dy >= 0; info->drawYMax = dy <= 0;
+	}
+	ResetPartFlags();
+}
+#endif
+
 static void UpdateChunks(float delta) {
 	struct LocalPlayer* p;
 	cc_bool samePos;
 	int chunkUpdates = 0;
+	int view = CUR_VIEW;
+	cc_uint32 uploaded;
+
+	/* Chunks are only queued for building once per frame (while updating the first view), */
+	/*  as the build queue is shared with all other split-screen views */
+	if (view == 0) {
+		/* Build more chunks if 30 FPS or over, otherwise slowdown */
+		chunksTarget += delta < CHUNK_TARGET_TIME ? 1 : -1; 
+		Math_Clamp(chunksTarget, 4, maxChunkUpdates);
+
+		/* Don't build any more chunks until the uploads over budget from previous frames have been paid off, */
+		/*  to avoid many large uploads in the same frame stalling the CPU */
+		uploadDebt    = uploadDebt > uploadBudget ? uploadDebt - uploadBudget : 0;
+		chunksAllowed = uploadDebt ? 0 : chunksTarget;
+		UpdateVRAMBudget();
+	} else {
+		chunksAllowed = 0;
+	}
 
-	/* Build more chunks if 30 FPS or over, otherwise slowdown */
-	chunksTarget += delta < CHUNK_TARGET_TIME ? 1 : -1; 
-	Math_Clamp(chunksTarget, 4, maxChunkUpdates);
+	/* e.g. camera entered or left water */
+	if (fogCullDist != EnvRenderer_FogCullDistance) {
+		InvalidateVisibility();
+		CalcViewDists();
+	}
 
 	p = Entities.CurPlayer;
-	samePos = Vec3_Equals(&Camera.CurrentPos, &lastCamPos)
-		&& p->Base.Pitch == lastPitch && p->Base.Yaw == lastYaw;
+	samePos = Vec3_Equals(&Camera.CurrentPos, &lastCamPos[view])
+		&& p->Base.Pitch == lastPitch[view] && p->Base.Yaw == lastYaw[view];
+	/* ChunkInfo visibility is shared between views, so must always be recalculated */
+	if (Game_NumStates > 1) samePos = false;
 
 	renderChunksCount = samePos ?
 		UpdateChunksStill(&chunkUpdates) :
 		UpdateChunksAndVisibility(&chunkUpdates);
 
-	lastCamPos = Camera.CurrentPos;
-	lastPitch  = p->Base.Pitch;
-	lastYaw    = p->Base.Yaw;
+	uploaded = Gfx_Stats.bytesUploaded;
+	if (buildChunksCount) BuildQueuedChunks();
+	/* Query results would be mixed up between split-screen views */
+	if (chunkQueries && Game_NumStates == 1 && UpdateOcclusionQueries()) samePos = false;
+#ifndef CC_BUILD_GL11
+	if (mapRegions) UpdateRegions();
+#endif
+	if (uploadBudget) uploadDebt += Gfx_Stats.bytesUploaded - uploaded;
+
+	lastCamPos[view] = Camera.CurrentPos;
+	lastPitch[view]  = p->Base.Pitch;
+	lastYaw[view]    = p->Base.Yaw;
+	/* Rebuilt chunks may have changed which chunks can be seen through */
+	if (MapRenderer_OcclusionCulling && chunkUpdates) lastCamPos[view] = Vec3_BigPos();
 
+#ifdef CC_BUILD_SPLITSCREEN
+	if (Game_NumStates > 1) { UpdateViewDrawFlags(); return; }
+#endif
 	if (!samePos || chunkUpdates) ResetPartFlags();
 }
 
-static void SortMapChunks(int left, int right) {
-	struct ChunkInfo** values = sortedChunks; struct ChunkInfo* value;
-	cc_uint32* keys = distances; cc_uint32 key;
+#define SORT_RADIX_BITS 11
+#define SORT_RADIX_SIZE (1 << SORT_RADIX_BITS)
+static int sortCounts[SORT_RADIX_SIZE];
+
+/* Sorts sortedChunks by distance using a least significant digit radix sort */
+/* NOTE: Distances are usually less than 2^22, so this only takes 2 linear passes over all chunks */
+static void SortMapChunks(void) {
+	struct ChunkInfo** values; struct ChunkInfo** tmpValues;
+	cc_uint32* keys; cc_uint32* tmpKeys;
+	cc_uint32 key, maxKey = 0;
+	int i, shift, index, sum, count;
+
+	for (i = 0; i < chunksCount; i++) { maxKey = max(maxKey, distances[i]); }
+
+	for (shift = 0; shift < 32 && (maxKey >> shift); shift += SORT_RADIX_BITS) 
+	{
+		keys    = distances;        values    = sortedChunks;
+		tmpKeys = sortTmpDistances; tmpValues = sortTmpChunks;
+		Mem_Set(sortCounts, 0, sizeof(sortCounts));
 
-	while (left < right) {
-		int i = left, j = right;
-		cc_uint32 pivot = keys[(i + j) >> 1];
+		for (i = 0; i < chunksCount; i++) {
+			sortCounts[(keys[i] >> shift) & (SORT_RADIX_SIZE - 1)]++;
+		}
+		for (i = 0, sum = 0; i < SORT_RADIX_SIZE; i++) {
+			count = sortCounts[i]; sortCounts[i] = sum; sum += count;
+		}
 
-		/* partition the list */
-		while (i <= j) {
-			while (pivot > keys[i]) i++;
-			while (pivot < keys[j]) j--;
-			QuickSort_Swap_KV_Maybe();
+		for (i = 0; i < chunksCount; i++) {
+			key   = keys[i];
+			index = sortCounts[(key >> shift) & (SORT_RADIX_SIZE - 1)]++;
+			tmpKeys[index] = key; tmpValues[index] = values[i];
 		}
-		/* recurse into the smaller subset */
-		QuickSort_Recurse(SortMapChunks)
+
+		/* Sorted output of this pass becomes the input of the next pass */
+		distances    = tmpKeys;   sortTmpDistances = keys;
+		sortedChunks = tmpValues; sortTmpChunks    = values;
 	}
 }
 
+#define TRANSLUCENT_RESORT_DIST ((2 * CHUNK_SIZE) * (2 * CHUNK_SIZE))
 static void UpdateSortOrder(void) {
 	struct ChunkInfo* info;
 	IVec3 pos;
@@ -666,15 +2229,15 @@ static void UpdateSortOrder(void) {
 	pos.z = (pos.z & ~CHUNK_MASK) + HALF_CHUNK_SIZE;
 
 	/* If in same chunk, don't need to recalculate sort order */
-	if (pos.x == chunkPos.x && pos.y == chunkPos.y && pos.z == chunkPos.z) return;
-	chunkPos = pos;
+	if (pos.x == chunkPos[CUR_VIEW].x && pos.y == chunkPos[CUR_VIEW].y && pos.z == chunkPos[CUR_VIEW].z) return;
+	chunkPos[CUR_VIEW] = pos;
 	if (!chunksCount) return;
 
 	for (i = 0; i < chunksCount; i++) {
 		info = sortedChunks[i];
-		/* Calculate distance to chunk centre */
+		/* Calculate distance to chunk centre (of the closest view for split-screen) */
 		dx = info->centreX - pos.x; dy = info->centreY - pos.y; dz = info->centreZ - pos.z;
-		distances[i] = dx * dx + dy * dy + dz * dz;
+		distances[i] = Game_NumStates > 1 ? CalcChunkDistance(info) : (cc_uint32)(dx * dx + dy * dy + dz * dz);
 
 		/* Consider these 3 chunks: */
 		/* |       X-1      |        X        |       X+1      | */
@@ -687,17 +2250,34 @@ static void UpdateSortOrder(void) {
 		info->drawXMin = dx >= 0; info->drawXMax = dx <= 0;
 		info->drawZMin = dz >= 0; info->drawZMax = dz <= 0;
 		info->drawYMin = dy >= 0; info->drawYMax = dy <= 0;
+
+		/* Order of translucent quads in nearby chunks is most likely to be noticeably wrong */
+		if (MapRenderer_SortTranslucent && info->translucentParts && distances[i] <= TRANSLUCENT_RESORT_DIST) {
+			info->dirty = true;
+		}
 	}
 
-	SortMapChunks(0, chunksCount - 1);
+	SortMapChunks();
+	UpdateSortedCentres();
+	ResetPartFlags();
+}
+
+/* Whether block definitions changed since the last MapRenderer_Update */
+static cc_bool blockDefsChanged;
+static void ApplyBlockDefinitionChanges(void) {
+	blockDefsChanged = false;
+	MapRenderer_Refresh();
+	/* MapRenderer_Refresh only recounts used atlases when chunks exist */
+	if (!mapChunks || !World_HasBlocks()) MapRenderer_1DUsedCount = MapRenderer_UsedAtlases();
 	ResetPartFlags();
-	/*SimpleOcclusionCulling();*/
 }
 
 void MapRenderer_Update(float delta) {
+	if (blockDefsChanged) ApplyBlockDefinitionChanges();
 	if (!mapChunks) return;
 	UpdateSortOrder();
 	UpdateChunks(delta);
+	if (CUR_VIEW == 0) UpdateFarTerrain();
 }
 
 
@@ -714,6 +2294,13 @@ void MapRenderer_RefreshChunk(int cx, int cy, int cz) {
 	info->dirty = true;
 }
 
+cc_bool MapRenderer_IsChunkAir(int cx, int cy, int cz) {
+	if (!mapChunks) return false;
+	if (cx < 0 || cy < 0 || cz < 0 || cx >= World.ChunksX || cy >= World.ChunksY || cz >= World.ChunksZ) return false;
+
+	return mapChunks[World_ChunkPack(cx, cy, cz)].allAir;
+}
+
 void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block) {
 	int cx = x >> CHUNK_SHIFT, cy = y >> CHUNK_SHIFT, cz = z >> CHUNK_SHIFT;
 	struct ChunkInfo* chunk;
@@ -722,6 +2309,65 @@ void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block) {
 	chunk->allAir &= Blocks.Draw[block] == DRAW_GAS;
 	/* TODO: Don't lookup twice, refresh directly using chunk pointer */
 	MapRenderer_RefreshChunk(cx, cy, cz);
+	MarkFarTilesDirty(x, z, x, z);
+}
+
+void MapRenderer_OnBlocksChanged(int x1, int y1, int z1, int x2, int y2, int z2) {
+	int cx1 = x1 >> CHUNK_SHIFT, cy1 = y1 >> CHUNK_SHIFT, cz1 = z1 >> CHUNK_SHIFT;
+	int cx2 = x2 >> CHUNK_SHIFT, cy2 = y2 >> CHUNK_SHIFT, cz2 = z2 >> CHUNK_SHIFT;
+	int cx, cy, cz;
+
+	/* Not known which blocks were placed where, so assume the chunk is no longer all air */
+	/*  (chunk builder recalculates this anyways when it next builds the chunk) */
+	for (cy = cy1; cy <= cy2; cy++) {
+		for (cz = cz1; cz <= cz2; cz++) {
+			for (cx = cx1; cx <= cx2; cx++) {
+				mapChunks[World_ChunkPack(cx, cy, cz)].allAir = false;
+			}
+		}
+	}
+	MarkFarTilesDirty(x1, z1, x2, z2);
+
+	/* Blocks on the edges of the region also affect culling of faces in neighbouring chunks */
+	cx1 = (x1 - 1) >> CHUNK_SHIFT; cy1 = (y1 - 1) >> CHUNK_SHIFT; cz1 = (z1 - 1) >> CHUNK_SHIFT;
+	cx2 = (x2 + 1) >> CHUNK_SHIFT; cy2 = (y2 + 1) >> CHUNK_SHIFT; cz2 = (z2 + 1) >> CHUNK_SHIFT;
+
+	for (cy = cy1; cy <= cy2; cy++) {
+		for (cz = cz1; cz <= cz2; cz++) {
+			for (cx = cx1; cx <= cx2; cx++) {
+				MapRenderer_RefreshChunk(cx, cy, cz);
+			}
+		}
+	}
+}
+
+/* Whether the given block can affect meshes/lighting differently to the other block */
+static cc_bool RendersDifferently(BlockID a, BlockID b) {
+	return Blocks.Draw[a]        != Blocks.Draw[b]        || Blocks.FullOpaque[a]  != Blocks.FullOpaque[b] ||
+		   Blocks.BlocksLight[a] != Blocks.BlocksLight[b] || Blocks.Brightness[a]  != Blocks.Brightness[b] ||
+		   Blocks.LightOffset[a] != Blocks.LightOffset[b];
+}
+
+cc_bool MapRenderer_IsHiddenChange(int x, int y, int z, BlockID old, BlockID now) {
+	static const int offsets[FACE_COUNT][3] = { { -1,0,0 }, { 1,0,0 }, { 0,0,-1 }, { 0,0,1 }, { 0,-1,0 }, { 0,1,0 } };
+	BlockID other;
+	int face;
+
+	if (old == now) return true;
+	if (Blocks.Draw[old] == DRAW_SPRITE || RendersDifferently(old, now)) return false;
+	/* Blocks on the map borders are affected by sides/edge level */
+	if (x <= 0 || y <= 0 || z <= 0 || x >= World.MaxX || y >= World.MaxY || z >= World.MaxZ) return false;
+
+	for (face = 0; face < FACE_COUNT; face++) 
+	{
+		other = World_GetBlock(x + offsets[face][0], y + offsets[face][1], z + offsets[face][2]);
+
+		/* All faces of both blocks must be hidden by the neighbouring blocks */
+		if (!Block_IsFaceHidden(old, other, face) || !Block_IsFaceHidden(now, other, face)) return false;
+		/* Neighbouring blocks must be culled the same way */
+		if (!Block_IsFaceHidden(other, old, face ^ 1) != !Block_IsFaceHidden(other, now, face ^ 1)) return false;
+	}
+	return true;
 }
 
 static void OnEnvVariableChanged(void* obj, int envVar) {
@@ -737,29 +2383,50 @@ static void OnEnvVariableChanged(void* obj, int envVar) {
 	}
 }
 
-static void OnTerrainAtlasChanged(void* obj) {
-	static int tilesPerAtlas;
+/* Whether chunk meshes built against the old terrain atlas can still be drawn with the new atlas */
+/* Meshes only store tile coordinates, so swapping to an atlas with the same layout just needs new textures */
+static cc_bool AtlasLayoutChanged(void) {
+	static int tilesPerAtlas, layers;
+	static cc_bool uniformRows[ATLAS1D_MAX_ATLASES];
+	cc_bool changed;
+
 	/* e.g. If old atlas was 256x256 and new is 256x256, don't need to refresh */
-	if (MapRenderer_1DUsedCount && tilesPerAtlas != Atlas1D.TilesPerAtlas) {
-		MapRenderer_Refresh();
-	}
+	/* Greedy meshing stretches tiles with uniform rows, so those must match too */
+	changed = tilesPerAtlas != Atlas1D.TilesPerAtlas || layers != Atlas1D.Layers
+		|| !Mem_Equal(uniformRows, Atlas2D.UniformRows, sizeof(uniformRows));
 
-	MapRenderer_1DUsedCount = MapRenderer_UsedAtlases();
 	tilesPerAtlas = Atlas1D.TilesPerAtlas;
-	ResetPartFlags();
+	layers        = Atlas1D.Layers;
+	Mem_Copy(uniformRows, Atlas2D.UniformRows, sizeof(uniformRows));
+	return changed;
 }
 
-static void OnBlockDefinitionChanged(void* obj) {
-	MapRenderer_Refresh();
+static void OnTerrainAtlasChanged(void* obj) {
+	if (AtlasLayoutChanged() && MapRenderer_1DUsedCount) {
+		MapRenderer_Refresh();
+	}
+
 	MapRenderer_1DUsedCount = MapRenderer_UsedAtlases();
 	ResetPartFlags();
+	InvalidateFarTerrain();
 }
 
+/* Rebuilding every chunk is expensive, so multiple block definition changes (e.g. from texture */
+/*  pack and block definitions packets arriving in the same frame) are coalesced into one refresh */
+static void OnBlockDefinitionChanged(void* obj) { blockDefsChanged = true; }
+
 static void OnVisibilityChanged(void* obj) {
-	lastCamPos = Vec3_BigPos();
+	InvalidateVisibility();
 	CalcViewDists();
 }
-static void DeleteChunks_(void* obj) { DeleteChunks(); }
+static void OnContextLost(void* obj) {
+	DeleteChunks();
+	DeleteFarTiles();
+	DeleteQueries();
+#ifndef CC_BUILD_GL11
+	DeletePool();
+#endif
+}
 static void Refresh_(void* obj)      { MapRenderer_Refresh(); }
 
 static void OnNewMap(void) {
@@ -767,9 +2434,11 @@ static void OnNewMap(void) {
 	DeleteChunks();
 	ResetPartCounts();
 
-	chunkPos = IVec3_MaxValue();
+	InvalidateSortOrder();
+	DeleteQueries();
 	FreeChunks();
 	FreeParts();
+	FreeFarTiles();
 }
 
 static void OnNewMapLoaded(void) {
@@ -784,7 +2453,10 @@ static void OnNewMapLoaded(void) {
 	/*}*/
 
 	InitChunks();
-	lastCamPos = Vec3_BigPos();
+	AllocateFarTiles();
+	InvalidateVisibility();
+	/* Build chunks as fast as possible straight after joining, then back off if frame rate drops */
+	chunksTarget = maxChunkUpdates;
 }
 
 static void OnInit(void) {
@@ -794,19 +2466,38 @@ static void OnInit(void) {
 
 	Event_Register_(&GfxEvents.ViewDistanceChanged, NULL, OnVisibilityChanged);
 	Event_Register_(&GfxEvents.ProjectionChanged,   NULL, OnVisibilityChanged);
-	Event_Register_(&GfxEvents.ContextLost,         NULL, DeleteChunks_);
+	Event_Register_(&GfxEvents.ContextLost,         NULL, OnContextLost);
 	Event_Register_(&GfxEvents.ContextRecreated,    NULL, Refresh_);
 
 	/* This = 87 fixes map being invisible when no textures */
 	MapRenderer_1DUsedCount = 87; /* Atlas1D_UsedAtlasesCount(); */
-	chunkPos   = IVec3_MaxValue();
-	maxChunkUpdates = Options_GetInt(OPT_MAX_CHUNK_UPDATES, 4, 1024, 30);
+	InvalidateSortOrder();
+	maxChunkUpdates = Options_GetInt(OPT_MAX_CHUNK_UPDATES, 4, MAX_CHUNK_UPDATES, 30);
+	uploadBudget    = Options_GetInt(OPT_UPLOAD_BUDGET, 0, 1024 * 1024, 4096) * 1024;
+	MapRenderer_OcclusionCulling = Options_GetBool(OPT_OCCLUSION_CULLING, false);
+	MapRenderer_DetailDistance   = Options_GetInt(OPT_DETAIL_DISTANCE, 0, 4096, 0);
+#ifndef CC_BUILD_GL11
+	MapRenderer_RegionBatching   = Options_GetBool(OPT_REGION_BATCHING,   false);
+	MapRenderer_SortTranslucent  = Options_GetBool(OPT_SORT_TRANSLUCENT,  false);
+	/* Region batching already merges the meshes of chunks into larger vertex buffers */
+	MapRenderer_PooledVertices   = Gfx.SupportsPartialVbUpdates && !MapRenderer_RegionBatching;
+#endif
+	/* Region batching draws whole regions of chunks at once, so skipping individual chunks wouldn't help */
+	MapRenderer_OcclusionQueries = Gfx.SupportsOcclusionQueries && !MapRenderer_RegionBatching &&
+									Options_GetBool(OPT_OCCLUSION_QUERIES, false);
 	CalcViewDists();
 }
 
+static void OnFree(void) {
+	OnNewMap();
+#ifndef CC_BUILD_GL11
+	DeletePool();
+#endif
+}
+
 struct IGameComponent MapRenderer_Component = {
 	OnInit, /* Init */
-	OnNewMap, /* Free */
+	OnFree, /* Free */
 	OnNewMap, /* Reset */
 	OnNewMap, /* OnNewMap */
 	OnNewMapLoaded /* OnNewMapLoaded */
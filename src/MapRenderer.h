@@ -14,6 +14,29 @@ extern struct IGameComponent MapRenderer_Component;
 
 /* Max used 1D atlases. (i.e. Atlas1D_Index(maxTextureLoc) + 1) */
 extern int MapRenderer_1DUsedCount;
+/* Whether chunks which cannot be seen through caves/openings from the camera's chunk are skipped. */
+/* NOTE: Only conservative - chunks are only culled when fully hidden by opaque blocks. */
+extern cc_bool MapRenderer_OcclusionCulling;
+/* Whether the bounding boxes of chunks in view are tested against the depth buffer using GPU occlusion queries, */
+/*  so that chunks hidden behind other geometry for several frames in a row are skipped. */
+/* NOTE: Only used when supported by the graphics backend, and region batching and split screen are not used. */
+extern cc_bool MapRenderer_OcclusionQueries;
+/* Whether the meshes of neighbouring chunks are merged into one vertex buffer per region, */
+/*  so that the non-translucent parts of all the chunks in a region can be drawn with one draw call per face. */
+/* NOTE: Uses more memory, as a copy of each chunk's vertices is kept to rebuild region vertex buffers with. */
+extern cc_bool MapRenderer_RegionBatching;
+/* Whether the translucent quads of each chunk are sorted from back to front, and chunks drawn from back to front, */
+/*  instead of first filling the depth buffer with a separate depth only pass over all translucent chunks. */
+/* NOTE: Nearby chunks are rebuilt to resort them whenever the camera moves into a different chunk. */
+extern cc_bool MapRenderer_SortTranslucent;
+/* Max distance from camera that chunks are built with full detail, or 0 to build all chunks within view distance. */
+/* Past this distance, low detail far terrain meshes (built from the top block of each column) are drawn instead. */
+extern int MapRenderer_DetailDistance;
+#ifndef CC_BUILD_GL11
+/* Whether chunk meshes are stored in a few large vertex buffers shared between chunks, instead of one per chunk. */
+/* NOTE: Only used when supported by the graphics backend, and region batching is disabled. */
+extern cc_bool MapRenderer_PooledVertices;
+#endif
 
 /* Buffer for all chunk parts. There are (MapRenderer_ChunksCount * Atlas1D_Count) parts in the buffer,
 with parts for 'normal' buffer being in lower half. */
@@ -50,12 +73,19 @@ struct ChunkInfo {
 	cc_uint8 drawYMin : 1;
 	cc_uint8 drawYMax : 1;
 	cc_uint8 : 0;          /* pad to next byte */
-#ifdef OCCLUSION
-	public cc_bool Visited = false, Occluded = false;
-	public byte OcclusionFlags, OccludedFlags, DistanceFlags;
-#endif
+	/* Bitmask of the faces that can be reached through the chunk from each face */
+	/* (e.g. connects[FACE_XMIN] & (1 << FACE_YMAX) when air/glass links left and top sides) */
+	cc_uint8 connects[FACE_COUNT];
+	/* Bitmask of the faces the chunk was entered through by the last occlusion pass */
+	/* (OCCLUSION_START if the camera is inside the chunk, 0 if the chunk was not reached) */
+	#define OCCLUSION_START 0x80
+	cc_uint8 occlusionEntry;
 #ifndef CC_BUILD_GL11
 	GfxResourceID vb;
+	/* Copy of the chunk's vertices (only used when region batching) */
+	void* vertices;
+	/* Block in the shared vertex buffers holding the chunk's vertices, -1 if the chunk has its own vertex buffer */
+	int poolBlock;
 #endif
 	struct ChunkPartInfo* normalParts;
 	struct ChunkPartInfo* translucentParts;
@@ -73,10 +103,24 @@ void MapRenderer_Update(float delta);
 /* Marks the given chunk as needing to be rebuilt/redrawn. */
 /* NOTE: Coordinates outside the map are simply ignored. */
 void MapRenderer_RefreshChunk(int cx, int cy, int cz);
+/* Whether the given chunk is known to be completely air. (i.e. only contains DRAW_GAS blocks) */
+/* NOTE: Returns false for chunks outside the map, or chunks which haven't been built yet */
+cc_bool MapRenderer_IsChunkAir(int cx, int cy, int cz);
 /* Called when a block is changed, to update internal state. */
 void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block);
+/* Called when many blocks in the region [x1, y1, z1] to [x2, y2, z2] were changed at once. */
+/* NOTE: Each affected chunk is only refreshed once */
+void MapRenderer_OnBlocksChanged(int x1, int y1, int z1, int x2, int y2, int z2);
+/* Whether changing the given block from old to now has no visible effect at all on chunk meshes. */
+/* (e.g. replacing stone with ore deep underground) */
+cc_bool MapRenderer_IsHiddenChange(int x, int y, int z, BlockID old, BlockID now);
 /* Deletes all chunks and resets internal state. */
 void MapRenderer_Refresh(void);
+#ifndef CC_BUILD_GL11
+/* Copies the given vertices of a chunk into the shared vertex buffers, then offsets the chunk's parts to match. */
+/* Returns false when there is no space left, in which case the chunk should use its own vertex buffer instead. */
+cc_bool MapRenderer_PoolVertices(struct ChunkInfo* info, void* vertices, int count);
+#endif
 
 CC_END_HEADER
 #endif
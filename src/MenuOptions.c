@@ -767,6 +767,13 @@ static void    GrO_SetMipmaps(cc_bool v) {
 	TexturePack_ExtractCurrent(true);
 }
 
+static cc_bool GrO_GetCompression(void) { return Gfx.CompressTextures; }
+static void    GrO_SetCompression(cc_bool v) {
+	Gfx.CompressTextures = v;
+	Options_SetBool(OPT_COMPRESS_TEXTURES, v);
+	TexturePack_ExtractCurrent(true);
+}
+
 static void GraphicsOptionsScreen_InitWidgets(struct MenuOptionsScreen* s) {
 	MenuOptionsScreen_BeginButtons(s);
 	{
@@ -809,6 +816,12 @@ static void GraphicsOptionsScreen_InitWidgets(struct MenuOptionsScreen* s) {
 		MenuOptionsScreen_AddBool(s, "Mipmaps",
 			GrO_GetMipmaps,    GrO_SetMipmaps, NULL);
 		}
+		if (Gfx.SupportsCompression) {
+		MenuOptionsScreen_AddBool(s, "Compress textures",
+			GrO_GetCompression, GrO_SetCompression,
+			"&eCompresses terrain textures, so that they use 4 times less video memory.\n" \
+			"&cNote: &eThis slightly reduces the quality of terrain textures.");
+		}
 
 		MenuOptionsScreen_AddBool(s, "3D anaglyph",
 			ClO_GetAnaglyph,   ClO_SetAnaglyph, NULL);
@@ -238,6 +238,7 @@ static struct ListScreen {
 	const char* actionText;
 	void (*LoadEntries)(struct ListScreen* s);
 	void (*UpdateEntry)(struct ListScreen* s, struct ButtonWidget* btn, const cc_string* text);
+	void (*Update)(struct ListScreen* s); /* Called every frame (can be NULL) */
 	const char* titleText;
 	struct TextWidget title;
 	struct StringsBuffer entries;
@@ -400,6 +401,11 @@ static void ListScreen_Init(void* screen) {
 	s->LoadEntries(s);
 }
 
+static void ListScreen_Update(void* screen, float delta) {
+	struct ListScreen* s = (struct ListScreen*)screen;
+	if (s->Update) s->Update(s);
+}
+
 static void ListScreen_Render(void* screen, float delta) {
 	Menu_RenderBounds();
 	Screen_Render2Widgets(screen, delta);
@@ -437,7 +443,7 @@ static void ListScreen_Reload(struct ListScreen* s) {
 }
 
 static const struct ScreenVTABLE ListScreen_VTABLE = {
-	ListScreen_Init,    Screen_NullUpdate, ListScreen_Free,  
+	ListScreen_Init,    ListScreen_Update, ListScreen_Free,  
 	ListScreen_Render,  Screen_BuildMesh,
 	ListScreen_KeyDown, Screen_InputUp,    Screen_TKeyPress, Screen_TText,
 	Menu_PointerDown,   Screen_PointerUp,  Menu_PointerMove, Screen_TMouseScroll,
@@ -1330,24 +1336,20 @@ static void SaveLevelScreen_RemoveOverwrites(struct SaveLevelScreen* s) {
 	}
 }
 
-static cc_result DoSaveMap(const cc_string* path, struct GZipState* state) {
-	static const cc_string schematic = String_FromConst(".schematic");
-	static const cc_string mine      = String_FromConst(".mine");
-	struct Stream stream, compStream;
+static cc_result DoSaveMap(const cc_string* path, struct GZipState* state, cc_uint8* buffer) {
+	struct Stream file, stream, compStream;
 	cc_result res;
 
-	res = Stream_CreateFile(&stream, path);
+	res = Stream_CreateFile(&file, path);
 	if (res) { Logger_SysWarn2(res, "creating", path); return res; }
-	GZip_MakeStream(&compStream, state, &stream);
 
-	if (String_CaselessEnds(path, &schematic)) {
-		res = Schematic_Save(&compStream);
-	} else if (String_CaselessEnds(path, &mine)) {
-		res = Dat_Save(&compStream);
-	} else {
-		res = Cw_Save(&compStream);
-	}
+	/* Closing the buffered stream also flushes and closes the file */
+	Stream_WriteonlyBuffered(&stream, &file, buffer, STREAM_FILE_BUFFER_SIZE);
+	GZip_MakeStream(&compStream, state, &stream);
+	Deflate_SetLevel(&state->Base, Options_GetInt(OPT_MAP_COMPRESSION,
+						DEFLATE_LEVEL_FAST, DEFLATE_LEVEL_BEST, DEFLATE_LEVEL_DEFAULT));
 
+	res = Map_FindExporter(path)(&compStream);
 	if (res) {
 		stream.Close(&stream);
 		Logger_SysWarn2(res, "encoding", path); return res;
@@ -1367,11 +1369,12 @@ static cc_result SaveLevelScreen_SaveMap(const cc_string* path) {
 	struct GZipState* state;
 	cc_result res;
 
-	state = Mem_TryAlloc(1, sizeof(struct GZipState));
+	/* File write buffer is allocated directly after the compression state */
+	state = Mem_TryAlloc(1, sizeof(struct GZipState) + STREAM_FILE_BUFFER_SIZE);
 	res   = ERR_OUT_OF_MEMORY;
 	if (!state) { Logger_SysWarn(res, "allocating temp memory"); return res; }
 
-	res = DoSaveMap(path, state);
+	res = DoSaveMap(path, state, (cc_uint8*)(state + 1));
 	Mem_Free(state);
 	if (res) return res;
 
@@ -1405,8 +1408,9 @@ static void SaveLevelScreen_Save(void* screen, void* widget) {
 	}
 		
 	SaveLevelScreen_RemoveOverwrites(s);
-	if ((res = SaveLevelScreen_SaveMap(&path))) return;
-	Chat_Add1("&eSaved map to: %s", &path);
+	/* Actual writing to disc happens in the background, and reports its result in chat */
+	if ((res = Map_SaveAsync(&path))) return;
+	Gui_ShowPauseMenu();
 }
 
 static void SaveLevelScreen_UploadCallback(const cc_string* path) {
@@ -1621,6 +1625,7 @@ void TexturePackScreen_Show(void) {
 	s->EntryClick  = TexturePackScreen_EntryClick;
 	s->DoneClick   = Menu_SwitchPause;
 	s->UpdateEntry = ListScreen_UpdateEntry;
+	s->Update      = NULL;
 	ListScreen_Show();
 }
 
@@ -1697,6 +1702,7 @@ void FontListScreen_Show(void) {
 	s->EntryClick  = FontListScreen_EntryClick;
 	s->DoneClick   = Menu_SwitchGui;
 	s->UpdateEntry = FontListScreen_UpdateEntry;
+	s->Update      = NULL;
 	ListScreen_Show();
 }
 
@@ -1773,6 +1779,7 @@ void HotkeyListScreen_Show(void) {
 	s->EntryClick  = HotkeyListScreen_EntryClick;
 	s->DoneClick   = Menu_SwitchPause;
 	s->UpdateEntry = HotkeyListScreen_UpdateEntry;
+	s->Update      = NULL;
 	ListScreen_Show();
 }
 
@@ -1812,6 +1819,120 @@ static void LoadLevelScreen_LoadEntries(struct ListScreen* s) {
 	static const cc_string path = String_FromConst("maps");
 	Directory_Enum(&path, &s->entries, LoadLevelScreen_FilterFiles);
 	StringsBuffer_Sort(&s->entries);
+	MapIndex_Start(&s->entries);
+}
+
+static int loadLevel_version;
+static cc_bool loadLevel_hasColors;
+static BitmapCol loadLevel_colors[256];
+
+/* Calculates the average color of the top face texture of each block */
+static void LoadLevelScreen_CalcColors(void) {
+	struct Bitmap* bmp = &Atlas2D.Bmp;
+	int size = Atlas2D.TileSize;
+	int b, x, y, baseX, baseY, count;
+	int r, g, bl;
+	BitmapCol* row;
+	BitmapCol col;
+	TextureLoc loc;
+	loadLevel_hasColors = true;
+
+	for (b = 0; b < Array_Elems(loadLevel_colors); b++) 
+	{
+		loadLevel_colors[b] = 0;
+		loc   = Block_Tex(b, FACE_YMAX);
+		baseX = Atlas2D_TileX(loc) * size;
+		baseY = Atlas2D_TileY(loc) * size;
+		if (!bmp->scan0 || baseX + size > bmp->width || baseY + size > bmp->height) continue;
+
+		r = 0; g = 0; bl = 0; count = 0;
+		for (y = 0; y < size; y++) 
+		{
+			row = Bitmap_GetRow(bmp, baseY + y) + baseX;
+			for (x = 0; x < size; x++) 
+			{
+				col = row[x];
+				if (!BitmapCol_A(col)) continue;
+
+				r += BitmapCol_R(col); g += BitmapCol_G(col); bl += BitmapCol_B(col);
+				count++;
+			}
+		}
+		if (count) loadLevel_colors[b] = BitmapColor_RGB(r / count, g / count, bl / count);
+	}
+}
+
+static void LoadLevelScreen_DrawThumb(struct Context2D* ctx, const struct MapInfo* info, int size) {
+	int maxDim = max(info->thumbWidth, info->thumbLength);
+	int width  = size * info->thumbWidth  / maxDim;
+	int height = size * info->thumbLength / maxDim;
+	int offsetX = (size - width) / 2, offsetY = (size - height) / 2;
+	int x, z, x1, x2, y1, y2, i, shade;
+	BitmapCol col;
+
+	Context2D_Clear(ctx, BitmapCol_Make(0, 0, 0, 160), offsetX, offsetY, width, height);
+	for (z = 0; z < info->thumbLength; z++) 
+	{
+		y1 = offsetY + z       * height / info->thumbLength;
+		y2 = offsetY + (z + 1) * height / info->thumbLength;
+
+		for (x = 0; x < info->thumbWidth; x++) 
+		{
+			x1 = offsetX + x       * width / info->thumbWidth;
+			x2 = offsetX + (x + 1) * width / info->thumbWidth;
+			i  = z * MAPINFO_THUMB_SIZE + x;
+
+			col = loadLevel_colors[info->thumbBlocks[i]];
+			if (!col || x1 == x2 || y1 == y2) continue;
+
+			/* Darken lower columns, so that the terrain is easier to make out */
+			shade = 160 + info->thumbHeights[i] * 95 / 255;
+			col   = BitmapColor_RGB(BitmapCol_R(col) * shade / 255, 
+						BitmapCol_G(col) * shade / 255, BitmapCol_B(col) * shade / 255);
+			Context2D_Clear(ctx, col, x1, y1, x2 - x1, y2 - y1);
+		}
+	}
+}
+
+/* Draws the thumbnail and dimensions of the map beside its name, once the map has been indexed */
+static void LoadLevelScreen_UpdateEntry(struct ListScreen* s, struct ButtonWidget* btn, const cc_string* text) {
+	cc_string str; char strBuffer[STRING_SIZE];
+	struct DrawTextArgs args;
+	struct Context2D ctx;
+	struct MapInfo info;
+	int size, offset;
+
+	if (Gfx.LostContext || !MapIndex_Get(text, &info)) {
+		ListScreen_UpdateEntry(s, btn, text); return;
+	}
+	if (!loadLevel_hasColors) LoadLevelScreen_CalcColors();
+
+	String_InitArray(str, strBuffer);
+	String_Format4(&str, "%s &7(%ix%ix%i)", text, &info.width, &info.height, &info.length);
+	DrawTextArgs_Make(&args, &str, &s->font, true);
+
+	size   = Drawer2D_TextHeight(&args);
+	offset = info.thumbWidth ? size + size / 4 : 0;
+	Gfx_DeleteTexture(&btn->tex.ID);
+
+	Context2D_Alloc(&ctx, offset + Drawer2D_TextWidth(&args), size);
+	{
+		if (info.thumbWidth) LoadLevelScreen_DrawThumb(&ctx, &info, size);
+		Context2D_DrawText(&ctx, &args, offset, 0);
+		Context2D_MakeTexture(&btn->tex, &ctx);
+	}
+	Context2D_Free(&ctx);
+	Widget_Layout(btn);
+}
+
+/* Redraws the entries whenever more maps have been indexed in the background */
+static void LoadLevelScreen_Update(struct ListScreen* s) {
+	int version = MapIndex_Version();
+	if (version == loadLevel_version) return;
+
+	loadLevel_version = version;
+	ListScreen_RedrawEntries(s);
+	s->dirty = true;
 }
 
 static void LoadLevelScreen_UploadCallback(const cc_string* path) { Map_LoadFrom(path); }
@@ -1842,7 +1963,12 @@ void LoadLevelScreen_Show(void) {
 	s->LoadEntries = LoadLevelScreen_LoadEntries;
 	s->EntryClick  = LoadLevelScreen_EntryClick;
 	s->DoneClick   = Menu_SwitchPause;
-	s->UpdateEntry = ListScreen_UpdateEntry;
+	s->UpdateEntry = LoadLevelScreen_UpdateEntry;
+	s->Update      = LoadLevelScreen_Update;
+
+	/* Block textures may have changed since the menu was last opened */
+	loadLevel_hasColors = false;
+	loadLevel_version   = MapIndex_Version();
 	ListScreen_Show();
 }
 
@@ -24,6 +24,12 @@ struct _ModelsData Models;
 #define AABB_Height(bb) ((bb)->Max.y - (bb)->Min.y)
 #define AABB_Length(bb) ((bb)->Max.z - (bb)->Min.z)
 
+/* Backends where changing the view matrix between draws only updates shader constants */
+/* On these, humanoid models are drawn from a per-entity cached mesh with a matrix per part */
+#if CC_GFX_BACKEND == CC_GFX_BACKEND_GL2 || CC_GFX_BACKEND == CC_GFX_BACKEND_D3D11
+#define MODEL_CACHED_MESHES
+#endif
+
 
 /*########################################################################################################################*
 *------------------------------------------------------------Model--------------------------------------------------------*
@@ -104,6 +110,12 @@ void Model_GetEntityTransform(struct Model* model, struct Entity* e, struct Matr
 	model->GetTransform(e, pos, transform);
 }
 
+#ifdef MODEL_CACHED_MESHES
+/* View matrix of the entity currently being rendered by Model_Render */
+static struct Matrix model_view;
+static cc_bool model_hasView;
+#endif
+
 void Model_Render(struct Model* model, struct Entity* e) {
 	struct Matrix m, transform;
 	Model_SetupState(model, e);
@@ -113,7 +125,14 @@ void Model_Render(struct Model* model, struct Entity* e) {
 	Matrix_Mul(&m, &transform, &Gfx.View);
 
 	Gfx_LoadMatrix(MATRIX_VIEW, &m);
+#ifdef MODEL_CACHED_MESHES
+	model_view    = m;
+	model_hasView = true;
+	model->Draw(e);
+	model_hasView = false;
+#else
 	model->Draw(e);
+#endif
 	Gfx_LoadMatrix(MATRIX_VIEW, &Gfx.View);
 }
 
@@ -129,8 +148,10 @@ void Model_SetupState(struct Model* model, struct Entity* e) {
 	/* then it is not using the model API properly. */
 	/* So set uScale/vScale to ridiculous defaults to make it obvious */
 	/* TODO: Remove setting this eventually */
-	Models.uScale = 100.0f;
-	Models.vScale = 100.0f;
+	Models.uScale  = 100.0f;
+	Models.vScale  = 100.0f;
+	Models.uOffset = 0.0f;
+	Models.vOffset = 0.0f;
 
 	if (!e->NoShade) {
 		Models.Cols[1] = PackedCol_Scale(col, PACKEDCOL_SHADE_YMIN);
@@ -153,22 +174,30 @@ void Model_ApplyTexture(struct Entity* e) {
 	struct Model* model = Models.Active;
 	struct ModelTex* data;
 	GfxResourceID tex;
-	cc_bool _64x64;
+	float uScale, vScale;
+	cc_bool _64x64, atlased;
+
+	atlased = (e->Flags & ENTITY_FLAG_HAS_MODELVB) && e->_skinSlot;
+	uScale  = e->uScale; vScale = e->vScale;
+	Models.uOffset = 0.0f; Models.vOffset = 0.0f;
 
 	tex = model->usesHumanSkin ? e->TextureId : e->MobTextureId;
 	if (tex) {
 		Models.skinType = e->SkinType;
+		if (atlased) { Models.uOffset = e->uOffset; Models.vOffset = e->vOffset; }
 	} else {
 		data = model->defaultTex;
 		tex  = data->texID;
 		Models.skinType = data->skinType;
+		/* Skin atlas scale only applies to the entity's own skin */
+		if (atlased) { uScale = 1.0f; vScale = 1.0f; }
 	}
 
 	Gfx_BindTexture(tex);
 	_64x64 = Models.skinType != SKIN_64x32;
 
-	Models.uScale = e->uScale * 0.015625f;
-	Models.vScale = e->vScale * (_64x64 ? 0.015625f : 0.03125f);
+	Models.uScale = uScale * 0.015625f;
+	Models.vScale = vScale * (_64x64 ? 0.015625f : 0.03125f);
 }
 
 
@@ -192,6 +221,9 @@ void Model_LockVB(struct Entity* entity, int verticesCount) {
 		entity->ModelVB = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, Models.Active->maxVertices);
 	}
 	modelVB = entity->ModelVB;
+
+	/* Per-entity VB is about to be overwritten, so any cached mesh in it is lost */
+	entity->_meshKey.model = NULL;
 #else
 	if (!Models.Vb) {
 		Models.Vb = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, Models.MaxVertices);
@@ -222,8 +254,8 @@ void Model_DrawPart(struct ModelPart* part) {
 		dst->x = v.x; dst->y = v.y; dst->z = v.z;
 		dst->Col = Models.Cols[i >> 2];
 
-		dst->U = (v.u & UV_POS_MASK) * Models.uScale - (v.u >> UV_MAX_SHIFT) * 0.01f * Models.uScale;
-		dst->V = (v.v & UV_POS_MASK) * Models.vScale - (v.v >> UV_MAX_SHIFT) * 0.01f * Models.vScale;
+		dst->U = (v.u & UV_POS_MASK) * Models.uScale - (v.u >> UV_MAX_SHIFT) * 0.01f * Models.uScale + Models.uOffset;
+		dst->V = (v.v & UV_POS_MASK) * Models.vScale - (v.v >> UV_MAX_SHIFT) * 0.01f * Models.vScale + Models.vOffset;
 		src++; dst++;
 	}
 	model->index += count;
@@ -233,56 +265,100 @@ void Model_DrawPart(struct ModelPart* part) {
 #define Model_RotateY t = cosY * v.x - sinY * v.z; v.z =  sinY * v.x + cosY * v.z; v.x = t;
 #define Model_RotateZ t = cosZ * v.x + sinZ * v.y; v.y = -sinZ * v.x + cosZ * v.y; v.x = t;
 
-void Model_DrawRotate(float angleX, float angleY, float angleZ, struct ModelPart* part, cc_bool head) {
-	struct Model* model        = Models.Active;
-	struct ModelVertex* src    = &model->vertices[part->offset];
-	struct VertexTextured* dst = &Models.Vertices[model->index];
+#define Model_RotateLocal \
+if (Models.Rotation == ROTATE_ORDER_ZYX) {\
+	Model_RotateZ Model_RotateY Model_RotateX \
+} else if (Models.Rotation == ROTATE_ORDER_XZY) {\
+	Model_RotateX Model_RotateZ Model_RotateY \
+} else if (Models.Rotation == ROTATE_ORDER_YZX) {\
+	Model_RotateY Model_RotateZ Model_RotateX \
+} else if (Models.Rotation == ROTATE_ORDER_XYZ) {\
+	Model_RotateX Model_RotateY Model_RotateZ \
+}
 
+/* Calculates the matrix that transforms vertices of a part the same way Model_DrawRotate does */
+static void Model_GetPartMatrix(float angleX, float angleY, float angleZ, struct ModelPart* part, cc_bool head, struct Matrix* m) {
 	float cosX = Math_CosF(-angleX), sinX = Math_SinF(-angleX);
 	float cosY = Math_CosF(-angleY), sinY = Math_SinF(-angleY);
 	float cosZ = Math_CosF(-angleZ), sinZ = Math_SinF(-angleZ);
 	float t, x = part->rotX, y = part->rotY, z = part->rotZ;
-	
-	struct ModelVertex v;
-	int i, count = part->count;
+	struct Vec4* row;
+	Vec3 v;
+	int i;
 
-	for (i = 0; i < count; i++) {
-		v = *src;
-		v.x -= x; v.y -= y; v.z -= z;
-
-		/* Rotate locally */
-		if (Models.Rotation == ROTATE_ORDER_ZYX) {
-			Model_RotateZ
-			Model_RotateY
-			Model_RotateX
-		} else if (Models.Rotation == ROTATE_ORDER_XZY) {
-			Model_RotateX
-			Model_RotateZ
-			Model_RotateY
-		} else if (Models.Rotation == ROTATE_ORDER_YZX) {
-			Model_RotateY
-			Model_RotateZ
-			Model_RotateX
-		} else if (Models.Rotation == ROTATE_ORDER_XYZ) {
-			Model_RotateX
-			Model_RotateY
-			Model_RotateZ
-		}
+	/* Rotation is linear, so just rotate each axis to get the rows */
+	for (i = 0; i < 3; i++) {
+		v.x = i == 0 ? 1.0f : 0.0f;
+		v.y = i == 1 ? 1.0f : 0.0f;
+		v.z = i == 2 ? 1.0f : 0.0f;
+		Model_RotateLocal
 
-		/* Rotate globally (inlined RotY) */
 		if (head) {
 			t = Models.cosHead * v.x - Models.sinHead * v.z; v.z = Models.sinHead * v.x + Models.cosHead * v.z; v.x = t;
 		}
-		dst->x = v.x + x; dst->y = v.y + y; dst->z = v.z + z;
-		dst->Col = Models.Cols[i >> 2];
+		row = i == 0 ? &m->row1 : (i == 1 ? &m->row2 : &m->row3);
+		row->x = v.x; row->y = v.y; row->z = v.z; row->w = 0.0f;
+	}
 
-		dst->U = (v.u & UV_POS_MASK) * Models.uScale - (v.u >> UV_MAX_SHIFT) * 0.01f * Models.uScale;
-		dst->V = (v.v & UV_POS_MASK) * Models.vScale - (v.v >> UV_MAX_SHIFT) * 0.01f * Models.vScale;
-		src++; dst++;
+	/* Parts are rotated around their pivot point */
+	m->row4.x = x - (x * m->row1.x + y * m->row2.x + z * m->row3.x);
+	m->row4.y = y - (x * m->row1.y + y * m->row2.y + z * m->row3.y);
+	m->row4.z = z - (x * m->row1.z + y * m->row2.z + z * m->row3.z);
+	m->row4.w = 1.0f;
+}
+
+void Model_DrawRotate(float angleX, float angleY, float angleZ, struct ModelPart* part, cc_bool head) {
+	struct Model* model        = Models.Active;
+	struct VertexTextured* dst = &Models.Vertices[model->index];
+	struct Matrix m;
+
+	/* Rotating is the same as transforming by the part's matrix, which can be done with SIMD */
+	Model_GetPartMatrix(angleX, angleY, angleZ, part, head, &m);
+	Model_DrawPart(part);
+	Vec3_TransformMany(dst, sizeof(struct VertexTextured), dst, sizeof(struct VertexTextured), part->count, &m);
+}
+
+#ifdef MODEL_CACHED_MESHES
+/* Returns whether the vertices cached in the entity's model VB need to be rebuilt */
+/* If so, locks the VB like Model_LockVB does, otherwise just binds it */
+static cc_bool Model_LockMesh(struct Entity* e, int verticesCount, int extra) {
+	struct ModelMeshKey* key = &e->_meshKey;
+	struct Model* model      = Models.Active;
+
+	if (e->ModelVB && key->model == model && key->col == Models.Cols[0] && key->noShade == e->NoShade &&
+		key->skinType == Models.skinType && key->uScale  == Models.uScale  && key->vScale  == Models.vScale &&
+		key->uOffset  == Models.uOffset  && key->vOffset == Models.vOffset && key->extra   == extra) {
+		Gfx_BindDynamicVb(e->ModelVB);
+		return false;
 	}
-	model->index += count;
+
+	if (!e->ModelVB) {
+		e->ModelVB = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, model->maxVertices);
+	}
+	key->model    = model;
+	key->col      = Models.Cols[0];
+	key->noShade  = e->NoShade;
+	key->skinType = Models.skinType;
+	key->uScale   = Models.uScale;  key->vScale  = Models.vScale;
+	key->uOffset  = Models.uOffset; key->vOffset = Models.vOffset;
+	key->extra    = extra;
+
+	modelVB         = e->ModelVB;
+	real_vertices   = Models.Vertices;
+	Models.Vertices = (struct VertexTextured*)Gfx_LockDynamicVb(modelVB, VERTEX_FORMAT_TEXTURED, verticesCount);
+	return true;
 }
 
+/* Draws vertices of the cached mesh in the currently bound VB, transformed by the given part matrix */
+static void Model_DrawMeshRange(const struct Matrix* local, int verticesCount, int startVertex) {
+	struct Matrix m;
+	Matrix_Mul(&m, local, &model_view);
+
+	Gfx_LoadMatrix(MATRIX_VIEW, &m);
+	Gfx_DrawVb_IndexedTris_Range(verticesCount, startVertex);
+}
+#endif
+
 void Model_RenderArm(struct Model* model, struct Entity* e) {
 	struct Matrix m, translate;
 	Vec3 pos = e->Position;
@@ -661,33 +737,39 @@ static float CustomModel_GetAnimValue(cc_uint8 type, struct CustomModelAnim* ani
 	return 0.0f;
 }
 
-static PackedCol oldCols[FACE_COUNT];
-static void CustomModel_DrawPart(
-	struct CustomModelPart* part,
-	struct CustomModel* cm,
-	struct Entity* e
-) {
-	int i, animIndex;
+/* Current animation state of a custom model part */
+struct CustomPartState {
 	float rotX, rotY, rotZ;
-	cc_bool head = false;
-	cc_bool modifiedVertices = false;
-	cc_uint8 type, axis;
-	float value = 0.0f;
+	/* Per-axis transform applied to the part's vertices before rotating (by translate/size animations) */
+	Vec3 scale, offset;
+	cc_bool head, transformed;
+};
 
-	if (part->fullbright) {
-		for (i = 0; i < FACE_COUNT; i++) 
-		{
-			oldCols[i] = Models.Cols[i];
-			Models.Cols[i] = PACKEDCOL_WHITE;
-		}
+static float* CustomPartState_Axis(Vec3* v, cc_uint8 axis) {
+	switch (axis) {
+		case CustomModelAnimAxis_X: return &v->x;
+		case CustomModelAnimAxis_Y: return &v->y;
+		case CustomModelAnimAxis_Z: return &v->z;
 	}
-	
+	return NULL;
+}
+
+static void CustomModel_GetPartState(struct CustomModelPart* part, struct Entity* e, struct CustomPartState* s) {
+	int animIndex;
+	cc_uint8 type, axis;
+	float value, pivot;
+	float* scale;
+	float* offset;
+
 	/* bbmodels use xyz rotation order */
 	Models.Rotation = ROTATE_ORDER_XYZ;
 	
-	rotX = part->rotation.x * MATH_DEG2RAD;
-	rotY = part->rotation.y * MATH_DEG2RAD;
-	rotZ = part->rotation.z * MATH_DEG2RAD;
+	s->rotX = part->rotation.x * MATH_DEG2RAD;
+	s->rotY = part->rotation.y * MATH_DEG2RAD;
+	s->rotZ = part->rotation.z * MATH_DEG2RAD;
+	Vec3_Set(s->scale,  1,1,1);
+	Vec3_Set(s->offset, 0,0,0);
+	s->head = false; s->transformed = false;
 
 	for (animIndex = 0; animIndex < MAX_CUSTOM_MODEL_ANIMS; animIndex++) 
 	{
@@ -696,26 +778,9 @@ static void CustomModel_DrawPart(
 		axis = part->animAxis[animIndex];
 
 		if (type == CustomModelAnimType_None) continue;
-		value = CustomModel_GetAnimValue(type, anim, e);
-	
-		if (
-			!modifiedVertices &&
-			(type == CustomModelAnimType_SinTranslate ||
-				type == CustomModelAnimType_SinTranslateVelocity ||
-				type == CustomModelAnimType_SinSize ||
-				type == CustomModelAnimType_SinSizeVelocity ||
-				type == CustomModelAnimType_FlipTranslate ||
-				type == CustomModelAnimType_FlipTranslateVelocity ||
-				type == CustomModelAnimType_FlipSize ||
-				type == CustomModelAnimType_FlipSizeVelocity)
-		) {
-			modifiedVertices = true;
-			Mem_Copy(
-				oldVertices,
-				&cm->model.vertices[part->modelPart.offset],
-				sizeof(struct ModelVertex) * MODEL_BOX_VERTICES
-			);
-		}
+		value  = CustomModel_GetAnimValue(type, anim, e);
+		scale  = CustomPartState_Axis(&s->scale,  axis);
+		offset = CustomPartState_Axis(&s->offset, axis);
 		
 		if (
 			type == CustomModelAnimType_SinTranslate ||
@@ -723,87 +788,184 @@ static void CustomModel_DrawPart(
 			type == CustomModelAnimType_FlipTranslate ||
 			type == CustomModelAnimType_FlipTranslateVelocity
 		) {
-			for (i = 0; i < MODEL_BOX_VERTICES; i++) {
-				struct ModelVertex* vertex = &cm->model.vertices[part->modelPart.offset + i];
-				switch (axis) {
-					case CustomModelAnimAxis_X:
-						vertex->x += value;
-						break;
-
-					case CustomModelAnimAxis_Y:
-						vertex->y += value;
-						break;
-
-					case CustomModelAnimAxis_Z:
-						vertex->z += value;
-						break;
-				}
-			}
+			s->transformed = true;
+			if (offset) *offset += value;
 		} else if (
 			type == CustomModelAnimType_SinSize ||
 			type == CustomModelAnimType_SinSizeVelocity ||
 			type == CustomModelAnimType_FlipSize ||
 			type == CustomModelAnimType_FlipSizeVelocity
 		) {
-			for (i = 0; i < MODEL_BOX_VERTICES; i++) {
-				struct ModelVertex* vertex = &cm->model.vertices[part->modelPart.offset + i];
-				switch (axis) {
-					case CustomModelAnimAxis_X:
-						vertex->x = Math_Lerp(part->modelPart.rotX, vertex->x, value);
-						break;
-
-					case CustomModelAnimAxis_Y:
-						vertex->y = Math_Lerp(part->modelPart.rotY, vertex->y, value);
-						break;
-
-					case CustomModelAnimAxis_Z:
-						vertex->z = Math_Lerp(part->modelPart.rotZ, vertex->z, value);
-						break;
-				}
-			}
+			s->transformed = true;
+			if (!offset) continue;
+
+			/* Scales the part's vertices on this axis around the part's pivot */
+			pivot = axis == CustomModelAnimAxis_X ? part->modelPart.rotX :
+					(axis == CustomModelAnimAxis_Y ? part->modelPart.rotY : part->modelPart.rotZ);
+			*scale  *= value;
+			*offset  = Math_Lerp(pivot, *offset, value);
 		} else {
 			if (type == CustomModelAnimType_Head) {
-				head = true;
+				s->head = true;
 			}
 			
 			switch (axis) {
 				case CustomModelAnimAxis_X:
-					rotX += value;
+					s->rotX += value;
 					break;
 
 				case CustomModelAnimAxis_Y:
-					rotY += value;
+					s->rotY += value;
 					break;
 
 				case CustomModelAnimAxis_Z:
-					rotZ += value;
+					s->rotZ += value;
 					break;
 			}
 		}
 	}
+}
+
+#ifdef MODEL_CACHED_MESHES
+static cc_bool CustomModel_IsAnimated(struct CustomModelPart* part) {
+	int animIndex;
+	for (animIndex = 0; animIndex < MAX_CUSTOM_MODEL_ANIMS; animIndex++) 
+	{
+		if (part->animType[animIndex] != CustomModelAnimType_None) return true;
+	}
+	return false;
+}
+#endif
+
+static PackedCol oldCols[FACE_COUNT];
+static void CustomModel_BeginFullbright(struct CustomModelPart* part) {
+	int i;
+	if (!part->fullbright) return;
+
+	for (i = 0; i < FACE_COUNT; i++) 
+	{
+		oldCols[i] = Models.Cols[i];
+		Models.Cols[i] = PACKEDCOL_WHITE;
+	}
+}
+
+static void CustomModel_EndFullbright(struct CustomModelPart* part) {
+	int i;
+	if (!part->fullbright) return;
+
+	for (i = 0; i < FACE_COUNT; i++) 
+	{
+		Models.Cols[i] = oldCols[i];
+	}
+}
+
+static void CustomModel_DrawPart(
+	struct CustomModelPart* part,
+	struct CustomModel* cm,
+	struct Entity* e
+) {
+	struct CustomPartState s;
+	struct ModelVertex* vertex;
+	int i;
+
+	CustomModel_BeginFullbright(part);
+	CustomModel_GetPartState(part, e, &s);
+
+	if (s.transformed) {
+		Mem_Copy(
+			oldVertices,
+			&cm->model.vertices[part->modelPart.offset],
+			sizeof(struct ModelVertex) * MODEL_BOX_VERTICES
+		);
+
+		for (i = 0; i < MODEL_BOX_VERTICES; i++) {
+			vertex = &cm->model.vertices[part->modelPart.offset + i];
+			vertex->x = vertex->x * s.scale.x + s.offset.x;
+			vertex->y = vertex->y * s.scale.y + s.offset.y;
+			vertex->z = vertex->z * s.scale.z + s.offset.z;
+		}
+	}
 
-	if (rotX || rotY || rotZ || head) {
-		Model_DrawRotate(rotX, rotY, rotZ, &part->modelPart, head);
+	if (s.rotX || s.rotY || s.rotZ || s.head) {
+		Model_DrawRotate(s.rotX, s.rotY, s.rotZ, &part->modelPart, s.head);
 	} else {
 		Model_DrawPart(&part->modelPart);
 	}
 
-	if (modifiedVertices) {
+	if (s.transformed) {
 		Mem_Copy(
 			&cm->model.vertices[part->modelPart.offset],
 			oldVertices,
 			sizeof(struct ModelVertex) * MODEL_BOX_VERTICES
 		);
 	}
+	CustomModel_EndFullbright(part);
+}
 
-	if (part->fullbright) {
-		for (i = 0; i < FACE_COUNT; i++) 
-		{
-			Models.Cols[i] = oldCols[i];
+#ifdef MODEL_CACHED_MESHES
+/* Builds the cached mesh for a custom model. Parts without animations are fully baked into it */
+static void CustomModel_BuildMesh(struct CustomModel* cm) {
+	struct CustomModelPart* part;
+	int i;
+
+	for (i = 0; i < cm->numParts; i++) 
+	{
+		part = &cm->parts[i];
+		CustomModel_BeginFullbright(part);
+		Models.Rotation = ROTATE_ORDER_XYZ;
+
+		if (!CustomModel_IsAnimated(part) && (part->rotation.x || part->rotation.y || part->rotation.z)) {
+			Model_DrawRotate(part->rotation.x * MATH_DEG2RAD, part->rotation.y * MATH_DEG2RAD, 
+							part->rotation.z * MATH_DEG2RAD, &part->modelPart, false);
+		} else {
+			Model_DrawPart(&part->modelPart);
 		}
+		CustomModel_EndFullbright(part);
 	}
 }
 
+/* Draws a custom model from the entity's cached mesh */
+/* Consecutive parts without animations are drawn together, other parts get their own transform */
+static void CustomModel_DrawMesh(struct Entity* e, struct CustomModel* cm) {
+	struct CustomModelPart* part;
+	struct CustomPartState s;
+	struct Matrix local, pre;
+	int i, offset = 0, staticStart = 0, staticCount = 0;
+
+	if (Model_LockMesh(e, cm->numParts * MODEL_BOX_VERTICES, 0)) {
+		CustomModel_BuildMesh(cm);
+		Model_UnlockVB();
+	}
+
+	for (i = 0; i < cm->numParts; i++, offset += MODEL_BOX_VERTICES) 
+	{
+		part = &cm->parts[i];
+		if (!CustomModel_IsAnimated(part)) {
+			if (!staticCount) staticStart = offset;
+			staticCount += MODEL_BOX_VERTICES; continue;
+		}
+
+		if (staticCount) {
+			Model_DrawMeshRange(&Matrix_Identity, staticCount, staticStart);
+			staticCount = 0;
+		}
+
+		CustomModel_GetPartState(part, e, &s);
+		Model_GetPartMatrix(s.rotX, s.rotY, s.rotZ, &part->modelPart, s.head, &local);
+
+		if (s.transformed) {
+			Matrix_Scale(&pre, s.scale.x, s.scale.y, s.scale.z);
+			pre.row4.x = s.offset.x; pre.row4.y = s.offset.y; pre.row4.z = s.offset.z;
+			Matrix_Mul(&local, &pre, &local);
+		}
+		Model_DrawMeshRange(&local, MODEL_BOX_VERTICES, offset);
+	}
+
+	if (staticCount) Model_DrawMeshRange(&Matrix_Identity, staticCount, staticStart);
+	Gfx_LoadMatrix(MATRIX_VIEW, &model_view);
+}
+#endif
+
 static void CustomModel_Draw(struct Entity* e) {
 	struct CustomModel* cm = (struct CustomModel*)Models.Active;
 	int i;
@@ -811,6 +973,14 @@ static void CustomModel_Draw(struct Entity* e) {
 	Model_ApplyTexture(e);
 	Models.uScale = e->uScale / cm->uScale;
 	Models.vScale = e->vScale / cm->vScale;
+
+#ifdef MODEL_CACHED_MESHES
+	if (model_hasView && (e->Flags & ENTITY_FLAG_HAS_MODELVB)) {
+		CustomModel_DrawMesh(e, cm);
+		Models.Rotation = ROTATE_ORDER_ZYX;
+		return;
+	}
+#endif
 	Model_LockVB(e, cm->numParts * MODEL_BOX_VERTICES);
 
 	for (i = 0; i < cm->numParts; i++) 
@@ -845,8 +1015,8 @@ static void CustomModel_DrawArm(struct Entity* e) {
 	if (!cm->numArmParts) return;
 	Gfx_SetAlphaTest(true);
 
-	Models.uScale = 1.0f / cm->uScale;
-	Models.vScale = 1.0f / cm->vScale;
+	Models.uScale = e->uScale / cm->uScale;
+	Models.vScale = e->vScale / cm->vScale;
 	Model_LockVB(e, cm->numArmParts * MODEL_BOX_VERTICES);
 
 	for (i = 0; i < cm->numParts; i++) 
@@ -936,6 +1106,64 @@ struct ModelSet {
 #define HUMAN_HAT64_VERTICES (6 * MODEL_BOX_VERTICES)
 #define HUMAN_MAX_VERTICES   HUMAN_BASE_VERTICES + HUMAN_HAT64_VERTICES
 
+#ifdef MODEL_CACHED_MESHES
+#define HUMAN_MAX_PARTS 12
+/* Part of the human model, along with how it is currently rotated */
+struct HumanPart { struct ModelPart* part; float angleX, angleZ; cc_uint8 rotation; cc_bool head; };
+
+static void HumanPart_Set(struct HumanPart* p, struct ModelPart* part, float angleX, float angleZ, 
+						cc_uint8 rotation, cc_bool head) {
+	p->part     = part;
+	p->angleX   = angleX;   p->angleZ = angleZ;
+	p->rotation = rotation; p->head   = head;
+}
+
+/* Draws the human model from the entity's cached mesh, only passing the per-part rotations each frame */
+static void HumanModel_DrawMesh(struct Entity* e, struct ModelSet* model, struct ModelLimbs* set, int num, cc_bool opaqueBody) {
+	struct HumanPart parts[HUMAN_MAX_PARTS];
+	struct HumanPart* p;
+	struct Matrix local;
+	int i, count = 0, offset = 0;
+
+	HumanPart_Set(&parts[count++], &model->head, -e->Pitch * MATH_DEG2RAD, 0, ROTATE_ORDER_ZYX, true);
+	HumanPart_Set(&parts[count++], &model->torso, 0, 0, ROTATE_ORDER_ZYX, false);
+	HumanPart_Set(&parts[count++], &set->leftLeg,  e->Anim.LeftLegX,  e->Anim.LeftLegZ,  ROTATE_ORDER_ZYX, false);
+	HumanPart_Set(&parts[count++], &set->rightLeg, e->Anim.RightLegX, e->Anim.RightLegZ, ROTATE_ORDER_ZYX, false);
+	HumanPart_Set(&parts[count++], &set->leftArm,  e->Anim.LeftArmX,  e->Anim.LeftArmZ,  ROTATE_ORDER_XZY, false);
+	HumanPart_Set(&parts[count++], &set->rightArm, e->Anim.RightArmX, e->Anim.RightArmZ, ROTATE_ORDER_XZY, false);
+
+	if (Models.skinType != SKIN_64x32) {
+		HumanPart_Set(&parts[count++], &model->torsoLayer, 0, 0, ROTATE_ORDER_ZYX, false);
+		HumanPart_Set(&parts[count++], &set->leftLegLayer,  e->Anim.LeftLegX,  e->Anim.LeftLegZ,  ROTATE_ORDER_ZYX, false);
+		HumanPart_Set(&parts[count++], &set->rightLegLayer, e->Anim.RightLegX, e->Anim.RightLegZ, ROTATE_ORDER_ZYX, false);
+		HumanPart_Set(&parts[count++], &set->leftArmLayer,  e->Anim.LeftArmX,  e->Anim.LeftArmZ,  ROTATE_ORDER_XZY, false);
+		HumanPart_Set(&parts[count++], &set->rightArmLayer, e->Anim.RightArmX, e->Anim.RightArmZ, ROTATE_ORDER_XZY, false);
+	}
+	HumanPart_Set(&parts[count++], &model->hat, -e->Pitch * MATH_DEG2RAD, 0, ROTATE_ORDER_ZYX, true);
+
+	/* Vertices only need rebuilding when colour or skin changes */
+	if (Model_LockMesh(e, num, 0)) {
+		for (i = 0; i < count; i++) { Model_DrawPart(parts[i].part); }
+		Model_UnlockVB();
+	}
+
+	/* human model draws the body opaque so players can't have invisible skins */
+	if (opaqueBody) Gfx_SetAlphaTest(false);
+	for (i = 0; i < count; i++) {
+		p = &parts[i];
+		if (opaqueBody && offset == HUMAN_BASE_VERTICES) Gfx_SetAlphaTest(true);
+
+		Models.Rotation = p->rotation;
+		Model_GetPartMatrix(p->angleX, 0, p->angleZ, p->part, p->head, &local);
+		Model_DrawMeshRange(&local, p->part->count, offset);
+		offset += p->part->count;
+	}
+
+	Models.Rotation = ROTATE_ORDER_ZYX;
+	Gfx_LoadMatrix(MATRIX_VIEW, &model_view);
+}
+#endif
+
 static void HumanModel_DrawCore(struct Entity* e, struct ModelSet* model, cc_bool opaqueBody) {
 	struct ModelLimbs* set;
 	int type, num;
@@ -944,6 +1172,12 @@ static void HumanModel_DrawCore(struct Entity* e, struct ModelSet* model, cc_boo
 	type = Models.skinType;
 	set  = &model->limbs[type & 0x3];
 	num  = HUMAN_BASE_VERTICES + (type == SKIN_64x32 ? HUMAN_HAT32_VERTICES : HUMAN_HAT64_VERTICES);
+
+#ifdef MODEL_CACHED_MESHES
+	if (model_hasView && (e->Flags & ENTITY_FLAG_HAS_MODELVB)) {
+		HumanModel_DrawMesh(e, model, set, num, opaqueBody); return;
+	}
+#endif
 	Model_LockVB(e, num);
 
 	Model_DrawRotate(-e->Pitch * MATH_DEG2RAD, 0, 0, &model->head, true);
@@ -2048,6 +2282,10 @@ static void ZombieModel_Register(void) {
 static BlockID bModel_block = BLOCK_AIR;
 static int bModel_index, bModel_texIndices[8];
 static struct VertexTextured* bModel_vertices;
+#ifdef MODEL_CACHED_MESHES
+/* Incremented whenever block textures or definitions change, invalidating cached block meshes */
+static int bModel_version;
+#endif
 
 static float BlockModel_GetNameY(struct Entity* e) {
 	BlockID block = e->ModelBlock;
@@ -2150,14 +2388,11 @@ static void BlockModel_SpriteXQuad(cc_bool firstPart, cc_bool mirror) {
 	bModel_vertices = ptr;
 }
 
-static void BlockModel_BuildParts(struct Entity* e, cc_bool sprite) {
-	struct VertexTextured* ptr;
+static void BlockModel_BuildParts(cc_bool sprite) {
+	struct VertexTextured* ptr = Models.Vertices;
 	Vec3 min, max;
 	TextureLoc loc;
 
-	Model_LockVB(e, sprite ? BLOCKMODEL_SPRITE_COUNT : BLOCKMODEL_CUBE_COUNT);
-	ptr = Models.Vertices;
-
 	if (sprite) {
 		bModel_vertices = ptr;
 
@@ -2189,8 +2424,6 @@ static void BlockModel_BuildParts(struct Entity* e, cc_bool sprite) {
 		loc = BlockModel_GetTex(FACE_XMIN); Drawer_XMin(1, Models.Cols[4], loc, &ptr);
 		loc = BlockModel_GetTex(FACE_YMAX); Drawer_YMax(1, Models.Cols[0], loc, &ptr);
 	}
-
-	Model_UnlockVB();
 }
 
 static void BlockModel_DrawParts(void) {
@@ -2216,6 +2449,35 @@ static void BlockModel_DrawParts(void) {
 	Gfx_DrawVb_IndexedTris_Range(count, offset);
 }
 
+#ifdef MODEL_CACHED_MESHES
+/* Faces that BlockModel_BuildParts looks up textures for, in the order it does so */
+static const cc_uint8 bModel_spriteFaces[8] = { 
+	FACE_XMAX, FACE_XMAX, FACE_ZMAX, FACE_ZMAX, FACE_ZMAX, FACE_ZMAX, FACE_XMAX, FACE_XMAX 
+};
+static const cc_uint8 bModel_cubeFaces[6] = {
+	FACE_YMIN, FACE_ZMIN, FACE_XMAX, FACE_ZMAX, FACE_XMIN, FACE_YMAX
+};
+
+/* Draws a block model from the entity's cached mesh, which is only rebuilt when the block or colour changes */
+static void BlockModel_DrawMesh(struct Entity* e, cc_bool sprite) {
+	int i, count = sprite ? BLOCKMODEL_SPRITE_COUNT : BLOCKMODEL_CUBE_COUNT;
+	int extra    = bModel_block | ((bModel_version & 0x7FFF) << 16);
+
+	if (Model_LockMesh(e, count, extra)) {
+		BlockModel_BuildParts(sprite);
+		Model_UnlockVB(); return;
+	}
+
+	if (sprite) {
+		for (i = 0; i < 8; i++) BlockModel_GetTex(bModel_spriteFaces[i]);
+	} else {
+		for (i = 0; i < 6; i++) BlockModel_GetTex(bModel_cubeFaces[i]);
+	}
+}
+
+static void BlockModel_Invalidate(void* obj) { bModel_version++; }
+#endif
+
 static void BlockModel_Draw(struct Entity* e) {
 	cc_bool sprite;
 	int i;
@@ -2232,7 +2494,19 @@ static void BlockModel_Draw(struct Entity* e) {
 	}
 
 	sprite = Blocks.Draw[bModel_block] == DRAW_SPRITE;
-	BlockModel_BuildParts(e, sprite);
+#ifdef MODEL_CACHED_MESHES
+	if (model_hasView && (e->Flags & ENTITY_FLAG_HAS_MODELVB)) {
+		BlockModel_DrawMesh(e, sprite);
+	} else {
+		Model_LockVB(e, sprite ? BLOCKMODEL_SPRITE_COUNT : BLOCKMODEL_CUBE_COUNT);
+		BlockModel_BuildParts(sprite);
+		Model_UnlockVB();
+	}
+#else
+	Model_LockVB(e, sprite ? BLOCKMODEL_SPRITE_COUNT : BLOCKMODEL_CUBE_COUNT);
+	BlockModel_BuildParts(sprite);
+	Model_UnlockVB();
+#endif
 
 	if (sprite) Gfx_SetFaceCulling(true);
 	BlockModel_DrawParts();
@@ -2435,6 +2709,10 @@ static void OnInit(void) {
 
 	Event_Register_(&TextureEvents.FileChanged, NULL, Models_TextureChanged);
 	Event_Register_(&GfxEvents.ContextLost,     NULL, OnContextLost);
+#ifdef MODEL_CACHED_MESHES
+	Event_Register_(&TextureEvents.AtlasChanged,  NULL, BlockModel_Invalidate);
+	Event_Register_(&BlockEvents.BlockDefChanged, NULL, BlockModel_Invalidate);
+#endif
 }
 
 static void OnFree(void) {
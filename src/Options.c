@@ -16,9 +16,87 @@ static cc_bool savingPaused;
 	#define OPTIONS_SAVE_IMMEDIATELY
 #endif
 
+/*########################################################################################################################*
+*-------------------------------------------------------Options index-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Open addressing hash table mapping each option's key to its entry in Options */
+/* Each slot stores entry index + 1, with 0 meaning the slot is empty */
+static int* optsIndex;
+static int optsIndexMask;
+static cc_bool optsIndexDirty = true;
+
+static cc_uint32 OptionsIndex_Hash(const cc_string* key) {
+	cc_uint32 hash = 2166136261U;
+	int i;
+	char c;
+
+	for (i = 0; i < key->length; i++) 
+	{
+		c = key->buffer[i];
+		Char_MakeLower(c);
+		hash = (hash ^ (cc_uint8)c) * 16777619U;
+	}
+	return hash;
+}
+
+static void OptionsIndex_Insert(const cc_string* key, int entry) {
+	cc_uint32 slot = OptionsIndex_Hash(key) & optsIndexMask;
+	while (optsIndex[slot]) slot = (slot + 1) & optsIndexMask;
+	optsIndex[slot] = entry + 1;
+}
+
+static void OptionsIndex_Rebuild(void) {
+	cc_string entry, key, value;
+	int i, size = 64;
+	while (size < Options.count * 2) size *= 2;
+
+	if (size != optsIndexMask + 1) {
+		Mem_Free(optsIndex);
+		optsIndex     = (int*)Mem_Alloc(size, sizeof(int), "options index");
+		optsIndexMask = size - 1;
+	}
+	Mem_Set(optsIndex, 0, size * sizeof(int));
+
+	for (i = 0; i < Options.count; i++) 
+	{
+		StringsBuffer_UNSAFE_GetRaw(&Options, i, &entry);
+		String_UNSAFE_Separate(&entry, '=', &key, &value);
+		OptionsIndex_Insert(&key, i);
+	}
+	optsIndexDirty = false;
+}
+
+/* Returns index of the entry in Options with the given key, or -1 if no such entry */
+static int OptionsIndex_Find(const cc_string* key, cc_string* value) {
+	cc_string entry, curKey;
+	cc_uint32 slot;
+	int i;
+	if (optsIndexDirty) OptionsIndex_Rebuild();
+
+	for (slot = OptionsIndex_Hash(key) & optsIndexMask; optsIndex[slot]; slot = (slot + 1) & optsIndexMask) 
+	{
+		i = optsIndex[slot] - 1;
+		StringsBuffer_UNSAFE_GetRaw(&Options, i, &entry);
+		String_UNSAFE_Separate(&entry, '=', &curKey, value);
+
+		if (String_CaselessEquals(key, &curKey)) return i;
+	}
+	*value = String_Empty;
+	return -1;
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------------Options--------------------------------------------------------*
+*#########################################################################################################################*/
 void Options_Free(void) {
 	StringsBuffer_Clear(&Options);
 	StringsBuffer_Clear(&changedOpts);
+
+	Mem_Free(optsIndex);
+	optsIndex      = NULL;
+	optsIndexMask  = 0;
+	optsIndexDirty = true;
 }
 
 static cc_bool HasChanged(const cc_string* key) {
@@ -43,6 +121,7 @@ void Options_Load(void) {
 	StringsBuffer_SetLengthBits(&Options, 11);
 	Options_LoadResult = EntryList_Load(&Options, "options-default.txt", '=', NULL);
 	Options_LoadResult = EntryList_Load(&Options, "options.txt",         '=', NULL);
+	optsIndexDirty     = true;
 }
 
 void Options_Reload(void) {
@@ -59,6 +138,7 @@ void Options_Reload(void) {
 	}
 	/* Load only options which have not changed */
 	Options_LoadResult = EntryList_Load(&Options, "options.txt", '=', Options_LoadFilter);
+	optsIndexDirty     = true;
 }
 
 static void SaveOptions(void) {
@@ -87,7 +167,7 @@ cc_bool Options_UNSAFE_Get(const char* keyRaw, cc_string* value) {
 	int idx;
 	cc_string key = String_FromReadonly(keyRaw);
 
-	*value = EntryList_UNSAFE_Get(&Options, &key, '=');
+	OptionsIndex_Find(&key, value);
 	if (value->length) return true; 
 
 	/* Fallback to without '-' (e.g. "hacks-fly" to "fly") */
@@ -96,7 +176,7 @@ cc_bool Options_UNSAFE_Get(const char* keyRaw, cc_string* value) {
 	if (idx == -1) return false;
 	key = String_UNSAFE_SubstringAt(&key, idx + 1);
 
-	*value = EntryList_UNSAFE_Get(&Options, &key, '=');
+	OptionsIndex_Find(&key, value);
 	return value->length > 0;
 }
 
@@ -179,10 +259,26 @@ void Options_Set(const char* keyRaw, const cc_string* value) {
 }
 
 void Options_SetString(const cc_string* key, const cc_string* value) {
+	cc_string cur;
+	int i = OptionsIndex_Find(key, &cur);
+
 	if (!value || !value->length) {
-		if (!EntryList_Remove(&Options, key, '=')) return;
+		if (i == -1) return;
+		EntryList_Remove(&Options, key, '=');
+		optsIndexDirty = true;
+	} else if (i == -1) {
+		EntryList_Set(&Options, key, value, '=');
+		/* New entry is always added at the end */
+		if (Options.count * 2 <= optsIndexMask + 1) {
+			OptionsIndex_Insert(key, Options.count - 1);
+		} else {
+			optsIndexDirty = true;
+		}
 	} else {
+		/* Avoid saving options again when nothing has actually changed */
+		if (String_Equals(&cur, value)) return;
 		EntryList_Set(&Options, key, value, '=');
+		optsIndexDirty = true;
 	}
 
 #if defined OPTIONS_SAVE_IMMEDIATELY
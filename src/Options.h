@@ -20,13 +20,23 @@ Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 #define OPT_INVERT_MOUSE "invertmouse"
 #define OPT_SENSITIVITY "mousesensitivity"
 #define OPT_FPS_LIMIT "fpslimit"
+#define OPT_LOW_LATENCY "gfx-lowlatency"
+#define OPT_NET_RECORD_REPLAY "net-recordreplay"
 #define OPT_DEFAULT_TEX_PACK "defaulttexpack"
 #define OPT_VIEW_BOBBING "viewbobbing"
 #define OPT_ENTITY_SHADOW "entityshadow"
 #define OPT_RENDER_TYPE "normal"
 #define OPT_SMOOTH_LIGHTING "gfx-smoothlighting"
+#define OPT_GREEDY_MESHING "gfx-greedymeshing"
+#define OPT_OCCLUSION_CULLING "gfx-occlusionculling"
+#define OPT_OCCLUSION_QUERIES "gfx-occlusionqueries"
+#define OPT_REGION_BATCHING "gfx-regionbatching"
+#define OPT_SORT_TRANSLUCENT "gfx-sorttranslucent"
+#define OPT_DETAIL_DISTANCE "gfx-detaildistance"
+#define OPT_VRAM_BUDGET "gfx-vrambudget"
 #define OPT_LIGHTING_MODE "gfx-lightingmode"
 #define OPT_MIPMAPS "gfx-mipmaps"
+#define OPT_COMPRESS_TEXTURES "gfx-compresstextures"
 #define OPT_CHAT_LOGGING "chat-logging"
 #define OPT_WINDOW_WIDTH "window-width"
 #define OPT_WINDOW_HEIGHT "window-height"
@@ -71,6 +81,11 @@ Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 #define OPT_CLASSIC_CHAT "nostalgia-classicchat"
 #define OPT_CLASSIC_INVENTORY "nostalgia-classicinventory"
 #define OPT_MAX_CHUNK_UPDATES "gfx-maxchunkupdates"
+#define OPT_UPLOAD_BUDGET "gfx-uploadbudget"
+#define OPT_BUILDER_THREADS "gfx-builderthreads"
+#define OPT_JOB_THREADS "job-threads"
+#define OPT_DYNAMIC_RES "gfx-dynamicres"
+#define OPT_DYNAMIC_RES_FPS "gfx-dynamicres-fps"
 #define OPT_CAMERA_MASS "cameramass"
 #define OPT_CAMERA_SMOOTH "camera-smooth"
 #define OPT_GRAB_CURSOR "win-grab-cursor"
@@ -85,6 +100,18 @@ Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 #define OPT_GAME_VERSION "game-version"
 #define OPT_INV_SCROLLBAR_SCALE "inv-scrollbar-scale"
 #define OPT_ANAGLYPH3D "anaglyph-3d"
+#define OPT_MAP_COMPRESSION "map-compression"
+#define OPT_AUTOSAVE_INTERVAL "autosave-interval"
+#define OPT_AUTOSAVE_JOURNAL "autosave-journal"
+#define OPT_MAP_CACHE "map-cache"
+#define OPT_SHADER_CACHE "gl-shader-cache"
+#define OPT_TEXTURE_CACHE_SIZE "texture-cache-size"
+#define OPT_MAX_PARTICLES "max-particles"
+#define OPT_TERMINAL_MAX_FPS "win-terminal-maxfps"
+#define OPT_LOG_LEVEL_GENERAL  "log-level-general"
+#define OPT_LOG_LEVEL_NETWORK  "log-level-network"
+#define OPT_LOG_LEVEL_AUDIO    "log-level-audio"
+#define OPT_LOG_LEVEL_GRAPHICS "log-level-graphics"
 
 #define OPT_SELECTED_BLOCK_OUTLINE_COLOR "selected-block-outline-color"
 #define OPT_SELECTED_BLOCK_OUTLINE_OPACITY "selected-block-outline-opacity"
@@ -10,11 +10,19 @@
 #include "Game.h"
 #include "Event.h"
 
-#ifdef CC_BUILD_TINYMEM
-	#define PARTICLES_MAX 10
+#include "Options.h"
+#include "Platform.h"
+
+#if defined CC_BUILD_TINYMEM
+	#define PARTICLES_DEF_MAX 10
+#elif defined CC_BUILD_LOWMEM
+	#define PARTICLES_DEF_MAX 600
 #else
-	#define PARTICLES_MAX 600
+	#define PARTICLES_DEF_MAX 4096
 #endif
+#define PARTICLES_MAX_LIMIT 65536
+/* Maximum number of particles written to the dynamic VB per draw call */
+#define PARTICLES_BATCH_MAX 2048
 
 
 /*########################################################################################################################*
@@ -23,7 +31,197 @@
 static GfxResourceID particles_TexId, particles_VB;
 static RNGState rnd;
 static cc_bool hitTerrain;
+/* Maximum number of particles of each type */
+static int particles_capacity;
+/* Number of particles that fit in particles_VB */
+static int particles_batchMax;
 typedef cc_bool (*CanPassThroughFunc)(BlockID b);
+/* Prepares for colliding the given particle with the world */
+/* Returns whether the particle is removed when it hits terrain */
+typedef cc_bool (*ParticlePrepareFunc)(int i);
+typedef void (*ParticleRemoveFunc)(int i);
+
+/* Particles of one type, stored as a structure of arrays so that the physics */
+/*  integration step runs over contiguous float arrays (vectorises well) */
+struct ParticleList {
+	float* x; float* y; float* z;             /* Position at end of current tick */
+	float* lastX; float* lastY; float* lastZ; /* Position at start of current tick */
+	float* velX; float* velY; float* velZ;
+	float* gravity;
+	float* lifetime;
+	float* size;
+	int count;
+	/* Vertices (4 per particle) simulated by the GPU, NULL when particles are drawn from the CPU */
+	struct VertexParticle* gpuVerts;
+	cc_uint8* gpuResting; /* Whether the GPU vertices of each particle are stationary */
+	cc_uint8* gpuDirty;   /* Whether the GPU vertices of each block of particles need uploading */
+	GfxResourceID gpuVb;
+};
+#define PARTICLE_LIST_FLOATS 12
+
+static void ParticleList_Alloc(struct ParticleList* l) {
+	int n = particles_capacity;
+	float* mem = (float*)Mem_Alloc(n * PARTICLE_LIST_FLOATS, sizeof(float), "particles");
+
+	l->x     = mem + n * 0;  l->y     = mem + n * 1;  l->z     = mem + n * 2;
+	l->lastX = mem + n * 3;  l->lastY = mem + n * 4;  l->lastZ = mem + n * 5;
+	l->velX  = mem + n * 6;  l->velY  = mem + n * 7;  l->velZ  = mem + n * 8;
+	l->gravity = mem + n * 9; l->lifetime = mem + n * 10; l->size = mem + n * 11;
+	l->count   = 0;
+}
+
+static void ParticleList_Free(struct ParticleList* l) {
+	Mem_Free(l->x);
+	l->x     = NULL;
+	l->count = 0;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------GPU particles-----------------------------------------------------*
+*#########################################################################################################################*/
+/* When the backend supports VERTEX_FORMAT_PARTICLE, rain and custom particles are positioned by the vertex shader */
+/*  from their spawn state. The CPU still ticks them for collision and removal, but only has to upload vertices */
+/*  again when a particle is spawned, removed, or stops/starts moving after hitting terrain */
+#define PARTICLE_GPU_BLOCK_SHIFT 6
+#define PARTICLE_GPU_BLOCK_SIZE (1 << PARTICLE_GPU_BLOCK_SHIFT)
+/* Maximum number of particles that can be drawn with the default index buffer */
+#define PARTICLE_GPU_DRAW_MAX (GFX_MAX_VERTICES / 4)
+/* Time of the most recent particles tick */
+static float particles_time;
+static float particles_tickDelta = (float)GAME_DEF_TICKS;
+
+static void ParticleList_AllocGpu(struct ParticleList* l) {
+	int n = particles_capacity;
+	l->gpuVerts   = (struct VertexParticle*)Mem_Alloc(n * 4, sizeof(struct VertexParticle), "GPU particles");
+	l->gpuResting = (cc_uint8*)Mem_AllocCleared(n, 1, "GPU particle states");
+	l->gpuDirty   = (cc_uint8*)Mem_AllocCleared((n >> PARTICLE_GPU_BLOCK_SHIFT) + 1, 1, "GPU particle blocks");
+}
+
+static void ParticleList_FreeGpu(struct ParticleList* l) {
+	Gfx_DeleteDynamicVb(&l->gpuVb);
+	if (!l->gpuVerts) return;
+
+	Mem_Free(l->gpuVerts);   l->gpuVerts   = NULL;
+	Mem_Free(l->gpuResting); l->gpuResting = NULL;
+	Mem_Free(l->gpuDirty);   l->gpuDirty   = NULL;
+}
+
+#define ParticleList_MarkDirty(l, i) (l)->gpuDirty[(i) >> PARTICLE_GPU_BLOCK_SHIFT] = true
+
+/* Restarts GPU simulation of the given particle from its current state */
+static void ParticleList_SyncGpu(struct ParticleList* l, int i, cc_bool resting) {
+	struct VertexParticle* v = &l->gpuVerts[i * 4];
+	float gravity = resting ? 0.0f : l->gravity[i];
+	float velX    = resting ? 0.0f : l->velX[i];
+	float velZ    = resting ? 0.0f : l->velZ[i];
+	/* Ticking applies gravity before moving, the shader integrates it continuously instead */
+	float velY    = resting ? 0.0f : l->velY[i] - 0.5f * gravity * particles_tickDelta;
+	float centreY = l->y[i] + v[1].offsetY;
+	int k;
+
+	for (k = 0; k < 4; k++, v++)
+	{
+		v->x    = l->x[i]; v->y    = centreY; v->z    = l->z[i];
+		v->velX = velX;    v->velY = velY;    v->velZ = velZ;
+		v->gravity   = gravity;
+		v->spawnTime = particles_time;
+	}
+	l->gpuResting[i] = resting;
+	ParticleList_MarkDirty(l, i);
+}
+
+static void ParticleList_InitGpu(struct ParticleList* l, int i, const TextureRec* rec, PackedCol col, 
+								float size, float frameRate, float frameU) {
+	struct VertexParticle* v = &l->gpuVerts[i * 4];
+	float s = size * 0.5f;
+	int k;
+
+	v[0].offsetX = -s; v[0].offsetY = -s; v[0].U = rec->u1; v[0].V = rec->v2;
+	v[1].offsetX = -s; v[1].offsetY =  s; v[1].U = rec->u1; v[1].V = rec->v1;
+	v[2].offsetX =  s; v[2].offsetY =  s; v[2].U = rec->u2; v[2].V = rec->v1;
+	v[3].offsetX =  s; v[3].offsetY = -s; v[3].U = rec->u2; v[3].V = rec->v2;
+
+	for (k = 0; k < 4; k++)
+	{
+		v[k].Col       = col;
+		v[k].frameRate = frameRate;
+		v[k].frameU    = frameU;
+	}
+	ParticleList_SyncGpu(l, i, false);
+}
+
+static void ParticleList_RenderGpu(struct ParticleList* l, float t) {
+	int i, j, beg, end, count, blocks;
+
+	if (!l->gpuVb) {
+		l->gpuVb = Gfx_CreateDynamicVb(VERTEX_FORMAT_PARTICLE, particles_capacity * 4);
+		if (!l->gpuVb) return;
+		Mem_Set(l->gpuDirty, true, (particles_capacity >> PARTICLE_GPU_BLOCK_SHIFT) + 1);
+	}
+
+	/* Upload each run of consecutive changed blocks */
+	blocks = (l->count + PARTICLE_GPU_BLOCK_SIZE - 1) >> PARTICLE_GPU_BLOCK_SHIFT;
+	for (i = 0; i < blocks; i = j) 
+	{
+		if (!l->gpuDirty[i]) { j = i + 1; continue; }
+		for (j = i; j < blocks && l->gpuDirty[j]; j++) { l->gpuDirty[j] = false; }
+
+		beg = i << PARTICLE_GPU_BLOCK_SHIFT;
+		end = min(j << PARTICLE_GPU_BLOCK_SHIFT, l->count);
+		Gfx_UpdateDynamicVbPart(l->gpuVb, VERTEX_FORMAT_PARTICLE, beg * 4, (end - beg) * 4, &l->gpuVerts[beg * 4]);
+	}
+
+	Gfx_SetVertexFormat(VERTEX_FORMAT_PARTICLE);
+	/* Particles are drawn interpolated between previous tick and most recent tick */
+	Gfx_SetParticleTime(particles_time + (t - 1.0f) * particles_tickDelta);
+	Gfx_BindDynamicVb(l->gpuVb);
+
+	for (i = 0; i < l->count; i += count) 
+	{
+		count = min(l->count - i, PARTICLE_GPU_DRAW_MAX);
+		Gfx_DrawVb_IndexedTris_Range(count * 4, i * 4);
+	}
+	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+}
+
+/* Returns index of a new particle, evicting one if the list is full */
+static int ParticleList_Add(struct ParticleList* l, ParticleRemoveFunc removeAt) {
+	if (l->count == particles_capacity) removeAt(0);
+	return l->count++;
+}
+
+static void ParticleList_Init(struct ParticleList* l, int i, float x, float y, float z, float lifetime, float size) {
+	l->x[i] = x; l->y[i] = y; l->z[i] = z;
+	l->lastX[i] = x; l->lastY[i] = y; l->lastZ[i] = z;
+	l->lifetime[i] = lifetime;
+	l->size[i]     = size;
+}
+
+/* Removes a particle by moving the last particle into its slot */
+/* NOTE: This does not preserve ordering of particles */
+static void ParticleList_RemoveAt(struct ParticleList* l, int i) {
+	int j = --l->count;
+	if (i == j) return;
+
+	l->x[i] = l->x[j]; l->y[i] = l->y[j]; l->z[i] = l->z[j];
+	l->lastX[i] = l->lastX[j]; l->lastY[i] = l->lastY[j]; l->lastZ[i] = l->lastZ[j];
+	l->velX[i]  = l->velX[j];  l->velY[i]  = l->velY[j];  l->velZ[i]  = l->velZ[j];
+	l->gravity[i]  = l->gravity[j];
+	l->lifetime[i] = l->lifetime[j];
+	l->size[i]     = l->size[j];
+	if (!l->gpuVerts) return;
+
+	Mem_Copy(&l->gpuVerts[i * 4], &l->gpuVerts[j * 4], 4 * sizeof(struct VertexParticle));
+	l->gpuResting[i] = l->gpuResting[j];
+	ParticleList_MarkDirty(l, i);
+}
+
+static void ParticleList_GetPos(struct ParticleList* l, int i, float t, Vec3* pos) {
+	pos->x = l->lastX[i] + (l->x[i] - l->lastX[i]) * t;
+	pos->y = l->lastY[i] + (l->y[i] - l->lastY[i]) * t;
+	pos->z = l->lastZ[i] + (l->z[i] - l->lastZ[i]) * t;
+}
 
 void Particle_DoRender(const Vec2* size, const Vec3* pos, const TextureRec* rec, PackedCol col, struct VertexTextured* v) {
 	struct Matrix* view;
@@ -44,12 +242,10 @@ void Particle_DoRender(const Vec2* size, const Vec3* pos, const TextureRec* rec,
 	v->x = centre.x + aX - bX; v->y = centre.y + aY - bY; v->z = centre.z + aZ - bZ; v->Col = col; v->U = rec->u2; v->V = rec->v2; v++;
 }
 
-static cc_bool CollidesHor(Vec3* nextPos, BlockID block) {
-	Vec3 horPos = Vec3_Create3((float)Math_Floor(nextPos->x), 0.0f, (float)Math_Floor(nextPos->z));
-	Vec3 min, max;
-	Vec3_Add(&min, &Blocks.MinBB[block], &horPos);
-	Vec3_Add(&max, &Blocks.MaxBB[block], &horPos);
-	return nextPos->x >= min.x && nextPos->z >= min.z && nextPos->x < max.x && nextPos->z < max.z;
+static cc_bool CollidesHor(float x, float z, BlockID block) {
+	float minX = Math_Floor(x) + Blocks.MinBB[block].x, maxX = Math_Floor(x) + Blocks.MaxBB[block].x;
+	float minZ = Math_Floor(z) + Blocks.MinBB[block].z, maxZ = Math_Floor(z) + Blocks.MaxBB[block].z;
+	return x >= minX && z >= minZ && x < maxX && z < maxZ;
 }
 
 static BlockID GetBlock(int x, int y, int z) {
@@ -60,79 +256,121 @@ static BlockID GetBlock(int x, int y, int z) {
 	return Env.SidesBlock;
 }
 
-static cc_bool ClipY(struct Particle* p, int y, cc_bool topFace, CanPassThroughFunc canPassThrough) {
+static cc_bool ClipY(struct ParticleList* l, int i, int y, cc_bool topFace, CanPassThroughFunc canPassThrough) {
 	BlockID block;
 	Vec3 minBB, maxBB;
 	float collideY;
 	cc_bool collideVer;
 
 	if (y < 0) {
-		p->nextPos.y = ENTITY_ADJUSTMENT; 
-		p->lastPos.y = ENTITY_ADJUSTMENT;
+		l->y[i]     = ENTITY_ADJUSTMENT; 
+		l->lastY[i] = ENTITY_ADJUSTMENT;
 
-		Vec3_Set(p->velocity, 0,0,0);
+		l->velX[i] = 0; l->velY[i] = 0; l->velZ[i] = 0;
 		hitTerrain = true;
 		return false;
 	}
 
-	block = GetBlock((int)p->nextPos.x, y, (int)p->nextPos.z);
+	block = GetBlock((int)l->x[i], y, (int)l->z[i]);
 	if (canPassThrough(block)) return true;
 	minBB = Blocks.MinBB[block]; maxBB = Blocks.MaxBB[block];
 
 	collideY   = y + (topFace ? maxBB.y : minBB.y);
-	collideVer = topFace ? (p->nextPos.y < collideY) : (p->nextPos.y > collideY);
+	collideVer = topFace ? (l->y[i] < collideY) : (l->y[i] > collideY);
 
-	if (collideVer && CollidesHor(&p->nextPos, block)) {
+	if (collideVer && CollidesHor(l->x[i], l->z[i], block)) {
 		float adjust = topFace ? ENTITY_ADJUSTMENT : -ENTITY_ADJUSTMENT;
-		p->lastPos.y = collideY + adjust;
-		p->nextPos.y = p->lastPos.y;
+		l->lastY[i] = collideY + adjust;
+		l->y[i]     = l->lastY[i];
 
-		Vec3_Set(p->velocity, 0,0,0);
+		l->velX[i] = 0; l->velY[i] = 0; l->velZ[i] = 0;
 		hitTerrain = true;
 		return false;
 	}
 	return true;
 }
 
-static cc_bool IntersectsBlock(struct Particle* p, CanPassThroughFunc canPassThrough) {
-	BlockID cur = GetBlock((int)p->nextPos.x, (int)p->nextPos.y, (int)p->nextPos.z);
-	float minY  = Math_Floor(p->nextPos.y) + Blocks.MinBB[cur].y;
-	float maxY  = Math_Floor(p->nextPos.y) + Blocks.MaxBB[cur].y;
+static cc_bool IntersectsBlock(float x, float y, float z, BlockID cur, CanPassThroughFunc canPassThrough) {
+	float minY = Math_Floor(y) + Blocks.MinBB[cur].y;
+	float maxY = Math_Floor(y) + Blocks.MaxBB[cur].y;
 
-	return !canPassThrough(cur) && p->nextPos.y >= minY && p->nextPos.y < maxY && CollidesHor(&p->nextPos, cur);
+	return !canPassThrough(cur) && y >= minY && y < maxY && CollidesHor(x, z, cur);
 }
 
-static cc_bool PhysicsTick(struct Particle* p, float gravity, CanPassThroughFunc canPassThrough, float delta) {
-	Vec3 velocity;
-	int y, begY, endY;
+/* Moves all particles in the list forward by one tick, ignoring collisions */
+static void ParticleList_Integrate(struct ParticleList* l, float delta) {
+	float* x     = l->x;     float* y     = l->y;     float* z     = l->z;
+	float* lastX = l->lastX; float* lastY = l->lastY; float* lastZ = l->lastZ;
+	float* velX  = l->velX;  float* velY  = l->velY;  float* velZ  = l->velZ;
+	float* gravity  = l->gravity;
+	float* lifetime = l->lifetime;
+	float scale = delta * 3.0f;
+	int i, count = l->count;
+
+	for (i = 0; i < count; i++) {
+		lastX[i] = x[i]; lastY[i] = y[i]; lastZ[i] = z[i];
+	}
+	for (i = 0; i < count; i++) {
+		velY[i] -= gravity[i] * delta;
+		x[i] += velX[i] * scale;
+		y[i] += velY[i] * scale;
+		z[i] += velZ[i] * scale;
+		lifetime[i] -= delta;
+	}
+}
 
-	p->lastPos = p->nextPos;
-	if (IntersectsBlock(p, canPassThrough)) return true;
+static void ParticleList_Tick(struct ParticleList* l, float delta, CanPassThroughFunc canPassThrough,
+							ParticlePrepareFunc prepare, ParticleRemoveFunc removeAt) {
+	cc_bool killOnHit, sameCell;
+	int i, y, begY, endY;
+	BlockID cur;
+	ParticleList_Integrate(l, delta);
 
-	p->velocity.y -= gravity * delta;
-	begY = Math_Floor(p->nextPos.y);
-	
-	Vec3_Mul1(&velocity, &p->velocity, delta * 3.0f);
-	Vec3_Add(&p->nextPos, &p->nextPos, &velocity);
-	endY = Math_Floor(p->nextPos.y);
-
-	if (p->velocity.y > 0.0f) {
-		/* don't test block we are already in */
-		for (y = begY + 1; y <= endY && ClipY(p, y, false, canPassThrough); y++) {}
-	} else {
-		for (y = begY; y >= endY && ClipY(p, y, true, canPassThrough); y--) {}
+	/* Iterate backwards, since removing moves the last particle into the removed slot */
+	for (i = l->count - 1; i >= 0; i--)
+	{
+		killOnHit = prepare(i);
+		cur = GetBlock((int)l->lastX[i], (int)l->lastY[i], (int)l->lastZ[i]);
+		if (IntersectsBlock(l->lastX[i], l->lastY[i], l->lastZ[i], cur, canPassThrough)) {
+			removeAt(i); continue;
+		}
+
+		hitTerrain = false;
+		begY = Math_Floor(l->lastY[i]);
+		endY = Math_Floor(l->y[i]);
+
+		if (l->velY[i] > 0.0f) {
+			/* don't test block we are already in */
+			for (y = begY + 1; y <= endY && ClipY(l, i, y, false, canPassThrough); y++) {}
+		} else {
+			/* Most particles stay within the same cell of a passable block, skip clipping those */
+			sameCell = begY >= 0 && begY == endY 
+				&& (int)l->x[i] == (int)l->lastX[i] && (int)l->z[i] == (int)l->lastZ[i];
+
+			if (!sameCell || !canPassThrough(cur)) {
+				for (y = begY; y >= endY && ClipY(l, i, y, true, canPassThrough); y--) {}
+			}
+		}
+
+		if (l->lifetime[i] < 0.0f || (hitTerrain && killOnHit)) { removeAt(i); continue; }
+
+		/* GPU simulated particles only need updating when they stop or start moving */
+		if (l->gpuVerts && hitTerrain != l->gpuResting[i]) ParticleList_SyncGpu(l, i, hitTerrain);
 	}
+}
 
-	p->lifetime -= delta;
-	return p->lifetime < 0.0f;
+/* Draws particles in batches that fit into particles_VB */
+#define ParticleList_BeginBatch(count) (struct VertexTextured*)Gfx_LockDynamicVb(particles_VB, VERTEX_FORMAT_TEXTURED, (count) * 4)
+static void ParticleList_EndBatch(int count) {
+	Gfx_UnlockDynamicVb(particles_VB);
+	Gfx_DrawVb_IndexedTris(count * 4);
 }
 
 
 /*########################################################################################################################*
 *-------------------------------------------------------Rain particle-----------------------------------------------------*
 *#########################################################################################################################*/
-static struct Particle rain_Particles[PARTICLES_MAX];
-static int rain_count;
+static struct ParticleList rain;
 static TextureRec rain_rec = { 2.0f/128.0f, 14.0f/128.0f, 5.0f/128.0f, 16.0f/128.0f };
 
 static cc_bool RainParticle_CanPass(BlockID block) {
@@ -140,19 +378,16 @@ static cc_bool RainParticle_CanPass(BlockID block) {
 	return draw == DRAW_GAS || draw == DRAW_SPRITE;
 }
 
-static cc_bool RainParticle_Tick(struct Particle* p, float delta) {
-	hitTerrain = false;
-	return PhysicsTick(p, 3.5f, RainParticle_CanPass, delta) || hitTerrain;
-}
+static cc_bool RainParticle_Prepare(int i) { return true; }
 
-static void RainParticle_Render(struct Particle* p, float t, struct VertexTextured* vertices) {
+static void RainParticle_Render(int i, float t, struct VertexTextured* vertices) {
 	Vec3 pos;
 	Vec2 size;
 	PackedCol col;
 	int x, y, z;
 
-	Vec3_Lerp(&pos, &p->lastPos, &p->nextPos, t);
-	size.x = p->size * 0.015625f; size.y = size.x;
+	ParticleList_GetPos(&rain, i, t, &pos);
+	size.x = rain.size[i] * 0.015625f; size.y = size.x;
 
 	x = Math_Floor(pos.x); y = Math_Floor(pos.y); z = Math_Floor(pos.z);
 	col = Lighting.Color(x, y, z);
@@ -161,58 +396,51 @@ static void RainParticle_Render(struct Particle* p, float t, struct VertexTextur
 
 static void Rain_Render(float t) {
 	struct VertexTextured* data;
-	int i;
-	if (!rain_count) return;
-	
-	data = (struct VertexTextured*)Gfx_LockDynamicVb(particles_VB, 
-										VERTEX_FORMAT_TEXTURED, rain_count * 4);
-	for (i = 0; i < rain_count; i++) {
-		RainParticle_Render(&rain_Particles[i], t, data);
-		data += 4;
-	}
-
+	int i, j, count;
+	if (!rain.count) return;
 	Gfx_BindTexture(particles_TexId);
-	Gfx_UnlockDynamicVb(particles_VB);
-	Gfx_DrawVb_IndexedTris(rain_count * 4);
-}
+	if (rain.gpuVerts) { ParticleList_RenderGpu(&rain, t); return; }
+	
+	for (i = 0; i < rain.count; i += count) 
+	{
+		count = min(rain.count - i, particles_batchMax);
+		data  = ParticleList_BeginBatch(count);
 
-static void Rain_RemoveAt(int i) {
-	for (; i < rain_count - 1; i++) {
-		rain_Particles[i] = rain_Particles[i + 1];
+		for (j = 0; j < count; j++, data += 4) {
+			RainParticle_Render(i + j, t, data);
+		}
+		ParticleList_EndBatch(count);
 	}
-	rain_count--;
 }
 
+static void Rain_RemoveAt(int i) { ParticleList_RemoveAt(&rain, i); }
+
 static void Rain_Tick(float delta) {
-	int i;
-	for (i = 0; i < rain_count; i++) {
-		if (RainParticle_Tick(&rain_Particles[i], delta)) {
-			Rain_RemoveAt(i); i--;
-		}
-	}
+	ParticleList_Tick(&rain, delta, RainParticle_CanPass, RainParticle_Prepare, Rain_RemoveAt);
 }
 
 void Particles_RainSnowEffect(float x, float y, float z) {
-	struct Particle* p;
-	int i, type;
+	PackedCol col;
+	int i, j, type;
 
 	for (i = 0; i < 2; i++) {
-		if (rain_count == PARTICLES_MAX) Rain_RemoveAt(0);
-		p = &rain_Particles[rain_count++];
-
-		p->velocity.x = Random_Float(&rnd) * 0.8f - 0.4f; /* [-0.4, 0.4] */
-		p->velocity.z = Random_Float(&rnd) * 0.8f - 0.4f;
-		p->velocity.y = Random_Float(&rnd) + 0.4f;
-
-		p->lastPos.x = x + Random_Float(&rnd); /* [0.0, 1.0] */
-		p->lastPos.y = y + Random_Float(&rnd) * 0.1f + 0.01f;
-		p->lastPos.z = z + Random_Float(&rnd);
+		j = ParticleList_Add(&rain, Rain_RemoveAt);
 
-		p->nextPos  = p->lastPos;
-		p->lifetime = 40.0f;
+		rain.velX[j] = Random_Float(&rnd) * 0.8f - 0.4f; /* [-0.4, 0.4] */
+		rain.velZ[j] = Random_Float(&rnd) * 0.8f - 0.4f;
+		rain.velY[j] = Random_Float(&rnd) + 0.4f;
+		rain.gravity[j] = 3.5f;
 
 		type = Random_Next(&rnd, 30);
-		p->size = type >= 28 ? 2 : (type >= 25 ? 4 : 3);
+		ParticleList_Init(&rain, j,
+			x + Random_Float(&rnd), /* [0.0, 1.0] */
+			y + Random_Float(&rnd) * 0.1f + 0.01f,
+			z + Random_Float(&rnd),
+			40.0f, type >= 28 ? 2 : (type >= 25 ? 4 : 3));
+
+		if (!rain.gpuVerts) continue;
+		col = Lighting.Color(Math_Floor(rain.x[j]), Math_Floor(rain.y[j]), Math_Floor(rain.z[j]));
+		ParticleList_InitGpu(&rain, j, &rain_rec, col, rain.size[j] * 0.015625f, 0.0f, 0.0f);
 	}
 }
 
@@ -220,112 +448,105 @@ void Particles_RainSnowEffect(float x, float y, float z) {
 /*########################################################################################################################*
 *------------------------------------------------------Terrain particle---------------------------------------------------*
 *#########################################################################################################################*/
-struct TerrainParticle {
-	struct Particle base;
-	TextureRec rec;
-	TextureLoc texLoc;
-	BlockID block;
-};
-
-static struct TerrainParticle terrain_particles[PARTICLES_MAX];
-static int terrain_count;
-static cc_uint16 terrain_1DCount[ATLAS1D_MAX_ATLASES];
-static cc_uint16 terrain_1DIndices[ATLAS1D_MAX_ATLASES];
+static struct ParticleList terrain;
+static TextureRec* terrain_recs;
+static TextureLoc* terrain_locs;
+static BlockID*    terrain_blocks;
+static int terrain_1DCount[ATLAS1D_MAX_ATLASES];
 
 static cc_bool TerrainParticle_CanPass(BlockID block) {
 	cc_uint8 draw = Blocks.Draw[block];
 	return draw == DRAW_GAS || draw == DRAW_SPRITE || Blocks.IsLiquid[block];
 }
 
-static cc_bool TerrainParticle_Tick(struct TerrainParticle* p, float delta) {
-	return PhysicsTick(&p->base, Blocks.ParticleGravity[p->block], TerrainParticle_CanPass, delta);
-}
+static cc_bool TerrainParticle_Prepare(int i) { return false; }
 
-static void TerrainParticle_Render(struct TerrainParticle* p, float t, struct VertexTextured* vertices) {
+static void TerrainParticle_Render(int i, float t, struct VertexTextured* vertices) {
 	PackedCol col = PACKEDCOL_WHITE;
+	BlockID block = terrain_blocks[i];
 	Vec3 pos;
 	Vec2 size;
 	int x, y, z;
 
-	Vec3_Lerp(&pos, &p->base.lastPos, &p->base.nextPos, t);
-	size.x = p->base.size * 0.015625f; size.y = size.x;
+	ParticleList_GetPos(&terrain, i, t, &pos);
+	size.x = terrain.size[i] * 0.015625f; size.y = size.x;
 	
-	if (!Blocks.Brightness[p->block]) {
+	if (!Blocks.Brightness[block]) {
 		x = Math_Floor(pos.x); y = Math_Floor(pos.y); z = Math_Floor(pos.z);
 		col = Lighting.Color_XSide(x, y, z);
 	}
 
-	Block_Tint(col, p->block);
-	Particle_DoRender(&size, &pos, &p->rec, col, vertices);
+	Block_Tint(col, block);
+	Particle_DoRender(&size, &pos, &terrain_recs[i], col, vertices);
 }
 
 static void Terrain_Update1DCounts(void) {
-	int i, index;
+	int i;
 
 	for (i = 0; i < ATLAS1D_MAX_ATLASES; i++) {
-		terrain_1DCount[i]   = 0;
-		terrain_1DIndices[i] = 0;
-	}
-	for (i = 0; i < terrain_count; i++) {
-		index = Atlas1D_Index(terrain_particles[i].texLoc);
-		terrain_1DCount[index] += 4;
+		terrain_1DCount[i] = 0;
 	}
-	for (i = 1; i < Atlas1D.Count; i++) {
-		terrain_1DIndices[i] = terrain_1DIndices[i - 1] + terrain_1DCount[i - 1];
+	for (i = 0; i < terrain.count; i++) {
+		terrain_1DCount[Atlas1D_Index(terrain_locs[i])]++;
 	}
 }
 
 static void Terrain_Render(float t) {
 	struct VertexTextured* data;
-	struct VertexTextured* ptr;
-	int offset = 0;
-	int i, index;
-	if (!terrain_count) return;
+	int atlas, remaining, count;
+	int i, j;
+	if (!terrain.count) return;
 
-	data = (struct VertexTextured*)Gfx_LockDynamicVb(particles_VB, 
-										VERTEX_FORMAT_TEXTURED, terrain_count * 4);
 	Terrain_Update1DCounts();
-	for (i = 0; i < terrain_count; i++) 
+	for (atlas = 0; atlas < Atlas1D.Count; atlas++) 
 	{
-		index = Atlas1D_Index(terrain_particles[i].texLoc);
-		ptr   = data + terrain_1DIndices[index];
+		remaining = terrain_1DCount[atlas];
+		if (!remaining) continue;
+		Atlas1D_Bind(atlas);
 
-		TerrainParticle_Render(&terrain_particles[i], t, ptr);
-		terrain_1DIndices[index] += 4;
-	}
+		for (i = 0; remaining; remaining -= count) 
+		{
+			count = min(remaining, particles_batchMax);
+			data  = ParticleList_BeginBatch(count);
 
-	Gfx_UnlockDynamicVb(particles_VB);
-	for (i = 0; i < Atlas1D.Count; i++) 
-	{
-		int partCount = terrain_1DCount[i];
-		if (!partCount) continue;
+			for (j = 0; j < count; i++) {
+				if (Atlas1D_Index(terrain_locs[i]) != atlas) continue;
 
-		Atlas1D_Bind(i);
-		Gfx_DrawVb_IndexedTris_Range(partCount, offset);
-		offset += partCount;
+				TerrainParticle_Render(i, t, data);
+				data += 4; j++;
+			}
+			ParticleList_EndBatch(count);
+		}
 	}
 }
 
 static void Terrain_RemoveAt(int i) {
-	for (; i < terrain_count - 1; i++) 
-	{
-		terrain_particles[i] = terrain_particles[i + 1];
-	}
-	terrain_count--;
+	int j = terrain.count - 1;
+	terrain_recs[i]   = terrain_recs[j];
+	terrain_locs[i]   = terrain_locs[j];
+	terrain_blocks[i] = terrain_blocks[j];
+	ParticleList_RemoveAt(&terrain, i);
 }
 
 static void Terrain_Tick(float delta) {
-	int i;
-	for (i = 0; i < terrain_count; i++) 
-	{
-		if (TerrainParticle_Tick(&terrain_particles[i], delta)) {
-			Terrain_RemoveAt(i); i--;
-		}
-	}
+	ParticleList_Tick(&terrain, delta, TerrainParticle_CanPass, TerrainParticle_Prepare, Terrain_RemoveAt);
+}
+
+static void Terrain_Alloc(void) {
+	ParticleList_Alloc(&terrain);
+	terrain_recs   = (TextureRec*)Mem_Alloc(particles_capacity, sizeof(TextureRec), "terrain particle recs");
+	terrain_locs   = (TextureLoc*)Mem_Alloc(particles_capacity, sizeof(TextureLoc), "terrain particle locs");
+	terrain_blocks = (BlockID*)Mem_Alloc(particles_capacity,    sizeof(BlockID),    "terrain particle blocks");
+}
+
+static void Terrain_Free(void) {
+	ParticleList_Free(&terrain);
+	Mem_Free(terrain_recs);   terrain_recs   = NULL;
+	Mem_Free(terrain_locs);   terrain_locs   = NULL;
+	Mem_Free(terrain_blocks); terrain_blocks = NULL;
 }
 
 void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
-	struct TerrainParticle* p;
 	TextureLoc loc;
 	int texIndex;
 	TextureRec baseRec, rec;
@@ -340,7 +561,7 @@ void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
 	/* per-particle variables */
 	float cellX, cellY, cellZ;
 	Vec3 cell;
-	int x, y, z, type;
+	int x, y, z, type, i;
 
 	if (now != BLOCK_AIR || Blocks.Draw[old] == DRAW_GAS) return;
 	IVec3_ToVec3(&origin, &coords);
@@ -375,13 +596,13 @@ void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
 				if (cell.x < minBB.x || cell.x > maxBB.x || cell.y < minBB.y
 					|| cell.y > maxBB.y || cell.z < minBB.z || cell.z > maxBB.z) continue;
 
-				if (terrain_count == PARTICLES_MAX) Terrain_RemoveAt(0);
-				p = &terrain_particles[terrain_count++];
+				i = ParticleList_Add(&terrain, Terrain_RemoveAt);
 
 				/* centre random offset around [-0.2, 0.2] */
-				p->base.velocity.x = CELL_CENTRE + (cellX - 0.5f) + (Random_Float(&rnd) * 0.4f - 0.2f);
-				p->base.velocity.y = CELL_CENTRE + (cellY - 0.0f) + (Random_Float(&rnd) * 0.4f - 0.2f);
-				p->base.velocity.z = CELL_CENTRE + (cellZ - 0.5f) + (Random_Float(&rnd) * 0.4f - 0.2f);
+				terrain.velX[i] = CELL_CENTRE + (cellX - 0.5f) + (Random_Float(&rnd) * 0.4f - 0.2f);
+				terrain.velY[i] = CELL_CENTRE + (cellY - 0.0f) + (Random_Float(&rnd) * 0.4f - 0.2f);
+				terrain.velZ[i] = CELL_CENTRE + (cellZ - 0.5f) + (Random_Float(&rnd) * 0.4f - 0.2f);
+				terrain.gravity[i] = Blocks.ParticleGravity[old];
 
 				rec = baseRec;
 				rec.u1 = baseRec.u1 + Random_Range(&rnd, minU, maxUsedU) * uScale;
@@ -390,16 +611,14 @@ void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
 				rec.v2 = rec.v1 + 4 * vScale;
 				rec.u2 = min(rec.u2, maxU2) - 0.01f * uScale;
 				rec.v2 = min(rec.v2, maxV2) - 0.01f * vScale;
-		
-				Vec3_Add(&p->base.lastPos, &origin, &cell);
-				p->base.nextPos  = p->base.lastPos;
-				p->base.lifetime = 0.3f + Random_Float(&rnd) * 1.2f;
 
-				p->rec    = rec;
-				p->texLoc = loc;
-				p->block  = old;
+				terrain_recs[i]   = rec;
+				terrain_locs[i]   = loc;
+				terrain_blocks[i] = old;
+
 				type = Random_Next(&rnd, 30);
-				p->base.size = type >= 28 ? 12 : (type >= 25 ? 10 : 8);
+				ParticleList_Init(&terrain, i, origin.x + cell.x, origin.y + cell.y, origin.z + cell.z,
+					0.3f + Random_Float(&rnd) * 1.2f, type >= 28 ? 12 : (type >= 25 ? 10 : 8));
 			}
 		}
 	}
@@ -409,16 +628,11 @@ void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
 /*########################################################################################################################*
 *-------------------------------------------------------Custom particle---------------------------------------------------*
 *#########################################################################################################################*/
+static struct ParticleList custom;
 #ifdef CC_BUILD_NETWORKING
-struct CustomParticle {
-	struct Particle base;
-	int effectId;
-	float totalLifespan;
-};
-
 struct CustomParticleEffect Particles_CustomEffects[256];
-static struct CustomParticle custom_particles[PARTICLES_MAX];
-static int custom_count;
+static cc_uint8* custom_effects;
+static float* custom_totalLifespans;
 static cc_uint8 collideFlags;
 #define EXPIRES_UPON_TOUCHING_GROUND (1 << 0)
 #define SOLID_COLLIDES  (1 << 1)
@@ -437,32 +651,29 @@ static cc_bool CustomParticle_CanPass(BlockID block) {
 	return true;
 }
 
-static cc_bool CustomParticle_Tick(struct CustomParticle* p, float delta) {
-	struct CustomParticleEffect* e = &Particles_CustomEffects[p->effectId];
-	hitTerrain   = false;
-	collideFlags = e->collideFlags;
-
-	return PhysicsTick(&p->base, e->gravity, CustomParticle_CanPass, delta)
-		|| (hitTerrain && (e->collideFlags & EXPIRES_UPON_TOUCHING_GROUND));
+static cc_bool CustomParticle_Prepare(int i) {
+	collideFlags = Particles_CustomEffects[custom_effects[i]].collideFlags;
+	return collideFlags & EXPIRES_UPON_TOUCHING_GROUND;
 }
 
-static void CustomParticle_Render(struct CustomParticle* p, float t, struct VertexTextured* vertices) {
-	struct CustomParticleEffect* e = &Particles_CustomEffects[p->effectId];
+static void CustomParticle_Render(int i, float t, struct VertexTextured* vertices) {
+	struct CustomParticleEffect* e = &Particles_CustomEffects[custom_effects[i]];
 	Vec3 pos;
 	Vec2 size;
 	PackedCol col;
 	TextureRec rec = e->rec;
 	int x, y, z;
 
-	float time_lived = p->totalLifespan - p->base.lifetime;
-	int curFrame = Math_Floor(e->frameCount * (time_lived / p->totalLifespan));
+	float totalLifespan = custom_totalLifespans[i];
+	float time_lived    = totalLifespan - custom.lifetime[i];
+	int curFrame = Math_Floor(e->frameCount * (time_lived / totalLifespan));
 	float shiftU = curFrame * (rec.u2 - rec.u1);
 
 	rec.u1 += shiftU;/* * 0.0078125f; */
 	rec.u2 += shiftU;/* * 0.0078125f; */
 
-	Vec3_Lerp(&pos, &p->base.lastPos, &p->base.nextPos, t);
-	size.x = p->base.size; size.y = size.x;
+	ParticleList_GetPos(&custom, i, t, &pos);
+	size.x = custom.size[i]; size.y = size.x;
 
 	x = Math_Floor(pos.x); y = Math_Floor(pos.y); z = Math_Floor(pos.z);
 	col = e->fullBright ? PACKEDCOL_WHITE : Lighting.Color(x, y, z);
@@ -473,52 +684,60 @@ static void CustomParticle_Render(struct CustomParticle* p, float t, struct Vert
 
 static void Custom_Render(float t) {
 	struct VertexTextured* data;
-	int i;
-	if (!custom_count) return;
+	int i, j, count;
+	if (!custom.count) return;
+	Gfx_BindTexture(particles_TexId);
+	if (custom.gpuVerts) { ParticleList_RenderGpu(&custom, t); return; }
 
-	data = (struct VertexTextured*)Gfx_LockDynamicVb(particles_VB, 
-										VERTEX_FORMAT_TEXTURED, custom_count * 4);
-	for (i = 0; i < custom_count; i++) {
-		CustomParticle_Render(&custom_particles[i], t, data);
-		data += 4;
-	}
+	for (i = 0; i < custom.count; i += count) 
+	{
+		count = min(custom.count - i, particles_batchMax);
+		data  = ParticleList_BeginBatch(count);
 
-	Gfx_BindTexture(particles_TexId);
-	Gfx_UnlockDynamicVb(particles_VB);
-	Gfx_DrawVb_IndexedTris(custom_count * 4);
+		for (j = 0; j < count; j++, data += 4) {
+			CustomParticle_Render(i + j, t, data);
+		}
+		ParticleList_EndBatch(count);
+	}
 }
 
 static void Custom_RemoveAt(int i) {
-	for (; i < custom_count - 1; i++) {
-		custom_particles[i] = custom_particles[i + 1];
-	}
-	custom_count--;
+	int j = custom.count - 1;
+	custom_effects[i]        = custom_effects[j];
+	custom_totalLifespans[i] = custom_totalLifespans[j];
+	ParticleList_RemoveAt(&custom, i);
 }
 
 static void Custom_Tick(float delta) {
-	int i;
-	for (i = 0; i < custom_count; i++) {
-		if (CustomParticle_Tick(&custom_particles[i], delta)) {
-			Custom_RemoveAt(i); i--;
-		}
-	}
+	ParticleList_Tick(&custom, delta, CustomParticle_CanPass, CustomParticle_Prepare, Custom_RemoveAt);
+}
+
+static void Custom_Alloc(void) {
+	ParticleList_Alloc(&custom);
+	if (Gfx.SupportsParticleVertices) ParticleList_AllocGpu(&custom);
+	custom_effects        = (cc_uint8*)Mem_Alloc(particles_capacity, 1, "custom particle effects");
+	custom_totalLifespans = (float*)Mem_Alloc(particles_capacity, sizeof(float), "custom particle lifespans");
+}
+
+static void Custom_Free(void) {
+	ParticleList_Free(&custom);
+	ParticleList_FreeGpu(&custom);
+	Mem_Free(custom_effects);        custom_effects        = NULL;
+	Mem_Free(custom_totalLifespans); custom_totalLifespans = NULL;
 }
 
 void Particles_CustomEffect(int effectID, float x, float y, float z, float originX, float originY, float originZ) {
-	struct CustomParticle* p;
 	struct CustomParticleEffect* e = &Particles_CustomEffects[effectID];
-	int i, count = e->particleCount;
-	Vec3 offset, delta, origin;
-	float d;
+	int i, j, count = e->particleCount;
+	Vec3 offset, delta, origin, pos;
+	float d, lifetime;
+	PackedCol col;
+	BlockID cur;
 
 	origin.x = originX; origin.y = originY; origin.z = originZ;
 
 	for (i = 0; i < count; i++) 
 	{
-		if (custom_count == PARTICLES_MAX) Custom_RemoveAt(0);
-		p = &custom_particles[custom_count++];
-		p->effectId = effectID;
-
 		offset.x = Random_Float(&rnd) - 0.5f;
 		offset.y = Random_Float(&rnd) - 0.5f;
 		offset.z = Random_Float(&rnd) - 0.5f;
@@ -530,34 +749,44 @@ void Particles_CustomEffect(int effectID, float x, float y, float z, float origi
 		d  = Math_Exp2(Math_Log2(d) / 3.0); /* d^1/3 for better distribution */
 		d *= e->spread;
 
-		p->base.lastPos.x = x + offset.x * d;
-		p->base.lastPos.y = y + offset.y * d;
-		p->base.lastPos.z = z + offset.z * d;
+		pos.x = x + offset.x * d;
+		pos.y = y + offset.y * d;
+		pos.z = z + offset.z * d;
 		
-		Vec3_Sub(&delta, &p->base.lastPos, &origin);
+		Vec3_Sub(&delta, &pos, &origin);
 		Vec3_Normalise(&delta);
-
-		p->base.velocity.x = delta.x * e->speed;
-		p->base.velocity.y = delta.y * e->speed;
-		p->base.velocity.z = delta.z * e->speed;
-
-		p->base.nextPos  = p->base.lastPos;
-		p->base.lifetime = e->baseLifetime + (e->baseLifetime * e->lifetimeVariation) * ((Random_Float(&rnd) - 0.5f) * 2);
-		p->totalLifespan = p->base.lifetime;
-
-		p->base.size = e->size + (e->size * e->sizeVariation) * ((Random_Float(&rnd) - 0.5f) * 2);
+		lifetime = e->baseLifetime + (e->baseLifetime * e->lifetimeVariation) * ((Random_Float(&rnd) - 0.5f) * 2);
 
 		/* Don't spawn custom particle inside a block (otherwise it appears */
 		/*   for a few frames, then disappears in first PhysicsTick call)*/
 		collideFlags = e->collideFlags;
-		if (IntersectsBlock(&p->base, CustomParticle_CanPass)) custom_count--;
+		cur = GetBlock((int)pos.x, (int)pos.y, (int)pos.z);
+		if (IntersectsBlock(pos.x, pos.y, pos.z, cur, CustomParticle_CanPass)) continue;
+
+		j = ParticleList_Add(&custom, Custom_RemoveAt);
+		custom_effects[j]        = (cc_uint8)effectID;
+		custom_totalLifespans[j] = lifetime;
+
+		custom.velX[j] = delta.x * e->speed;
+		custom.velY[j] = delta.y * e->speed;
+		custom.velZ[j] = delta.z * e->speed;
+		custom.gravity[j] = e->gravity;
+
+		ParticleList_Init(&custom, j, pos.x, pos.y, pos.z, lifetime,
+			e->size + (e->size * e->sizeVariation) * ((Random_Float(&rnd) - 0.5f) * 2));
+
+		if (!custom.gpuVerts) continue;
+		col = e->fullBright ? PACKEDCOL_WHITE : Lighting.Color(Math_Floor(pos.x), Math_Floor(pos.y), Math_Floor(pos.z));
+		col = PackedCol_Tint(col, e->tintCol);
+		ParticleList_InitGpu(&custom, j, &e->rec, col, custom.size[j], 
+			lifetime > 0.0f ? e->frameCount / lifetime : 0.0f, e->rec.u2 - e->rec.u1);
 	}
 }
 #else
-static int custom_count;
-
 static void Custom_Render(float t) { }
 static void Custom_Tick(float delta) { }
+static void Custom_Alloc(void) { }
+static void Custom_Free(void)  { }
 #endif
 
 
@@ -565,11 +794,11 @@ static void Custom_Tick(float delta) { }
 *--------------------------------------------------------Particles--------------------------------------------------------*
 *#########################################################################################################################*/
 void Particles_Render(float t) {
-	if (!terrain_count && !rain_count && !custom_count) return;
+	if (!terrain.count && !rain.count && !custom.count) return;
 
 	if (Gfx.LostContext) return;
 	if (!particles_VB)
-		particles_VB = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, PARTICLES_MAX * 4);
+		particles_VB = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, particles_batchMax * 4);
 
 	Gfx_SetAlphaTest(true);
 
@@ -583,6 +812,9 @@ void Particles_Render(float t) {
 
 static void Particles_Tick(struct ScheduledTask* task) {
 	float delta = task->interval;
+	particles_time     += delta;
+	particles_tickDelta = delta;
+
 	Terrain_Tick(delta);
 	Rain_Tick(delta);
 	Custom_Tick(delta);
@@ -600,6 +832,8 @@ static struct TextureEntry particles_entry = { "particles.png", ParticlesPngProc
 
 static void OnContextLost(void* obj) {
 	Gfx_DeleteDynamicVb(&particles_VB); 
+	Gfx_DeleteDynamicVb(&rain.gpuVb);
+	Gfx_DeleteDynamicVb(&custom.gpuVb);
 
 	if (Gfx.ManagedTextures) return;
 	Gfx_DeleteTexture(&particles_TexId);
@@ -614,13 +848,26 @@ static void OnInit(void) {
 	Random_SeedFromCurrentTime(&rnd);
 	TextureEntry_Register(&particles_entry);
 
+	particles_capacity = Options_GetInt(OPT_MAX_PARTICLES, 10, PARTICLES_MAX_LIMIT, PARTICLES_DEF_MAX);
+	particles_batchMax = min(particles_capacity, PARTICLES_BATCH_MAX);
+	ParticleList_Alloc(&rain);
+	if (Gfx.SupportsParticleVertices) ParticleList_AllocGpu(&rain);
+	Terrain_Alloc();
+	Custom_Alloc();
+
 	Event_Register_(&UserEvents.BlockChanged, NULL, OnBreakBlockEffect_Handler);
 	Event_Register_(&GfxEvents.ContextLost,   NULL, OnContextLost);
 }
 
-static void OnFree(void) { OnContextLost(NULL); }
+static void OnFree(void) {
+	OnContextLost(NULL);
+	ParticleList_Free(&rain);
+	ParticleList_FreeGpu(&rain);
+	Terrain_Free();
+	Custom_Free();
+}
 
-static void OnReset(void) { rain_count = 0; terrain_count = 0; custom_count = 0; }
+static void OnReset(void) { rain.count = 0; terrain.count = 0; custom.count = 0; particles_time = 0.0f; }
 
 struct IGameComponent Particles_Component = {
 	OnInit,  /* Init  */
@@ -126,7 +126,9 @@ cc_bool Intersection_RayIntersectsBox(Vec3 origin, Vec3 invDir, Vec3 min, Vec3 m
 /*########################################################################################################################*
 *----------------------------------------------------Collisions finder----------------------------------------------------*
 *#########################################################################################################################*/
-#define SEARCHER_STATES_MIN 64
+#define SEARCHER_STATES_MIN 256
+/* Below this many states, an insertion sort beats quicksort */
+#define SEARCHER_INSERTION_MAX 16
 static struct SearcherState searcherDefaultStates[SEARCHER_STATES_MIN];
 static cc_uint32 searcherCapacity = SEARCHER_STATES_MIN;
 struct SearcherState* Searcher_States = searcherDefaultStates;
@@ -149,16 +151,52 @@ static void Searcher_QuickSort(int left, int right) {
 	}
 }
 
+static void Searcher_InsertionSort(int count) {
+	struct SearcherState* keys = Searcher_States; struct SearcherState key;
+	int i, j;
+
+	for (i = 1; i < count; i++) {
+		key = keys[i];
+		for (j = i - 1; j >= 0 && keys[j].tSquared > key.tSquared; j--) {
+			keys[j + 1] = keys[j];
+		}
+		keys[j + 1] = key;
+	}
+}
+
+/* Doubles capacity of the states arena, preserving the states found so far */
+static struct SearcherState* Searcher_Grow(struct SearcherState* curState) {
+	cc_uint32 count = (cc_uint32)(curState - Searcher_States);
+	struct SearcherState* states;
+
+	states = (struct SearcherState*)Mem_Alloc(searcherCapacity * 2, sizeof(struct SearcherState), "collision search states");
+	Mem_Copy(states, Searcher_States, count * sizeof(struct SearcherState));
+
+	if (Searcher_States != searcherDefaultStates) Mem_Free(Searcher_States);
+	Searcher_States   = states;
+	searcherCapacity *= 2;
+	return states + count;
+}
+
+/* Calculates the time along velocity for the entity to reach the block on a single axis */
+static CC_INLINE float Searcher_AxisTime(float vel, float entityMin, float entityMax, float blockMin, float blockMax) {
+	float d = vel > 0.0f ? blockMin - entityMax : entityMin - blockMax;
+
+	if (entityMax >= blockMin && entityMin <= blockMax) return 0.0f;
+	return vel == 0.0f ? MATH_LARGENUM : Math_AbsF(d / vel);
+}
+
 int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, struct AABB* entityExtentBB) {
 	Vec3 vel = entity->Velocity;
 	IVec3 min, max;
-	cc_uint32 elements;
 	struct SearcherState* curState;
+	struct SearcherState* endState;
 	int count;
 
-	BlockID block;
-	struct AABB blockBB;
-	float xx, yy, zz, tx, ty, tz;
+	BlockID block, rowBlock;
+	cc_bool rowInside, rowReachable;
+	float minX, maxX, minY, maxY, minZ, maxZ;
+	float tx, ty, tz, rowTime;
 	int x, y, z;
 
 	Entity_GetBounds(entity, entityBB);
@@ -173,68 +211,74 @@ int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, s
 
 	IVec3_Floor(&min, &entityExtentBB->Min);
 	IVec3_Floor(&max, &entityExtentBB->Max);
-	elements = (max.x - min.x + 1) * (max.y - min.y + 1) * (max.z - min.z + 1);
+	/* Everything above the map is air, which never collides */
+	max.y = min(max.y, World.Height - 1);
 
-	if (elements > searcherCapacity) {
-		Searcher_Free();
-		searcherCapacity = elements;
-		Searcher_States  = (struct SearcherState*)Mem_Alloc(elements, sizeof(struct SearcherState), "collision search states");
-	}
 	curState = Searcher_States;
+	endState = Searcher_States + searcherCapacity;
 
 	/* Order loops so that we minimise cache misses */
 	for (y = min.y; y <= max.y; y++) {
 		for (z = min.z; z <= max.z; z++) {
+			/* Y/Z tests only depend on the block type within a row, so are only redone when it changes */
+			rowInside = y >= 0 && (unsigned)z < (unsigned)World.Length;
+			rowBlock  = BLOCK_AIR;
+			rowReachable = false; rowTime = 0.0f;
+
 			for (x = min.x; x <= max.x; x++) {
-				block = World_GetPhysicsBlock(x, y, z);
+				block = rowInside && (unsigned)x < (unsigned)World.Width ? World_GetBlock(x, y, z) : BLOCK_BEDROCK;
 				if (Blocks.Collide[block] != COLLIDE_SOLID) continue;
 
-				xx = (float)x; yy = (float)y; zz = (float)z;
-				blockBB.Min = Blocks.MinBB[block];
-				blockBB.Min.x += xx; blockBB.Min.y += yy; blockBB.Min.z += zz;
-				blockBB.Max = Blocks.MaxBB[block];
-				blockBB.Max.x += xx; blockBB.Max.y += yy; blockBB.Max.z += zz;
-
-				if (!AABB_Intersects(entityExtentBB, &blockBB)) continue; /* necessary for non whole blocks. (slabs) */
-				Searcher_CalcTime(&vel, entityBB, &blockBB, &tx, &ty, &tz);
-				if (tx > 1.0f || ty > 1.0f || tz > 1.0f) continue;
+				if (block != rowBlock) {
+					rowBlock = block;
+					minY = Blocks.MinBB[block].y + y; maxY = Blocks.MaxBB[block].y + y;
+					minZ = Blocks.MinBB[block].z + z; maxZ = Blocks.MaxBB[block].z + z;
+
+					/* necessary for non whole blocks. (slabs) */
+					rowReachable = 
+						entityExtentBB->Max.y >= minY && entityExtentBB->Min.y <= maxY &&
+						entityExtentBB->Max.z >= minZ && entityExtentBB->Min.z <= maxZ;
+					if (!rowReachable) continue;
+
+					ty = Searcher_AxisTime(vel.y, entityBB->Min.y, entityBB->Max.y, minY, maxY);
+					tz = Searcher_AxisTime(vel.z, entityBB->Min.z, entityBB->Max.z, minZ, maxZ);
+					rowReachable = ty <= 1.0f && tz <= 1.0f;
+					rowTime      = ty * ty + tz * tz;
+				}
+				if (!rowReachable) continue;
+
+				minX = Blocks.MinBB[block].x + x; maxX = Blocks.MaxBB[block].x + x;
+				if (entityExtentBB->Max.x < minX || entityExtentBB->Min.x > maxX) continue;
+				tx = Searcher_AxisTime(vel.x, entityBB->Min.x, entityBB->Max.x, minX, maxX);
+				if (tx > 1.0f) continue;
+
+				if (curState == endState) {
+					curState = Searcher_Grow(curState);
+					endState = Searcher_States + searcherCapacity;
+				}
 
 				curState->x = (x << 3) | (block  & 0x007);
 				curState->y = (y << 4) | ((block & 0x078) >> 3);
 				curState->z = (z << 3) | ((block & 0x380) >> 7);
-				curState->tSquared = tx * tx + ty * ty + tz * tz;
+				curState->tSquared = tx * tx + rowTime;
 				curState++;
 			}
 		}
 	}
 
 	count = (int)(curState - Searcher_States);
-	if (count) Searcher_QuickSort(0, count - 1);
+	if (count <= SEARCHER_INSERTION_MAX) {
+		Searcher_InsertionSort(count);
+	} else {
+		Searcher_QuickSort(0, count - 1);
+	}
 	return count;
 }
 
 void Searcher_CalcTime(Vec3* vel, struct AABB *entityBB, struct AABB* blockBB, float* tx, float* ty, float* tz) {
-	float dx = vel->x > 0.0f ? blockBB->Min.x - entityBB->Max.x : entityBB->Min.x - blockBB->Max.x;
-	float dy = vel->y > 0.0f ? blockBB->Min.y - entityBB->Max.y : entityBB->Min.y - blockBB->Max.y;
-	float dz = vel->z > 0.0f ? blockBB->Min.z - entityBB->Max.z : entityBB->Min.z - blockBB->Max.z;
-
-	if (entityBB->Max.x >= blockBB->Min.x && entityBB->Min.x <= blockBB->Max.x) {
-		*tx = 0.0f; /* Inlined XIntersects test */
-	} else {
-		*tx = vel->x == 0.0f ? MATH_LARGENUM : Math_AbsF(dx / vel->x);
-	}
-
-	if (entityBB->Max.y >= blockBB->Min.y && entityBB->Min.y <= blockBB->Max.y) {
-		*ty = 0.0f; /* Inlined YIntersects test */
-	} else {
-		*ty = vel->y == 0.0f ? MATH_LARGENUM : Math_AbsF(dy / vel->y);
-	}
-
-	if (entityBB->Max.z >= blockBB->Min.z && entityBB->Min.z <= blockBB->Max.z) {
-		*tz = 0.0f; /* Inlined ZIntersects test */
-	} else {
-		*tz = vel->z == 0.0f ? MATH_LARGENUM : Math_AbsF(dz / vel->z);
-	}
+	*tx = Searcher_AxisTime(vel->x, entityBB->Min.x, entityBB->Max.x, blockBB->Min.x, blockBB->Max.x);
+	*ty = Searcher_AxisTime(vel->y, entityBB->Min.y, entityBB->Max.y, blockBB->Min.y, blockBB->Max.y);
+	*tz = Searcher_AxisTime(vel->z, entityBB->Min.z, entityBB->Max.z, blockBB->Min.z, blockBB->Max.z);
 }
 
 void Searcher_Free(void) {
@@ -9,6 +9,7 @@
 #include "Logger.h"
 #include "Camera.h"
 #include "Platform.h"
+#include "MapRenderer.h"
 
 static float pickedPos_dist;
 static void TestAxis(struct RayTracer* t, float dAxis, Face fAxis) {
@@ -102,6 +103,15 @@ void RayTracer_Step(struct RayTracer* t) {
 	}
 }
 
+/* Moves along the ray until the ray leaves the chunk it is currently in */
+static void RayTracer_SkipChunk(struct RayTracer* t) {
+	int cx = t->pos.x >> CHUNK_SHIFT, cy = t->pos.y >> CHUNK_SHIFT, cz = t->pos.z >> CHUNK_SHIFT;
+
+	do {
+		RayTracer_Step(t);
+	} while ((t->pos.x >> CHUNK_SHIFT) == cx && (t->pos.y >> CHUNK_SHIFT) == cy && (t->pos.z >> CHUNK_SHIFT) == cz);
+}
+
 #define BORDER BLOCK_BEDROCK
 typedef cc_bool (*IntersectTest)(struct RayTracer* t);
 
@@ -188,6 +198,12 @@ static cc_bool RayTrace(struct RayTracer* t, const Vec3* origin, const Vec3* dir
 		dx = min(dxMin, dxMax); dy = min(dyMin, dyMax); dz = min(dzMin, dzMax);
 		if (dx * dx + dy * dy + dz * dz > reachSq) return false;
 
+		/* Chunks which are completely air can never be intersected, so skip past all their blocks at once */
+		/* NOTE: Only when inside the map, as map borders are also intersected when ray tracing from outside */
+		if (insideMap && MapRenderer_IsChunkAir(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT)) {
+			RayTracer_SkipChunk(t); continue;
+		}
+
 		if (intersect(t)) return true;
 		RayTracer_Step(t);
 	}
@@ -246,6 +262,14 @@ void Picking_CalcPickedBlock(const Vec3* origin, const Vec3* dir, float reach, s
 	}
 }
 
+void Picking_CalcPickedBlocks(const Vec3* origin, const Vec3* dirs, int count, float reach, struct RayTracer* results) {
+	int i;
+	for (i = 0; i < count; i++) 
+	{
+		Picking_CalcPickedBlock(origin, &dirs[i], reach, &results[i]);
+	}
+}
+
 void Picking_ClipCameraPos(const Vec3* origin, const Vec3* dir, float reach, struct RayTracer* t) {
 	cc_bool noClip = (!Camera.Clipping || Entities.CurPlayer->Hacks.Noclip)
 						&& Entities.CurPlayer->Hacks.CanNoclip;
@@ -44,6 +44,9 @@ void RayTracer_Step(struct RayTracer* t);
    Marks pickedPos as invalid if a block could not be found due to going outside map boundaries
    or not being able to find a suitable candiate within the given reach distance.*/
 void Picking_CalcPickedBlock(const Vec3* origin, const Vec3* dir, float reach, struct RayTracer* t);
+/* Determines the picked block for each of the given directions from the same origin. */
+/* (e.g. for plugins that need to cast many rays per frame) */
+CC_API void Picking_CalcPickedBlocks(const Vec3* origin, const Vec3* dirs, int count, float reach, struct RayTracer* results);
 void Picking_ClipCameraPos(const Vec3* origin, const Vec3* dir, float reach, struct RayTracer* t);
 
 CC_END_HEADER
@@ -175,6 +175,28 @@ CC_API void* Mem_Realloc(void* mem, cc_uint32 numElems, cc_uint32 elemsSize, con
 /* Frees an allocated a block of memory. Does nothing when passed NULL. */
 CC_API void  Mem_Free(void* mem);
 
+/* Kinds of resources which can have their memory usage tracked */
+enum MemTrackType { MEM_TRACK_HEAP, MEM_TRACK_TEXTURE, MEM_TRACK_VB, MEM_TRACK_COUNT };
+#ifdef CC_BUILD_TRACKMEM
+struct MemTrackedTag {
+	const char* name; /* Descriptive string passed to Mem_Alloc etc */
+	cc_uint8 type;    /* Type of resources, see MemTrackType */
+	int count;        /* Number of live allocations */
+	cc_uint64 cur, peak; /* Current and peak bytes used by this tag */
+};
+
+/* Records that the given allocation/GPU resource currently uses 'size' bytes under the given tag */
+/* NOTE: Calling this again with the same key and type replaces the previously recorded size and tag */
+void Mem_Track(int type, const void* key, cc_uint32 size, const char* tag);
+/* Removes the given allocation/GPU resource from tracked memory usage */
+void Mem_Untrack(int type, const void* key);
+/* Copies up to 'maxTags' tags into the given array, returning the number of tags copied */
+int  Mem_GetTrackedTags(struct MemTrackedTag* tags, int maxTags);
+#else
+#define Mem_Track(type, key, size, tag)
+#define Mem_Untrack(type, key)
+#endif
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Memory modification--------------------------------------------------*
@@ -194,13 +216,25 @@ int Mem_Equal(const void* a, const void* b, cc_uint32 numBytes);
 /*########################################################################################################################*
 *-----------------------------------------------------Logging functions---------------------------------------------------*
 *#########################################################################################################################*/
+enum LogCategory { LOG_CATEGORY_GENERAL, LOG_CATEGORY_NETWORK, LOG_CATEGORY_AUDIO, LOG_CATEGORY_GRAPHICS, LOG_CATEGORY_COUNT };
+enum LogLevel    { LOG_LEVEL_NONE, LOG_LEVEL_WARN, LOG_LEVEL_INFO, LOG_LEVEL_DEBUG };
+/* Most verbose level of messages that are logged for each category (LOG_LEVEL_INFO by default) */
+extern cc_uint8 Platform_LogLevels[LOG_CATEGORY_COUNT];
+/* Whether messages of the given level in the given category should be logged */
+/* NOTE: Only needed for messages logged very frequently, or which are only useful for debugging */
+#define Platform_LogEnabled(category, level) (Platform_LogLevels[category] >= (level))
+
 /* Logs a debug message to console. */
+/* NOTE: Unlike the other Platform_Log functions, this always writes the message immediately */
 void Platform_Log(const char* msg, int len);
 void Platform_LogConst(const char* message);
 void Platform_Log1(const char* format, const void* a1);
 void Platform_Log2(const char* format, const void* a1, const void* a2);
 void Platform_Log3(const char* format, const void* a1, const void* a2, const void* a3);
 void Platform_Log4(const char* format, const void* a1, const void* a2, const void* a3, const void* a4);
+/* Starts the background thread which writes out queued log messages, on platforms where logging is slow */
+/* NOTE: Before this is called, messages are always written immediately instead */
+void Platform_StartLogThread(void);
 
 /* Outputs more detailed information about errors with operating system functions. */
 /* NOTE: This is for general functions like file I/O. If a more specific 
@@ -279,6 +313,33 @@ cc_result File_Seek(cc_file file, int offset, int seekType);
 cc_result File_Position(cc_file file, cc_uint32* pos);
 /* Attempts to retrieve the length of the given file. */
 cc_result File_Length(cc_file file, cc_uint32* len);
+#ifdef CC_BUILD_FILEMAP
+/* Alignment that offsets passed to File_Map must be a multiple of */
+#define FILE_MAP_ALIGNMENT (64 * 1024)
+/* Attempts to map part of the given file into memory as private copy-on-write pages. */
+/* NOTE: The mapping remains valid after the file is closed */
+cc_result File_Map(cc_file file, cc_uint32 offset, cc_uint32 length, void** data);
+/* Unmaps memory that was previously mapped using File_Map */
+void File_Unmap(void* data, cc_uint32 length);
+#endif
+
+/* Callback function invoked on the main thread once an asynchronous file write has completed. */
+typedef void (*File_AsyncCallback)(const cc_string* path, cc_result res, void* obj);
+/* Creates (or overwrites) a file on a background thread, setting its contents to the given data. */
+/* NOTE: Takes ownership of data, which must have been allocated using Mem_Alloc/Mem_TryAlloc */
+/* NOTE: Writes are performed in the order they were queued. If the platform */
+/*  does not support threading, the write is instead performed immediately */
+void File_WriteAllAsync(const cc_string* path, void* data, cc_uint32 length, File_AsyncCallback callback, void* obj);
+struct Stream;
+/* Callback function invoked on a background thread to write the contents of an asynchronously written file. */
+typedef cc_result (*File_AsyncWriter)(struct Stream* s, void* obj);
+/* Creates (or overwrites) a file on a background thread, then calls writer to write its contents. */
+/* NOTE: obj is passed to both writer and callback, so can be freed in callback */
+void File_WriteAsync(const cc_string* path, File_AsyncWriter writer, File_AsyncCallback callback, void* obj);
+/* Invokes the callbacks of all asynchronous file writes which have completed since the last call. */
+void File_ProcessAsync(void);
+/* Blocks until all queued asynchronous file writes have completed. */
+void File_FlushAsync(void);
 
 
 /*########################################################################################################################*
@@ -287,6 +348,14 @@ cc_result File_Length(cc_file file, cc_uint32* len);
 typedef void (*Thread_StartFunc)(void);
 /* Blocks the current thread for the given number of milliseconds. */
 CC_API void Thread_Sleep(cc_uint32 milliseconds);
+#if defined CC_BUILD_WIN || defined CC_BUILD_POSIX
+/* Blocks the current thread for the given number of microseconds. */
+/* NOTE: Uses a higher resolution timer than Thread_Sleep when the OS provides one, */
+/*  but may still oversleep by up to a millisecond or so depending on the scheduler */
+void Thread_SleepPrecise(cc_uint32 microseconds);
+#else
+#define Thread_SleepPrecise(microseconds) Thread_Sleep((microseconds) / 1000)
+#endif
 /* Initialises and starts a new thread that runs the given function. */
 /* NOTE: Threads must either be detached or joined, otherwise data leaks. */
 CC_API void Thread_Run(void** handle, Thread_StartFunc func, int stackSize, const char* name);
@@ -362,6 +431,11 @@ cc_result Socket_CheckWritable(cc_socket s, cc_bool* writable);
 /* If the input represents an IP address, then parses the input into a single IP address */
 /* Otherwise, attempts to resolve the input via DNS into one or more IP addresses */
 cc_result Socket_ParseAddress(const cc_string* address, int port, cc_sockaddr* addrs, int* numValidAddrs);
+/* Same as Socket_ParseAddress, but reuses the results of recently resolving the same address and port */
+cc_result Socket_ResolveAddress(const cc_string* address, int port, cc_sockaddr* addrs, int* numValidAddrs);
+/* Records whether connecting to one of the addresses returned by Socket_ResolveAddress succeeded */
+/* NOTE: Later calls to Socket_ResolveAddress return working addresses first, and failing addresses last */
+void Socket_ReportAddress(const cc_string* address, int port, const cc_sockaddr* addr, cc_bool success);
 
 /* Allocates a new socket that is capable of connecting to the given address */
 cc_result Socket_Create(cc_socket* s, cc_sockaddr* addr, cc_bool nonblocking);
@@ -53,6 +53,7 @@ void* Mem_TryRealloc(void* mem, cc_uint32 numElems, cc_uint32 elemsSize) {
 }
 
 void Mem_Free(void* mem) {
+	Mem_Untrack(MEM_TRACK_HEAP, mem);
 	if (mem) FreeVec(mem);
 }
 
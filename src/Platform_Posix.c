@@ -25,6 +25,9 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#ifdef CC_BUILD_FILEMAP
+#include <sys/mman.h>
+#endif
 #include <utime.h>
 #include <signal.h>
 #include <stdio.h>
@@ -95,6 +98,7 @@ void* Mem_TryRealloc(void* mem, cc_uint32 numElems, cc_uint32 elemsSize) {
 }
 
 void Mem_Free(void* mem) {
+	Mem_Untrack(MEM_TRACK_HEAP, mem);
 	if (mem) free(mem);
 }
 
@@ -393,12 +397,36 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	*len = st.st_size; return 0;
 }
 
+#ifdef CC_BUILD_FILEMAP
+cc_result File_Map(cc_file file, cc_uint32 offset, cc_uint32 length, void** data) {
+	void* ptr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, offset);
+	if (ptr == MAP_FAILED) { *data = NULL; return errno; }
+
+	*data = ptr; return 0;
+}
+
+void File_Unmap(void* data, cc_uint32 length) { munmap(data, length); }
+#endif
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
 *#########################################################################################################################*/
 void Thread_Sleep(cc_uint32 milliseconds) { usleep(milliseconds * 1000); }
 
+void Thread_SleepPrecise(cc_uint32 microseconds) {
+	struct timespec spec;
+	spec.tv_sec  = microseconds / 1000000;
+	spec.tv_nsec = (microseconds % 1000000) * 1000;
+	
+	/* Restart the sleep with the remaining time when interrupted by a signal */
+#if defined CC_BUILD_LINUX || defined CC_BUILD_ANDROID || defined CC_BUILD_FREEBSD || defined CC_BUILD_NETBSD
+	while (clock_nanosleep(CLOCK_MONOTONIC, 0, &spec, &spec) == EINTR) { }
+#else
+	while (nanosleep(&spec, &spec) == -1 && errno == EINTR) { }
+#endif
+}
+
 #ifdef CC_BUILD_ANDROID
 /* All threads using JNI must detach BEFORE they exit */
 /* (see https://developer.android.com/training/articles/perf-jni#threads */
@@ -64,6 +64,7 @@ void* Mem_TryRealloc(void* mem, cc_uint32 numElems, cc_uint32 elemsSize) {
 }
 
 void Mem_Free(void* mem) {
+	Mem_Untrack(MEM_TRACK_HEAP, mem);
 	if (mem) free(mem);
 }
 
@@ -237,6 +238,153 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
 *#########################################################################################################################*/
+#ifdef CC_BUILD_WEBTHREADS
+/* Threads are emscripten pthreads (Web Workers sharing the wasm memory through a SharedArrayBuffer) */
+/* NOTE: The main browser thread must never block for long, so only short compute jobs use these */
+#include <pthread.h>
+#include <errno.h>
+#include <unistd.h>
+#define NS_PER_SEC 1000000000ULL
+
+void Thread_Sleep(cc_uint32 milliseconds) { usleep(milliseconds * 1000); }
+
+static void* ExecThread(void* param) {
+	((Thread_StartFunc)param)();
+	return NULL;
+}
+
+void Thread_Run(void** handle, Thread_StartFunc func, int stackSize, const char* name) {
+	pthread_t* ptr = (pthread_t*)Mem_Alloc(1, sizeof(pthread_t), "thread");
+	pthread_attr_t attrs;
+	int res;
+	
+	*handle = ptr;
+	pthread_attr_init(&attrs);
+	pthread_attr_setstacksize(&attrs, stackSize);
+	
+	res = pthread_create(ptr, &attrs, ExecThread, (void*)func);
+	if (res) Process_Abort2(res, "Creating thread");
+	pthread_attr_destroy(&attrs);
+}
+
+void Thread_Detach(void* handle) {
+	pthread_t* ptr = (pthread_t*)handle;
+	int res = pthread_detach(*ptr);
+	if (res) Process_Abort2(res, "Detaching thread");
+	Mem_Free(ptr);
+}
+
+void Thread_Join(void* handle) {
+	pthread_t* ptr = (pthread_t*)handle;
+	int res = pthread_join(*ptr, NULL);
+	if (res) Process_Abort2(res, "Joining thread");
+	Mem_Free(ptr);
+}
+
+void* Mutex_Create(const char* name) {
+	pthread_mutex_t* ptr = (pthread_mutex_t*)Mem_Alloc(1, sizeof(pthread_mutex_t), "mutex");
+	int res = pthread_mutex_init(ptr, NULL);
+	if (res) Process_Abort2(res, "Creating mutex");
+	return ptr;
+}
+
+void Mutex_Free(void* handle) {
+	int res = pthread_mutex_destroy((pthread_mutex_t*)handle);
+	if (res) Process_Abort2(res, "Destroying mutex");
+	Mem_Free(handle);
+}
+
+void Mutex_Lock(void* handle) {
+	int res = pthread_mutex_lock((pthread_mutex_t*)handle);
+	if (res) Process_Abort2(res, "Locking mutex");
+}
+
+void Mutex_Unlock(void* handle) {
+	int res = pthread_mutex_unlock((pthread_mutex_t*)handle);
+	if (res) Process_Abort2(res, "Unlocking mutex");
+}
+
+struct WaitData {
+	pthread_cond_t  cond;
+	pthread_mutex_t mutex;
+	int signalled; /* For when Waitable_Signal is called before Waitable_Wait */
+};
+
+void* Waitable_Create(const char* name) {
+	struct WaitData* ptr = (struct WaitData*)Mem_Alloc(1, sizeof(struct WaitData), "waitable");
+	int res;
+	
+	res = pthread_cond_init(&ptr->cond, NULL);
+	if (res) Process_Abort2(res, "Creating waitable");
+	res = pthread_mutex_init(&ptr->mutex, NULL);
+	if (res) Process_Abort2(res, "Creating waitable mutex");
+
+	ptr->signalled = false;
+	return ptr;
+}
+
+void Waitable_Free(void* handle) {
+	struct WaitData* ptr = (struct WaitData*)handle;
+	int res;
+	
+	res = pthread_cond_destroy(&ptr->cond);
+	if (res) Process_Abort2(res, "Destroying waitable");
+	res = pthread_mutex_destroy(&ptr->mutex);
+	if (res) Process_Abort2(res, "Destroying waitable mutex");
+	Mem_Free(handle);
+}
+
+void Waitable_Signal(void* handle) {
+	struct WaitData* ptr = (struct WaitData*)handle;
+	int res;
+
+	Mutex_Lock(&ptr->mutex);
+	ptr->signalled = true;
+	Mutex_Unlock(&ptr->mutex);
+
+	res = pthread_cond_signal(&ptr->cond);
+	if (res) Process_Abort2(res, "Signalling event");
+}
+
+void Waitable_Wait(void* handle) {
+	struct WaitData* ptr = (struct WaitData*)handle;
+	int res;
+
+	Mutex_Lock(&ptr->mutex);
+	if (!ptr->signalled) {
+		res = pthread_cond_wait(&ptr->cond, &ptr->mutex);
+		if (res) Process_Abort2(res, "Waitable wait");
+	}
+	ptr->signalled = false;
+	Mutex_Unlock(&ptr->mutex);
+}
+
+void Waitable_WaitFor(void* handle, cc_uint32 milliseconds) {
+	struct WaitData* ptr = (struct WaitData*)handle;
+	struct timeval tv;
+	struct timespec ts;
+	int res;
+	gettimeofday(&tv, NULL);
+
+	/* absolute time for some silly reason */
+	ts.tv_sec  = tv.tv_sec + milliseconds / 1000;
+	ts.tv_nsec = 1000 * (tv.tv_usec + 1000 * (milliseconds % 1000));
+
+	/* statement above might exceed max nsec, so adjust for that */
+	while (ts.tv_nsec >= NS_PER_SEC) {
+		ts.tv_sec++;
+		ts.tv_nsec -= NS_PER_SEC;
+	}
+
+	Mutex_Lock(&ptr->mutex);
+	if (!ptr->signalled) {
+		res = pthread_cond_timedwait(&ptr->cond, &ptr->mutex, &ts);
+		if (res && res != ETIMEDOUT) Process_Abort2(res, "Waitable wait for");
+	}
+	ptr->signalled = false;
+	Mutex_Unlock(&ptr->mutex);
+}
+#else
 /* No real threading support with emscripten backend */
 void  Thread_Sleep(cc_uint32 milliseconds) { }
 
@@ -250,6 +398,7 @@ void  Waitable_Free(void* handle) { }
 void  Waitable_Signal(void* handle) { }
 void  Waitable_Wait(void* handle) { }
 void  Waitable_WaitFor(void* handle, cc_uint32 milliseconds) { }
+#endif
 
 
 /*########################################################################################################################*
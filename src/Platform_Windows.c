@@ -98,6 +98,7 @@ void* Mem_TryRealloc(void* mem, cc_uint32 numElems, cc_uint32 elemsSize) {
 }
 
 void Mem_Free(void* mem) {
+	Mem_Untrack(MEM_TRACK_HEAP, mem);
 	if (mem) HeapFree(heap, 0, mem);
 }
 
@@ -408,11 +409,55 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	return *len != INVALID_FILE_SIZE ? 0 : GetLastError();
 }
 
+#ifdef CC_BUILD_FILEMAP
+cc_result File_Map(cc_file file, cc_uint32 offset, cc_uint32 length, void** data) {
+	HANDLE mapping;
+	cc_result res = 0;
+
+	/* PAGE_WRITECOPY + FILE_MAP_COPY means changes are private and never written back to the file */
+	mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if (!mapping) { *data = NULL; return GetLastError(); }
+
+	*data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, offset, length);
+	if (!(*data)) res = GetLastError();
+
+	/* The view keeps the mapping alive until it is unmapped */
+	CloseHandle(mapping);
+	return res;
+}
+
+void File_Unmap(void* data, cc_uint32 length) { UnmapViewOfFile(data); }
+#endif
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
 *#############################################################################################################p############*/
 void Thread_Sleep(cc_uint32 milliseconds) { Sleep(milliseconds); }
+
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION_ 0x00000002
+#define TIMER_ALL_ACCESS_ 0x1F0003
+static HANDLE preciseTimer;
+static cc_bool preciseTimerChecked;
+
+void Thread_SleepPrecise(cc_uint32 microseconds) {
+	LARGE_INTEGER due;
+	if (!preciseTimerChecked) {
+		preciseTimerChecked = true;
+		if (_CreateWaitableTimerExW && _SetWaitableTimer)
+			preciseTimer = _CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION_, TIMER_ALL_ACCESS_);
+	}
+
+	/* Sleep() is only accurate to the system timer resolution (often 15.6 ms) */
+	if (!preciseTimer) { Sleep(microseconds / 1000); return; }
+
+	/* Negative due time is relative, in 100 nanosecond units */
+	due.QuadPart = -(LONGLONG)microseconds * 10;
+	if (!_SetWaitableTimer(preciseTimer, &due, 0, NULL, NULL, FALSE)) {
+		Sleep(microseconds / 1000); return;
+	}
+	WaitForSingleObject(preciseTimer, INFINITE);
+}
 static DWORD WINAPI ExecThread(void* param) {
 	Thread_StartFunc func = (Thread_StartFunc)param;
 	func();
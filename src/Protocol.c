@@ -93,6 +93,7 @@ static struct CpeExt
 	extTeleport_Ext     = { "ExtEntityTeleport", 1 },
 	lightingMode_Ext    = { "LightingMode", 1 },
 	cinematicGui_Ext   = { "CinematicGui", 1 },
+	regionFill_Ext      = { "CompressedBlockUpdate", 1 },
 	extTextures_Ext     = { "ExtendedTextures", 1 },
 	extBlocks_Ext       = { "ExtendedBlocks", 1 };
 
@@ -103,6 +104,7 @@ static struct CpeExt* cpe_clientExtensions[] = {
 	&blockDefsExt_Ext, &bulkBlockUpdate_Ext, &textColors_Ext, &envMapAspect_Ext, &entityProperty_Ext, &extEntityPos_Ext,
 	&twoWayPing_Ext, &invOrder_Ext, &instantMOTD_Ext, &fastMap_Ext, &setHotbar_Ext, &setSpawnpoint_Ext, &velControl_Ext,
 	&customParticles_Ext, &pluginMessages_Ext, &extTeleport_Ext, &lightingMode_Ext, &cinematicGui_Ext,
+	&regionFill_Ext,
 #ifdef CUSTOM_MODELS
 	&customModels_Ext,
 #endif
@@ -201,15 +203,19 @@ static void CheckName(EntityID id, cc_string* name, cc_string* skin) {
 }
 
 static void Classic_ReadAbsoluteLocation(cc_uint8* data, EntityID id, cc_uint8 flags);
+/* Whether the spawn location of a newly added entity is being read */
+static cc_bool classic_spawning;
 static void AddEntity(cc_uint8* data, EntityID id, const cc_string* name, const cc_string* skin, cc_bool readPosition) {
 	struct LocalPlayer* p = Entities.CurPlayer;
 	struct Entity* e;
 
 	if (id != ENTITIES_SELF_ID) {
+		struct NetPlayer* player;
 		Entities_Remove(id);
-		e = &NetPlayers_List[id].Base;
+		if (!(player = NetPlayers_Get(id))) return;
 
-		NetPlayer_Init((struct NetPlayer*)e);
+		e = &player->Base;
+		NetPlayer_Init(player);
 		Entities.List[id] = e;
 		Event_RaiseInt(&EntityEvents.Added, id);
 	} else {
@@ -219,8 +225,10 @@ static void AddEntity(cc_uint8* data, EntityID id, const cc_string* name, const
 	Entity_SetName(e, name);
 
 	if (!readPosition) return;
+	classic_spawning = true;
 	Classic_ReadAbsoluteLocation(data, id,
 		LU_HAS_POS | LU_HAS_YAW | LU_HAS_PITCH | LU_POS_ABSOLUTE_INSTANT);
+	classic_spawning = false;
 	if (id != ENTITIES_SELF_ID) return;
 
 	p->Spawn      = p->Base.Position;
@@ -230,7 +238,15 @@ static void AddEntity(cc_uint8* data, EntityID id, const cc_string* name, const
 
 static void UpdateLocation(EntityID id, struct LocationUpdate* update) {
 	struct Entity* e = Entities.List[id];
-	if (e) { e->VTABLE->SetLocation(e, update); }
+	if (!e) return;
+
+	/* Other players are often moved many times per tick, so only apply the combined movement */
+	/* (but spawn location must be applied immediately, otherwise entity is at origin until next tick) */
+	if (id != ENTITIES_SELF_ID && !classic_spawning) {
+		Entities_QueueLocation(id, update);
+	} else {
+		e->VTABLE->SetLocation(e, update);
+	}
 }
 
 static void UpdateUserType(struct HacksComp* hacks, cc_uint8 value) {
@@ -391,6 +407,16 @@ static void FreeMapStates(void) {
 #endif
 }
 
+static cc_bool MapState_Alloc(struct MapState* m) {
+	m->blocks = (BlockRaw*)Mem_TryAlloc(map_volume, 1);
+	if (m->blocks) return true;
+
+	/* unlikely but possible */
+	Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
+	m->allocFailed = true;
+	return false;
+}
+
 static cc_result MapState_Read(struct MapState* m) {
 	cc_uint32 left, read;
 	cc_result res;
@@ -409,15 +435,7 @@ static cc_result MapState_Read(struct MapState* m) {
 
 	if (!map_volume) map_volume = Stream_GetU32_BE(m->size);
 
-	if (!m->blocks) {
-		m->blocks = (BlockRaw*)Mem_TryAlloc(map_volume, 1);
-		/* unlikely but possible */
-		if (!m->blocks) {
-			Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
-			m->allocFailed = true;
-			return 0;
-		}
-	}
+	if (!m->blocks && !MapState_Alloc(m)) return 0;
 
 	left = map_volume - m->index;
 	res  = m->stream.Read(&m->stream, &m->blocks[m->index], left, &read);
@@ -555,6 +573,10 @@ static void Classic_LevelInit(cc_uint8* data) {
 #ifdef EXTENDED_BLOCKS
 	MapState_SkipHeader(&map2);
 #endif
+
+	/* Volume is known up front, so blocks can be inflated directly into the final array */
+	/*  as soon as the first chunk arrives (upper blocks array is still only allocated on demand) */
+	if (map_volume) MapState_Alloc(&map1);
 }
 
 static void Classic_LevelDataChunk(cc_uint8* data) {
@@ -978,7 +1000,8 @@ static void CPE_ExtEntry(cc_uint8* data) {
 	struct CpeExt* ext;
 	cc_string name = UNSAFE_GetString(data);
 	int version    = data[67];
-	Platform_Log2("cpe ext: %s, %i", &name, &version);
+	if (Platform_LogEnabled(LOG_CATEGORY_NETWORK, LOG_LEVEL_DEBUG))
+		Platform_Log2("cpe ext: %s, %i", &name, &version);
 
 	cpe_serverExtensionsCount--;
 	CPE_SendCpeExtInfoReply();
@@ -1084,7 +1107,8 @@ static void CPE_SetTextHotkey(cc_uint8* data) {
 	if (keyCode > 255) return;
 	key = Hotkeys_LWJGL[keyCode];
 	if (!key) return;
-	Platform_Log3("CPE hotkey added: %c, %b: %s", Input_DisplayNames[key], &keyMods, &action);
+	if (Platform_LogEnabled(LOG_CATEGORY_NETWORK, LOG_LEVEL_DEBUG))
+		Platform_Log3("CPE hotkey added: %c, %b: %s", Input_DisplayNames[key], &keyMods, &action);
 
 	if (!action.length) {
 		Hotkeys_Remove(key, keyMods);
@@ -1295,6 +1319,106 @@ static void CPE_BulkBlockUpdate(cc_uint8* data) {
 	}
 }
 
+/* Region fills send a deflate compressed run length encoded list of blocks for a cuboid region, */
+/*  which is then applied to the world in a single pass once all of the compressed data has arrived */
+/* Each run is [block (1 byte, or 2 bytes with ExtendedBlocks)][run length - 1 (2 bytes)], in X/Z/Y order */
+#define REGION_FILL_MAX_SIZE (16 * 1024 * 1024)
+static struct RegionFillState {
+	cc_uint8* data;
+	cc_uint32 size, received;
+	IVec3 min, max;
+	struct Stream src, stream;
+	struct InflateState inflate;
+	BlockID runBlock;
+	cc_uint32 runLeft;
+	cc_result res;
+} regionFill;
+
+static void RegionFill_Free(void) {
+	Mem_Free(regionFill.data);
+	regionFill.data = NULL;
+}
+
+static BlockID RegionFill_NextBlock(int x, int y, int z, BlockID cur) {
+	cc_uint8 run[4];
+	int blockSize = IsSupported(extBlocks_Ext) ? 2 : 1;
+
+	if (!regionFill.runLeft) {
+		if (regionFill.res) return cur;
+		regionFill.res = Stream_Read(&regionFill.stream, run, blockSize + 2);
+		if (regionFill.res) return cur;
+
+		regionFill.runBlock = blockSize == 2 ? Stream_GetU16_BE(run) : run[0];
+		regionFill.runLeft  = Stream_GetU16_BE(run + blockSize) + 1;
+	}
+
+	regionFill.runLeft--;
+#ifdef EXTENDED_BLOCKS
+	return regionFill.runBlock % BLOCK_COUNT;
+#else
+	return regionFill.runBlock;
+#endif
+}
+
+static void RegionFill_Apply(void) {
+	IVec3 min = regionFill.min, max = regionFill.max;
+
+	if (max.x >= World.Width || max.y >= World.Height || max.z >= World.Length) {
+		Chat_AddRaw("&cIgnoring region fill that extends outside the map");
+		return;
+	}
+
+	Stream_ReadonlyMemory(&regionFill.src, regionFill.data, regionFill.size);
+	Inflate_MakeStream2(&regionFill.stream, &regionFill.inflate, &regionFill.src);
+	regionFill.runLeft = 0;
+	regionFill.res     = 0;
+
+	Game_UpdateBlocks(min.x, min.y, min.z, max.x, max.y, max.z, RegionFill_NextBlock);
+	if (regionFill.res) Logger_SysWarn(regionFill.res, "decompressing region fill");
+}
+
+static void CPE_RegionFillBegin(cc_uint8* data) {
+	cc_uint32 size;
+	RegionFill_Free();
+
+	regionFill.min.x = Stream_GetU16_BE(data + 0);
+	regionFill.min.y = Stream_GetU16_BE(data + 2);
+	regionFill.min.z = Stream_GetU16_BE(data + 4);
+	regionFill.max.x = Stream_GetU16_BE(data + 6);
+	regionFill.max.y = Stream_GetU16_BE(data + 8);
+	regionFill.max.z = Stream_GetU16_BE(data + 10);
+	size = Stream_GetU32_BE(data + 12);
+
+	if (regionFill.min.x > regionFill.max.x || regionFill.min.y > regionFill.max.y
+		|| regionFill.min.z > regionFill.max.z) return;
+	if (!size || size > REGION_FILL_MAX_SIZE) return;
+
+	regionFill.data = (cc_uint8*)Mem_TryAlloc(size, 1);
+	if (!regionFill.data) {
+		Chat_AddRaw("&cOut of memory for region fill, ignoring it");
+		return;
+	}
+	regionFill.size     = size;
+	regionFill.received = 0;
+}
+
+static void CPE_RegionFillData(cc_uint8* data) {
+	cc_uint32 left;
+	int length = Stream_GetU16_BE(data);
+	if (!regionFill.data) return;
+
+	left   = regionFill.size - regionFill.received;
+	length = min(length, 1024);
+	length = min(length, (int)left);
+
+	Mem_Copy(regionFill.data + regionFill.received, data + 2, length);
+	regionFill.received += length;
+	if (regionFill.received < regionFill.size) return;
+
+	RegionFill_Apply();
+	RegionFill_Free();
+}
+
 static void CPE_SetTextColor(cc_uint8* data) {
 	BitmapCol c   = BitmapCol_Make(data[0], data[1], data[2], data[3]);
 	cc_uint8 code = data[4];
@@ -1581,6 +1705,7 @@ static void CPE_Reset(void) {
 	CPEExtensions_Reset();
 	cpe_needD3Fix = false;
 	Game_UseCPEBlocks = false;
+	RegionFill_Free();
 	if (!Game_Version.HasCPE) return;
 
 	Net_Set(OPCODE_EXT_INFO, CPE_ExtInfo, 67);
@@ -1620,6 +1745,8 @@ static void CPE_Reset(void) {
 	Net_Set(OPCODE_ENTITY_TELEPORT_EXT, CPE_ExtEntityTeleport, 11);
 	Net_Set(OPCODE_LIGHTING_MODE, CPE_LightingMode, 3);
 	Net_Set(OPCODE_CINEMATIC_GUI, CPE_CinematicGui, 10);
+	Net_Set(OPCODE_REGION_FILL_BEGIN, CPE_RegionFillBegin, 17);
+	Net_Set(OPCODE_REGION_FILL_DATA, CPE_RegionFillData, 1027);
 }
 
 static cc_uint8* CPE_Tick(cc_uint8* data) {
@@ -53,7 +53,7 @@ struct ResourceZipEntry {
 #define RESOURCE_TYPE_CONST 3
 #define RESOURCE_TYPE_SOUND 4
 
-static CC_NOINLINE cc_bool Fetcher_Get(int reqID, struct HttpRequest* item);
+static CC_NOINLINE cc_bool Fetcher_Get(int reqID, struct HttpRequest* item, const char* hash);
 CC_NOINLINE static struct ResourceZipEntry* ZipEntries_Find(const cc_string* name);
 static cc_result ZipEntry_ExtractData(struct ResourceZipEntry* e, struct Stream* data, struct ZipEntry* source);
 
@@ -175,7 +175,7 @@ static cc_result ZipWriter_FixupLocalFile(struct Stream* s, struct ResourceZipEn
 	int filenameLen = String_Length(e->filename);
 	cc_uint8 tmp[2048];
 	cc_uint32 dataBeg, dataEnd;
-	cc_uint32 i, crc, toRead, read;
+	cc_uint32 crc, toRead, read;
 	cc_result res;
 
 	dataBeg = e->offset + 30 + filenameLen;
@@ -193,9 +193,7 @@ static cc_result ZipWriter_FixupLocalFile(struct Stream* s, struct ResourceZipEn
 		if ((res = s->Read(s, tmp, toRead, &read))) return res;
 		if (!read) return ERR_END_OF_STREAM;
 
-		for (i = 0; i < read; i++) {
-			crc = Utils_Crc32Table[(crc ^ tmp[i]) & 0xFF] ^ (crc >> 8);
-		}
+		crc = Utils_CRC32Update(crc, tmp, read);
 	}
 	e->crc32 = crc ^ 0xffffffffUL;
 
@@ -265,20 +263,80 @@ static cc_result ZipFile_WriteEntries(struct Stream* s, struct ResourceZipEntry*
 	return ZipWriter_EndOfCentralDir(s, numEntries, beg, end);
 }
 
-static void ZipFile_Create(const cc_string* path, struct ResourceZipEntry* entries, int numEntries) {
+/* Creates a zip file containing the given entries, without logging any errors */
+/* (so that it can be called from worker threads) */
+static cc_result ZipFile_Save(const cc_string* path, struct ResourceZipEntry* entries, int numEntries, const char** action) {
 	struct Stream s;
-	cc_result res;
+	cc_result res, closeRes;
 
-	res = Stream_CreateFile(&s, path);
-	if (res) {
-		Logger_SysWarn2(res, "creating", path); return;
-	}
+	*action = "creating";
+	res     = Stream_CreateFile(&s, path);
+	if (res) return res;
 		
-	res = ZipFile_WriteEntries(&s, entries, numEntries);
-	if (res) Logger_SysWarn2(res, "making", path);
+	*action  = "making";
+	res      = ZipFile_WriteEntries(&s, entries, numEntries);
+	closeRes = s.Close(&s);
+
+	if (!res && closeRes) { *action = "closing"; res = closeRes; }
+	return res;
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Background patching------------------------------------------------*
+*#########################################################################################################################*/
+/* Decoding sounds, patching textures and writing zip files is slow on some devices, */
+/*  so is done on worker threads where supported instead of stalling the launcher */
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_WEB && !defined CC_BUILD_LOWMEM
+#define RESOURCES_THREADED
+#endif
+
+struct PatchJob {
+	void (*Run)(void);    /* Called on the worker thread, must set done to true once finished */
+	void (*Finish)(void); /* Called on the main thread after Run has finished (e.g. to log errors) */
+	void* thread;
+	volatile cc_bool done;
+};
+
+static void PatchJob_Start(struct PatchJob* job) {
+	job->done = false;
+#ifdef RESOURCES_THREADED
+	Thread_Run(&job->thread, job->Run, 128 * 1024, "Resource patcher");
+#else
+	job->Run();
+	job->Finish();
+#endif
+}
+
+static void PatchJob_Complete(struct PatchJob* job) {
+	Thread_Join(job->thread);
+	job->thread = NULL;
+	job->Finish();
+}
 
-	res = s.Close(&s);
-	if (res) Logger_SysWarn2(res, "closing", path);
+/* Returns whether the given job is still running on its worker thread */
+static cc_bool PatchJob_Busy(struct PatchJob* job) {
+	if (!job->thread) return false;
+	if (!job->done)   return true;
+
+	PatchJob_Complete(job);
+	return false;
+}
+
+static void PatchJob_Wait(struct PatchJob* job) {
+	if (job->thread) PatchJob_Complete(job);
+}
+
+static struct PatchJob soundsPatchJob, texturesPatchJob;
+
+static cc_bool Patcher_Busy(void) {
+	cc_bool busy = PatchJob_Busy(&soundsPatchJob);
+	return PatchJob_Busy(&texturesPatchJob) || busy;
+}
+
+static void Patcher_WaitAll(void) {
+	PatchJob_Wait(&soundsPatchJob);
+	PatchJob_Wait(&texturesPatchJob);
 }
 
 
@@ -339,7 +397,7 @@ CC_NOINLINE static int MusicAsset_Download(const char* hash) {
 	String_InitArray(url, urlBuffer);
 	String_Format3(&url, "https://resources.download.minecraft.net/%r%r/%c", 
 					&hash[0], &hash[1], hash);
-	return Http_AsyncGetData(&url, 0);
+	return Http_AsyncGetData(&url, HTTP_FLAG_RESUMABLE);
 }
 
 static void MusicAssets_DownloadAssets(void) {
@@ -377,7 +435,7 @@ static void MusicAsset_Save(const char* name, struct HttpRequest* req) {
 
 static void MusicAsset_Check(struct MusicAsset* music) {
 	struct HttpRequest item;
-	if (!Fetcher_Get(music->reqID, &item)) return;
+	if (!Fetcher_Get(music->reqID, &item, music->hash)) return;
 
 	music->downloaded = true;
 	MusicAsset_Save(music->name, &item);
@@ -416,12 +474,7 @@ static cc_result SoundPatcher_Save(struct Stream* s, struct ResourceZipEntry* e)
 #define WAV_FourCC(a, b, c, d) (((cc_uint32)a << 24) | ((cc_uint32)b << 16) | ((cc_uint32)c << 8) | (cc_uint32)d)
 #define WAV_HDR_SIZE 44
 
-/* Fixes up the .WAV header after having written all samples */
-static cc_result SoundPatcher_FixupHeader(struct Stream* s, struct VorbisState* ctx, cc_uint32 offset, cc_uint32 len) {
-	cc_uint8 header[WAV_HDR_SIZE];
-	cc_result res = s->Seek(s, offset);
-	if (res) return res;
-
+static void SoundPatcher_MakeHeader(cc_uint8* header, struct VorbisState* ctx, cc_uint32 len) {
 	Stream_SetU32_BE(header +  0, WAV_FourCC('R','I','F','F'));
 	Stream_SetU32_LE(header +  4, len - 8);
 	Stream_SetU32_BE(header +  8, WAV_FourCC('W','A','V','E'));
@@ -436,7 +489,15 @@ static cc_result SoundPatcher_FixupHeader(struct Stream* s, struct VorbisState*
 	Stream_SetU16_LE(header + 34, 16);                                  /* bits per sample */
 	Stream_SetU32_BE(header + 36, WAV_FourCC('d','a','t','a'));
 	Stream_SetU32_LE(header + 40, len - WAV_HDR_SIZE);
+}
+
+/* Fixes up the .WAV header after having written all samples */
+static cc_result SoundPatcher_FixupHeader(struct Stream* s, struct VorbisState* ctx, cc_uint32 offset, cc_uint32 len) {
+	cc_uint8 header[WAV_HDR_SIZE];
+	cc_result res = s->Seek(s, offset);
+	if (res) return res;
 
+	SoundPatcher_MakeHeader(header, ctx, len);
 	return Stream_Write(s, header, WAV_HDR_SIZE);
 }
 
@@ -508,6 +569,66 @@ cleanup:
 	return res;
 }
 
+#ifdef RESOURCES_THREADED
+/* Decodes an OGG sound into a .WAV file in memory */
+static cc_result SoundPatcher_Decode(void* data, cc_uint32 size, cc_uint8** wav, cc_uint32* wavSize) {
+	struct OggState* ogg    = NULL;
+	struct VorbisState* ctx = NULL;
+	cc_uint8* buffer = NULL;
+	cc_uint8* tmp;
+	cc_uint32 len = WAV_HDR_SIZE, capacity = 0, maxFrameSize;
+	struct Stream src;
+	cc_result res;
+	int count;
+
+	ogg = (struct OggState*)Mem_TryAlloc(1,    sizeof(struct OggState));
+	if (!ogg) { res = ERR_OUT_OF_MEMORY; goto cleanup; }
+
+	ctx = (struct VorbisState*)Mem_TryAlloc(1, sizeof(struct VorbisState));
+	if (!ctx) { res = ERR_OUT_OF_MEMORY; goto cleanup; }
+
+	Stream_ReadonlyMemory(&src, data, size);
+	Ogg_Init(ogg, &src);
+	Vorbis_Init(ctx);
+	ctx->source = ogg;
+
+	if ((res = Vorbis_DecodeHeaders(ctx))) goto cleanup;
+	maxFrameSize = ctx->blockSizes[1] * ctx->channels * 2;
+
+	for (;;) {
+		if (len + maxFrameSize > capacity) {
+			capacity = max(capacity * 2, len + maxFrameSize + 64 * 1024);
+			tmp      = (cc_uint8*)(buffer ? Mem_TryRealloc(buffer, capacity, 1) : Mem_TryAlloc(capacity, 1));
+
+			if (!tmp) { res = ERR_OUT_OF_MEMORY; goto cleanup; }
+			buffer = tmp;
+		}
+
+		res = Vorbis_DecodeFrame(ctx);
+		if (res == ERR_END_OF_STREAM) { res = 0; break; }
+		if (res) goto cleanup;
+
+		count = Vorbis_OutputFrame(ctx, (cc_int16*)(buffer + len));
+#ifdef CC_BUILD_BIGENDIAN
+		Utils_SwapEndian16((cc_int16*)(buffer + len), count);
+#endif
+		len += count * 2;
+	}
+
+	SoundPatcher_MakeHeader(buffer, ctx, len);
+	*wav     = buffer;
+	*wavSize = len;
+	buffer   = NULL;
+
+cleanup:
+	Mem_Free(buffer);
+	if (ctx) Vorbis_Free(ctx);
+	Mem_Free(ctx);
+	Mem_Free(ogg);
+	return res;
+}
+#endif
+
 
 /*########################################################################################################################*
 *---------------------------------------------------------Sound assets----------------------------------------------------*
@@ -517,6 +638,10 @@ static struct SoundAsset {
 	const char* hash;
 	int reqID, size;
 	void* data;
+	/* Decoded .WAV file (only for the first sound with a given hash) */
+	cc_uint8* wav;
+	cc_uint32 wavSize;
+	cc_result result;
 } soundAssets[] = {
 	{ "dig_cloth1.wav",  "5fd568d724ba7d53911b6cccf5636f859d2662e8" }, { "dig_cloth2.wav",  "56c1d0ac0de2265018b2c41cb571cc6631101484" },
 	{ "dig_cloth3.wav",  "9c63f2a3681832dc32d206f6830360bfe94b5bfc" }, { "dig_cloth4.wav",  "55da1856e77cfd31a7e8c3d358e1f856c5583198" },
@@ -561,6 +686,11 @@ static void SoundAssets_ResetState(void) {
 		Mem_Free(soundAssets[i].data);
 		soundAssets[i].data = NULL;
 		soundAssets[i].size = 0;
+
+		Mem_Free(soundAssets[i].wav);
+		soundAssets[i].wav     = NULL;
+		soundAssets[i].wavSize = 0;
+		soundAssets[i].result  = 0;
 	}
 }
 
@@ -609,6 +739,100 @@ static void SoundAssets_CountMissing(void) {
 /*########################################################################################################################*
 *----------------------------------------------------Sound asset generation ----------------------------------------------*
 *#########################################################################################################################*/
+#ifdef RESOURCES_THREADED
+#define SOUND_PATCH_WORKERS 4
+static void* soundsMutex;
+static int soundsNext;
+static const char* soundsZipAction;
+static cc_result soundsZipResult;
+
+/* Dig and step sounds often share the same source file, which only needs to be decoded once */
+static int SoundAsset_FindOriginal(int i) {
+	cc_string hash = String_FromReadonly(soundAssets[i].hash);
+	int j;
+
+	for (j = 0; j < i; j++) 
+	{
+		if (String_CaselessEqualsConst(&hash, soundAssets[j].hash)) return j;
+	}
+	return i;
+}
+
+static void SoundAssets_DecodeWorker(void) {
+	struct SoundAsset* a;
+	int i;
+
+	for (;;) {
+		Mutex_Lock(soundsMutex);
+		i = soundsNext++;
+		Mutex_Unlock(soundsMutex);
+
+		if (i >= Array_Elems(soundAssets)) return;
+		if (SoundAsset_FindOriginal(i) != i) continue;
+
+		a = &soundAssets[i];
+		a->result = SoundPatcher_Decode(a->data, a->size, &a->wav, &a->wavSize);
+	}
+}
+
+/* Decodes all the sounds across several threads, then writes out the sounds zip */
+static void SoundAssets_RunPatcher(void) {
+	struct ResourceZipEntry entries[Array_Elems(soundAssets)];
+	void* workers[SOUND_PATCH_WORKERS - 1];
+	struct SoundAsset* a;
+	cc_result res = 0;
+	int i;
+
+	soundsNext = 0;
+	for (i = 0; i < SOUND_PATCH_WORKERS - 1; i++) 
+	{
+		Thread_Run(&workers[i], SoundAssets_DecodeWorker, 128 * 1024, "Sound patcher");
+	}
+	SoundAssets_DecodeWorker();
+	for (i = 0; i < SOUND_PATCH_WORKERS - 1; i++) 
+	{
+		Thread_Join(workers[i]);
+	}
+
+	for (i = 0; i < Array_Elems(soundAssets); i++)
+	{
+		a = &soundAssets[SoundAsset_FindOriginal(i)];
+		if (a->result && !res) res = a->result;
+
+		entries[i].filename   = soundAssets[i].filename;
+		entries[i].type       = RESOURCE_TYPE_DATA;
+		entries[i].value.data = a->wav;
+		entries[i].size       = a->wavSize;
+	}
+
+	if (res) {
+		soundsZipResult = res;
+		soundsZipAction = "making";
+	} else {
+		soundsZipResult = ZipFile_Save(&Sounds_ZipPathMC, entries, Array_Elems(soundAssets), &soundsZipAction);
+	}
+	soundsPatchJob.done = true;
+}
+
+static void SoundAssets_FinishPatcher(void) {
+	if (soundsZipResult) Logger_SysWarn2(soundsZipResult, soundsZipAction, &Sounds_ZipPathMC);
+	SoundAssets_ResetState();
+}
+
+static void SoundAsset_CreateZip(void) {
+	if (!soundsMutex) soundsMutex = Mutex_Create("Sound patcher");
+
+	soundsPatchJob.Run    = SoundAssets_RunPatcher;
+	soundsPatchJob.Finish = SoundAssets_FinishPatcher;
+	PatchJob_Start(&soundsPatchJob);
+}
+#else
+static void ZipFile_Create(const cc_string* path, struct ResourceZipEntry* entries, int numEntries) {
+	const char* action;
+	cc_result res = ZipFile_Save(path, entries, numEntries, &action);
+	if (res) Logger_SysWarn2(res, action, path);
+}
+
 static void SoundAsset_CreateZip(void) {
 	struct ResourceZipEntry entries[Array_Elems(soundAssets)];
 	int i;
@@ -625,6 +849,7 @@ static void SoundAsset_CreateZip(void) {
 	ZipFile_Create(&Sounds_ZipPathMC, entries, Array_Elems(soundAssets));
 	SoundAssets_ResetState();
 }
+#endif
 
 
 /*########################################################################################################################*
@@ -632,8 +857,12 @@ static void SoundAsset_CreateZip(void) {
 *#########################################################################################################################*/
 #define SoundAsset_Download(hash) MusicAsset_Download(hash)
 
+static int soundsDownloaded;
+
 static void SoundAssets_DownloadAssets(void) {
 	int i;
+	soundsDownloaded = 0;
+
 	for (i = 0; i < Array_Elems(soundAssets); i++)
 	{
 		if (allSoundsExist) continue;
@@ -652,14 +881,14 @@ static const char* SoundAssets_GetRequestName(int reqID) {
 
 static void SoundAsset_Check(struct SoundAsset* sound, int i) {
 	struct HttpRequest item;
-	if (!Fetcher_Get(sound->reqID, &item)) return;
+	if (!Fetcher_Get(sound->reqID, &item, sound->hash)) return;
 
 	sound->data = item.data;
 	sound->size = item.size;
 	item.data   = NULL;
 	HttpRequest_Free(&item);
 
-	if (i == Array_Elems(soundAssets) - 1)
+	if (++soundsDownloaded == Array_Elems(soundAssets))
 		SoundAsset_CreateZip();
 }
 
@@ -712,7 +941,7 @@ static void CCTextures_DownloadAssets(void) {
 	static cc_string url = String_FromConst(RESOURCE_SERVER "/default.zip");
 	if (ccTexturesExist) return;
 
-	ccTexturesReqID = Http_AsyncGetData(&url, 0);
+	ccTexturesReqID = Http_AsyncGetData(&url, HTTP_FLAG_RESUMABLE);
 }
 
 static const char* CCTextures_GetRequestName(int reqID) {
@@ -753,7 +982,7 @@ static void CCTextures_CheckStatus(void) {
 	cc_result res;
 
 	if (ccTexturesDownloaded) return;
-	if (!Fetcher_Get(ccTexturesReqID, &item)) return;
+	if (!Fetcher_Get(ccTexturesReqID, &item, NULL)) return;
 
 	ccTexturesDownloaded = true;
 	res = CCTextures_ExtractZip(&item);
@@ -850,6 +1079,9 @@ struct ZipfileSource {
 	short size;
 	cc_bool downloaded;
 	int reqID;
+	/* Downloaded contents, kept until processed by the patcher */
+	struct HttpRequest item;
+	cc_result result;
 };
 
 #define DEFAULTZIP_0030_ENTRIES_COUNT 4
@@ -865,10 +1097,14 @@ static struct ZipfileSource defaultZipSources_0030_0023[] = {
 	{ "0.0.23 gray",  "https://classic.minecraft.net/assets/textures/color14.png",   Classic0023Patcher_OldGrayWool,  1 },
 };
 static struct ZipfileSource* defaultZipSources;
-static int numDefaultZipSources, numDefaultZipProcessed;
+static int numDefaultZipSources, numDefaultZipDownloaded;
 
 static void MCCTextures_ResetState(void) {
 	int i;
+	for (i = 0; i < numDefaultZipSources; i++) 
+	{
+		HttpRequest_Free(&defaultZipSources[i].item);
+	}
 	for (i = 0; i < Array_Elems(defaultZipEntries); i++) 
 	{
 		if (defaultZipEntries[i].type == RESOURCE_TYPE_CONST) continue;
@@ -976,27 +1212,26 @@ static cc_bool ModernPatcher_SelectEntry(const cc_string* path) {
 		ModernPatcher_GetTile(path) != NULL;
 }
 
+/* Each 16x16 frame down the fire strip becomes the next frame across animations.png */
+static BitmapCol* ModernPatcher_GetFireRow(struct Bitmap* bmp, int row, void* ctx) {
+	struct Bitmap* anim = (struct Bitmap*)ctx;
+	if (bmp->width != 16 || row >= 512) return NULL;
+
+	return Bitmap_GetRow(anim, row & 15) + (row & ~15);
+}
+
 static cc_result ModernPatcher_MakeAnimations(struct Stream* data) {
 	static const cc_string animsPng = String_FromConst("animations.png");
 	struct ResourceZipEntry* entry;
 	struct Bitmap* anim;
 	struct Bitmap bmp;
-	cc_result res;
-	int i;
 
 	entry = ZipEntries_Find(&animsPng);
 	anim  = &entry->value.bmp;
 	Bitmap_TryAllocate(anim, 512, 16);
 
 	if (!anim->scan0) return ERR_OUT_OF_MEMORY;
-	if ((res = Png_Decode(&bmp, data))) return res;
-
-	for (i = 0; i < 512; i += 16) {
-		Bitmap_UNSAFE_CopyBlock(0, i, i, 0, &bmp, anim, 16);
-	}
-
-	Mem_Free(bmp.scan0); 
-	return 0;
+	return Png_DecodeRows(&bmp, data, ModernPatcher_GetFireRow, anim);
 }
 
 static cc_result ModernPatcher_ProcessEntry(const cc_string* path, struct Stream* data, struct ZipEntry* source) {
@@ -1159,12 +1394,12 @@ static void MCCTextures_DownloadAssets(void) {
 	cc_string url;
 	int i;
 	if (allZipEntriesExist) return;
-	numDefaultZipProcessed = 0;
+	numDefaultZipDownloaded = 0;
 
 	for (i = 0; i < numDefaultZipSources; i++)
 	{
 		url = String_FromReadonly(defaultZipSources[i].url);
-		defaultZipSources[i].reqID = Http_AsyncGetData(&url, 0);
+		defaultZipSources[i].reqID = Http_AsyncGetData(&url, HTTP_FLAG_RESUMABLE);
 		defaultZipSources[i].downloaded = false;
 	}
 }
@@ -1182,28 +1417,51 @@ static const char* MCCTextures_GetRequestName(int reqID) {
 /*########################################################################################################################*
 *------------------------------------------Minecraft Classic texture assets processing -----------------------------------*
 *#########################################################################################################################*/
-static void MCCTextures_CreateDefaultZip(void) {
+static const char* texturesZipAction;
+static cc_result texturesZipResult;
+
+/* Patches all the downloaded sources into default.zip entries, then writes out default.zip */
+static void MCCTextures_RunPatcher(void) {
 	cc_string path = String_FromReadonly(Game_Version.DefaultTexpack);
-	ZipFile_Create(&path, defaultZipEntries, Array_Elems(defaultZipEntries));
+	struct ZipfileSource* source;
+	int i;
+
+	for (i = 0; i < numDefaultZipSources; i++) 
+	{
+		source = &defaultZipSources[i];
+		source->result = source->Process(&source->item);
+		HttpRequest_Free(&source->item);
+	}
+
+	texturesZipResult = ZipFile_Save(&path, defaultZipEntries, Array_Elems(defaultZipEntries), &texturesZipAction);
+	texturesPatchJob.done = true;
+}
+
+static void MCCTextures_FinishPatcher(void) {
+	cc_string path = String_FromReadonly(Game_Version.DefaultTexpack);
+	cc_string name;
+	int i;
+
+	for (i = 0; i < numDefaultZipSources; i++) 
+	{
+		if (!defaultZipSources[i].result) continue;
+		name = String_FromReadonly(defaultZipSources[i].name);
+		Logger_SysWarn2(defaultZipSources[i].result, "making", &name);
+	}
+
+	if (texturesZipResult) Logger_SysWarn2(texturesZipResult, texturesZipAction, &path);
 	MCCTextures_ResetState();
 }
 
 static void MCCTextures_CheckSource(struct ZipfileSource* source) {
-	struct HttpRequest item;
-	cc_result res;
-	if (!Fetcher_Get(source->reqID, &item)) return;
-	
+	if (!Fetcher_Get(source->reqID, &source->item, NULL)) return;
 	source->downloaded = true;
-	res = source->Process(&item);
 
-	if (res) {
-		cc_string name = String_FromReadonly(source->name);
-		Logger_SysWarn2(res, "making", &name);
-	}
-	HttpRequest_Free(&item);
-
-	if (++numDefaultZipProcessed < numDefaultZipSources) return;
-	MCCTextures_CreateDefaultZip();
+	/* Sources are patched together, as they all modify the same default.zip entries */
+	if (++numDefaultZipDownloaded < numDefaultZipSources) return;
+	texturesPatchJob.Run    = MCCTextures_RunPatcher;
+	texturesPatchJob.Finish = MCCTextures_FinishPatcher;
+	PatchJob_Start(&texturesPatchJob);
 }
 
 static void MCCTextures_CheckStatus(void) {
@@ -1295,6 +1553,7 @@ void Fetcher_Run(void) {
 }
 
 static void Fetcher_Finish(void) {
+	Patcher_WaitAll();
 	Fetcher_Completed = true;
 	Fetcher_Working   = false;
 	ResetState();
@@ -1308,9 +1567,30 @@ static void Fetcher_Fail(struct HttpRequest* item) {
 	Fetcher_Failed = true;
 }
 
-CC_NOINLINE static cc_bool Fetcher_Get(int reqID, struct HttpRequest* item) {
+/* Checks whether the downloaded data has the given SHA-1 hash (as a lowercase hex string) */
+static cc_bool Fetcher_CheckHash(struct HttpRequest* item, const char* hash) {
+	static const char hexDigits[] = "0123456789abcdef";
+	cc_uint8 digest[20];
+	int i;
+	Utils_SHA1(item->data, item->size, digest);
+
+	for (i = 0; i < 20; i++)
+	{
+		if (hash[i * 2 + 0] != hexDigits[digest[i] >> 4])  return false;
+		if (hash[i * 2 + 1] != hexDigits[digest[i] & 0xF]) return false;
+	}
+	return true;
+}
+
+CC_NOINLINE static cc_bool Fetcher_Get(int reqID, struct HttpRequest* item, const char* hash) {
 	if (!Http_GetResult(reqID, item)) return false;
 
+	/* Resumed downloads are pieced together, so also check the combined data wasn't corrupted */
+	if (item->success && hash && !Fetcher_CheckHash(item, hash)) {
+		item->success = false;
+		item->result  = ERR_HASH_MISMATCH;
+	}
+
 	if (item->success) {
 		Fetcher_Downloaded++;
 		return true;
@@ -1333,6 +1613,7 @@ void Fetcher_Update(void) {
 	}
 
 	if (Fetcher_Downloaded != Resources_MissingCount) return; 
+	if (Patcher_Busy()) return;
 	Fetcher_Finish();
 }
 #endif
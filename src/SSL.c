@@ -406,6 +406,9 @@ cc_result SSL_Free(void* ctx_) {
 }
 #elif CC_SSL_BACKEND == CC_SSL_BACKEND_BEARSSL
 #include "String.h"
+#include "Constants.h"
+#include "Funcs.h"
+#include "Platform.h"
 #include "bearssl.h"
 #include "../misc/certs/certs.h"
 // https://github.com/unkaktus/bearssl/blob/master/samples/client_basic.c#L283
@@ -425,13 +428,68 @@ typedef struct SSLContext {
 	br_sslio_context ioc;
 	cc_result readError, writeError;
 	cc_socket socket;
+	cc_string host;
+	char hostBuffer[STRING_SIZE];
+	cc_bool savedSession;
 } SSLContext;
 
 static cc_bool _verifyCerts;
 
 
+/*########################################################################################################################*
+*------------------------------------------------------Session cache------------------------------------------------------*
+*#########################################################################################################################*/
+/* Parameters of recent sessions, so later connections to the same host can skip most of the handshake */
+static struct SessionCacheEntry {
+	char host[STRING_SIZE + 1];
+	br_ssl_session_parameters params;
+} session_cache[8];
+static int session_next;
+static void* session_mutex;
+
+/* NOTE: Must be called with session_mutex held */
+static struct SessionCacheEntry* SessionCache_Get(const cc_string* host) {
+	int i;
+	for (i = 0; i < Array_Elems(session_cache); i++)
+	{
+		if (String_CaselessEqualsConst(host, session_cache[i].host)) return &session_cache[i];
+	}
+	return NULL;
+}
+
+static cc_bool SessionCache_Find(const cc_string* host, br_ssl_session_parameters* params) {
+	struct SessionCacheEntry* e;
+
+	Mutex_Lock(session_mutex);
+	{
+		e = SessionCache_Get(host);
+		if (e) *params = e->params;
+	}
+	Mutex_Unlock(session_mutex);
+	return e != NULL;
+}
+
+static void SessionCache_Save(const cc_string* host, const br_ssl_session_parameters* params) {
+	struct SessionCacheEntry* e;
+
+	Mutex_Lock(session_mutex);
+	{
+		e = SessionCache_Get(host);
+		/* Replace oldest entry */
+		if (!e) {
+			e = &session_cache[session_next];
+			session_next = (session_next + 1) % Array_Elems(session_cache);
+			String_CopyToRawArray(e->host, host);
+		}
+		e->params = *params;
+	}
+	Mutex_Unlock(session_mutex);
+}
+
+
 void SSLBackend_Init(cc_bool verifyCerts) {
-	_verifyCerts = verifyCerts; // TODO support
+	_verifyCerts  = verifyCerts; // TODO support
+	session_mutex = Mutex_Create("SSL sessions");
 }
 
 cc_bool SSLBackend_DescribeError(cc_result res, cc_string* dst) {
@@ -501,6 +559,7 @@ static int sock_write(void* ctx_, const unsigned char* buf, size_t len) {
 }
 
 cc_result SSL_Init(cc_socket socket, const cc_string* host_, void** out_ctx) {
+	br_ssl_session_parameters params;
 	SSLContext* ctx;
 	char host[NATIVE_STR_LEN];
 	String_EncodeUtf8(host, host_);
@@ -514,8 +573,18 @@ cc_result SSL_Init(cc_socket socket, const cc_string* host_, void** out_ctx) {
 	SetCurrentTime(ctx);
 	ctx->socket = socket;
 
+	String_InitArray(ctx->host, ctx->hostBuffer);
+	String_Copy(&ctx->host, host_);
+	ctx->savedSession = false;
+
 	br_ssl_engine_set_buffer(&ctx->sc.eng, ctx->iobuf, sizeof(ctx->iobuf), 1);
-	br_ssl_client_reset(&ctx->sc, host, 0);
+	/* Try to resume the last session with this host, which avoids the expensive key exchange */
+	if (SessionCache_Find(host_, &params)) {
+		br_ssl_engine_set_session_parameters(&ctx->sc.eng, &params);
+		br_ssl_client_reset(&ctx->sc, host, 1);
+	} else {
+		br_ssl_client_reset(&ctx->sc, host, 0);
+	}
 	
 	/* Account login must be done over TLS 1.2 */
 	if (String_CaselessEqualsConst(host_, "www.classicube.net")) {
@@ -542,6 +611,7 @@ cc_result SSL_Init(cc_socket socket, const cc_string* host_, void** out_ctx) {
 
 cc_result SSL_Read(void* ctx_, cc_uint8* data, cc_uint32 count, cc_uint32* read) { 
 	SSLContext* ctx = (SSLContext*)ctx_;
+	br_ssl_session_parameters params;
 	// TODO: just br_sslio_write ??
 	int res = br_sslio_read(&ctx->ioc, data, count);
 	int err;
@@ -559,6 +629,13 @@ cc_result SSL_Read(void* ctx_, cc_uint8* data, cc_uint32 count, cc_uint32* read)
 	
 	br_sslio_flush(&ctx->ioc);
 	*read = res;
+
+	/* Handshake must have completed by the time any data is received */
+	if (!ctx->savedSession) {
+		br_ssl_engine_get_session_parameters(&ctx->sc.eng, &params);
+		if (params.session_id_len) SessionCache_Save(&ctx->host, &params);
+		ctx->savedSession = true;
+	}
 	return 0;
 }
 
@@ -70,21 +70,41 @@ static struct HUDScreen {
 	Screen_Body
 	struct FontDesc font;
 	struct TextWidget line1, line2;
-	struct TextAtlas posAtlas;
+	struct TextAtlas textAtlas;
 	float accumulator;
-	int frames, posCount;
+	int frames, posCount, line1Count;
+	cc_string line1Text;
 	cc_bool hacksChanged;
 	float lastSpeed;
 	int lastFov;
 	int lastX, lastY, lastZ;
 	struct HotbarWidget hotbar;
+	char line1Buffer[STRING_SIZE * 2];
 } HUDScreen_Instance;
 
 /* Each integer can be at most 10 digits + minus prefix */
 #define POSITION_VAL_CHARS 11
 /* [PREFIX] [(] [X] [,] [Y] [,] [Z] [)] */
-#define POSITION_HUD_CHARS (1 + 1 + POSITION_VAL_CHARS + 1 + POSITION_VAL_CHARS + 1 + POSITION_VAL_CHARS + 1)
-#define HUD_MAX_VERTICES (4 + TEXTWIDGET_MAX * 2 + HOTBAR_MAX_VERTICES + POSITION_HUD_CHARS * 4)
+#define POSITION_PREFIX_CHARS 10
+/* [PREFIX] [(] [X] [,] [Y] [,] [Z] [)] */
+#define POSITION_HUD_CHARS (POSITION_PREFIX_CHARS + 1 + POSITION_VAL_CHARS + 1 + POSITION_VAL_CHARS + 1 + POSITION_VAL_CHARS + 1)
+#define LINE1_HUD_CHARS    (STRING_SIZE * 2)
+
+/* Vertex layout: [crosshair] [line2] [hotbar] [position] [line1] */
+#define HUD_POSITION_OFFSET (8 + HOTBAR_MAX_VERTICES)
+#define HUD_LINE1_OFFSET    (HUD_POSITION_OFFSET + POSITION_HUD_CHARS * 4)
+#define HUD_MAX_VERTICES    (HUD_LINE1_OFFSET + LINE1_HUD_CHARS * 4)
+
+/* Status lines which change frequently are drawn from a glyph atlas instead, */
+/*  which avoids having to rasterise and upload a new texture for every change */
+static void HUDScreen_SetLine1(struct HUDScreen* s, const cc_string* text) {
+	s->line1Text.length = 0;
+	String_AppendString(&s->line1Text, text);
+
+	s->line1.width  = TextAtlas_TextWidth(&s->textAtlas, text);
+	s->line1.height = s->textAtlas.tex.height;
+	Widget_Layout(&s->line1);
+}
 
 static void HUDScreen_RemakeLine1(struct HUDScreen* s) {
 	cc_string status; char statusBuffer[STRING_SIZE * 2];
@@ -92,8 +112,8 @@ static void HUDScreen_RemakeLine1(struct HUDScreen* s) {
 	float real_fps;
 
 	String_InitArray(status, statusBuffer);
-	/* Don't remake texture when FPS isn't being shown */
-	if (!Gui.ShowFPS && s->line1.tex.ID) return;
+	/* Don't remake text when FPS isn't being shown */
+	if (!Gui.ShowFPS && s->line1.height) return;
 	fps = s->accumulator == 0 ? 1 : (int)(s->frames / s->accumulator);
 
 	if (Gfx.ReducedPerfMode || (Gfx.ReducedPerfModeCooldown > 0)) {
@@ -120,33 +140,33 @@ static void HUDScreen_RemakeLine1(struct HUDScreen* s) {
 		ping = Ping_AveragePingMS();
 		if (ping) String_Format1(&status, ", ping %i ms", &ping);
 	}
-	TextWidget_Set(&s->line1, &status, &s->font);
+	HUDScreen_SetLine1(s, &status);
 	s->dirty = true;
 }
 
+static void HUDScreen_BuildLine1(struct HUDScreen* s, struct VertexTextured* data) {
+	struct VertexTextured* cur = data;
+	struct TextAtlas* atlas    = &s->textAtlas;
+
+	atlas->tex.y = s->line1.y;
+	atlas->curX  = s->line1.x;
+	TextAtlas_AddString(atlas, &s->line1Text, &cur);
+	s->line1Count = (int)(cur - data);
+}
+
 static void HUDScreen_BuildPosition(struct HUDScreen* s, struct VertexTextured* data) {
+	cc_string str; char strBuffer[POSITION_HUD_CHARS];
 	struct VertexTextured* cur = data;
-	struct TextAtlas* atlas = &s->posAtlas;
-	struct Texture tex;
+	struct TextAtlas* atlas    = &s->textAtlas;
 	IVec3 pos;
 
-	/* Make "Position: " prefix */
-	tex = atlas->tex; 
-	tex.x     = 2 + DisplayInfo.ContentOffsetX;
-	tex.width = atlas->offset;
-	Gfx_Make2DQuad(&tex, PACKEDCOL_WHITE, &cur);
-
 	IVec3_Floor(&pos, &Entities.CurPlayer->Base.Position);
-	atlas->curX = tex.x + tex.width;
+	String_InitArray(str, strBuffer);
+	String_Format3(&str, "Position: (%i,%i,%i)", &pos.x, &pos.y, &pos.z);
 
-	/* Make (X, Y, Z) suffix */
-	TextAtlas_Add(atlas,       13, &cur);
-	TextAtlas_AddInt(atlas, pos.x, &cur);
-	TextAtlas_Add(atlas,       11, &cur);
-	TextAtlas_AddInt(atlas, pos.y, &cur);
-	TextAtlas_Add(atlas,       11, &cur);
-	TextAtlas_AddInt(atlas, pos.z, &cur);
-	TextAtlas_Add(atlas,       14, &cur);
+	atlas->tex.y = s->line1.y + s->line1.height;
+	atlas->curX  = 2 + DisplayInfo.ContentOffsetX;
+	TextAtlas_AddString(atlas, &str, &cur);
 
 	s->lastX = pos.x;
 	s->lastY = pos.y;
@@ -194,16 +214,13 @@ static void HUDScreen_ContextLost(void* screen) {
 	Font_Free(&s->font);
 	Screen_ContextLost(screen);
 
-	TextAtlas_Free(&s->posAtlas);
+	TextAtlas_Free(&s->textAtlas);
 	Elem_Free(&s->hotbar);
 	Elem_Free(&s->line1);
 	Elem_Free(&s->line2);
 }
 
 static void HUDScreen_ContextRecreated(void* screen) {	
-	static const cc_string chars  = String_FromConst("0123456789-, ()");
-	static const cc_string prefix = String_FromConst("Position: ");
-
 	struct HUDScreen* s = (struct HUDScreen*)screen;
 	Screen_UpdateVb(s);
 
@@ -211,8 +228,9 @@ static void HUDScreen_ContextRecreated(void* screen) {
 	Font_SetPadding(&s->font, 2);
 	HotbarWidget_SetFont(&s->hotbar, &s->font);
 
+	TextAtlas_MakeGlyphs(&s->textAtlas, &s->font);
+	s->line1.height = 0;
 	HUDScreen_RemakeLine1(s);
-	TextAtlas_Make(&s->posAtlas, &chars, &s->font, &prefix);
 	HUDScreen_RemakeLine2(s);
 }
 
@@ -232,7 +250,6 @@ static void HUDScreen_Layout(void* screen) {
 	Widget_SetLocation(line1, ANCHOR_MIN, ANCHOR_MIN, 
 						2 + DisplayInfo.ContentOffsetX, 2 + DisplayInfo.ContentOffsetY);
 	posY = line1->y + line1->height;
-	s->posAtlas.tex.y = posY;
 	Widget_SetLocation(line2, ANCHOR_MIN, ANCHOR_MIN, 
 						2 + DisplayInfo.ContentOffsetX, 0);
 
@@ -243,7 +260,7 @@ static void HUDScreen_Layout(void* screen) {
 		Widget_Layout(line1);
 	} else {
 		/* We can't use y in TextWidget_Make because that DPI scales it */
-		line2->yOffset = posY + s->posAtlas.tex.height;
+		line2->yOffset = posY + s->textAtlas.tex.height;
 	}
 
 	HUDScreen_LayoutHotbar();
@@ -307,6 +324,7 @@ static void HUDScreen_Init(void* screen) {
 	HotbarWidget_Create(&s->hotbar);
 	TextWidget_Init(&s->line1);
 	TextWidget_Init(&s->line2);
+	String_InitArray(s->line1Text, s->line1Buffer);
 	
 	s->line1.flags  |= WIDGET_FLAG_MAINSCREEN;
 	s->line2.flags  |= WIDGET_FLAG_MAINSCREEN;
@@ -368,19 +386,22 @@ static void HUDScreen_BuildCrosshairsMesh(struct VertexTextured** ptr) {
 
 static void HUDScreen_BuildMesh(void* screen) {
 	struct HUDScreen* s = (struct HUDScreen*)screen;
+	struct VertexTextured* base;
 	struct VertexTextured* data;
 	struct VertexTextured** ptr;
 
-	data = Screen_LockVb(s);
+	base = Screen_LockVb(s);
+	data = base;
 	ptr  = &data;
 
 	HUDScreen_BuildCrosshairsMesh(ptr);
-	Widget_BuildMesh(&s->line1,  ptr);
 	Widget_BuildMesh(&s->line2,  ptr);
 	Widget_BuildMesh(&s->hotbar, ptr);
 
+	data = base + HUD_POSITION_OFFSET;
 	if (!Game_ClassicMode) 
 		HUDScreen_BuildPosition(s, data);
+	HUDScreen_BuildLine1(s, base + HUD_LINE1_OFFSET);
 	Gfx_UnlockDynamicVb(s->vb);
 }
 
@@ -392,20 +413,23 @@ static void HUDScreen_Render(void* screen, float delta) {
 
 	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
 	Gfx_BindDynamicVb(s->vb);
-	if (Gui.ShowFPS) Widget_Render2(&s->line1, 4);
+	if (Gui.ShowFPS && s->line1Count) {
+		Gfx_BindTexture(s->textAtlas.tex.ID);
+		Gfx_DrawVb_IndexedTris_Range(s->line1Count, HUD_LINE1_OFFSET);
+	}
 
 	if (Game_ClassicMode) {
-		Widget_Render2(&s->line2, 8);
+		Widget_Render2(&s->line2, 4);
 	} else if (IsOnlyChatActive() && Gui.ShowFPS) {
-		Widget_Render2(&s->line2, 8);
-		Gfx_BindTexture(s->posAtlas.tex.ID);
-		Gfx_DrawVb_IndexedTris_Range(s->posCount, 12 + HOTBAR_MAX_VERTICES);
+		Widget_Render2(&s->line2, 4);
+		Gfx_BindTexture(s->textAtlas.tex.ID);
+		Gfx_DrawVb_IndexedTris_Range(s->posCount, HUD_POSITION_OFFSET);
 		/* TODO swap these two lines back */
 	}
 
 	if (!Gui_GetBlocksWorld()) {
 		Gfx_BindDynamicVb(s->vb);
-		if (!Gui.HideHotbar) Widget_Render2(&s->hotbar, 12);
+		if (!Gui.HideHotbar) Widget_Render2(&s->hotbar, 8);
 
 		if (!Gui.HideCrosshair && Gui.IconsTex && !tablist_active) {
 			Gfx_BindTexture(Gui.IconsTex);
@@ -701,10 +725,78 @@ static void TabListOverlay_SortAndLayout(struct TabListOverlay* s) {
 	s->dirty = true;
 }
 
+/* Moves all entries from index onwards down by one, leaving an empty slot at index */
+static void TabListOverlay_OpenSlot(struct TabListOverlay* s, int index) {
+	int i;
+	for (i = s->usedCount; i > index; i--) 
+	{
+		s->ids[i]      = s->ids[i - 1];
+		s->textures[i] = s->textures[i - 1];
+	}
+	s->usedCount++;
+}
+
+/* Returns the index in [beg, end) that the given player should be inserted at to keep entries sorted */
+static int TabListOverlay_FindPlayerSlot(struct TabListOverlay* s, int id, int beg, int end) {
+	int mid;
+	while (beg < end) {
+		mid = (beg + end) / 2;
+		if (TabListOverlay_PlayerCompare(id, s->ids[mid]) < 0) {
+			end = mid;
+		} else {
+			beg = mid + 1;
+		}
+	}
+	return beg;
+}
+
+/* Returns the index the given player should be inserted at, inserting a new group name entry if needed */
+static int TabListOverlay_FindSlot(struct TabListOverlay* s, int id) {
+	cc_string group, curGroup;
+	int i, count;
+	if (s->classic) return TabListOverlay_FindPlayerSlot(s, id, 0, s->usedCount);
+
+	/* List is made up of a group name entry, followed by the sorted players in that group */
+	group = TabList_UNSAFE_GetGroup(id);
+	for (i = 0; i < s->usedCount; i += count + 1)
+	{
+		curGroup = TabList_UNSAFE_GetGroup(s->ids[i + 1]);
+		count    = TabListOverlay_GetGroupCount(s, s->ids[i + 1], i + 1);
+
+		if (String_CaselessEquals(&group, &curGroup)) {
+			return TabListOverlay_FindPlayerSlot(s, id, i + 1, i + 1 + count);
+		}
+		if (String_Compare(&group, &curGroup) < 0) break;
+	}
+
+	TabListOverlay_OpenSlot(s, i);
+	s->ids[i] = GROUP_NAME_ID;
+	TabListOverlay_DrawText(&s->textures[i], s, &group);
+	return i + 1;
+}
+
+/* Inserts the given player at its sorted position, without touching the textures of other entries */
+static void TabListOverlay_InsertName(struct TabListOverlay* s, int id) {
+	int i = TabListOverlay_FindSlot(s, id);
+	TabListOverlay_OpenSlot(s, i);
+	TabListOverlay_AddName(s, id, i);
+}
+
+/* Removes the i'th entry, along with its group name entry if it was the last player in that group */
+static void TabListOverlay_RemoveAt(struct TabListOverlay* s, int i) {
+	TabListOverlay_DeleteAt(s, i);
+	if (s->classic || i == 0 || s->ids[i - 1] != GROUP_NAME_ID) return;
+
+	if (i == s->usedCount || s->ids[i] == GROUP_NAME_ID) {
+		TabListOverlay_DeleteAt(s, i - 1);
+	}
+}
+
 static void TabListOverlay_Add(void* obj, int id) {
 	struct TabListOverlay* s = (struct TabListOverlay*)obj;
-	TabListOverlay_AddName(s, id, -1);
-	TabListOverlay_SortAndLayout(s);
+	TabListOverlay_InsertName(s, id);
+	TabListOverlay_Layout(s);
+	s->dirty = true;
 }
 
 static void TabListOverlay_Update(void* obj, int id) {
@@ -713,10 +805,10 @@ static void TabListOverlay_Update(void* obj, int id) {
 	for (i = 0; i < s->usedCount; i++)
 	{
 		if (s->ids[i] != id) continue;
-		Gfx_DeleteTexture(&s->textures[i].ID);
 
-		TabListOverlay_AddName(s, id, i);
-		TabListOverlay_SortAndLayout(s);
+		/* Name, group, or rank may have changed, so the player may need to move elsewhere */
+		TabListOverlay_RemoveAt(s, i);
+		TabListOverlay_Add(s, id);
 		return;
 	}
 }
@@ -728,8 +820,9 @@ static void TabListOverlay_Remove(void* obj, int id) {
 	{
 		if (s->ids[i] != id) continue;
 
-		TabListOverlay_DeleteAt(s, i);
-		TabListOverlay_SortAndLayout(s);
+		TabListOverlay_RemoveAt(s, i);
+		TabListOverlay_Layout(s);
+		s->dirty = true;
 		return;
 	}
 }
@@ -889,6 +982,139 @@ void TabListOverlay_Show(cc_bool staysOpen) { }
 #endif
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------ProfilerOverlay-----------------------------------------------------*
+*#########################################################################################################################*/
+#define PROFILER_LINES (PROFILE_COUNT + 5)
+static struct ProfilerOverlay {
+	Screen_Body
+	struct FontDesc font;
+	float accumulator;
+	struct TextWidget lines[PROFILER_LINES];
+} ProfilerOverlay_Instance;
+static struct Widget* profiler_widgets[PROFILER_LINES];
+
+static void ProfilerOverlay_Remake(struct ProfilerOverlay* s) {
+	cc_string line; char lineBuffer[STRING_SIZE];
+	struct ProfilerStats stats;
+	struct FrameTimeStats frames;
+	int i, kb;
+
+	for (i = 0; i < PROFILE_COUNT; i++) 
+	{
+		Profiler_CalcStats(i, &stats);
+		String_InitArray(line, lineBuffer);
+		String_Format4(&line, "%c: &f%f2 / %f2 / %f2", 
+						Profiler_Names[i], &stats.min, &stats.avg, &stats.max);
+		TextWidget_Set(&s->lines[i + 1], &line, &s->font);
+	}
+
+	Profiler_CalcFrameTimes(&frames);
+	String_InitArray(line, lineBuffer);
+	String_Format2(&line, "Frame time p50 / p99: &f%f2 / %f2", &frames.p50, &frames.p99);
+	TextWidget_Set(&s->lines[PROFILE_COUNT + 1], &line, &s->font);
+
+	String_InitArray(line, lineBuffer);
+	String_Format4(&line, "Draws: &f%i (%i verts), %i binds, %i states",
+					&Gfx_LastStats.drawCalls, &Gfx_LastStats.vertices, 
+					&Gfx_LastStats.textureBinds, &Gfx_LastStats.stateChanges);
+	TextWidget_Set(&s->lines[PROFILE_COUNT + 2], &line, &s->font);
+
+	kb = Gfx_LastStats.bytesUploaded / 1024;
+	String_InitArray(line, lineBuffer);
+	String_Format2(&line, "VB locks: &f%i (%i KB uploaded)", &Gfx_LastStats.vbLocks, &kb);
+	TextWidget_Set(&s->lines[PROFILE_COUNT + 3], &line, &s->font);
+
+	kb = NetStats.Queued / 1024;
+	String_InitArray(line, lineBuffer);
+	String_Format2(&line, "Packets: &f%i last tick (%i KB queued)", &NetStats.TickPackets, &kb);
+	TextWidget_Set(&s->lines[PROFILE_COUNT + 4], &line, &s->font);
+	s->dirty = true;
+}
+
+static void ProfilerOverlay_Layout(void* screen) {
+	struct ProfilerOverlay* s = (struct ProfilerOverlay*)screen;
+	struct TextWidget* prev;
+	int i;
+
+	Widget_SetLocation(&s->lines[0], ANCHOR_MAX, ANCHOR_MIN, 
+						2 + DisplayInfo.ContentOffsetX, 2 + DisplayInfo.ContentOffsetY);
+	for (i = 1; i < PROFILER_LINES; i++) 
+	{
+		prev = &s->lines[i - 1];
+		Widget_SetLocation(&s->lines[i], ANCHOR_MAX, ANCHOR_MIN, 
+							2 + DisplayInfo.ContentOffsetX, 0);
+		/* We can't use y in Widget_SetLocation because that DPI scales it */
+		s->lines[i].yOffset = prev->y + prev->height;
+		Widget_Layout(&s->lines[i]);
+	}
+}
+
+static void ProfilerOverlay_ContextLost(void* screen) {
+	struct ProfilerOverlay* s = (struct ProfilerOverlay*)screen;
+	Font_Free(&s->font);
+	Screen_ContextLost(screen);
+}
+
+static void ProfilerOverlay_ContextRecreated(void* screen) {
+	struct ProfilerOverlay* s = (struct ProfilerOverlay*)screen;
+	Screen_UpdateVb(s);
+
+	Font_Make(&s->font, 16, FONT_FLAGS_PADDING);
+	Font_SetPadding(&s->font, 2);
+	TextWidget_SetConst(&s->lines[0], "&eTimings (min / avg / max ms)", &s->font);
+	ProfilerOverlay_Remake(s);
+}
+
+static void ProfilerOverlay_Init(void* screen) {
+	struct ProfilerOverlay* s = (struct ProfilerOverlay*)screen;
+	int i;
+	s->widgets     = profiler_widgets;
+	s->numWidgets  = 0;
+	s->maxWidgets  = Array_Elems(profiler_widgets);
+	s->accumulator = 0.0f;
+
+	for (i = 0; i < PROFILER_LINES; i++) 
+	{
+		TextWidget_Add(s, &s->lines[i]);
+	}
+	s->maxVertices = Screen_CalcDefaultMaxVertices(s);
+}
+
+static void ProfilerOverlay_Update(void* screen, float delta) {
+	struct ProfilerOverlay* s = (struct ProfilerOverlay*)screen;
+	s->accumulator += delta;
+	if (s->accumulator < 0.5f) return;
+
+	/* Only remake twice a second, as remaking text textures is slow */
+	ProfilerOverlay_Remake(s);
+	ProfilerOverlay_Layout(s);
+	s->accumulator = 0.0f;
+}
+
+static void ProfilerOverlay_Render(void* screen, float delta) {
+	if (Game_HideGui) return;
+	Screen_Render2Widgets(screen, delta);
+}
+
+static const struct ScreenVTABLE ProfilerOverlay_VTABLE = {
+	ProfilerOverlay_Init,   ProfilerOverlay_Update, Screen_NullFunc,
+	ProfilerOverlay_Render, Screen_BuildMesh,
+	Screen_FInput,          Screen_InputUp,         Screen_FKeyPress, Screen_FText,
+	Screen_FPointer,        Screen_PointerUp,       Screen_FPointer,  Screen_FMouseScroll,
+	ProfilerOverlay_Layout, ProfilerOverlay_ContextLost, ProfilerOverlay_ContextRecreated
+};
+void ProfilerOverlay_Toggle(void) {
+	struct ProfilerOverlay* s = &ProfilerOverlay_Instance;
+	if (Gui_GetScreen(GUI_PRIORITY_PROFILER)) {
+		Gui_Remove((struct Screen*)s); return;
+	}
+
+	s->VTABLE = &ProfilerOverlay_VTABLE;
+	Gui_Add((struct Screen*)s, GUI_PRIORITY_PROFILER);
+}
+
+
 /*########################################################################################################################*
 *--------------------------------------------------------ChatScreen-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -898,6 +1124,7 @@ static struct ChatScreen {
 	cc_bool suppressNextPress;
 	int chatIndex, paddingX, paddingY;
 	int lastDownloadStatus;
+	int pendingChatLines; /* Number of chat lines received but not yet drawn */
 	struct FontDesc chatFont, announcementFont, bigAnnouncementFont, smallAnnouncementFont;
 	struct TextWidget announcement, bigAnnouncement, smallAnnouncement;
 	struct ChatInputWidget input;
@@ -943,6 +1170,19 @@ static cc_string ChatScreen_GetChat(int i) {
 	return String_Empty;
 }
 
+/* Busy servers may send many chat lines in one frame, so only draw the lines which end up visible */
+static void ChatScreen_UpdateChatLines(struct ChatScreen* s) {
+	if (!s->pendingChatLines) return;
+
+	TextGroupWidget_ShiftUpBy(&s->chat, s->pendingChatLines);
+	s->pendingChatLines = 0;
+}
+
+static void ChatScreen_RedrawChat(struct ChatScreen* s) {
+	TextGroupWidget_RedrawAll(&s->chat);
+	s->pendingChatLines = 0;
+}
+
 static cc_string ChatScreen_GetStatus(int i)       { return Chat_Status[i]; }
 static cc_string ChatScreen_GetBottomRight(int i)  { return Chat_BottomRight[2 - i]; }
 static cc_string ChatScreen_GetClientStatus(int i) { return Chat_ClientStatus[i]; }
@@ -983,7 +1223,7 @@ static cc_bool ChatScreen_ChatUpdateFont(struct ChatScreen* s) {
 }
 
 static void ChatScreen_Redraw(struct ChatScreen* s) {
-	TextGroupWidget_RedrawAll(&s->chat);
+	ChatScreen_RedrawChat(s);
 	TextWidget_Set(&s->announcement, &Chat_Announcement, &s->announcementFont);
 	TextWidget_Set(&s->bigAnnouncement, &Chat_BigAnnouncement, &s->bigAnnouncementFont);
 	TextWidget_Set(&s->smallAnnouncement, &Chat_SmallAnnouncement, &s->smallAnnouncementFont);
@@ -1006,6 +1246,7 @@ static void ChatScreen_ScrollChatBy(struct ChatScreen* s, int delta) {
 	int newIndex = ChatScreen_ClampChatIndex(s->chatIndex + delta);
 	delta = newIndex - s->chatIndex;
 	if (Game_PureClassic) return;
+	ChatScreen_UpdateChatLines(s);
 
 	while (delta) {
 		if (delta < 0) {
@@ -1038,7 +1279,7 @@ static void ChatScreen_EnterChatInput(struct ChatScreen* s, cc_bool close) {
 	defaultIndex = Chat_Log.count - Gui.Chatlines;
 	if (s->chatIndex != defaultIndex) {
 		s->chatIndex = defaultIndex;
-		TextGroupWidget_RedrawAll(&s->chat);
+		ChatScreen_RedrawChat(s);
 	}
 }
 
@@ -1066,6 +1307,7 @@ static void ChatScreen_ColCodeChanged(void* screen, int code) {
 	if (Gfx.LostContext) return;
 
 	SpecialInputWidget_UpdateCols(&s->altText);
+	ChatScreen_UpdateChatLines(s);
 	TextGroupWidget_RedrawAllWithCol(&s->chat,         code);
 	TextGroupWidget_RedrawAllWithCol(&s->status,       code);
 	TextGroupWidget_RedrawAllWithCol(&s->bottomRight,  code);
@@ -1086,7 +1328,8 @@ static void ChatScreen_ChatReceived(void* screen, const cc_string* msg, int type
 	if (type == MSG_TYPE_NORMAL) {
 		s->chatIndex++;
 		if (!Gui.Chatlines) return;
-		TextGroupWidget_ShiftUp(&s->chat);
+		/* Drawn later in ChatScreen_Update */
+		s->pendingChatLines = min(s->pendingChatLines + 1, s->chat.lines);
 	} else if (type >= MSG_TYPE_STATUS_1 && type <= MSG_TYPE_STATUS_3) {
 		/* Status[0] is for texture pack downloading message */
 		/* Status[1] is for reduced performance mode message */
@@ -1114,6 +1357,7 @@ static void ChatScreen_ChatReceived(void* screen, const cc_string* msg, int type
 static void ChatScreen_Update(void* screen, float delta) {
 	struct ChatScreen* s = (struct ChatScreen*)screen;
 	double now = Game.Time;
+	ChatScreen_UpdateChatLines(s);
 
 	/* Destroy announcement texture before even rendering it at all, */
 	/* otherwise changing texture pack shows announcement for one frame */
@@ -1401,6 +1645,7 @@ static int ChatScreen_PointerDown(void* screen, int id, int x, int y) {
 	struct ChatScreen* s = (struct ChatScreen*)screen;
 	int height, chatY, i;
 	if (Game_HideGui) return false;
+	ChatScreen_UpdateChatLines(s);
 
 	if (!s->grabsInput) {
 		if (!Gui_TouchUI) return false;
@@ -1573,7 +1818,7 @@ void ChatScreen_SetChatlines(int lines) {
 	Elem_Free(&s->chat);
 	s->chatIndex += s->chat.lines - lines;
 	s->chat.lines = lines;
-	TextGroupWidget_RedrawAll(&s->chat);
+	ChatScreen_RedrawChat(s);
 
 	s->maxVertices = ChatScreen_CalcMaxVertices(s);
 	Screen_UpdateVb(s);
@@ -2012,6 +2257,8 @@ static void GeneratingScreen_EndGeneration(void) {
 
 	Gen_Blocks = NULL;
 	World.Seed = Gen_Seed;
+	/* Spawn position depends on the blocks around the centre of the map */
+	Gen_GenerateColumns(World.Width / 2 - 1, World.Length / 2 - 1, World.Width / 2 + 1, World.Length / 2 + 1);
 
 	LocalPlayer_CalcDefaultSpawn(Entities.CurPlayer, &update);
 	LocalPlayers_MoveToSpawn(&update);
@@ -39,6 +39,8 @@ void TouchScreen_Show(void);
 
 int HUDScreen_LayoutHotbar(void);
 void TabListOverlay_Show(cc_bool staysOpen);
+/* Shows the frame profiler overlay, or removes it if already shown */
+void ProfilerOverlay_Toggle(void);
 
 /* Opens chat input for the HUD with the given initial text. */
 void ChatScreen_OpenInput(const cc_string* text);
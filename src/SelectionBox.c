@@ -104,11 +104,17 @@ static void CalcDists(struct SelectionBox* box, Vec3 P) {
 #define SELECTIONS_MAX 256
 #define SELECTIONS_VERTICES 24
 #define SELECTIONS_MAX_VERTICES SELECTIONS_MAX * SELECTIONS_VERTICES
+/* How far camera must move before selections are re-sorted (and geometry rebuilt) */
+#define SELECTIONS_RESORT_DIST 1.0f
 
 static int selections_count;
 static struct SelectionBox selections_list[SELECTIONS_MAX];
 static cc_uint8 selections_ids[SELECTIONS_MAX];
-static GfxResourceID selections_VB, selections_LineVB;
+/* Edges of all selections, followed by the faces of all selections */
+static GfxResourceID selections_VB;
+/* Whether the selections have changed since the geometry in the vertex buffer was last built */
+static cc_bool selections_dirty;
+static Vec3 selections_lastPos;
 
 void Selections_Add(cc_uint8 id, const IVec3* p1, const IVec3* p2, PackedCol color) {
 	struct SelectionBox sel;
@@ -120,6 +126,7 @@ void Selections_Add(cc_uint8 id, const IVec3* p1, const IVec3* p2, PackedCol col
 	selections_list[selections_count] = sel;
 	selections_ids[selections_count]  = id;
 	selections_count++;
+	selections_dirty = true;
 }
 
 void Selections_Remove(cc_uint8 id) {
@@ -133,18 +140,18 @@ void Selections_Remove(cc_uint8 id) {
 		}
 
 		selections_count--;
+		selections_dirty = true;
 		return;
 	}
 }
 
 static void Selections_ContextLost(void* obj) {
 	Gfx_DeleteDynamicVb(&selections_VB);
-	Gfx_DeleteDynamicVb(&selections_LineVB);
+	selections_dirty = true;
 }
 
 static void AllocateVertexBuffers(void) {
-	selections_VB     = Gfx_CreateDynamicVb(VERTEX_FORMAT_COLOURED, SELECTIONS_MAX_VERTICES);
-	selections_LineVB = Gfx_CreateDynamicVb(VERTEX_FORMAT_COLOURED, SELECTIONS_MAX_VERTICES);
+	selections_VB = Gfx_CreateDynamicVb(VERTEX_FORMAT_COLOURED, SELECTIONS_MAX_VERTICES * 2);
 }
 
 static void Selections_QuickSort(int left, int right) {
@@ -166,11 +173,10 @@ static void Selections_QuickSort(int left, int right) {
 	}
 }
 
-void Selections_Render(void) {
+static void Selections_Rebuild(int count) {
 	struct VertexColoured* data;
 	Vec3 cameraPos;
-	int i, count;
-	if (!selections_count) return;
+	int i;
 
 	/* TODO: Proper selection box sorting. But this is very difficult because
 	   we can have boxes within boxes, intersecting boxes, etc. Probably not worth it. */
@@ -180,30 +186,43 @@ void Selections_Render(void) {
 	}
 	Selections_QuickSort(0, selections_count - 1);
 
-	/* lazy init as most servers don't use this */
-	if (!selections_VB) AllocateVertexBuffers();
+	selections_lastPos = cameraPos;
+	selections_dirty   = false;
 
-	count = selections_count * SELECTIONS_VERTICES;
-	Gfx_SetVertexFormat(VERTEX_FORMAT_COLOURED);
-
-	data = (struct VertexColoured*)Gfx_LockDynamicVb(selections_LineVB, 
-										VERTEX_FORMAT_COLOURED, count);
+	data = (struct VertexColoured*)Gfx_LockDynamicVb(selections_VB, 
+										VERTEX_FORMAT_COLOURED, count * 2);
 	for (i = 0; i < selections_count; i++, data += SELECTIONS_VERTICES) {
 		BuildEdges(&selections_list[i], data);
 	}
-	Gfx_UnlockDynamicVb(selections_LineVB);
-	Gfx_DrawVb_Lines(count);
-
-	data = (struct VertexColoured*)Gfx_LockDynamicVb(selections_VB, 
-										VERTEX_FORMAT_COLOURED, count);
 	for (i = 0; i < selections_count; i++, data += SELECTIONS_VERTICES) {
 		BuildFaces(&selections_list[i], data);
 	}
 	Gfx_UnlockDynamicVb(selections_VB);
+}
+
+void Selections_Render(void) {
+	Vec3 delta;
+	int count;
+	if (!selections_count) return;
+
+	/* lazy init as most servers don't use this */
+	if (!selections_VB) AllocateVertexBuffers();
+
+	count = selections_count * SELECTIONS_VERTICES;
+	Gfx_SetVertexFormat(VERTEX_FORMAT_COLOURED);
+
+	/* Sort order only really changes once camera has moved a fair distance */
+	Vec3_Sub(&delta, &Camera.CurrentPos, &selections_lastPos);
+	if (selections_dirty || Vec3_LengthSquared(&delta) > SELECTIONS_RESORT_DIST * SELECTIONS_RESORT_DIST) {
+		Selections_Rebuild(count);
+	} else {
+		Gfx_BindDynamicVb(selections_VB);
+	}
+	Gfx_DrawVb_Lines(count);
 
 	Gfx_SetDepthWrite(false);
 	Gfx_SetAlphaBlending(true);
-	Gfx_DrawVb_IndexedTris(count);
+	Gfx_DrawVb_IndexedTris_Range(count, count);
 	Gfx_SetDepthWrite(true);
 	Gfx_SetAlphaBlending(false);
 }
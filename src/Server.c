@@ -25,6 +25,9 @@
 #include "Input.h"
 #include "Errors.h"
 #include "Options.h"
+#include "Stream.h"
+#include "Lighting.h"
+#include "Utils.h"
 
 static char nameBuffer[STRING_SIZE];
 static char motdBuffer[STRING_SIZE];
@@ -54,6 +57,61 @@ void Server_RetrieveTexturePack(const cc_string* url) {
 }
 
 
+/*########################################################################################################################*
+*---------------------------------------------------Network statistics----------------------------------------------------*
+*#########################################################################################################################*/
+struct _NetStatsData NetStats;
+
+void NetStats_Reset(void) {
+	Mem_Set(&NetStats, 0, sizeof(NetStats));
+	NetStats.ResetTime = Game.Time;
+}
+
+cc_result NetStats_WriteCSV(struct Stream* s) {
+	cc_string line; char lineBuffer[STRING_SIZE * 2];
+	int i, recvKB, sentKB;
+	float time;
+	cc_result res;
+
+	String_InitArray(line, lineBuffer);
+	String_AppendConst(&line, "Opcode,Packets received,KB received,Handler time (ms),Packets sent,KB sent\r\n");
+	if ((res = Stream_Write(s, (cc_uint8*)line.buffer, line.length))) return res;
+
+	for (i = 0; i < 256; i++) 
+	{
+		if (!NetStats.RecvPackets[i] && !NetStats.SentPackets[i]) continue;
+		recvKB = (int)(NetStats.RecvBytes[i] / 1024);
+		sentKB = (int)(NetStats.SentBytes[i] / 1024);
+		time   = Stopwatch_ElapsedMicroseconds(0, NetStats.HandlerTime[i]) / 1000.0f;
+
+		line.length = 0;
+		String_Format4(&line, "%i,%i,%i,%f3,", &i, &NetStats.RecvPackets[i], &recvKB, &time);
+		String_Format2(&line, "%i,%i\r\n", &NetStats.SentPackets[i], &sentKB);
+		if ((res = Stream_Write(s, (cc_uint8*)line.buffer, line.length))) return res;
+	}
+	return 0;
+}
+
+#ifdef CC_BUILD_NETWORKING
+/* Records that a packet was processed, and the time at which processing finished */
+static void NetStats_Processed(cc_uint8 opcode, cc_uint32 size, cc_uint64* last) {
+	cc_uint64 now = Stopwatch_Measure();
+	NetStats.RecvPackets[opcode]++;
+	NetStats.RecvBytes[opcode]   += size;
+	NetStats.HandlerTime[opcode] += now - *last;
+	NetStats.TickPackets++;
+	*last = now;
+}
+
+static void NetStats_EndTick(cc_uint32 queued) {
+	NetStats.Ticks++;
+	NetStats.MaxTickPackets = max(NetStats.MaxTickPackets, NetStats.TickPackets);
+	NetStats.Queued         = queued;
+	NetStats.MaxQueued      = max(NetStats.MaxQueued, queued);
+}
+#endif
+
+
 /*########################################################################################################################*
 *--------------------------------------------------------PingList---------------------------------------------------------*
 *#########################################################################################################################*/
@@ -238,18 +296,59 @@ static cc_uint8  net_readBuffer[4096 * 5];
 static cc_uint8* net_readCurrent;
 static double net_lastPacket;
 static cc_uint8 lastOpcode;
+static void NetThread_Start(void);
+static void NetThread_Stop(void);
+static void ReplayRecorder_Start(void);
+static void ReplayRecorder_Add(const cc_uint8* data, cc_uint32 len);
 
 static cc_bool net_connecting;
 static double net_connectTimeout;
 #define NET_TIMEOUT_SECS 15
 
-static void MPConnection_FinishConnect(void) {
+/* When the server address resolves to multiple IPs, connection attempts are started this far apart */
+/*  and the first to succeed is used (so e.g. a broken IPv6 route doesn't stall until the timeout) */
+#define NET_ATTEMPT_DELAY_SECS 0.25
+static cc_socket   net_attempts[SOCKET_MAX_ADDRS];
+static cc_sockaddr net_addrs[SOCKET_MAX_ADDRS];
+static int net_numAddrs, net_numAttempts;
+static double net_nextAttempt;
+static cc_result net_attemptError;
+
+/* Outgoing packets are gathered up and then sent together once per network tick */
+#define NET_SEND_SIZE (64 * 1024)
+/* Maximum time to wait for the socket to accept any more data before giving up */
+#define NET_SEND_TIMEOUT_SECS 10
+static cc_uint8  net_sendBuffer[NET_SEND_SIZE];
+static cc_uint32 net_sendLength;
+static double net_lastSend;
+
+static void MPConnection_CloseAttempts(void) {
+	int i;
+	for (i = 0; i < net_numAttempts; i++)
+	{
+		if (net_attempts[i] == -1) continue;
+		Socket_Close(net_attempts[i]);
+		net_attempts[i] = -1;
+	}
+}
+
+static void MPConnection_FinishConnect(int attempt) {
+	net_socket = net_attempts[attempt];
+	net_attempts[attempt] = -1;
+	MPConnection_CloseAttempts();
+	Socket_ReportAddress(&Server.Address, Server.Port, &net_addrs[attempt], true);
+
 	net_connecting = false;
 	Event_RaiseVoid(&NetEvents.Connected);
 	Event_RaiseFloat(&WorldEvents.Loading, 0.0f);
 
 	net_readCurrent = net_readBuffer;
 	net_lastPacket  = Game.Time;
+	net_sendLength  = 0;
+	net_lastSend    = Game.Time;
+	NetStats_Reset();
+	NetThread_Start();
+	ReplayRecorder_Start();
 	Classic_SendLogin();
 }
 
@@ -267,6 +366,7 @@ static void MPConnection_FailConnect(cc_result result) {
 	static const cc_string reason = String_FromConst("You failed to connect to the server. It's probably down!");
 	cc_string msg; char msgBuffer[STRING_SIZE * 2];
 	String_InitArray(msg, msgBuffer);
+	MPConnection_CloseAttempts();
 
 	if (result) {
 		String_Format3(&msg, "Error connecting to %s:%i: %e" _NL, &Server.Address, &Server.Port, &result);
@@ -275,15 +375,51 @@ static void MPConnection_FailConnect(cc_result result) {
 	MPConnection_Fail(&reason);
 }
 
+static void MPConnection_StartAttempt(void) {
+	int i = net_numAttempts++;
+	cc_result res;
+	net_nextAttempt = Game.Time + NET_ATTEMPT_DELAY_SECS;
+
+	res = Socket_Create(&net_attempts[i], &net_addrs[i], true);
+	if (res) { net_attempts[i] = -1; net_attemptError = res; return; }
+	res = Socket_Connect(net_attempts[i], &net_addrs[i]);
+
+	if (res && res != ReturnCode_SocketInProgess && res != ReturnCode_SocketWouldBlock) {
+		Socket_ReportAddress(&Server.Address, Server.Port, &net_addrs[i], false);
+		Socket_Close(net_attempts[i]);
+		net_attempts[i]  = -1;
+		net_attemptError = res;
+	}
+}
+
 static void MPConnection_TickConnect(void) {
-	cc_bool writable;
-	double now    = Game.Time;
-	cc_result res = Socket_CheckWritable(net_socket, &writable);
+	cc_bool writable, pending = false;
+	double now = Game.Time;
+	cc_result res;
+	int i;
 
-	if (res) {
-		MPConnection_FailConnect(res);
-	} else if (writable) {
-		MPConnection_FinishConnect();
+	for (i = 0; i < net_numAttempts; i++)
+	{
+		if (net_attempts[i] == -1) continue;
+		res = Socket_CheckWritable(net_attempts[i], &writable);
+
+		if (res) {
+			Socket_ReportAddress(&Server.Address, Server.Port, &net_addrs[i], false);
+			Socket_Close(net_attempts[i]);
+			net_attempts[i]  = -1;
+			net_attemptError = res;
+		} else if (writable) {
+			MPConnection_FinishConnect(i); return;
+		} else {
+			pending = true;
+		}
+	}
+
+	/* Start connecting to the next address early if all the earlier attempts already failed */
+	if (net_numAttempts < net_numAddrs && (!pending || now >= net_nextAttempt)) {
+		MPConnection_StartAttempt();
+	} else if (!pending) {
+		MPConnection_FailConnect(net_attemptError);
 	} else if (now > net_connectTimeout) {
 		MPConnection_FailConnect(0);
 	} else {
@@ -295,8 +431,6 @@ static void MPConnection_TickConnect(void) {
 static void MPConnection_BeginConnect(void) {
 	static const cc_string invalid_reason = String_FromConst("Invalid IP address");
 	cc_string title; char titleBuffer[STRING_SIZE];
-	cc_sockaddr addrs[SOCKET_MAX_ADDRS];
-	int numValidAddrs;
 	cc_result res;
 	String_InitArray(title, titleBuffer);
 
@@ -308,19 +442,20 @@ static void MPConnection_BeginConnect(void) {
 	Blocks.CanPlace[BLOCK_STILL_WATER] = false; Blocks.CanDelete[BLOCK_STILL_WATER] = false;
 	Blocks.CanPlace[BLOCK_BEDROCK] = false;     Blocks.CanDelete[BLOCK_BEDROCK] = false;
 	
-	res = Socket_ParseAddress(&Server.Address, Server.Port, addrs, &numValidAddrs);
-	if (res == ERR_INVALID_ARGUMENT) {
+	res = Socket_ResolveAddress(&Server.Address, Server.Port, net_addrs, &net_numAddrs);
+	if (res == ERR_INVALID_ARGUMENT || (!res && !net_numAddrs)) {
 		MPConnection_Fail(&invalid_reason); return;
 	} else if (res) {
 		MPConnection_FailConnect(res); return;
 	}
 
-	res = Socket_Create(&net_socket, &addrs[0], true);
-	if (res) { MPConnection_FailConnect(res); return; }
-	res = Socket_Connect(net_socket, &addrs[0]);
+	net_numAttempts  = 0;
+	net_attemptError = 0;
+	net_socket       = -1;
+	MPConnection_StartAttempt();
 
-	if (res && res != ReturnCode_SocketInProgess && res != ReturnCode_SocketWouldBlock) {
-		MPConnection_FailConnect(res);
+	if (net_attempts[0] == -1 && net_numAddrs == 1) {
+		MPConnection_FailConnect(net_attemptError);
 	} else {
 		Server.Disconnected = false;
 		net_connecting      = true;
@@ -376,16 +511,247 @@ static void DisconnectInvalidOpcode(cc_uint8 opcode) {
 	Game_Disconnect(&title, &tmp); return;
 }
 
-static void MPConnection_Tick(struct ScheduledTask* task) {
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_WEB && !defined CC_BUILD_LOWMEM
+#define NET_THREADED
+#endif
+/* Maximum time spent processing received packets per network tick */
+#define NET_PROCESS_BUDGET_US 4000
+
+#ifdef NET_THREADED
+/* Packets are read and framed on a background network thread, then processed */
+/*  on the main thread (since packet handlers change game state) */
+/* Received data is stored in a ring buffer, which packet handlers then read from in place */
+#define NET_RING_SIZE (256 * 1024) /* NOTE: Must be a power of two */
+#define NET_RING_MASK (NET_RING_SIZE - 1)
+
+static void* net_thread;
+static void* net_ringMutex;
+static volatile cc_bool net_threadQuit;
+/* Set by network thread when it stops reading, after framing all the data it received */
+static volatile cc_bool net_threadDone;
+/* Set by network thread whenever reading from the socket returns 0 bytes */
+static volatile cc_bool net_readEmpty;
+static cc_result net_readFailure;
+
+/* Packets that wrap around the end of the ring have the wrapped bytes also copied */
+/*  to just after the end of the ring, so that each packet can be read contiguously */
+static cc_uint8 net_ring[NET_RING_SIZE + 0x10000];
+/* Positions in the ring (only ever increase, so must be masked with NET_RING_MASK) */
+/*  net_ringRead   - data before this has been processed by main thread */
+/*  net_ringFramed - data before this contains only complete packets */
+/* NOTE: Both are only accessed under net_ringMutex, while data is copied outside of it */
+static cc_uint32 net_ringRead, net_ringFramed;
+
+static void NetRing_GetPositions(cc_uint32* read, cc_uint32* framed) {
+	Mutex_Lock(net_ringMutex);
+	*read   = net_ringRead;
+	*framed = net_ringFramed;
+	Mutex_Unlock(net_ringMutex);
+}
+
+static void NetRing_SetFramed(cc_uint32 framed) {
+	Mutex_Lock(net_ringMutex);
+	net_ringFramed = framed;
+	Mutex_Unlock(net_ringMutex);
+}
+
+static void NetRing_SetRead(cc_uint32 read) {
+	Mutex_Lock(net_ringMutex);
+	net_ringRead = read;
+	Mutex_Unlock(net_ringMutex);
+}
+
+/* Waits until the main thread has processed all framed packets */
+static cc_bool NetThread_WaitProcessed(void) {
+	cc_uint32 read, framed;
+
+	for (;;) {
+		NetRing_GetPositions(&read, &framed);
+		if (read == framed) return true;
+		if (net_threadQuit) return false;
+		Thread_Sleep(1);
+	}
+}
+
+/* Packet handlers for these opcodes may change Protocol.Sizes, so the network thread */
+/*  must wait for them to be processed before it can frame any following packets */
+#define NetThread_IsBarrier(opcode) ((opcode) == OPCODE_EXT_INFO || (opcode) == OPCODE_EXT_ENTRY)
+
+/* Advances past all complete packets in the received data */
+/* NOTE: Main thread determines packet boundaries the same way when processing them */
+static cc_uint32 NetThread_Frame(cc_uint32 framed, cc_uint32 written, cc_uint8* lastOpcode) {
+	cc_uint32 offset, size, wrapped;
+	cc_uint8 opcode;
+
+	while (framed != written) {
+		offset = framed & NET_RING_MASK;
+		opcode = net_ring[offset];
+
+		/* Workaround for older D3 servers which wrote one byte too many for HackControl packets */
+		if (cpe_needD3Fix && *lastOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
+			if (Platform_LogEnabled(LOG_CATEGORY_NETWORK, LOG_LEVEL_DEBUG))
+				Platform_LogConst("Skipping invalid HackControl byte from D3 server");
+			framed++;
+			continue;
+		}
+
+		if (!Protocol.Handlers[opcode]) {
+			/* Let main thread disconnect, since rest of the data can't be framed */
+			net_threadQuit = true;
+			return framed + 1;
+		}
+
+		size = Protocol.Sizes[opcode];
+		if (written - framed < size) break;
+
+		if (offset + size > NET_RING_SIZE) {
+			wrapped = offset + size - NET_RING_SIZE;
+			Mem_Copy(&net_ring[NET_RING_SIZE], net_ring, wrapped);
+		}
+
+		*lastOpcode = opcode;
+		framed     += size;
+		if (!NetThread_IsBarrier(opcode)) continue;
+
+		NetRing_SetFramed(framed);
+		if (!NetThread_WaitProcessed()) break;
+	}
+	return framed;
+}
+
+static void NetThread_Run(void) {
+	cc_uint32 read, framed, written = 0, count;
+	cc_uint8 lastOpcode = 0xFF;
+	cc_result res;
+
+	while (!net_threadQuit) {
+		NetRing_GetPositions(&read, &framed);
+		/* Read as much as possible, without wrapping around or overwriting unprocessed data */
+		count = NET_RING_SIZE - (written & NET_RING_MASK);
+		count = min(count, NET_RING_SIZE - (written - read));
+
+		if (!count) { Thread_Sleep(1); continue; }
+		res = Socket_Read(net_socket, &net_ring[written & NET_RING_MASK], count, &count);
+
+		if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) {
+			/* 'no data available for non-blocking read' is an expected error */
+			Thread_Sleep(1);
+			continue;
+		} else if (res) {
+			net_readFailure = res;
+			break;
+		} else if (count == 0) {
+			/* recv only returns 0 read when socket is closed.. probably? */
+			net_readEmpty = true;
+			Thread_Sleep(1);
+			continue;
+		}
+
+		written += count;
+		framed   = NetThread_Frame(framed, written, &lastOpcode);
+		NetRing_SetFramed(framed);
+	}
+	net_threadDone = true;
+}
+
+static void NetThread_Start(void) {
+	if (!net_ringMutex) net_ringMutex = Mutex_Create("Network ring");
+	net_ringRead    = 0;
+	net_ringFramed  = 0;
+	net_threadQuit  = false;
+	net_threadDone  = false;
+	net_readEmpty   = false;
+	net_readFailure = 0;
+
+	Thread_Run(&net_thread, NetThread_Run, 64 * 1024, "Network");
+}
+
+static void NetThread_Stop(void) {
+	if (!net_thread) return;
+	net_threadQuit = true;
+
+	Thread_Join(net_thread);
+	net_thread = NULL;
+}
+
+/* Processes packets framed by the network thread, returning false if disconnected */
+static cc_bool MPConnection_ProcessPackets(void) {
+	cc_uint64 beg = Stopwatch_Measure(), last = beg;
+	cc_uint32 read, framed, size;
+	Net_Handler handler;
+	cc_uint8* data;
+	cc_uint8 opcode;
+	NetStats.TickPackets = 0;
+
+	for (;;) {
+		NetRing_GetPositions(&read, &framed);
+		if (read == framed) break;
+		net_lastPacket = Game.Time;
+
+		while (read != framed) {
+			data   = &net_ring[read & NET_RING_MASK];
+			opcode = data[0];
+
+			if (cpe_needD3Fix && lastOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
+				LocalPlayer_ResetJumpVelocity(Entities.CurPlayer);
+				read++;
+				continue;
+			}
+
+			handler = Protocol.Handlers[opcode];
+			if (!handler) { DisconnectInvalidOpcode(opcode); return false; }
+
+			/* NOTE: Size must be retrieved before calling handler, as handler may change it */
+			size = Protocol.Sizes[opcode];
+			ReplayRecorder_Add(data, size);
+			read      += size;
+			lastOpcode = opcode;
+			handler(data + 1); /* skip opcode */
+			NetStats_Processed(opcode, size, &last);
+			if (Server.Disconnected) return false;
+
+			/* Leave remaining packets for next tick, instead of stalling this frame */
+			/* NOTE: last is the time the handler finished, as measured by NetStats_Processed */
+			if (Stopwatch_ElapsedMicroseconds(beg, last) >= NET_PROCESS_BUDGET_US) {
+				NetRing_SetRead(read);
+				NetRing_GetPositions(&read, &framed);
+				NetStats_EndTick(framed - read);
+				return true;
+			}
+		}
+		NetRing_SetRead(read);
+	}
+
+	NetStats_EndTick(0);
+
+	/* Only report errors once all data received before them has been processed */
+	if (!net_threadDone) {
+		/* Over 30 seconds since last packet, connection probably dropped */
+		if (net_readEmpty && net_lastPacket + 30 < Game.Time) { MPConnection_Disconnect(); return false; }
+		return true;
+	}
+
+	if (net_readFailure) {
+		DisconnectReadFailed(net_readFailure); 
+	} else {
+		MPConnection_Disconnect();
+	}
+	return false;
+}
+#else
+static void NetThread_Start(void) { }
+static void NetThread_Stop(void)  { }
+
+/* Reads and processes packets from the socket, returning false if disconnected */
+static cc_bool MPConnection_ProcessPackets(void) {
 	Net_Handler handler;
 	cc_uint8* readEnd;
 	cc_uint8* readCur;
 	cc_uint32 read;
-	int i, remaining;
+	cc_uint64 last;
+	int remaining;
 	cc_result res;
-
-	if (Server.Disconnected) return;
-	if (net_connecting) { MPConnection_TickConnect(); return; }
+	NetStats.TickPackets = 0;
 
 	/* NOTE: using a read call that is a multiple of 4096 (appears to?) improve read performance */	
 	res = Socket_Read(net_socket, net_readCurrent, 4096 * 4, &read);
@@ -395,22 +761,24 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 		if (res == ReturnCode_SocketInProgess)  res = 0;
 		if (res == ReturnCode_SocketWouldBlock) res = 0;
 
-		if (res) { DisconnectReadFailed(res); return; }
+		if (res) { DisconnectReadFailed(res); return false; }
 	} else if (read == 0) {
 		/* recv only returns 0 read when socket is closed.. probably? */
 		/* Over 30 seconds since last packet, connection probably dropped */
 		/* TODO: Should this be checked unconditonally instead of just when read = 0 ? */
-		if (net_lastPacket + 30 < Game.Time) { MPConnection_Disconnect(); return; }
+		if (net_lastPacket + 30 < Game.Time) { MPConnection_Disconnect(); return false; }
 	} else {
 		readCur        = net_readBuffer;
 		readEnd        = net_readCurrent + read;
 		net_lastPacket = Game.Time;
+		last           = Stopwatch_Measure();
 
 		while (readCur < readEnd) {
 			cc_uint8 opcode = readCur[0];
 
 			/* Workaround for older D3 servers which wrote one byte too many for HackControl packets */
 			if (cpe_needD3Fix && lastOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
+				if (Platform_LogEnabled(LOG_CATEGORY_NETWORK, LOG_LEVEL_DEBUG))
 				Platform_LogConst("Skipping invalid HackControl byte from D3 server");
 				readCur++;
 				LocalPlayer_ResetJumpVelocity(Entities.CurPlayer);
@@ -419,10 +787,12 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 
 			if (readCur + Protocol.Sizes[opcode] > readEnd) break;
 			handler = Protocol.Handlers[opcode];
-			if (!handler) { DisconnectInvalidOpcode(opcode); return; }
+			if (!handler) { DisconnectInvalidOpcode(opcode); return false; }
 
+			ReplayRecorder_Add(readCur, Protocol.Sizes[opcode]);
 			lastOpcode = opcode;
 			handler(readCur + 1); /* skip opcode */
+			NetStats_Processed(opcode, Protocol.Sizes[opcode], &last);
 			readCur += Protocol.Sizes[opcode];
 		}
 
@@ -430,47 +800,86 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 		/* If so, copy last few unprocessed bytes back to beginning of buffer */
 		/* These bytes are then later combined with subsequently read TCP packet data */
 		remaining = (int)(readEnd - readCur);
-		for (i = 0; i < remaining; i++) 
-		{
-			net_readBuffer[i] = readCur[i];
-		}
+		Mem_Move(net_readBuffer, readCur, remaining);
 		net_readCurrent = net_readBuffer + remaining;
 	}
 
+	NetStats_EndTick((cc_uint32)(net_readCurrent - net_readBuffer));
+	return true;
+}
+#endif
+
+/* Attempts to send as much of the pending outgoing data as the socket will currently accept */
+static void MPConnection_FlushData(void) {
+	cc_uint32 wrote, sent = 0;
+	cc_result res = 0;
+
+	while (sent < net_sendLength) {
+		res = Socket_Write(net_socket, net_sendBuffer + sent, net_sendLength - sent, &wrote);
+		if (res) break;
+		if (!wrote) { res = ERR_INVALID_ARGUMENT; break; }
+		sent += wrote;
+	}
+
+	/* Move unsent data to start of the buffer, to try sending it again later */
+	net_sendLength -= sent;
+	Mem_Move(net_sendBuffer, net_sendBuffer + sent, net_sendLength);
+	if (sent || !net_sendLength) net_lastSend = Game.Time;
+
+	/* If sending would block (send buffer full), just try again next tick */
+	if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) {
+		res = 0;
+		if (net_lastSend + NET_SEND_TIMEOUT_SECS < Game.Time) res = ReturnCode_SocketWouldBlock;
+	}
+
+	/* NOTE: Not immediately disconnecting here, as otherwise we sometimes miss out on kick messages */
+	if (res) net_writeFailure = res;
+}
+
+static void MPConnection_Tick(struct ScheduledTask* task) {
+	cc_bool connected;
+	if (Server.Disconnected) return;
+	if (net_connecting) { MPConnection_TickConnect(); return; }
+
+	/* Servers often send thousands of block changes in one tick (e.g. /cuboid) */
+	Game_BeginBlockChanges();
+	Lighting_BeginBatch();
+	connected = MPConnection_ProcessPackets();
+	Lighting_EndBatch();
+	Game_EndBlockChanges();
+	if (!connected) return;
+
 	if (net_writeFailure) {
 		Platform_Log1("Error from send: %e", &net_writeFailure);
 		MPConnection_Disconnect(); return;
 	}
 
 	/* Network is ticked 60 times a second. We only send position updates 20 times a second */
-	if ((ticks++ % 3) != 0) return;
-
-	TexturePack_CheckPending();
-	Protocol_Tick();
+	if ((ticks++ % 3) == 0) {
+		TexturePack_CheckPending();
+		Protocol_Tick();
+	}
+	MPConnection_FlushData();
 }
 
 static void MPConnection_SendData(const cc_uint8* data, cc_uint32 len) {
-	cc_uint32 wrote;
-	cc_result res;
-	int tries = 0;
-	if (Server.Disconnected) return;
+	if (Server.Disconnected || net_writeFailure) return;
 
-	while (len) {
-		res = Socket_Write(net_socket, data, len, &wrote);
-		/* If sending would block (send buffer full), retry for a bit up to 10 seconds */
-		/* TODO: Avoid doing this and manually buffer data when this happens */
-		if (res && tries < 1000 && (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock)) {
-			Thread_Sleep(10);
-			tries++;
-			continue;
-		}
+	/* Try to make room when a lot of data is sent in one tick */
+	if (net_sendLength + len > NET_SEND_SIZE) MPConnection_FlushData();
 
-		/* NOTE: Not immediately disconnecting here, as otherwise we sometimes miss out on kick messages */
-		if (res)    { net_writeFailure = res;                  return; }
-		if (!wrote) { net_writeFailure = ERR_INVALID_ARGUMENT; return; }
-
-		data += wrote; len -= wrote;
+	if (net_sendLength + len > NET_SEND_SIZE) {
+		/* Dropping packets would corrupt the stream, so treat as a send failure instead */
+		if (!net_writeFailure) net_writeFailure = ReturnCode_SocketWouldBlock;
+		return;
 	}
+
+	Mem_Copy(net_sendBuffer + net_sendLength, data, len);
+	net_sendLength += len;
+
+	/* NOTE: Assumes data is a single packet, which is the case for all packets the client sends */
+	NetStats.SentPackets[data[0]]++;
+	NetStats.SentBytes[data[0]] += len;
 }
 
 static void MPConnection_Init(void) {
@@ -489,6 +898,235 @@ static void MPConnection_Init(void) { SPConnection_Init(); }
 #endif
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------Replay recording----------------------------------------------------*
+*#########################################################################################################################*/
+static char replayPathBuffer[FILENAME_SIZE];
+cc_string Replay_Path = String_FromArray(replayPathBuffer);
+cc_bool Replay_MaxSpeed;
+
+#ifdef CC_BUILD_NETWORKING
+/* Replay file format: 'CCRP' magic, version byte, 3 reserved bytes, then a sequence of records */
+/* Each record is [u32 LE ms since connected][u16 LE length][packet data, including opcode] */
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 8
+#define REPLAY_RECORD_SIZE 6
+#define REPLAY_BUFFER_SIZE (64 * 1024)
+
+static struct Stream replay_file;
+static cc_bool replay_recording, replay_playing;
+static cc_uint8  replay_buffer[REPLAY_BUFFER_SIZE];
+static cc_uint32 replay_buffered;
+static cc_uint64 replay_start;
+
+static void ReplayRecorder_Flush(void) {
+	cc_result res;
+	if (!replay_buffered) return;
+
+	res = Stream_Write(&replay_file, replay_buffer, replay_buffered);
+	replay_buffered = 0;
+	if (!res) return;
+
+	Logger_SysWarn(res, "writing replay");
+	replay_recording = false;
+	replay_file.Close(&replay_file);
+}
+
+static void ReplayRecorder_Start(void) {
+	static const cc_uint8 header[REPLAY_HEADER_SIZE] = { 'C','C','R','P', REPLAY_VERSION };
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	struct cc_datetime now;
+	cc_result res;
+	if (replay_recording || !Options_GetBool(OPT_NET_RECORD_REPLAY, false)) return;
+
+	DateTime_CurrentLocal(&now);
+	String_InitArray(path, pathBuffer);
+	String_Format3(&path, "replays/replay_%p4-%p2-%p2", &now.year, &now.month, &now.day);
+	String_Format3(&path, "-%p2-%p2-%p2.ccr", &now.hour, &now.minute, &now.second);
+
+	if (!Utils_EnsureDirectory("replays")) return;
+	res = Stream_CreateFile(&replay_file, &path);
+	if (res) { Logger_SysWarn2(res, "creating", &path); return; }
+
+	Mem_Copy(replay_buffer, header, REPLAY_HEADER_SIZE);
+	replay_buffered  = REPLAY_HEADER_SIZE;
+	replay_recording = true;
+	replay_start     = Stopwatch_Measure();
+	Platform_Log1("Recording replay to %s", &path);
+}
+
+/* Appends a packet to the replay, right before the packet's handler is invoked */
+static void ReplayRecorder_Add(const cc_uint8* data, cc_uint32 len) {
+	cc_uint32 ms;
+	if (!replay_recording) return;
+	if (replay_buffered + REPLAY_RECORD_SIZE + len > REPLAY_BUFFER_SIZE) {
+		ReplayRecorder_Flush();
+		if (!replay_recording) return;
+	}
+
+	ms = (cc_uint32)(Stopwatch_ElapsedMicroseconds(replay_start, Stopwatch_Measure()) / 1000);
+	Stream_SetU32_LE(replay_buffer + replay_buffered,     ms);
+	Stream_SetU16_LE(replay_buffer + replay_buffered + 4, (cc_uint16)len);
+	Mem_Copy(replay_buffer + replay_buffered + REPLAY_RECORD_SIZE, data, len);
+	replay_buffered += REPLAY_RECORD_SIZE + len;
+}
+
+static void Replay_Close(void) {
+	if (replay_recording) {
+		ReplayRecorder_Flush();
+		/* Flush closes the file itself on failure */
+		if (replay_recording) replay_file.Close(&replay_file);
+		replay_recording = false;
+	}
+
+	if (replay_playing) {
+		replay_file.Close(&replay_file);
+		replay_playing = false;
+	}
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Replay connection---------------------------------------------------*
+*#########################################################################################################################*/
+static struct Stream replay_source;
+static cc_bool replay_havePending;
+static cc_uint32 replay_pendingTime, replay_pendingLen;
+static cc_uint8 replay_packet[REPLAY_BUFFER_SIZE];
+static int replay_packets;
+
+static void ReplayConnection_Fail(const cc_string* reason) {
+	static const cc_string title = String_FromConst("Failed to play replay");
+	Game_Disconnect(&title, reason);
+	OnClose();
+}
+
+static void ReplayConnection_Finish(void) {
+	float secs = (float)Stopwatch_ElapsedMicroseconds(replay_start, Stopwatch_Measure()) / (1000 * 1000);
+	cc_string msg; char msgBuffer[STRING_SIZE];
+	String_InitArray(msg, msgBuffer);
+
+	String_Format2(&msg, "&eReplay finished: %i packets in %f3 seconds", &replay_packets, &secs);
+	Chat_Add(&msg);
+	Platform_Log(msg.buffer + 2, msg.length - 2);
+
+	replay_file.Close(&replay_file);
+	replay_playing = false;
+}
+
+static void ReplayConnection_BeginConnect(void) {
+	static const cc_string invalid_reason = String_FromConst("Not a valid replay file");
+	cc_uint8 header[REPLAY_HEADER_SIZE];
+	cc_result res;
+
+	res = Stream_OpenFile(&replay_file, &Replay_Path);
+	if (res) {
+		Logger_SysWarn2(res, "opening", &Replay_Path);
+		ReplayConnection_Fail(&invalid_reason); return;
+	}
+
+	replay_playing = true;
+	Stream_ReadonlyBuffered(&replay_source, &replay_file, replay_buffer, REPLAY_BUFFER_SIZE);
+	res = Stream_Read(&replay_source, header, REPLAY_HEADER_SIZE);
+
+	if (res || !Mem_Equal(header, "CCRP", 4) || header[4] != REPLAY_VERSION) {
+		ReplayConnection_Fail(&invalid_reason); return;
+	}
+
+	Server.Disconnected = false;
+	replay_havePending  = false;
+	replay_packets      = 0;
+	Event_RaiseVoid(&NetEvents.Connected);
+	Event_RaiseFloat(&WorldEvents.Loading, 0.0f);
+
+	Platform_Log2("Playing replay %s (%c)", &Replay_Path, Replay_MaxSpeed ? "max speed" : "real-time");
+	replay_start = Stopwatch_Measure();
+}
+
+/* Dispatches all recorded packets that are due, returning false once the replay has ended */
+static cc_bool ReplayConnection_ProcessPackets(void) {
+	static const cc_string corrupt_reason = String_FromConst("Replay file is corrupted");
+	cc_uint64 beg = Stopwatch_Measure();
+	cc_uint8 record[REPLAY_RECORD_SIZE];
+	Net_Handler handler;
+	cc_uint32 elapsed;
+	cc_uint8 opcode;
+	cc_result res;
+
+	for (;;) {
+		if (!replay_havePending) {
+			res = Stream_Read(&replay_source, record, REPLAY_RECORD_SIZE);
+			if (res) { ReplayConnection_Finish(); return false; }
+
+			replay_pendingTime = Stream_GetU32_LE(record);
+			replay_pendingLen  = Stream_GetU16_LE(record + 4);
+			replay_havePending = true;
+		}
+
+		if (Replay_MaxSpeed) {
+			/* Leave remaining packets for next tick, so frames still get rendered */
+			if (Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure()) >= NET_PROCESS_BUDGET_US) return true;
+		} else {
+			elapsed = (cc_uint32)(Stopwatch_ElapsedMicroseconds(replay_start, Stopwatch_Measure()) / 1000);
+			if (replay_pendingTime > elapsed) return true;
+		}
+
+		replay_havePending = false;
+		if (!replay_pendingLen) { ReplayConnection_Fail(&corrupt_reason); return false; }
+		res = Stream_Read(&replay_source, replay_packet, replay_pendingLen);
+		if (res) { ReplayConnection_Fail(&corrupt_reason); return false; }
+
+		/* Protocol state during playback matches the recorded session, so sizes should too */
+		opcode  = replay_packet[0];
+		handler = Protocol.Handlers[opcode];
+		if (!handler || Protocol.Sizes[opcode] != replay_pendingLen) {
+			DisconnectInvalidOpcode(opcode); return false;
+		}
+
+		replay_packets++;
+		lastOpcode = opcode;
+		handler(replay_packet + 1); /* skip opcode */
+		if (Server.Disconnected) return false;
+	}
+}
+
+static void ReplayConnection_Tick(struct ScheduledTask* task) {
+	cc_bool connected;
+	if (Server.Disconnected || !replay_playing) return;
+
+	Game_BeginBlockChanges();
+	Lighting_BeginBatch();
+	connected = ReplayConnection_ProcessPackets();
+	Lighting_EndBatch();
+	Game_EndBlockChanges();
+	if (!connected) return;
+
+	if ((ticks++ % 3) == 0) {
+		TexturePack_CheckPending();
+		Protocol_Tick();
+	}
+}
+
+static void ReplayConnection_SendBlock(int x, int y, int z, BlockID old, BlockID now) { }
+static void ReplayConnection_SendChat(const cc_string* text) { }
+static void ReplayConnection_SendData(const cc_uint8* data, cc_uint32 len) { }
+
+static void ReplayConnection_Init(void) {
+	Server_ResetState();
+	Server.IsSinglePlayer = false;
+
+	Server.BeginConnect = ReplayConnection_BeginConnect;
+	Server.Tick         = ReplayConnection_Tick;
+	Server.SendBlock    = ReplayConnection_SendBlock;
+	Server.SendChat     = ReplayConnection_SendChat;
+	Server.SendData     = ReplayConnection_SendData;
+}
+#else
+static void Replay_Close(void) { }
+static void ReplayConnection_Init(void) { SPConnection_Init(); }
+#endif
+
+
 /*########################################################################################################################*
 *---------------------------------------------------Component interface---------------------------------------------------*
 *#########################################################################################################################*/
@@ -503,18 +1141,26 @@ static void OnNewMap(void) {
 	}
 }
 
+static void Server_Tick(struct ScheduledTask* task) {
+	Profiler_Begin(PROFILE_SERVER_TICK);
+	Server.Tick(task);
+	Profiler_End(PROFILE_SERVER_TICK);
+}
+
 static void OnInit(void) {
 	String_InitArray(Server.Name,    nameBuffer);
 	String_InitArray(Server.MOTD,    motdBuffer);
 	String_InitArray(Server.AppName, appBuffer);
 
-	if (!Server.Address.length) {
+	if (Replay_Path.length) {
+		ReplayConnection_Init();
+	} else if (!Server.Address.length) {
 		SPConnection_Init();
 	} else {
 		MPConnection_Init();
 	}
 
-	ScheduledTask_Add(GAME_NET_TICKS, Server.Tick);
+	ScheduledTask_Add(GAME_NET_TICKS, Server_Tick);
 	String_AppendConst(&Server.AppName, GAME_APP_NAME);
 	String_AppendConst(&Server.AppName, Platform_AppNameSuffix);
 
@@ -541,8 +1187,14 @@ static void OnClose(void) {
 		Physics_Free();
 	} else {
 		Ping_Reset();
+		Replay_Close();
 		if (Server.Disconnected) return;
 
+#ifdef CC_BUILD_NETWORKING
+		/* Network thread must stop using the socket before it is closed */
+		NetThread_Stop();
+		MPConnection_CloseAttempts();
+#endif
 		Socket_Close(net_socket);
 		Server.Disconnected = true;
 	}
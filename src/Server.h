@@ -10,6 +10,7 @@ Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 
 struct IGameComponent;
 struct ScheduledTask;
+struct Stream;
 extern struct IGameComponent Server_Component;
 
 /* Prepares a ping entry for sending to the server, then returns its ID */
@@ -71,8 +72,38 @@ CC_VAR extern struct _ServerConnectionData {
 /* Otherwise just calls TexturePack_Extract */
 void Server_RetrieveTexturePack(const cc_string* url);
 
+/* Statistics about the packets sent to and received from a multiplayer server */
+/* (e.g. to find out which packets are taking the most time to process) */
+CC_VAR extern struct _NetStatsData {
+	/* Number of packets and bytes received, for each opcode */
+	cc_uint32 RecvPackets[256];
+	cc_uint64 RecvBytes[256];
+	/* Time spent in packet handlers for each opcode, in Stopwatch_Measure() units */
+	cc_uint64 HandlerTime[256];
+	/* Number of packets and bytes sent, for each opcode */
+	cc_uint32 SentPackets[256];
+	cc_uint64 SentBytes[256];
+	/* Number of network ticks since statistics were reset */
+	cc_uint32 Ticks;
+	/* Number of packets processed in the last tick, and the most processed in one tick */
+	cc_uint32 TickPackets, MaxTickPackets;
+	/* Number of bytes received but not yet processed after the last tick, and the most ever */
+	cc_uint32 Queued, MaxQueued;
+	/* Value of Game.Time when statistics were reset */
+	double ResetTime;
+} NetStats;
+
+/* Resets all network statistics to 0 */
+void NetStats_Reset(void);
+/* Writes the per opcode network statistics to the given stream in CSV format */
+cc_result NetStats_WriteCSV(struct Stream* s);
+
 /* Path of map to automatically load in singleplayer */
 extern cc_string SP_AutoloadMap;
+/* Path of replay file to play back instead of connecting to a server */
+extern cc_string Replay_Path;
+/* Whether replay packets are played back as fast as possible, instead of in real-time */
+extern cc_bool Replay_MaxSpeed;
 
 CC_END_HEADER
 #endif
@@ -289,6 +289,59 @@ void Stream_ReadonlyMemory(struct Stream* s, void* data, cc_uint32 len) {
 	s->meta.mem.base   = (cc_uint8*)data;
 }
 
+static cc_result Stream_GrowableWrite(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	cc_uint32 used = (cc_uint32)(s->meta.mem.cur - s->meta.mem.base);
+	cc_uint32 size;
+	cc_uint8* mem;
+
+	if (count > s->meta.mem.left) {
+		size = max(s->meta.mem.length * 2, used + count);
+		size = max(size, 64 * 1024);
+
+		if (s->meta.mem.base) {
+			mem = (cc_uint8*)Mem_TryRealloc(s->meta.mem.base, size, 1);
+		} else {
+			mem = (cc_uint8*)Mem_TryAlloc(size, 1);
+		}
+		if (!mem) return ERR_OUT_OF_MEMORY;
+
+		s->meta.mem.base   = mem;
+		s->meta.mem.cur    = mem + used;
+		s->meta.mem.left   = size - used;
+		s->meta.mem.length = size;
+	}
+
+	Mem_Copy(s->meta.mem.cur, data, count);
+	s->meta.mem.cur  += count;
+	s->meta.mem.left -= count;
+	*modified = count;
+	return 0;
+}
+
+static cc_result Stream_GrowableSeek(struct Stream* s, cc_uint32 position) {
+	if (position > s->meta.mem.length) return ERR_INVALID_ARGUMENT;
+
+	s->meta.mem.cur  = s->meta.mem.base   + position;
+	s->meta.mem.left = s->meta.mem.length - position;
+	return 0;
+}
+
+static cc_result Stream_GrowablePosition(struct Stream* s, cc_uint32* position) {
+	*position = (cc_uint32)(s->meta.mem.cur - s->meta.mem.base); return 0;
+}
+
+void Stream_WriteonlyMemory(struct Stream* s) {
+	Stream_Init(s);
+	s->Write    = Stream_GrowableWrite;
+	s->Seek     = Stream_GrowableSeek;
+	s->Position = Stream_GrowablePosition;
+
+	s->meta.mem.cur    = NULL;
+	s->meta.mem.left   = 0;
+	s->meta.mem.length = 0;
+	s->meta.mem.base   = NULL;
+}
+
 
 /*########################################################################################################################*
 *----------------------------------------------------BufferedStream-------------------------------------------------------*
@@ -303,6 +356,13 @@ static cc_result Stream_BufferedRead(struct Stream* s, cc_uint8* data, cc_uint32
 		source               = s->meta.buffered.source; 
 		s->meta.buffered.cur = s->meta.buffered.base;
 
+		/* Large reads can bypass the buffer entirely, avoiding an extra copy */
+		if (count >= s->meta.buffered.length) {
+			res = source->Read(source, data, count, modified);
+			if (!res) s->meta.buffered.end += *modified;
+			return res;
+		}
+
 		res = source->Read(source, s->meta.buffered.cur, s->meta.buffered.length, &read);
 		if (res) return res;
 		s->meta.buffered.left  = read;
@@ -353,11 +413,22 @@ static cc_result Stream_BufferedSeek(struct Stream* s, cc_uint32 position) {
 	return res;
 }
 
+static cc_result Stream_BufferedPosition(struct Stream* s, cc_uint32* position) {
+	*position = s->meta.buffered.end - s->meta.buffered.left; return 0;
+}
+
+static cc_result Stream_BufferedLength(struct Stream* s, cc_uint32* length) {
+	struct Stream* source = s->meta.buffered.source;
+	return source->Length(source, length);
+}
+
 void Stream_ReadonlyBuffered(struct Stream* s, struct Stream* source, void* data, cc_uint32 size) {
 	Stream_Init(s);
-	s->Read   = Stream_BufferedRead;
-	s->ReadU8 = Stream_BufferedReadU8;
-	s->Seek   = Stream_BufferedSeek;
+	s->Read     = Stream_BufferedRead;
+	s->ReadU8   = Stream_BufferedReadU8;
+	s->Seek     = Stream_BufferedSeek;
+	s->Position = Stream_BufferedPosition;
+	s->Length   = Stream_BufferedLength;
 
 	s->meta.buffered.left   = 0;
 	s->meta.buffered.end    = 0;
@@ -368,18 +439,68 @@ void Stream_ReadonlyBuffered(struct Stream* s, struct Stream* source, void* data
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------BufferedWriteStream-----------------------------------------------------*
+*#########################################################################################################################*/
+static cc_result Stream_BufferedFlush(struct Stream* s) {
+	struct Stream* dest = s->meta.buffered.source;
+	cc_uint32 len       = (cc_uint32)(s->meta.buffered.cur - s->meta.buffered.base);
+
+	s->meta.buffered.cur  = s->meta.buffered.base;
+	s->meta.buffered.left = s->meta.buffered.length;
+	return len ? Stream_Write(dest, s->meta.buffered.base, len) : 0;
+}
+
+static cc_result Stream_BufferedWrite(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct Stream* dest;
+	cc_result res;
+
+	if (!s->meta.buffered.left) {
+		if ((res = Stream_BufferedFlush(s))) return res;
+	}
+
+	/* Large writes can bypass the buffer entirely, avoiding an extra copy */
+	if (count >= s->meta.buffered.length && s->meta.buffered.left == s->meta.buffered.length) {
+		dest = s->meta.buffered.source;
+		return dest->Write(dest, data, count, modified);
+	}
+
+	count = min(count, s->meta.buffered.left);
+	Mem_Copy(s->meta.buffered.cur, data, count);
+
+	s->meta.buffered.cur  += count;
+	s->meta.buffered.left -= count;
+	*modified = count;
+	return 0;
+}
+
+static cc_result Stream_BufferedClose(struct Stream* s) {
+	struct Stream* dest = s->meta.buffered.source;
+	cc_result res       = Stream_BufferedFlush(s);
+	cc_result closeRes  = dest->Close(dest);
+	return res ? res : closeRes;
+}
+
+void Stream_WriteonlyBuffered(struct Stream* s, struct Stream* dest, void* data, cc_uint32 size) {
+	Stream_Init(s);
+	s->Write = Stream_BufferedWrite;
+	s->Close = Stream_BufferedClose;
+
+	s->meta.buffered.left   = size;
+	s->meta.buffered.end    = 0;
+	s->meta.buffered.cur    = (cc_uint8*)data;
+	s->meta.buffered.base   = (cc_uint8*)data;
+	s->meta.buffered.length = size;
+	s->meta.buffered.source = dest;
+}
+
+
 /*########################################################################################################################*
 *-----------------------------------------------------CRC32Stream---------------------------------------------------------*
 *#########################################################################################################################*/
 static cc_result Stream_Crc32Write(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
 	struct Stream* source;
-	cc_uint32 i, crc32 = stream->meta.crc32.crc32;
-
-	/* TODO: Optimise this calculation */
-	for (i = 0; i < count; i++) {
-		crc32 = Utils_Crc32Table[(crc32 ^ data[i]) & 0xFF] ^ (crc32 >> 8);
-	}
-	stream->meta.crc32.crc32 = crc32;
+	stream->meta.crc32.crc32 = Utils_CRC32Update(stream->meta.crc32.crc32, data, count);
 
 	source = stream->meta.crc32.source;
 	return source->Write(source, data, count, modified);
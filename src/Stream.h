@@ -66,8 +66,17 @@ CC_API void Stream_FromFile(struct Stream* s, cc_file file);
 CC_API void Stream_ReadonlyPortion(struct Stream* s, struct Stream* source, cc_uint32 len);
 /* Wraps a block of memory, allowing reading from and seeking in the block. */
 CC_API void Stream_ReadonlyMemory(struct Stream* s, void* data, cc_uint32 len);
+/* Wraps a block of memory that automatically grows as data is written to it. */
+/* NOTE: Written data is located at s->meta.mem.base, and s->Position gives the current end of it */
+/* NOTE: Closing the stream does NOT free the memory, you must Mem_Free s->meta.mem.base yourself */
+CC_API void Stream_WriteonlyMemory(struct Stream* s);
 /* Wraps another Stream, reading through an intermediary buffer. (Useful for files, since each read call is expensive) */
 CC_API void Stream_ReadonlyBuffered(struct Stream* s, struct Stream* source, void* data, cc_uint32 size);
+/* Wraps another Stream, writing through an intermediary buffer. (Useful for files, since each write call is expensive) */
+/* NOTE: Closing this stream flushes any buffered data, then closes the wrapped stream */
+CC_API void Stream_WriteonlyBuffered(struct Stream* s, struct Stream* dest, void* data, cc_uint32 size);
+/* Default size of the intermediary buffer for buffered file streams */
+#define STREAM_FILE_BUFFER_SIZE (16 * 1024)
 
 /* Wraps another Stream, calculating a running CRC32 as data is written. */
 /* To get the final CRC32, xor it with 0xFFFFFFFFUL */
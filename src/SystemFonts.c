@@ -430,6 +430,11 @@ struct SysFont {
 #ifdef CC_BUILD_DARWIN
 	char filename[FILENAME_SIZE + 1];
 #endif
+	int refCount;       /* number of FontDescs currently using this font */
+	cc_bool cached;     /* whether this font is stored in the font cache */
+	cc_uint32 lastUsed; /* when this font was last released, for evicting from the cache */
+	int size, dpiX, dpiY;
+	cc_string key; char keyBuffer[FILENAME_SIZE + 16];
 };
 
 static unsigned long SysFont_Read(FT_Stream s, unsigned long offset, unsigned char* buffer, unsigned long count) {
@@ -731,6 +736,55 @@ void SysFonts_GetNames(struct StringsBuffer* buffer) {
 	StringsBuffer_Sort(buffer);
 }
 
+/*########################################################################################################################*
+*-------------------------------------------------------Font cache--------------------------------------------------------*
+*#########################################################################################################################*/
+/* Fonts with the same face and size are shared between FontDescs, and recently freed fonts are kept around */
+/*  for a while, so their rasterised glyphs can be reused (e.g. when a menu is reopened or chat is remade) */
+#define SYSFONT_CACHE_SIZE 16
+static struct SysFont* font_cache[SYSFONT_CACHE_SIZE];
+static cc_uint32 font_cacheTime;
+
+static void SysFont_Destroy(struct SysFont* font) {
+	FT_Done_Face(font->face);
+	Mem_Free(font);
+}
+
+static struct SysFont* FontCache_Find(const cc_string* key, int size, int dpiX, int dpiY) {
+	struct SysFont* font;
+	int i;
+
+	for (i = 0; i < SYSFONT_CACHE_SIZE; i++) 
+	{
+		font = font_cache[i];
+		if (!font || font->size != size) continue;
+		if (font->dpiX != dpiX || font->dpiY != dpiY) continue;
+		if (String_Equals(&font->key, key)) return font;
+	}
+	return NULL;
+}
+
+static void FontCache_Add(struct SysFont* font) {
+	struct SysFont* cur;
+	int i, slot = -1;
+
+	for (i = 0; i < SYSFONT_CACHE_SIZE; i++) 
+	{
+		cur = font_cache[i];
+		if (!cur) { slot = i; break; }
+
+		/* Evict the least recently used font that is not currently in use */
+		if (cur->refCount) continue;
+		if (slot == -1 || cur->lastUsed < font_cache[slot]->lastUsed) slot = i;
+	}
+	if (slot == -1) return;
+
+	if (font_cache[slot]) SysFont_Destroy(font_cache[slot]);
+	font_cache[slot] = font;
+	font->cached     = true;
+}
+
+
 #define TEXT_CEIL(x) (((x) + 63) >> 6)
 cc_result SysFont_Make(struct FontDesc* desc, const cc_string* fontName, int size, int flags) {
 	struct SysFont* font;
@@ -748,6 +802,19 @@ cc_result SysFont_Make(struct FontDesc* desc, const cc_string* fontName, int siz
 	String_UNSAFE_Separate(&value, ',', &path, &index);
 	Convert_ParseInt(&index, &faceIndex);
 
+	/* TODO: Use 72 instead of 96 dpi for mobile devices */
+	dpiX = (int)(DisplayInfo.ScaleX * 96);
+	dpiY = (int)(DisplayInfo.ScaleY * 96);
+
+	/* Glyphs only depend on font face and size, other flags apply at draw time */
+	font = FontCache_Find(&value, size, dpiX, dpiY);
+	if (font) {
+		font->refCount++;
+		desc->handle = font;
+		desc->height = TEXT_CEIL(font->face->size->metrics.height);
+		return 0;
+	}
+
 	font = (struct SysFont*)Mem_TryAlloc(1, sizeof(struct SysFont));
 	if (!font) return ERR_OUT_OF_MEMORY;
 
@@ -755,13 +822,22 @@ cc_result SysFont_Make(struct FontDesc* desc, const cc_string* fontName, int siz
 	if ((err = SysFont_Init(&path, font, &args))) { Mem_Free(font); return err; }
 	desc->handle = font;
 
-	/* TODO: Use 72 instead of 96 dpi for mobile devices */
-	dpiX = (int)(DisplayInfo.ScaleX * 96);
-	dpiY = (int)(DisplayInfo.ScaleY * 96);
+	font->refCount = 1;
+	font->cached   = false;
+	font->size     = size;
+	font->dpiX     = dpiX;
+	font->dpiY     = dpiY;
+	String_InitArray(font->key, font->keyBuffer);
 
 	if ((err = FT_New_Face(ft_lib, &args, faceIndex, &font->face)))     return err;
 	if ((err = FT_Set_Char_Size(font->face, size * 64, 0, dpiX, dpiY))) return err;
 
+	/* Fonts with overly long paths are not cached */
+	if (value.length <= font->key.capacity) {
+		String_Copy(&font->key, &value);
+		FontCache_Add(font);
+	}
+
 	/* height of any text when drawn with the given system font */
 	desc->height = TEXT_CEIL(font->face->size->metrics.height);
 	return 0;
@@ -802,8 +878,14 @@ void SysFont_MakeDefault(struct FontDesc* desc, int size, int flags) {
 
 void SysFont_Free(struct FontDesc* desc) {
 	struct SysFont* font = (struct SysFont*)desc->handle;
-	FT_Done_Face(font->face);
-	Mem_Free(font);
+	if (--font->refCount > 0) return;
+
+	/* Cached fonts are only destroyed when evicted from the cache */
+	if (font->cached) {
+		font->lastUsed = ++font_cacheTime;
+	} else {
+		SysFont_Destroy(font);
+	}
 }
 
 int SysFont_TextWidth(struct DrawTextArgs* args) {
@@ -16,6 +16,10 @@
 #include "Utils.h"
 #include "Chat.h" /* TODO avoid this include */
 #include "Errors.h"
+#include "Jobs.h"
+#ifdef CC_BUILD_WEB
+#include <emscripten/emscripten.h>
+#endif
 
 /* Simple fallback terrain for when no texture packs are available at all */
 static BitmapCol fallback_terrain[16 * 8] = {
@@ -80,13 +84,11 @@ TextureRec Atlas1D_TexRec(TextureLoc texLoc, int uCount, int* index) {
 }
 
 
-static void Atlas1D_Load(int index, struct Bitmap* atlas1D) {
-	int tileSize      = Atlas2D.TileSize;
-	int tilesPerAtlas = Atlas1D.TilesPerAtlas;
-	int y, tile = index * tilesPerAtlas;
-	int atlasX, atlasY;
+static void Atlas1D_CopyTiles(int tile, int count, struct Bitmap* atlas1D) {
+	int tileSize = Atlas2D.TileSize;
+	int y, atlasX, atlasY;
 	
-	for (y = 0; y < tilesPerAtlas; y++, tile++) 
+	for (y = 0; y < count; y++, tile++) 
 	{
 		atlasX = Atlas2D_TileX(tile) * tileSize;
 		atlasY = Atlas2D_TileY(tile) * tileSize;
@@ -94,7 +96,17 @@ static void Atlas1D_Load(int index, struct Bitmap* atlas1D) {
 		Bitmap_UNSAFE_CopyBlock(atlasX, atlasY, 0, y * tileSize,
 							&Atlas2D.Bmp, atlas1D, tileSize);
 	}
-	Gfx_RecreateTexture(&Atlas1D.TexIds[index], atlas1D, TEXTURE_FLAG_MANAGED | TEXTURE_FLAG_DYNAMIC, Gfx.Mipmaps);
+}
+
+static void Atlas1D_Load(int index, struct Bitmap* atlas1D) {
+	int tileSize      = Atlas2D.TileSize;
+	int tilesPerAtlas = Atlas1D.TilesPerAtlas;
+	cc_uint8 flags    = TEXTURE_FLAG_MANAGED | TEXTURE_FLAG_DYNAMIC;
+
+	Atlas1D_CopyTiles(index * tilesPerAtlas, tilesPerAtlas, atlas1D);
+	/* Compressed textures can only be updated in 4x4 blocks */
+	if (Gfx.CompressTextures && tileSize >= 4) flags |= TEXTURE_FLAG_COMPRESSED;
+	Gfx_RecreateTexture(&Atlas1D.TexIds[index], atlas1D, flags, Gfx.Mipmaps);
 }
 
 /* TODO: always do this? */
@@ -124,7 +136,35 @@ static void Atlas_Convert2DTo1D(void) {
 }
 #else
 void Atlas1D_Bind(int index) {
-	Gfx_BindTexture(Atlas1D.TexIds[index]);
+	if (Atlas1D.Layers) {
+		Gfx_BindTextureArray(Atlas1D.TexIds[0], Atlas1D.Layers);
+	} else {
+		Gfx_BindTexture(Atlas1D.TexIds[index]);
+	}
+}
+
+static void Atlas1D_LoadLayers(void) {
+	int tileSize      = Atlas2D.TileSize;
+	int layers        = Atlas1D.Layers;
+	int tilesPerLayer = Atlas1D.TilesPerAtlas / layers;
+	struct Bitmap layer;
+	cc_bool mipmaps;
+	int i;
+
+	Platform_Log2("Loaded terrain atlas: %i layers, %i per layer", &layers, &tilesPerLayer);
+	Atlas1D.TexIds[0] = Gfx_CreateTextureArray(tileSize, tilesPerLayer * tileSize, layers,
+								TEXTURE_FLAG_MANAGED | TEXTURE_FLAG_DYNAMIC, Gfx.Mipmaps);
+	if (!Atlas1D.TexIds[0]) return;
+	Bitmap_Allocate(&layer, tileSize, tilesPerLayer * tileSize);
+
+	for (i = 0; i < layers; i++)
+	{
+		Atlas1D_CopyTiles(i * tilesPerLayer, tilesPerLayer, &layer);
+		/* GPU generates mipmaps for all the layers at once */
+		mipmaps = Gfx.Mipmaps && (!Gfx.GpuMipmaps || i == layers - 1);
+		Gfx_UpdateTextureArray(Atlas1D.TexIds[0], 0, 0, i, &layer, tileSize, mipmaps);
+	}
+	Mem_Free(layer.scan0);
 }
 
 static void Atlas_Convert2DTo1D(void) {
@@ -134,6 +174,7 @@ static void Atlas_Convert2DTo1D(void) {
 	struct Bitmap atlas1D;
 	int i;
 
+	if (Atlas1D.Layers) { Atlas1D_LoadLayers(); return; }
 	Platform_Log2("Loaded terrain atlas: %i bmps, %i per bmp", &atlasesCount, &tilesPerAtlas);
 	Bitmap_Allocate(&atlas1D, tileSize, tilesPerAtlas * tileSize);
 	
@@ -162,21 +203,61 @@ static void Atlas_Update1D(void) {
 
 	Atlas1D.TilesPerAtlas = min(maxTilesPerAtlas, maxTiles);
 	Atlas1D.Count = Math_CeilDiv(maxTiles, Atlas1D.TilesPerAtlas);
+	Atlas1D.Layers = 0;
+
+#ifndef CC_BUILD_LOWMEM
+	/* Store all the 1D atlases as layers of one texture array instead, so that world */
+	/*  geometry isn't split up per 1D atlas and can be drawn with fewer draw calls */
+	/* NOTE: Texture arrays support at least 64 layers, which is enough for 512x512 tiles */
+	if (Gfx.SupportsTextureArrays && Atlas1D.Count > 1 && Atlas1D.Count <= 64) {
+		Atlas1D.Layers         = Atlas1D.Count;
+		Atlas1D.TilesPerAtlas *= Atlas1D.Count;
+		Atlas1D.Count          = 1;
+	}
+#endif
 
 	Atlas1D.InvTileSize = 1.0f / Atlas1D.TilesPerAtlas;
 	Atlas1D.Mask  = Atlas1D.TilesPerAtlas - 1;
 	Atlas1D.Shift = Math_ilog2(Atlas1D.TilesPerAtlas);
 }
 
+static cc_bool Atlas2D_HasUniformRows(TextureLoc texLoc) {
+	int size = Atlas2D.TileSize;
+	int x = Atlas2D_TileX(texLoc) * size, y = Atlas2D_TileY(texLoc) * size;
+	BitmapCol* first = Bitmap_GetRow(&Atlas2D.Bmp, y) + x;
+	int i;
+
+	for (i = 1; i < size; i++) 
+	{
+		if (!Mem_Equal(first, Bitmap_GetRow(&Atlas2D.Bmp, y + i) + x, size * BITMAPCOLOR_SIZE)) return false;
+	}
+	return true;
+}
+
+static void Atlas2D_CalcUniformRows(void) {
+	int i, tiles = Atlas2D.RowsCount * ATLAS2D_TILES_PER_ROW;
+
+	for (i = 0; i < ATLAS1D_MAX_ATLASES; i++) 
+	{
+		Atlas2D.UniformRows[i] = i < tiles && Atlas2D_HasUniformRows(i);
+	}
+}
+
 /* Loads the given atlas and converts it into an array of 1D atlases. */
 static void Atlas_Update(struct Bitmap* bmp) {
 	Atlas2D.Bmp       = *bmp;
 	Atlas2D.TileSize  = bmp->width  / ATLAS2D_TILES_PER_ROW;
 	Atlas2D.RowsCount = bmp->height / Atlas2D.TileSize;
 	Atlas2D.RowsCount = min(Atlas2D.RowsCount, ATLAS2D_MAX_ROWS_COUNT);
+	Atlas2D_CalcUniformRows();
 
 	Atlas_Update1D();
 	Atlas_Convert2DTo1D();
+
+	/* NOTE: Mipmaps use roughly another third of the base texture size */
+	Game_VRAMUsage[VRAM_ATLASES] = Bitmap_DataSize(Atlas2D.TileSize, Atlas2D.TileSize) 
+									* Atlas1D.TilesPerAtlas * Atlas1D.Count;
+	if (Gfx.Mipmaps) Game_VRAMUsage[VRAM_ATLASES] += Game_VRAMUsage[VRAM_ATLASES] / 3;
 }
 
 GfxResourceID Atlas2D_LoadTile(TextureLoc texLoc) {
@@ -205,6 +286,7 @@ static void Atlas1D_Free(void) {
 	for (i = 0; i < Atlas1D.Count; i++) {
 		Gfx_DeleteTexture(&Atlas1D.TexIds[i]);
 	}
+	Game_VRAMUsage[VRAM_ATLASES] = 0;
 }
 
 cc_bool Atlas_TryChange(struct Bitmap* atlas) {
@@ -263,12 +345,15 @@ static struct StringsBuffer acceptedList, deniedList, etagCache, lastModCache;
 #define ETAGS_TXT    "texturecache/etags.txt"
 #define LASTMOD_TXT  "texturecache/lastmodified.txt"
 
+static void CacheIndex_Init(void);
+
 /* Initialises cache state (loading various lists) */
 static void TextureCache_Init(void) {
 	EntryList_UNSAFE_Load(&acceptedList, ACCEPTED_TXT);
 	EntryList_UNSAFE_Load(&deniedList,   DENIED_TXT);
 	EntryList_UNSAFE_Load(&etagCache,    ETAGS_TXT);
 	EntryList_UNSAFE_Load(&lastModCache, LASTMOD_TXT);
+	CacheIndex_Init();
 }
 
 cc_bool TextureCache_HasAccepted(const cc_string* url) { return EntryList_Find(&acceptedList, url, ' ') >= 0; }
@@ -318,26 +403,305 @@ static cc_bool UseDedicatedCache(cc_string* path, const cc_string* key) {
 	return !cacheInvalid;
 }
 
-CC_NOINLINE static void MakeCachePath(cc_string* mainPath, cc_string* altPath, const cc_string* url) {
-	cc_string key; char keyBuffer[STRING_INT_CHARS];
-	String_InitArray(key, keyBuffer);
-	HashUrl(&key, url);
-	
-	if (UseDedicatedCache(mainPath, &key)) {
+static void MakeKeyCachePath(cc_string* mainPath, cc_string* altPath, const cc_string* key) {
+	if (UseDedicatedCache(mainPath, key)) {
 		/* If using dedicated cache directory, also fallback to default cache directory */
 		String_Format1(altPath,  "texturecache/%s",  &key);
 	} else {
 		mainPath->length = 0;
-		String_Format1(mainPath, "texturecache/%s",  &key);
+		String_Format1(mainPath, "texturecache/%s",  key);
 	}
 }
 
+CC_NOINLINE static void MakeCachePath(cc_string* mainPath, cc_string* altPath, const cc_string* url) {
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
+	String_InitArray(key, keyBuffer);
+	HashUrl(&key, url);
+	MakeKeyCachePath(mainPath, altPath, &key);
+}
+
+/* The size and last access time of each cached pack are tracked in an index, so that the least recently */
+/*  used packs can be evicted once the total size of the cache exceeds the texture-cache-size option */
+/* Entries are formatted as "[key] [size in bytes] [last accessed, in seconds since unix epoch]" */
+static struct StringsBuffer cacheIndex;
+static cc_uint64 cacheLimit;
+static cc_bool cacheScanned; /* Whether index has been checked against the cache directories yet */
+#define INDEX_TXT "texturecache/cacheindex.txt"
+
+static cc_uint32 CacheIndex_Now(void) {
+	return (cc_uint32)(DateTime_CurrentUTC() - UNIX_EPOCH_SECONDS);
+}
+
+static void CacheIndex_ParseValue(const cc_string* value, cc_uint32* size, cc_uint32* accessed) {
+	cc_string sizeStr, timeStr;
+	cc_uint64 tmp;
+	String_UNSAFE_Separate(value, ' ', &sizeStr, &timeStr);
+
+	*size     = Convert_ParseUInt64(&sizeStr, &tmp) ? (cc_uint32)tmp : 0;
+	*accessed = Convert_ParseUInt64(&timeStr, &tmp) ? (cc_uint32)tmp : 0;
+}
+
+static void CacheIndex_Set(struct StringsBuffer* list, const cc_string* key, cc_uint32 size, cc_uint32 accessed) {
+	cc_string value; char valueBuffer[STRING_INT_CHARS * 2];
+	String_InitArray(value, valueBuffer);
+
+	String_AppendUInt32(&value, size);
+	String_Append(&value, ' ');
+	String_AppendUInt32(&value, accessed);
+	EntryList_Set(list, key, &value, ' ');
+}
+
+static struct Job evictJob;
+static struct StringsBuffer evictPaths;
+static cc_bool evicting;
+
+static void CacheEvict_Run(struct Job* job) {
+	cc_string path;
+	cc_filepath str;
+	int i;
+
+	/* Platform lacks a way to delete files, so truncate to indicate no cached data instead */
+	for (i = 0; i < evictPaths.count; i++)
+	{
+		path = StringsBuffer_UNSAFE_Get(&evictPaths, i);
+		Platform_EncodePath(&str, &path);
+		if (File_Exists(&str)) (void)Stream_WriteAllTo(&path, NULL, 0);
+	}
+}
+
+static void CacheEvict_Complete(struct Job* job) {
+	StringsBuffer_Clear(&evictPaths);
+	evicting = false;
+}
+
+static void CacheIndex_Evict(int i) {
+	cc_string mainPath; char mainBuffer[FILENAME_SIZE];
+	cc_string altPath;  char  altBuffer[FILENAME_SIZE];
+	cc_string entry, key, value;
+	String_InitArray(mainPath, mainBuffer);
+	String_InitArray(altPath,   altBuffer);
+
+	StringsBuffer_UNSAFE_GetRaw(&cacheIndex, i, &entry);
+	String_UNSAFE_Separate(&entry, ' ', &key, &value);
+	MakeKeyCachePath(&mainPath, &altPath, &key);
+
+	StringsBuffer_Add(&evictPaths, &mainPath);
+	if (altPath.length) StringsBuffer_Add(&evictPaths, &altPath);
+
+	EntryList_Remove(&etagCache,    &key, ' ');
+	EntryList_Remove(&lastModCache, &key, ' ');
+	StringsBuffer_Remove(&cacheIndex, i);
+}
+
+/* Evicts least recently used packs until the total size of the cache is below the limit */
+static void CacheIndex_CheckLimit(void) {
+	cc_uint32 size, accessed, oldestAccessed;
+	cc_uint64 total = 0;
+	cc_string entry, key, value;
+	int i, oldest;
+	if (!cacheLimit || !cacheScanned || evicting) return;
+
+	for (i = 0; i < cacheIndex.count; i++)
+	{
+		StringsBuffer_UNSAFE_GetRaw(&cacheIndex, i, &entry);
+		String_UNSAFE_Separate(&entry, ' ', &key, &value);
+		CacheIndex_ParseValue(&value, &size, &accessed);
+		total += size;
+	}
+
+	/* The most recently used pack is always kept, even if it is larger than the limit by itself */
+	while (total > cacheLimit && cacheIndex.count > 1)
+	{
+		oldest = 0; oldestAccessed = 0;
+		for (i = 0; i < cacheIndex.count; i++)
+		{
+			StringsBuffer_UNSAFE_GetRaw(&cacheIndex, i, &entry);
+			String_UNSAFE_Separate(&entry, ' ', &key, &value);
+			CacheIndex_ParseValue(&value, &size, &accessed);
+			if (i && accessed >= oldestAccessed) continue;
+
+			oldest = i; oldestAccessed = accessed;
+		}
+
+		StringsBuffer_UNSAFE_GetRaw(&cacheIndex, oldest, &entry);
+		String_UNSAFE_Separate(&entry, ' ', &key, &value);
+		CacheIndex_ParseValue(&value, &size, &accessed);
+
+		total -= size;
+		CacheIndex_Evict(oldest);
+	}
+	if (!evictPaths.count) return;
+
+	EntryList_Save(&cacheIndex,   INDEX_TXT);
+	EntryList_Save(&etagCache,    ETAGS_TXT);
+	EntryList_Save(&lastModCache, LASTMOD_TXT);
+
+	/* Truncating files can be slow when there are many of them, so do it in the background */
+	evicting = true;
+	evictJob.Run      = CacheEvict_Run;
+	evictJob.Complete = CacheEvict_Complete;
+	evictJob.Priority = JOB_PRIORITY_LOW;
+	Jobs_Submit(&evictJob);
+}
+
+/* Records that the cached data for the given URL was just used */
+static void CacheIndex_Touch(const cc_string* url, cc_uint32 size) {
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
+	String_InitArray(key, keyBuffer);
+	HashUrl(&key, url);
+
+	CacheIndex_Set(&cacheIndex, &key, size, CacheIndex_Now());
+	EntryList_Save(&cacheIndex, INDEX_TXT);
+	CacheIndex_CheckLimit();
+}
+
+static void CacheIndex_Remove(const cc_string* url) {
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
+	String_InitArray(key, keyBuffer);
+	HashUrl(&key, url);
+	if (EntryList_Remove(&cacheIndex, &key, ' ')) EntryList_Save(&cacheIndex, INDEX_TXT);
+}
+
+/* The cache directories are scanned once in the background on startup, to pick up packs cached */
+/*  by older versions and to drop entries whose files were deleted by something else */
+static struct Job scanJob;
+static struct StringsBuffer scanDirs, scanFound;
+static cc_uint32 scanStarted;
+
+static void CacheScan_Callback(const cc_string* path, void* obj, int isDirectory) {
+	cc_string name = *path;
+	cc_uint32 size, extra, accessed;
+	cc_string value;
+	struct Stream stream;
+	int i;
+	if (isDirectory) return;
+
+	/* Cached packs are named by the CRC32 of their URL */
+	Utils_UNSAFE_GetFilename(&name);
+	if (!name.length) return;
+	for (i = 0; i < name.length; i++) 
+	{
+		if (name.buffer[i] < '0' || name.buffer[i] > '9') return;
+	}
+
+	if (Stream_OpenFile(&stream, path)) return;
+	if (stream.Length(&stream, &size)) size = 0;
+	(void)stream.Close(&stream);
+	if (!size) return;
+
+	/* Same pack may be in both the dedicated and default cache directory */
+	value = EntryList_UNSAFE_Get(&scanFound, &name, ' ');
+	CacheIndex_ParseValue(&value, &extra, &accessed);
+	CacheIndex_Set(&scanFound, &name, size + extra, 0);
+}
+
+static void CacheScan_Run(struct Job* job) {
+	cc_string dir;
+	int i;
+
+	for (i = 0; i < scanDirs.count; i++)
+	{
+		dir = StringsBuffer_UNSAFE_Get(&scanDirs, i);
+		Directory_Enum(&dir, NULL, CacheScan_Callback);
+	}
+}
+
+static void CacheScan_Complete(struct Job* job) {
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
+	cc_uint32 size, accessed, unused;
+	cc_string entry, name, value;
+	int i;
+
+	/* Packs cached before the index existed are treated as the least recently used */
+	/* NOTE: Setting an entry moves it to the end of the list */
+	for (i = scanFound.count; i > 0; i--)
+	{
+		StringsBuffer_UNSAFE_GetRaw(&scanFound, 0, &entry);
+		String_UNSAFE_Separate(&entry, ' ', &name, &value);
+		CacheIndex_ParseValue(&value, &size, &unused);
+
+		/* Key must be copied, since the entry is removed before being added back */
+		String_InitArray(key, keyBuffer);
+		String_AppendString(&key, &name);
+
+		value = EntryList_UNSAFE_Get(&cacheIndex, &key, ' ');
+		CacheIndex_ParseValue(&value, &unused, &accessed);
+		CacheIndex_Set(&scanFound, &key, size, accessed);
+	}
+
+	/* Packs cached while the scan was running are kept too */
+	for (i = 0; i < cacheIndex.count; i++)
+	{
+		StringsBuffer_UNSAFE_GetRaw(&cacheIndex, i, &entry);
+		String_UNSAFE_Separate(&entry, ' ', &name, &value);
+		CacheIndex_ParseValue(&value, &size, &accessed);
+
+		if (accessed < scanStarted || EntryList_Find(&scanFound, &name, ' ') >= 0) continue;
+		StringsBuffer_Add(&scanFound, &entry);
+	}
+
+	StringsBuffer_Clear(&cacheIndex);
+	for (i = 0; i < scanFound.count; i++)
+	{
+		StringsBuffer_UNSAFE_GetRaw(&scanFound, i, &entry);
+		StringsBuffer_Add(&cacheIndex, &entry);
+	}
+
+	StringsBuffer_Clear(&scanFound);
+	StringsBuffer_Clear(&scanDirs);
+	EntryList_Save(&cacheIndex, INDEX_TXT);
+
+	cacheScanned = true;
+	CacheIndex_CheckLimit();
+}
+
+static void CacheIndex_Init(void) {
+	static const cc_string defDir = String_FromConst("texturecache");
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	int limit;
+
+	StringsBuffer_Clear(&cacheIndex);
+	EntryList_UNSAFE_Load(&cacheIndex, INDEX_TXT);
+	if (Platform_ReadonlyFilesystem) return;
+	limit      = Options_GetInt(OPT_TEXTURE_CACHE_SIZE, 0, 1024 * 1024, 1024);
+	cacheLimit = (cc_uint64)limit * 1024 * 1024;
+
+	/* Game may be started again before the previous scan finished */
+	if (scanJob.Status == JOB_STATUS_QUEUED || scanJob.Status == JOB_STATUS_RUNNING) return;
+	String_InitArray(path, pathBuffer);
+	Directory_GetCachePath(&path);
+	if (path.length) {
+		String_AppendConst(&path, "/texturecache");
+		StringsBuffer_Add(&scanDirs, &path);
+	}
+	StringsBuffer_Add(&scanDirs, &defDir);
+
+	scanStarted      = CacheIndex_Now();
+	scanJob.Run      = CacheScan_Run;
+	scanJob.Complete = CacheScan_Complete;
+	scanJob.Priority = JOB_PRIORITY_LOW;
+	Jobs_Submit(&scanJob);
+}
+
 /* Returns non-zero if given URL has been cached */
 static int IsCached(const cc_string* url) {
 	cc_string mainPath; char mainBuffer[FILENAME_SIZE];
 	cc_string altPath;  char  altBuffer[FILENAME_SIZE];
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
 	cc_filepath mainStr, altStr;
+	cc_uint32 size, accessed;
+	cc_string value;
+
+	if (cacheScanned) {
+		String_InitArray(key, keyBuffer);
+		HashUrl(&key, url);
+		value = EntryList_UNSAFE_Get(&cacheIndex, &key, ' ');
+
+		CacheIndex_ParseValue(&value, &size, &accessed);
+		return size != 0;
+	}
 	
+	/* Index might still be missing packs cached by older versions */
 	String_InitArray(mainPath, mainBuffer);
 	String_InitArray(altPath,   altBuffer);
 
@@ -352,6 +716,7 @@ static int IsCached(const cc_string* url) {
 static cc_bool OpenCachedData(const cc_string* url, struct Stream* stream) {
 	cc_string mainPath; char mainBuffer[FILENAME_SIZE];
 	cc_string altPath;  char  altBuffer[FILENAME_SIZE];
+	cc_uint32 length;
 	cc_result res;
 	String_InitArray(mainPath, mainBuffer);
 	String_InitArray(altPath,   altBuffer);
@@ -366,6 +731,13 @@ static cc_bool OpenCachedData(const cc_string* url, struct Stream* stream) {
 
 	if (res == ReturnCode_FileNotFound) return false;
 	if (res) { Logger_SysWarn2(res, "opening cache for", url); return false; }
+
+	/* Data of incomplete downloads is truncated to be empty */
+	if (!stream->Length(stream, &length) && !length) {
+		(void)stream->Close(stream); return false;
+	}
+
+	if (!Platform_ReadonlyFilesystem) CacheIndex_Touch(url, length);
 	return true;
 }
 
@@ -405,27 +777,560 @@ CC_NOINLINE static void SetCachedTag(const cc_string* url, struct StringsBuffer*
 	EntryList_Save(list, file);
 }
 
+CC_NOINLINE static void ClearCachedTag(const cc_string* url, struct StringsBuffer* list, const char* file) {
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
+	String_InitArray(key, keyBuffer);
+
+	HashUrl(&key, url);
+	if (EntryList_Remove(list, &key, ' ')) EntryList_Save(list, file);
+}
+
+/* Updates cached ETag and Last-Modified for the given URL */
+static void UpdateCachedTags(const cc_string* url, struct HttpRequest* req) {
+	cc_string value;
+	value = String_FromRawArray(req->etag);
+	SetCachedTag(url, &etagCache,    &value, ETAGS_TXT);
+	value = String_FromRawArray(req->lastModified);
+	SetCachedTag(url, &lastModCache, &value, LASTMOD_TXT);
+}
+
+static void OnPackCached(const cc_string* path, cc_result res, void* obj) {
+	if (res) Logger_SysWarn2(res, "caching", path);
+}
+
 /* Updates cached data, ETag, and Last-Modified for the given URL */
 static void UpdateCache(struct HttpRequest* req) {
-	cc_string url, altPath, value;
+	cc_string url, altPath;
 	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_uint8* data;
 	cc_result res;
 	url = String_FromRawArray(req->url);
-
-	value = String_FromRawArray(req->etag);
-	SetCachedTag(&url, &etagCache,    &value, ETAGS_TXT);
-	value = String_FromRawArray(req->lastModified);
-	SetCachedTag(&url, &lastModCache, &value, LASTMOD_TXT);
+	UpdateCachedTags(&url, req);
 
 	String_InitArray(path, pathBuffer);
 	altPath = String_Empty;
 	MakeCachePath(&path, &altPath, &url);
+	CacheIndex_Touch(&url, req->size);
 
-	res = Stream_WriteAllTo(&path, req->data, req->size);
-	if (res) { Logger_SysWarn2(res, "caching", &url); }
+	/* Write the cached copy in the background, since req->data is still needed for applying the pack */
+	data = (cc_uint8*)Mem_TryAlloc(req->size, 1);
+	if (data) {
+		Mem_Copy(data, req->data, req->size);
+		File_WriteAllAsync(&path, data, req->size, OnPackCached, NULL);
+	} else {
+		res = Stream_WriteAllTo(&path, req->data, req->size);
+		if (res) { Logger_SysWarn2(res, "caching", &url); }
+	}
 }
 
 
+/*########################################################################################################################*
+*------------------------------------------------Background terrain decoding----------------------------------------------*
+*#########################################################################################################################*/
+/* Decoding a large terrain.png can take hundreds of milliseconds, so for downloaded texture packs it is instead */
+/*  decoded on a background thread, with only the final texture upload left to TexturePack_CheckPending */
+#if !defined CC_BUILD_COOPTHREADED && (!defined CC_BUILD_WEB || defined CC_BUILD_WEBTHREADS) && !defined CC_BUILD_TINYSTACK
+#define TERRAIN_DECODE_THREADED
+#endif
+static cc_bool needReload;
+
+#ifdef TERRAIN_DECODE_THREADED
+static cc_bool terrain_async; /* Whether terrain.png should be decoded in the background */
+static void* terrain_thread;
+static volatile cc_bool terrain_done;
+static cc_uint8* terrain_data;
+static cc_uint32 terrain_size;
+static struct Bitmap terrain_bmp;
+static cc_result terrain_res;
+
+/* Rows are decoded straight into the final atlas bitmap, which is only allocated once the size is known */
+static BitmapCol* TerrainDecode_GetRow(struct Bitmap* bmp, int row, void* ctx) {
+	if (row == 0) {
+		terrain_bmp.scan0 = (BitmapCol*)Mem_TryAlloc(bmp->width * bmp->height, BITMAPCOLOR_SIZE);
+	}
+	if (!terrain_bmp.scan0) return NULL;
+	return Bitmap_GetRow(&terrain_bmp, row);
+}
+
+static void TerrainDecode_Run(void) {
+	struct Stream mem;
+	Stream_ReadonlyMemory(&mem, terrain_data, terrain_size);
+
+	terrain_bmp.scan0 = NULL;
+	terrain_res = Png_DecodeRows(&terrain_bmp, &mem, TerrainDecode_GetRow, NULL);
+	if (!terrain_res && !terrain_bmp.scan0) terrain_res = ERR_OUT_OF_MEMORY;
+	terrain_done = true;
+}
+
+/* Waits for terrain.png to finish decoding, then changes to it if apply is true */
+static void TerrainDecode_Finish(cc_bool apply) {
+	static const cc_string terrain = String_FromConst("terrain.png");
+	if (!terrain_thread) return;
+
+	Thread_Join(terrain_thread);
+	terrain_thread = NULL;
+	Mem_Free(terrain_data);
+	terrain_data = NULL;
+
+	if (apply) {
+		if (terrain_res) {
+			Logger_SysWarn2(terrain_res, "decoding", &terrain);
+		} else if (Gfx.LostContext) {
+			/* Context was lost while decoding, so reload texture pack once context is restored */
+			needReload = true;
+		} else if (Atlas_TryChange(&terrain_bmp)) {
+			return;
+		}
+	}
+	Mem_Free(terrain_bmp.scan0);
+	terrain_bmp.scan0 = NULL;
+}
+
+/* Reads all of the PNG data from the given stream, then starts decoding it in the background */
+static cc_result TerrainDecode_Start(struct Stream* stream) {
+	cc_uint32 read, capacity = 64 * 1024;
+	cc_uint8* data;
+	cc_result res;
+
+	TerrainDecode_Finish(false);
+	terrain_size = 0;
+	terrain_data = (cc_uint8*)Mem_TryAlloc(capacity, 1);
+	if (!terrain_data) return ERR_OUT_OF_MEMORY;
+
+	for (;;) {
+		if (terrain_size == capacity) {
+			capacity *= 2;
+			data = (cc_uint8*)Mem_TryRealloc(terrain_data, capacity, 1);
+			if (!data) { res = ERR_OUT_OF_MEMORY; break; }
+			terrain_data = data;
+		}
+
+		res = stream->Read(stream, terrain_data + terrain_size, capacity - terrain_size, &read);
+		if (res || !read) break;
+		terrain_size += read;
+	}
+
+	if (res) {
+		Mem_Free(terrain_data);
+		terrain_data = NULL;
+		return res;
+	}
+
+	terrain_done = false;
+	Thread_Run(&terrain_thread, TerrainDecode_Run, 128 * 1024, "Terrain decode");
+	return 0;
+}
+
+/* Starts decoding the given stream in the background if it is a PNG image */
+static cc_result TerrainDecode_TryStart(struct Stream* stream) {
+	cc_uint8 sig[PNG_SIG_SIZE];
+	cc_result res;
+
+	if ((res = Stream_Read(stream, sig, PNG_SIG_SIZE))) return res;
+	if (!Png_Detect(sig, PNG_SIG_SIZE)) return PNG_ERR_INVALID_SIG;
+
+	if ((res = stream->Seek(stream, 0))) return res;
+	return TerrainDecode_Start(stream);
+}
+
+/* Applies terrain.png if it has finished decoding in the background */
+static void TerrainDecode_Poll(void) {
+	if (terrain_thread && terrain_done) TerrainDecode_Finish(true);
+}
+
+cc_bool Atlas_IsDecoding(void) { return terrain_thread != NULL; }
+#define TerrainDecode_SetAsync(async) terrain_async = async
+#else
+#define TerrainDecode_Finish(apply)
+#define TerrainDecode_Poll()
+#define TerrainDecode_SetAsync(async)
+
+cc_bool Atlas_IsDecoding(void) { return false; }
+#endif
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Parallel PNG decoding--------------------------------------------------*
+*#########################################################################################################################*/
+/* The PNG images used from a .zip texture pack are inflated and decoded on multiple threads at once, */
+/*  with the decoded images then handed out in archive order as each entry is processed on the main thread */
+#ifdef TERRAIN_DECODE_THREADED
+#define PNG_DECODE_THREADED
+#define PNG_DECODE_THREADS  3
+#define PNG_DECODE_MAX_JOBS 64
+#define PNG_DECODE_MAX_DATA (16 * 1024 * 1024)
+
+struct PngDecodeJob {
+	struct ZipEntry* source; /* .zip entry the data was read from */
+	cc_uint8* data;          /* Data of the entry, possibly still compressed */
+	cc_uint32 size;
+	int method;              /* Compression method of the data */
+	struct Bitmap bmp;
+	cc_result res;
+};
+static struct PngDecodeJob pngJobs[PNG_DECODE_MAX_JOBS];
+static int pngJobsCount, pngJobsNext;
+static void* pngJobsMutex;
+
+/* Job and stream for the .zip entry currently being processed */
+static struct PngDecodeJob* pngCurJob;
+static struct Stream* pngCurStream;
+
+static void PngDecode_RunJob(struct PngDecodeJob* job) {
+	struct Stream mem, compStream;
+	struct InflateState* inflate;
+	cc_uint8* data;
+	Stream_ReadonlyMemory(&mem, job->data, job->size);
+
+	if (job->method == 0) {
+		job->res = Png_Decode(&job->bmp, &mem);
+		return;
+	}
+
+	/* Size is known from the .zip entry, so decompress straight into memory */
+	if (job->source->UncompressedSize) {
+		data = (cc_uint8*)Mem_TryAlloc(job->source->UncompressedSize, 1);
+		if (!data) { job->res = ERR_OUT_OF_MEMORY; return; }
+
+		job->res = Inflate_ToBuffer(job->data, job->size, data, job->source->UncompressedSize);
+		if (!job->res) {
+			Stream_ReadonlyMemory(&mem, data, job->source->UncompressedSize);
+			job->res = Png_Decode(&job->bmp, &mem);
+		}
+		Mem_Free(data);
+		return;
+	}
+
+	inflate = (struct InflateState*)Mem_TryAlloc(1, sizeof(struct InflateState));
+	if (!inflate) { job->res = ERR_OUT_OF_MEMORY; return; }
+
+	Inflate_MakeStream2(&compStream, inflate, &mem);
+	job->res = Png_Decode(&job->bmp, &compStream);
+	Mem_Free(inflate);
+}
+
+static void PngDecode_RunJobs(void) {
+	int i;
+	for (;;)
+	{
+		Mutex_Lock(pngJobsMutex);
+		{
+			i = pngJobsNext < pngJobsCount ? pngJobsNext++ : -1;
+		}
+		Mutex_Unlock(pngJobsMutex);
+
+		if (i < 0) return;
+		PngDecode_RunJob(&pngJobs[i]);
+	}
+}
+
+/* Decodes all of the queued jobs, using multiple threads when there is more than one job */
+static void PngDecode_RunAll(void) {
+	void* threads[PNG_DECODE_THREADS];
+	int i, count = min(pngJobsCount - 1, PNG_DECODE_THREADS);
+
+	if (count <= 0) {
+		for (i = 0; i < pngJobsCount; i++) PngDecode_RunJob(&pngJobs[i]);
+		return;
+	}
+
+	pngJobsNext  = 0;
+	pngJobsMutex = Mutex_Create("PNG decode jobs");
+	for (i = 0; i < count; i++) 
+	{
+		Thread_Run(&threads[i], PngDecode_RunJobs, 128 * 1024, "PNG decode");
+	}
+
+	/* Main thread also decodes while waiting */
+	PngDecode_RunJobs();
+	for (i = 0; i < count; i++) Thread_Join(threads[i]);
+
+	Mutex_Free(pngJobsMutex);
+	pngJobsMutex = NULL;
+}
+
+/* Frees all of the queued jobs, including any decoded images that were never used */
+static void PngDecode_Reset(void) {
+	int i;
+	for (i = 0; i < pngJobsCount; i++) 
+	{
+		Mem_Free(pngJobs[i].data);
+		Mem_Free(pngJobs[i].bmp.scan0);
+	}
+
+	pngJobsCount = 0;
+	pngCurJob    = NULL;
+	pngCurStream = NULL;
+}
+
+static void PngDecode_SetEntry(struct Stream* stream, struct ZipEntry* source) {
+	int i;
+	pngCurJob    = NULL;
+	pngCurStream = stream;
+
+	for (i = 0; i < pngJobsCount && source; i++) 
+	{
+		if (pngJobs[i].source == source) pngCurJob = &pngJobs[i];
+	}
+}
+
+/* Decodes a PNG image from the given stream, or hands out the already decoded image if there is one */
+static cc_result DecodePng(struct Bitmap* bmp, struct Stream* stream) {
+	struct PngDecodeJob* job = pngCurJob;
+	if (!job || stream != pngCurStream) return Png_Decode(bmp, stream);
+
+	/* The Bitmap is now owned by the caller */
+	*bmp = job->bmp;
+	job->bmp.scan0 = NULL;
+	pngCurJob      = NULL;
+	return job->res;
+}
+#else
+#define PngDecode_Reset()
+#define PngDecode_SetEntry(stream, source)
+#define DecodePng(bmp, stream) Png_Decode(bmp, stream)
+#endif
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Decoded textures cache--------------------------------------------------*
+*#########################################################################################################################*/
+/* Images decoded from the default and user selected texture packs are stored uncompressed in a cache file, */
+/*  so later startups can skip inflating and PNG decoding them. Entries are keyed by CRC32 and size of the .zip entry */
+#if !defined CC_BUILD_WEB && !defined CC_BUILD_LOWMEM && !defined CC_BUILD_CONSOLE
+#define DECODED_CACHE
+#define DECODED_CACHE_PATH "texturecache/decoded.bin"
+#define DECODED_CACHE_MAGIC   0x43434454UL /* "CCDT" */
+#define DECODED_CACHE_VERSION (1 + BITMAPCOLOR_SIZE * 256)
+#define DECODED_CACHE_HEADER  4 * 4
+#define DECODED_CACHE_MAX_SIZE (32 * 1024 * 1024)
+#define DECODED_CACHE_MAX_ENTRIES 64
+#define DecodedCache_PixelsSize(width, height) ((cc_uint32)(width) * (cc_uint32)(height) * BITMAPCOLOR_SIZE)
+
+/* Cache file is laid out as: (all values are 32 bit little endian) */
+/*  [magic] [version] [number of entries] [reserved] */
+/*  then for each entry: [crc32] [size] [width] [height] [pixels] */
+static struct DecodedEntry {
+	cc_uint32 crc32, size;
+	struct Bitmap bmp;
+	cc_bool used, owned; /* owned is whether bmp.scan0 needs to be freed */
+} decodedEntries[DECODED_CACHE_MAX_ENTRIES];
+static int decodedCount, decodedQueries;
+static cc_uint8* decodedData;
+static cc_bool decodedActive, decodedDirty;
+static cc_uint32 decodedTotal;
+
+/* .zip entry currently being processed */
+static struct Stream* decodedStream;
+static struct ZipEntry* decodedSource;
+
+static void DecodedCache_Parse(cc_uint8* data, cc_uint32 len) {
+	struct DecodedEntry* e;
+	cc_uint32 count, offset = DECODED_CACHE_HEADER, pixels;
+	int width, height;
+
+	if (len < DECODED_CACHE_HEADER) return;
+	if (Stream_GetU32_LE(data + 0) != DECODED_CACHE_MAGIC)   return;
+	if (Stream_GetU32_LE(data + 4) != DECODED_CACHE_VERSION) return;
+	count = Stream_GetU32_LE(data + 8);
+
+	while (count-- && decodedCount < DECODED_CACHE_MAX_ENTRIES && offset + 16 <= len) 
+	{
+		width  = (int)Stream_GetU32_LE(data + offset +  8);
+		height = (int)Stream_GetU32_LE(data + offset + 12);
+		if (width <= 0 || height <= 0 || width > 8192 || height > 8192) return;
+
+		pixels = DecodedCache_PixelsSize(width, height);
+		if (offset + 16 + pixels > len) return;
+
+		e = &decodedEntries[decodedCount++];
+		e->crc32 = Stream_GetU32_LE(data + offset + 0);
+		e->size  = Stream_GetU32_LE(data + offset + 4);
+		e->used  = false;
+		e->owned = false;
+		Bitmap_Init(e->bmp, width, height, (BitmapCol*)(data + offset + 16));
+
+		decodedTotal += pixels;
+		offset += 16 + pixels;
+	}
+}
+
+static void DecodedCache_Begin(void) {
+	static const cc_string path = String_FromConst(DECODED_CACHE_PATH);
+	struct Stream stream;
+	cc_uint32 len;
+	cc_result res;
+
+	decodedCount   = 0;
+	decodedQueries = 0;
+	decodedTotal   = 0;
+	decodedDirty  = false;
+	decodedActive = true;
+
+	res = Stream_OpenFile(&stream, &path);
+	if (res) return;
+
+	if (!stream.Length(&stream, &len) && len <= DECODED_CACHE_MAX_SIZE) {
+		decodedData = (cc_uint8*)Mem_TryAlloc(len, 1);
+		/* Pixels of cached entries are used directly from the loaded data */
+		if (decodedData && !Stream_Read(&stream, decodedData, len)) {
+			DecodedCache_Parse(decodedData, len);
+		}
+	}
+	(void)stream.Close(&stream);
+}
+
+static void DecodedCache_Save(void) {
+	static const cc_string path = String_FromConst(DECODED_CACHE_PATH);
+	struct DecodedEntry* e;
+	struct Stream stream;
+	cc_uint8 tmp[16];
+	cc_result res;
+	int i, count = 0;
+
+	for (i = 0; i < decodedCount; i++) 
+	{
+		if (decodedEntries[i].used) count++;
+	}
+	if (Platform_ReadonlyFilesystem) return;
+	Utils_EnsureDirectory("texturecache");
+
+	res = Stream_CreateFile(&stream, &path);
+	if (res) { Logger_SysWarn2(res, "creating", &path); return; }
+
+	Stream_SetU32_LE(tmp + 0,  DECODED_CACHE_MAGIC);
+	Stream_SetU32_LE(tmp + 4,  DECODED_CACHE_VERSION);
+	Stream_SetU32_LE(tmp + 8,  count);
+	Stream_SetU32_LE(tmp + 12, 0);
+	res = Stream_Write(&stream, tmp, DECODED_CACHE_HEADER);
+
+	for (i = 0; i < decodedCount && !res; i++) 
+	{
+		e = &decodedEntries[i];
+		if (!e->used) continue;
+
+		Stream_SetU32_LE(tmp + 0,  e->crc32);
+		Stream_SetU32_LE(tmp + 4,  e->size);
+		Stream_SetU32_LE(tmp + 8,  e->bmp.width);
+		Stream_SetU32_LE(tmp + 12, e->bmp.height);
+
+		if ((res = Stream_Write(&stream, tmp, 16))) break;
+		res = Stream_Write(&stream, (cc_uint8*)e->bmp.scan0, 
+						DecodedCache_PixelsSize(e->bmp.width, e->bmp.height));
+	}
+	if (res) Logger_SysWarn2(res, "writing", &path);
+
+	res = stream.Close(&stream);
+	if (res) Logger_SysWarn2(res, "closing", &path);
+}
+
+static void DecodedCache_End(void) {
+	int i;
+	if (!decodedActive) return;
+	decodedActive = false;
+
+	/* Entries which are no longer used are removed from the cache too */
+	/*  (unless nothing was extracted at all, e.g. due to lost graphics context) */
+	for (i = 0; i < decodedCount && decodedQueries; i++) 
+	{
+		if (!decodedEntries[i].used) decodedDirty = true;
+	}
+	if (decodedDirty) DecodedCache_Save();
+
+	for (i = 0; i < decodedCount; i++) 
+	{
+		if (decodedEntries[i].owned) Mem_Free(decodedEntries[i].bmp.scan0);
+	}
+	Mem_Free(decodedData);
+	decodedData  = NULL;
+	decodedCount = 0;
+}
+
+static cc_bool DecodedCache_Lookup(struct Bitmap* bmp) {
+	struct DecodedEntry* e;
+	cc_uint32 size;
+	int i;
+
+	for (i = 0; i < decodedCount; i++) 
+	{
+		e = &decodedEntries[i];
+		if (e->crc32 != decodedSource->CRC32 || e->size != decodedSource->UncompressedSize) continue;
+
+		size = DecodedCache_PixelsSize(e->bmp.width, e->bmp.height);
+		bmp->scan0 = (BitmapCol*)Mem_TryAlloc(size, 1);
+		if (!bmp->scan0) return false;
+
+		Mem_Copy(bmp->scan0, e->bmp.scan0, size);
+		bmp->width  = e->bmp.width;
+		bmp->height = e->bmp.height;
+		e->used     = true;
+		return true;
+	}
+	return false;
+}
+
+static void DecodedCache_Add(struct Bitmap* bmp) {
+	struct DecodedEntry* e;
+	cc_uint32 size = DecodedCache_PixelsSize(bmp->width, bmp->height);
+	BitmapCol* copy;
+
+	if (decodedCount == DECODED_CACHE_MAX_ENTRIES) return;
+	if (decodedTotal + size > DECODED_CACHE_MAX_SIZE - 4096) return;
+
+	copy = (BitmapCol*)Mem_TryAlloc(size, 1);
+	if (!copy) return;
+	Mem_Copy(copy, bmp->scan0, size);
+
+	e = &decodedEntries[decodedCount++];
+	e->crc32 = decodedSource->CRC32;
+	e->size  = decodedSource->UncompressedSize;
+	e->used  = true;
+	e->owned = true;
+	Bitmap_Init(e->bmp, bmp->width, bmp->height, copy);
+
+	decodedTotal += size;
+	decodedDirty  = true;
+}
+
+cc_result TexturePack_DecodePng(struct Bitmap* bmp, struct Stream* stream) {
+	cc_result res;
+	/* Only images from .zip entries of the default/user selected packs can be cached */
+	if (!decodedActive || stream != decodedStream) return DecodePng(bmp, stream);
+	decodedQueries++;
+	if (DecodedCache_Lookup(bmp)) return 0;
+
+	res = DecodePng(bmp, stream);
+	if (!res) DecodedCache_Add(bmp);
+	return res;
+}
+
+#ifdef PNG_DECODE_THREADED
+/* Whether the image for the given .zip entry can be retrieved from the cache */
+static cc_bool DecodedCache_Contains(struct ZipEntry* source) {
+	int i;
+	if (!decodedActive) return false;
+
+	for (i = 0; i < decodedCount; i++) 
+	{
+		if (decodedEntries[i].crc32 == source->CRC32 && decodedEntries[i].size == source->UncompressedSize) return true;
+	}
+	return false;
+}
+#endif
+
+#define DecodedCache_SetEntry(stream, source) decodedStream = stream; decodedSource = source;
+#else
+#define DecodedCache_Begin()
+#define DecodedCache_End()
+#define DecodedCache_SetEntry(stream, source)
+#define DecodedCache_Contains(source) false
+
+cc_result TexturePack_DecodePng(struct Bitmap* bmp, struct Stream* stream) {
+	return DecodePng(bmp, stream);
+}
+#endif
+
+
 /*########################################################################################################################*
 *-------------------------------------------------------TexturePack-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -466,25 +1371,99 @@ static cc_bool SelectZipEntry(const cc_string* path) { return true; }
 static cc_result ProcessZipEntry(const cc_string* path, struct Stream* stream, struct ZipEntry* source) {
 	cc_string name = *path;
 	Utils_UNSAFE_GetFilename(&name);
+
+	DecodedCache_SetEntry(stream, source);
+	PngDecode_SetEntry(stream, source);
 	Event_RaiseEntry(&TextureEvents.FileChanged, stream, &name);
+	DecodedCache_SetEntry(NULL, NULL);
+	PngDecode_SetEntry(NULL, NULL);
 	return 0;
 }
 
 static cc_result ExtractPng(struct Stream* stream) {
 	struct Bitmap bmp;
-	cc_result res = Png_Decode(&bmp, stream);
+	cc_result res;
+#ifdef TERRAIN_DECODE_THREADED
+	if (terrain_async) return TerrainDecode_TryStart(stream);
+#endif
+
+	res = Png_Decode(&bmp, stream);
 	if (!res && Atlas_TryChange(&bmp)) return 0;
 
 	Mem_Free(bmp.scan0);
 	return res;
 }
 
-static cc_bool needReload;
+#ifdef PNG_DECODE_THREADED
+static cc_bool TextureEntry_IsRegistered(const cc_string* name);
+
+/* Queues decoding the PNG images that will be used, out of a batch of entries starting from the i'th entry */
+/* Returns the index of the first entry after the batch */
+static int PngDecode_Prepare(struct ZipIndex* index, int i) {
+	static const cc_string png = String_FromConst(".png");
+	struct PngDecodeJob* job;
+	struct ZipEntry* source;
+	cc_uint32 total = 0;
+	cc_string name;
+
+	for (; i < index->count; i++)
+	{
+		if (pngJobsCount == PNG_DECODE_MAX_JOBS || total >= PNG_DECODE_MAX_DATA) break;
+		source = &index->entries[i].data;
+		name   = ZipIndex_GetPath(index, i);
+		Utils_UNSAFE_GetFilename(&name);
+
+		/* Only decode images that something will actually use */
+		if (!String_CaselessEnds(&name, &png) || !TextureEntry_IsRegistered(&name)) continue;
+		if (terrain_async && String_CaselessEqualsConst(&name, "terrain.png")) continue;
+		if (DecodedCache_Contains(source)) continue;
+
+		job = &pngJobs[pngJobsCount];
+		if (ZipIndex_ReadCompressed(index, i, &job->data, &job->size, &job->method)) continue;
+		if (job->method != 0 && job->method != 8) { Mem_Free(job->data); continue; }
+
+		job->source    = source;
+		job->bmp.scan0 = NULL;
+		job->res       = 0;
+		total += job->size;
+		pngJobsCount++;
+	}
+
+	PngDecode_RunAll();
+	return i;
+}
+#else
+#define PngDecode_Prepare(index, i) (index)->count
+#endif
+
+/* Processes every entry in a .zip texture pack, in the order they are stored in the archive */
+/* NOTE: Uses an index of the central directory, so that packs with thousands of entries can still be loaded */
+static cc_result ExtractZip(struct Stream* stream) {
+	struct ZipIndex index;
+	cc_result res;
+	int i, end;
+
+	if ((res = ZipIndex_Build(&index, stream))) return res;
+
+	for (i = 0; i < index.count && !res; )
+	{
+		end = PngDecode_Prepare(&index, i);
+
+		for (; i < end && !res; i++)
+		{
+			res = ZipIndex_Extract(&index, i, ProcessZipEntry);
+		}
+		PngDecode_Reset();
+	}
+	ZipIndex_Free(&index);
+	return res;
+}
+
 static cc_result ExtractFrom(struct Stream* stream, const cc_string* path) {
-	struct ZipEntry entries[512];
 	cc_result res;
 
 	Event_RaiseVoid(&TextureEvents.PackChanged);
+	TerrainDecode_Finish(false);
 	/* If context is lost, then trying to load textures will just fail */
 	/* So defer loading the texture pack until context is restored */
 	if (Gfx.LostContext) { needReload = true; return 0; }
@@ -493,9 +1472,7 @@ static cc_result ExtractFrom(struct Stream* stream, const cc_string* path) {
 	res = ExtractPng(stream);
 	if (res == PNG_ERR_INVALID_SIG) {
 		/* file isn't a .png image, probably a .zip archive then */
-		res = Zip_Extract(stream, SelectZipEntry, ProcessZipEntry,
-							entries, Array_Elems(entries));
-
+		res = ExtractZip(stream);
 		if (res) Logger_SysWarn2(res, "extracting", path);
 	} else if (res) {
 		Logger_SysWarn2(res, "decoding", path);
@@ -531,6 +1508,7 @@ static cc_result ExtractUserTextures(void) {
 	cc_string path;
 	cc_result res;
 
+	DecodedCache_Begin();
 	/* TODO: Log error for multiple default texture pack extract failure */
 	res = TexturePack_ExtractDefault(ExtractFromFile);
 	/* Game shows a warning dialog if default textures are missing */
@@ -538,10 +1516,11 @@ static cc_result ExtractUserTextures(void) {
 
 	path = TexturePack_Path;
 	if (String_CaselessEqualsConst(&path, "texpacks/default.zip")) path.length = 0;
-	if (Game_ClassicMode || path.length == 0) return res;
 
 	/* override default textures with user's selected texture pack */
-	return ExtractFromFile(&path);
+	if (!Game_ClassicMode && path.length) res = ExtractFromFile(&path);
+	DecodedCache_End();
+	return res;
 }
 
 static cc_bool usingDefault;
@@ -569,6 +1548,144 @@ cc_result TexturePack_ExtractCurrent(cc_bool forceReload) {
 	return res;
 }
 
+/*########################################################################################################################*
+*---------------------------------------------------Streamed texture pack-------------------------------------------------*
+*#########################################################################################################################*/
+/* Downloaded texture pack data is written to the cache as it arrives, and if the pack is a .zip archive, */
+/*  each entry is extracted as soon as it has been downloaded (so peak memory usage stays bounded) */
+static struct ZipStreamState streamZip;
+static struct Stream streamFile;
+static char streamUrlBuffer[URL_MAX_SIZE];
+static cc_string streamUrl = String_FromArray(streamUrlBuffer);
+static int streamReqID;
+static cc_bool streamFileOpen, streamExtracting;
+static cc_uint32 streamCached;
+
+static void StreamPack_Begin(const cc_uint8* data, cc_uint32 len) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string altPath = String_Empty;
+	cc_result res;
+
+	streamReqID = TexturePack_ReqID;
+	String_Copy(&streamUrl, &TexturePack_Url);
+	/* Texture pack was reset while still downloading, so just discard the data */
+	if (!streamUrl.length) return;
+
+	String_InitArray(path, pathBuffer);
+	MakeCachePath(&path, &altPath, &streamUrl);
+
+	res = Stream_CreateFile(&streamFile, &path);
+	if (res) Logger_SysWarn2(res, "caching", &streamUrl);
+	streamFileOpen = !res;
+	streamCached   = 0;
+
+	/* Only .zip archives can be extracted before the whole pack has been downloaded */
+	streamExtracting = len >= 4 && Stream_GetU32_LE(data) == 0x04034b50 && !Gfx.LostContext;
+	if (!streamExtracting) return;
+
+	Event_RaiseVoid(&TextureEvents.PackChanged);
+	TerrainDecode_Finish(false);
+	ZipStream_Init(&streamZip, SelectZipEntry, ProcessZipEntry);
+	needReload   = false;
+	usingDefault = false;
+}
+
+/* Discards the cached data, e.g. if the download failed or is no longer needed */
+static void StreamPack_DiscardCache(void) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string altPath = String_Empty;
+	String_InitArray(path, pathBuffer);
+	MakeCachePath(&path, &altPath, &streamUrl);
+
+	/* Platform lacks a way to delete files, so truncate to indicate no cached data instead */
+	(void)Stream_WriteAllTo(&path, NULL, 0);
+	ClearCachedTag(&streamUrl, &etagCache,    ETAGS_TXT);
+	ClearCachedTag(&streamUrl, &lastModCache, LASTMOD_TXT);
+	CacheIndex_Remove(&streamUrl);
+}
+
+static void StreamPack_Append(const cc_uint8* data, cc_uint32 len) {
+	cc_result res;
+
+	if (streamFileOpen && (res = Stream_Write(&streamFile, data, len))) {
+		Logger_SysWarn2(res, "caching", &streamUrl);
+		(void)streamFile.Close(&streamFile);
+		streamFileOpen = false;
+		StreamPack_DiscardCache();
+	} else if (streamFileOpen) {
+		streamCached += len;
+	}
+	if (!streamExtracting) return;
+
+	/* If context is lost, then trying to load textures will just fail */
+	/* So finish extracting the texture pack from the cache instead once downloaded */
+	if (Gfx.LostContext) { streamExtracting = false; return; }
+
+	TerrainDecode_SetAsync(true);
+	res = ZipStream_Append(&streamZip, data, len);
+	TerrainDecode_SetAsync(false);
+	if (!res) return;
+	
+	if (res != ZIP_ERR_DATA_DESCRIPTOR) Logger_SysWarn2(res, "extracting", &streamUrl);
+	streamExtracting = false;
+}
+
+static cc_result StreamPack_Finish(void) {
+	cc_result res = 0;
+	ZipStream_Free(&streamZip);
+	streamReqID      = 0;
+	streamExtracting = false;
+
+	if (!streamFileOpen) return ERR_INVALID_ARGUMENT;
+	streamFileOpen = false;
+
+	res = streamFile.Close(&streamFile);
+	if (!res) { CacheIndex_Touch(&streamUrl, streamCached); return 0; }
+
+	Logger_SysWarn2(res, "caching", &streamUrl);
+	StreamPack_DiscardCache();
+	return res;
+}
+
+/* Stops streaming an incompletely downloaded texture pack */
+static void StreamPack_Abandon(void) {
+	cc_bool cached = streamFileOpen;
+	if (!streamReqID) return;
+
+	StreamPack_Finish();
+	if (cached) StreamPack_DiscardCache();
+}
+
+static void StreamPack_Receive(cc_uint8* data, cc_uint32 len) {
+	/* Texture pack being streamed is no longer the active texture pack */
+	if (streamReqID && streamReqID != TexturePack_ReqID) StreamPack_Abandon();
+
+	if (!streamReqID) StreamPack_Begin(data, len);
+	StreamPack_Append(data, len);
+}
+
+static void StreamPack_Complete(struct HttpRequest* item) {
+	struct Stream stream;
+	cc_bool extracted;
+	if (item->size) StreamPack_Append(item->data, item->size);
+
+	extracted = streamExtracting;
+	if (StreamPack_Finish()) return;
+	UpdateCachedTags(&streamUrl, item);
+	if (extracted) return;
+
+	/* Extracting while downloading wasn't possible, so extract from the cached data instead */
+	if (!OpenCachedData(&streamUrl, &stream)) return;
+	TerrainDecode_SetAsync(true);
+	ExtractFrom(&stream, &streamUrl);
+	TerrainDecode_SetAsync(false);
+	usingDefault = false;
+
+	/* No point logging error for closing readonly file */
+	(void)stream.Close(&stream);
+}
+
+
 /* Extracts and updates cache for the downloaded texture pack */
 static void ApplyDownloaded(struct HttpRequest* item) {
 	struct Stream mem;
@@ -580,14 +1697,32 @@ static void ApplyDownloaded(struct HttpRequest* item) {
 	if (!String_Equals(&TexturePack_Url, &url)) return;
 
 	Stream_ReadonlyMemory(&mem, item->data, item->size);
+	TerrainDecode_SetAsync(true);
 	ExtractFrom(&mem, &url);
+	TerrainDecode_SetAsync(false);
 	usingDefault = false;
 }
 
 void TexturePack_CheckPending(void) {
 	struct HttpRequest item;
+	cc_uint8* data;
+	cc_uint32 size;
+
+	TerrainDecode_Poll();
+	size = Http_TakePartial(TexturePack_ReqID, &data);
+	if (size) { StreamPack_Receive(data, size); Mem_Free(data); }
 	if (!Http_GetResult(TexturePack_ReqID, &item)) return;
 
+	if (item.success && streamReqID == item.id) {
+		StreamPack_Complete(&item);
+		HttpRequest_Free(&item);
+		return;
+	} else if (streamReqID == item.id) {
+		/* Undo the partially extracted texture pack */
+		StreamPack_Abandon();
+		TexturePack_ExtractCurrent(false);
+	}
+
 	if (item.success) {
 		ApplyDownloaded(&item);
 	} else if (item.result) {
@@ -610,6 +1745,7 @@ void TexturePack_CheckPending(void) {
 static void DownloadAsync(const cc_string* url) {
 	cc_string etag = String_Empty;
 	cc_string time = String_Empty;
+	cc_uint8 flags;
 
 	/* Only retrieve etag/last-modified headers if the file exists */
 	/* This inconsistency can occur if user deleted some cached files */
@@ -618,10 +1754,56 @@ static void DownloadAsync(const cc_string* url) {
 		etag = GetCachedETag(url);
 	}
 
+	/* Downloaded data can only be streamed straight into the cache when it is writable */
+	flags = HTTP_FLAG_PRIORITY;
+	if (!Platform_ReadonlyFilesystem) flags |= HTTP_FLAG_STREAMING;
+
 	Http_TryCancel(TexturePack_ReqID);
-	TexturePack_ReqID = Http_AsyncGetDataEx(url, HTTP_FLAG_PRIORITY, &time, &etag, NULL);
+	TexturePack_ReqID = Http_AsyncGetDataEx(url, flags, &time, &etag, NULL);
 }
 
+#ifdef CC_BUILD_WEB
+/* Cached texture packs aren't preloaded from IndexedDB at startup like other files are, */
+/*  so the cached data must be asynchronously loaded into the filesystem before it can be used */
+extern void interop_AsyncLoadCached(const char* path, int id);
+static int cacheLoadID;
+static cc_bool cacheLoadExtract;
+
+/* Called once the cached data (if any) of the texture pack has been loaded */
+EMSCRIPTEN_KEEPALIVE void TexturePack_OnCacheLoaded(int id) {
+	/* Texture pack changed or was reset while cached data was still loading */
+	if (id != cacheLoadID || !TexturePack_Url.length) return;
+
+	if (cacheLoadExtract) TexturePack_ExtractCurrent(false);
+	cacheLoadExtract = false;
+	/* The downloaded texture pack only needs to be applied if the cached data is out of date */
+	DownloadAsync(&TexturePack_Url);
+}
+
+void TexturePack_Extract(const cc_string* url) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string altPath = String_Empty;
+	char str[NATIVE_STR_LEN];
+	cc_bool changed = !String_Equals(url, &TexturePack_Url);
+
+	if (changed) String_Copy(&TexturePack_Url, url);
+	cacheLoadID++;
+
+	if (!url->length) {
+		if (changed) TexturePack_ExtractCurrent(false);
+		cacheLoadExtract = false;
+		return;
+	}
+
+	String_InitArray(path, pathBuffer);
+	MakeCachePath(&path, &altPath, url);
+	String_EncodeUtf8(str, &path);
+
+	/* Texture pack may have changed since an earlier request that's still loading */
+	cacheLoadExtract |= changed;
+	interop_AsyncLoadCached(str, cacheLoadID);
+}
+#else
 void TexturePack_Extract(const cc_string* url) {
 	if (url->length) DownloadAsync(url);
 
@@ -629,6 +1811,7 @@ void TexturePack_Extract(const cc_string* url) {
 	String_Copy(&TexturePack_Url, url);
 	TexturePack_ExtractCurrent(false);
 }
+#endif
 
 static struct TextureEntry* entries_head;
 static struct TextureEntry* entries_tail;
@@ -637,13 +1820,33 @@ void TextureEntry_Register(struct TextureEntry* entry) {
 	LinkedList_Append(entry, entries_head, entries_tail);
 }
 
+#ifdef PNG_DECODE_THREADED
+static cc_bool TextureEntry_IsRegistered(const cc_string* name) {
+	struct TextureEntry* e;
+
+	for (e = entries_head; e; e = e->next) 
+	{
+		if (String_CaselessEqualsConst(name, e->filename)) return true;
+	}
+	return false;
+}
+#endif
+
 
 /*########################################################################################################################*
 *---------------------------------------------------Textures component----------------------------------------------------*
 *#########################################################################################################################*/
 static void TerrainPngProcess(struct Stream* stream, const cc_string* name) {
 	struct Bitmap bmp;
-	cc_result res = Png_Decode(&bmp, stream);
+	cc_result res;
+#ifdef TERRAIN_DECODE_THREADED
+	if (terrain_async) {
+		if ((res = TerrainDecode_Start(stream))) Logger_SysWarn2(res, "decoding", name);
+		return;
+	}
+#endif
+
+	res = TexturePack_DecodePng(&bmp, stream);
 
 	if (res) {
 		Logger_SysWarn2(res, "decoding", name);
@@ -699,12 +1902,16 @@ static void OnInit(void) {
 }
 
 static void OnReset(void) {
+	StreamPack_Abandon();
+	TerrainDecode_Finish(false);
 	if (!TexturePack_Url.length) return;
 	TexturePack_Url.length = 0;
 	TexturePack_ExtractCurrent(false);
 }
 
 static void OnFree(void) {
+	StreamPack_Abandon();
+	TerrainDecode_Finish(false);
 	OnContextLost(NULL);
 	Atlas2D_Free();
 	TexturePack_Url.length = 0;
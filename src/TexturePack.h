@@ -39,6 +39,9 @@ CC_VAR extern struct _Atlas2DData {
 	int TileSize;
 	/* Number of rows in the atlas. (default 16, can be 32) */
 	int RowsCount;
+	/* Whether every row of pixels in each tile is identical. */
+	/* (i.e. the tile looks the same when stretched vertically) */
+	cc_bool UniformRows[ATLAS1D_MAX_ATLASES];
 } Atlas2D;
 
 CC_VAR extern struct _Atlas1DData {
@@ -53,6 +56,9 @@ CC_VAR extern struct _Atlas1DData {
 	float InvTileSize;
 	/* Textures for each 1D atlas. Only Atlas1D_Count of these are valid. */
 	GfxResourceID TexIds[ATLAS1D_MAX_ATLASES];
+	/* Number of layers in the texture array holding all the tiles, or 0 if not using a texture array. */
+	/* NOTE: When using a texture array, there is only one 1D atlas, which is spread across all the layers. */
+	int Layers;
 } Atlas1D;
 
 /* URL of the current custom texture pack, can be empty */
@@ -73,6 +79,8 @@ extern cc_bool TexturePack_DefaultMissing;
 GfxResourceID Atlas2D_LoadTile(TextureLoc texLoc);
 /* Attempts to change the terrain atlas. (bitmap containing textures for all blocks) */
 cc_bool Atlas_TryChange(struct Bitmap* bmp);
+/* Whether terrain.png from a downloaded texture pack is still being decoded in the background */
+cc_bool Atlas_IsDecoding(void);
 /* Returns the UV rectangle of the given tile id in the 1D atlases. */
 /* That is, returns U1/U2/V1/V2 coords that make up the tile in a 1D atlas. */
 /* index is set to the index of the 1D atlas that the tile is in. */
@@ -107,6 +115,10 @@ void TexturePack_CheckPending(void);
 /* then asynchronously downloads the texture pack from the given URL. */
 CC_API void TexturePack_Extract(const cc_string* url);
 
+/* Decodes a PNG image from an entry in a texture pack */
+/* NOTE: Images from the default/user selected texture packs are cached in decoded form on disk */
+CC_API cc_result TexturePack_DecodePng(struct Bitmap* bmp, struct Stream* stream);
+
 typedef cc_result (*DefaultZipCallback)(const cc_string* path);
 cc_result TexturePack_ExtractDefault(DefaultZipCallback callback);
 
@@ -42,13 +42,32 @@ int Utils_AccumulateWheelDelta(float* accumulator, float delta);
 #define Utils_AdjViewDist(value) ((int)(1.4142135f * (value)))
 
 cc_uint8 Utils_CalcSkinType(const struct Bitmap* bmp);
+/* Calculates the CRC32 checksum of the given data */
 cc_uint32 Utils_CRC32(const cc_uint8* data, cc_uint32 length);
+/* Updates a running CRC32 value with the given data, using hardware acceleration where supported. */
+/* NOTE: crc should start as 0xFFFFFFFF, and the final checksum is crc ^ 0xFFFFFFFF */
+cc_uint32 Utils_CRC32Update(cc_uint32 crc, const cc_uint8* data, cc_uint32 length);
+/* Calculates the 20 byte SHA-1 hash of the given data */
+void Utils_SHA1(const cc_uint8* data, cc_uint32 length, cc_uint8* hash);
 /* CRC32 lookup table, for faster CRC32 calculations. */
 /* NOTE: This cannot be just indexed by byte value - see Utils_CRC32 implementation. */
 extern const cc_uint32 Utils_Crc32Table[256];
 CC_NOINLINE void Utils_Resize(void** buffer, int* capacity, cc_uint32 elemSize, int defCapacity, int expandElems);
 void Utils_SwapEndian16(cc_int16* values, int numValues);
 
+struct MemArenaBlock;
+/* Bump allocator for short lived allocations, which are then all freed at once by resetting the arena */
+/* Avoids the cost of many separate Mem_Alloc/Mem_Free calls, and heap fragmentation from them */
+/* NOTE: Not thread safe, each thread must use a separate arena */
+struct MemArena { struct MemArenaBlock* head; };
+/* Allocates a block of memory from the arena, with undetermined contents. Returns NULL on allocation failure. */
+/* NOTE: The memory remains valid until MemArena_Reset or MemArena_Free is called */
+void* MemArena_TryAlloc(struct MemArena* arena, cc_uint32 numElems, cc_uint32 elemsSize);
+/* Frees all memory previously allocated from the arena, but keeps the backing memory for reuse */
+void MemArena_Reset(struct MemArena* arena);
+/* Frees all memory previously allocated from the arena, including the backing memory */
+void MemArena_Free(struct MemArena* arena);
+
 /* Converts blocks of 3 bytes into 4 ASCII characters. (pads if needed) */
 /* Returns the number of ASCII characters written. */
 /* NOTE: You MUST ensure that dst is appropriately sized. */
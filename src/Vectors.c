@@ -1,9 +1,36 @@
 #include "Vectors.h"
 #include "ExtMath.h"
-#include "Funcs.h"
 #include "Constants.h"
 #include "Core.h"
 
+/* SIMD instructions are used for matrix/vector transforms and to test several spheres */
+/*  against the frustum at once where supported */
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define VEC_SIMD_SSE2
+#elif (defined __ARM_NEON || defined __ARM_NEON__) && !defined __ARM_BIG_ENDIAN
+	#include <arm_neon.h>
+	#define VEC_SIMD_NEON
+#endif
+
+#if defined VEC_SIMD_SSE2
+#define VEC_SIMD
+typedef __m128 VecSimd;
+#define VecSimd_Load(ptr)          _mm_loadu_ps(ptr)
+#define VecSimd_Store(ptr, v)      _mm_storeu_ps(ptr, v)
+#define VecSimd_Mul(v, s)          _mm_mul_ps(v, _mm_set1_ps(s))
+#define VecSimd_MulAdd(acc, v, s)  _mm_add_ps(acc, _mm_mul_ps(v, _mm_set1_ps(s)))
+#elif defined VEC_SIMD_NEON
+#define VEC_SIMD
+typedef float32x4_t VecSimd;
+#define VecSimd_Load(ptr)          vld1q_f32(ptr)
+#define VecSimd_Store(ptr, v)      vst1q_f32(ptr, v)
+#define VecSimd_Mul(v, s)          vmulq_n_f32(v, s)
+#define VecSimd_MulAdd(acc, v, s)  vmlaq_n_f32(acc, v, s)
+#endif
+/* NOTE: Must be included after SIMD headers, as C++ standard library undefines min/max */
+#include "Funcs.h"
+
 void Vec3_Lerp(Vec3* result, const Vec3* a, const Vec3* b, float blend) {
 	result->x = blend * (b->x - a->x) + a->x;
 	result->y = blend * (b->y - a->y) + a->y;
@@ -22,6 +49,45 @@ void Vec3_Normalise(Vec3* v) {
 	v->z  = v->z * scale;
 }
 
+#ifdef VEC_SIMD
+/* Calculates row4 + x * row1 + y * row2 + z * row3 */
+#define VecSimd_Transform(r1, r2, r3, r4, v) VecSimd_MulAdd(VecSimd_MulAdd(VecSimd_MulAdd(r4, r1, (v)->x), r2, (v)->y), r3, (v)->z)
+
+void Vec3_Transform(Vec3* result, const Vec3* a, const struct Matrix* mat) {
+	VecSimd r1 = VecSimd_Load(&mat->row1.x), r2 = VecSimd_Load(&mat->row2.x);
+	VecSimd r3 = VecSimd_Load(&mat->row3.x), r4 = VecSimd_Load(&mat->row4.x);
+	float tmp[4];
+
+	/* Can't store directly into result, as that would overwrite whatever is after it */
+	VecSimd_Store(tmp, VecSimd_Transform(r1, r2, r3, r4, a));
+	result->x = tmp[0]; result->y = tmp[1]; result->z = tmp[2];
+}
+
+void Vec3_Transform4(struct Vec4* result, const Vec3* a, const struct Matrix* mat) {
+	VecSimd r1 = VecSimd_Load(&mat->row1.x), r2 = VecSimd_Load(&mat->row2.x);
+	VecSimd r3 = VecSimd_Load(&mat->row3.x), r4 = VecSimd_Load(&mat->row4.x);
+
+	VecSimd_Store(&result->x, VecSimd_Transform(r1, r2, r3, r4, a));
+}
+
+void Vec3_TransformMany(void* dst, int dstStride, const void* src, int srcStride, int count, const struct Matrix* mat) {
+	VecSimd r1 = VecSimd_Load(&mat->row1.x), r2 = VecSimd_Load(&mat->row2.x);
+	VecSimd r3 = VecSimd_Load(&mat->row3.x), r4 = VecSimd_Load(&mat->row4.x);
+	float tmp[4];
+	Vec3* v;
+	int i;
+
+	for (i = 0; i < count; i++) 
+	{
+		VecSimd_Store(tmp, VecSimd_Transform(r1, r2, r3, r4, (const Vec3*)src));
+		v    = (Vec3*)dst;
+		v->x = tmp[0]; v->y = tmp[1]; v->z = tmp[2];
+
+		src = (const cc_uint8*)src + srcStride;
+		dst = (cc_uint8*)dst + dstStride;
+	}
+}
+#else
 void Vec3_Transform(Vec3* result, const Vec3* a, const struct Matrix* mat) {
 	/* a could be pointing to result - therefore can't directly assign X/Y/Z */
 	float x = a->x * mat->row1.x + a->y * mat->row2.x + a->z * mat->row3.x + mat->row4.x;
@@ -30,6 +96,25 @@ void Vec3_Transform(Vec3* result, const Vec3* a, const struct Matrix* mat) {
 	result->x = x; result->y = y; result->z = z;
 }
 
+void Vec3_Transform4(struct Vec4* result, const Vec3* a, const struct Matrix* mat) {
+	float x = a->x, y = a->y, z = a->z;
+	result->x = x * mat->row1.x + y * mat->row2.x + z * mat->row3.x + mat->row4.x;
+	result->y = x * mat->row1.y + y * mat->row2.y + z * mat->row3.y + mat->row4.y;
+	result->z = x * mat->row1.z + y * mat->row2.z + z * mat->row3.z + mat->row4.z;
+	result->w = x * mat->row1.w + y * mat->row2.w + z * mat->row3.w + mat->row4.w;
+}
+
+void Vec3_TransformMany(void* dst, int dstStride, const void* src, int srcStride, int count, const struct Matrix* mat) {
+	int i;
+	for (i = 0; i < count; i++) 
+	{
+		Vec3_Transform((Vec3*)dst, (const Vec3*)src, mat);
+		src = (const cc_uint8*)src + srcStride;
+		dst = (cc_uint8*)dst + dstStride;
+	}
+}
+#endif
+
 void Vec3_TransformY(Vec3* result, float y, const struct Matrix* mat) {
 	result->x = y * mat->row2.x + mat->row4.x;
 	result->y = y * mat->row2.y + mat->row4.y;
@@ -132,6 +217,50 @@ void Matrix_Scale(struct Matrix* result, float x, float y, float z) {
 	result->row1.x = x; result->row2.y = y; result->row3.z = z;
 }
 
+#if defined CC_BUILD_PSP
+void Matrix_Mul(struct Matrix* result, const struct Matrix* left, const struct Matrix* right) {
+	/* Multiplied by the VFPU, which sees the row major matrices as column major */
+	/*  and so calculates (right * left) to produce the same result */
+	/* NOTE: Both matrices are entirely loaded first, so result can alias either left or right */
+	__asm__ volatile (
+		"ulv.q C000,  0(%1)\n"
+		"ulv.q C010, 16(%1)\n"
+		"ulv.q C020, 32(%1)\n"
+		"ulv.q C030, 48(%1)\n"
+		"ulv.q C100,  0(%2)\n"
+		"ulv.q C110, 16(%2)\n"
+		"ulv.q C120, 32(%2)\n"
+		"ulv.q C130, 48(%2)\n"
+		"vmmul.q M200, M000, M100\n"
+		"usv.q C200,  0(%0)\n"
+		"usv.q C210, 16(%0)\n"
+		"usv.q C220, 32(%0)\n"
+		"usv.q C230, 48(%0)\n"
+		: : "r" (result), "r" (right), "r" (left) : "memory"
+	);
+}
+#elif defined VEC_SIMD
+void Matrix_Mul(struct Matrix* result, const struct Matrix* left, const struct Matrix* right) {
+	/* Each row of the result is a linear combination of the rows of right */
+	/* NOTE: right is entirely loaded first, and each row of left is read before the */
+	/*  same row of result is written, so result can alias either left or right */
+	VecSimd r1 = VecSimd_Load(&right->row1.x), r2 = VecSimd_Load(&right->row2.x);
+	VecSimd r3 = VecSimd_Load(&right->row3.x), r4 = VecSimd_Load(&right->row4.x);
+	const struct Vec4* src = &left->row1;
+	struct Vec4* dst       = &result->row1;
+	VecSimd row;
+	int i;
+
+	for (i = 0; i < 4; i++) 
+	{
+		row = VecSimd_Mul(r1, src[i].x);
+		row = VecSimd_MulAdd(row, r2, src[i].y);
+		row = VecSimd_MulAdd(row, r3, src[i].z);
+		row = VecSimd_MulAdd(row, r4, src[i].w);
+		VecSimd_Store(&dst[i].x, row);
+	}
+}
+#else
 void Matrix_Mul(struct Matrix* result, const struct Matrix* left, const struct Matrix* right) {
 	/* Originally from http://www.edais.co.uk/blog/?p=27 */
 	float
@@ -165,6 +294,7 @@ void Matrix_Mul(struct Matrix* result, const struct Matrix* left, const struct M
 	result->row4.z = (((lM41 * rM13) + (lM42 * rM23)) + (lM43 * rM33)) + (lM44 * rM43);
 	result->row4.w = (((lM41 * rM14) + (lM42 * rM24)) + (lM43 * rM34)) + (lM44 * rM44);
 }
+#endif
 
 void Matrix_LookRot(struct Matrix* result, Vec3 pos, Vec2 rot) {
 	struct Matrix rotX, rotY, trans;
@@ -207,6 +337,71 @@ cc_bool FrustumCulling_SphereInFrustum(float x, float y, float z, float radius)
 	return true;
 }
 
+#if defined VEC_SIMD_SSE2
+#define FRUSTUM_SIMD
+/* Tests 4 spheres against a plane, returning a lane mask of the spheres in front of the plane */
+static CC_INLINE __m128 FrustumCulling_Plane4(const struct Plane* p, __m128 x, __m128 y, __m128 z, __m128 negRadius) {
+	__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p->a)), _mm_mul_ps(y, _mm_set1_ps(p->b))),
+						  _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(p->c)), _mm_set1_ps(p->d)));
+	return _mm_cmpgt_ps(d, negRadius);
+}
+
+static int FrustumCulling_Spheres4(const float* xs, const float* ys, const float* zs, float radius) {
+	__m128 x = _mm_loadu_ps(xs), y = _mm_loadu_ps(ys), z = _mm_loadu_ps(zs);
+	__m128 negRadius = _mm_set1_ps(-radius);
+	__m128 mask;
+
+	mask = FrustumCulling_Plane4(&frustumR, x, y, z, negRadius);
+	mask = _mm_and_ps(mask, FrustumCulling_Plane4(&frustumL, x, y, z, negRadius));
+	mask = _mm_and_ps(mask, FrustumCulling_Plane4(&frustumB, x, y, z, negRadius));
+	mask = _mm_and_ps(mask, FrustumCulling_Plane4(&frustumT, x, y, z, negRadius));
+	mask = _mm_and_ps(mask, FrustumCulling_Plane4(&frustumF, x, y, z, negRadius));
+	return _mm_movemask_ps(mask);
+}
+#elif defined VEC_SIMD_NEON
+#define FRUSTUM_SIMD
+/* Tests 4 spheres against a plane, returning a lane mask of the spheres in front of the plane */
+static CC_INLINE uint32x4_t FrustumCulling_Plane4(const struct Plane* p, float32x4_t x, float32x4_t y, float32x4_t z, float32x4_t negRadius) {
+	float32x4_t d = vdupq_n_f32(p->d);
+	d = vmlaq_n_f32(d, x, p->a);
+	d = vmlaq_n_f32(d, y, p->b);
+	d = vmlaq_n_f32(d, z, p->c);
+	return vcgtq_f32(d, negRadius);
+}
+
+static int FrustumCulling_Spheres4(const float* xs, const float* ys, const float* zs, float radius) {
+	float32x4_t x = vld1q_f32(xs), y = vld1q_f32(ys), z = vld1q_f32(zs);
+	float32x4_t negRadius = vdupq_n_f32(-radius);
+	uint32x4_t mask;
+
+	mask = FrustumCulling_Plane4(&frustumR, x, y, z, negRadius);
+	mask = vandq_u32(mask, FrustumCulling_Plane4(&frustumL, x, y, z, negRadius));
+	mask = vandq_u32(mask, FrustumCulling_Plane4(&frustumB, x, y, z, negRadius));
+	mask = vandq_u32(mask, FrustumCulling_Plane4(&frustumT, x, y, z, negRadius));
+	mask = vandq_u32(mask, FrustumCulling_Plane4(&frustumF, x, y, z, negRadius));
+	return (vgetq_lane_u32(mask, 0) & 1)        | (vgetq_lane_u32(mask, 1) & 1) << 1 |
+		   (vgetq_lane_u32(mask, 2) & 1) << 2   | (vgetq_lane_u32(mask, 3) & 1) << 3;
+}
+#endif
+
+void FrustumCulling_SpheresInFrustum(const float* x, const float* y, const float* z, int count, float radius, cc_uint32* visible) {
+	int i;
+	for (i = 0; i < ((count + 31) >> 5); i++) visible[i] = 0;
+	i = 0;
+
+#ifdef FRUSTUM_SIMD
+	for (; i + 4 <= count; i += 4) 
+	{
+		visible[i >> 5] |= (cc_uint32)FrustumCulling_Spheres4(x + i, y + i, z + i, radius) << (i & 31);
+	}
+#endif
+	for (; i < count; i++) 
+	{
+		if (!FrustumCulling_SphereInFrustum(x[i], y[i], z[i], radius)) continue;
+		visible[i >> 5] |= 1u << (i & 31);
+	}
+}
+
 void FrustumCulling_CalcFrustumEquations(struct Matrix* clip) {
 	/* Extract the RIGHT plane */
 	frustumR.a = clip->row1.w - clip->row1.x;
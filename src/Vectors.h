@@ -94,6 +94,11 @@ void Vec3_Normalise(Vec3* v);
 void Vec3_Transform(Vec3* result, const Vec3* a, const struct Matrix* mat);
 /* Same as Vec3_Transform, but faster since X and Z are assumed as 0. */
 void Vec3_TransformY(Vec3* result, float y, const struct Matrix* mat);
+/* Transforms a vector by the given matrix, including the W component of the result. */
+void Vec3_Transform4(struct Vec4* result, const Vec3* a, const struct Matrix* mat);
+/* Transforms count vectors by the given matrix. */
+/* NOTE: Vectors are dstStride/srcStride bytes apart, and dst can be the same pointer as src. */
+void Vec3_TransformMany(void* dst, int dstStride, const void* src, int srcStride, int count, const struct Matrix* mat);
 
 Vec3 Vec3_RotateX(Vec3 v, float angle);
 Vec3 Vec3_RotateY(Vec3 v, float angle);
@@ -135,6 +140,9 @@ CC_API void Matrix_Mul(struct Matrix* result, const struct Matrix* left, const s
 void Matrix_LookRot(struct Matrix* result, Vec3 pos, Vec2 rot);
 
 cc_bool FrustumCulling_SphereInFrustum(float x, float y, float z, float radius);
+/* Tests count spheres with the same radius at once, setting bit i of visible when sphere i is in the frustum */
+/* NOTE: The centres of the spheres are given as separate x/y/z arrays, so several can be tested at once with SIMD */
+void FrustumCulling_SpheresInFrustum(const float* x, const float* y, const float* z, int count, float radius, cc_uint32* visible);
 /* Calculates the clipping planes from the combined modelview and projection matrices */
 /* Matrix_Mul(&clip, modelView, projection); */
 void FrustumCulling_CalcFrustumEquations(struct Matrix* clip);
@@ -3,10 +3,20 @@
 #include "Platform.h"
 #include "Event.h"
 #include "ExtMath.h"
-#include "Funcs.h"
 #include "Errors.h"
 #include "Stream.h"
 
+/* SIMD instructions are used to speed up the imdct and sample output where supported */
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define VORBIS_SIMD_SSE2
+#elif (defined __ARM_NEON || defined __ARM_NEON__) && !defined __ARM_BIG_ENDIAN
+	#include <arm_neon.h>
+	#define VORBIS_SIMD_NEON
+#endif
+/* NOTE: Must be included after SIMD headers, as C++ standard library undefines min/max */
+#include "Funcs.h"
+
 /*########################################################################################################################*
 *-------------------------------------------------------Ogg stream--------------------------------------------------------*
 *#########################################################################################################################*/
@@ -1054,6 +1064,151 @@ static cc_result Mapping_DecodeSetup(struct VorbisState* ctx, struct Mapping* m)
 }
 
 
+/*########################################################################################################################*
+*----------------------------------------------------Vorbis SIMD helpers--------------------------------------------------*
+*#########################################################################################################################*/
+#if defined VORBIS_SIMD_SSE2 || defined VORBIS_SIMD_NEON
+#define VORBIS_SIMD
+#endif
+
+/* Each 4 float vector holds the interleaved (e_2, e_1) pairs for r+1 and r in imdct step 3, */
+/*  so the rotation is computed by swapping each pair and multiplying by alternately signed twiddles */
+/* Samples are output by clamping to [-1, 1], scaling by 32767 and truncating, same as the scalar code */
+#if defined VORBIS_SIMD_SSE2
+static void imdct_SimdButterflies(const float* w, float* u, int p, int k0, int count, const float* twiddles) {
+	__m128 a0 = _mm_loadu_ps(twiddles);
+	__m128 a1 = _mm_loadu_ps(twiddles + 4);
+	__m128 e, f, d, s;
+	int i;
+
+	for (i = 0; i < count; i++, p -= 2 * k0) {
+		e = _mm_loadu_ps(w + p);
+		f = _mm_loadu_ps(w + p - k0);
+		_mm_storeu_ps(u + p, _mm_add_ps(e, f));
+
+		d = _mm_sub_ps(e, f);
+		s = _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1));
+		_mm_storeu_ps(u + p - k0, _mm_add_ps(_mm_mul_ps(d, a0), _mm_mul_ps(s, a1)));
+	}
+}
+
+static CC_INLINE __m128i Vorbis_SimdToInt(__m128 v) {
+	v = _mm_max_ps(_mm_min_ps(v, _mm_set1_ps(1.0f)), _mm_set1_ps(-1.0f));
+	return _mm_cvttps_epi32(_mm_mul_ps(v, _mm_set1_ps(32767.0f)));
+}
+
+static CC_INLINE void Vorbis_SimdStore(cc_int16* data, __m128 l, __m128 r, int channels) {
+	__m128i a = Vorbis_SimdToInt(l), b;
+
+	if (channels == 1) {
+		_mm_storel_epi64((__m128i*)data, _mm_packs_epi32(a, a));
+	} else {
+		b = Vorbis_SimdToInt(r);
+		a = _mm_packs_epi32(a, a);
+		b = _mm_packs_epi32(b, b);
+		_mm_storeu_si128((__m128i*)data, _mm_unpacklo_epi16(a, b));
+	}
+}
+
+static int Vorbis_SimdConvert(cc_int16* data, float** src, int channels, int count) {
+	__m128 l, r;
+	int i;
+	if (channels > 2) return 0;
+
+	for (i = 0; i + 4 <= count; i += 4, data += 4 * channels) {
+		l = _mm_loadu_ps(src[0] + i);
+		r = channels == 2 ? _mm_loadu_ps(src[1] + i) : l;
+		Vorbis_SimdStore(data, l, r, channels);
+	}
+	return i;
+}
+
+static int Vorbis_SimdOverlap(cc_int16* data, float** prev, float** cur, const struct VorbisWindow* window, int channels, int count) {
+	__m128 wp, wc, l, r;
+	int i;
+	if (channels > 2) return 0;
+
+	for (i = 0; i + 4 <= count; i += 4, data += 4 * channels) {
+		wp = _mm_loadu_ps(window->Prev + i);
+		wc = _mm_loadu_ps(window->Cur  + i);
+
+		l = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(prev[0] + i), wp), _mm_mul_ps(_mm_loadu_ps(cur[0] + i), wc));
+		r = l;
+		if (channels == 2) {
+			r = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(prev[1] + i), wp), _mm_mul_ps(_mm_loadu_ps(cur[1] + i), wc));
+		}
+		Vorbis_SimdStore(data, l, r, channels);
+	}
+	return i;
+}
+#elif defined VORBIS_SIMD_NEON
+static void imdct_SimdButterflies(const float* w, float* u, int p, int k0, int count, const float* twiddles) {
+	float32x4_t a0 = vld1q_f32(twiddles);
+	float32x4_t a1 = vld1q_f32(twiddles + 4);
+	float32x4_t e, f, d;
+	int i;
+
+	for (i = 0; i < count; i++, p -= 2 * k0) {
+		e = vld1q_f32(w + p);
+		f = vld1q_f32(w + p - k0);
+		vst1q_f32(u + p, vaddq_f32(e, f));
+
+		d = vsubq_f32(e, f);
+		vst1q_f32(u + p - k0, vaddq_f32(vmulq_f32(d, a0), vmulq_f32(vrev64q_f32(d), a1)));
+	}
+}
+
+static CC_INLINE int16x4_t Vorbis_SimdToInt(float32x4_t v) {
+	v = vmaxq_f32(vminq_f32(v, vdupq_n_f32(1.0f)), vdupq_n_f32(-1.0f));
+	return vqmovn_s32(vcvtq_s32_f32(vmulq_f32(v, vdupq_n_f32(32767.0f))));
+}
+
+static CC_INLINE void Vorbis_SimdStore(cc_int16* data, float32x4_t l, float32x4_t r, int channels) {
+	int16x4x2_t lr;
+
+	if (channels == 1) {
+		vst1_s16(data, Vorbis_SimdToInt(l));
+	} else {
+		lr.val[0] = Vorbis_SimdToInt(l);
+		lr.val[1] = Vorbis_SimdToInt(r);
+		vst2_s16(data, lr);
+	}
+}
+
+static int Vorbis_SimdConvert(cc_int16* data, float** src, int channels, int count) {
+	float32x4_t l, r;
+	int i;
+	if (channels > 2) return 0;
+
+	for (i = 0; i + 4 <= count; i += 4, data += 4 * channels) {
+		l = vld1q_f32(src[0] + i);
+		r = channels == 2 ? vld1q_f32(src[1] + i) : l;
+		Vorbis_SimdStore(data, l, r, channels);
+	}
+	return i;
+}
+
+static int Vorbis_SimdOverlap(cc_int16* data, float** prev, float** cur, const struct VorbisWindow* window, int channels, int count) {
+	float32x4_t wp, wc, l, r;
+	int i;
+	if (channels > 2) return 0;
+
+	for (i = 0; i + 4 <= count; i += 4, data += 4 * channels) {
+		wp = vld1q_f32(window->Prev + i);
+		wc = vld1q_f32(window->Cur  + i);
+
+		l = vaddq_f32(vmulq_f32(vld1q_f32(prev[0] + i), wp), vmulq_f32(vld1q_f32(cur[0] + i), wc));
+		r = l;
+		if (channels == 2) {
+			r = vaddq_f32(vmulq_f32(vld1q_f32(prev[1] + i), wp), vmulq_f32(vld1q_f32(cur[1] + i), wc));
+		}
+		Vorbis_SimdStore(data, l, r, channels);
+	}
+	return i;
+}
+#endif
+
+
 /*########################################################################################################################*
 *------------------------------------------------------imdct impl---------------------------------------------------------*
 *#########################################################################################################################*/
@@ -1137,8 +1292,20 @@ void imdct_calc(float* in, float* out, struct imdct_state* state) {
 	{
 		int k0 = n >> (l+3), k1 = 1 << (l+3);
 		int r, r2, rMax = n >> (l+4), s2, s2Max = 1 << (l+2);
+		r = 0;
 
-		for (r = 0, r2 = 0; r < rMax; r++, r2 += 2) 
+#ifdef VORBIS_SIMD
+		/* rMax is a power of two, so r values can be processed in pairs when it is above 1 */
+		for (; r + 1 < rMax; r += 2)
+		{
+			float tw[8];
+			tw[0] = A[(r+1)*k1];   tw[1] =  tw[0]; tw[2] = A[r*k1];   tw[3] =  tw[2];
+			tw[4] = A[(r+1)*k1+1]; tw[5] = -tw[4]; tw[6] = A[r*k1+1]; tw[7] = -tw[6];
+			imdct_SimdButterflies(w, u, n2-4-2*r, k0, s2Max / 2, tw);
+		}
+#endif
+
+		for (r2 = 2*r; r < rMax; r++, r2 += 2) 
 		{
 			for (s2 = 0; s2 < s2Max; s2 += 2) 
 			{
@@ -1585,6 +1752,47 @@ cc_result Vorbis_DecodeFrame(struct VorbisState* ctx) {
 	return 0;
 }
 
+static cc_int16* Vorbis_ConvertSamples(cc_int16* data, float** src, int channels, int count) {
+	float sample;
+	int i = 0, ch;
+#ifdef VORBIS_SIMD
+	i     = Vorbis_SimdConvert(data, src, channels, count);
+	data += i * channels;
+#endif
+
+	for (; i < count; i++) 
+	{
+		for (ch = 0; ch < channels; ch++) 
+		{
+			sample = src[ch][i];
+			Math_Clamp(sample, -1.0f, 1.0f);
+			*data++ = (cc_int16)(sample * 32767);
+		}
+	}
+	return data;
+}
+
+static cc_int16* Vorbis_OverlapSamples(cc_int16* data, float** prev, float** cur, 
+										const struct VorbisWindow* window, int channels, int count) {
+	float sample;
+	int i = 0, ch;
+#ifdef VORBIS_SIMD
+	i     = Vorbis_SimdOverlap(data, prev, cur, window, channels, count);
+	data += i * channels;
+#endif
+
+	for (; i < count; i++) 
+	{
+		for (ch = 0; ch < channels; ch++) 
+		{
+			sample = prev[ch][i] * window->Prev[i] + cur[ch][i] * window->Cur[i];
+			Math_Clamp(sample, -1.0f, 1.0f);
+			*data++ = (cc_int16)(sample * 32767);
+		}
+	}
+	return data;
+}
+
 int Vorbis_OutputFrame(struct VorbisState* ctx, cc_int16* data) {
 	struct VorbisWindow window;
 	float* prev[VORBIS_MAX_CHANS];
@@ -1592,8 +1800,7 @@ int Vorbis_OutputFrame(struct VorbisState* ctx, cc_int16* data) {
 
 	int curQrtr, prevQrtr, overlapQtr;
 	int curOffset, prevOffset, overlapSize;
-	float sample;
-	int i, ch;
+	int i;
 
 	/* first frame decoded has no data */
 	if (ctx->prevBlockSize == 0) {
@@ -1626,15 +1833,7 @@ int Vorbis_OutputFrame(struct VorbisState* ctx, cc_int16* data) {
 	}
 
 	/* for long prev and short cur block, there will be non-overlapped data before */
-	for (i = 0; i < prevOffset; i++) 
-	{
-		for (ch = 0; ch < ctx->channels; ch++) 
-		{
-			sample = prev[ch][i];
-			Math_Clamp(sample, -1.0f, 1.0f);
-			*data++ = (cc_int16)(sample * 32767);
-		}
-	}
+	data = Vorbis_ConvertSamples(data, prev, ctx->channels, prevOffset);
 
 	/* adjust pointers to start at 0 for overlapping */
 	for (i = 0; i < ctx->channels; i++) 
@@ -1647,27 +1846,11 @@ int Vorbis_OutputFrame(struct VorbisState* ctx, cc_int16* data) {
 
 	/* overlap and add data */
 	/* also perform windowing here */
-	for (i = 0; i < overlapSize; i++) 
-	{
-		for (ch = 0; ch < ctx->channels; ch++) 
-		{
-			sample = prev[ch][i] * window.Prev[i] + cur[ch][i] * window.Cur[i];
-			Math_Clamp(sample, -1.0f, 1.0f);
-			*data++ = (cc_int16)(sample * 32767);
-		}
-	}
+	data = Vorbis_OverlapSamples(data, prev, cur, &window, ctx->channels, overlapSize);
 
 	/* for long cur and short prev block, there will be non-overlapped data after */
 	for (i = 0; i < ctx->channels; i++) { cur[i] += overlapSize; }
-	for (i = 0; i < curOffset; i++) 
-	{
-		for (ch = 0; ch < ctx->channels; ch++) 
-		{
-			sample = cur[ch][i];
-			Math_Clamp(sample, -1.0f, 1.0f);
-			*data++ = (cc_int16)(sample * 32767);
-		}
-	}
+	data = Vorbis_ConvertSamples(data, cur, ctx->channels, curOffset);
 
 	ctx->prevBlockSize = ctx->curBlockSize;
 	return (prevQrtr + curQrtr) * ctx->channels;
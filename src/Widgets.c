@@ -59,10 +59,7 @@ static void TextWidget_BuildMesh(void* widget, struct VertexTextured** vertices)
 
 static int TextWidget_Render2(void* widget, int offset) {
 	struct TextWidget* w = (struct TextWidget*)widget;
-	if (w->tex.ID) {
-		Gfx_BindTexture(w->tex.ID);
-		Gfx_DrawVb_IndexedTris_Range(4, offset);
-	}
+	if (w->tex.ID) Gui_DrawQuads(w->tex.ID, 4, offset);
 	return offset + 4;
 }
 
@@ -214,14 +211,11 @@ static void ButtonWidget_BuildMesh(void* widget, struct VertexTextured** vertice
 
 static int ButtonWidget_Render2(void* widget, int offset) {
 	struct ButtonWidget* w = (struct ButtonWidget*)widget;	
-	Gfx_BindTexture(Gui.ClassicTexture ? Gui.GuiClassicTex : Gui.GuiTex);
 	/* TODO: Does this 400 need to take DPI into account */
-	Gfx_DrawVb_IndexedTris_Range(w->width >= 400 ? 4 : 8, offset);
+	Gui_DrawQuads(Gui.ClassicTexture ? Gui.GuiClassicTex : Gui.GuiTex, 
+				w->width >= 400 ? 4 : 8, offset);
 
-	if (w->tex.ID) {
-		Gfx_BindTexture(w->tex.ID);
-		Gfx_DrawVb_IndexedTris_Range(4, offset + 8);
-	}
+	if (w->tex.ID) Gui_DrawQuads(w->tex.ID, 4, offset + 8);
 	return offset + 12;
 }
 
@@ -462,6 +456,7 @@ static void HotbarWidget_RenderEntries(struct HotbarWidget* w, int offset) {
 
 static int HotbarWidget_Render2(void* widget, int offset) {
 	struct HotbarWidget* w = (struct HotbarWidget*)widget;
+	Gui_FlushQuads();
 	Gfx_3DS_SetRenderScreen(BOTTOM_SCREEN);
 
 	HotbarWidget_RenderOutline(w, offset    );
@@ -813,6 +808,7 @@ static int TableWidget_Render2(void* widget, int offset) {
 	PackedCol topSelColor     = PackedCol_Make(255, 255, 255, 142);
 	PackedCol bottomSelColor  = PackedCol_Make(255, 255, 255, 192);
 
+	Gui_FlushQuads();
 	Gfx_Draw2DGradient(Table_X(w), Table_Y(w),
 		Table_Width(w), Table_Height(w), topBackColor, bottomBackColor);
 
@@ -1596,13 +1592,11 @@ static void TextInputWidget_BuildMesh(void* widget, struct VertexTextured** vert
 
 static int TextInputWidget_Render2(void* widget, int offset) {
 	struct InputWidget* w = (struct InputWidget*)widget;
-	Gfx_BindTexture(w->inputTex.ID);
-	Gfx_DrawVb_IndexedTris_Range(4, offset);
+	Gui_DrawQuads(w->inputTex.ID, 4, offset);
 	offset += 4;
 
 	if (w->showCaret && Math_Mod1((float)w->caretAccumulator) < 0.5f) {
-		Gfx_BindTexture(w->caretTex.ID);
-		Gfx_DrawVb_IndexedTris_Range(4, offset);
+		Gui_DrawQuads(w->caretTex.ID, 4, offset);
 	}
 	return offset + 4;
 }
@@ -2042,6 +2036,26 @@ void TextGroupWidget_ShiftUp(struct TextGroupWidget* w) {
 	TextGroupWidget_Redraw(w, last);
 }
 
+void TextGroupWidget_ShiftUpBy(struct TextGroupWidget* w, int count) {
+	int i;
+	if (count >= w->lines) { TextGroupWidget_RedrawAll(w); return; }
+
+	for (i = 0; i < count; i++) 
+	{
+		Gfx_DeleteTexture(&w->textures[i].ID);
+	}
+	for (i = 0; i < w->lines - count; i++) 
+	{
+		w->textures[i] = w->textures[i + count];
+	}
+
+	for (i = w->lines - count; i < w->lines; i++) 
+	{
+		w->textures[i].ID = 0; /* Gfx_DeleteTexture() called by TextGroupWidget_Redraw otherwise */
+		TextGroupWidget_Redraw(w, i);
+	}
+}
+
 void TextGroupWidget_ShiftDown(struct TextGroupWidget* w) {
 	int last, i;
 	last = w->lines - 1;
@@ -2458,9 +2472,7 @@ static int TextGroupWidget_Render2(void* widget, int offset) {
 	for (i = 0; i < w->lines; i++, offset += 4)
 	{
 		if (!textures[i].ID) continue;
-
-		Gfx_BindTexture(textures[i].ID);
-		Gfx_DrawVb_IndexedTris_Range(4, offset);
+		Gui_DrawQuads(textures[i].ID, 4, offset);
 	}
 	return offset;
 }
@@ -2814,10 +2826,9 @@ static int ThumbstickWidget_Render2(void* widget, int offset) {
 	int i, base, flags = ThumbstickWidget_CalcDirs(w);
 
 	if (Gui.TouchTex) {
-		Gfx_BindTexture(Gui.TouchTex);
 		for (i = 0; i < 4; i++) {
 			base = (flags & (1 << i)) ? 0 : THUMBSTICKWIDGET_PER;
-			Gfx_DrawVb_IndexedTris_Range(4, offset + base + (i * 4));
+			Gui_DrawQuads(Gui.TouchTex, 4, offset + base + (i * 4));
 		}
 	}
 	return offset + THUMBSTICKWIDGET_MAX;
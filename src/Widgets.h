@@ -261,6 +261,9 @@ CC_NOINLINE void TextGroupWidget_SetFont(struct TextGroupWidget* w, struct FontD
 /* Deletes first line, then moves all other lines upwards, then redraws last line. */
 /* NOTE: GetLine must also adjust the lines it returns for this to behave properly. */
 CC_NOINLINE void TextGroupWidget_ShiftUp(struct TextGroupWidget* w);
+/* Deletes first count lines, then moves all other lines upwards, then redraws last count lines. */
+/* NOTE: Cheaper than calling TextGroupWidget_ShiftUp count times, as each line is only drawn once. */
+CC_NOINLINE void TextGroupWidget_ShiftUpBy(struct TextGroupWidget* w, int count);
 /* Deletes last line, then moves all other lines downwards, then redraws first line. */
 /* NOTE: GetLine must also adjust the lines it returns for this to behave properly. */
 CC_NOINLINE void TextGroupWidget_ShiftDown(struct TextGroupWidget* w);
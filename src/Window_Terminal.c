@@ -48,8 +48,12 @@
 #endif
 
 static void SetMousePosition(int x, int y);
+static void AllocCells(int width, int height);
+static void FreeCells(void);
+static void InvalidateCells(void);
+static void CheckPendingFrame(void);
 static cc_bool pendingResize, pendingClose;
-static int supportsTruecolor;
+static int supportsTruecolor, minFrameMS;
 #define CHARS_PER_CELL 2
 #define CSI "\x1B["
 
@@ -409,6 +413,7 @@ void Window_PreInit(void) {
 }
 
 void Window_Init(void) {
+	int fps;
 	Input.Sources = INPUT_SOURCE_NORMAL;
 	DisplayInfo.Depth  = 4;
 	DisplayInfo.ScaleX = 0.5f;
@@ -420,6 +425,9 @@ void Window_Init(void) {
 	UpdateDimensions();
 	HookSignals();
 	Platform_SingleProcess = true;
+
+	fps = Options_GetInt(OPT_TERMINAL_MAX_FPS, 0, 1000, 0);
+	minFrameMS = fps ? 1000 / fps : 0;
 }
 
 void Window_Free(void) {
@@ -477,8 +485,10 @@ void Window_ProcessEvents(float delta) {
 	if (pendingResize) {
 		pendingResize = false;
 		UpdateDimensions();
+		InvalidateCells();
 		Event_RaiseVoid(&WindowEvents.Resized);
 	}
+	CheckPendingFrame();
 	
 	if (pendingClose) {
 		pendingClose = false;
@@ -535,10 +545,12 @@ void Window_AllocFramebuffer(struct Bitmap* bmp, int width, int height) {
 	bmp->scan0  = (BitmapCol*)Mem_Alloc(width * height, BITMAPCOLOR_SIZE, "window pixels");
 	bmp->width  = width;
 	bmp->height = height;
+	AllocCells(width, height);
 }
 
 void Window_FreeFramebuffer(struct Bitmap* bmp) {
 	Mem_Free(bmp->scan0);
+	FreeCells();
 }
 
 void OnscreenKeyboard_Open(struct OpenKeyboardArgs* args) { }
@@ -586,69 +598,160 @@ static int CalcIndex(BitmapCol rgb) {
 	return 16 + 36 * r + 6 * g + b;
 }
 
-void Window_DrawFramebuffer(Rect2D r, struct Bitmap* bmp) {
-	char buf[256];
-	cc_string str;
-	int len;
-	String_InitArray(str, buf);
+// Only cells which differ from what was last output are written again, since the full screen
+//  of colour escapes is far too much output for slower connections (e.g. over SSH)
+static cc_uint32* cells; // Top and bottom colour of each previously output cell
+static int cellsWidth, cellsHeight;
+static cc_bool cellsValid;
+
+static cc_uint32 curTop, curBot; // Current background and foreground colour of the terminal
+static cc_bool colorsValid;
+static int cursorX, cursorY;
+
+static char outBuffer[16384];
+#define OUTPUT_CELL_MAX 64 // Upper bound on bytes output for a single cell
+
+// Optional frame rate cap, which also backs off while output is being blocked
+static int frameDelayMS;
+static cc_uint64 lastFrame;
+static Rect2D pendingRect;
+static struct Bitmap* pendingBmp;
+
+static void InvalidateCells(void) {
+	cellsValid  = false;
+	colorsValid = false;
+}
+
+static void AllocCells(int width, int height) {
+	Mem_Free(cells);
+	cellsWidth  = width;
+	cellsHeight = (height + 1) / CHARS_PER_CELL;
+	cells       = (cc_uint32*)Mem_TryAlloc(cellsWidth * cellsHeight * 2, 4);
+	InvalidateCells();
+}
+
+static void FreeCells(void) {
+	Mem_Free(cells);
+	cells      = NULL;
+	pendingBmp = NULL;
+}
+
+static cc_uint32 CellColor(BitmapCol col) {
+	return supportsTruecolor ? (col & BITMAPCOLOR_RGB_MASK) : (cc_uint32)CalcIndex(col);
+}
+
+// https://en.wikipedia.org/wiki/ANSI_escape_code#Colors
+static void AppendCellColor(cc_string* str, const char* cmd, cc_uint32 col) {
+	String_AppendConst(str, CSI);
+	String_AppendConst(str, cmd);
+
+	if (supportsTruecolor) {
+		String_AppendConst(str, SEP_STR "2" SEP_STR);
+		AppendByteFast(str, BitmapCol_R(col));
+		String_Append( str, SEP_CHAR);
+		AppendByteFast(str, BitmapCol_G(col));
+		String_Append( str, SEP_CHAR);
+		AppendByteFast(str, BitmapCol_B(col));
+	} else {
+		String_AppendConst(str, SEP_STR "5" SEP_STR);
+		AppendByteFast(str, col);
+	}
+	String_Append(str, 'm');
+}
+
+static void DrawCells(Rect2D r, struct Bitmap* bmp) {
+	cc_string str = String_Init(outBuffer, 0, sizeof(outBuffer));
+	cc_uint32 top, bot;
+	cc_uint32* cell;
+	int x, y, cellY;
+
+	// Other output (e.g. logging) may have moved the cursor in between frames
+	cursorX = -1;
+	cursorY = -1;
 	
-	for (int y = r.y & ~0x01; y < r.y + r.height; y += 2)
+	for (y = r.y & ~0x01; y < r.y + r.height; y += 2)
 	{
-		//len = sprintf(buf, CSI "%i;%iH", y / 2, r.x); // move cursor to start
-		//OutputConsole(buf, len);
-		str.length = 0;
-		String_AppendConst(&str, CSI);
-		String_AppendInt(  &str, y / CHARS_PER_CELL);
-		String_Append(     &str, ';');
-		String_AppendInt(  &str, r.x);
-		String_Append(     &str, 'H');
-		OutputConsole(buf, str.length);
-		
-		for (int x = r.x; x < r.x + r.width; x++)
+		cellY = y / CHARS_PER_CELL;
+
+		for (x = r.x; x < r.x + r.width; x++)
 		{
-			BitmapCol top = Bitmap_GetPixel(bmp, x, y + 0);
-			BitmapCol bot = Bitmap_GetPixel(bmp, x, y + 1);
-	
+			top = CellColor(Bitmap_GetPixel(bmp, x, y));
+			bot = y + 1 < bmp->height ? CellColor(Bitmap_GetPixel(bmp, x, y + 1)) : top;
+
+			if (cells && x < cellsWidth && cellY < cellsHeight) {
+				cell = &cells[(cellY * cellsWidth + x) * 2];
+				if (cellsValid && cell[0] == top && cell[1] == bot) continue;
+				cell[0] = top; cell[1] = bot;
+			}
+
+			if (str.length > str.capacity - OUTPUT_CELL_MAX) {
+				OutputConsole(outBuffer, str.length);
+				str.length = 0;
+			}
+
+			// Cursor only needs to be moved when skipping over unchanged cells
+			if (x != cursorX || cellY != cursorY) {
+				String_AppendConst(&str, CSI);
+				String_AppendInt(  &str, cellY + 1);
+				String_Append(     &str, ';');
+				String_AppendInt(  &str, x + 1);
+				String_Append(     &str, 'H');
+			}
+
 			// Use '▄' so each cell can use a background and foreground colour
 			// This essentially doubles the vertical resolution of the displayed image
-			//printf(CSI "48;2;%i;%i;%im", BitmapCol_R(top), BitmapCol_G(top), BitmapCol_B(top));
-			//printf(CSI "38;2;%i;%i;%im", BitmapCol_R(bot), BitmapCol_G(bot), BitmapCol_B(bot));
-			//printf("\xE2\x96\x84");
-			//len = sprintf(buf, CSI "48;2;%i;%i;%im" CSI "38;2;%i;%i;%im" BOX_CHAR, 
-			//				BitmapCol_R(top), BitmapCol_G(top), BitmapCol_B(top),
-			//				BitmapCol_R(bot), BitmapCol_G(bot), BitmapCol_B(bot));
-			
-			// https://en.wikipedia.org/wiki/ANSI_escape_code#Colors
-			str.length = 0;
-			if (supportsTruecolor) {
-				String_AppendConst(&str, CSI "48" SEP_STR "2" SEP_STR);
-				String_AppendInt(  &str, BitmapCol_R(top));
-				String_Append(     &str, SEP_CHAR);
-				String_AppendInt(  &str, BitmapCol_G(top));
-				String_Append(     &str, SEP_CHAR);
-				String_AppendInt(  &str, BitmapCol_B(top));
-				String_Append(     &str, 'm');
-				
-				String_AppendConst(&str, CSI "38" SEP_STR "2" SEP_STR);
-				String_AppendInt(  &str, BitmapCol_R(bot));
-				String_Append(     &str, SEP_CHAR);
-				String_AppendInt(  &str, BitmapCol_G(bot));
-				String_Append(     &str, SEP_CHAR);
-				String_AppendInt(  &str, BitmapCol_B(bot));
-				String_Append(     &str, 'm');
-			} else {
-				String_AppendConst(&str, CSI "48" SEP_STR "5" SEP_STR);
-				String_AppendInt(  &str, CalcIndex(top));
-				String_Append(     &str, 'm');
-				
-				String_AppendConst(&str, CSI "38" SEP_STR "5" SEP_STR);
-				String_AppendInt(  &str, CalcIndex(bot));
-				String_Append(     &str, 'm');
-			}
-			
+			if (!colorsValid || top != curTop) AppendCellColor(&str, "48", top);
+			if (!colorsValid || bot != curBot) AppendCellColor(&str, "38", bot);
+
 			String_AppendConst(&str, BOX_CHAR);
-			OutputConsole(buf, str.length);
-		}		
+			curTop  = top; curBot  = bot;
+			cursorX = x + 1;
+			cursorY = cellY;
+			colorsValid = true;
+		}
+	}
+
+	if (str.length) OutputConsole(outBuffer, str.length);
+	// Cells outside the redrawn area may be stale, so can't be relied upon until a full redraw
+	if (!cellsValid) {
+		cellsValid = cells && r.x == 0 && r.y == 0 && r.width >= cellsWidth && r.height >= bmp->height;
+	}
+}
+
+static void UnionRect(Rect2D* a, Rect2D b) {
+	int x2 = max(a->x + a->width,  b.x + b.width);
+	int y2 = max(a->y + a->height, b.y + b.height);
+
+	a->x = min(a->x, b.x); a->width  = x2 - a->x;
+	a->y = min(a->y, b.y); a->height = y2 - a->y;
+}
+
+static void CheckPendingFrame(void) {
+	cc_uint64 beg, end;
+	if (!pendingBmp) return;
+
+	beg = Stopwatch_Measure();
+	if (lastFrame && Stopwatch_ElapsedMS(lastFrame, beg) < frameDelayMS) return;
+
+	DrawCells(pendingRect, pendingBmp);
+	pendingBmp = NULL;
+	end = Stopwatch_Measure();
+
+	// Writing blocks once the terminal (or the connection to it) can't keep up,
+	//  so at most half of the time is spent waiting on output
+	frameDelayMS = max(minFrameMS, 2 * Stopwatch_ElapsedMS(beg, end));
+	lastFrame    = beg;
+}
+
+void Window_DrawFramebuffer(Rect2D r, struct Bitmap* bmp) {
+	if (!minFrameMS) { DrawCells(r, bmp); return; }
+
+	if (pendingBmp) {
+		UnionRect(&pendingRect, r);
+	} else {
+		pendingRect = r;
 	}
+	pendingBmp = bmp;
+	CheckPendingFrame();
 }
 #endif
@@ -770,7 +770,13 @@ void GLContext_Create(void) {
 	attribs.stencil   = false;
 	attribs.antialias = false;
 
+	/* Prefer WebGL 2 for VAOs and texture arrays, but fallback to WebGL 1 if unsupported */
+	attribs.majorVersion = 2;
 	ctx_handle = emscripten_webgl_create_context("#canvas", &attribs);
+	if (!ctx_handle) {
+		attribs.majorVersion = 1;
+		ctx_handle = emscripten_webgl_create_context("#canvas", &attribs);
+	}
 	if (!ctx_handle) {
 		Window_ShowDialog("WebGL unsupported", "WebGL is required to run ClassiCube");
 		Process_Exit(0x57474C20);
@@ -55,8 +55,12 @@
 /* https://tedyin.com/posts/a-brief-intro-to-linux-input-method-framework/ */
 #endif
 
+/* MIT-SHM extension is used to avoid copying framebuffer pixels to the X server */
+#define CC_BUILD_XSHM
+
 #if defined CC_BUILD_HPUX || defined CC_BUILD_IRIX
 #undef CC_BUILD_XIM
+#undef CC_BUILD_XSHM
 #endif
 
 #define _NET_WM_STATE_REMOVE 0
@@ -744,6 +748,7 @@ static void HandleWMPing(XEvent* e) {
 		SubstructureRedirectMask | SubstructureNotifyMask, e);
 }
 static void HandleGenericEvent(XEvent* e);
+static void FlushRawMotion(void);
 
 static void HandleClientMessage(XEvent* e) {
 	if (e->xclient.data.l[0] == wm_destroy) {
@@ -842,6 +847,7 @@ void Window_ProcessEvents(float delta) {
 			HandleSelectionRequest(&e); break;
 		}
 	}
+	FlushRawMotion();
 }
 
 void Gamepads_Init(void) {
@@ -1217,11 +1223,94 @@ static XImage* fb_image;
 static void* fb_data;
 static int fb_fast;
 
+#ifdef CC_BUILD_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+/* Based on X11/extensions/XShm.h */
+typedef struct {
+	unsigned long shmseg;
+	int shmid;
+	char* shmaddr;
+	Bool readOnly;
+} XShmSegmentInfo;
+
+static Bool    (*_XShmQueryExtension)(Display* dpy);
+static Bool    (*_XShmAttach)(Display* dpy, XShmSegmentInfo* shminfo);
+static Bool    (*_XShmDetach)(Display* dpy, XShmSegmentInfo* shminfo);
+static XImage* (*_XShmCreateImage)(Display* dpy, Visual* visual, unsigned int depth, int format,
+								char* data, XShmSegmentInfo* shminfo, unsigned int width, unsigned int height);
+static Bool    (*_XShmPutImage)(Display* dpy, Drawable d, GC gc, XImage* image, int src_x, int src_y,
+								int dst_x, int dst_y, unsigned int width, unsigned int height, Bool send_event);
+
+static XShmSegmentInfo fb_shm;
+static cc_bool fb_shmUsed, fb_shmFailed;
+
+static cc_bool LoadXShmFuncs(void) {
+	static const struct DynamicLibSym funcs[] = {
+		DynamicLib_Sym(XShmQueryExtension), DynamicLib_Sym(XShmAttach),
+		DynamicLib_Sym(XShmDetach),         DynamicLib_Sym(XShmCreateImage),
+		DynamicLib_Sym(XShmPutImage)
+	};
+#ifdef CC_BUILD_BSD
+	static const cc_string xextLib = String_FromConst("libXext.so");
+#else
+	static const cc_string xextLib = String_FromConst("libXext.so.6");
+#endif
+	static int loaded;
+	void* lib;
+
+	if (!loaded) loaded = DynamicLib_LoadAll(&xextLib, funcs, Array_Elems(funcs), &lib) ? 1 : -1;
+	return loaded == 1 && _XShmQueryExtension(win_display);
+}
+
+static int OnXShmAttachError(Display* dpy, XErrorEvent* ev) {
+	fb_shmFailed = true;
+	return 0;
+}
+
+/* Attempts to create fb_image with pixels stored in memory shared with the X server */
+static cc_bool AllocShmFramebuffer(int width, int height) {
+	X11_ErrorHandler oldHandler;
+	if (!LoadXShmFuncs()) return false;
+
+	fb_image = _XShmCreateImage(win_display, win_visual.visual, win_visual.depth,
+						ZPixmap, NULL, &fb_shm, width, height);
+	if (!fb_image) return false;
+
+	fb_shm.shmid = shmget(IPC_PRIVATE, fb_image->bytes_per_line * fb_image->height, IPC_CREAT | 0600);
+	if (fb_shm.shmid == -1) { XFree(fb_image); return false; }
+
+	fb_shm.shmaddr  = (char*)shmat(fb_shm.shmid, NULL, 0);
+	fb_shm.readOnly = False;
+	fb_image->data  = fb_shm.shmaddr;
+
+	if (fb_shm.shmaddr == (char*)-1) {
+		shmctl(fb_shm.shmid, IPC_RMID, NULL);
+		XFree(fb_image); return false;
+	}
+
+	/* Attaching fails when the X server is on a different machine (e.g. with SSH forwarding) */
+	XSync(win_display, False);
+	fb_shmFailed = false;
+	oldHandler   = XSetErrorHandler(OnXShmAttachError);
+	_XShmAttach(win_display, &fb_shm);
+	XSync(win_display, False);
+	XSetErrorHandler(oldHandler);
+
+	/* Segment is then automatically destroyed once both the game and X server detach from it */
+	shmctl(fb_shm.shmid, IPC_RMID, NULL);
+	if (fb_shmFailed) {
+		shmdt(fb_shm.shmaddr);
+		XFree(fb_image); return false;
+	}
+	return true;
+}
+#endif
+
 void Window_AllocFramebuffer(struct Bitmap* bmp, int width, int height) {
 	Window win = Window_Main.Handle.val;
 	if (!fb_gc) fb_gc = XCreateGC(win_display, win, 0, NULL);
 
-	bmp->scan0  = (BitmapCol*)Mem_Alloc(width * height, BITMAPCOLOR_SIZE, "window pixels");
 	bmp->width  = width;
 	bmp->height = height;
 
@@ -1229,7 +1318,20 @@ void Window_AllocFramebuffer(struct Bitmap* bmp, int width, int height) {
 	/* Easy for 24/32 bit case, but much trickier with other depths */
 	/*  (have to do a manual and slow second blit for other depths) */
 	fb_fast = win_visual.depth == 24 || win_visual.depth == 32;
-	fb_data = fb_fast ? bmp->scan0 : Mem_Alloc(width * height, BITMAPCOLOR_SIZE, "window blit");
+
+#ifdef CC_BUILD_XSHM
+	fb_shmUsed = AllocShmFramebuffer(width, height);
+	if (fb_shmUsed) {
+		/* Game can draw directly into the shared memory when the pixel layout matches */
+		fb_fast    = fb_fast && fb_image->bytes_per_line == width * BITMAPCOLOR_SIZE;
+		fb_data    = fb_image->data;
+		bmp->scan0 = fb_fast ? (BitmapCol*)fb_data : (BitmapCol*)Mem_Alloc(width * height, BITMAPCOLOR_SIZE, "window pixels");
+		return;
+	}
+#endif
+
+	bmp->scan0 = (BitmapCol*)Mem_Alloc(width * height, BITMAPCOLOR_SIZE, "window pixels");
+	fb_data    = fb_fast ? bmp->scan0 : Mem_Alloc(width * height, BITMAPCOLOR_SIZE, "window blit");
 
 	fb_image = XCreateImage(win_display, win_visual.visual,
 		win_visual.depth, ZPixmap, 0, (char*)fb_data,
@@ -1283,11 +1385,35 @@ void Window_DrawFramebuffer(Rect2D r, struct Bitmap* bmp) {
 	/* Convert 32 bit depth to window depth when required */
 	if (!fb_fast) BlitFramebuffer(r.x, r.y, r.width, r.height, bmp);
 
+#ifdef CC_BUILD_XSHM
+	if (fb_shmUsed) {
+		_XShmPutImage(win_display, win, fb_gc, fb_image,
+			r.x, r.y, r.x, r.y, r.width, r.height, False);
+		/* X server reads from the shared pixels asynchronously, so wait until it's done */
+		/*  to avoid the next frame being drawn into them while they're still being read */
+		XSync(win_display, False);
+		return;
+	}
+#endif
+
 	XPutImage(win_display, win, fb_gc, fb_image,
 		r.x, r.y, r.x, r.y, r.width, r.height);
 }
 
 void Window_FreeFramebuffer(struct Bitmap* bmp) {
+#ifdef CC_BUILD_XSHM
+	if (fb_shmUsed) {
+		_XShmDetach(win_display, &fb_shm);
+		XSync(win_display, False);
+		XFree(fb_image);
+		shmdt(fb_shm.shmaddr);
+
+		if (bmp->scan0 != fb_data) Mem_Free(bmp->scan0);
+		fb_shmUsed = false;
+		return;
+	}
+#endif
+
 	XFree(fb_image);
 	Mem_Free(bmp->scan0);
 	if (bmp->scan0 != fb_data) Mem_Free(fb_data);
@@ -1297,7 +1423,7 @@ void OnscreenKeyboard_Open(struct OpenKeyboardArgs* args) { }
 void OnscreenKeyboard_SetText(const cc_string* text) { }
 void OnscreenKeyboard_Close(void) { }
 
-static cc_bool rawMouseInited, rawMouseSupported;
+static cc_bool rawMouseInited, rawMouseSupported, pointerGrabbed;
 static int xiOpcode;
 
 #ifdef CC_BUILD_XINPUT2
@@ -1322,6 +1448,20 @@ static void CheckMovementDelta(double dx, double dy) {
 	rawMouseSupported = false;
 }
 
+/* High polling rate mice can produce many raw motion events per frame, */
+/*  so the deltas are summed up and only raised once per event loop */
+static double rawDeltaX, rawDeltaY;
+static cc_bool rawDeltaPending;
+
+static void FlushRawMotion(void) {
+	if (!rawDeltaPending) return;
+	rawDeltaPending = false;
+
+	/* Using 0.5f here makes the sensitivity about same as normal cursor movement */
+	Event_RaiseRawMove(&PointerEvents.RawMoved, (float)rawDeltaX * 0.5f, (float)rawDeltaY * 0.5f);
+	rawDeltaX = 0; rawDeltaY = 0;
+}
+
 static void HandleGenericEvent(XEvent* e) {
 	const double* values;
 	XIRawEvent* ev;
@@ -1339,8 +1479,8 @@ static void HandleGenericEvent(XEvent* e) {
 		dy = XIMaskIsSet(ev->valuators.mask, 1) ? *values++ : 0;
 
 		CheckMovementDelta(dx, dy);
-		/* Using 0.5f here makes the sensitivity about same as normal cursor movement */
-		Event_RaiseRawMove(&PointerEvents.RawMoved, dx * 0.5f, dy * 0.5f);
+		rawDeltaX += dx; rawDeltaY += dy;
+		rawDeltaPending = true;
 	}
 	XFreeEventData(win_display, &e->xcookie);
 }
@@ -1384,6 +1524,7 @@ static void InitRawMouse(void) {
 }
 #else
 static void HandleGenericEvent(XEvent* e) { }
+static void FlushRawMotion(void) { }
 static void InitRawMouse(void) { }
 #endif
 
@@ -1394,14 +1535,16 @@ void Window_EnableRawMouse(void) {
 	rawMouseInited = true;
 
 	if (!grabCursor) return;
-	XGrabPointer(win_display, win, True, ButtonPressMask | ButtonReleaseMask | PointerMotionMask,
-		GrabModeAsync, GrabModeAsync, win, blankCursor, CurrentTime);
+	pointerGrabbed = XGrabPointer(win_display, win, True, ButtonPressMask | ButtonReleaseMask | PointerMotionMask,
+		GrabModeAsync, GrabModeAsync, win, blankCursor, CurrentTime) == GrabSuccess;
 }
 
 void Window_UpdateRawMouse(void) {
 	if (rawMouseSupported) {
 		/* Handled by XI_RawMotion generic event */
-		CentreMousePosition();
+		/* Raw motion is still delivered when the grabbed pointer is at the edge of */
+		/*  the window, so there's no need to keep warping the pointer back to centre */
+		if (!pointerGrabbed) CentreMousePosition();
 	} else {
 		DefaultUpdateRawMouse();
 	}
@@ -1411,6 +1554,7 @@ void Window_DisableRawMouse(void) {
 	DefaultDisableRawMouse();
 	if (!grabCursor) return;
 	XUngrabPointer(win_display, CurrentTime);
+	pointerGrabbed = false;
 }
 
 
@@ -10,9 +10,16 @@
 #include "Game.h"
 #include "TexturePack.h"
 #include "Window.h"
+#include "Stream.h"
+#include "Funcs.h"
+#include "Errors.h"
 
 struct _WorldData World;
 static char nameBuffer[STRING_SIZE];
+#ifdef EXTENDED_BLOCKS
+/* Upper 8 bits of all blocks, as given by World_SetMapUpper */
+static BlockRaw* upperBlocks;
+#endif
 /*########################################################################################################################*
 *----------------------------------------------------------World----------------------------------------------------------*
 *#########################################################################################################################*/
@@ -37,14 +44,52 @@ static void GenerateNewUuid(void) {
 	World.Uuid[8] |= 0x80; /* variant 2*/
 }
 
-void World_Reset(void) {
+#ifdef CC_BUILD_BRICKWORLD
+static void World_FreeBricks(void);
+static void World_LoadBricks(void);
+#endif
+#ifdef CC_BUILD_PAGEDWORLD
+static void* WorldPage_Acquire(struct WorldBrick* b);
+static void  WorldPage_MarkDirty(struct WorldBrick* b);
+#endif
 #ifdef EXTENDED_BLOCKS
-	if (World.Blocks != World.Blocks2) Mem_Free(World.Blocks2);
-	World.Blocks2 = NULL;
-	World.IDMask  = 0xFF;
+static void World_FreeUpper(void);
+#endif
+#if defined EXTENDED_BLOCKS && !defined CC_BUILD_BRICKWORLD
+static void World_LoadUpper(void);
+#endif
+
+#ifdef CC_BUILD_FILEMAP
+/* Length of the mapping World.Blocks points to, or 0 if allocated normally */
+static cc_uint32 mappedLength;
+
+void World_SetBlocksMapped(cc_uint32 mapLength) { mappedLength = mapLength; }
+#endif
+
+static void World_FreeBlocks(void) {
+#ifdef CC_BUILD_FILEMAP
+	if (mappedLength) {
+		File_Unmap(World.Blocks, mappedLength);
+		mappedLength = 0;
+	} else
 #endif
-	Mem_Free(World.Blocks);
+	{
+		Mem_Free(World.Blocks);
+	}
 	World.Blocks = NULL;
+}
+
+void World_Reset(void) {
+#ifdef CC_BUILD_BRICKWORLD
+	World_FreeBricks();
+#endif
+#ifdef EXTENDED_BLOCKS
+	World_FreeUpper();
+	Mem_Free(upperBlocks);
+	upperBlocks  = NULL;
+	World.IDMask = 0xFF;
+#endif
+	World_FreeBlocks();
 	String_InitArray(World.Name, nameBuffer);
 
 	World_SetDimensions(0, 0, 0);
@@ -66,14 +111,17 @@ void World_SetNewMap(BlockRaw* blocks, int width, int height, int length) {
 	World_SetDimensions(width, height, length);
 	World.Blocks      = blocks;
 	World.Name.length = 0;
+	Mem_Track(MEM_TRACK_HEAP, blocks, World.Volume, "world blocks");
 
 	if (!World.Volume) World.Blocks = NULL;
 #ifdef EXTENDED_BLOCKS
 	/* .cw maps may have set this to a non-NULL when importing */
-	if (!World.Blocks2) {
-		World.Blocks2 = World.Blocks;
-		World.IDMask  = 0xFF;
-	}
+	if (!upperBlocks) World.IDMask = 0xFF;
+#endif
+#if defined CC_BUILD_BRICKWORLD
+	World_LoadBricks();
+#elif defined EXTENDED_BLOCKS
+	World_LoadUpper();
 #endif
 
 	if (Env.EdgeHeight == -1)   { Env.EdgeHeight   = height / 2; }
@@ -98,13 +146,21 @@ CC_NOINLINE void World_SetDimensions(int width, int height, int length) {
 	World.ChunksZ = (length + CHUNK_MAX) >> CHUNK_SHIFT;
 
 	World.ChunksCount = World.ChunksX * World.ChunksY * World.ChunksZ;
+#ifdef CC_BUILD_BRICKWORLD
+	World.BricksX = (width  + BRICK_MASK) >> BRICK_SHIFT;
+	World.BricksY = (height + BRICK_MASK) >> BRICK_SHIFT;
+	World.BricksZ = (length + BRICK_MASK) >> BRICK_SHIFT;
+#endif
 }
 
 #ifdef EXTENDED_BLOCKS
 void World_SetMapUpper(BlockRaw* blocks) {
-	World.Blocks2 = blocks;
-	World.IDMask  = 0x3FF;
+	Mem_Free(upperBlocks);
+	upperBlocks  = blocks;
+	World.IDMask = 0x3FF;
 }
+
+BlockRaw* World_GetMapUpper(void) { return upperBlocks; }
 #endif
 
 void World_OutOfMemory(void) {
@@ -113,26 +169,120 @@ void World_OutOfMemory(void) {
 }
 
 
+#if defined CC_BUILD_BRICKWORLD
+static BlockID brick_blocks[BRICK_VOLUME];
+
+/* Converts a brick to storing one BlockID per block */
+#ifdef CC_BUILD_PAGEDWORLD
+static cc_bool WorldBrick_MakeRaw(struct WorldBrick* b) {
+	int i;
+	/* Pages are always large enough to store one BlockID per block */
+	for (i = 0; i < BRICK_VOLUME; i++) 
+	{
+		brick_blocks[i] = WorldBrick_Get(b, i);
+	}
+	Mem_Copy(b->data, brick_blocks, sizeof(brick_blocks));
+
+	b->paletteCount = 0;
+	return true;
+}
+#else
+static cc_bool WorldBrick_MakeRaw(struct WorldBrick* b) {
+	BlockID* data = (BlockID*)Mem_TryAlloc(BRICK_VOLUME, sizeof(BlockID));
+	int i;
+	if (!data) return false;
+	Mem_Track(MEM_TRACK_HEAP, data, BRICK_VOLUME * sizeof(BlockID), "world bricks");
+
+	for (i = 0; i < BRICK_VOLUME; i++) 
+	{
+		data[i] = WorldBrick_Get(b, i);
+	}
+	Mem_Free(b->data);
+
+	b->data         = data;
+	b->paletteCount = 0;
+	return true;
+}
+#endif
+
+static void WorldBrick_Set(struct WorldBrick* b, int i, BlockID block) {
+	cc_uint8* cur;
+	int p, shift;
+
+#ifdef CC_BUILD_PAGEDWORLD
+	if (!b->data && b->packed && !WorldBrick_PageIn(b)) { World_OutOfMemory(); return; }
+	WorldPage_MarkDirty(b);
+#endif
+	if (!b->paletteCount) { ((BlockID*)b->data)[i] = block; return; }
+	for (p = 0; p < b->paletteCount; p++) 
+	{
+		if (b->palette[p] == block) break;
+	}
+
+	/* Setting a block in a uniform brick to the same block */
+	if (!b->data && p == 0) return;
+
+	if (p == BRICK_MAX_PALETTE) {
+		if (!WorldBrick_MakeRaw(b)) { World_OutOfMemory(); return; }
+		((BlockID*)b->data)[i] = block; return;
+	}
+
+	/* Uniform brick needs to become a paletted brick (palette index 0 for every block) */
+	if (!b->data) {
+#ifdef CC_BUILD_PAGEDWORLD
+		b->data = WorldPage_Acquire(b);
+		if (!b->data) { World_OutOfMemory(); return; }
+		Mem_Set(b->data, 0, BRICK_VOLUME / 2);
+#else
+		b->data = Mem_TryAllocCleared(BRICK_VOLUME / 2, 1);
+		if (!b->data) { World_OutOfMemory(); return; }
+		Mem_Track(MEM_TRACK_HEAP, b->data, BRICK_VOLUME / 2, "world bricks");
+#endif
+	}
+	if (p == b->paletteCount) b->palette[b->paletteCount++] = block;
+
+	cur   = (cc_uint8*)b->data + (i >> 1);
+	shift = (i & 1) << 2;
+	*cur  = (*cur & ~(0x0F << shift)) | (p << shift);
+}
+
+void World_SetBlock(int x, int y, int z, BlockID block) {
+	struct WorldBrick* b = &World.Bricks[World_BrickPack(x >> BRICK_SHIFT, y >> BRICK_SHIFT, z >> BRICK_SHIFT)];
 #ifdef EXTENDED_BLOCKS
+	if (block > 0xFF) World.IDMask = 0x3FF;
+#endif
+	WorldBrick_Set(b, World_BrickIndex(x, y, z), block);
+}
+#elif defined EXTENDED_BLOCKS
 static CC_NOINLINE void LazyInitUpper(int i, BlockID block) {
-	BlockRaw* data = (BlockRaw*)Mem_TryAllocCleared(World.Volume, 1);
-	if (!data) { World_OutOfMemory(); return; }
+	BlockRaw* page;
+
+	if (!World.Upper) {
+		World.Upper = (BlockRaw**)Mem_TryAllocCleared(World_UpperPages(), sizeof(BlockRaw*));
+		if (!World.Upper) { World_OutOfMemory(); return; }
+		World.IDMask = 0x3FF;
+	}
+
+	page = (BlockRaw*)Mem_TryAllocCleared(WORLD_UPPER_SIZE, 1);
+	if (!page) { World_OutOfMemory(); return; }
+	Mem_Track(MEM_TRACK_HEAP, page, WORLD_UPPER_SIZE, "world upper blocks");
 
-	World_SetMapUpper(data);
-	World.Blocks2[i] = (BlockRaw)(block >> 8);
+	World.Upper[i >> WORLD_UPPER_SHIFT] = page;
+	page[i & WORLD_UPPER_MASK] = (BlockRaw)(block >> 8);
 }
 
 void World_SetBlock(int x, int y, int z, BlockID block) {
 	int i = World_Pack(x, y, z);
+	BlockRaw* page;
 	World.Blocks[i] = (BlockRaw)block;
 
-	/* defer allocation of second map array if possible */
-	if (World.Blocks == World.Blocks2) {
-		if (block < 256) return;
+	/* defer allocation of upper page if possible */
+	page = World.Upper ? World.Upper[i >> WORLD_UPPER_SHIFT] : NULL;
+	if (page) {
+		page[i & WORLD_UPPER_MASK] = (BlockRaw)(block >> 8);
+	} else if (block >= 256) {
 		LazyInitUpper(i, block);
-		return;
 	}
-	World.Blocks2[i] = (BlockRaw)(block >> 8);
 }
 #else
 void World_SetBlock(int x, int y, int z, BlockID block) {
@@ -152,6 +302,379 @@ BlockID World_SafeGetBlock(int x, int y, int z) {
 }
 
 
+#ifdef CC_BUILD_BRICKWORLD
+/*########################################################################################################################*
+*-------------------------------------------------------Brick storage-----------------------------------------------------*
+*#########################################################################################################################*/
+#ifdef CC_BUILD_PAGEDWORLD
+static cc_uint8 page_temp[BRICK_VOLUME / 2];
+static void WorldPage_FreeAll(void);
+static cc_bool WorldPage_Pack(struct WorldBrick* b, const void* data, int size);
+#endif
+
+static void World_FreeBricks(void) {
+	int i, count = World.BricksX * World.BricksY * World.BricksZ;
+	if (!World.Bricks) return;
+
+	for (i = 0; i < count; i++) 
+	{
+#ifdef CC_BUILD_PAGEDWORLD
+		/* data only ever points into the shared pages */
+		Mem_Free(World.Bricks[i].packed);
+#else
+		Mem_Free(World.Bricks[i].data);
+#endif
+	}
+	Mem_Free(World.Bricks);
+	World.Bricks = NULL;
+#ifdef CC_BUILD_PAGEDWORLD
+	WorldPage_FreeAll();
+#endif
+}
+
+#ifdef EXTENDED_BLOCKS
+#define World_GetFlatBlock(idx) (upperBlocks ? (World.Blocks[idx] | (upperBlocks[idx] << 8)) & World.IDMask : World.Blocks[idx])
+#else
+#define World_GetFlatBlock(idx) World.Blocks[idx]
+#endif
+
+/* Copies the blocks of the given brick from the flat blocks array, then picks the smallest storage for them */
+static cc_bool WorldBrick_Load(struct WorldBrick* b, int x1, int y1, int z1) {
+	int x2 = min(x1 + BRICK_SIZE, World.Width);
+	int y2 = min(y1 + BRICK_SIZE, World.Height);
+	int z2 = min(z1 + BRICK_SIZE, World.Length);
+	int x, y, z, i, p, index;
+	BlockID block, last;
+	cc_uint8* data;
+
+	/* Parts of edge bricks outside the map are never read, so copy the first block */
+	/*  into them so that they don't stop the brick from being uniform */
+	block = World_GetFlatBlock(World_Pack(x1, y1, z1));
+	if (x2 - x1 < BRICK_SIZE || y2 - y1 < BRICK_SIZE || z2 - z1 < BRICK_SIZE) {
+		for (i = 0; i < BRICK_VOLUME; i++) brick_blocks[i] = block;
+	}
+
+	b->palette[0]   = block;
+	b->paletteCount = 1;
+	last = block;
+
+	for (y = y1; y < y2; y++) {
+		for (z = z1; z < z2; z++) {
+			index = World_Pack(x1, y, z);
+			i     = World_BrickIndex(x1, y, z);
+
+			for (x = x1; x < x2; x++, index++, i++) {
+				block = World_GetFlatBlock(index);
+				brick_blocks[i] = block;
+				if (block == last || !b->paletteCount) continue;
+				last = block;
+
+				for (p = 0; p < b->paletteCount; p++) 
+				{
+					if (b->palette[p] == block) break;
+				}
+				if (p < b->paletteCount) continue;
+
+				if (p == BRICK_MAX_PALETTE) {
+					b->paletteCount = 0;
+				} else {
+					b->palette[b->paletteCount++] = block;
+				}
+			}
+		}
+	}
+
+	if (b->paletteCount == 1) return true;
+#ifdef CC_BUILD_PAGEDWORLD
+	/* Bricks start out paged out, so only the compressed data of each is stored */
+	if (!b->paletteCount) return WorldPage_Pack(b, brick_blocks, sizeof(brick_blocks));
+
+	data = page_temp;
+	Mem_Set(data, 0, BRICK_VOLUME / 2);
+	for (i = 0; i < BRICK_VOLUME; i++) 
+	{
+		block = brick_blocks[i];
+		for (p = 0; b->palette[p] != block; p++) { }
+		data[i >> 1] |= p << ((i & 1) << 2);
+	}
+	return WorldPage_Pack(b, data, BRICK_VOLUME / 2);
+#else
+	if (!b->paletteCount) {
+		b->data = Mem_TryAlloc(BRICK_VOLUME, sizeof(BlockID));
+		if (!b->data) return false;
+		Mem_Track(MEM_TRACK_HEAP, b->data, BRICK_VOLUME * sizeof(BlockID), "world bricks");
+
+		Mem_Copy(b->data, brick_blocks, sizeof(brick_blocks));
+		return true;
+	}
+
+	data = (cc_uint8*)Mem_TryAllocCleared(BRICK_VOLUME / 2, 1);
+	if (!data) return false;
+	b->data = data;
+	Mem_Track(MEM_TRACK_HEAP, data, BRICK_VOLUME / 2, "world bricks");
+
+	for (i = 0; i < BRICK_VOLUME; i++) 
+	{
+		block = brick_blocks[i];
+		for (p = 0; b->palette[p] != block; p++) { }
+		data[i >> 1] |= p << ((i & 1) << 2);
+	}
+	return true;
+#endif
+}
+
+/* Moves the flat blocks array given to World_SetNewMap into bricks */
+static void World_LoadBricks(void) {
+	struct WorldBrick* b;
+	cc_bool success = true;
+	int x, y, z;
+	if (!World.Blocks) return;
+
+	World.Bricks = (struct WorldBrick*)Mem_TryAllocCleared(World.BricksX * World.BricksY * World.BricksZ, 
+															sizeof(struct WorldBrick));
+	success = World.Bricks != NULL;
+	Mem_Track(MEM_TRACK_HEAP, World.Bricks, 
+			World.BricksX * World.BricksY * World.BricksZ * sizeof(struct WorldBrick), "world bricks");
+
+	for (y = 0; success && y < World.BricksY; y++) {
+		for (z = 0; success && z < World.BricksZ; z++) {
+			for (x = 0; success && x < World.BricksX; x++) {
+				b = &World.Bricks[World_BrickPack(x, y, z)];
+				success = WorldBrick_Load(b, x << BRICK_SHIFT, y << BRICK_SHIFT, z << BRICK_SHIFT);
+			}
+		}
+	}
+
+#ifdef EXTENDED_BLOCKS
+	Mem_Free(upperBlocks);
+	upperBlocks = NULL;
+#endif
+	World_FreeBlocks();
+
+	if (success) return;
+	World_FreeBricks();
+	World_SetDimensions(0, 0, 0);
+	Window_ShowDialog("Out of memory", "Not enough free memory to load the map.\nTry joining a different map.");
+}
+
+cc_result World_WriteBlocks(struct Stream* stream, cc_bool upper) {
+	int x, y, z, shift = upper ? 8 : 0;
+	BlockRaw* row;
+	cc_result res = 0;
+
+	row = (BlockRaw*)Mem_TryAlloc(World.Width, 1);
+	if (!row) return ERR_OUT_OF_MEMORY;
+
+	for (y = 0; !res && y < World.Height; y++) {
+		for (z = 0; !res && z < World.Length; z++) {
+			for (x = 0; x < World.Width; x++) {
+				row[x] = (BlockRaw)(World_GetBlock(x, y, z) >> shift);
+			}
+			res = Stream_Write(stream, row, World.Width);
+		}
+	}
+	Mem_Free(row);
+	return res;
+}
+#endif
+
+
+#ifdef CC_BUILD_PAGEDWORLD
+/*########################################################################################################################*
+*-------------------------------------------------------Brick paging------------------------------------------------------*
+*#########################################################################################################################*/
+/* Decompressed bricks are stored in a fixed number of pages, each large enough for one BlockID per block. */
+/* Bricks are compressed with a simple run length encoding, which is fast enough to run on every page fault */
+/*  while still compressing terrain (e.g. layers of stone or air with the odd ore) very well */
+#define PAGE_SIZE (BRICK_VOLUME * sizeof(BlockID))
+#define WorldPage_DataSize(b) ((b)->paletteCount ? BRICK_VOLUME / 2 : PAGE_SIZE)
+
+static cc_uint8* page_data;
+static struct WorldBrick* page_owners[WORLD_PAGED_BRICKS];
+static int page_hand;
+/* Worst case is one extra header byte for every 128 bytes */
+static cc_uint8 page_packed[PAGE_SIZE + PAGE_SIZE / 128 + 1];
+
+/* Encodes runs of 3 to 130 of the same byte as [n + 125, byte], and everything else as [n - 1, n bytes] */
+static int WorldPage_Compress(const cc_uint8* src, int len, cc_uint8* dst) {
+	int i = 0, run, start, size = 0;
+
+	while (i < len)
+	{
+		for (run = 1; i + run < len && run < 130 && src[i + run] == src[i]; run++) { }
+
+		if (run >= 3) {
+			dst[size++] = (cc_uint8)(run + 125);
+			dst[size++] = src[i];
+			i += run; continue;
+		}
+
+		for (start = i; i < len && i - start < 128; i++)
+		{
+			if (i + 2 < len && src[i] == src[i + 1] && src[i] == src[i + 2]) break;
+		}
+		dst[size++] = (cc_uint8)(i - start - 1);
+		Mem_Copy(dst + size, src + start, i - start);
+		size += i - start;
+	}
+	return size;
+}
+
+static void WorldPage_Decompress(const cc_uint8* src, cc_uint8* dst, int len) {
+	int n, count;
+
+	while (len > 0)
+	{
+		n = *src++;
+		if (n < 128) {
+			count = min(n + 1, len);
+			Mem_Copy(dst, src, count);
+			src += n + 1;
+		} else {
+			count = min(n - 125, len);
+			Mem_Set(dst, *src++, count);
+		}
+		dst += count; len -= count;
+	}
+}
+
+static cc_bool WorldPage_Pack(struct WorldBrick* b, const void* data, int size) {
+	int len = WorldPage_Compress((const cc_uint8*)data, size, page_packed);
+	void* packed = Mem_TryAlloc(len, 1);
+	if (!packed) return false;
+
+	Mem_Copy(packed, page_packed, len);
+	b->packed = packed;
+	return true;
+}
+
+static void WorldPage_MarkDirty(struct WorldBrick* b) {
+	Mem_Free(b->packed);
+	b->packed = NULL;
+}
+
+/* Finds a page to decompress the given brick into (paging out an unused brick if necessary) */
+static void* WorldPage_Acquire(struct WorldBrick* b) {
+	struct WorldBrick* owner;
+	int i;
+
+	if (!page_data) {
+		page_data = (cc_uint8*)Mem_TryAlloc(WORLD_PAGED_BRICKS, PAGE_SIZE);
+		if (!page_data) return NULL;
+		Mem_Track(MEM_TRACK_HEAP, page_data, WORLD_PAGED_BRICKS * PAGE_SIZE, "world brick pages");
+	}
+
+	/* Clock algorithm, where recently used bricks get a second chance before being paged out */
+	for (i = 0; i < WORLD_PAGED_BRICKS * 2; i++)
+	{
+		owner = page_owners[page_hand];
+		if (!owner) break;
+
+		if (owner->used) {
+			owner->used = false;
+		} else if (owner->packed || WorldPage_Pack(owner, owner->data, WorldPage_DataSize(owner))) {
+			owner->data = NULL; break;
+		}
+		page_hand = (page_hand + 1) % WORLD_PAGED_BRICKS;
+	}
+	if (page_owners[page_hand] && page_owners[page_hand]->data) return NULL;
+
+	page_owners[page_hand] = b;
+	b->used = true;
+	i = page_hand;
+
+	page_hand = (page_hand + 1) % WORLD_PAGED_BRICKS;
+	return page_data + i * PAGE_SIZE;
+}
+
+cc_bool WorldBrick_PageIn(struct WorldBrick* b) {
+	void* data = WorldPage_Acquire(b);
+	if (!data) return false;
+
+	WorldPage_Decompress((const cc_uint8*)b->packed, (cc_uint8*)data, WorldPage_DataSize(b));
+	b->data = data;
+	return true;
+}
+
+static void WorldPage_FreeAll(void) {
+	Mem_Free(page_data);
+	page_data = NULL;
+	page_hand = 0;
+	Mem_Set(page_owners, 0, sizeof(page_owners));
+}
+#endif
+
+#ifdef EXTENDED_BLOCKS
+/*########################################################################################################################*
+*----------------------------------------------------Upper block storage--------------------------------------------------*
+*#########################################################################################################################*/
+static void World_FreeUpper(void) {
+	int i, count = World_UpperPages();
+	if (!World.Upper) return;
+
+	for (i = 0; i < count; i++) 
+	{
+		Mem_Free(World.Upper[i]);
+	}
+	Mem_Free(World.Upper);
+	World.Upper = NULL;
+}
+
+#ifndef CC_BUILD_BRICKWORLD
+/* Splits the upper blocks array into pages, only keeping pages which contain blocks above 255 */
+static void World_LoadUpper(void) {
+	int i, j, len, count = World_UpperPages();
+	BlockRaw* src;
+	BlockRaw* page;
+	cc_bool success;
+	if (!upperBlocks) return;
+	if (!World.Volume) { Mem_Free(upperBlocks); upperBlocks = NULL; return; }
+
+	World.Upper = (BlockRaw**)Mem_TryAllocCleared(count, sizeof(BlockRaw*));
+	success     = World.Upper != NULL;
+
+	for (i = 0; success && i < count; i++) {
+		src = upperBlocks + (i << WORLD_UPPER_SHIFT);
+		len = min(WORLD_UPPER_SIZE, World.Volume - (i << WORLD_UPPER_SHIFT));
+
+		for (j = 0; j < len && !src[j]; j++) { }
+		if (j == len) continue;
+
+		page    = (BlockRaw*)Mem_TryAllocCleared(WORLD_UPPER_SIZE, 1);
+		success = page != NULL;
+		Mem_Track(MEM_TRACK_HEAP, page, WORLD_UPPER_SIZE, "world upper blocks");
+		if (success) Mem_Copy(page, src, len);
+		World.Upper[i] = page;
+	}
+
+	Mem_Free(upperBlocks);
+	upperBlocks = NULL;
+	if (success) return;
+
+	World_FreeUpper();
+	World_FreeBlocks();
+	World_SetDimensions(0, 0, 0);
+	Window_ShowDialog("Out of memory", "Not enough free memory to load the map.\nTry joining a different map.");
+}
+
+cc_result World_WriteBlocks(struct Stream* stream, cc_bool upper) {
+	static BlockRaw empty[WORLD_UPPER_SIZE];
+	int i, len, count = World_UpperPages();
+	const BlockRaw* page;
+	cc_result res;
+	if (!upper) return Stream_Write(stream, World.Blocks, World.Volume);
+
+	for (i = 0; i < count; i++) {
+		len  = min(WORLD_UPPER_SIZE, World.Volume - (i << WORLD_UPPER_SHIFT));
+		page = World.Upper && World.Upper[i] ? World.Upper[i] : empty;
+		if ((res = Stream_Write(stream, page, len))) return res;
+	}
+	return 0;
+}
+#endif
+#endif
+
+
 /*########################################################################################################################*
 *-------------------------------------------------------Environment-------------------------------------------------------*
 *#########################################################################################################################*/
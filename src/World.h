@@ -9,6 +9,7 @@ Represents a fixed size 3D array of blocks and associated metadata
 Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 */
 struct AABB;
+struct Stream;
 extern struct IGameComponent World_Component;
 
 /* Unpacka an index into x,y,z (slow!) */
@@ -20,14 +21,63 @@ extern struct IGameComponent World_Component;
 #define World_ChunkPack(cx, cy, cz) (((cz) * World.ChunksY + (cy)) * World.ChunksX + (cx))
 /* TODO: Swap Y and Z? Make sure to update MapRenderer's ResetChunkCache and ClearChunkCache methods! */
 
+#ifdef EXTENDED_BLOCKS
+#define WORLD_UPPER_SHIFT 12
+#define WORLD_UPPER_SIZE  (1 << WORLD_UPPER_SHIFT)
+#define WORLD_UPPER_MASK  (WORLD_UPPER_SIZE - 1)
+#define World_UpperPages() ((World.Volume + WORLD_UPPER_MASK) >> WORLD_UPPER_SHIFT)
+#endif
+
+#ifdef CC_BUILD_BRICKWORLD
+/* When CC_BUILD_BRICKWORLD is defined, blocks are stored in 16x16x16 bricks instead of one flat array. */
+/* Bricks containing only one type of block (e.g. sky) only use the few bytes of the brick itself, */
+/*  and bricks with at most 16 different blocks only use 4 bits per block. */
+/* NOTE: World.Blocks is then only used to hand the loaded/generated blocks to World_SetNewMap */
+#define BRICK_SHIFT 4
+#define BRICK_SIZE  16
+#define BRICK_MASK  15
+#define BRICK_VOLUME (BRICK_SIZE * BRICK_SIZE * BRICK_SIZE)
+#define BRICK_MAX_PALETTE 16
+
+struct WorldBrick {
+	/* NULL when every block in the brick is palette[0] */
+	/* Otherwise, 4 bit palette indices, or one BlockID per block if paletteCount is 0 */
+	void* data;
+#ifdef CC_BUILD_PAGEDWORLD
+	/* Compressed copy of data, or NULL if data has been changed since it was last compressed */
+	/* NOTE: data is NULL while the brick is paged out, in which case this is always non-NULL */
+	void* packed;
+	/* Whether the brick has been accessed since the pager last checked it */
+	cc_bool used;
+#endif
+	int paletteCount;
+	BlockID palette[BRICK_MAX_PALETTE];
+};
+
+#ifdef CC_BUILD_PAGEDWORLD
+/* When CC_BUILD_PAGEDWORLD is defined, bricks are only kept decompressed while recently used, */
+/*  with at most WORLD_PAGED_BRICKS decompressed at once. The rest only use their compressed data. */
+#ifndef WORLD_PAGED_BRICKS
+#define WORLD_PAGED_BRICKS 64
+#endif
+/* Decompresses the given brick, paging out a brick that has not been used recently if necessary */
+/* Returns false if there was not enough memory, in which case the brick is left paged out */
+CC_NOINLINE cc_bool WorldBrick_PageIn(struct WorldBrick* b);
+#endif
+
+#define World_BrickPack(bx, by, bz) (((by) * World.BricksZ + (bz)) * World.BricksX + (bx))
+#define World_BrickIndex(x, y, z) ((((y) & BRICK_MASK) << 8) | (((z) & BRICK_MASK) << 4) | ((x) & BRICK_MASK))
+#endif
+
 
 CC_VAR extern struct _WorldData {
 	/* The blocks in the world. */
 	BlockRaw* Blocks;
 #ifdef EXTENDED_BLOCKS
-	/* The upper 8 bit of blocks in the world. */
-	/* If only 8 bit blocks are used, equals World_Blocks. */
-	BlockRaw* Blocks2;
+	/* The upper 8 bits of blocks in the world, split into pages of WORLD_UPPER_SIZE blocks. */
+	/* A page is only allocated once a block above 255 is stored in it. (NULL = all 0) */
+	/* NOTE: This is NULL when only 8 bit blocks are used. */
+	BlockRaw** Upper;
 #endif
 	/* Volume of the world. */
 	int Volume;
@@ -43,7 +93,7 @@ CC_VAR extern struct _WorldData {
 	cc_uint8 Uuid[WORLD_UUID_LEN];
 
 #ifdef EXTENDED_BLOCKS
-	/* Masks access to World.Blocks/World.Blocks2 */
+	/* Masks access to World.Blocks/World.Upper */
 	/* e.g. this will be 255 if only 8 bit blocks are used */
 	int IDMask;
 #endif
@@ -60,6 +110,12 @@ CC_VAR extern struct _WorldData {
 	int ChunksCount;
 	/* Seed world was generated with. May be 0 (unknown) */
 	int Seed;
+#ifdef CC_BUILD_BRICKWORLD
+	/* The bricks that blocks in the world are stored in. */
+	struct WorldBrick* Bricks;
+	/* Number of bricks on each axis the world is subdivided into */
+	int BricksX, BricksY, BricksZ;
+#endif
 } World;
 
 /* Frees the blocks array, sets dimensions to 0, resets environment to default. */
@@ -74,12 +130,65 @@ CC_API void World_SetNewMap(BlockRaw* blocks, int width, int height, int length)
 /* NOTE: This is an internal API. Use World_SetNewMap instead. */
 CC_NOINLINE void World_SetDimensions(int width, int height, int length);
 void World_OutOfMemory(void);
+#ifdef CC_BUILD_FILEMAP
+/* Marks World.Blocks as memory mapped from a file using File_Map */
+/* NOTE: The blocks are then unmapped (instead of freed) when no longer needed */
+void World_SetBlocksMapped(cc_uint32 mapLength);
+#endif
 
 #ifdef EXTENDED_BLOCKS
-/* Sets World.Blocks2 and updates internal state for more than 256 blocks. */
+/* Sets the upper 8 bits of all blocks in the world (i.e. one byte per block) */
+/* NOTE: The array is compacted into World.Upper and then freed by World_SetNewMap */
 void World_SetMapUpper(BlockRaw* blocks);
+/* Returns the array last passed to World_SetMapUpper, or NULL if none */
+/* NOTE: Only valid while importing a map (i.e. before World_SetNewMap) */
+BlockRaw* World_GetMapUpper(void);
+#endif
 
-#define World_GetRawBlock(idx) ((World.Blocks[idx] | (World.Blocks2[idx] << 8)) & World.IDMask)
+/* Whether the world currently has any blocks stored */
+#ifdef CC_BUILD_BRICKWORLD
+#define World_HasBlocks() (World.Bricks != NULL)
+#else
+#define World_HasBlocks() (World.Blocks != NULL)
+#endif
+
+#if defined CC_BUILD_BRICKWORLD
+#ifdef CC_BUILD_PAGEDWORLD
+static CC_INLINE BlockID WorldBrick_Get(struct WorldBrick* b, int i) {
+	if (!b->data && b->packed) WorldBrick_PageIn(b);
+	b->used = true;
+#else
+static CC_INLINE BlockID WorldBrick_Get(const struct WorldBrick* b, int i) {
+#endif
+	if (!b->data)         return b->palette[0];
+	if (!b->paletteCount) return ((BlockID*)b->data)[i];
+	return b->palette[(((cc_uint8*)b->data)[i >> 1] >> ((i & 1) << 2)) & 0x0F];
+}
+
+/* Gets the block at the given coordinates. */
+/* NOTE: Does NOT check that the coordinates are inside the map. */
+static CC_INLINE BlockID World_GetBlock(int x, int y, int z) {
+	struct WorldBrick* b = &World.Bricks[World_BrickPack(x >> BRICK_SHIFT, y >> BRICK_SHIFT, z >> BRICK_SHIFT)];
+	return WorldBrick_Get(b, World_BrickIndex(x, y, z));
+}
+
+/* Gets the block at the given packed index. (slow, as the index must be unpacked) */
+static CC_INLINE BlockID World_GetRawBlock(int idx) {
+	int x, y, z;
+	World_Unpack(idx, x, y, z);
+	return World_GetBlock(x, y, z);
+}
+
+#elif defined EXTENDED_BLOCKS
+/* Gets the block at the given packed index. */
+static CC_INLINE BlockID World_GetRawBlock(int idx) {
+	BlockRaw* page;
+	if (!World.Upper) return World.Blocks[idx];
+
+	page = World.Upper[idx >> WORLD_UPPER_SHIFT];
+	if (!page) return World.Blocks[idx];
+	return (World.Blocks[idx] | (page[idx & WORLD_UPPER_MASK] << 8)) & World.IDMask;
+}
 
 /* Gets the block at the given coordinates. */
 /* NOTE: Does NOT check that the coordinates are inside the map. */
@@ -92,6 +201,12 @@ static CC_INLINE BlockID World_GetBlock(int x, int y, int z) {
 #define World_GetRawBlock(idx)  World.Blocks[idx]
 #endif
 
+#if defined CC_BUILD_BRICKWORLD || defined EXTENDED_BLOCKS
+/* Writes either the lower or upper 8 bits of all blocks in the world to the given stream */
+/* (i.e. one byte per block, in the same order as World.Blocks) */
+cc_result World_WriteBlocks(struct Stream* stream, cc_bool upper);
+#endif
+
 /* If Y is above the map, returns BLOCK_AIR. */
 /* If coordinates are outside the map, returns BLOCK_AIR. */
 /* Otherwise returns the block at the given coordinates. */
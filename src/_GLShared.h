@@ -21,6 +21,12 @@
 #define uint_to_ptr(raw) ((void*)((cc_uintptr)(raw)))
 #define ptr_to_uint(raw) ((GLuint)((cc_uintptr)(raw)))
 
+#ifndef CC_BUILD_GLES
+#define GL_TEXTURE_COMPRESSION
+#endif
+static void GL_InitCompression(void);
+static void GL_InitMipmapGeneration(void);
+
 
 /*########################################################################################################################*
 *---------------------------------------------------------General---------------------------------------------------------*
@@ -36,6 +42,8 @@ void Gfx_Create(void) {
 	Gfx.LostContext  = false;
 
 	GLBackend_Init();
+	GL_InitCompression();
+	GL_InitMipmapGeneration();
 	Gfx_RestoreState();
 	GLContext_SetVSync(gfx_vsync);
 }
@@ -64,25 +72,243 @@ static void* FastAllocTempMem(int size) {
 }
 
 
+/*########################################################################################################################*
+*---------------------------------------------------Texture compression---------------------------------------------------*
+*#########################################################################################################################*/
+#ifdef GL_TEXTURE_COMPRESSION
+#define _GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+typedef void (APIENTRY *FP_glCompressedTexImage2D)(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data);
+typedef void (APIENTRY *FP_glCompressedTexSubImage2D)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void* data);
+static FP_glCompressedTexImage2D    _glCompressedTexImage2D;
+static FP_glCompressedTexSubImage2D _glCompressedTexSubImage2D;
+
+/* Texture IDs are usually allocated sequentially, so just use a bitset to track which textures are compressed */
+#define GL_MAX_COMPRESSED_ID 16384
+static cc_uint8 compressedIDs[GL_MAX_COMPRESSED_ID / 8];
+#define GL_IsCompressed(id) ((id) < GL_MAX_COMPRESSED_ID && (compressedIDs[(id) >> 3] & (1 << ((id) & 7))))
+
+static void GL_InitCompression(void) {
+	static const cc_string s3tcExt = String_FromConst("GL_EXT_texture_compression_s3tc");
+	cc_string exts = String_FromReadonly((const char*)glGetString(GL_EXTENSIONS));
+	Mem_Set(compressedIDs, 0, sizeof(compressedIDs));
+
+	Gfx.SupportsCompression = false;
+	if (!String_CaselessContains(&exts, &s3tcExt)) return;
+
+	/* glCompressedTexImage2D is core since OpenGL 1.3 */
+	_glCompressedTexImage2D    = (FP_glCompressedTexImage2D)   GLContext_GetAddress("glCompressedTexImage2D");
+	_glCompressedTexSubImage2D = (FP_glCompressedTexSubImage2D)GLContext_GetAddress("glCompressedTexSubImage2D");
+	Gfx.SupportsCompression    = _glCompressedTexImage2D && _glCompressedTexSubImage2D;
+}
+
+static int BC3_Nearest(const int* palette, int count, int r, int g, int b) {
+	int i, dr, dg, db, dist, best = 0, bestDist = 0x7FFFFFFF;
+
+	for (i = 0; i < count; i++)
+	{
+		dr = palette[i * 3 + 0] - r; dg = palette[i * 3 + 1] - g; db = palette[i * 3 + 2] - b;
+		dist = dr * dr + dg * dg + db * db;
+		if (dist < bestDist) { best = i; bestDist = dist; }
+	}
+	return best;
+}
+
+static int BC3_Pack565(const int* rgb) {
+	int r = (rgb[0] * 31 + 127) / 255, g = (rgb[1] * 63 + 127) / 255, b = (rgb[2] * 31 + 127) / 255;
+	return (r << 11) | (g << 5) | b;
+}
+
+static void BC3_Expand565(int c, int* rgb) {
+	int r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+/* Encodes a 4x4 block of pixels into a 16 byte BC3 (DXT5) block */
+/* Uses the inset bounding box of the block's colours as the endpoints, which is quick but lower quality */
+static void BC3_EncodeBlock(const BitmapCol* pixels, cc_uint8* dst) {
+	int minC[3] = { 255, 255, 255 }, maxC[3] = { 0, 0, 0 };
+	int minA = 255, maxA = 0, opaque = 0;
+	int palette[4 * 3], alphas[8];
+	int i, j, c0, c1, tmp, inset, a, idx, best, bestDist, dist;
+	cc_uint32 colorBits = 0;
+	cc_uint32 alphaLo = 0, alphaHi = 0;
+
+	for (i = 0; i < 16; i++)
+	{
+		a    = BitmapCol_A(pixels[i]);
+		minA = min(minA, a); maxA = max(maxA, a);
+		if (a >= 128) opaque++;
+	}
+
+	/* Colour of (mostly) transparent pixels is usually irrelevant, since they are alpha tested away */
+	for (i = 0; i < 16; i++)
+	{
+		if (opaque && BitmapCol_A(pixels[i]) < 128) continue;
+		minC[0] = min(minC[0], BitmapCol_R(pixels[i])); maxC[0] = max(maxC[0], BitmapCol_R(pixels[i]));
+		minC[1] = min(minC[1], BitmapCol_G(pixels[i])); maxC[1] = max(maxC[1], BitmapCol_G(pixels[i]));
+		minC[2] = min(minC[2], BitmapCol_B(pixels[i])); maxC[2] = max(maxC[2], BitmapCol_B(pixels[i]));
+	}
+
+	for (j = 0; j < 3; j++)
+	{
+		inset    = (maxC[j] - minC[j]) >> 4;
+		minC[j] += inset; maxC[j] -= inset;
+	}
+	c0 = BC3_Pack565(maxC);
+	c1 = BC3_Pack565(minC);
+	/* c0 > c1 selects the four colour mode */
+	if (c0 < c1) { tmp = c0; c0 = c1; c1 = tmp; }
+
+	BC3_Expand565(c0, &palette[0]);
+	BC3_Expand565(c1, &palette[3]);
+	for (j = 0; j < 3; j++)
+	{
+		palette[6 + j] = (2 * palette[j] + palette[3 + j]) / 3;
+		palette[9 + j] = (palette[j] + 2 * palette[3 + j]) / 3;
+	}
+
+	for (i = 0; i < 16; i++)
+	{
+		idx = BC3_Nearest(palette, c0 == c1 ? 1 : 4, 
+						BitmapCol_R(pixels[i]), BitmapCol_G(pixels[i]), BitmapCol_B(pixels[i]));
+		colorBits |= (cc_uint32)idx << (i * 2);
+	}
+
+	/* maxA > minA selects the eight alpha mode */
+	alphas[0] = maxA; alphas[1] = minA;
+	for (j = 1; j < 7; j++)
+	{
+		alphas[j + 1] = ((7 - j) * maxA + j * minA) / 7;
+	}
+
+	for (i = 0; i < 16; i++)
+	{
+		a = BitmapCol_A(pixels[i]);
+		best = 0; bestDist = 0x7FFFFFFF;
+
+		for (j = 0; j < (maxA == minA ? 1 : 8); j++)
+		{
+			dist = Math_AbsI(alphas[j] - a);
+			if (dist < bestDist) { best = j; bestDist = dist; }
+		}
+
+		/* 16 3 bit indices are stored as a 48 bit little endian integer */
+		if (i < 8) {
+			alphaLo |= (cc_uint32)best << (i * 3);
+		} else {
+			alphaHi |= (cc_uint32)best << ((i - 8) * 3);
+		}
+	}
+
+	dst[0] = maxA;
+	dst[1] = minA;
+	dst[2] = (cc_uint8)alphaLo; dst[3] = (cc_uint8)(alphaLo >> 8); dst[4] = (cc_uint8)(alphaLo >> 16);
+	dst[5] = (cc_uint8)alphaHi; dst[6] = (cc_uint8)(alphaHi >> 8); dst[7] = (cc_uint8)(alphaHi >> 16);
+
+	dst[8]  = (cc_uint8)c0; dst[9]  = (cc_uint8)(c0 >> 8);
+	dst[10] = (cc_uint8)c1; dst[11] = (cc_uint8)(c1 >> 8);
+	dst[12] = (cc_uint8)colorBits;         dst[13] = (cc_uint8)(colorBits >> 8);
+	dst[14] = (cc_uint8)(colorBits >> 16); dst[15] = (cc_uint8)(colorBits >> 24);
+}
+
+static void GL_UploadCompressed(int lvl, int x, int y, int width, int height, 
+								BitmapCol* src, int rowWidth, cc_bool partial) {
+	int blocksX = (width + 3) >> 2, blocksY = (height + 3) >> 2;
+	int size    = blocksX * blocksY * 16;
+	BitmapCol pixels[16];
+	cc_uint8* data;
+	cc_uint8* dst;
+	int bx, by, px, py, i;
+
+	dst = data = (cc_uint8*)Mem_Alloc(blocksX * blocksY, 16, "compressed texture");
+	for (by = 0; by < blocksY; by++)
+	{
+		for (bx = 0; bx < blocksX; bx++, dst += 16)
+		{
+			/* Texture dimensions may not be a multiple of 4 (e.g. 2x2 mipmap) */
+			for (i = 0; i < 16; i++)
+			{
+				px = min(bx * 4 + (i & 3),  width  - 1);
+				py = min(by * 4 + (i >> 2), height - 1);
+				pixels[i] = src[py * rowWidth + px];
+			}
+			BC3_EncodeBlock(pixels, dst);
+		}
+	}
+
+	if (partial) {
+		_glCompressedTexSubImage2D(GL_TEXTURE_2D, lvl, x, y, width, height, _GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, size, data);
+	} else {
+		_glCompressedTexImage2D(GL_TEXTURE_2D, lvl, _GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, width, height, 0, size, data);
+	}
+	Mem_Free(data);
+}
+#else
+static void GL_InitCompression(void) { }
+#define GL_IsCompressed(id) false
+#define GL_UploadCompressed(lvl, x, y, width, height, src, rowWidth, partial)
+#endif
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Mipmaps generation----------------------------------------------------*
+*#########################################################################################################################*/
+/* Dynamically loaded, as glGenerateMipmap is only core since OpenGL 3.0 (but is core in OpenGL ES 2.0) */
+typedef void (APIENTRY *FP_glGenerateMipmap)(GLenum target);
+static FP_glGenerateMipmap _glGenerateMipmap;
+
+#if defined CC_BUILD_GL11
+static void GL_InitMipmapGeneration(void) { }
+#elif defined CC_BUILD_WEB
+/* WebGL functions are statically linked by emscripten */
+GLAPI void APIENTRY glGenerateMipmap(GLenum target);
+
+static void GL_InitMipmapGeneration(void) {
+	_glGenerateMipmap = glGenerateMipmap;
+	Gfx.GpuMipmaps    = true;
+}
+#else
+static void GL_InitMipmapGeneration(void) {
+	_glGenerateMipmap = (FP_glGenerateMipmap)GLContext_GetAddress("glGenerateMipmap");
+	/* Also provided by GL_EXT_framebuffer_object on older drivers */
+	if (!_glGenerateMipmap)
+		_glGenerateMipmap = (FP_glGenerateMipmap)GLContext_GetAddress("glGenerateMipmapEXT");
+	Gfx.GpuMipmaps = _glGenerateMipmap != NULL;
+}
+#endif
+
+
 /*########################################################################################################################*
 *---------------------------------------------------------Textures--------------------------------------------------------*
 *#########################################################################################################################*/
-static void Gfx_DoMipmaps(int x, int y, struct Bitmap* bmp, int rowWidth, cc_bool partial) {
+static void Gfx_DoMipmaps(int x, int y, struct Bitmap* bmp, int rowWidth, cc_bool partial, cc_bool compressed) {
 	BitmapCol* prev = bmp->scan0;
 	BitmapCol* cur;
 
 	int lvls = CalcMipmapsLevels(bmp->width, bmp->height);
 	int lvl, width = bmp->width, height = bmp->height;
 
+	/* Much faster to let the GPU downsample the whole texture, than to downsample on the CPU and upload each level */
+	/* NOTE: Compressed textures can't be rendered to, so have to be downsampled on the CPU instead */
+	if (_glGenerateMipmap && !compressed) { _glGenerateMipmap(GL_TEXTURE_2D); return; }
+
 	for (lvl = 1; lvl <= lvls; lvl++) {
 		x /= 2; y /= 2;
 		if (width > 1)  width /= 2;
 		if (height > 1) height /= 2;
 
+		/* Compressed textures can only be updated in whole 4x4 blocks, */
+		/*  so lower mipmap levels of small updates have to be left as is */
+		if (compressed && partial && ((x | y | width | height) & 3)) break;
+
 		cur = (BitmapCol*)Mem_Alloc(width * height, BITMAPCOLOR_SIZE, "mipmaps");
 		GenMipmaps(width, height, cur, prev, rowWidth);
 
-		if (partial) {
+		if (compressed) {
+			GL_UploadCompressed(lvl, x, y, width, height, cur, width, partial);
+		} else if (partial) {
 			_glTexSubImage2D(GL_TEXTURE_2D, lvl, x, y, width, height, PIXEL_FORMAT, TRANSFER_FORMAT, cur);
 		} else {
 			_glTexImage2D(GL_TEXTURE_2D, lvl, GL_RGBA, width, height, 0, PIXEL_FORMAT, TRANSFER_FORMAT, cur);
@@ -120,6 +346,7 @@ static CC_NOINLINE void UpdateTextureSlow(int x, int y, struct Bitmap* part, int
 
 GfxResourceID Gfx_AllocTexture(struct Bitmap* bmp, int rowWidth, cc_uint8 flags, cc_bool mipmaps) {
 	GfxResourceID texId = NULL;
+	cc_bool compressed  = false;
 	_glGenTextures(1, (GLuint*)&texId);
 	_glBindTexture(GL_TEXTURE_2D, ptr_to_uint(texId));
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (flags & TEXTURE_FLAG_BILINEAR) ? GL_LINEAR : GL_NEAREST);
@@ -134,32 +361,54 @@ GfxResourceID Gfx_AllocTexture(struct Bitmap* bmp, int rowWidth, cc_uint8 flags,
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (flags & TEXTURE_FLAG_BILINEAR) ? GL_LINEAR : GL_NEAREST);
 	}
 
-	if (bmp->width == rowWidth) {
+#ifdef GL_TEXTURE_COMPRESSION
+	if ((flags & TEXTURE_FLAG_COMPRESSED) && Gfx.SupportsCompression && ptr_to_uint(texId) < GL_MAX_COMPRESSED_ID) {
+		GLuint id  = ptr_to_uint(texId);
+		compressed = true;
+		compressedIDs[id >> 3] |= 1 << (id & 7);
+	}
+#endif
+
+	if (compressed) {
+		GL_UploadCompressed(0, 0, 0, bmp->width, bmp->height, bmp->scan0, rowWidth, false);
+	} else if (bmp->width == rowWidth) {
 		_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, bmp->width, bmp->height, 0, PIXEL_FORMAT, TRANSFER_FORMAT, bmp->scan0);
 	} else {
 		UpdateTextureSlow(0, 0, bmp, rowWidth, true);
 	}
 
-	if (mipmaps) Gfx_DoMipmaps(0, 0, bmp, rowWidth, false);
+	if (mipmaps) Gfx_DoMipmaps(0, 0, bmp, rowWidth, false, compressed);
 	return texId;
 }
 
 void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, int rowWidth, cc_bool mipmaps) {
+	cc_bool compressed = GL_IsCompressed(ptr_to_uint(texId));
 	_glBindTexture(GL_TEXTURE_2D, ptr_to_uint(texId));
 
-	if (part->width == rowWidth) {
+	if (compressed) {
+		GL_UploadCompressed(0, x, y, part->width, part->height, part->scan0, rowWidth, true);
+#if CC_GFX_BACKEND == CC_GFX_BACKEND_GL2
+	} else if (Ring_UploadTexture(x, y, part, rowWidth)) {
+		/* Texture will be updated from the staged copy */
+#endif
+	} else if (part->width == rowWidth) {
 		_glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, part->width, part->height, PIXEL_FORMAT, TRANSFER_FORMAT, part->scan0);
 	} else {
 		UpdateTextureSlow(x, y, part, rowWidth, false);
 	}
 
-	if (mipmaps) Gfx_DoMipmaps(x, y, part, rowWidth, true);
+	if (mipmaps) Gfx_DoMipmaps(x, y, part, rowWidth, true, compressed);
 }
 
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	GLuint id = ptr_to_uint(*texId);
+	Mem_Untrack(MEM_TRACK_TEXTURE, *texId);
 	if (id) _glDeleteTextures(1, &id);
 	*texId = 0;
+
+#ifdef GL_TEXTURE_COMPRESSION
+	if (id < GL_MAX_COMPRESSED_ID) compressedIDs[id >> 3] &= ~(1 << (id & 7));
+#endif
 }
 
 void Gfx_EnableMipmaps(void) { }
@@ -236,19 +485,28 @@ static BitmapCol* GL_GetRow(struct Bitmap* bmp, int y, void* ctx) {
 	/* OpenGL stores bitmap in bottom-up order, so flip order when saving */
 	return Bitmap_GetRow(bmp, (bmp->height - 1) - y); 
 }
-cc_result Gfx_TakeScreenshot(struct Stream* output) {
-	struct Bitmap bmp;
-	cc_result res;
+cc_result Gfx_ReadScreenshot(struct Bitmap* bmp) {
 	GLint vp[4];
-	
 	glGetIntegerv(GL_VIEWPORT, vp); /* { x, y, width, height } */
-	bmp.width  = vp[2]; 
-	bmp.height = vp[3];
+	bmp->width  = vp[2]; 
+	bmp->height = vp[3];
 
-	bmp.scan0  = (BitmapCol*)Mem_TryAlloc(bmp.width * bmp.height, BITMAPCOLOR_SIZE);
-	if (!bmp.scan0) return ERR_OUT_OF_MEMORY;
-	glReadPixels(0, 0, bmp.width, bmp.height, PIXEL_FORMAT, TRANSFER_FORMAT, bmp.scan0);
+	bmp->scan0  = (BitmapCol*)Mem_TryAlloc(bmp->width * bmp->height, BITMAPCOLOR_SIZE);
+	if (!bmp->scan0) return ERR_OUT_OF_MEMORY;
+	glReadPixels(0, 0, bmp->width, bmp->height, PIXEL_FORMAT, TRANSFER_FORMAT, bmp->scan0);
+	return 0;
+}
 
+void Gfx_CopyBackbuffer(GfxResourceID texId, int width, int height) {
+	_glBindTexture(GL_TEXTURE_2D, ptr_to_uint(texId));
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+}
+
+cc_result Gfx_TakeScreenshot(struct Stream* output) {
+	struct Bitmap bmp;
+	cc_result res;
+	
+	if ((res = Gfx_ReadScreenshot(&bmp))) return res;
 	res = Png_Encode(&bmp, output, GL_GetRow, false, NULL);
 	Mem_Free(bmp.scan0);
 	return res;
@@ -286,6 +544,7 @@ void Gfx_GetApiInfo(cc_string* info) {
 	String_Format1(info, "GL version: %c\n", glGetString(GL_VERSION));
 	AppendVRAMStats(info);
 	PrintMaxTextureInfo(info);
+	if (Gfx.SupportsCompression) String_AppendConst(info, "Texture compression: BC3\n");
 	String_Format1(info, "Depth buffer bits: %i\n",      &depthBits);
 	GLContext_GetApiInfo(info);
 }
@@ -311,6 +570,9 @@ void Gfx_EndFrame(void) {
 	} else {
 		EndReducedPerformance();
 	}
+#endif
+#if CC_GFX_BACKEND == CC_GFX_BACKEND_GL2
+	Ring_EndFrame();
 #endif
 	/* TODO always run ?? */
 
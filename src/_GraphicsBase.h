@@ -15,7 +15,7 @@ struct _GfxData Gfx;
 static GfxResourceID Gfx_quadVb, Gfx_texVb;
 const cc_string Gfx_LowPerfMessage = String_FromConst("&eRunning in reduced performance mode (game minimised or hidden)");
 
-static const int strideSizes[] = { SIZEOF_VERTEX_COLOURED, SIZEOF_VERTEX_TEXTURED };
+static const int strideSizes[] = { SIZEOF_VERTEX_COLOURED, SIZEOF_VERTEX_TEXTURED, SIZEOF_VERTEX_PACKED, SIZEOF_VERTEX_PARTICLE };
 /* Whether mipmaps must be created for all dimensions down to 1x1 or not */
 static cc_bool customMipmapsLevels;
 /* Current format and size of vertices */
@@ -24,6 +24,16 @@ static int gfx_stride, gfx_format = -1;
 static cc_bool gfx_vsync, gfx_fogEnabled;
 static cc_bool gfx_rendering2D;
 
+struct GfxStats Gfx_Stats, Gfx_LastStats;
+#define GFX_STATS_DRAW(verts)      (Gfx_Stats.drawCalls++, Gfx_Stats.vertices += (verts))
+#define GFX_STATS_BIND()           (Gfx_Stats.textureBinds++)
+#define GFX_STATS_LOCK(fmt, count) (Gfx_Stats.vbLocks++, Gfx_Stats.bytesUploaded += (count) * strideSizes[fmt])
+
+void Gfx_ResetStats(void) {
+	Gfx_LastStats = Gfx_Stats;
+	Mem_Set(&Gfx_Stats, 0, sizeof(Gfx_Stats));
+}
+
 
 /*########################################################################################################################*
 *------------------------------------------------------State changes------------------------------------------------------*
@@ -37,6 +47,7 @@ void Gfx_SetAlphaTest(cc_bool enabled) {
 	if (gfx_alphaTest == enabled) return;
 	
 	gfx_alphaTest = enabled;
+	Gfx_Stats.stateChanges++;
 	SetAlphaTest(enabled);
 }
 
@@ -45,6 +56,7 @@ void Gfx_SetAlphaBlending(cc_bool enabled) {
 	if (gfx_alphaBlend == enabled) return;
 	
 	gfx_alphaBlend = enabled;
+	Gfx_Stats.stateChanges++;
 	SetAlphaBlend(enabled);
 }
 
@@ -59,6 +71,7 @@ void Gfx_SetColorWrite(cc_bool r, cc_bool g, cc_bool b, cc_bool a) {
 	gfx_colorMask[1] = g;
 	gfx_colorMask[2] = b;
 	gfx_colorMask[3] = a;
+	Gfx_Stats.stateChanges++;
 	SetColorWrite(r, g, b, a);
 }
 
@@ -425,6 +438,7 @@ GfxResourceID Gfx_CreateTexture(struct Bitmap* bmp, cc_uint8 flags, cc_bool mipm
 }
 
 GfxResourceID Gfx_CreateTexture2(struct Bitmap* bmp, int rowWidth, cc_uint8 flags, cc_bool mipmaps) {
+	GfxResourceID texId;
 	if (Gfx.SupportsNonPowTwoTextures && (flags & TEXTURE_FLAG_NONPOW2)) {
 		/* Texture is being deliberately created and can be successfully created */
 		/* with non power of two dimensions. Typically used for UI textures */
@@ -435,8 +449,34 @@ GfxResourceID Gfx_CreateTexture2(struct Bitmap* bmp, int rowWidth, cc_uint8 flag
 	if (Gfx.LostContext) return 0;
 	if (!Gfx_CheckTextureSize(bmp->width, bmp->height, flags)) return 0;
 
-	return Gfx_AllocTexture(bmp, rowWidth, flags, mipmaps);
+	texId = Gfx_AllocTexture(bmp, rowWidth, flags, mipmaps);
+	/* Mipmaps use roughly an extra third of the base level's memory */
+	Mem_Track(MEM_TRACK_TEXTURE, texId, bmp->width * bmp->height * 4 * (mipmaps ? 4 : 3) / 3, "textures");
+	return texId;
+}
+
+#if CC_GFX_BACKEND != CC_GFX_BACKEND_GL2
+GfxResourceID Gfx_CreateTextureArray(int width, int height, int layers, cc_uint8 flags, cc_bool mipmaps) {
+	return 0;
 }
+void Gfx_UpdateTextureArray(GfxResourceID texId, int x, int y, int layer, struct Bitmap* part, int rowWidth, cc_bool mipmaps) { }
+void Gfx_BindTextureArray(GfxResourceID texId, int layers) { Gfx_BindTexture(texId); }
+
+void Gfx_UpdateDynamicVbPart(GfxResourceID vb, VertexFormat fmt, int offset, int count, void* vertices) { }
+void Gfx_SetParticleTime(float time) { }
+#endif
+
+#if !CC_GFX_BACKEND_IS_GL() || defined CC_BUILD_GL11
+void Gfx_UpdateVbPart(GfxResourceID vb, VertexFormat fmt, int offset, int count, void* vertices) { }
+#endif
+
+#if CC_GFX_BACKEND != CC_GFX_BACKEND_GL2 && CC_GFX_BACKEND != CC_GFX_BACKEND_D3D11
+GfxResourceID Gfx_CreateQuery(void) { return 0; }
+void Gfx_DeleteQuery(GfxResourceID* query) { *query = 0; }
+void Gfx_BeginQuery(GfxResourceID query) { }
+void Gfx_EndQuery(GfxResourceID query)   { }
+cc_bool Gfx_GetQueryResult(GfxResourceID query, cc_bool* visible) { return false; }
+#endif
 
 void Texture_Render(const struct Texture* tex) {
 	Gfx_BindTexture(tex->ID);
@@ -452,6 +492,16 @@ void Texture_RenderShaded(const struct Texture* tex, PackedCol shadeColor) {
 /*########################################################################################################################*
 *------------------------------------------------------Vertex buffers-----------------------------------------------------*
 *#########################################################################################################################*/
+#if CC_GFX_BACKEND != CC_GFX_BACKEND_GL2
+void Gfx_DrawIndexedTris_T2fC4b_Ranges(const struct GfxDrawRange* ranges, int count) {
+	int i;
+	for (i = 0; i < count; i++) 
+	{
+		Gfx_DrawIndexedTris_T2fC4b(ranges[i].verticesCount, ranges[i].startVertex);
+	}
+}
+#endif
+
 void* Gfx_RecreateAndLockVb(GfxResourceID* vb, VertexFormat fmt, int count) {
 	Gfx_DeleteVb(vb);
 	*vb = Gfx_CreateVb(fmt, count);
@@ -467,7 +517,10 @@ GfxResourceID Gfx_CreateVb(VertexFormat fmt, int count) {
 
 	for (;;)
 	{
-		if ((vb = Gfx_AllocStaticVb(fmt, count))) return vb;
+		if ((vb = Gfx_AllocStaticVb(fmt, count))) {
+			Mem_Track(MEM_TRACK_VB, vb, count * strideSizes[fmt], "vertex buffers");
+			return vb;
+		}
 
 		if (!Game_ReduceVRAM()) Process_Abort("Out of video memory! (allocating static VB)");
 	}
@@ -479,7 +532,10 @@ GfxResourceID Gfx_CreateDynamicVb(VertexFormat fmt, int maxVertices) {
 
 	for (;;)
 	{
-		if ((vb = Gfx_AllocDynamicVb(fmt, maxVertices))) return vb;
+		if ((vb = Gfx_AllocDynamicVb(fmt, maxVertices))) {
+			Mem_Track(MEM_TRACK_VB, vb, maxVertices * strideSizes[fmt], "dynamic vertex buffers");
+			return vb;
+		}
 
 		if (!Game_ReduceVRAM()) Process_Abort("Out of video memory! (allocating dynamic VB)");
 	}
@@ -507,6 +563,7 @@ static void OnInit(void) {
 	Event_Register_(&GfxEvents.ContextRecreated, NULL, OnContextRecreated);
 
 	Gfx.Mipmaps = Options_GetBool(OPT_MIPMAPS, false);
+	Gfx.CompressTextures = Options_GetBool(OPT_COMPRESS_TEXTURES, false);
 	if (Gfx.LostContext) return;
 	OnContextRecreated(NULL);
 }
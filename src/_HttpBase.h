@@ -7,6 +7,7 @@
 #include "Game.h"
 #include "Utils.h"
 #include "Options.h"
+#include "Errors.h"
 
 static cc_bool httpsOnly, httpOnly, httpsVerify;
 static char skinServer_buffer[128];
@@ -15,10 +16,12 @@ static cc_string skinServer = String_FromArray(skinServer_buffer);
 void HttpRequest_Free(struct HttpRequest* request) {
 	Mem_Free(request->data);
 	Mem_Free(request->error);
+	Mem_Free(request->image.scan0);
 
 	request->data  = NULL;
 	request->size  = 0;
 	request->error = NULL;
+	request->image.scan0 = NULL;
 }
 #define HttpRequest_Copy(dst, src) Mem_Copy(dst, src, sizeof(struct HttpRequest))
 
@@ -110,6 +113,444 @@ static void RequestList_Free(struct RequestList* list) {
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------Http disk cache-----------------------------------------------------*
+*#########################################################################################################################*/
+#ifndef CC_BUILD_WEB
+#ifdef CC_BUILD_LOWMEM
+	#define HTTP_CACHE_MAX_ENTRIES 32
+#else
+	#define HTTP_CACHE_MAX_ENTRIES 256
+#endif
+#define HTTP_CACHE_MAX_SIZE  (4 * 1024 * 1024)
+#define HTTP_CACHE_MAX_ENTRY (HTTP_CACHE_MAX_SIZE / 16)
+#define HTTP_CACHE_INDEX "httpcache/index.txt"
+
+/* Each entry's data is stored in httpcache/[slot], where slot is the entry's index in this array */
+static struct HttpCacheEntry {
+	cc_uint32 urlHash, dataCrc, lastUsed;
+	cc_uint32 size; /* 0 if slot is unused */
+	char etag[STRING_SIZE];
+	char lastModified[STRING_SIZE];
+} httpCache[HTTP_CACHE_MAX_ENTRIES];
+static cc_uint32 httpCacheSize, httpCacheUsed;
+static cc_bool httpCacheDirty;
+static void* httpCacheMutex;
+
+static cc_uint32 HttpCache_HashUrl(struct HttpRequest* req) {
+	cc_string url = String_FromRawArray(req->url);
+	return Utils_CRC32((const cc_uint8*)url.buffer, url.length);
+}
+
+static void HttpCache_MakePath(cc_string* path, int slot) {
+	String_Format1(path, "httpcache/%i", &slot);
+}
+
+static int HttpCache_Find(cc_uint32 urlHash) {
+	int i;
+	for (i = 0; i < HTTP_CACHE_MAX_ENTRIES; i++)
+	{
+		if (httpCache[i].size && httpCache[i].urlHash == urlHash) return i;
+	}
+	return -1;
+}
+
+/* Removes the given entry, also emptying its data file unless it is about to be overwritten anyways */
+static void HttpCache_Remove(int slot, cc_bool truncate) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	httpCacheSize -= httpCache[slot].size;
+	httpCache[slot].size = 0;
+	httpCacheDirty = true;
+	if (!truncate) return;
+
+	String_InitArray(path, pathBuffer);
+	HttpCache_MakePath(&path, slot);
+	(void)Stream_WriteAllTo(&path, NULL, 0);
+}
+
+/* Returns the slot to store new data of the given size in, evicting least recently used entries if necessary */
+static int HttpCache_Allocate(cc_uint32 size) {
+	int i, slot, oldest;
+
+	for (;;) {
+		slot = -1; oldest = -1;
+		for (i = HTTP_CACHE_MAX_ENTRIES - 1; i >= 0; i--)
+		{
+			if (!httpCache[i].size) { slot = i; continue; }
+			if (oldest == -1 || httpCache[i].lastUsed < httpCache[oldest].lastUsed) oldest = i;
+		}
+
+		if (slot >= 0 && httpCacheSize + size <= HTTP_CACHE_MAX_SIZE) return slot;
+		/* Reuse the evicted entry's slot if no other slots are free */
+		HttpCache_Remove(oldest, slot >= 0);
+	}
+}
+
+static void HttpCache_Load(struct HttpRequest* req, cc_uint32 urlHash) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	struct HttpCacheEntry* e;
+	struct Stream stream;
+	cc_uint8* data;
+	cc_result res;
+	int slot = HttpCache_Find(urlHash);
+	if (slot == -1) return;
+
+	e = &httpCache[slot];
+	String_InitArray(path, pathBuffer);
+	HttpCache_MakePath(&path, slot);
+
+	data = (cc_uint8*)Mem_TryAlloc(e->size, 1);
+	if (!data) return;
+	res = Stream_OpenFile(&stream, &path);
+
+	if (!res) {
+		res = Stream_Read(&stream, data, e->size);
+		(void)stream.Close(&stream);
+	}
+	
+	/* Cached data may have been deleted or modified outside the game */
+	if (res || Utils_CRC32(data, e->size) != e->dataCrc) {
+		Platform_Log1("Discarding invalid cached data for %c", req->url);
+		Mem_Free(data);
+		HttpCache_Remove(slot, true);
+		return;
+	}
+
+	Mem_Free(req->data);
+	req->data       = data;
+	req->size       = e->size;
+	req->_capacity  = e->size;
+	req->statusCode = 200;
+
+	e->lastUsed    = ++httpCacheUsed;
+	httpCacheDirty = true;
+}
+
+static void HttpCache_Store(struct HttpRequest* req, cc_uint32 urlHash) {
+	cc_string url, path; char pathBuffer[FILENAME_SIZE];
+	struct HttpCacheEntry* e;
+	cc_result res;
+	int slot;
+
+	/* Can't revalidate a response later without either of these */
+	if (!req->etag[0] && !req->lastModified[0]) return;
+	if (req->size > HTTP_CACHE_MAX_ENTRY) return;
+
+	slot = HttpCache_Find(urlHash);
+	if (slot >= 0) HttpCache_Remove(slot, true);
+	slot = HttpCache_Allocate(req->size);
+
+	String_InitArray(path, pathBuffer);
+	HttpCache_MakePath(&path, slot);
+	res = Stream_WriteAllTo(&path, req->data, req->size);
+
+	if (res) {
+		url = String_FromRawArray(req->url);
+		Logger_SysWarn2(res, "caching", &url); return;
+	}
+
+	e = &httpCache[slot];
+	e->urlHash  = urlHash;
+	e->dataCrc  = Utils_CRC32(req->data, req->size);
+	e->lastUsed = ++httpCacheUsed;
+	e->size     = req->size;
+	Mem_Copy(e->etag,         req->etag,         sizeof(e->etag));
+	Mem_Copy(e->lastModified, req->lastModified, sizeof(e->lastModified));
+
+	httpCacheSize += req->size;
+	httpCacheDirty = true;
+}
+
+/* Sets the If-None-Match and If-Modified-Since values of a request from its cached response (if any) */
+static void HttpCache_Lookup(struct HttpRequest* req) {
+	struct HttpCacheEntry* e;
+	int slot;
+	if (!httpCacheMutex) return;
+	req->_diskCached = true;
+
+	Mutex_Lock(httpCacheMutex);
+	{
+		slot = HttpCache_Find(HttpCache_HashUrl(req));
+		if (slot >= 0) {
+			e = &httpCache[slot];
+			Mem_Copy(req->etag,         e->etag,         sizeof(e->etag));
+			Mem_Copy(req->lastModified, e->lastModified, sizeof(e->lastModified));
+		}
+	}
+	Mutex_Unlock(httpCacheMutex);
+}
+
+/* Replaces a 304 Not Modified response with the cached data, or caches a successful response */
+static void HttpCache_Finish(struct HttpRequest* req) {
+	cc_uint32 urlHash;
+	if (!req->_diskCached || req->result) return;
+	urlHash = HttpCache_HashUrl(req);
+
+	Mutex_Lock(httpCacheMutex);
+	{
+		if (req->statusCode == 304) {
+			HttpCache_Load(req, urlHash);
+		} else if (req->statusCode == 200 && req->data && req->size) {
+			HttpCache_Store(req, urlHash);
+		}
+	}
+	Mutex_Unlock(httpCacheMutex);
+}
+
+/* Parses an index line of the form [slot] [url hash] [data crc] [size] [last used] [etag] [last modified] */
+static void HttpCache_ParseEntry(const cc_string* line) {
+	struct HttpCacheEntry* e;
+	cc_string parts[7];
+	cc_uint64 urlHash, dataCrc, size, lastUsed;
+	int slot;
+
+	if (String_UNSAFE_Split(line, ' ', parts, 7) < 6) return;
+	if (!Convert_ParseInt(&parts[0], &slot) || slot < 0 || slot >= HTTP_CACHE_MAX_ENTRIES) return;
+
+	if (!Convert_ParseUInt64(&parts[1], &urlHash))  return;
+	if (!Convert_ParseUInt64(&parts[2], &dataCrc))  return;
+	if (!Convert_ParseUInt64(&parts[3], &size))     return;
+	if (!Convert_ParseUInt64(&parts[4], &lastUsed)) return;
+	if (!size || size > HTTP_CACHE_MAX_ENTRY || httpCache[slot].size) return;
+
+	e = &httpCache[slot];
+	e->urlHash  = (cc_uint32)urlHash;
+	e->dataCrc  = (cc_uint32)dataCrc;
+	e->size     = (cc_uint32)size;
+	e->lastUsed = (cc_uint32)lastUsed;
+	String_CopyToRawArray(e->etag,         &parts[5]);
+	String_CopyToRawArray(e->lastModified, &parts[6]);
+
+	httpCacheSize += e->size;
+	httpCacheUsed  = max(httpCacheUsed, e->lastUsed);
+}
+
+static void HttpCache_Init(void) {
+	struct StringsBuffer lines;
+	int i;
+	/* Http component gets initialised multiple times on Android */
+	if (httpCacheMutex || Platform_ReadonlyFilesystem) return;
+	if (!Utils_EnsureDirectory("httpcache")) return;
+
+	StringsBuffer_SetLengthBits(&lines, STRINGSBUFFER_DEF_LEN_SHIFT);
+	StringsBuffer_Init(&lines);
+	EntryList_UNSAFE_Load(&lines, HTTP_CACHE_INDEX);
+
+	for (i = 0; i < lines.count; i++)
+	{
+		cc_string line = StringsBuffer_UNSAFE_Get(&lines, i);
+		HttpCache_ParseEntry(&line);
+	}
+	StringsBuffer_Clear(&lines);
+
+	/* Evict entries if the size limit was reduced */
+	while (httpCacheSize > HTTP_CACHE_MAX_SIZE) HttpCache_Allocate(0);
+	httpCacheMutex = Mutex_Create("HTTP cache");
+}
+
+static void HttpCache_WriteIndex(void) {
+	static const cc_string path = String_FromConst(HTTP_CACHE_INDEX);
+	cc_string line; char lineBuffer[256];
+	cc_string etag, lastModified;
+	struct HttpCacheEntry* e;
+	struct Stream stream;
+	cc_result res;
+	int i;
+
+	res = Stream_CreateFile(&stream, &path);
+	if (res) { Logger_SysWarn2(res, "creating", &path); return; }
+
+	for (i = 0; i < HTTP_CACHE_MAX_ENTRIES; i++)
+	{
+		e = &httpCache[i];
+		if (!e->size) continue;
+		String_InitArray(line, lineBuffer);
+
+		etag         = String_FromRawArray(e->etag);
+		lastModified = String_FromRawArray(e->lastModified);
+		/* Index is space separated, so an ETag with spaces can't be stored */
+		if (String_IndexOf(&etag, ' ') >= 0) etag.length = 0;
+
+		String_AppendInt(&line,    i);            String_Append(&line, ' ');
+		String_AppendUInt32(&line, e->urlHash);   String_Append(&line, ' ');
+		String_AppendUInt32(&line, e->dataCrc);   String_Append(&line, ' ');
+		String_AppendUInt32(&line, e->size);      String_Append(&line, ' ');
+		String_AppendUInt32(&line, e->lastUsed);
+		String_Format2(&line, " %s %s", &etag, &lastModified);
+
+		res = Stream_WriteLine(&stream, &line);
+		if (res) { Logger_SysWarn2(res, "writing to", &path); break; }
+	}
+
+	res = stream.Close(&stream);
+	if (res) { Logger_SysWarn2(res, "closing", &path); }
+}
+
+/* Writes the index of cached responses to disk, if it has changed */
+static void HttpCache_Save(void) {
+	if (!httpCacheMutex) return;
+
+	Mutex_Lock(httpCacheMutex);
+	{
+		if (httpCacheDirty) HttpCache_WriteIndex();
+		httpCacheDirty = false;
+	}
+	Mutex_Unlock(httpCacheMutex);
+}
+#else
+/* Browser already caches responses */
+#define HttpCache_Init()
+#define HttpCache_Save()
+#define HttpCache_Lookup(req)
+#define HttpCache_Finish(req)
+#endif
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Resumable downloads----------------------------------------------------*
+*#########################################################################################################################*/
+#ifndef CC_BUILD_WEB
+/* Partially downloaded data is stored in httpcache/partial_[url hash], and the */
+/*  ETag or Last-Modified value it must match for resuming in httpcache/partial_[url hash].txt */
+static void HttpResume_MakePath(cc_string* path, struct HttpRequest* req, const char* ext) {
+	cc_uint32 urlHash = HttpCache_HashUrl(req);
+	String_Format2(path, "httpcache/partial_%h%c", &urlHash, ext);
+}
+
+static void HttpResume_Discard(struct HttpRequest* req) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+
+	String_InitArray(path, pathBuffer);
+	HttpResume_MakePath(&path, req, "");
+	(void)Stream_WriteAllTo(&path, NULL, 0);
+
+	path.length = 0;
+	HttpResume_MakePath(&path, req, ".txt");
+	(void)Stream_WriteAllTo(&path, NULL, 0);
+}
+
+/* Sets up a request to resume from the partially downloaded data from an earlier request (if any) */
+static void HttpResume_Lookup(struct HttpRequest* req) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string tag;  char tagBuffer[STRING_SIZE];
+	struct Stream stream;
+	cc_uint32 length = 0;
+	cc_result res;
+	/* Data taken by Http_TakePartial can't be saved */
+	if (Platform_ReadonlyFilesystem || req->_streaming) return;
+	req->_resumable = true;
+
+	String_InitArray(path, pathBuffer);
+	String_InitArray(tag,  tagBuffer);
+	HttpResume_MakePath(&path, req, ".txt");
+
+	if (Stream_OpenFile(&stream, &path)) return;
+	res = Stream_ReadLine(&stream, &tag);
+	(void)stream.Close(&stream);
+	if (res || !tag.length) return;
+
+	path.length = 0;
+	HttpResume_MakePath(&path, req, "");
+	if (Stream_OpenFile(&stream, &path)) return;
+	res = stream.Length(&stream, &length);
+	(void)stream.Close(&stream);
+	if (res || !length) return;
+
+	Platform_Log2("Resuming %c from %i bytes", req->url, &length);
+	String_CopyToRawArray(req->_resumeTag, &tag);
+	req->_resumeFrom = length;
+}
+
+/* Saves the data received by a failed request, so that a later request can resume from it */
+static void HttpResume_Save(struct HttpRequest* req) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string tag;
+	struct Stream stream;
+	cc_result res;
+
+	tag = String_FromRawArray(req->etag);
+	if (!tag.length) tag = String_FromRawArray(req->lastModified);
+	/* Can't safely resume without being able to check the server's data hasn't changed */
+	if (!tag.length || !Utils_EnsureDirectory("httpcache")) return;
+
+	String_InitArray(path, pathBuffer);
+	HttpResume_MakePath(&path, req, "");
+
+	if (req->statusCode == 206) {
+		if (req->_rangeStart != req->_resumeFrom) { HttpResume_Discard(req); return; }
+		res = Stream_AppendFile(&stream, &path);
+	} else {
+		res = Stream_CreateFile(&stream, &path);
+	}
+	if (res) { HttpResume_Discard(req); return; }
+
+	res = Stream_Write(&stream, req->data, req->size);
+	if (res) { (void)stream.Close(&stream); HttpResume_Discard(req); return; }
+	if ((res = stream.Close(&stream))) { HttpResume_Discard(req); return; }
+
+	path.length = 0;
+	HttpResume_MakePath(&path, req, ".txt");
+	res = Stream_WriteAllTo(&path, (const cc_uint8*)tag.buffer, tag.length);
+	if (res) HttpResume_Discard(req);
+}
+
+/* Combines the partially downloaded data with the rest of it from the server */
+static cc_result HttpResume_Merge(struct HttpRequest* req) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	struct Stream stream;
+	cc_uint32 total = req->_resumeFrom + req->size;
+	cc_uint8* data;
+	cc_result res;
+	if (req->_rangeStart != req->_resumeFrom) return HTTP_ERR_INVALID_RANGE;
+
+	data = (cc_uint8*)Mem_TryAlloc(total, 1);
+	if (!data) return ERR_OUT_OF_MEMORY;
+
+	String_InitArray(path, pathBuffer);
+	HttpResume_MakePath(&path, req, "");
+	res = Stream_OpenFile(&stream, &path);
+
+	if (!res) {
+		res = Stream_Read(&stream, data, req->_resumeFrom);
+		(void)stream.Close(&stream);
+	}
+	if (res) { Mem_Free(data); return res; }
+
+	Mem_Copy(data + req->_resumeFrom, req->data, req->size);
+	Mem_Free(req->data);
+	req->data       = data;
+	req->size       = total;
+	req->_capacity  = total;
+	req->statusCode = 200;
+	return 0;
+}
+
+/* Saves or completes partially downloaded data, depending on whether the request succeeded */
+static void HttpResume_Finish(struct HttpRequest* req) {
+	int status = req->statusCode;
+	if (!req->_resumable) return;
+
+	if (req->result) {
+		/* Error pages and such shouldn't be mistaken for the data */
+		if ((status == 200 || status == 206) && req->data && req->size) HttpResume_Save(req);
+		return;
+	}
+
+	if (status == 206 && req->_resumeFrom) {
+		req->result = HttpResume_Merge(req);
+		HttpResume_Discard(req);
+	} else if (status == 200 || status == 416) {
+		/* Server sends the full data instead if it changed since the partial download */
+		if (req->_resumeFrom) HttpResume_Discard(req);
+	}
+}
+#else
+/* Browser doesn't allow resuming downloads */
+#define HttpResume_Lookup(req)
+#define HttpResume_Finish(req)
+#endif
+
+
 /*########################################################################################################################*
 *--------------------------------------------------Common downloader code-------------------------------------------------*
 *#########################################################################################################################*/
@@ -154,8 +595,12 @@ static int Http_Add(const cc_string* url, cc_uint8 flags, cc_uint8 type, const c
 		Mem_Copy(req.data, data, size);
 		req.size = size;
 	}
-	req.cookies  = cookies;
-	req.progress = HTTP_PROGRESS_NOT_WORKING_ON;
+	req.cookies    = cookies;
+	req.progress   = HTTP_PROGRESS_NOT_WORKING_ON;
+	req._streaming = (flags & HTTP_FLAG_STREAMING) != 0;
+	req._decodePng = (flags & HTTP_FLAG_DECODEPNG) != 0;
+	if (flags & HTTP_FLAG_DISKCACHE) HttpCache_Lookup(&req);
+	if (flags & HTTP_FLAG_RESUMABLE) HttpResume_Lookup(&req);
 
 	HttpBackend_Add(&req, flags);
 	return req.id;
@@ -184,9 +629,26 @@ static void Http_GetUrl(struct HttpRequest* req, cc_string* dst) {
 }
 
 
+/* Decodes the contents of a successful request into an image, if requested */
+static void Http_DecodeImage(struct HttpRequest* req) {
+	struct Stream mem;
+	if (!req->_decodePng) return;
+	req->_decodePng = false;
+	if (!req->success) return;
+
+	Stream_ReadonlyMemory(&mem, req->data, req->size);
+	req->imageResult = Png_Decode(&req->image, &mem);
+	if (!req->imageResult) return;
+
+	Mem_Free(req->image.scan0);
+	req->image.scan0 = NULL;
+}
+
 /* Updates state after a completed http request */
 static void Http_FinishRequest(struct HttpRequest* req) {
-	req->success = !req->result && req->statusCode == 200 && req->data && req->size;
+	HttpResume_Finish(req);
+	HttpCache_Finish(req);
+	req->success = !req->result && req->statusCode == 200 && ((req->data && req->size) || req->_streamed);
 
 	if (!req->success) {
 		char* error = req->error; req->error = NULL;
@@ -194,6 +656,10 @@ static void Http_FinishRequest(struct HttpRequest* req) {
 		req->error = error;
 		/* TODO don't HttpRequest_Free here? */
 	}
+	/* Png_Decode uses static state when stack space is limited, so must only be called from the main thread */
+#ifndef CC_BUILD_TINYSTACK
+	Http_DecodeImage(req);
+#endif
 
 	Mutex_Lock(processedMutex);
 	{
@@ -222,6 +688,7 @@ static void Http_CleanCacheTask(struct ScheduledTask* task) {
 		}
 	}
 	Mutex_Unlock(processedMutex);
+	HttpCache_Save();
 }
 
 
@@ -237,6 +704,8 @@ int Http_AsyncGetSkin(const cc_string* skinName, cc_uint8 flags) {
 	} else {
 		String_Format2(&url, "%s/%s.png", &skinServer, skinName);
 	}
+
+	if (!(flags & HTTP_FLAG_NOCACHE)) flags |= HTTP_FLAG_DISKCACHE;
 	return Http_AsyncGetData(&url, flags);
 }
 
@@ -310,11 +779,17 @@ static void Http_InitCommon(void) {
 
 	Options_Get(OPT_SKIN_SERVER, &skinServer, SKINS_SERVER);
 	ScheduledTask_Add(30, Http_CleanCacheTask);
+	HttpCache_Init();
 }
 static void Http_Init(void);
 
+static void Http_Free(void) {
+	Http_ClearPending();
+	HttpCache_Save();
+}
+
 struct IGameComponent Http_Component = {
 	Http_Init,        /* Init  */
-	Http_ClearPending,/* Free  */
+	Http_Free,        /* Free  */
 	Http_ClearPending /* Reset */
 };
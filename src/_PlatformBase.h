@@ -3,6 +3,7 @@
 #include "Logger.h"
 #include "Constants.h"
 #include "Errors.h"
+#include "Stream.h"
 
 /*########################################################################################################################*
 *---------------------------------------------------------Memory----------------------------------------------------------*
@@ -29,18 +30,25 @@ CC_NOINLINE static void AbortOnAllocFailed(const char* place) {
 void* Mem_Alloc(cc_uint32 numElems, cc_uint32 elemsSize, const char* place) {
 	void* ptr = Mem_TryAlloc(numElems, elemsSize);
 	if (!ptr) AbortOnAllocFailed(place);
+
+	Mem_Track(MEM_TRACK_HEAP, ptr, numElems * elemsSize, place);
 	return ptr;
 }
 
 void* Mem_AllocCleared(cc_uint32 numElems, cc_uint32 elemsSize, const char* place) {
 	void* ptr = Mem_TryAllocCleared(numElems, elemsSize);
 	if (!ptr) AbortOnAllocFailed(place);
+
+	Mem_Track(MEM_TRACK_HEAP, ptr, numElems * elemsSize, place);
 	return ptr;
 }
 
 void* Mem_Realloc(void* mem, cc_uint32 numElems, cc_uint32 elemsSize, const char* place) {
 	void* ptr = Mem_TryRealloc(mem, numElems, elemsSize);
 	if (!ptr) AbortOnAllocFailed(place);
+
+	Mem_Untrack(MEM_TRACK_HEAP, mem);
+	Mem_Track(MEM_TRACK_HEAP,   ptr, numElems * elemsSize, place);
 	return ptr;
 }
 
@@ -54,6 +62,146 @@ static CC_NOINLINE cc_uint32 CalcMemSize(cc_uint32 numElems, cc_uint32 elemsSize
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------Memory tracking-----------------------------------------------------*
+*#########################################################################################################################*/
+#ifdef CC_BUILD_TRACKMEM
+#define MEM_TRACK_BITS 15
+#define MEM_TRACK_SLOTS (1 << MEM_TRACK_BITS)
+#define MEM_TRACK_MAX_TAGS 128
+
+struct MemTrackEntry { const void* key; cc_uint32 size; cc_uint8 type, tag; };
+/* Open addressing hash table of tracked allocations, using linear probing */
+static struct MemTrackEntry mem_entries[MEM_TRACK_SLOTS];
+static struct MemTrackedTag mem_tags[MEM_TRACK_MAX_TAGS];
+static int mem_tagsCount, mem_entriesUsed;
+
+static void* mem_trackMutex;
+static cc_bool mem_trackCreating;
+
+/* NOTE: Creating the mutex might itself call Mem_Alloc, so that allocation is never tracked */
+/* (First allocation always happens on the main thread before any other threads are started) */
+static cc_bool MemTrack_Lock(cc_bool create) {
+	if (!mem_trackMutex) {
+		if (!create || mem_trackCreating) return false;
+
+		mem_trackCreating = true;
+		mem_trackMutex    = Mutex_Create("Memory tracker");
+		mem_trackCreating = false;
+	}
+	Mutex_Lock(mem_trackMutex);
+	return true;
+}
+
+static cc_uint32 MemTrack_Hash(int type, const void* key) {
+	/* Resource IDs for some graphics backends are just small integers, so mix in all the bits */
+	cc_uint32 addr = (cc_uint32)(cc_uintptr)key + type * 0x10000;
+	return (addr * 2654435761U) >> (32 - MEM_TRACK_BITS);
+}
+
+static int MemTrack_FindTag(int type, const char* name) {
+	struct MemTrackedTag* tag;
+	int i, len = String_Length(name);
+
+	for (i = 0; i < mem_tagsCount; i++) 
+	{
+		tag = &mem_tags[i];
+		if (tag->type != type) continue;
+		if (tag->name == name || (String_Length(tag->name) == len && Mem_Equal(tag->name, name, len))) return i;
+	}
+
+	/* Last tag is used to gather allocations once there are too many different tags */
+	if (mem_tagsCount == MEM_TRACK_MAX_TAGS) return MEM_TRACK_MAX_TAGS - 1;
+	tag = &mem_tags[mem_tagsCount];
+	tag->name = mem_tagsCount == MEM_TRACK_MAX_TAGS - 1 ? "(other)" : name;
+	tag->type = type;
+	return mem_tagsCount++;
+}
+
+static void MemTrack_RemoveAt(int i) {
+	struct MemTrackEntry* e = &mem_entries[i];
+	struct MemTrackedTag* tag = &mem_tags[e->tag];
+	int j, home;
+
+	tag->cur -= e->size;
+	tag->count--;
+	e->key    = NULL;
+	mem_entriesUsed--;
+
+	/* Shift later entries in the probe sequence back, so lookups never stop early at the gap */
+	for (j = (i + 1) & (MEM_TRACK_SLOTS - 1); mem_entries[j].key; j = (j + 1) & (MEM_TRACK_SLOTS - 1))
+	{
+		home = MemTrack_Hash(mem_entries[j].type, mem_entries[j].key);
+		/* Entry can only move into the gap if the gap lies between its home slot and its current slot */
+		if (((j - home) & (MEM_TRACK_SLOTS - 1)) < ((j - i) & (MEM_TRACK_SLOTS - 1))) continue;
+
+		mem_entries[i] = mem_entries[j];
+		mem_entries[j].key = NULL;
+		i = j;
+	}
+}
+
+static int MemTrack_Find(int type, const void* key) {
+	int i = MemTrack_Hash(type, key);
+
+	for (; mem_entries[i].key; i = (i + 1) & (MEM_TRACK_SLOTS - 1))
+	{
+		if (mem_entries[i].key == key && mem_entries[i].type == type) return i;
+	}
+	return -i - 1;
+}
+
+void Mem_Track(int type, const void* key, cc_uint32 size, const char* name) {
+	static cc_bool warnedFull;
+	struct MemTrackedTag* tag;
+	int i;
+	if (!key || !MemTrack_Lock(true)) return;
+
+	i = MemTrack_Find(type, key);
+	if (i >= 0) MemTrack_RemoveAt(i);
+	i = MemTrack_Find(type, key);
+	i = -i - 1;
+
+	/* Keep some free slots, as linear probing gets very slow when the table is almost full */
+	if (mem_entriesUsed >= MEM_TRACK_SLOTS - MEM_TRACK_SLOTS / 8) {
+		if (!warnedFull) Platform_LogConst("Too many allocations to track, ignoring new allocations");
+		warnedFull = true;
+	} else {
+		mem_entries[i].key  = key;
+		mem_entries[i].size = size;
+		mem_entries[i].type = type;
+		mem_entries[i].tag  = MemTrack_FindTag(type, name);
+		mem_entriesUsed++;
+
+		tag = &mem_tags[mem_entries[i].tag];
+		tag->cur += size;
+		tag->count++;
+		if (tag->cur > tag->peak) tag->peak = tag->cur;
+	}
+	Mutex_Unlock(mem_trackMutex);
+}
+
+void Mem_Untrack(int type, const void* key) {
+	int i;
+	if (!key || !MemTrack_Lock(false)) return;
+
+	i = MemTrack_Find(type, key);
+	if (i >= 0) MemTrack_RemoveAt(i);
+	Mutex_Unlock(mem_trackMutex);
+}
+
+int Mem_GetTrackedTags(struct MemTrackedTag* tags, int maxTags) {
+	int count;
+	if (!MemTrack_Lock(false)) return 0;
+
+	count = maxTags < mem_tagsCount ? maxTags : mem_tagsCount;
+	Mem_Copy(tags, mem_tags, count * sizeof(struct MemTrackedTag));
+	Mutex_Unlock(mem_trackMutex);
+	return count;
+}
+#endif
+
+
 /*########################################################################################################################*
 *--------------------------------------------------------Logging----------------------------------------------------------*
 *#########################################################################################################################*/
@@ -67,16 +215,110 @@ void Platform_Log3(const char* format, const void* a1, const void* a2, const voi
 	Platform_Log4(format, a1, a2, a3, NULL);
 }
 
+cc_uint8 Platform_LogLevels[LOG_CATEGORY_COUNT] = { LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO };
+
+#ifdef CC_BUILD_LOGRING
+/* Writing to the platform log is slow on some systems (e.g. Android's logcat), so instead */
+/*  messages are copied into a ring buffer, and then written out by a background thread */
+/* Each message is stored as a 2 byte length, followed by the characters of the message */
+#define LOGRING_SIZE 16384
+#define LOGRING_MASK (LOGRING_SIZE - 1)
+#define LOGRING_MAX_MESSAGE 512
+
+static char logRing[LOGRING_SIZE];
+/* NOTE: These only ever increase, the offset in the ring is calculated with LOGRING_MASK */
+static cc_uint32 logRead, logWrite;
+static int logDropped;
+static void* logMutex;
+static void* logWakeup;
+
+static void LogRing_Copy(char* dst, cc_uint32 src, int len) {
+	int i;
+	for (i = 0; i < len; i++) dst[i] = logRing[(src + i) & LOGRING_MASK];
+}
+
+static void LogRing_Drain(void) {
+	char buffer[LOGRING_MAX_MESSAGE];
+	cc_uint8 header[2];
+	int len, dropped;
+	cc_bool empty;
+	cc_string msg; char msgBuffer[64];
+
+	for (;;)
+	{
+		Mutex_Lock(logMutex);
+		{
+			dropped    = logDropped;
+			logDropped = 0;
+			empty      = logRead == logWrite;
+
+			if (!empty) {
+				LogRing_Copy((char*)header, logRead, 2);
+				len = header[0] | (header[1] << 8);
+				LogRing_Copy(buffer, logRead + 2, len);
+				logRead += 2 + len;
+			}
+		}
+		Mutex_Unlock(logMutex);
+
+		/* NOTE: Written directly, since the ring buffer is probably still nearly full */
+		if (dropped) {
+			String_InitArray(msg, msgBuffer);
+			String_Format1(&msg, "(%i log messages were dropped)", &dropped);
+			Platform_Log(msg.buffer, msg.length);
+		}
+		if (empty) { Waitable_Wait(logWakeup); continue; }
+		Platform_Log(buffer, len);
+	}
+}
+
+static void LogRing_Write(const char* msg, int len) {
+	cc_uint32 offset;
+	int i;
+	if (!logMutex) { Platform_Log(msg, len); return; }
+	if (len > LOGRING_MAX_MESSAGE) len = LOGRING_MAX_MESSAGE;
+
+	Mutex_Lock(logMutex);
+	{
+		if (LOGRING_SIZE - (logWrite - logRead) < (cc_uint32)(len + 2)) {
+			logDropped++;
+		} else {
+			offset = logWrite;
+			logRing[offset++ & LOGRING_MASK] = (char)len;
+			logRing[offset++ & LOGRING_MASK] = (char)(len >> 8);
+
+			for (i = 0; i < len; i++) logRing[offset++ & LOGRING_MASK] = msg[i];
+			logWrite = offset;
+		}
+	}
+	Mutex_Unlock(logMutex);
+	Waitable_Signal(logWakeup);
+}
+
+void Platform_StartLogThread(void) {
+	void* thread;
+	if (logMutex) return;
+
+	logWakeup = Waitable_Create("Log wakeup");
+	logMutex  = Mutex_Create("Log ring");
+	Thread_Run(&thread, LogRing_Drain, 64 * 1024, "Log writer");
+	Thread_Detach(thread);
+}
+#else
+#define LogRing_Write Platform_Log
+void Platform_StartLogThread(void) { }
+#endif
+
 void Platform_Log4(const char* format, const void* a1, const void* a2, const void* a3, const void* a4) {
 	cc_string msg; char msgBuffer[512];
 	String_InitArray(msg, msgBuffer);
 
 	String_Format4(&msg, format, a1, a2, a3, a4);
-	Platform_Log(msg.buffer, msg.length);
+	LogRing_Write(msg.buffer, msg.length);
 }
 
 void Platform_LogConst(const char* message) {
-	Platform_Log(message, String_Length(message));
+	LogRing_Write(message, String_Length(message));
 }
 
 /*########################################################################################################################*
@@ -143,6 +385,122 @@ cc_result Socket_WriteAll(cc_socket socket, const cc_uint8* data, cc_uint32 coun
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------Address cache-------------------------------------------------------*
+*#########################################################################################################################*/
+#ifdef CC_BUILD_NETWORKING
+/* getaddrinfo and the console DNS APIs don't expose record TTLs, so entries instead expire after a short fixed time */
+#define ADDR_CACHE_SLOTS 4
+#define ADDR_CACHE_LIFETIME_MS (60 * 1000)
+
+struct AddrCacheEntry {
+	cc_uint64 resolved; /* Stopwatch time the address was resolved at (0 if slot is unused) */
+	int port, numAddrs;
+	cc_sockaddr addrs[SOCKET_MAX_ADDRS];
+	cc_string host; char _hostBuffer[STRING_SIZE];
+};
+static struct AddrCacheEntry addr_entries[ADDR_CACHE_SLOTS];
+static void* addr_mutex;
+
+static void AddrCache_Lock(void) {
+	if (!addr_mutex) addr_mutex = Mutex_Create("Address cache");
+	Mutex_Lock(addr_mutex);
+}
+
+static struct AddrCacheEntry* AddrCache_Find(const cc_string* host, int port, cc_uint64 now) {
+	struct AddrCacheEntry* e;
+	int i;
+
+	for (i = 0; i < ADDR_CACHE_SLOTS; i++)
+	{
+		e = &addr_entries[i];
+		if (!e->resolved || e->port != port || !String_Equals(&e->host, host)) continue;
+
+		if (Stopwatch_ElapsedMS(e->resolved, now) < ADDR_CACHE_LIFETIME_MS) return e;
+		e->resolved = 0; return NULL;
+	}
+	return NULL;
+}
+
+static void AddrCache_Add(const cc_string* host, int port, cc_sockaddr* addrs, int numAddrs, cc_uint64 now) {
+	struct AddrCacheEntry* e = &addr_entries[0];
+	int i;
+	if (host->length > STRING_SIZE) return;
+
+	/* Replace either an unused slot or the oldest entry */
+	for (i = 1; i < ADDR_CACHE_SLOTS && e->resolved; i++)
+	{
+		if (addr_entries[i].resolved < e->resolved) e = &addr_entries[i];
+	}
+
+	e->resolved = now;
+	e->port     = port;
+	e->numAddrs = numAddrs;
+	Mem_Copy(e->addrs, addrs, numAddrs * sizeof(cc_sockaddr));
+
+	String_InitArray(e->host, e->_hostBuffer);
+	String_Copy(&e->host, host);
+}
+
+cc_result Socket_ResolveAddress(const cc_string* address, int port, cc_sockaddr* addrs, int* numValidAddrs) {
+	struct AddrCacheEntry* e;
+	cc_uint64 now = Stopwatch_Measure();
+	cc_result res;
+
+	AddrCache_Lock();
+	e = AddrCache_Find(address, port, now);
+	if (e) {
+		Mem_Copy(addrs, e->addrs, e->numAddrs * sizeof(cc_sockaddr));
+		*numValidAddrs = e->numAddrs;
+	}
+	Mutex_Unlock(addr_mutex);
+	if (e) return 0;
+
+	/* NOTE: Lock isn't held while resolving, since a DNS lookup can block for a long time */
+	res = Socket_ParseAddress(address, port, addrs, numValidAddrs);
+	if (res || !(*numValidAddrs)) return res;
+
+	AddrCache_Lock();
+	/* Another thread might have resolved the same address in the meantime */
+	if (!AddrCache_Find(address, port, now)) AddrCache_Add(address, port, addrs, *numValidAddrs, now);
+	Mutex_Unlock(addr_mutex);
+	return 0;
+}
+
+void Socket_ReportAddress(const cc_string* address, int port, const cc_sockaddr* addr, cc_bool success) {
+	struct AddrCacheEntry* e;
+	cc_sockaddr tmp;
+	int i, j;
+
+	AddrCache_Lock();
+	e = AddrCache_Find(address, port, Stopwatch_Measure());
+
+	for (i = 0; e && i < e->numAddrs; i++)
+	{
+		if (e->addrs[i].size != addr->size || !Mem_Equal(e->addrs[i].data, addr->data, addr->size)) continue;
+		tmp = e->addrs[i];
+
+		/* Working address moves to the front, and failing addresses are moved to the back */
+		if (success) {
+			for (j = i; j > 0; j--) e->addrs[j] = e->addrs[j - 1];
+			e->addrs[0] = tmp;
+		} else {
+			for (j = i; j < e->numAddrs - 1; j++) e->addrs[j] = e->addrs[j + 1];
+			e->addrs[e->numAddrs - 1] = tmp;
+		}
+		break;
+	}
+	Mutex_Unlock(addr_mutex);
+}
+#else
+cc_result Socket_ResolveAddress(const cc_string* address, int port, cc_sockaddr* addrs, int* numValidAddrs) {
+	return Socket_ParseAddress(address, port, addrs, numValidAddrs);
+}
+
+void Socket_ReportAddress(const cc_string* address, int port, const cc_sockaddr* addr, cc_bool success) { }
+#endif
+
+
 /*########################################################################################################################*
 *-------------------------------------------------------Dynamic lib-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -172,3 +530,192 @@ cc_bool DynamicLib_LoadAll(const cc_string* path, const struct DynamicLibSym* sy
 	}
 	return loaded == count;
 }
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Asynchronous file I/O--------------------------------------------------*
+*#########################################################################################################################*/
+#if !defined CC_BUILD_COOPTHREADED && (!defined CC_BUILD_WEB || defined CC_BUILD_WEBTHREADS)
+#define FILE_ASYNC_THREADED
+#endif
+
+struct AsyncFileWrite {
+	struct AsyncFileWrite* next;
+	File_AsyncWriter writer;
+	File_AsyncCallback callback;
+	void* obj;
+	cc_uint8* data;
+	cc_uint32 length;
+	cc_result result;
+	cc_string path; char _pathBuffer[FILENAME_SIZE];
+};
+static struct AsyncFileWrite* asyncDone_head;
+static struct AsyncFileWrite* asyncDone_tail;
+
+static cc_result AsyncFile_Perform(struct AsyncFileWrite* w) {
+	cc_filepath str;
+	cc_uint32 wrote, offset = 0;
+	cc_result res, closeRes;
+	struct Stream stream;
+	cc_file file;
+
+	Platform_EncodePath(&str, &w->path);
+	res = File_Create(&file, &str);
+	if (res) return res;
+
+	if (w->writer) {
+		Stream_FromFile(&stream, file);
+		res      = w->writer(&stream, w->obj);
+		closeRes = stream.Close(&stream);
+		return res ? res : closeRes;
+	}
+
+	while (offset < w->length) {
+		if ((res = File_Write(file, w->data + offset, w->length - offset, &wrote))) break;
+		if (!wrote) { res = ERR_END_OF_STREAM; break; }
+		offset += wrote;
+	}
+
+	closeRes = File_Close(file);
+	return res ? res : closeRes;
+}
+
+static void AsyncFile_Complete(struct AsyncFileWrite* w) {
+	Mem_Free(w->data);
+	w->data = NULL;
+	w->next = NULL;
+
+	if (asyncDone_tail) {
+		asyncDone_tail->next = w;
+	} else {
+		asyncDone_head = w;
+	}
+	asyncDone_tail = w;
+}
+
+#ifdef FILE_ASYNC_THREADED
+static struct AsyncFileWrite* asyncPending_head;
+static struct AsyncFileWrite* asyncPending_tail;
+static void* asyncMutex;
+static void* asyncWaitable;
+static void* asyncThread;
+static volatile int asyncBusy; /* Number of writes queued or in progress */
+
+static void AsyncFile_WorkerFunc(void) {
+	struct AsyncFileWrite* w;
+	for (;;) 
+	{
+		Mutex_Lock(asyncMutex);
+		w = asyncPending_head;
+		if (w) {
+			asyncPending_head = w->next;
+			if (!asyncPending_head) asyncPending_tail = NULL;
+		}
+		Mutex_Unlock(asyncMutex);
+
+		if (!w) { Waitable_Wait(asyncWaitable); continue; }
+		w->result = AsyncFile_Perform(w);
+
+		Mutex_Lock(asyncMutex);
+		AsyncFile_Complete(w);
+		asyncBusy--;
+		Mutex_Unlock(asyncMutex);
+	}
+}
+
+static void AsyncFile_Queue(struct AsyncFileWrite* w) {
+	if (!asyncThread) {
+		asyncMutex    = Mutex_Create("Async file mutex");
+		asyncWaitable = Waitable_Create("Async file waitable");
+		/* Larger stack size, since writers may need to compress data (e.g. PNG encoding) */
+		Thread_Run(&asyncThread, AsyncFile_WorkerFunc, 256 * 1024, "Async file I/O");
+		Thread_Detach(asyncThread);
+	}
+
+	Mutex_Lock(asyncMutex);
+	w->next = NULL;
+	if (asyncPending_tail) {
+		asyncPending_tail->next = w;
+	} else {
+		asyncPending_head = w;
+	}
+	asyncPending_tail = w;
+	asyncBusy++;
+	Mutex_Unlock(asyncMutex);
+
+	Waitable_Signal(asyncWaitable);
+}
+
+void File_FlushAsync(void) {
+	if (!asyncThread) return;
+	while (asyncBusy) Thread_Sleep(1);
+}
+
+static struct AsyncFileWrite* AsyncFile_TakeCompleted(void) {
+	struct AsyncFileWrite* w;
+	if (!asyncThread) return NULL;
+
+	Mutex_Lock(asyncMutex);
+	w = asyncDone_head;
+	asyncDone_head = NULL;
+	asyncDone_tail = NULL;
+	Mutex_Unlock(asyncMutex);
+	return w;
+}
+#else
+static void AsyncFile_Queue(struct AsyncFileWrite* w) {
+	w->result = AsyncFile_Perform(w);
+	AsyncFile_Complete(w);
+}
+
+void File_FlushAsync(void) { }
+
+static struct AsyncFileWrite* AsyncFile_TakeCompleted(void) {
+	struct AsyncFileWrite* w = asyncDone_head;
+	asyncDone_head = NULL;
+	asyncDone_tail = NULL;
+	return w;
+}
+#endif
+
+static void AsyncFile_Start(const cc_string* path, File_AsyncWriter writer, void* data, cc_uint32 length, 
+							File_AsyncCallback callback, void* obj) {
+	struct AsyncFileWrite* w = (struct AsyncFileWrite*)Mem_TryAlloc(1, sizeof(struct AsyncFileWrite));
+	struct AsyncFileWrite tmp;
+	cc_result res;
+	if (!w) w = &tmp; /* Fallback to writing synchronously if out of memory */
+
+	String_InitArray(w->path, w->_pathBuffer);
+	String_Copy(&w->path, path);
+	w->writer   = writer;
+	w->data     = (cc_uint8*)data;
+	w->length   = length;
+	w->callback = callback;
+	w->obj      = obj;
+	w->result   = 0;
+	if (w != &tmp) { AsyncFile_Queue(w); return; }
+
+	res = AsyncFile_Perform(w);
+	Mem_Free(data);
+	if (callback) callback(path, res, obj);
+}
+
+void File_WriteAllAsync(const cc_string* path, void* data, cc_uint32 length, File_AsyncCallback callback, void* obj) {
+	AsyncFile_Start(path, NULL, data, length, callback, obj);
+}
+
+void File_WriteAsync(const cc_string* path, File_AsyncWriter writer, File_AsyncCallback callback, void* obj) {
+	AsyncFile_Start(path, writer, NULL, 0, callback, obj);
+}
+
+void File_ProcessAsync(void) {
+	struct AsyncFileWrite* w;
+	struct AsyncFileWrite* next;
+
+	for (w = AsyncFile_TakeCompleted(); w; w = next) 
+	{
+		next = w->next;
+		if (w->callback) w->callback(&w->path, w->result, w->obj);
+		Mem_Free(w);
+	}
+}
@@ -65,6 +65,20 @@ mergeInto(LibraryManager.library, {
     var onFinished = Module["_Http_OnFinishedAsync"];
     var onProgress = Module["_Http_OnUpdateProgress"];
 
+    // Prefer streaming the response body, so it never needs to be entirely stored in a JS ArrayBuffer
+    if (window.fetch && window.Request && window.ReadableStream) {
+      var req;
+      try {
+        req = new Request(url, { method: reqMethod });
+      } catch (e) {
+        // TypeError gets thrown when invalid URL provided
+        console.log(e);
+        return 1;
+      }
+      _interop_FetchAsync(req, reqID);
+      return 0;
+    }
+
     var xhr = new XMLHttpRequest();
     try {
       xhr.open(reqMethod, url);
@@ -86,6 +100,18 @@ mergeInto(LibraryManager.library, {
       } catch (ex) { return 0; }
     };
     
+    xhr.onreadystatechange = function() {
+      if (xhr.readyState != 2) return; // HEADERS_RECEIVED
+      var getHeader = function(name) {
+        try { return xhr.getResponseHeader(name); } catch (ex) { return null; }
+      };
+      if (_interop_HttpStart(reqID, xhr.status, getHeader)) return;
+
+      // Cached data is still up to date, so skip downloading the body
+      xhr.onerror = xhr.onload = xhr.ontimeout = null;
+      xhr.abort();
+      onFinished(reqID, 0, 0, 304);
+    };
     xhr.onload = function(e) {
       var src  = new Uint8Array(xhr.response);
       var len  = src.byteLength;
@@ -100,6 +126,61 @@ mergeInto(LibraryManager.library, {
     try { xhr.send(); } catch (e) { onFinished(reqID, 0, 0, 0); }
     return 0;
   },
+  interop_DownloadAsync__deps: ['interop_FetchAsync', 'interop_HttpStart'],
+  interop_HttpStart: function(reqID, status, getHeader) {
+    // onStart = FUNC(status, total, etag, lastModified), returns 0 if the response body should be skipped
+    var onStart  = Module["_Http_OnResponseStart"];
+    var len      = parseInt(getHeader('Content-Length'), 10) || 0;
+    var headers  = [getHeader('ETag'), getHeader('Last-Modified')];
+    var args     = [0, 0];
+    var stackTop = stackSave();
+
+    for (var i = 0; i < headers.length; i++) 
+    {
+      if (!headers[i]) continue;
+      var size = (headers[i].length * 4) + 1; // worst case, 4 bytes to encode a char
+      args[i]  = stackAlloc(size);
+      stringToUTF8(headers[i], args[i], size);
+    }
+
+    var ret = onStart(reqID, status, len, args[0], args[1]);
+    stackRestore(stackTop);
+    return ret;
+  },
+  interop_FetchAsync__deps: ['interop_HttpStart'],
+  interop_FetchAsync: function(req, reqID) {
+    // onReserve = FUNC(len), returns where in the heap to copy the next len bytes to
+    var onReserve  = Module["_Http_ReserveData"];
+    var onFinished = Module["_Http_OnFinishedAsync"];
+
+    fetch(req).then(function(res) {
+      var getHeader = function(name) { return res.headers.get(name); };
+      if (!_interop_HttpStart(reqID, res.status, getHeader)) {
+        // Cached data is still up to date, so skip downloading the body
+        if (res.body) res.body.cancel();
+        onFinished(reqID, 0, 0, 304); return;
+      }
+      if (!res.body) { onFinished(reqID, 0, 0, res.status); return; }
+
+      var reader = res.body.getReader();
+      var pump   = function(chunk) {
+        if (chunk.done) { onFinished(reqID, 0, 0, res.status); return; }
+        var src = chunk.value;
+        var dst = onReserve(reqID, src.byteLength);
+
+        // Out of memory, or request was cancelled
+        if (!dst) { reader.cancel(); onFinished(reqID, 0, 0, res.status); return; }
+        // NOTE: HEAPU8 must be accessed after onReserve, as the heap may have been resized
+        HEAPU8.set(src, dst);
+        return reader.read().then(pump);
+      };
+      return reader.read().then(pump);
+    }).catch(function(e) {
+      // Usually this happens when denied by CORS, or the connection was lost partway through
+      console.log(e);
+      onFinished(reqID, 0, 0, 0);
+    });
+  },
   interop_IsHttpsOnly : function() {
     // If this webpage is https://, browsers deny any http:// downloading
     return location.protocol === 'https:'; 
@@ -353,6 +434,29 @@ mergeInto(LibraryManager.library, {
     // however, as ClassiCube now loads IndexedDB asynchronously itself, this is
     //   no longer necessary, but is kept around for backwards compatibility
   },
+  interop_AsyncLoadCached__deps: ['IDBFS_getDB', 'IDBFS_loadRemoteEntry', 'IDBFS_storeLocalEntry'],
+  interop_AsyncLoadCached: function(raw, id) {
+    // Cached data isn't preloaded at startup (see IDBFS_reconcile), so is loaded on demand instead
+    var path = CCFS.resolvePath(UTF8ToString(raw));
+    var done = function() { Module['_TexturePack_OnCacheLoaded'](id); };
+    if (path in CCFS.entries) return setTimeout(done, 0);
+
+    _IDBFS_getDB(function(err, db) {
+      if (err) return done();
+      var store;
+      try {
+        store = db.transaction([IDBFS_DB_STORE_NAME], 'readonly').objectStore(IDBFS_DB_STORE_NAME);
+      } catch (e) {
+        return done();
+      }
+
+      _IDBFS_loadRemoteEntry(store, path, function(err, entry) {
+        // Entry is undefined if nothing has been cached for this path
+        if (!err && entry) _IDBFS_storeLocalEntry(path, entry, function(err) { if (err) console.log(err); });
+        done();
+      });
+    });
+  },
   interop_SaveNode__deps: ['IDBFS_getDB', 'IDBFS_storeRemoteEntry'],
   interop_SaveNode: function(path) {
     var callback = function(err) { 
@@ -520,6 +624,8 @@ mergeInto(LibraryManager.library, {
     var create = [];
 
     Object.keys(src.entries).forEach(function (key) {
+      // Cached texture packs can be quite large, so are only loaded when actually needed
+      if (key.indexOf('/texturecache/') >= 0) return;
       create.push(key);
       total++;
     });
@@ -108,6 +108,13 @@ CC_NOINLINE static void WarnMissingArgs(int argsCount, const cc_string* args) {
 	Logger_DialogWarn(&tmp);
 }
 
+static void LoadLogLevels(void) {
+	Platform_LogLevels[LOG_CATEGORY_GENERAL]  = Options_GetInt(OPT_LOG_LEVEL_GENERAL,  LOG_LEVEL_NONE, LOG_LEVEL_DEBUG, LOG_LEVEL_INFO);
+	Platform_LogLevels[LOG_CATEGORY_NETWORK]  = Options_GetInt(OPT_LOG_LEVEL_NETWORK,  LOG_LEVEL_NONE, LOG_LEVEL_DEBUG, LOG_LEVEL_INFO);
+	Platform_LogLevels[LOG_CATEGORY_AUDIO]    = Options_GetInt(OPT_LOG_LEVEL_AUDIO,    LOG_LEVEL_NONE, LOG_LEVEL_DEBUG, LOG_LEVEL_INFO);
+	Platform_LogLevels[LOG_CATEGORY_GRAPHICS] = Options_GetInt(OPT_LOG_LEVEL_GRAPHICS, LOG_LEVEL_NONE, LOG_LEVEL_DEBUG, LOG_LEVEL_INFO);
+}
+
 static void SetupProgram(int argc, char** argv) {
 	static char ipBuffer[STRING_SIZE];
 	cc_result res;
@@ -115,9 +122,11 @@ static void SetupProgram(int argc, char** argv) {
 	Logger_Hook();
 	Window_PreInit();
 	Platform_Init();
+	Platform_StartLogThread();
 	
 	res = Platform_SetDefaultCurrentDirectory(argc, argv);
 	Options_Load();
+	LoadLogLevels();
 	Window_Init();
 	Gamepads_Init();
 	
@@ -189,6 +198,17 @@ static int RunProgram(int argc, char** argv) {
 		Options_Get(LOPT_USERNAME, &Game_Username, DEFAULT_USERNAME);
 		String_Copy(&SP_AutoloadMap, &args[0]); /* TODO: don't copy args? */
 		RunGame();
+	/* --replay [file path] <max> - play back a recorded multiplayer session */
+	} else if (argsCount >= 2 && String_CaselessEqualsConst(&args[0], DEFAULT_REPLAY_ARG)) {
+		if (!IsOpenableFile(&args[1])) {
+			WarnInvalidArg("Replay file does not exist", &args[1]);
+			return 1;
+		}
+
+		Options_Get(LOPT_USERNAME, &Game_Username, DEFAULT_USERNAME);
+		String_Copy(&Replay_Path, &args[1]);
+		Replay_MaxSpeed = argsCount >= 3 && String_CaselessEqualsConst(&args[2], "max");
+		RunGame();
 #endif
 	/* mc://[addr]:[port]/[user]/[mppass] - run multiplayer using direct URL form arguments */
 	} else if (argsCount == 1 && DirectUrl_Claims(&args[0], &host, &r.user, &r.mppass)) {
@@ -212,7 +232,9 @@ static int RunProgram(int argc, char** argv) {
 	return 0;
 }
 
-#if defined CC_BUILD_IOS
+#if defined CC_BUILD_BENCH
+/* Benchmark builds use the entrypoint in Bench.c instead */
+#elif defined CC_BUILD_IOS
 /* ClassiCube is sort of and sort of not the executable */
 /*  on iOS - UIKit is responsible for kickstarting the game. */
 /* (this is handled in interop_ios.m as the code is Objective C) */